@@ -0,0 +1,33 @@
+/**
+ * @file atomics.h
+ * @brief Thin wrappers over compiler atomic builtins
+ * @version 0.1
+ * @date 2025-11-23
+ *
+ * Uses the GCC/Clang __atomic builtins, which MinGW also provides.
+ *
+ */
+#ifndef ATOMICS_H
+#define ATOMICS_H
+
+#define ATOMIC_LOAD_RELAXED(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define ATOMIC_LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+
+#define ATOMIC_STORE_RELAXED(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELAXED)
+#define ATOMIC_STORE_RELEASE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define ATOMIC_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_SEQ_CST)
+
+#define ATOMIC_FETCH_ADD_RELAXED(ptr, val) __atomic_fetch_add((ptr), (val), __ATOMIC_RELAXED)
+#define ATOMIC_FETCH_ADD(ptr, val) __atomic_fetch_add((ptr), (val), __ATOMIC_SEQ_CST)
+#define ATOMIC_FETCH_SUB(ptr, val) __atomic_fetch_sub((ptr), (val), __ATOMIC_SEQ_CST)
+
+/**
+ * @brief Weak compare-and-swap; on failure *expected receives the current value.
+ */
+#define ATOMIC_CAS_WEAK_RELAXED(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define ATOMIC_CAS_WEAK(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)
+
+#endif // ATOMICS_H
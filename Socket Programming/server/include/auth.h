@@ -27,9 +27,9 @@
 #define AUTH_MAX_HOME_DIR 1024
 
 /**
- * @brief Maximum number of users
+ * @brief Initial number of hash buckets in the user table (grows with the user count)
  */
-#define AUTH_MAX_USERS 1024
+#define AUTH_INITIAL_BUCKETS 64
 
 /**
  * @brief User permission flags
@@ -47,16 +47,24 @@ typedef enum
     AUTH_PERM_ALL = 0xFF     // All permissions
 } auth_permission_t;
 
+struct auth_table;
+
 /**
  * @brief User account information
+ *
+ * Entries are immutable once published. A reload or change builds or
+ * extends a table and swaps it in; the old one is freed after all readers
+ * left it and every auth_get_user() reference was released.
  */
-typedef struct
+typedef struct auth_user
 {
-    char username[AUTH_MAX_USERNAME]; // Username
-    char password_hash[65];           // SHA-256 hash (64 hex chars + null)
-    char home_dir[AUTH_MAX_HOME_DIR]; // Home directory path
-    auth_permission_t permissions;    // Permission flags
-    int in_use;                       // 1 if slot is occupied, 0 if free
+    const char *username;          // Username
+    const char *home_dir;          // Home directory path
+    char password_hash[65];        // SHA-256 hash (64 hex chars + null)
+    auth_permission_t permissions; // Permission flags
+    unsigned long long rate_limit; // Bytes per second for all sessions of the user, 0 if unlimited
+    struct auth_user *next;        // Next user in the same hash bucket (internal)
+    struct auth_table *table;      // Owning table (internal)
 } auth_user_t;
 
 /**
@@ -159,12 +167,29 @@ int auth_add_user(const char *username,
 /**
  * @brief Retrieves user information.
  *
+ * The returned entry stays valid across reloads until it is passed to
+ * auth_user_release().
+ *
  * @param username The username to search for.
  * @return A pointer to the user structure if found in user table
  * (include virtual anonymous user), or NULL otherwise.
  */
 const auth_user_t *auth_get_user(const char *username);
 
+/**
+ * @brief Releases a user returned by auth_get_user().
+ *
+ * @param user The user to release (NULL is ignored).
+ */
+void auth_user_release(const auth_user_t *user);
+
+/**
+ * @brief Gets the number of users in the database.
+ *
+ * @return Number of users (the virtual anonymous user is not counted).
+ */
+int auth_get_user_count(void);
+
 /**
  * @brief Checks if a user has specific permissions.
  *
@@ -177,8 +202,10 @@ int auth_has_permission(const char *username, auth_permission_t permission);
 /**
  * @brief Loads users from a file.
  *
- * This reads user data from a file and populates the user
- * database. The file must follow the expected format.
+ * This reads user data from a file into a new table and swaps it in
+ * atomically, replacing the current users. Logins keep using the old
+ * table while the file is parsed, so it can be called at runtime.
+ * The file must follow the expected format.
  * This should manually be called after auth_init() to load users.
  *
  * @param filename The path to the file containing user data.
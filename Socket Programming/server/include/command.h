@@ -4,6 +4,12 @@
  * @version 0.1
  * @date 2025-10-30
  *
+ * Verbs are found through a perfect hash: the name, packed into a 32-bit
+ * key, selects its entry with one multiply and shift and no collision
+ * handling, so dispatch is a single probe. Each entry carries flags with
+ * the preconditions of the command and the pending state it cancels, which
+ * dispatch checks and applies before calling the handler.
+ *
  */
 #ifndef COMMAND_H
 #define COMMAND_H
@@ -15,6 +21,18 @@
  */
 #define CMD_MAX_HANDLERS 64
 
+/*
+ * Command flags, see cmd_register_handler()
+ */
+#define CMD_NEED_AUTH     0x01 // Refused before login
+#define CMD_NEED_DATA     0x02 // Refused before PORT or PASV
+#define CMD_CLEAR_RENAME  0x10 // Cancels a pending RNFR
+#define CMD_CLEAR_RESTART 0x20 // Cancels a pending REST
+#define CMD_CLEAR_ALL     (CMD_CLEAR_RENAME | CMD_CLEAR_RESTART)
+
+// Flags that are preconditions, as opposed to state changes
+#define CMD_NEED_MASK (CMD_NEED_AUTH | CMD_NEED_DATA)
+
 /**
  * @brief Opaque handle for command handler context.
  *
@@ -33,6 +51,19 @@ typedef void *cmd_handler_context_t;
  */
 typedef int (*cmd_handler_t)(cmd_handler_context_t context, const proto_command_t *cmd);
 
+/**
+ * @brief Session callbacks behind the command flags.
+ */
+typedef struct
+{
+    // Gets the CMD_NEED_* preconditions the context currently meets
+    unsigned (*get_state)(cmd_handler_context_t context);
+    // Replies to a command whose CMD_NEED_* preconditions in missing are not met
+    int (*refuse)(cmd_handler_context_t context, unsigned missing);
+    // Cancels the pending state named by the CMD_CLEAR_* bits in flags
+    void (*clear)(cmd_handler_context_t context, unsigned flags);
+} cmd_context_ops_t;
+
 /**
  * @brief Initializes the command module.
  *
@@ -49,18 +80,29 @@ int cmd_init(void);
  */
 void cmd_cleanup(void);
 
+/**
+ * @brief Sets the callbacks that check and apply command flags.
+ *
+ * Without them, flags are ignored and every command reaches its handler.
+ *
+ * @param ops The callbacks, NULL to remove them. Must stay valid while set.
+ */
+void cmd_set_context_ops(const cmd_context_ops_t *ops);
+
 /**
  * @brief Registers a command handler.
  *
- * Multiple handlers can be registered. When a command is parsed,
- * first the previous handler (if any) will be called, then the matching handler will be called.
+ * Multiple handlers can be registered. When a command is parsed, first
+ * the state named by its CMD_CLEAR_* flags is cancelled, then the command
+ * is refused if a CMD_NEED_* precondition is not met, and only then the
+ * handler is called.
  *
  * @param command The command name (e.g., "USER", "PASS"). Case-insensitive.
  * @param handler The handler function to call for this command.
- * @param prev_handler The previous handler function to call before the handler (can be NULL).
+ * @param flags CMD_NEED_* and CMD_CLEAR_* flags, 0 for none.
  * @return 0 on success, -1 if the handler table is full or invalid parameters.
  */
-int cmd_register_handler(const char *command, cmd_handler_t handler, cmd_handler_t prev_handler);
+int cmd_register_handler(const char *command, cmd_handler_t handler, unsigned flags);
 
 /**
  * @brief Unregisters a command handler.
@@ -73,8 +115,9 @@ int cmd_unregister_handler(const char *command);
 /**
  * @brief Dispatches a parsed command to its registered handler.
  *
- * Looks up the command name in the handler table and calls the
- * corresponding handler function.
+ * Looks up the command name in the handler table, applies its flags and
+ * calls the corresponding handler function. A refused command counts as
+ * handled: the refusal is its reply.
  *
  * @param context The handler context to pass to the handler.
  * @param cmd The parsed command structure.
@@ -108,6 +151,22 @@ int cmd_get_handler_count(void);
  */
 int cmd_register_standard_handlers(void);
 
+/**
+ * @brief Gets the flags of a registered command.
+ *
+ * @param command The command name. Case-insensitive.
+ * @return The CMD_NEED_* and CMD_CLEAR_* flags, 0 if not registered.
+ */
+unsigned cmd_get_handler_flags(const char *command);
+
+/**
+ * @brief Gets the command registered in a handler slot.
+ *
+ * @param slot Slot index, 0 to CMD_MAX_HANDLERS - 1.
+ * @return The command name, or NULL if the slot is unused.
+ */
+const char *cmd_get_handler_name(int slot);
+
 /**
  * @brief Gets a comma-separated list of all registered commands.
  *
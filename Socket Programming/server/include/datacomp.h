@@ -0,0 +1,156 @@
+/**
+ * @file datacomp.h
+ * @brief Deflate compression of the data channel (MODE Z)
+ * @version 0.1
+ * @date 2025-11-27
+ *
+ * A MODE Z transfer carries a single zlib stream (RFC 1950) over the data
+ * connection, which is closed at the end as in stream mode. Requires a
+ * build with ENABLE_ZLIB; without it datacomp_is_available() returns 0 and
+ * the writer and reader cannot be created.
+ *
+ */
+#ifndef DATACOMP_H
+#define DATACOMP_H
+
+#include "network.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Compression levels (zlib semantics: 0 stores, 9 compresses best)
+ */
+#define DATACOMP_MIN_LEVEL 0
+#define DATACOMP_MAX_LEVEL 9
+#define DATACOMP_DEFAULT_LEVEL 6
+
+/**
+ * @brief Buffer size of the writer and reader
+ *
+ * With the deflate window and hash table this bounds a writer to about
+ * 320KB and a reader to about 100KB, whatever the transfer size.
+ */
+#define DATACOMP_BUFFER_SIZE 65536
+
+/**
+ * @brief Bytes inspected by datacomp_is_incompressible(), and the least it judges
+ */
+#define DATACOMP_SAMPLE_SIZE 16384
+#define DATACOMP_MIN_SAMPLE_SIZE 512
+
+/**
+ * @brief Input bytes between two samples of an adaptive writer
+ */
+#define DATACOMP_RESAMPLE_INTERVAL (1024 * 1024)
+
+/**
+ * @brief Error codes returned by datacomp_reader_receive()
+ */
+#define DATACOMP_NET_ERROR -1    // Receiving from the socket failed
+#define DATACOMP_STREAM_ERROR -2 // Corrupt or truncated compressed stream
+
+typedef struct datacomp_writer datacomp_writer_t;
+typedef struct datacomp_reader datacomp_reader_t;
+
+/**
+ * @brief Checks if the server was built with compression support.
+ *
+ * @return 1 if MODE Z can be used, 0 otherwise.
+ */
+int datacomp_is_available(void);
+
+/**
+ * @brief Guesses whether data is already compressed (or otherwise random).
+ *
+ * Looks at the byte histogram of up to DATACOMP_SAMPLE_SIZE bytes: archives,
+ * images and video have an almost flat one, text and most binaries do not.
+ *
+ * @param data Sample to inspect.
+ * @param length Sample length.
+ * @return 1 if compressing is not worth the CPU, 0 otherwise.
+ */
+int datacomp_is_incompressible(const void *data, size_t length);
+
+/**
+ * @brief Creates a writer that compresses into a socket.
+ *
+ * @param sock Connected data socket.
+ * @param level Compression level (DATACOMP_MIN_LEVEL to DATACOMP_MAX_LEVEL).
+ * @param adaptive 1 to sample the input and store blocks that look
+ *                 incompressible instead of compressing them.
+ * @return The writer, or NULL on error or when compression is unavailable.
+ */
+datacomp_writer_t *datacomp_writer_create(socket_t sock, int level, int adaptive);
+
+/**
+ * @brief Compresses data and sends whatever output is ready.
+ *
+ * @param writer The writer.
+ * @param data Data to compress.
+ * @param length Data length.
+ * @return 0 on success, -1 if sending failed.
+ */
+int datacomp_writer_write(datacomp_writer_t *writer, const void *data, size_t length);
+
+/**
+ * @brief Ends the stream and sends the remaining output.
+ *
+ * @param writer The writer.
+ * @return 0 on success, -1 if sending failed.
+ */
+int datacomp_writer_finish(datacomp_writer_t *writer);
+
+/**
+ * @brief Gets the bytes consumed and sent so far.
+ *
+ * @param writer The writer.
+ * @param bytes_in Receives the uncompressed byte count (may be NULL).
+ * @param bytes_out Receives the compressed byte count (may be NULL).
+ */
+void datacomp_writer_get_totals(const datacomp_writer_t *writer, long long *bytes_in, long long *bytes_out);
+
+/**
+ * @brief Frees a writer. Does not close the socket.
+ *
+ * @param writer The writer (NULL is ignored).
+ */
+void datacomp_writer_destroy(datacomp_writer_t *writer);
+
+/**
+ * @brief Creates a reader that decompresses from a socket.
+ *
+ * @param sock Connected data socket.
+ * @return The reader, or NULL on error or when compression is unavailable.
+ */
+datacomp_reader_t *datacomp_reader_create(socket_t sock);
+
+/**
+ * @brief Receives and decompresses the next piece of data.
+ *
+ * A connection closed before any data arrived is taken as an empty stream.
+ *
+ * @param reader The reader.
+ * @param buffer Buffer for decompressed data.
+ * @param buffer_size Buffer size.
+ * @return Bytes decompressed, 0 at the end of the stream, DATACOMP_NET_ERROR
+ *         or DATACOMP_STREAM_ERROR on error.
+ */
+int datacomp_reader_receive(datacomp_reader_t *reader, void *buffer, size_t buffer_size);
+
+/**
+ * @brief Gets the bytes received and produced so far.
+ *
+ * @param reader The reader.
+ * @param bytes_in Receives the compressed byte count (may be NULL).
+ * @param bytes_out Receives the decompressed byte count (may be NULL).
+ */
+void datacomp_reader_get_totals(const datacomp_reader_t *reader, long long *bytes_in, long long *bytes_out);
+
+/**
+ * @brief Frees a reader. Does not close the socket.
+ *
+ * @param reader The reader (NULL is ignored).
+ */
+void datacomp_reader_destroy(datacomp_reader_t *reader);
+
+#endif // DATACOMP_H
@@ -0,0 +1,122 @@
+/**
+ * @file digest.h
+ * @brief Checksums and message digests (CRC-32, CRC-32C, MD5, SHA-256)
+ * @version 0.1
+ * @date 2025-12-10
+ *
+ * CRC-32C uses the SSE4.2 or ARMv8 CRC32 instructions and SHA-256 the x86
+ * SHA extensions when the CPU has them, detected once at first use; the
+ * portable code (slicing-by-8 CRC tables) is used otherwise. The results
+ * are identical either way.
+ *
+ */
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Size of the largest hex digest including the terminator (SHA-256)
+ */
+#define DIGEST_HEX_SIZE 65
+
+/**
+ * @brief Supported algorithms
+ */
+typedef enum
+{
+    DIGEST_SHA256, // SHA-256, the default of HASH
+    DIGEST_MD5,    // MD5
+    DIGEST_CRC32,  // CRC-32 (IEEE 802.3, as in zip and XCRC)
+    DIGEST_CRC32C, // CRC-32C (Castagnoli)
+    DIGEST_ALGORITHM_COUNT
+} digest_algorithm_t;
+
+/**
+ * @brief Running state of a digest
+ */
+typedef struct
+{
+    digest_algorithm_t algorithm;
+    uint64_t length;         // Bytes hashed so far
+    uint32_t state[8];       // CRC in state[0], MD5 in state[0..3], SHA-256 in state[0..7]
+    unsigned char block[64]; // Pending partial block (MD5, SHA-256)
+    size_t block_used;
+    void (*blocks)(uint32_t *state, const unsigned char *data, size_t count); // MD5, SHA-256
+    uint32_t (*crc)(uint32_t crc, const unsigned char *data, size_t length);  // CRC-32, CRC-32C
+} digest_ctx_t;
+
+/**
+ * @brief Gets the name of an algorithm as used by HASH ("SHA-256", "MD5", "CRC32", "CRC32C").
+ *
+ * @param algorithm The algorithm.
+ * @return Its name, "unknown" for an invalid value.
+ */
+const char *digest_algorithm_name(digest_algorithm_t algorithm);
+
+/**
+ * @brief Looks up an algorithm by name, ignoring case.
+ *
+ * @param name Algorithm name.
+ * @param algorithm Receives the algorithm.
+ * @return 0 on success, -1 if the name is unknown.
+ */
+int digest_parse_algorithm(const char *name, digest_algorithm_t *algorithm);
+
+/**
+ * @brief Gets the implementation used for an algorithm ("SHA-NI", "SSE4.2",
+ * "ARMv8" or "generic").
+ *
+ * @param algorithm The algorithm.
+ * @return Name of the implementation.
+ */
+const char *digest_implementation(digest_algorithm_t algorithm);
+
+/**
+ * @brief Allows or forbids the CPU-specific implementations.
+ *
+ * Affects digests started afterwards; meant for tests and benchmarks.
+ *
+ * @param enabled 0 to force the portable code, non-zero to use the CPU features (default).
+ */
+void digest_use_hardware(int enabled);
+
+/**
+ * @brief Starts a digest.
+ *
+ * @param ctx State to initialize.
+ * @param algorithm Algorithm to compute.
+ */
+void digest_init(digest_ctx_t *ctx, digest_algorithm_t algorithm);
+
+/**
+ * @brief Adds data to a digest.
+ *
+ * @param ctx A started digest.
+ * @param data Data to add.
+ * @param length Bytes of data.
+ */
+void digest_update(digest_ctx_t *ctx, const void *data, size_t length);
+
+/**
+ * @brief Finishes a digest and writes it as lowercase hex.
+ *
+ * CRCs are written as 8 digits, MD5 as 32 and SHA-256 as 64.
+ *
+ * @param ctx A started digest; it must be started again before reuse.
+ * @param hex Output of at least DIGEST_HEX_SIZE bytes.
+ */
+void digest_final_hex(digest_ctx_t *ctx, char *hex);
+
+/**
+ * @brief Computes the digest of a buffer in one call.
+ *
+ * @param algorithm Algorithm to compute.
+ * @param data Data to hash.
+ * @param length Bytes of data.
+ * @param hex Output of at least DIGEST_HEX_SIZE bytes.
+ */
+void digest_hex(digest_algorithm_t algorithm, const void *data, size_t length, char *hex);
+
+#endif // DIGEST_H
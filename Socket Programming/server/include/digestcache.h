@@ -0,0 +1,83 @@
+/**
+ * @file digestcache.h
+ * @brief Cache of file checksums (HASH, XCRC, XMD5, XSHA256)
+ * @version 0.1
+ * @date 2025-12-10
+ *
+ * An entry is keyed by path, algorithm and start offset and is valid while
+ * the file still has the size and mtime it was computed from. Commands that
+ * change or move files (STOR, APPE, RNTO, DELE) invalidate it explicitly, in
+ * case a write within the same second left both unchanged.
+ *
+ */
+#ifndef DIGESTCACHE_H
+#define DIGESTCACHE_H
+
+#include "digest.h"
+#include "filesys.h"
+
+/**
+ * @brief Default number of cached checksums
+ */
+#define DIGESTCACHE_DEFAULT_ENTRIES 256
+
+/**
+ * @brief Enables the cache.
+ *
+ * @param max_entries Number of checksums kept (<= 0 for the default)
+ * @return 0 on success, -1 on error
+ */
+int digestcache_init(int max_entries);
+
+/**
+ * @brief Drops all entries and disables the cache.
+ */
+void digestcache_cleanup(void);
+
+/**
+ * @brief Looks up a checksum.
+ *
+ * @param path Absolute file path
+ * @param st Current metadata of the file
+ * @param algorithm Checksum algorithm
+ * @param offset First byte covered, the range runs to the end of the file
+ * @param hex Receives the checksum (DIGEST_HEX_SIZE bytes)
+ * @return 0 on hit, -1 on miss
+ */
+int digestcache_lookup(const char *path, const fs_stat_t *st, digest_algorithm_t algorithm,
+                       long long offset, char *hex);
+
+/**
+ * @brief Gets the invalidation generation.
+ *
+ * Take this before reading the file and pass it to digestcache_store(), so
+ * a checksum that raced with an invalidation is not stored.
+ *
+ * @return Current generation
+ */
+unsigned long digestcache_get_generation(void);
+
+/**
+ * @brief Stores a checksum, replacing any previous entry with the same key.
+ *
+ * Checksums of files modified within the last second are not stored,
+ * because a change in the same second would not move the mtime.
+ *
+ * @param path Absolute file path
+ * @param st Metadata of the file observed before reading it
+ * @param algorithm Checksum algorithm
+ * @param offset First byte covered
+ * @param generation Value of digestcache_get_generation() taken before reading
+ * @param hex The checksum
+ */
+void digestcache_store(const char *path, const fs_stat_t *st, digest_algorithm_t algorithm,
+                       long long offset, unsigned long generation, const char *hex);
+
+/**
+ * @brief Invalidates the checksums of path and of everything below it.
+ *
+ * @param path Absolute path of the modified, renamed or removed entry
+ */
+void digestcache_invalidate(const char *path);
+
+#endif // DIGESTCACHE_H
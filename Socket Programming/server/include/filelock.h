@@ -5,6 +5,11 @@
 #ifndef FILELOCK_H
 #define FILELOCK_H
 
+/**
+ * @brief Handle of a held shared lock, see file_lock_try_acquire_shared_handle()
+ */
+typedef struct file_lock_entry file_lock_t;
+
 /**
  * @brief Acquire a shared (read) lock for the specified absolute path.
  *
@@ -26,6 +31,20 @@ int file_lock_acquire_shared(const char *path);
  */
 int file_lock_try_acquire_shared(const char *path);
 
+/**
+ * @brief Try to acquire a shared (read) lock without blocking, returning a handle.
+ *
+ * Like file_lock_try_acquire_shared(), but the lock is released with
+ * file_lock_release_shared_handle(), which skips hashing and looking up the
+ * path. Unless it is the last reader, a release does not take the lock
+ * table's mutex, so many concurrent readers of one file (such as the
+ * segments of a parallel download) do not contend on it when they finish.
+ *
+ * @param path Absolute filesystem path to lock.
+ * @return The lock handle, or NULL if the lock is busy or on error.
+ */
+file_lock_t *file_lock_try_acquire_shared_handle(const char *path);
+
 /**
  * @brief Acquire an exclusive (write) lock for the specified absolute path.
  *
@@ -55,6 +74,13 @@ int file_lock_try_acquire_exclusive(const char *path);
  */
 void file_lock_release_shared(const char *path);
 
+/**
+ * @brief Release a shared (read) lock acquired as a handle.
+ *
+ * @param lock Handle from file_lock_try_acquire_shared_handle(), NULL is ignored.
+ */
+void file_lock_release_shared_handle(file_lock_t *lock);
+
 /**
  * @brief Release a previously acquired exclusive (write) lock.
  *
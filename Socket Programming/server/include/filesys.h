@@ -15,6 +15,7 @@
 #define FILESYS_H
 
 #define MAX_FILENAME_LEN 256
+#define FS_NAME_CACHE_TTL 300 // Seconds a uid/gid name lookup stays cached
 #include <time.h>
 
 #ifdef _WIN32
@@ -82,6 +83,40 @@ typedef struct
     char link_target[MAX_FILENAME_LEN]; // Target path for symbolic links
 } fs_file_info_t;
 
+// Metadata of a path or open file taken with a single stat call. See fs_stat().
+typedef struct
+{
+    fs_file_type_t type;        // FS_TYPE_FILE, FS_TYPE_DIR or FS_TYPE_UNKNOWN (symlinks are followed)
+    long long size;             // File size in bytes (0 for directories)
+    time_t last_modified;       // Last modification timestamp
+    unsigned long long file_id; // Inode number (file index on Windows, 0 if unknown), new when a file is replaced
+} fs_stat_t;
+
+// Access mode for fs_file_open()
+typedef enum
+{
+    FS_OPEN_READ, // Open an existing file for reading
+    FS_OPEN_WRITE // Open for writing, create if missing, keep existing content
+} fs_open_mode_t;
+
+// Expected access pattern for fs_file_advise()
+typedef enum
+{
+    FS_ADVICE_SEQUENTIAL, // The range will be read from start to end
+    FS_ADVICE_WILLNEED,   // The range will be read soon: start reading it ahead
+    FS_ADVICE_DONTNEED    // The range will not be read again: drop it from the cache
+} fs_advice_t;
+
+// Open file handle for streaming I/O. Use fs_file_open() / fs_file_close().
+typedef struct
+{
+#ifdef _WIN32
+    void *handle; // Native HANDLE, NULL when closed
+#else
+    int fd; // File descriptor, -1 when closed
+#endif
+} fs_file_t;
+
 /**
  * @brief Join directory and name into a single path stored in dest
  * @param dest Output buffer where the joined path will be written.
@@ -124,13 +159,87 @@ long long fs_get_file_size(const char *path);
  */
 time_t fs_get_file_mtime(const char *path);
 
+/**
+ * @brief Get type, size and modification time of a path with one stat call.
+ *
+ * Prefer this over calling fs_path_exists(), fs_is_directory() and
+ * fs_get_file_size() one after another, which stat the path each time.
+ *
+ * @param path Path to the file/dir
+ * @param st Receives the metadata
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - The path does not exist or error
+ */
+int fs_stat(const char *path, fs_stat_t *st);
+
 /**
  * @brief Get the directory size.
+ * The tree is walked in parallel by fswalk_run(); symbolic links are not followed.
  * @param path Path to the directory
  * @return Directory size in byte, or -1 for non-existence or error.
  */
 long long fs_get_directory_size(const char *path);
 
+/**
+ * @brief fs_dir_open() flag: return only entry names, without stat'ing each entry.
+ *
+ * The type is reported as FS_TYPE_UNKNOWN on POSIX and the other fields are zero.
+ */
+#define FS_DIR_NAMES_ONLY 0x1
+
+/**
+ * @brief Open directory stream (opaque)
+ */
+typedef struct fs_dir fs_dir_t;
+
+/**
+ * @brief Open a directory for streaming iteration.
+ * @param path Path to directory
+ * @param flags 0 or FS_DIR_NAMES_ONLY
+ * @return Directory stream, or NULL on error. Close with fs_dir_close().
+ */
+fs_dir_t *fs_dir_open(const char *path, int flags);
+
+/**
+ * @brief Read the next entry of a directory stream.
+ *
+ * Note: Special entries "." and ".." are skipped, as are entries that vanish
+ * before they can be stat'ed.
+ *
+ * @param dir Directory stream
+ * @param info Receives the entry information
+ * @return 1 if an entry was read, 0 at the end of the directory, -1 on error.
+ */
+int fs_dir_next(fs_dir_t *dir, fs_file_info_t *info);
+
+/**
+ * @brief Read up to max_entries entries of a directory stream.
+ * @param dir Directory stream
+ * @param infos Array receiving the entries
+ * @param max_entries Capacity of infos
+ * @return Number of entries read (0 at the end of the directory), or -1 on error.
+ */
+int fs_dir_read_batch(fs_dir_t *dir, fs_file_info_t *infos, int max_entries);
+
+/**
+ * @brief Close a directory stream.
+ * @param dir Directory stream (NULL is ignored)
+ */
+void fs_dir_close(fs_dir_t *dir);
+
+/**
+ * @brief Get the information of a single directory entry without scanning the directory.
+ *
+ * Symlinks are reported as such, like fs_dir_next() does.
+ *
+ * @param dirpath Directory containing the entry
+ * @param name Entry name
+ * @param info Receives the entry information
+ * @return 0 on success, -1 if the entry does not exist or on error.
+ */
+int fs_get_entry_info(const char *dirpath, const char *name, fs_file_info_t *info);
+
 /**
  * @brief List the contents of the specified directory.
  *
@@ -140,6 +249,9 @@ long long fs_get_directory_size(const char *path);
  * @param file_list Array pointer used to store file information.
  * @param max_files The maximum capacity of the file_list array.
  * @return The actual number of files/directories listed, or -1 if an error occurs.
+ *
+ * Entries beyond max_files are not returned; use fs_dir_open() to walk
+ * directories of any size.
  */
 int fs_list_directory(const char *path, fs_file_info_t *file_list, int max_files);
 
@@ -192,6 +304,147 @@ long long fs_read_file_chunk(const char *path, void *buffer, long long offset, l
  */
 long long fs_write_file_chunk(const char *path, const void *buffer, long long offset, long long length);
 
+/**
+ * @brief Open a file for streaming I/O.
+ *
+ * The handle keeps a file position, so sequential fs_file_read() /
+ * fs_file_write() calls do not reopen the path. Prefer this over the chunk
+ * functions for transfers that touch a file more than once.
+ *
+ * @param file Handle to initialize.
+ * @param path File path
+ * @param mode FS_OPEN_READ or FS_OPEN_WRITE
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Failure or error (file is left closed)
+ */
+int fs_file_open(fs_file_t *file, const char *path, fs_open_mode_t mode);
+
+/**
+ * @brief Check whether a handle refers to an open file.
+ * @param file File handle
+ * @return int
+ * @retval 1 - Open
+ * @retval 0 - Closed or NULL
+ */
+int fs_file_is_open(const fs_file_t *file);
+
+/**
+ * @brief Read from the current position of an open file.
+ *
+ * Reads until length bytes are read or the end of the file is reached.
+ *
+ * @param file File handle opened with FS_OPEN_READ
+ * @param buffer The buffer for storing reading data.
+ * @param length The number of bytes to read.
+ * @return The actual number of bytes read (0 at end of file), or -1 if an error occurs.
+ */
+long long fs_file_read(fs_file_t *file, void *buffer, long long length);
+
+/**
+ * @brief Write to the current position of an open file.
+ * @param file File handle opened with FS_OPEN_WRITE
+ * @param buffer The buffer containing the data to be written.
+ * @param length The number of bytes to write.
+ * @return The actual number of bytes written, or -1 if an error occurs.
+ */
+long long fs_file_write(fs_file_t *file, const void *buffer, long long length);
+
+/**
+ * @brief Move the position of an open file.
+ * @param file File handle
+ * @param offset Absolute offset from the start of the file.
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Failure or error
+ */
+int fs_file_seek(fs_file_t *file, long long offset);
+
+/**
+ * @brief Get the size of an open file.
+ * @param file File handle
+ * @return File size in byte, or -1 if an error occurs.
+ */
+long long fs_file_size(fs_file_t *file);
+
+/**
+ * @brief Get type, size and modification time of an open file.
+ *
+ * Unlike fs_stat(), the result describes the opened file even if the path
+ * was replaced since.
+ *
+ * @param file File handle
+ * @param st Receives the metadata
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Failure or error
+ */
+int fs_file_stat(fs_file_t *file, fs_stat_t *st);
+
+/**
+ * @brief Tell the system how a byte range of an open file will be accessed.
+ *
+ * Only a hint: platforms without an equivalent ignore it.
+ *
+ * @param file File handle
+ * @param offset Start of the range
+ * @param length Length of the range, 0 for up to the end of the file
+ * @param advice Expected access pattern
+ * @return int
+ * @retval 0 - Success, or hint not supported
+ * @retval -1 - Invalid arguments or the system rejected the hint
+ */
+int fs_file_advise(fs_file_t *file, long long offset, long long length, fs_advice_t advice);
+
+/**
+ * @brief Reserve disk space for a byte range of an open file.
+ *
+ * The file size is not changed, so a transfer that ends early leaves no
+ * trailing zeros. Contiguous space also keeps large uploads from fragmenting.
+ *
+ * @param file File handle (opened for writing)
+ * @param offset Start of the range
+ * @param length Length of the range
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Not supported by the platform or filesystem, or no space
+ */
+int fs_file_preallocate(fs_file_t *file, long long offset, long long length);
+
+/**
+ * @brief Write back a byte range of an open file without waiting for metadata.
+ *
+ * Used to push upload data to disk as it arrives, so the final
+ * fs_file_sync() has little left to do.
+ *
+ * @param file File handle
+ * @param offset Start of the range
+ * @param length Length of the range
+ * @param wait 0 to only start write-back, 1 to also wait until it completes
+ * @return int
+ * @retval 0 - Success, or not supported (wait = 0 only)
+ * @retval -1 - Failure or error
+ */
+int fs_file_flush_range(fs_file_t *file, long long offset, long long length, int wait);
+
+/**
+ * @brief Flush written data of an open file to stable storage.
+ * @param file File handle
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Failure or error
+ */
+int fs_file_sync(fs_file_t *file);
+
+/**
+ * @brief Close an open file. Closing an already closed handle does nothing.
+ * @param file File handle
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Failure or error
+ */
+int fs_file_close(fs_file_t *file);
+
 /**
  * @brief Create a new directory.
  * @param path Path to new directory.
@@ -216,6 +469,7 @@ int fs_delete_file(const char *path);
  * @param force_delete Default 0.
  * 0 means only empty folders will be deleted,
  * while non-zero means the folder will be forcibly deleted even if it is not empty.
+ * The forced delete walks the tree in parallel by fswalk_run().
  * @return int
  * @retval 0 - Success
  * @retval -1 - Failure or error
@@ -232,6 +486,19 @@ int fs_delete_directory(const char *path, int force_delete);
  */
 int fs_rename(const char *old_path, const char *new_path);
 
+/**
+ * @brief Atomically replace a file with another one on the same filesystem.
+ *
+ * Readers see either the old or the new content of new_path, never a mix.
+ *
+ * @param old_path Path to the replacement file; it is gone on success.
+ * @param new_path Path to replace (created if missing).
+ * @return int
+ * @retval 0 - Success
+ * @retval -1 - Failure or error
+ */
+int fs_replace_file(const char *old_path, const char *new_path);
+
 /**
  * @brief Get the parent directory of the given path.
  *
@@ -245,4 +512,39 @@ int fs_rename(const char *old_path, const char *new_path);
  */
 int fs_get_parent_directory(const char *path, char *parent, size_t parent_size);
 
+/**
+ * @brief Get the directory modification time.
+ *
+ * Changes whenever an entry is created, removed or renamed in the directory.
+ *
+ * @param path Path to the directory
+ * @return Modification time as time_t, or -1 for non-existence, non-directory or error.
+ */
+time_t fs_get_directory_mtime(const char *path);
+
+/**
+ * @brief Look up the user name for a numeric uid.
+ *
+ * Results (including failed lookups) are cached for FS_NAME_CACHE_TTL
+ * seconds, so repeated listings do not hit NSS for every line. Thread-safe.
+ *
+ * @param uid User ID
+ * @param name Output buffer, receives the user name or the decimal uid if unknown
+ * @param name_size Size of the output buffer
+ * @return 0 on success, -1 on error or if not supported on this platform
+ */
+int fs_get_user_name(uid_t uid, char *name, size_t name_size);
+
+/**
+ * @brief Look up the group name for a numeric gid.
+ *
+ * Same caching and thread-safety as fs_get_user_name().
+ *
+ * @param gid Group ID
+ * @param name Output buffer, receives the group name or the decimal gid if unknown
+ * @param name_size Size of the output buffer
+ * @return 0 on success, -1 on error or if not supported on this platform
+ */
+int fs_get_group_name(gid_t gid, char *name, size_t name_size);
+
 #endif
\ No newline at end of file
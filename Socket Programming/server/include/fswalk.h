@@ -0,0 +1,116 @@
+/**
+ * @file fswalk.h
+ * @brief Parallel directory tree walker
+ * @version 0.1
+ * @date 2025-12-09
+ *
+ * Directories are work items. Each worker keeps a bounded deque of them:
+ * it pushes and pops its own end (depth first, warm caches) and steals the
+ * oldest, usually largest, subtrees from the other end of its peers' deques.
+ * A directory that finds every slot taken is walked inline instead, so the
+ * queues never grow. On POSIX every directory is opened relative to its
+ * parent (openat/fstatat), so no path is resolved twice and entries are
+ * only stat'ed when their type is not known from readdir or FS_WALK_STAT
+ * asks for sizes. The calling thread is worker 0; helpers are started once
+ * there is a second directory to hand out.
+ *
+ */
+#ifndef FSWALK_H
+#define FSWALK_H
+
+#include "filesys.h"
+
+#include <time.h>
+
+/**
+ * @brief Upper bound and default of fswalk_options_t.threads
+ */
+#define FSWALK_MAX_THREADS 16
+#define FSWALK_DEFAULT_THREADS 4
+
+/**
+ * @brief Directories a worker can queue before walking inline
+ */
+#define FSWALK_QUEUE_CAPACITY 256
+
+/**
+ * @brief Flags of fswalk_options_t
+ */
+#define FSWALK_STAT 0x01 // Fill size and last_modified of every entry
+
+/**
+ * @brief Why the visitor is called
+ */
+typedef enum
+{
+    FSWALK_VISIT_ENTRY,    // Anything but a directory (symlinks are not followed)
+    FSWALK_VISIT_DIR_PRE,  // A directory, before its contents
+    FSWALK_VISIT_DIR_POST, // A directory, once everything below it was visited
+} fswalk_visit_t;
+
+/**
+ * @brief Return values of the visitor
+ */
+typedef enum
+{
+    FSWALK_CONTINUE = 0, // Go on
+    FSWALK_SKIP = 1,     // From FSWALK_VISIT_DIR_PRE: do not descend (no POST either)
+    FSWALK_STOP = -1     // Abort the walk, fswalk_run() fails
+} fswalk_action_t;
+
+/**
+ * @brief An entry handed to the visitor
+ */
+typedef struct
+{
+    fswalk_visit_t visit;
+    const char *dir_path;  // Path of the directory holding the entry
+    int dir_fd;            // Open descriptor of that directory (-1 on Windows)
+    const char *name;      // Entry name within the directory
+    fs_file_type_t type;   // FS_TYPE_FILE, FS_TYPE_DIR, FS_TYPE_SYMLINK or FS_TYPE_UNKNOWN
+    long long size;        // Size in bytes, with FSWALK_STAT only
+    time_t last_modified;  // Modification time, with FSWALK_STAT only
+    int depth;             // 1 for the entries of the root
+    int worker;            // Index of the calling worker, below fswalk_options_t.threads
+} fswalk_entry_t;
+
+/**
+ * @brief Visitor callback.
+ *
+ * Called concurrently from all workers; entry->worker lets it accumulate
+ * into per-worker slots without locking. Every entry of a directory is
+ * visited before the DIR_POST of that directory.
+ *
+ * @param entry The entry, valid during the call only.
+ * @param arg User argument.
+ * @return A fswalk_action_t.
+ */
+typedef int (*fswalk_visitor_t)(const fswalk_entry_t *entry, void *arg);
+
+/**
+ * @brief Options of a walk
+ */
+typedef struct
+{
+    int threads;                // Workers including the caller, 0 for FSWALK_DEFAULT_THREADS
+    int flags;                  // FSWALK_* flags
+    int max_depth;              // Deeper directories fail the walk, 0 for no limit
+    const volatile int *cancel; // Walk stops as soon as *cancel is non-zero (may be NULL)
+} fswalk_options_t;
+
+/**
+ * @brief Walks everything below a directory.
+ *
+ * The root itself is not visited. A failing directory read, a visitor
+ * returning FSWALK_STOP or a cancellation stops all workers; entries
+ * already visited stay visited.
+ *
+ * @param root Directory to walk.
+ * @param options Options, NULL for the defaults.
+ * @param visitor Callback for every entry.
+ * @param arg User argument of the visitor.
+ * @return 0 when the whole tree was visited, -1 on error, stop or cancellation.
+ */
+int fswalk_run(const char *root, const fswalk_options_t *options, fswalk_visitor_t visitor, void *arg);
+
+#endif // FSWALK_H
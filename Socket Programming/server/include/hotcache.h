@@ -0,0 +1,117 @@
+/**
+ * @file hotcache.h
+ * @brief In-memory cache of small, frequently downloaded files
+ * @version 0.1
+ * @date 2025-12-16
+ *
+ * Binary RETR of a cached file is sent straight from the cached copy,
+ * without reading the file again. An entry is keyed by path and is valid
+ * while the file still has the inode, size and mtime it was read with.
+ * Commands that change or move files (STOR, APPE, RNTO, DELE, RMD)
+ * invalidate it explicitly, in case a write within the same second left
+ * all three unchanged.
+ *
+ * The cache is bounded by the total size of the cached files and replaces
+ * entries with the CLOCK algorithm. Entries are reference counted, so a
+ * download keeps sending from an entry that was replaced meanwhile.
+ *
+ */
+#ifndef HOTCACHE_H
+#define HOTCACHE_H
+
+#include "filesys.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Default size limit of a cached file
+ */
+#define HOTCACHE_DEFAULT_MAX_FILE (256 * 1024) // 256KB
+
+/**
+ * @brief A cached file, see hotcache_acquire()
+ */
+typedef struct hotcache_file hotcache_file_t;
+
+/**
+ * @brief Cache statistics
+ */
+typedef struct
+{
+    size_t max_bytes;               // Size limit of all cached files together, 0 if disabled
+    size_t bytes;                   // Size of the cached files
+    size_t entries;                 // Files cached
+    size_t pinned_bytes;            // Replaced entries still held by downloads
+    unsigned long long hits;        // Downloads served from the cache
+    unsigned long long misses;      // Downloads of cacheable files that had to read the file
+    unsigned long long evictions;   // Entries replaced to make room
+} hotcache_stats_t;
+
+/**
+ * @brief Enables the cache.
+ *
+ * @param max_bytes Size limit of all cached files together (0 leaves the cache disabled)
+ * @param max_file_size Files larger than this are not cached (0 for the default)
+ * @return 0 on success, -1 on error
+ */
+int hotcache_init(size_t max_bytes, size_t max_file_size);
+
+/**
+ * @brief Drops all entries and disables the cache.
+ *
+ * Entries still held by downloads are freed when they are released.
+ */
+void hotcache_cleanup(void);
+
+/**
+ * @brief Checks if the cache is enabled.
+ *
+ * @return 1 if enabled, 0 otherwise
+ */
+int hotcache_is_enabled(void);
+
+/**
+ * @brief Gets the cached copy of an open file, reading it into the cache on a miss.
+ *
+ * The file is stat'ed once to validate the entry. Files that are too
+ * large, were modified within the last second or could not be read are
+ * not cached.
+ *
+ * @param path Absolute file path, the key
+ * @param file The open file
+ * @return The cached file, to be released with hotcache_release(), or NULL
+ *         if it is not cached (read it from the file instead)
+ */
+hotcache_file_t *hotcache_acquire(const char *path, fs_file_t *file);
+
+/**
+ * @brief Gets the contents of a cached file.
+ *
+ * @param entry Cached file
+ * @param length Receives the file size
+ * @return The contents, valid until the entry is released
+ */
+const char *hotcache_data(const hotcache_file_t *entry, size_t *length);
+
+/**
+ * @brief Releases a cached file returned by hotcache_acquire().
+ *
+ * @param entry Cached file, NULL is ignored
+ */
+void hotcache_release(hotcache_file_t *entry);
+
+/**
+ * @brief Invalidates the cached copies of path and of everything below it.
+ *
+ * @param path Absolute path of the modified, renamed or removed entry
+ */
+void hotcache_invalidate(const char *path);
+
+/**
+ * @brief Gets the cache statistics.
+ *
+ * @param stats Receives the statistics
+ */
+void hotcache_get_stats(hotcache_stats_t *stats);
+
+#endif // HOTCACHE_H
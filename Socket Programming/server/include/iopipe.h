@@ -0,0 +1,124 @@
+/**
+ * @file iopipe.h
+ * @brief Bounded buffer pipeline overlapping disk and network I/O
+ * @version 0.1
+ * @date 2025-11-28
+ *
+ * A pipeline runs one stage of a transfer on a helper thread, connected to
+ * the caller by a ring of fixed-size buffers. For a download the stage reads
+ * the file ahead while the caller sends (IOPIPE_READ_AHEAD); for an upload
+ * the caller receives while the stage writes the file behind it
+ * (IOPIPE_WRITE_BEHIND). Buffers are handed over in order, so the data
+ * stream is unchanged. With a depth of 1, or if the thread cannot be
+ * started, the stage runs inline in the caller instead.
+ *
+ */
+#ifndef IOPIPE_H
+#define IOPIPE_H
+
+#include <stddef.h>
+
+/**
+ * @brief Limits and default of the buffers in flight per pipeline
+ */
+#define IOPIPE_MIN_DEPTH 1
+#define IOPIPE_MAX_DEPTH 64
+#define IOPIPE_DEFAULT_DEPTH 4
+
+typedef enum
+{
+    IOPIPE_READ_AHEAD,  // The stage produces buffers, the caller consumes them
+    IOPIPE_WRITE_BEHIND // The caller produces buffers, the stage consumes them
+} iopipe_direction_t;
+
+/**
+ * @brief Work done by the pipeline stage on one buffer
+ *
+ * Read-ahead: fills up to length bytes of buffer and returns the byte count,
+ * 0 at the end of the data or -1 on error.
+ * Write-behind: consumes length bytes of buffer and returns 0, or -1 on error.
+ * After an end or an error the stage is not called again.
+ */
+typedef long long (*iopipe_stage_fn)(void *context, char *buffer, size_t length);
+
+typedef struct iopipe iopipe_t;
+
+/**
+ * @brief Pipeline statistics
+ */
+typedef struct
+{
+    unsigned long long buffers;      // Buffers handed from one side to the other
+    unsigned long long caller_waits; // Times the caller blocked on the stage
+    unsigned long long stage_waits;  // Times the stage blocked on the caller
+} iopipe_stats_t;
+
+/**
+ * @brief Creates a pipeline and starts its stage.
+ *
+ * @param direction Which side produces the buffers.
+ * @param depth Buffers in flight (IOPIPE_MIN_DEPTH to IOPIPE_MAX_DEPTH).
+ * @param buffer_size Size of each buffer.
+ * @param stage Stage function, called from the helper thread.
+ * @param context Argument of the stage function.
+ * @return The pipeline, or NULL on error.
+ */
+iopipe_t *iopipe_create(iopipe_direction_t direction, int depth, size_t buffer_size,
+                        iopipe_stage_fn stage, void *context);
+
+/**
+ * @brief Takes the next buffer of a read-ahead pipeline.
+ *
+ * Hands the previously taken buffer back to the stage, so the data must be
+ * used before the next call.
+ *
+ * @param pipe The pipeline.
+ * @param data Receives the buffer.
+ * @return Bytes in the buffer, 0 at the end of the data, -1 if the stage failed.
+ */
+long long iopipe_next(iopipe_t *pipe, const char **data);
+
+/**
+ * @brief Takes an empty buffer of a write-behind pipeline to fill.
+ *
+ * @param pipe The pipeline.
+ * @return A buffer of the pipeline's buffer size, or NULL if the stage failed.
+ */
+char *iopipe_acquire(iopipe_t *pipe);
+
+/**
+ * @brief Queues the acquired buffer for the stage of a write-behind pipeline.
+ *
+ * @param pipe The pipeline.
+ * @param length Bytes filled in the buffer.
+ * @return 0 on success, -1 if no buffer was acquired or the stage failed.
+ */
+int iopipe_submit(iopipe_t *pipe, size_t length);
+
+/**
+ * @brief Waits until the stage of a write-behind pipeline has consumed every queued buffer.
+ *
+ * @param pipe The pipeline.
+ * @return 0 if every stage call succeeded, -1 otherwise.
+ */
+int iopipe_finish(iopipe_t *pipe);
+
+/**
+ * @brief Gets the statistics of a pipeline.
+ *
+ * @param pipe The pipeline.
+ * @param stats Receives the statistics.
+ */
+void iopipe_get_stats(iopipe_t *pipe, iopipe_stats_t *stats);
+
+/**
+ * @brief Stops the stage and frees a pipeline.
+ *
+ * Waits for a stage call in progress; buffers still queued are discarded,
+ * so call iopipe_finish() first to keep them.
+ *
+ * @param pipe The pipeline (NULL is ignored).
+ */
+void iopipe_destroy(iopipe_t *pipe);
+
+#endif // IOPIPE_H
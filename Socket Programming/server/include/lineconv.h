@@ -0,0 +1,109 @@
+/**
+ * @file lineconv.h
+ * @brief Line ending conversion for ASCII mode transfers
+ * @version 0.1
+ * @date 2025-11-25
+ *
+ * The conversion kernel (scalar, SSE2, AVX2 or NEON) is chosen once at
+ * runtime from the CPU features. All kernels produce identical output.
+ *
+ */
+#ifndef LINECONV_H
+#define LINECONV_H
+
+/**
+ * @brief Streaming state for CRLF to LF conversion.
+ *
+ * A CR at the end of a chunk is held back until the next chunk shows
+ * whether it starts with the matching LF.
+ */
+typedef struct
+{
+    int pending_cr;
+} lineconv_state_t;
+
+/**
+ * @brief Initializes (or resets) a conversion state.
+ *
+ * @param state The state to initialize.
+ */
+void lineconv_state_init(lineconv_state_t *state);
+
+/**
+ * @brief Converts one chunk of a CRLF stream to LF.
+ *
+ * Lone CRs are kept. A trailing CR is held in state and emitted by the next
+ * call or by lineconv_crlf_to_lf_finish().
+ *
+ * @param state Streaming state.
+ * @param input The input chunk.
+ * @param input_len The number of bytes in the input chunk.
+ * @param output The output buffer (input_len + 1 bytes always suffice).
+ * @param output_size The size of the output buffer.
+ * @return The number of bytes written, or -1 on error (including a too small output buffer).
+ */
+long long lineconv_crlf_to_lf(lineconv_state_t *state, const char *input, long long input_len,
+                              char *output, long long output_size);
+
+/**
+ * @brief Ends a CRLF to LF stream, emitting a held CR.
+ *
+ * @param state Streaming state (reset on return).
+ * @param output The output buffer.
+ * @param output_size The size of the output buffer.
+ * @return The number of bytes written (0 or 1), or -1 on error.
+ */
+long long lineconv_crlf_to_lf_finish(lineconv_state_t *state, char *output, long long output_size);
+
+/**
+ * @brief Converts LF line endings to CRLF.
+ *
+ * Every LF is expanded, so no state is needed between chunks.
+ *
+ * @param input The input buffer.
+ * @param input_len The number of bytes in the input buffer.
+ * @param output The output buffer (2 * input_len bytes always suffice).
+ * @param output_size The size of the output buffer.
+ * @return The number of bytes written, or -1 on error (including a too small output buffer).
+ */
+long long lineconv_lf_to_crlf(const char *input, long long input_len, char *output, long long output_size);
+
+/**
+ * @brief Gets the number of compiled-in kernels.
+ *
+ * @return Kernel count (at least 1, the scalar kernel is index 0).
+ */
+int lineconv_get_kernel_count(void);
+
+/**
+ * @brief Gets the name of a kernel.
+ *
+ * @param index Kernel index.
+ * @return Kernel name ("scalar", "sse2", "avx2", "neon"), or NULL for a bad index.
+ */
+const char *lineconv_get_kernel_name(int index);
+
+/**
+ * @brief Checks if the CPU can run a kernel.
+ *
+ * @param index Kernel index.
+ * @return 1 if supported, 0 otherwise.
+ */
+int lineconv_is_kernel_supported(int index);
+
+/**
+ * @brief Gets the kernel in use.
+ *
+ * @return Index of the active kernel.
+ */
+int lineconv_get_active_kernel(void);
+
+/**
+ * @brief Forces a kernel, overriding the runtime choice (for tests and benchmarks).
+ *
+ * @param index Kernel index, or -1 to return to the best supported kernel.
+ * @return 0 on success, -1 if the kernel does not exist or is not supported.
+ */
+int lineconv_select_kernel(int index);
+
+#endif // LINECONV_H
@@ -0,0 +1,95 @@
+/**
+ * @file listcache.h
+ * @brief Cache of formatted LIST output per directory
+ * @version 0.1
+ * @date 2025-11-24
+ *
+ * An entry is valid while the directory mtime still matches and it is
+ * younger than the configured TTL. Commands that change a directory
+ * (STOR, APPE, DELE, RNTO, MKD, RMD) invalidate it explicitly, since file
+ * size changes do not touch the directory mtime.
+ *
+ */
+#ifndef LISTCACHE_H
+#define LISTCACHE_H
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @brief Default number of cached directories
+ */
+#define LISTCACHE_DEFAULT_ENTRIES 256
+
+/**
+ * @brief Listings larger than this are not cached
+ */
+#define LISTCACHE_MAX_LISTING (1024 * 1024) // 1MB
+
+/**
+ * @brief Enables the cache.
+ *
+ * @param ttl_seconds Maximum age of an entry (<= 0 leaves the cache disabled)
+ * @param max_entries Number of directories kept (<= 0 for the default)
+ * @return 0 on success, -1 on error
+ */
+int listcache_init(int ttl_seconds, int max_entries);
+
+/**
+ * @brief Drops all entries and disables the cache.
+ */
+void listcache_cleanup(void);
+
+/**
+ * @brief Checks if the cache is enabled.
+ *
+ * @return 1 if enabled, 0 otherwise
+ */
+int listcache_is_enabled(void);
+
+/**
+ * @brief Looks up the listing of a directory.
+ *
+ * @param dirpath Absolute directory path
+ * @param dir_mtime Current modification time of the directory
+ * @param data Receives a malloc'd copy of the listing (caller frees)
+ * @param length Receives the listing length in bytes
+ * @return 0 on hit, -1 on miss
+ */
+int listcache_lookup(const char *dirpath, time_t dir_mtime, char **data, size_t *length);
+
+/**
+ * @brief Gets the invalidation generation.
+ *
+ * Take this before reading the directory and pass it to listcache_store(),
+ * so a listing that raced with an invalidation is not stored.
+ *
+ * @return Current generation
+ */
+unsigned long listcache_get_generation(void);
+
+/**
+ * @brief Stores the listing of a directory, replacing any previous entry.
+ *
+ * Listings of directories modified within the last second are not stored,
+ * because a change in the same second would not move the mtime.
+ *
+ * @param dirpath Absolute directory path
+ * @param dir_mtime Directory modification time observed before listing
+ * @param generation Value of listcache_get_generation() taken before listing
+ * @param data Formatted listing
+ * @param length Listing length in bytes
+ */
+void listcache_store(const char *dirpath, time_t dir_mtime, unsigned long generation,
+                     const char *data, size_t length);
+
+/**
+ * @brief Invalidates the cached listings affected by a change to path.
+ *
+ * Drops the entry for path itself (if it is a directory) and for its parent.
+ *
+ * @param path Absolute path of the created, modified, renamed or removed entry
+ */
+void listcache_invalidate(const char *path);
+
+#endif // LISTCACHE_H
@@ -16,6 +16,25 @@ typedef enum log_level_t
     LOG_LEVEL_ERROR
 } log_level_t;
 
+/**
+ * @brief What an asynchronous producer does when the ring buffer is full.
+ */
+typedef enum log_overflow_policy_t
+{
+    LOG_OVERFLOW_DROP, // Discard the message and count it as dropped
+    LOG_OVERFLOW_BLOCK // Wait until the writer thread frees a slot
+} log_overflow_policy_t;
+
+/**
+ * @brief Longest formatted line kept by the asynchronous logger (longer lines are truncated).
+ */
+#define LOG_ASYNC_LINE_MAX 1024
+
+/**
+ * @brief Default number of ring buffer slots for the asynchronous logger.
+ */
+#define LOG_ASYNC_DEFAULT_CAPACITY 4096
+
 /**
  * @brief Initialize the log system.
  *
@@ -40,10 +59,40 @@ int logger_init(const char *log_file, log_level_t level);
  */
 void logger_log(log_level_t level, const char *filename, int line, const char *funcname, const char *format, ...);
 
+/**
+ * @brief Switch the log system to asynchronous mode.
+ *
+ * Producers format lines into a lock-free ring buffer and a background writer
+ * thread writes them out in batches. ERROR messages wake the writer, which
+ * flushes and fsyncs the log file before going back to sleep.
+ * Must be called after logger_init(); logger_close() stops the writer.
+ *
+ * @param capacity Number of ring slots (rounded up to a power of two, 0 for the default)
+ * @param policy Behavior when the ring is full
+ * @retval 0:    Success
+ * @retval -1:   Failure or error (logger stays synchronous)
+ */
+int logger_enable_async(unsigned int capacity, log_overflow_policy_t policy);
+
+/**
+ * @brief Write out every message logged before this call and fsync the log file.
+ *
+ * In asynchronous mode this blocks until the writer thread has caught up.
+ */
+void logger_flush(void);
+
+/**
+ * @brief Get the number of messages dropped because the ring buffer was full.
+ *
+ * @return Dropped message count since logger_enable_async().
+ */
+unsigned long long logger_get_dropped_count(void);
+
 /**
  * @brief Close the log system.
  *
  * Thread-safe. It can be called concurrently with logger_log().
+ * Pending asynchronous messages are written out before the file is closed.
  * After calling this, logger_log() will silently fail until
  * logger_init() is called again.
  */
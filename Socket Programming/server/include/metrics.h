@@ -0,0 +1,185 @@
+/**
+ * @file metrics.h
+ * @brief Server-wide counters and latency histograms
+ * @version 0.1
+ * @date 2025-11-30
+ *
+ * Every thread records into its own shard, so the hot paths take no lock
+ * and share no cache line with other threads; a shard is folded into the
+ * retired totals when its thread exits. Reading merges all shards under a
+ * mutex. Histograms have power-of-two microsecond buckets from
+ * METRICS_MIN_BOUND_US to METRICS_MAX_BOUND_US and an overflow bucket.
+ *
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "command.h"
+#include "network.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Upper bounds of the first and the last finite histogram bucket (16us and about 16.8s)
+ */
+#define METRICS_MIN_BOUND_US 16LL
+#define METRICS_MAX_BOUND_US (16LL << 20)
+#define METRICS_HISTOGRAM_BUCKETS 22 // 21 finite buckets and the overflow bucket
+
+/**
+ * @brief Histogram slot of commands that have no handler
+ */
+#define METRICS_UNKNOWN_COMMAND CMD_MAX_HANDLERS
+
+/**
+ * @brief Latencies recorded outside of command handling
+ */
+typedef enum
+{
+    METRICS_DATA_CONNECT,   // Opening a data connection (PORT connect or PASV accept)
+    METRICS_FILE_LOCK_WAIT, // Acquiring a file lock, 0 when uncontended
+    METRICS_LATENCY_COUNT
+} metrics_latency_t;
+
+/**
+ * @brief Kinds of data transfer
+ */
+typedef enum
+{
+    METRICS_DOWNLOAD, // RETR
+    METRICS_UPLOAD,   // STOR, APPE
+    METRICS_LISTING,  // LIST, NLST, MLSD
+    METRICS_DIRECTION_COUNT
+} metrics_direction_t;
+
+/**
+ * @brief Outcomes of a data transfer
+ */
+typedef enum
+{
+    METRICS_RESULT_OK,
+    METRICS_RESULT_ABORTED,
+    METRICS_RESULT_FAILED,
+    METRICS_RESULT_COUNT
+} metrics_result_t;
+
+/**
+ * @brief Output formats of metrics_render()
+ */
+typedef enum
+{
+    METRICS_FORMAT_TEXT,      // Human-readable summary, one item per line
+    METRICS_FORMAT_PROMETHEUS // Prometheus text exposition format 0.0.4
+} metrics_format_t;
+
+/**
+ * @brief A latency histogram
+ */
+typedef struct
+{
+    unsigned long long count;
+    unsigned long long sum_us;
+    unsigned long long buckets[METRICS_HISTOGRAM_BUCKETS]; // Not cumulative
+} metrics_histogram_t;
+
+/**
+ * @brief Merged view of all shards
+ */
+typedef struct
+{
+    metrics_histogram_t commands[CMD_MAX_HANDLERS + 1]; // Indexed by handler slot, see METRICS_UNKNOWN_COMMAND
+    metrics_histogram_t latencies[METRICS_LATENCY_COUNT];
+    metrics_histogram_t transfers[METRICS_DIRECTION_COUNT]; // Duration of successful transfers
+    unsigned long long transfer_results[METRICS_DIRECTION_COUNT][METRICS_RESULT_COUNT];
+    unsigned long long transfer_bytes[METRICS_DIRECTION_COUNT]; // Bytes of successful file transfers, 0 for listings
+    unsigned long long sessions_opened;
+    unsigned long long sessions_closed;
+} metrics_snapshot_t;
+
+/**
+ * @brief Gets a monotonic timestamp in microseconds.
+ *
+ * @return Microseconds since an arbitrary fixed point.
+ */
+long long metrics_now_us(void);
+
+/**
+ * @brief Records the time taken by a command.
+ *
+ * @param slot Handler slot of the command, or METRICS_UNKNOWN_COMMAND.
+ * @param elapsed_us Time spent in the handler.
+ */
+void metrics_observe_command(int slot, long long elapsed_us);
+
+/**
+ * @brief Records a latency outside of command handling.
+ *
+ * @param latency What was measured.
+ * @param elapsed_us Time taken.
+ */
+void metrics_observe_latency(metrics_latency_t latency, long long elapsed_us);
+
+/**
+ * @brief Records a finished data transfer.
+ *
+ * @param direction Kind of transfer.
+ * @param result Outcome.
+ * @param bytes Bytes moved (counted for successful transfers only).
+ * @param elapsed_us Duration (recorded for successful transfers only).
+ */
+void metrics_record_transfer(metrics_direction_t direction, metrics_result_t result,
+                             long long bytes, long long elapsed_us);
+
+/**
+ * @brief Counts a session being opened or closed.
+ *
+ * @param opened 1 when the session was created, 0 when it was destroyed.
+ */
+void metrics_record_session(int opened);
+
+/**
+ * @brief Merges all shards.
+ *
+ * @param snapshot Receives the totals.
+ */
+void metrics_get_snapshot(metrics_snapshot_t *snapshot);
+
+/**
+ * @brief Gets an upper bound of a histogram quantile.
+ *
+ * @param histogram The histogram.
+ * @param quantile Quantile between 0 and 1.
+ * @return Bound of the bucket holding the quantile in microseconds, -1 if it
+ *         is the overflow bucket, 0 for an empty histogram.
+ */
+long long metrics_histogram_quantile(const metrics_histogram_t *histogram, double quantile);
+
+/**
+ * @brief Renders the metrics together with the worker pool, passive port
+ * and bandwidth scheduler statistics.
+ *
+ * @param format Output format.
+ * @param length Receives the length of the text (may be NULL).
+ * @return Text to free() by the caller, or NULL on allocation failure.
+ */
+char *metrics_render(metrics_format_t format, size_t *length);
+
+/**
+ * @brief Starts serving the Prometheus format over HTTP (GET /metrics).
+ *
+ * Scrapes are answered one at a time on a dedicated thread.
+ *
+ * @param family Address family of the listening socket.
+ * @param bind_address Address to listen on.
+ * @param port Port to listen on.
+ * @return 0 on success, -1 on error.
+ */
+int metrics_http_start(net_addr_family_t family, const char *bind_address, uint16_t port);
+
+/**
+ * @brief Stops the HTTP endpoint, if running.
+ */
+void metrics_http_stop(void);
+
+#endif // METRICS_H
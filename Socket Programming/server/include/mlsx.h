@@ -0,0 +1,85 @@
+/**
+ * @file mlsx.h
+ * @brief Machine-readable listings (RFC 3659 MLST and MLSD)
+ * @version 0.1
+ * @date 2025-12-08
+ *
+ * An entry is written as "fact=value;...; name" with the facts chosen by
+ * OPTS MLST. Numbers and timestamps are formatted by hand, and the owner
+ * and group names are looked up only when those facts are selected.
+ *
+ */
+#ifndef MLSX_H
+#define MLSX_H
+
+#include "auth.h"
+#include "filesys.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Facts an entry can carry, as a bit mask
+ */
+typedef enum
+{
+    MLSX_FACT_TYPE = 0x001,           // file, dir or OS.unix=<kind>
+    MLSX_FACT_SIZE = 0x002,           // Size in bytes (not given for directories)
+    MLSX_FACT_MODIFY = 0x004,         // Modification time, YYYYMMDDHHMMSS in UTC
+    MLSX_FACT_PERM = 0x008,           // Operations the user may perform
+    MLSX_FACT_UNIX_MODE = 0x010,      // Permission bits in octal
+    MLSX_FACT_UNIX_OWNER = 0x020,     // Numeric uid
+    MLSX_FACT_UNIX_GROUP = 0x040,     // Numeric gid
+    MLSX_FACT_UNIX_OWNERNAME = 0x080, // User name (needs a lookup)
+    MLSX_FACT_UNIX_GROUPNAME = 0x100  // Group name (needs a lookup)
+} mlsx_fact_t;
+
+/**
+ * @brief Facts of a session that did not send OPTS MLST
+ */
+#define MLSX_DEFAULT_FACTS (MLSX_FACT_TYPE | MLSX_FACT_SIZE | MLSX_FACT_MODIFY | MLSX_FACT_PERM | \
+                            MLSX_FACT_UNIX_MODE)
+
+/**
+ * @brief Large enough for every fact of an entry, without the name
+ */
+#define MLSX_MAX_FACTS_LEN 256
+
+/**
+ * @brief Writes a fact list such as "type*;size*;UNIX.owner;".
+ *
+ * @param facts Facts currently selected.
+ * @param mark_selected 1 to list every fact and mark the selected ones with
+ *                      '*' (FEAT), 0 to list the selected ones only (OPTS MLST).
+ * @param buffer Output buffer.
+ * @param buffer_size Size of the output buffer.
+ * @return 0 on success, -1 if the buffer is too small.
+ */
+int mlsx_format_fact_list(unsigned int facts, int mark_selected, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Parses the argument of OPTS MLST ("fact;fact;...").
+ *
+ * Fact names are case-insensitive; unknown ones are ignored, as RFC 3659
+ * requires.
+ *
+ * @param list Fact names separated by ';', may be empty.
+ * @return Mask of the facts recognized.
+ */
+unsigned int mlsx_parse_fact_list(const char *list);
+
+/**
+ * @brief Formats one entry.
+ *
+ * @param info Entry information; directories are described by info->type.
+ * @param facts Facts to write.
+ * @param permissions Permissions of the user, used by the perm fact.
+ * @param name Name written after the facts (the entry name for MLSD, the
+ *             pathname for MLST).
+ * @param buffer Output buffer, receives the entry without line ending.
+ * @param buffer_size Size of the output buffer.
+ * @return Length written, or -1 if the buffer is too small.
+ */
+int mlsx_format_entry(const fs_file_info_t *info, unsigned int facts, auth_permission_t permissions,
+                      const char *name, char *buffer, size_t buffer_size);
+
+#endif // MLSX_H
@@ -8,6 +8,8 @@
 #ifndef NETWORK_H
 #define NETWORK_H
 
+#include "filesys.h"
+
 #include <stdint.h>
 #include <stddef.h>
 
@@ -63,6 +65,38 @@ typedef enum
  */
 socket_t net_create_listening_socket(net_addr_family_t family, const char *bind_address, uint16_t port, int backlog);
 
+/**
+ * @brief Checks whether several sockets can listen on one port with the kernel
+ * spreading new connections across them (SO_REUSEPORT on Linux, SO_REUSEPORT_LB on FreeBSD).
+ *
+ * @return 1 if supported, 0 otherwise.
+ */
+int net_reuseport_supported(void);
+
+/**
+ * @brief Checks whether shutting a listening socket down wakes the threads
+ * waiting for connections on it (Linux), so another thread can end the wait.
+ *
+ * @return 1 if supported, 0 otherwise.
+ */
+int net_listener_shutdown_supported(void);
+
+/**
+ * @brief Creates a listening socket in the load-balancing group of a port.
+ *
+ * Every socket created this way for the same address and port receives a
+ * share of the incoming connections, so each can be served by its own thread.
+ *
+ * @param family The address family to use (IPv4, IPv6, or Unspecified).
+ * @param bind_address The IP address to bind to (NULL for any address).
+ * @param port The port number to listen on.
+ * @param backlog The maximum number of pending connections to queue.
+ * @return The listening socket descriptor, or INVALID_SOCKET_T on error or if
+ *         net_reuseport_supported() is 0.
+ */
+socket_t net_create_listening_socket_reuseport(net_addr_family_t family, const char *bind_address, uint16_t port,
+                                               int backlog);
+
 /**
  * @brief Creates a listening socket within a specified port range.
  *
@@ -154,6 +188,100 @@ int net_receive_all(socket_t connected_socket, void *buffer, size_t length);
  */
 int net_receive_line(socket_t connected_socket, char *buffer, size_t buffer_size, int timeout_ms);
 
+/**
+ * @brief Size of the receive buffer used by the buffered line reader.
+ *
+ * Must be larger than the longest accepted command line so several
+ * pipelined commands can be read with one receive call.
+ */
+#define NET_LINE_BUFFER_SIZE 4096
+
+/**
+ * @brief Receive buffer for reading CRLF-terminated lines without a system call per byte.
+ *
+ * Bytes in [start, end) have been received but not yet returned as a line.
+ * The NET_LINE_BUFFER_SIZE bytes of storage are only allocated while bytes
+ * are pending, so an idle connection holds none.
+ */
+typedef struct
+{
+    char *data; // NULL while the buffer is empty
+    size_t start;
+    size_t end;
+} net_line_buffer_t;
+
+/**
+ * @brief Initializes a line buffer.
+ *
+ * @param line_buffer The buffer to initialize.
+ */
+void net_line_buffer_init(net_line_buffer_t *line_buffer);
+
+/**
+ * @brief Discards pending bytes and frees the storage of a line buffer.
+ *
+ * @param line_buffer The buffer, it can be filled again afterwards.
+ */
+void net_line_buffer_free(net_line_buffer_t *line_buffer);
+
+/**
+ * @brief Performs a single receive call into a line buffer.
+ *
+ * Blocks only if the socket has no data; call after the socket is known to be
+ * readable to avoid blocking.
+ *
+ * @param connected_socket The socket to receive data from.
+ * @param line_buffer The buffer to append to.
+ * @return The number of bytes received, 0 if the connection was closed by the peer,
+ *         or -1 on error (including a full buffer).
+ */
+int net_line_buffer_fill(socket_t connected_socket, net_line_buffer_t *line_buffer);
+
+/**
+ * @brief Extracts the next complete line (until CRLF) from a line buffer.
+ *
+ * Does not perform any I/O.
+ *
+ * @param line_buffer The buffer to read from.
+ * @param buffer The buffer to store the line (includes CRLF, NUL-terminated).
+ * @param buffer_size The maximum size of the buffer.
+ * @return The length of the line (including CRLF), 0 if no complete line is buffered,
+ *         or -1 if the pending line does not fit in buffer_size.
+ */
+int net_line_buffer_next(net_line_buffer_t *line_buffer, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Receives a line of text from a socket (until CRLF) through a line buffer.
+ *
+ * Same contract as net_receive_line(), but reads in bulk: lines that are
+ * already buffered are returned without any system call, and the remainder
+ * of a receive stays buffered for the next call.
+ *
+ * Before each receive the socket is checked for urgent data. TCP stops a read
+ * at the urgent mark, so the line following a Telnet Synch is still reported.
+ *
+ * @param connected_socket The socket to receive data from.
+ * @param line_buffer Per-connection line buffer.
+ * @param buffer The buffer to store the received line (includes CRLF).
+ * @param buffer_size The maximum size of the buffer.
+ * @param timeout_ms Timeout in milliseconds for each wait. -1 means wait indefinitely.
+ * @param has_urgent Set to 1 if urgent data was pending while reading this line (can be NULL).
+ * @return The number of bytes received (including CRLF), 0 if connection closed, -1 on error or timeout.
+ */
+int net_receive_line_buffered(socket_t connected_socket, net_line_buffer_t *line_buffer,
+                              char *buffer, size_t buffer_size, int timeout_ms, int *has_urgent);
+
+/**
+ * @brief Gets the received bytes a socket has buffered above the kernel.
+ *
+ * A socket secured with TLS (see tlssock.h) decrypts whole records, so input
+ * may be waiting that select() and readiness events do not report.
+ *
+ * @param connected_socket The socket to check.
+ * @return The number of bytes net_receive() returns without touching the socket, 0 for plain sockets.
+ */
+size_t net_receive_pending(socket_t connected_socket);
+
 /**
  * @brief Sends data to a connected socket.
  *
@@ -176,9 +304,83 @@ int net_send(socket_t connected_socket, const void *data, size_t length);
  */
 int net_send_all(socket_t connected_socket, const void *data, size_t length);
 
+/**
+ * @brief Size of the output buffer used to coalesce small sends.
+ */
+#define NET_SEND_BUFFER_SIZE (64 * 1024)
+
+/**
+ * @brief Output buffer that gathers many small writes into few send calls.
+ *
+ * Bytes in [0, used) have been appended but not yet sent.
+ */
+typedef struct
+{
+    socket_t sock;
+    size_t used;
+    unsigned long sends; // Number of net_send_all() calls issued so far
+    char data[NET_SEND_BUFFER_SIZE];
+} net_send_buffer_t;
+
+/**
+ * @brief Initializes (or empties) a send buffer.
+ *
+ * @param send_buffer The buffer to initialize.
+ * @param sock The socket the buffer is flushed to.
+ */
+void net_send_buffer_init(net_send_buffer_t *send_buffer, socket_t sock);
+
+/**
+ * @brief Appends data to a send buffer, flushing it first if the data does not fit.
+ *
+ * Data larger than the whole buffer is sent directly after the pending bytes.
+ *
+ * @param send_buffer The buffer to append to.
+ * @param data The data to append.
+ * @param length The number of bytes to append.
+ * @return 0 on success, -1 if a flush failed.
+ */
+int net_send_buffer_append(net_send_buffer_t *send_buffer, const void *data, size_t length);
+
+/**
+ * @brief Sends all pending bytes of a send buffer.
+ *
+ * @param send_buffer The buffer to flush.
+ * @return 0 on success (including an empty buffer), -1 on failure.
+ */
+int net_send_buffer_flush(net_send_buffer_t *send_buffer);
+
+/**
+ * @brief Return value of net_send_file() when zero-copy sending is not available.
+ */
+#define NET_SENDFILE_UNSUPPORTED -2
+
+/**
+ * @brief Sends a byte range of an open file to a connected socket without
+ * copying it through user space.
+ *
+ * Uses sendfile() on Linux, BSD and macOS, and TransmitFile() on Windows.
+ * A socket secured with TLS supports it only where the kernel encrypts (kTLS).
+ * The file position of the handle is not relied upon; on Windows it is moved.
+ * Loops until the whole range is sent, the end of the file is reached, or an
+ * error occurs.
+ *
+ * @param sock The socket to send data to.
+ * @param file Open file handle.
+ * @param offset Offset of the first byte to send.
+ * @param length Number of bytes to send.
+ * @return The number of bytes sent (less than length only at end of file), -1 on error,
+ *         or NET_SENDFILE_UNSUPPORTED if the platform, file or socket does not
+ *         support zero-copy sending and nothing was sent.
+ */
+long long net_send_file(socket_t sock, fs_file_t *file, long long offset, long long length);
+
 /**
  * @brief Closes a socket.
  *
+ * A socket secured with TLS sends close_notify first, unless another thread
+ * is using it.
+ *
  * @param sock The socket descriptor to close.
  */
 void net_close_socket(socket_t sock);
@@ -0,0 +1,82 @@
+/**
+ * @file objpool.h
+ * @brief Pool of fixed-size objects carved from slabs
+ * @version 0.1
+ * @date 2025-12-12
+ *
+ * Objects are cut from slabs of per_slab objects and recycled through a
+ * free list, so allocating one after start-up costs a lock and a pointer
+ * swap, and objects of one pool sit next to each other instead of being
+ * spread over the heap. Slabs go back to the system only in
+ * objpool_destroy().
+ *
+ */
+#ifndef OBJPOOL_H
+#define OBJPOOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/**
+ * @brief A pool; define it with OBJPOOL_INITIALIZER, the fields are private
+ */
+typedef struct
+{
+    size_t object_size;    // Requested size of an object
+    size_t per_slab;       // Objects cut from each slab
+    void *free_list;       // Free objects, linked through their first word
+    void *slabs;           // Slabs, linked through their first word
+    size_t allocated;      // Objects cut from slabs so far
+    size_t in_use;         // Objects handed out and not yet freed
+    pthread_mutex_t mutex; // Guards all of the above
+} objpool_t;
+
+/**
+ * @brief Static initializer of a pool of objects of size bytes
+ */
+#define OBJPOOL_INITIALIZER(size, per_slab) {(size), (per_slab), NULL, NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER}
+
+/**
+ * @brief Usage of a pool
+ */
+typedef struct
+{
+    size_t object_size; // Bytes an object occupies in its slab, alignment included
+    size_t allocated;   // Objects cut from slabs, in use or free
+    size_t in_use;      // Objects handed out
+} objpool_stats_t;
+
+/**
+ * @brief Takes an object from the pool.
+ *
+ * @param pool The pool
+ * @return The object, its contents undefined, or NULL if a new slab could not be allocated
+ */
+void *objpool_alloc(objpool_t *pool);
+
+/**
+ * @brief Returns an object to the pool.
+ *
+ * @param pool The pool it came from
+ * @param object The object, NULL is ignored
+ */
+void objpool_free(objpool_t *pool, void *object);
+
+/**
+ * @brief Gets the usage of a pool.
+ *
+ * @param pool The pool
+ * @param stats Receives the usage
+ */
+void objpool_get_stats(objpool_t *pool, objpool_stats_t *stats);
+
+/**
+ * @brief Frees all slabs; every object must have been returned.
+ *
+ * The pool can be used again afterwards.
+ *
+ * @param pool The pool
+ */
+void objpool_destroy(objpool_t *pool);
+
+#endif // OBJPOOL_H
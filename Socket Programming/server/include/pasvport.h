@@ -0,0 +1,94 @@
+/**
+ * @file pasvport.h
+ * @brief Server-wide passive mode port allocator
+ * @version 0.1
+ * @date 2025-11-26
+ *
+ * Free ports are kept in a FIFO, so a lease takes the port that has been
+ * free the longest without probing the range with bind() calls. A port
+ * that turns out to be taken by another process goes to the back of the
+ * queue. Optionally a few listening sockets are kept bound ahead of time,
+ * so PASV can answer without any socket setup at all.
+ *
+ */
+#ifndef PASVPORT_H
+#define PASVPORT_H
+
+#include "network.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Ports tried per lease before giving up when binds keep failing
+ */
+#define PASV_PORT_MAX_ATTEMPTS 16
+
+/**
+ * @brief Allocator statistics
+ */
+typedef struct
+{
+    int range_size;                   // Ports in the passive range
+    int free_ports;                   // Ports waiting in the free queue
+    int leased_ports;                 // Ports held by sessions or pre-bound sockets
+    int prebound_sockets;             // Listening sockets ready to be handed out
+    unsigned long long leases;        // Successful leases since init
+    unsigned long long prebound_hits; // Leases served from the pre-bound pool
+    unsigned long long bind_failures; // Ports that failed to bind (in use elsewhere)
+} pasv_port_stats_t;
+
+/**
+ * @brief Initializes the allocator.
+ *
+ * @param port_min Lowest passive port.
+ * @param port_max Highest passive port.
+ * @param bind_address Address the pre-bound sockets listen on (NULL for any).
+ * @param prebind_count Listening sockets to keep bound ahead of time (0 to disable).
+ * @return 0 on success, -1 on error.
+ */
+int pasv_port_init(uint16_t port_min, uint16_t port_max, const char *bind_address, int prebind_count);
+
+/**
+ * @brief Closes the pre-bound sockets and disables the allocator.
+ */
+void pasv_port_cleanup(void);
+
+/**
+ * @brief Checks if the allocator is initialized.
+ *
+ * @return 1 if enabled, 0 otherwise.
+ */
+int pasv_port_is_enabled(void);
+
+/**
+ * @brief Leases a port and returns a socket listening on it.
+ *
+ * Pre-bound sockets are used when bind_address matches the one given to
+ * pasv_port_init(); connections that reached such a socket before it was
+ * handed out are dropped.
+ *
+ * @param bind_address Address to listen on (NULL for any).
+ * @param backlog Listen backlog for a newly bound socket.
+ * @param port Receives the leased port.
+ * @return The listening socket, or INVALID_SOCKET_T if no port could be leased.
+ */
+socket_t pasv_port_acquire(const char *bind_address, int backlog, uint16_t *port);
+
+/**
+ * @brief Returns a leased port to the free queue.
+ *
+ * Call after the listening socket of the lease was closed. May bind a
+ * replacement pre-bound socket.
+ *
+ * @param port The leased port (ports not currently leased are ignored).
+ */
+void pasv_port_release(uint16_t port);
+
+/**
+ * @brief Gets allocator statistics.
+ *
+ * @param stats Receives the statistics.
+ */
+void pasv_port_get_stats(pasv_port_stats_t *stats);
+
+#endif // PASVPORT_H
@@ -52,8 +52,9 @@ typedef enum
 typedef enum
 {
     PROTO_MODE_STREAM,    // Stream mode (default)
-    PROTO_MODE_BLOCK,     // Block mode
-    PROTO_MODE_COMPRESSED // Compressed mode
+    PROTO_MODE_BLOCK,      // Block mode
+    PROTO_MODE_COMPRESSED, // Compressed mode
+    PROTO_MODE_DEFLATE     // Deflate compressed stream (MODE Z extension)
 } proto_transfer_mode_t;
 
 /**
@@ -163,7 +164,8 @@ int proto_parse_type(const char *argument, proto_transfer_type_t *type);
 /**
  * @brief Parses a MODE command argument.
  *
- * MODE command format: "MODE S" (Stream), "MODE B" (Block), or "MODE C" (Compressed)
+ * MODE command format: "MODE S" (Stream), "MODE B" (Block), "MODE C" (Compressed)
+ * or "MODE Z" (Deflate)
  *
  * @param argument The MODE command argument string.
  * @param mode Pointer to store the parsed transfer mode.
@@ -247,6 +249,7 @@ int proto_normalize_path(char *path, size_t max_length);
 #define PROTO_RESP_CLOSING_DATA         226
 #define PROTO_RESP_ENTERING_PASV        227
 #define PROTO_RESP_USER_LOGGED_IN       230
+#define PROTO_RESP_AUTH_OK              234 // RFC 4217: security data exchange complete
 #define PROTO_RESP_FILE_ACTION_OK       250
 #define PROTO_RESP_PATH_CREATED         257
 
@@ -266,8 +269,11 @@ int proto_normalize_path(char *path, size_t max_length);
 #define PROTO_RESP_COMMAND_NOT_IMPL     502
 #define PROTO_RESP_BAD_COMMAND_SEQUENCE 503
 #define PROTO_RESP_COMMAND_NOT_IMPL_PARAM 504
+#define PROTO_RESP_DATA_PROT_REFUSED    521 // RFC 4217: data connection refused at this PROT level
 #define PROTO_RESP_NOT_LOGGED_IN        530
 #define PROTO_RESP_NEED_ACCOUNT_STORE   532
+#define PROTO_RESP_POLICY_DENIED        534 // RFC 2228: request denied for policy reasons
+#define PROTO_RESP_PROT_NOT_SUPPORTED   536 // RFC 2228: protection level not supported
 #define PROTO_RESP_FILE_UNAVAILABLE     550
 #define PROTO_RESP_PAGE_TYPE_UNKNOWN    551
 #define PROTO_RESP_EXCEEDED_STORAGE     552
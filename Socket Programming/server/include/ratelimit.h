@@ -0,0 +1,134 @@
+/**
+ * @file ratelimit.h
+ * @brief Hierarchical token-bucket bandwidth scheduler
+ * @version 0.1
+ * @date 2025-11-29
+ *
+ * Transfer bytes are charged against three buckets in turn: the server-wide
+ * bucket, a bucket shared by all sessions of the same user, and the bucket
+ * of the session itself. A bucket refills at its rate and may go into debt;
+ * the charge returns how long the caller has to pause until every bucket is
+ * out of debt again. Sessions sharing a bucket thereby take turns and split
+ * its rate, so a bulk transfer cannot starve the other sessions of a user
+ * or of the server. A rate of 0 leaves that level unlimited.
+ *
+ */
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include <stddef.h>
+
+/**
+ * @brief Highest rate a bucket accepts, in bytes per second (1TB/s)
+ */
+#define RATELIMIT_MAX_RATE 1000000000000ULL
+
+/**
+ * @brief Burst a bucket allows after being idle: 1/RATELIMIT_BURST_DIVISOR
+ * of a second at its rate, but at least RATELIMIT_MIN_BURST bytes
+ */
+#define RATELIMIT_BURST_DIVISOR 10
+#define RATELIMIT_MIN_BURST 16384
+
+/**
+ * @brief Bytes moved between two charges: 1/RATELIMIT_CHUNKS_PER_SECOND of a
+ * second at the lowest rate that applies, but at least RATELIMIT_MIN_CHUNK bytes
+ */
+#define RATELIMIT_CHUNKS_PER_SECOND 20
+#define RATELIMIT_MIN_CHUNK 1024
+
+/**
+ * @brief Longest single sleep of a paced transfer, so ABOR is noticed promptly
+ */
+#define RATELIMIT_MAX_SLEEP_MS 50
+
+typedef struct ratelimit_session ratelimit_session_t;
+
+/**
+ * @brief Scheduler statistics
+ */
+typedef struct
+{
+    unsigned long long global_rate;  // Server-wide rate in bytes per second, 0 if unlimited
+    unsigned long long session_rate; // Default per-session rate, 0 if unlimited
+    int user_buckets;                // Users with a shared bucket in use
+    unsigned long long charged;      // Bytes charged since init
+    unsigned long long delays;       // Charges that made the caller pause
+    unsigned long long delay_us;     // Total pause requested, in microseconds
+} ratelimit_stats_t;
+
+/**
+ * @brief Sets the server-wide and the default per-session rate.
+ *
+ * @param global_rate Bytes per second for all sessions together (0 for unlimited).
+ * @param session_rate Bytes per second for each session (0 for unlimited).
+ * @return 0 on success, -1 on error.
+ */
+int ratelimit_init(unsigned long long global_rate, unsigned long long session_rate);
+
+/**
+ * @brief Resets the scheduler to unlimited. Sessions must be destroyed first.
+ */
+void ratelimit_cleanup(void);
+
+/**
+ * @brief Creates the scheduler state of a session, not yet tied to a user.
+ *
+ * @return The session state, or NULL on error.
+ */
+ratelimit_session_t *ratelimit_session_create(void);
+
+/**
+ * @brief Ties a session to the shared bucket of a user.
+ *
+ * Replaces the previous user, if any. The rate of the shared bucket follows
+ * the rate given by the latest login of that user.
+ *
+ * @param limiter The session state.
+ * @param username The user, or NULL to leave only the global and session buckets.
+ * @param user_rate Bytes per second for all sessions of the user (0 for unlimited).
+ * @return 0 on success, -1 on error (the session is then without user bucket).
+ */
+int ratelimit_session_set_user(ratelimit_session_t *limiter, const char *username,
+                               unsigned long long user_rate);
+
+/**
+ * @brief Frees the scheduler state of a session.
+ *
+ * @param limiter The session state (NULL is ignored).
+ */
+void ratelimit_session_destroy(ratelimit_session_t *limiter);
+
+/**
+ * @brief Gets the size of the scheduler state of a session.
+ *
+ * @return Bytes allocated by ratelimit_session_create().
+ */
+size_t ratelimit_session_size(void);
+
+/**
+ * @brief Gets how many bytes to move before the next charge.
+ *
+ * @param limiter The session state (NULL for unlimited).
+ * @param max_bytes Upper bound, usually the transfer buffer size.
+ * @return max_bytes if no bucket applies, otherwise a slice of the lowest rate.
+ */
+size_t ratelimit_chunk_size(ratelimit_session_t *limiter, size_t max_bytes);
+
+/**
+ * @brief Charges transferred bytes to the global, user and session buckets.
+ *
+ * @param limiter The session state (NULL for unlimited).
+ * @param bytes Bytes just sent or received.
+ * @return Microseconds to pause before moving more data, 0 if none.
+ */
+long long ratelimit_charge(ratelimit_session_t *limiter, size_t bytes);
+
+/**
+ * @brief Gets scheduler statistics.
+ *
+ * @param stats Receives the statistics.
+ */
+void ratelimit_get_stats(ratelimit_stats_t *stats);
+
+#endif // RATELIMIT_H
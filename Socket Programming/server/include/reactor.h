@@ -0,0 +1,94 @@
+/**
+ * @file reactor.h
+ * @brief Readiness-based event loop for control connections
+ * @version 0.1
+ * @date 2025-11-20
+ *
+ * A small reactor that multiplexes many sockets over a fixed set of event
+ * loop threads. It uses epoll on Linux and kqueue on BSD/macOS. Every
+ * registered socket is armed one-shot, so at most one loop thread runs the
+ * read callback for a given socket at a time; the socket is re-armed when the
+ * callback returns.
+ *
+ */
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "network.h"
+
+/**
+ * @brief Called on a loop thread when a registered socket becomes readable.
+ *
+ * @param user_data Pointer passed to reactor_add().
+ * @return 0 to keep watching the socket, non-zero to unregister it.
+ *         When non-zero is returned the reactor stops watching the socket
+ *         and invokes the close callback with the same user data.
+ */
+typedef int (*reactor_read_cb_t)(void *user_data);
+
+/**
+ * @brief Called on a loop thread after a socket has been unregistered.
+ *
+ * The callback owns user_data and the socket from this point on.
+ *
+ * @param user_data Pointer passed to reactor_add().
+ */
+typedef void (*reactor_close_cb_t)(void *user_data);
+
+/**
+ * @brief Called periodically from a single loop thread.
+ */
+typedef void (*reactor_tick_cb_t)(void);
+
+/**
+ * @brief Checks if an event backend is available on this platform.
+ *
+ * @return 1 if supported, 0 otherwise.
+ */
+int reactor_is_supported(void);
+
+/**
+ * @brief Gets the name of the event backend compiled in.
+ *
+ * @return "epoll", "kqueue" or "none".
+ */
+const char *reactor_get_backend_name(void);
+
+/**
+ * @brief Starts the reactor and its loop threads.
+ *
+ * @param num_threads Number of loop threads (<= 0 selects a default based on the CPU count).
+ * @param on_readable Read callback (required).
+ * @param on_close Close callback (required).
+ * @param on_tick Periodic callback (can be NULL).
+ * @param tick_ms Interval between on_tick calls in milliseconds.
+ * @return 0 on success, -1 on error.
+ */
+int reactor_init(int num_threads, reactor_read_cb_t on_readable, reactor_close_cb_t on_close,
+                 reactor_tick_cb_t on_tick, int tick_ms);
+
+/**
+ * @brief Registers a socket with the reactor.
+ *
+ * @param sock Connected socket to watch for readability.
+ * @param user_data Pointer handed to the callbacks.
+ * @return 0 on success, -1 on error (the socket is not registered).
+ */
+int reactor_add(socket_t sock, void *user_data);
+
+/**
+ * @brief Stops and joins all loop threads.
+ *
+ * Sockets that are still registered are left untouched; the caller is
+ * responsible for releasing them. Callbacks are not invoked after this returns.
+ */
+void reactor_shutdown(void);
+
+/**
+ * @brief Gets the number of loop threads currently running.
+ *
+ * @return Number of loop threads, 0 if the reactor is not running.
+ */
+int reactor_get_thread_count(void);
+
+#endif // REACTOR_H
@@ -10,8 +10,23 @@
 
 #include "network.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
+/**
+ * @brief Maximum number of acceptor threads
+ */
+#define SERVER_MAX_ACCEPTORS 64
+
+/**
+ * @brief Connection handling engine
+ */
+typedef enum
+{
+    SERVER_ENGINE_THREADED = 0, // One blocking thread per client (default)
+    SERVER_ENGINE_EVENT         // Control connections multiplexed over event loop threads (epoll/kqueue)
+} server_engine_t;
+
 /**
  * @brief Server configuration structure
  */
@@ -22,8 +37,29 @@ typedef struct
     char bind_address[64];            // Address to bind to (e.g., "0.0.0.0" or "127.0.0.1")
     int max_backlog;                  // Maximum pending connections
     int command_timeout_ms;           // Command timeout in milliseconds
+    int data_timeout_ms;              // Time a transfer may move no data before it is aborted (<= 0 disables)
     int max_connections;              // Maximum concurrent connections (-1 for unlimited)
     net_addr_family_t address_family; // Address family: NET_AF_IPV4, NET_AF_IPV6, NET_AF_UNSPEC
+    server_engine_t engine;           // Connection engine: SERVER_ENGINE_THREADED or SERVER_ENGINE_EVENT
+    int event_threads;                // Event loop threads for SERVER_ENGINE_EVENT (<= 0 for default)
+    int transfer_workers;             // Maximum transfer worker threads (<= 0 to match max_connections)
+    int listing_cache_ttl;            // Seconds a cached LIST stays valid (<= 0 disables the listing cache)
+    uint16_t pasv_port_min;           // Lowest port handed out for passive mode
+    uint16_t pasv_port_max;           // Highest port handed out for passive mode
+    int pasv_prebind;                 // Passive listening sockets kept bound ahead of time (0 disables)
+    int compression_level;            // Default deflate level for MODE Z (0-9)
+    int pipeline_depth;               // Read-ahead/write-behind buffers per file transfer (1 disables)
+    int upload_durability;            // transfer_durability_t: when uploads are flushed to disk
+    int atomic_uploads;               // 1 to upload to a temporary file renamed over the target on success
+    unsigned long long global_rate_limit;  // Bytes per second for all transfers together (0 for unlimited)
+    unsigned long long session_rate_limit; // Bytes per second for the transfers of each session (0 for unlimited)
+    uint16_t metrics_port;                 // Port of the Prometheus metrics endpoint (0 disables)
+    size_t hot_cache_bytes;                // Memory for caching small popular files (0 disables the file cache)
+    int acceptor_threads;                  // Threads accepting connections (<= 1: the main thread alone)
+    int acceptor_pinning;                  // 1 to pin acceptor threads to CPUs round-robin
+    char tls_cert_file[1024];              // PEM certificate chain for AUTH TLS ("" disables TLS)
+    char tls_key_file[1024];               // PEM private key ("" if it is in tls_cert_file)
+    int tls_required;                      // 1 to refuse logins and data connections without TLS
 } server_config_t;
 
 /**
@@ -41,7 +77,8 @@ int server_init(const server_config_t *config);
  * @brief Starts the FTP server main loop
  *
  * This runs the main accept loop, accepting client connections
- * and spawning threads to handle them. It blocks until server_stop() is called
+ * and either spawning threads to handle them or handing them to the
+ * event loops, depending on the configured engine. It blocks until server_stop() is called
  * or a fatal error occurs.
  *
  * @return 0 on success, -1 on error
@@ -64,6 +101,15 @@ void server_stop(void);
  */
 void server_cleanup(void);
 
+/**
+ * @brief Gets the active server configuration
+ *
+ * Only valid between server_init() and server_cleanup().
+ *
+ * @return Pointer to the configuration
+ */
+const server_config_t *server_get_config(void);
+
 /**
  * @brief Checks if the server is currently running
  *
@@ -10,19 +10,28 @@
 #include "network.h"
 #include "protocol.h"
 #include "auth.h"
+#include "filesys.h"
+#include "ratelimit.h"
 #include "transfer.h"
+#include "threadpool.h"
+#include "timerwheel.h"
 #include <stdint.h>
 #include <pthread.h>
 
 /**
- * @brief Maximum length of username
+ * @brief Maximum length of directory path
  */
-#define SESSION_MAX_USERNAME 256
+#define SESSION_MAX_PATH 1024
 
 /**
- * @brief Maximum length of directory path
+ * @brief A path resolved once, with the metadata of one stat of it
  */
-#define SESSION_MAX_PATH 1024
+typedef struct
+{
+    char path[SESSION_MAX_PATH]; // Absolute filesystem path
+    int exists;                  // 1 if the path existed when it was stat'ed
+    fs_stat_t st;                // Metadata, valid when exists is set
+} session_path_t;
 
 /**
  * @brief Session states for authentication flow
@@ -49,29 +58,42 @@ typedef enum
  * @brief FTP session structure
  *
  * Contains all state information for a single FTP client connection.
+ * Sessions come from a pool; paths and names that many sessions have in
+ * common are shared strings, and state only needed during a rename or a
+ * transfer is allocated for its duration, so an idle session stays small.
  */
 typedef struct session_t
 {
     // Connection information
-    socket_t control_socket; // Control connection socket
-    char client_ip[64];      // Client IP address
-    uint16_t client_port;    // Client port number
-    char bind_address[64];   // Server bind address for data connections
+    socket_t control_socket;  // Control connection socket
+    char client_ip[64];       // Client IP address
+    uint16_t client_port;     // Client port number
+    const char *bind_address; // Server bind address for data connections (shared)
+    net_line_buffer_t control_buffer; // Buffered, not yet processed control channel input
+
+    // Connection security (RFC 4217), see tlssock.h
+    int control_protected; // 1 once AUTH TLS has secured the control connection
+    int tls_pending;       // 1 after AUTH TLS was accepted, until session_secure_control() runs
+    int pbsz_set;          // 1 once PBSZ was accepted, which PROT requires
+    int data_protected;    // 1 after PROT P: data connections are secured as well
 
     // Authentication state
     session_state_t state;               // Current session state
-    char username[SESSION_MAX_USERNAME]; // Username (if authenticated)
+    const char *username;                // Username (if authenticated), "" if none (shared)
     int authenticated;                   // 1 if authenticated, 0 otherwise
     auth_permission_t permissions;       // User permissions (from auth module)
 
-    // Directory management
-    char root_dir[SESSION_MAX_PATH];      // Root directory (chroot)
-    char current_dir[SESSION_MAX_PATH];   // Current working directory (relative to root)
-    char user_home_dir[SESSION_MAX_PATH]; // User's home directory (from auth module)
+    // Directory management, shared strings (see strintern.h) changed under lock
+    const char *root_dir;      // Root directory (chroot)
+    const char *current_dir;   // Current working directory (relative to root)
+    const char *user_home_dir; // User's home directory (from auth module), "" if none
 
     // Transfer parameters
     proto_transfer_type_t transfer_type;   // ASCII or Binary. EBCDIC is rarely used
-    proto_transfer_mode_t transfer_mode;   // Stream, Block, or Compressed
+    proto_transfer_mode_t transfer_mode;   // Stream, Block, Compressed or Deflate
+    int compression_level;                 // Deflate level for MODE Z (OPTS MODE Z LEVEL)
+    unsigned int mlst_facts;               // Facts of MLST/MLSD entries (OPTS MLST), see mlsx.h
+    digest_algorithm_t hash_algorithm;     // Algorithm of HASH (OPTS HASH)
     proto_data_structure_t data_structure; // File, Record, or Page
 
     // Data connection
@@ -84,21 +106,27 @@ typedef struct session_t
     uint16_t active_port; // Client port for active mode
 
     // Passive mode parameters (PASV command)
-    uint16_t passive_port; // Server port for passive mode
+    uint16_t passive_port;    // Server port for passive mode
+    int passive_port_leased;  // 1 if passive_port is leased from the port allocator
 
     // Command state
-    char rename_from[SESSION_MAX_PATH]; // Temporary storage for RNFR command
+    char *rename_from;                  // Path given to RNFR, allocated while rename_pending
     long long restart_offset;           // File offset for REST command
+    long long restart_end;              // Last byte of the range set by RANG, -1 to the end of the file
+    long long allocation_size;          // Upload size announced by ALLO, 0 if none
     int rename_pending;                 // 1 if RNFR was issued, waiting for RNTO
 
     // Transfer state
     int transfer_in_progress;           // 1 if a data transfer is currently in progress
     volatile int transfer_should_abort; // 1 if transfer should be aborted (ABOR command)
+    ratelimit_session_t *limiter;       // Bandwidth buckets of the session and its user, NULL if unpaced
 
-    // Async transfer thread support
-    pthread_t transfer_thread;                     // Transfer thread handle
+    // Async transfer support (runs on the transfer worker pool)
+    threadpool_job_t transfer_job;                 // Pool job node for the current transfer
+    int transfer_job_active;                       // 1 from submission until the job has finished with the session
+    pthread_cond_t transfer_job_done;              // Signalled when transfer_job_active drops to 0
     transfer_thread_state_t transfer_thread_state; // Current transfer thread state
-    void *transfer_params;                         // Parameters for current transfer (opaque)
+    transfer_params_t *transfer_params;            // Parameters for current transfer, pooled while the job is active
     transfer_status_t transfer_result;             // Result of completed transfer
 
     // Thread safety
@@ -109,6 +137,17 @@ typedef struct session_t
     time_t last_activity;     // Time of last activity
     volatile int should_quit; // 1 if session should terminate
 
+    // Deadlines, enforced on the timer wheel (see session_set_timeouts())
+    timerwheel_timer_t idle_timer;        // Closes the control connection once idle for idle_timeout_ms
+    timerwheel_timer_t accept_timer;      // Ends the wait for a passive mode data connection
+    timerwheel_timer_t stall_timer;       // Closes a data connection that moved nothing for data_timeout_ms
+    int idle_timeout_ms;                  // Control connection idle limit (<= 0 disables)
+    int data_timeout_ms;                  // Data connection stall limit (<= 0 disables)
+    int accept_expired;                   // 1 once accept_timer has fired for the current wait
+    int transfer_stalled;                 // 1 once stall_timer has closed the current transfer
+    unsigned long long transfer_progress; // Bytes moved by the current transfer, updated atomically
+    unsigned long long stall_progress;    // transfer_progress at the last stall check
+
     // Statistics (for tracking data transfer)
     unsigned long long bytes_uploaded;   // Total bytes uploaded (STOR etc.)
     unsigned long long bytes_downloaded; // Total bytes downloaded (RETR etc.)
@@ -140,6 +179,38 @@ session_t *session_create(socket_t control_socket,
  */
 void session_destroy(session_t *session);
 
+/**
+ * @brief Memory held by sessions
+ */
+typedef struct
+{
+    size_t idle_bytes;       // Heap memory of one idle session: its pooled object and rate limiter
+    size_t sessions_in_use;  // Sessions alive
+    size_t sessions_pooled;  // Session objects in the pool, alive or free for reuse
+    size_t transfers_in_use; // Transfer parameter blocks held by running transfers
+    size_t shared_bytes;     // Shared strings (directories, usernames) of all sessions together
+} session_memory_stats_t;
+
+/**
+ * @brief Gets the memory held by sessions.
+ *
+ * @param stats Receives the figures
+ */
+void session_get_memory_stats(session_memory_stats_t *stats);
+
+/**
+ * @brief Frees the session pools; call once no session is left.
+ */
+void session_pool_cleanup(void);
+
+/**
+ * @brief Logs the session out: clears the username, home directory and
+ * permissions and goes back to the root directory (REIN).
+ *
+ * @param session Pointer to session
+ */
+void session_reset_user(session_t *session);
+
 /**
  * @brief Sets the authenticated user for a session.
  *
@@ -224,6 +295,39 @@ int session_resolve_path(session_t *session,
                          char *absolute_path,
                          size_t buffer_size);
 
+/**
+ * @brief Normalizes a session-relative path to an absolute path within the session.
+ *
+ * @param session Pointer to session
+ * @param relative_path Path relative to current directory (or absolute within session)
+ * @param virtual_path Buffer to store the path as the client sees it (starts with '/')
+ * @param buffer_size Size of virtual_path buffer
+ * @return 0 on success, -1 on error or security violation
+ */
+int session_get_virtual_path(session_t *session, const char *relative_path,
+                             char *virtual_path, size_t buffer_size);
+
+/**
+ * @brief Resolves a session-relative path and stats it once.
+ *
+ * Handlers take their existence, type and size checks from the snapshot
+ * instead of calling the filesystem for each. A missing path is not an error.
+ *
+ * @param session Pointer to session
+ * @param relative_path Path relative to current directory (or absolute within session)
+ * @param resolved Receives the absolute path and its metadata
+ * @return 0 on success, -1 on error or security violation
+ */
+int session_lookup_path(session_t *session, const char *relative_path, session_path_t *resolved);
+
+/**
+ * @brief Stats a looked up path again, e.g. after the file lock was taken.
+ *
+ * @param resolved Path from session_lookup_path()
+ * @return 1 if the path exists, 0 otherwise
+ */
+int session_path_refresh(session_path_t *resolved);
+
 /**
  * @brief Sets up a data connection in active mode (PORT).
  *
@@ -314,12 +418,51 @@ int session_set_restart_offset(session_t *session, long long offset);
 long long session_get_restart_offset(session_t *session);
 
 /**
- * @brief Clears any pending restart offset without using it.
+ * @brief Sets a byte range for the next transfer (RANG command).
+ *
+ * Replaces any restart offset; a later REST replaces the range again.
+ *
+ * @param session Pointer to session
+ * @param start First byte of the range
+ * @param end Last byte of the range (inclusive), >= start
+ * @return 0 on success, -1 on error
+ */
+int session_set_restart_range(session_t *session, long long start, long long end);
+
+/**
+ * @brief Gets the last byte of the pending range without clearing it.
+ *
+ * The first byte is the restart offset.
+ *
+ * @param session Pointer to session
+ * @return The last byte of the range (inclusive), -1 if the transfer runs to the end of the file
+ */
+long long session_get_restart_end(session_t *session);
+
+/**
+ * @brief Clears any pending restart offset and range without using them.
  *
  * @param session Pointer to session
  */
 void session_clear_restart_offset(session_t *session);
 
+/**
+ * @brief Records the size of the next upload (ALLO).
+ *
+ * @param session Pointer to session
+ * @param size Announced upload size in bytes
+ * @return 0 on success, -1 on error
+ */
+int session_set_allocation_size(session_t *session, long long size);
+
+/**
+ * @brief Gets and clears the announced upload size.
+ *
+ * @param session Pointer to session
+ * @return The size announced by ALLO, 0 if none
+ */
+long long session_take_allocation_size(session_t *session);
+
 /**
  * @brief Stores the source path for a rename operation (RNFR).
  *
@@ -408,6 +551,67 @@ void session_update_activity(session_t *session);
  */
 int session_is_timed_out(session_t *session, int timeout_seconds);
 
+/**
+ * @brief Sets the session's deadlines and arms its idle timer.
+ *
+ * The timer wheel shuts the control connection down once the session has
+ * been idle for idle_timeout_ms (not counting time spent in a transfer),
+ * so the connection's reader sees it close and needs no receive timeout.
+ * Transfers that move no data for data_timeout_ms have their data
+ * connection closed and fail with 426.
+ *
+ * @param session Pointer to session
+ * @param idle_timeout_ms Control connection idle limit in milliseconds (<= 0 disables)
+ * @param data_timeout_ms Data connection stall limit in milliseconds (<= 0 disables)
+ * @return 0 on success, -1 if the timer wheel is not running (no deadline is enforced)
+ */
+int session_set_timeouts(session_t *session, int idle_timeout_ms, int data_timeout_ms);
+
+/**
+ * @brief Records data moved by the running transfer, for stall detection.
+ *
+ * @param session Pointer to session
+ * @param bytes Bytes sent or received
+ */
+void session_add_transfer_progress(session_t *session, size_t bytes);
+
+/**
+ * @brief Checks if the running transfer was stopped for making no progress.
+ *
+ * @param session Pointer to session
+ * @return 1 if stalled, 0 otherwise
+ */
+int session_is_transfer_stalled(session_t *session);
+
+/**
+ * @brief Receives the next command line from the control connection.
+ *
+ * Reads through the session's control buffer, so pipelined commands are
+ * served from memory. Only the thread that owns the control connection may
+ * call this; it does not take the session lock.
+ *
+ * @param session Pointer to session
+ * @param buffer Buffer to store the line (includes CRLF)
+ * @param buffer_size Size of the buffer
+ * @param timeout_ms Timeout in milliseconds. -1 means wait indefinitely.
+ * @param has_urgent Set to 1 if urgent data (e.g. Telnet Synch before ABOR) was pending (can be NULL)
+ * @return The number of bytes received, 0 if the connection was closed, -1 on error or timeout
+ */
+int session_receive_line(session_t *session, char *buffer, size_t buffer_size, int timeout_ms, int *has_urgent);
+
+/**
+ * @brief Performs the TLS handshake that AUTH TLS announced on the control connection.
+ *
+ * The handshake and every later read block, so the command handlers only
+ * set tls_pending and the thread that owns the control connection calls
+ * this before receiving the next command. The event engine hands the
+ * session to a thread of its own first.
+ *
+ * @param session Pointer to session
+ * @return 0 on success, -1 if the handshake failed (should_quit is set)
+ */
+int session_secure_control(session_t *session);
+
 /**
  * @brief Sends a response message on the control connection.
  *
@@ -433,6 +637,18 @@ int session_send_response(session_t *session, int code, const char *message);
  */
 int session_send_response_multiline(session_t *session, int code, const char *message);
 
+/**
+ * @brief Sends a line of a multi-line response as is, without a reply code.
+ *
+ * For replies whose inner lines have a fixed syntax, such as the entry of
+ * MLST, which starts with a space.
+ *
+ * @param session Pointer to session
+ * @param line Line to send, without CRLF
+ * @return 0 on success, -1 on error
+ */
+int session_send_response_text(session_t *session, const char *line);
+
 /**
  * @brief Sets the transfer thread state for a session.
  *
@@ -450,7 +666,11 @@ void session_set_transfer_thread_state(session_t *session, transfer_thread_state
 transfer_thread_state_t session_get_transfer_thread_state(session_t *session);
 
 /**
- * @brief Starts a transfer thread for asynchronous data transfer.
+ * @brief Starts an asynchronous data transfer.
+ *
+ * The parameters are copied into the session and the transfer is queued on
+ * the shared transfer worker pool. If the pool is not running, a dedicated
+ * detached thread is used instead.
  *
  * @param session Pointer to session
  * @param params Transfer parameters
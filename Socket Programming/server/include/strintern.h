@@ -0,0 +1,56 @@
+/**
+ * @file strintern.h
+ * @brief Shared, reference-counted strings
+ * @version 0.1
+ * @date 2025-12-12
+ *
+ * Equal strings acquired by different owners share one copy, which stays
+ * allocated until the last owner releases it. Sessions keep their root,
+ * home and current directory and their username this way, so thousands of
+ * sessions of the same user in the same directory hold one copy of each.
+ * The strings are immutable; change one by acquiring the new value and
+ * releasing the old.
+ *
+ */
+#ifndef STRINTERN_H
+#define STRINTERN_H
+
+#include <stddef.h>
+
+/**
+ * @brief Usage of the string table
+ */
+typedef struct
+{
+    size_t strings;    // Distinct strings held
+    size_t references; // Owners of those strings
+    size_t bytes;      // Memory of the strings, headers included
+} strintern_stats_t;
+
+/**
+ * @brief Gets the shared copy of a string, creating it on first use.
+ *
+ * The empty string is a static that needs no allocation, so acquiring it
+ * never fails.
+ *
+ * @param text The string
+ * @return The shared copy, to be released with strintern_release(), or
+ *         NULL if text is NULL or memory ran out
+ */
+const char *strintern_acquire(const char *text);
+
+/**
+ * @brief Releases a string returned by strintern_acquire().
+ *
+ * @param text The shared copy, NULL is ignored
+ */
+void strintern_release(const char *text);
+
+/**
+ * @brief Gets the usage of the string table.
+ *
+ * @param stats Receives the usage
+ */
+void strintern_get_stats(strintern_stats_t *stats);
+
+#endif // STRINTERN_H
@@ -0,0 +1,101 @@
+/**
+ * @file threadpool.h
+ * @brief Bounded pool of worker threads for data transfers
+ * @version 0.1
+ * @date 2025-11-22
+ *
+ * Workers are created on demand, up to a configured maximum, and then kept
+ * parked on a condition variable so later jobs reuse them instead of paying
+ * for a pthread_create per transfer. Jobs beyond the number of workers wait
+ * in a FIFO queue.
+ *
+ * Job nodes are supplied by the caller (intrusive queue), so submitting a job
+ * never allocates. A node must stay valid and must not be resubmitted until
+ * its function has started running.
+ *
+ */
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/**
+ * @brief Job function run on a worker thread.
+ *
+ * @param arg Pointer stored in the job node.
+ */
+typedef void (*threadpool_job_fn_t)(void *arg);
+
+/**
+ * @brief Queue node for a pool job.
+ */
+typedef struct threadpool_job
+{
+    threadpool_job_fn_t fn;      // Function to run
+    void *arg;                   // Argument passed to fn
+    struct threadpool_job *next; // Next queued job (owned by the pool while queued)
+} threadpool_job_t;
+
+/**
+ * @brief Snapshot of pool counters.
+ */
+typedef struct
+{
+    int max_workers;                   // Upper bound on worker threads
+    int workers;                       // Worker threads currently alive
+    int busy_workers;                  // Workers currently running a job
+    int queue_depth;                   // Jobs waiting for a worker
+    unsigned long long jobs_completed; // Jobs finished since threadpool_init()
+} threadpool_stats_t;
+
+/**
+ * @brief Starts the pool. No threads are created until the first job arrives.
+ *
+ * @param max_workers Maximum number of worker threads (must be > 0).
+ * @return 0 on success, -1 on error.
+ */
+int threadpool_init(int max_workers);
+
+/**
+ * @brief Queues a job for execution on a worker thread.
+ *
+ * A new worker is spawned when no parked worker is available and the
+ * pool is below its maximum; otherwise the job waits for a free worker.
+ *
+ * @param job Caller-owned job node with fn set.
+ * @return 0 on success, -1 if the pool is not running or no worker could be started.
+ */
+int threadpool_submit(threadpool_job_t *job);
+
+/**
+ * @brief Checks if the pool is accepting jobs.
+ *
+ * @return 1 if running, 0 otherwise.
+ */
+int threadpool_is_running(void);
+
+/**
+ * @brief Gets a consistent snapshot of the pool counters.
+ *
+ * @param stats Output structure (zeroed if the pool is not running).
+ */
+void threadpool_get_stats(threadpool_stats_t *stats);
+
+/**
+ * @brief Gets the number of jobs waiting for a worker.
+ *
+ * @return Queue depth.
+ */
+int threadpool_get_queue_depth(void);
+
+/**
+ * @brief Gets the number of workers currently running a job.
+ *
+ * @return Busy worker count.
+ */
+int threadpool_get_busy_count(void);
+
+/**
+ * @brief Stops accepting jobs, runs the jobs still queued and joins all workers.
+ */
+void threadpool_shutdown(void);
+
+#endif // THREADPOOL_H
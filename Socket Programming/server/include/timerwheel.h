@@ -0,0 +1,118 @@
+/**
+ * @file timerwheel.h
+ * @brief Hashed timer wheel for connection deadlines
+ * @version 0.1
+ * @date 2025-12-14
+ *
+ * One thread advances a wheel of slots at a fixed tick; a timer sits in the
+ * slot of its expiry tick, so arming, re-arming and cancelling are O(1) and
+ * a tick only visits the timers of one slot. Control idle timeouts, passive
+ * mode accept deadlines and stalled transfers are all detected here instead
+ * of by every connection waking up on its own timeouts.
+ *
+ * Timer nodes are supplied by the caller (intrusive lists), so arming a
+ * timer never allocates. Callbacks run on the wheel thread with the wheel
+ * locked: they must be short, must not block (use trylock and retry on the
+ * next tick) and must not call the timerwheel functions. In exchange, once
+ * timerwheel_cancel() returns the callback is not running and will not run.
+ *
+ */
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <stddef.h>
+
+/**
+ * @brief Default tick, the resolution of all deadlines
+ */
+#define TIMERWHEEL_DEFAULT_TICK_MS 100
+
+/**
+ * @brief Called on the wheel thread when a timer expires.
+ *
+ * @param user_data Pointer stored in the timer.
+ * @return Milliseconds until the timer fires again, or 0 to leave it disarmed.
+ */
+typedef int (*timerwheel_cb_t)(void *user_data);
+
+/**
+ * @brief Timer node, embedded in the structure it watches.
+ */
+typedef struct timerwheel_timer
+{
+    struct timerwheel_timer *prev; // Neighbours in the slot (owned by the wheel while armed)
+    struct timerwheel_timer *next;
+    unsigned long long expires;    // Tick the timer fires at
+    timerwheel_cb_t callback;      // Function to run on expiry
+    void *user_data;               // Argument passed to callback
+    int armed;                     // 1 while the timer sits in the wheel
+} timerwheel_timer_t;
+
+/**
+ * @brief Snapshot of wheel counters.
+ */
+typedef struct
+{
+    int tick_ms;                // Tick length
+    size_t armed;               // Timers waiting in the wheel
+    unsigned long long expired; // Callbacks run since timerwheel_init()
+} timerwheel_stats_t;
+
+/**
+ * @brief Prepares a timer node; call once before the timer is first armed.
+ *
+ * @param timer Timer node.
+ * @param callback Function to run on expiry.
+ * @param user_data Argument passed to callback.
+ */
+void timerwheel_timer_init(timerwheel_timer_t *timer, timerwheel_cb_t callback, void *user_data);
+
+/**
+ * @brief Starts the wheel thread.
+ *
+ * @param tick_ms Tick length in milliseconds (<= 0 selects TIMERWHEEL_DEFAULT_TICK_MS).
+ * @return 0 on success, -1 on error.
+ */
+int timerwheel_init(int tick_ms);
+
+/**
+ * @brief Arms a timer, or moves an armed timer to a new deadline.
+ *
+ * The timer never fires early; it fires at most one tick late.
+ *
+ * @param timer Timer node prepared with timerwheel_timer_init().
+ * @param delay_ms Milliseconds from now.
+ * @return 0 on success, -1 if the wheel is not running (the timer stays disarmed).
+ */
+int timerwheel_schedule(timerwheel_timer_t *timer, int delay_ms);
+
+/**
+ * @brief Disarms a timer; does nothing if it is not armed.
+ *
+ * Waits for its callback if that is running, so the structure holding the
+ * timer can be freed afterwards.
+ *
+ * @param timer Timer node.
+ */
+void timerwheel_cancel(timerwheel_timer_t *timer);
+
+/**
+ * @brief Checks if the wheel thread is running.
+ *
+ * @return 1 if running, 0 otherwise.
+ */
+int timerwheel_is_running(void);
+
+/**
+ * @brief Gets a consistent snapshot of the wheel counters.
+ *
+ * @param stats Output structure.
+ */
+void timerwheel_get_stats(timerwheel_stats_t *stats);
+
+/**
+ * @brief Stops and joins the wheel thread and disarms the timers left in it.
+ */
+void timerwheel_shutdown(void);
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,132 @@
+/**
+ * @file tlssock.h
+ * @brief TLS on connected sockets (FTPS, RFC 4217)
+ * @version 0.1
+ * @date 2025-12-18
+ *
+ * A socket secured with tlssock_accept() keeps its socket_t: net_send(),
+ * net_receive() and the functions built on them encrypt transparently, so
+ * responses, listings and transfers need no TLS-specific code. Closing the
+ * socket with net_close_socket() sends close_notify and frees the TLS state.
+ *
+ * Data connections resume the TLS session of the control connection when
+ * the client offers it, which skips the full handshake per transfer. Where
+ * the kernel supports TLS offload (Linux kTLS), net_send_file() keeps
+ * sending files without copying them through user space.
+ *
+ * Requires a build with ENABLE_OPENSSL; without it tlssock_init() fails
+ * and tlssock_is_available() returns 0.
+ *
+ */
+#ifndef TLSSOCK_H
+#define TLSSOCK_H
+
+#include "network.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Time a client gets to complete a handshake
+ */
+#define TLSSOCK_HANDSHAKE_TIMEOUT_MS 10000
+
+/**
+ * @brief Handshake statistics
+ */
+typedef struct
+{
+    unsigned long long handshakes; // Completed handshakes
+    unsigned long long resumed;    // Completed handshakes that resumed an earlier session
+    unsigned long long failures;   // Failed handshakes
+    unsigned long long ktls_send;  // Completed handshakes with kernel TLS offload for sending
+    int secured;                   // Sockets currently secured
+} tlssock_stats_t;
+
+/**
+ * @brief Loads the certificate and key and enables TLS.
+ *
+ * @param cert_file PEM file with the certificate chain
+ * @param key_file PEM file with the private key (NULL or "" to read it from cert_file)
+ * @return 0 on success, -1 on error or if built without OpenSSL
+ */
+int tlssock_init(const char *cert_file, const char *key_file);
+
+/**
+ * @brief Disables TLS again. Sockets still secured keep working until closed.
+ */
+void tlssock_cleanup(void);
+
+/**
+ * @brief Checks if TLS is built in and enabled.
+ *
+ * @return 1 if available, 0 otherwise
+ */
+int tlssock_is_available(void);
+
+/**
+ * @brief Performs the server side of a handshake on a connected, blocking socket.
+ *
+ * On success the socket is secured: net_* I/O on it goes through TLS.
+ * On failure nothing is attached and the connection is unusable.
+ *
+ * @param sock Connected socket
+ * @param timeout_ms Time the peer gets to complete the handshake (<= 0 for no limit)
+ * @return 0 on success, -1 on error
+ */
+int tlssock_accept(socket_t sock, int timeout_ms);
+
+/**
+ * @brief Checks if a socket is secured.
+ *
+ * @return 1 if secured, 0 otherwise
+ */
+int tlssock_is_secured(socket_t sock);
+
+/**
+ * @brief Gets the handshake statistics.
+ *
+ * @param stats Receives the statistics
+ */
+void tlssock_get_stats(tlssock_stats_t *stats);
+
+/*
+ * Hooks of the network module. Each returns 1 if the socket is secured and
+ * the operation was done through TLS (result in *result), 0 if the socket is
+ * a plain one for the caller to handle.
+ */
+
+/**
+ * @brief Receives decrypted data, see net_receive()
+ */
+int tlssock_receive(socket_t sock, void *buffer, size_t buffer_size, int *result);
+
+/**
+ * @brief Encrypts and sends data, see net_send()
+ */
+int tlssock_send(socket_t sock, const void *data, size_t length, int *result);
+
+/**
+ * @brief Sends a file range, see net_send_file()
+ *
+ * The result is NET_SENDFILE_UNSUPPORTED unless the kernel encrypts for the socket.
+ */
+int tlssock_send_file(socket_t sock, fs_file_t *file, long long offset, long long length, long long *result);
+
+/**
+ * @brief Gets the decrypted bytes buffered for a socket, which select() does not see
+ *
+ * @return The number of bytes, 0 for plain sockets
+ */
+size_t tlssock_pending(socket_t sock);
+
+/**
+ * @brief Sends close_notify if no other thread is using the socket; never blocks
+ */
+void tlssock_close_notify(socket_t sock);
+
+/**
+ * @brief Sends close_notify and detaches the TLS state before the socket is closed
+ */
+void tlssock_detach(socket_t sock);
+
+#endif // TLSSOCK_H
@@ -9,6 +9,9 @@
 #define TRANSFER_H
 
 #include "protocol.h"
+#include "digest.h"
+#include "filelock.h"
+#include "filesys.h"
 
 // Forward declaration to avoid circular include
 struct session_t;
@@ -19,6 +22,28 @@ typedef struct session_t session_t;
  */
 #define TRANSFER_BUFFER_SIZE 65536 // 64KB
 
+/**
+ * @brief Bytes handed to the kernel per zero-copy send call
+ *
+ * Abort requests are checked between slices.
+ */
+#define TRANSFER_ZERO_COPY_SLICE (1024 * 1024) // 1MB
+
+/**
+ * @brief Upload bytes between two write-backs with TRANSFER_DURABILITY_PERIODIC
+ */
+#define TRANSFER_SYNC_INTERVAL (8 * 1024 * 1024) // 8MB
+
+/**
+ * @brief When uploaded data is forced to stable storage.
+ */
+typedef enum
+{
+	TRANSFER_DURABILITY_NONE,    // Leave write-back to the system
+	TRANSFER_DURABILITY_CLOSE,   // Flush once when the upload completes
+	TRANSFER_DURABILITY_PERIODIC // Also write back every TRANSFER_SYNC_INTERVAL bytes
+} transfer_durability_t;
+
 /**
  * @brief Result codes for data transfer operations.
  */
@@ -51,7 +76,9 @@ typedef enum
 	TRANSFER_OP_SEND_FILE,   // Send file (RETR)
 	TRANSFER_OP_RECV_FILE,   // Receive file (STOR/APPE)
 	TRANSFER_OP_SEND_LIST,   // Send directory listing (LIST)
-	TRANSFER_OP_SEND_NLST    // Send name list (NLST)
+	TRANSFER_OP_SEND_NLST,   // Send name list (NLST)
+	TRANSFER_OP_SEND_MLSD,   // Send machine-readable listing (MLSD)
+	TRANSFER_OP_HASH         // Checksum a file, no data connection (HASH, XCRC, XMD5, XSHA256)
 } transfer_operation_t;
 
 /**
@@ -62,14 +89,46 @@ typedef struct
 	transfer_operation_t operation; // Operation type
 	char filepath[1024];		    // File/directory path for transfer
 	long long offset;			    // Transfer offset (for file operations)
+	long long length;			    // Bytes from offset set by RANG (RETR, HASH), -1 to the end of the file
 	proto_transfer_type_t type;     // Transfer type (ASCII/BINARY)
 	int lock_acquired;			    // 1 if file lock was acquired, 0 otherwise
+	file_lock_t *shared_lock;	    // Handle of the shared lock if acquired as one (RETR, HASH)
+	long long size_hint;		    // Upload size announced by ALLO, 0 if unknown
+	int atomic;					    // Upload to a temporary file renamed over filepath on success
+	fs_stat_t stat;				    // Metadata of filepath taken by the handler (RETR, LIST)
+	int file_opened;			    // 1 if the handler opened file, the transfer thread closes it
+	fs_file_t file;				    // filepath opened and revalidated under the file lock (RETR, HASH)
+	digest_algorithm_t algorithm;   // Checksum algorithm (HASH)
+	int hash_reply;				    // 1 to reply as HASH (algorithm, range, name), 0 as XCRC/XMD5/XSHA256
+	char hash_name[1024];		    // Pathname as given by the client, echoed by HASH
 } transfer_params_t;
 
+/**
+ * @brief Sets the buffers in flight per file transfer.
+ *
+ * Buffered downloads read the file ahead on a helper thread and uploads
+ * write it behind the network, each through this many buffers of
+ * TRANSFER_BUFFER_SIZE. 1 keeps disk and network I/O in the transfer
+ * thread. Call before the first transfer.
+ *
+ * @param depth Buffers per transfer (IOPIPE_MIN_DEPTH to IOPIPE_MAX_DEPTH)
+ * @return 0 on success, -1 if the depth is out of range
+ */
+int transfer_set_pipeline_depth(int depth);
+
+/**
+ * @brief Sets when uploads are flushed to stable storage.
+ *
+ * @param durability Durability policy; TRANSFER_DURABILITY_CLOSE by default
+ */
+void transfer_set_durability(transfer_durability_t durability);
+
 /**
  * @brief Sends a file to the client through the data connection.
  *
- * Binary mode transmission.
+ * Binary mode transmission. Uses the platform's zero-copy file send
+ * (sendfile/TransmitFile) when available, except in TLS builds, and falls
+ * back to a buffered copy through a read-ahead pipeline otherwise.
  *
  * @param session The FTP session
  * @param filepath Absolute filesystem path to the file
@@ -84,9 +143,11 @@ transfer_status_t transfer_send_file(session_t *session, const char *filepath, l
  * @param session The FTP session
  * @param filepath Absolute filesystem path to save the file
  * @param offset Starting byte offset (for APPE/REST command support)
+ * @param size_hint Expected upload size to preallocate, 0 if unknown
  * @return transfer_status_t value indicating success or the failure reason
  */
-transfer_status_t transfer_receive_file(session_t *session, const char *filepath, long long offset);
+transfer_status_t transfer_receive_file(session_t *session, const char *filepath, long long offset,
+                                        long long size_hint);
 
 /**
  * @brief Sends a file to the client through the data connection
@@ -108,9 +169,11 @@ transfer_status_t transfer_send_file_ascii(session_t *session, const char *filep
  * @param session The FTP session
  * @param filepath Absolute filesystem path to save the file
  * @param offset Starting byte offset
+ * @param size_hint Expected upload size to preallocate, 0 if unknown
  * @return transfer_status_t value indicating success or the failure reason
  */
-transfer_status_t transfer_receive_file_ascii(session_t *session, const char *filepath, long long offset);
+transfer_status_t transfer_receive_file_ascii(session_t *session, const char *filepath, long long offset,
+                                              long long size_hint);
 
 /**
  * @brief Sends directory listing to the client (LIST command)
@@ -132,10 +195,38 @@ transfer_status_t transfer_send_list(session_t *session, const char *dirpath);
  */
 transfer_status_t transfer_send_nlst(session_t *session, const char *dirpath);
 
+/**
+ * @brief Sends a machine-readable directory listing (MLSD command)
+ *
+ * Entries carry the facts selected by OPTS MLST.
+ *
+ * @param session The FTP session
+ * @param dirpath Absolute filesystem path to the directory
+ * @return transfer_status_t indicating success or failure reason
+ */
+transfer_status_t transfer_send_mlsd(session_t *session, const char *dirpath);
+
+/**
+ * @brief Sends the reply of a checksum command
+ *
+ * HASH replies "213 <algorithm> <start>-<end> <hex> <name>", the X* commands
+ * "250 <hex>".
+ *
+ * @param session The FTP session
+ * @param algorithm Checksum algorithm
+ * @param hash_reply 1 for the HASH format, 0 for XCRC/XMD5/XSHA256
+ * @param offset First byte covered
+ * @param size End of the range: the file size, or one past the last byte of a RANG range
+ * @param name Pathname as given by the client
+ * @param hex The checksum
+ */
+void transfer_send_digest_reply(session_t *session, digest_algorithm_t algorithm, int hash_reply,
+                                long long offset, long long size, const char *name, const char *hex);
+
 /**
  * @brief Transfer thread function for async file transfers
  *
- * This function runs in a separate thread to perform file transfers
+ * This function runs on a transfer worker to perform file transfers
  * without blocking the main command processing thread.
  *
  * @param arg Pointer to session_t
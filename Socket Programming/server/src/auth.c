@@ -1,11 +1,20 @@
 /**
  * @file auth.c
  * @brief User authentication and authorization implementation
- * @version 0.1
+ * @version 0.2
  * @date 2025-11-03
+ *
+ * Users live in a chained hash table that is published through an
+ * RCU-style pointer. Readers never take a lock: they enter a read section
+ * (one atomic increment on an epoch counter), look the user up and leave.
+ * Writers are serialized by g_auth_lock; they either insert fully built
+ * entries in place or build a new table, swap the pointer and wait until
+ * every reader of the previous epoch has left before dropping the old one.
  */
 
 #include "auth.h"
+#include "atomics.h"
+#include "digest.h"
 #include "logger.h"
 #include "filesys.h"
 
@@ -13,6 +22,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
 #include <ctype.h>
 
 #ifdef _WIN32
@@ -21,32 +32,310 @@
 #include <unistd.h>
 #endif
 
+/**
+ * @brief User table
+ */
+typedef struct auth_table
+{
+    int refcount;           // One for being current, plus one per auth_get_user() reference
+    size_t bucket_mask;     // Bucket count - 1 (power of two)
+    auth_user_t **buckets;  // Chains, newest entry first
+    int user_count;         // Entries in the buckets (written by writers only)
+    auth_user_t *anonymous; // Virtual anonymous user (not in the buckets)
+} auth_table_t;
+
 static int g_initialized = 0;
 static int g_anonymous_enabled = 1; // Anonymous login enabled by default
-static auth_user_t g_users[AUTH_MAX_USERS];
-static pthread_mutex_t g_auth_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_auth_lock = PTHREAD_MUTEX_INITIALIZER; // Serializes writers
 
-// Virtual anonymous user with default configuration
-static auth_user_t g_virtual_anonymous = {
-    .username = "anonymous",
-    .password_hash = "",
-    .home_dir = "/pub",
-    .permissions = AUTH_PERM_READ,
-    .in_use = 1};
+static auth_table_t *g_table = NULL; // Current table (readers load it inside a read section)
+static unsigned int g_epoch = 0;     // Low bit selects the reader counter for new readers
+static int g_readers[2] = {0, 0};    // Readers inside a read section, per epoch parity
 
 // Forward declarations
 static void hash_password(const char *password, char *hash_output);
+static int is_legacy_hash(const char *hash);
 static int verify_password(const char *password, const char *hash);
-static auth_user_t *find_user(const char *username);
+
+/**
+ * @brief FNV-1a hash of a username
+ */
+static uint64_t auth_hash(const char *username)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)username; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Allocates a user entry; the strings are stored right after the struct.
+ */
+static auth_user_t *auth_user_new(const char *username, const char *password_hash,
+                                  const char *home_dir, auth_permission_t permissions)
+{
+    size_t username_len = strlen(username);
+    size_t home_dir_len = strlen(home_dir);
+    if (username_len >= AUTH_MAX_USERNAME || home_dir_len >= AUTH_MAX_HOME_DIR)
+        return NULL;
+
+    auth_user_t *user = (auth_user_t *)malloc(sizeof(auth_user_t) + username_len + home_dir_len + 2);
+    if (!user)
+        return NULL;
+
+    char *strings = (char *)(user + 1);
+    memcpy(strings, username, username_len + 1);
+    memcpy(strings + username_len + 1, home_dir, home_dir_len + 1);
+    user->username = strings;
+    user->home_dir = strings + username_len + 1;
+
+    strncpy(user->password_hash, password_hash, 64);
+    user->password_hash[64] = '\0';
+    user->permissions = permissions;
+    user->rate_limit = 0;
+    user->next = NULL;
+    user->table = NULL;
+    return user;
+}
+
+/**
+ * @brief Allocates an empty table with at least min_buckets buckets.
+ */
+static auth_table_t *auth_table_new(size_t min_buckets)
+{
+    size_t buckets = AUTH_INITIAL_BUCKETS;
+    while (buckets < min_buckets)
+        buckets <<= 1;
+
+    auth_table_t *table = (auth_table_t *)calloc(1, sizeof(auth_table_t));
+    if (!table)
+        return NULL;
+
+    table->buckets = (auth_user_t **)calloc(buckets, sizeof(auth_user_t *));
+    if (!table->buckets)
+    {
+        free(table);
+        return NULL;
+    }
+    table->bucket_mask = buckets - 1;
+    table->refcount = 1;
+    return table;
+}
+
+static void auth_table_free(auth_table_t *table)
+{
+    for (size_t i = 0; i <= table->bucket_mask; i++)
+    {
+        auth_user_t *user = table->buckets[i];
+        while (user)
+        {
+            auth_user_t *next = user->next;
+            free(user);
+            user = next;
+        }
+    }
+    free(table->anonymous);
+    free(table->buckets);
+    free(table);
+}
+
+/**
+ * @brief Drops a reference; the last one frees the table.
+ */
+static void auth_table_put(auth_table_t *table)
+{
+    if (table && ATOMIC_FETCH_SUB(&table->refcount, 1) == 1)
+        auth_table_free(table);
+}
+
+/**
+ * @brief Finds a user in a table. Safe against concurrent in-place inserts.
+ */
+static auth_user_t *auth_table_find(const auth_table_t *table, const char *username)
+{
+    auth_user_t *user = ATOMIC_LOAD_ACQUIRE(&table->buckets[auth_hash(username) & table->bucket_mask]);
+    while (user && strcmp(user->username, username) != 0)
+        user = ATOMIC_LOAD_ACQUIRE(&user->next);
+    return user;
+}
+
+/**
+ * @brief Links a fully built entry into a table; readers see it atomically.
+ */
+static void auth_table_insert(auth_table_t *table, auth_user_t *user)
+{
+    auth_user_t **bucket = &table->buckets[auth_hash(user->username) & table->bucket_mask];
+    user->table = table;
+    user->next = *bucket;
+    ATOMIC_STORE_RELEASE(bucket, user);
+    ATOMIC_FETCH_ADD_RELAXED(&table->user_count, 1);
+}
+
+/**
+ * @brief Sets the virtual anonymous user of a private (unpublished) table.
+ */
+static int auth_table_set_anonymous(auth_table_t *table, const char *home_dir, auth_permission_t permissions)
+{
+    auth_user_t *anonymous = auth_user_new("anonymous", "", home_dir, permissions);
+    if (!anonymous)
+        return -1;
+
+    anonymous->table = table;
+    free(table->anonymous);
+    table->anonymous = anonymous;
+    return 0;
+}
+
+/**
+ * @brief Copies a table's entries into a new private table.
+ *
+ * @param source The table to copy.
+ * @param min_buckets Minimum bucket count of the copy.
+ */
+static auth_table_t *auth_table_clone(const auth_table_t *source, size_t min_buckets)
+{
+    auth_table_t *table = auth_table_new(min_buckets);
+    if (!table)
+        return NULL;
+
+    if (source->anonymous &&
+        auth_table_set_anonymous(table, source->anonymous->home_dir, source->anonymous->permissions) != 0)
+    {
+        auth_table_free(table);
+        return NULL;
+    }
+
+    for (size_t i = 0; i <= source->bucket_mask; i++)
+    {
+        for (const auth_user_t *user = source->buckets[i]; user; user = user->next)
+        {
+            auth_user_t *copy = auth_user_new(user->username, user->password_hash,
+                                              user->home_dir, user->permissions);
+            if (!copy)
+            {
+                auth_table_free(table);
+                return NULL;
+            }
+            copy->rate_limit = user->rate_limit;
+            auth_table_insert(table, copy);
+        }
+    }
+
+    return table;
+}
+
+/**
+ * @brief Doubles the buckets of a private (unpublished) table, relinking its entries.
+ */
+static int auth_table_grow_private(auth_table_t *table)
+{
+    size_t buckets = (table->bucket_mask + 1) * 2;
+    auth_user_t **chains = (auth_user_t **)calloc(buckets, sizeof(auth_user_t *));
+    if (!chains)
+        return -1;
+
+    for (size_t i = 0; i <= table->bucket_mask; i++)
+    {
+        auth_user_t *user = table->buckets[i];
+        while (user)
+        {
+            auth_user_t *next = user->next;
+            size_t slot = auth_hash(user->username) & (buckets - 1);
+            user->next = chains[slot];
+            chains[slot] = user;
+            user = next;
+        }
+    }
+
+    free(table->buckets);
+    table->buckets = chains;
+    table->bucket_mask = buckets - 1;
+    return 0;
+}
+
+/**
+ * @brief Enters a read section.
+ *
+ * @return Token for auth_read_unlock().
+ */
+static int auth_read_lock(void)
+{
+    for (;;)
+    {
+        unsigned int epoch = ATOMIC_LOAD(&g_epoch) & 1;
+        ATOMIC_FETCH_ADD(&g_readers[epoch], 1);
+
+        // A writer flipped the epoch in between: we might be waited for on the wrong counter
+        if ((ATOMIC_LOAD(&g_epoch) & 1) == epoch)
+            return (int)epoch;
+
+        ATOMIC_FETCH_SUB(&g_readers[epoch], 1);
+    }
+}
+
+static void auth_read_unlock(int token)
+{
+    ATOMIC_FETCH_SUB(&g_readers[token], 1);
+}
+
+/**
+ * @brief Publishes a table and drops the previous one once no reader can see it.
+ *
+ * Must be called with g_auth_lock held.
+ */
+static void auth_publish(auth_table_t *table)
+{
+    auth_table_t *old = ATOMIC_LOAD(&g_table);
+    ATOMIC_STORE(&g_table, table);
+
+    // Readers that entered before the flip may still hold old
+    unsigned int epoch = ATOMIC_FETCH_ADD(&g_epoch, 1) & 1;
+    while (ATOMIC_LOAD(&g_readers[epoch]) != 0)
+        sched_yield();
+
+    auth_table_put(old);
+}
+
+/**
+ * @brief Takes a reference to the current table.
+ *
+ * @return The table (release with auth_table_put()), or NULL if not initialized.
+ */
+static auth_table_t *auth_table_acquire(void)
+{
+    int token = auth_read_lock();
+    auth_table_t *table = ATOMIC_LOAD(&g_table);
+    if (table)
+        ATOMIC_FETCH_ADD(&table->refcount, 1);
+    auth_read_unlock(token);
+    return table;
+}
 
 int auth_init(void)
 {
+    pthread_mutex_lock(&g_auth_lock);
+
     if (g_initialized)
+    {
+        pthread_mutex_unlock(&g_auth_lock);
         return 0;
+    }
 
-    pthread_mutex_lock(&g_auth_lock);
-    memset(g_users, 0, sizeof(g_users));
-    g_initialized = 1;
+    auth_table_t *table = auth_table_new(0);
+    if (!table || auth_table_set_anonymous(table, "/pub", AUTH_PERM_READ) != 0)
+    {
+        if (table)
+            auth_table_free(table);
+        pthread_mutex_unlock(&g_auth_lock);
+        LOG_ERROR("Failed to allocate user table");
+        return -1;
+    }
+
+    auth_publish(table);
+    ATOMIC_STORE(&g_initialized, 1);
     pthread_mutex_unlock(&g_auth_lock);
     LOG_INFO("Authentication module initialized");
     return 0;
@@ -54,31 +343,29 @@ int auth_init(void)
 
 void auth_cleanup(void)
 {
+    pthread_mutex_lock(&g_auth_lock);
+
     if (!g_initialized)
+    {
+        pthread_mutex_unlock(&g_auth_lock);
         return;
+    }
 
-    pthread_mutex_lock(&g_auth_lock);
-    memset(g_users, 0, sizeof(g_users));
-    g_initialized = 0;
+    ATOMIC_STORE(&g_initialized, 0);
+    auth_publish(NULL);
     pthread_mutex_unlock(&g_auth_lock);
     LOG_INFO("Authentication module cleaned up");
 }
 
 void auth_set_anonymous_enabled(int enable)
 {
-    pthread_mutex_lock(&g_auth_lock);
-    g_anonymous_enabled = enable ? 1 : 0;
-    pthread_mutex_unlock(&g_auth_lock);
-    LOG_INFO("Anonymous login %s", g_anonymous_enabled ? "enabled" : "disabled");
+    ATOMIC_STORE(&g_anonymous_enabled, enable ? 1 : 0);
+    LOG_INFO("Anonymous login %s", enable ? "enabled" : "disabled");
 }
 
 int auth_is_anonymous_enabled(void)
 {
-    int enabled;
-    pthread_mutex_lock(&g_auth_lock);
-    enabled = g_anonymous_enabled;
-    pthread_mutex_unlock(&g_auth_lock);
-    return enabled;
+    return ATOMIC_LOAD(&g_anonymous_enabled);
 }
 
 int auth_set_anonymous_defaults(const char *home_dir, auth_permission_t permissions)
@@ -87,9 +374,26 @@ int auth_set_anonymous_defaults(const char *home_dir, auth_permission_t permissi
         return -1;
 
     pthread_mutex_lock(&g_auth_lock);
-    strncpy(g_virtual_anonymous.home_dir, home_dir, AUTH_MAX_HOME_DIR - 1);
-    g_virtual_anonymous.home_dir[AUTH_MAX_HOME_DIR - 1] = '\0';
-    g_virtual_anonymous.permissions = permissions;
+
+    auth_table_t *current = g_table;
+    if (!current)
+    {
+        pthread_mutex_unlock(&g_auth_lock);
+        return -1;
+    }
+
+    // Published entries are immutable, so the change goes into a copy
+    auth_table_t *table = auth_table_clone(current, current->bucket_mask + 1);
+    if (!table || auth_table_set_anonymous(table, home_dir, permissions) != 0)
+    {
+        if (table)
+            auth_table_free(table);
+        pthread_mutex_unlock(&g_auth_lock);
+        LOG_ERROR("Failed to update anonymous defaults");
+        return -1;
+    }
+
+    auth_publish(table);
     pthread_mutex_unlock(&g_auth_lock);
 
     LOG_INFO("Anonymous defaults set: home='%s', permissions=0x%02X", home_dir, permissions);
@@ -98,27 +402,34 @@ int auth_set_anonymous_defaults(const char *home_dir, auth_permission_t permissi
 
 int auth_load_users(const char *filename)
 {
-    if (!g_initialized)
+    if (!ATOMIC_LOAD(&g_initialized))
         return -1;
 
     if (!filename)
         return -1;
 
-    pthread_mutex_lock(&g_auth_lock);
-
     FILE *fp = fopen(filename, "r");
     if (!fp)
     {
-        pthread_mutex_unlock(&g_auth_lock);
         LOG_WARN("Could not open user database file: %s", filename);
         return -1;
     }
 
+    // Parsed into a private table, logins keep using the current one meanwhile
+    auth_table_t *table = auth_table_new(0);
+    if (!table)
+    {
+        fclose(fp);
+        LOG_ERROR("Failed to allocate user table");
+        return -1;
+    }
+
     char line[2048];
     int count = 0;
     int line_num = 0;
+    int failed = 0;
 
-    while (fgets(line, sizeof(line), fp) && count < AUTH_MAX_USERS)
+    while (fgets(line, sizeof(line), fp))
     {
         line_num++;
 
@@ -126,14 +437,15 @@ int auth_load_users(const char *filename)
         if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
             continue;
 
-        // Parse line: username:password_hash:home_dir:permissions
+        // Parse line: username:password_hash:home_dir:permissions[:rate_limit]
         char username[AUTH_MAX_USERNAME];
         char password_hash[65];
         char home_dir[AUTH_MAX_HOME_DIR];
         unsigned int permissions;
+        unsigned long long rate_limit = 0;
 
-        int parsed = sscanf(line, "%255[^:]:%64[^:]:%1023[^:]:%u",
-                            username, password_hash, home_dir, &permissions);
+        int parsed = sscanf(line, "%255[^:]:%64[^:]:%1023[^:]:%u:%llu",
+                            username, password_hash, home_dir, &permissions, &rate_limit);
 
         if (parsed < 4)
         {
@@ -141,40 +453,52 @@ int auth_load_users(const char *filename)
             continue;
         }
 
-        // Find free slot
-        int slot = -1;
-        for (int i = 0; i < AUTH_MAX_USERS; i++)
+        if (auth_table_find(table, username))
         {
-            if (!g_users[i].in_use)
-            {
-                slot = i;
-                break;
-            }
+            LOG_WARN("Duplicate user '%s' on line %d in user database, skipped", username, line_num);
+            continue;
         }
 
-        if (slot == -1)
+        // Keep the load factor at or below one
+        if ((size_t)table->user_count >= table->bucket_mask + 1 && auth_table_grow_private(table) != 0)
         {
-            LOG_WARN("User database full, skipping remaining entries");
+            failed = 1;
             break;
         }
 
-        // Populate user entry
-        strncpy(g_users[slot].username, username, AUTH_MAX_USERNAME - 1);
-        g_users[slot].username[AUTH_MAX_USERNAME - 1] = '\0';
-
-        strncpy(g_users[slot].password_hash, password_hash, 64);
-        g_users[slot].password_hash[64] = '\0';
-
-        strncpy(g_users[slot].home_dir, home_dir, AUTH_MAX_HOME_DIR - 1);
-        g_users[slot].home_dir[AUTH_MAX_HOME_DIR - 1] = '\0';
+        if (is_legacy_hash(password_hash))
+        {
+            LOG_WARN("User '%s' on line %d has an old-style password hash, replace it with the SHA-256 of the password",
+                     username, line_num);
+        }
 
-        g_users[slot].permissions = (auth_permission_t)permissions;
-        g_users[slot].in_use = 1;
+        auth_user_t *user = auth_user_new(username, password_hash, home_dir, (auth_permission_t)permissions);
+        if (!user)
+        {
+            failed = 1;
+            break;
+        }
+        user->rate_limit = rate_limit;
+        auth_table_insert(table, user);
 
         count++;
     }
 
     fclose(fp);
+
+    pthread_mutex_lock(&g_auth_lock);
+
+    auth_table_t *current = g_table;
+    if (failed || !current ||
+        auth_table_set_anonymous(table, current->anonymous->home_dir, current->anonymous->permissions) != 0)
+    {
+        pthread_mutex_unlock(&g_auth_lock);
+        auth_table_free(table);
+        LOG_ERROR("Failed to load user database: %s", filename);
+        return -1;
+    }
+
+    auth_publish(table);
     pthread_mutex_unlock(&g_auth_lock);
 
     LOG_INFO("Loaded %d users from %s", count, filename);
@@ -183,24 +507,27 @@ int auth_load_users(const char *filename)
 
 int auth_save_users(const char *filename)
 {
-    if (!g_initialized)
+    if (!ATOMIC_LOAD(&g_initialized))
         return -1;
 
     if (!filename)
         return -1;
 
-    pthread_mutex_lock(&g_auth_lock);
+    // Pin the current table; writing the file does not hold up reloads
+    auth_table_t *table = auth_table_acquire();
+    if (!table)
+        return -1;
 
     FILE *fp = fopen(filename, "w");
     if (!fp)
     {
-        pthread_mutex_unlock(&g_auth_lock);
+        auth_table_put(table);
         LOG_ERROR("Failed to open user database file for writing: %s", filename);
         return -1;
     }
 
     fprintf(fp, "# FTP User Database\n");
-    fprintf(fp, "# Format: username:password_hash:home_dir:permissions\n");
+    fprintf(fp, "# Format: username:password_hash:home_dir:permissions[:rate_limit]\n");
     fprintf(fp, "# home_dir should be relative to root_dir and start with /\n");
     fprintf(fp, "# permissions are hex values (bitwise OR of permission flags):\n");
     fprintf(fp, "#   0x01 = READ      - Read files and list directories\n");
@@ -211,32 +538,38 @@ int auth_save_users(const char *filename)
     fprintf(fp, "#   0x20 = RMDIR     - Remove directories\n");
     fprintf(fp, "#   0x40 = ADMIN     - Administrative operations\n");
     fprintf(fp, "#   0xFF = ALL       - All permissions\n");
+    fprintf(fp, "# rate_limit is optional: bytes per second shared by all sessions of the user\n");
     fprintf(fp, "#\n");
     fprintf(fp, "# Example entries:\n");
     fprintf(fp, "#   admin:0000000000000000000000000000000000000000000000000000000000001234:/admin:255\n");
     fprintf(fp, "#   user1:0000000000000000000000000000000000000000000000000000000000005678:/users/user1:3\n");
     fprintf(fp, "#   readonly:0000000000000000000000000000000000000000000000000000000000004321:/pub:1\n");
+    fprintf(fp, "#   mirror:0000000000000000000000000000000000000000000000000000000000008765:/pub:1:1048576\n");
     fprintf(fp, "#\n");
     fprintf(fp, "# Anonymous user can be defined here or will use default settings (/pub, READ only)\n");
     fprintf(fp, "# anonymous::/pub:1\n\n");
 
     int count = 0;
-    for (int i = 0; i < AUTH_MAX_USERS; i++)
+    for (size_t i = 0; i <= table->bucket_mask; i++)
     {
-        if (!g_users[i].in_use)
-            continue;
-
-        fprintf(fp, "%s:%s:%s:%u\n",
-                g_users[i].username,
-                g_users[i].password_hash,
-                g_users[i].home_dir,
-                (unsigned int)g_users[i].permissions);
-
-        count++;
+        for (const auth_user_t *user = ATOMIC_LOAD_ACQUIRE(&table->buckets[i]); user;
+             user = ATOMIC_LOAD_ACQUIRE(&user->next))
+        {
+            fprintf(fp, "%s:%s:%s:%u",
+                    user->username,
+                    user->password_hash,
+                    user->home_dir,
+                    (unsigned int)user->permissions);
+            if (user->rate_limit > 0)
+                fprintf(fp, ":%llu", user->rate_limit);
+            fputc('\n', fp);
+
+            count++;
+        }
     }
 
     fclose(fp);
-    pthread_mutex_unlock(&g_auth_lock);
+    auth_table_put(table);
 
     LOG_INFO("Saved %d users to %s", count, filename);
     return 0;
@@ -244,69 +577,68 @@ int auth_save_users(const char *filename)
 
 int auth_authenticate(const char *username, const char *password)
 {
-    if (!g_initialized)
-        return 0;
-
     if (!username || !password)
         return 0;
 
-    pthread_mutex_lock(&g_auth_lock);
+    int token = auth_read_lock();
+    auth_table_t *table = ATOMIC_LOAD(&g_table);
+    if (!table)
+    {
+        auth_read_unlock(token);
+        return 0;
+    }
 
     // Check for anonymous user with anonymous login enabled
-    if (g_anonymous_enabled && strcmp(username, "anonymous") == 0)
+    if (ATOMIC_LOAD(&g_anonymous_enabled) && strcmp(username, "anonymous") == 0)
     {
         // Anonymous user can log in with any password
         // Check if anonymous user exists in database (optional)
-        auth_user_t *user = find_user(username);
-        if (user)
+        int in_database = auth_table_find(table, username) != NULL;
+        auth_read_unlock(token);
+        if (in_database)
         {
-            pthread_mutex_unlock(&g_auth_lock);
             LOG_INFO("Anonymous user authenticated using database configuration");
-            return 1;
         }
         else
         {
             // Use virtual anonymous user with default settings
-            pthread_mutex_unlock(&g_auth_lock);
             LOG_INFO("Anonymous user authenticated using default virtual configuration");
-            return 1;
         }
+        return 1;
     }
 
     // Regular user authentication
-    auth_user_t *user = find_user(username);
+    auth_user_t *user = auth_table_find(table, username);
     if (!user)
     {
-        pthread_mutex_unlock(&g_auth_lock);
+        auth_read_unlock(token);
         LOG_WARN("Authentication failed: user '%s' not found", username);
         return 0;
     }
 
     // Verify password
-    if (!verify_password(password, user->password_hash))
+    int verified = verify_password(password, user->password_hash);
+    auth_read_unlock(token);
+
+    if (!verified)
     {
-        pthread_mutex_unlock(&g_auth_lock);
         LOG_WARN("Authentication failed: invalid password for user '%s'", username);
         return 0;
     }
 
-    pthread_mutex_unlock(&g_auth_lock);
     LOG_INFO("User '%s' authenticated successfully", username);
     return 1;
 }
 
 int auth_user_exists(const char *username)
 {
-    if (!g_initialized)
-        return 0;
-
     if (!username)
         return 0;
 
-    pthread_mutex_lock(&g_auth_lock);
-    auth_user_t *user = find_user(username);
-    int exists = (user != NULL);
-    pthread_mutex_unlock(&g_auth_lock);
+    int token = auth_read_lock();
+    auth_table_t *table = ATOMIC_LOAD(&g_table);
+    int exists = table && auth_table_find(table, username) != NULL;
+    auth_read_unlock(token);
 
     return exists;
 }
@@ -316,52 +648,57 @@ int auth_add_user(const char *username,
                   const char *home_dir,
                   auth_permission_t permissions)
 {
-    if (!g_initialized)
+    if (!username || !password || !home_dir)
         return -1;
 
-    if (!username || !password || !home_dir)
+    char password_hash[65];
+    hash_password(password, password_hash);
+
+    auth_user_t *user = auth_user_new(username, password_hash, home_dir, permissions);
+    if (!user)
+    {
+        LOG_ERROR("Failed to create user '%s'", username);
         return -1;
+    }
 
     pthread_mutex_lock(&g_auth_lock);
 
+    auth_table_t *table = g_table;
+    if (!table)
+    {
+        pthread_mutex_unlock(&g_auth_lock);
+        free(user);
+        return -1;
+    }
+
     // Check if user already exists
-    if (find_user(username) != NULL)
+    if (auth_table_find(table, username) != NULL)
     {
         pthread_mutex_unlock(&g_auth_lock);
+        free(user);
         LOG_WARN("User '%s' already exists", username);
         return -1;
     }
 
-    // Find free slot
-    int slot = -1;
-    for (int i = 0; i < AUTH_MAX_USERS; i++)
+    if ((size_t)table->user_count >= table->bucket_mask + 1)
     {
-        if (!g_users[i].in_use)
+        // Grow into a copy with twice the buckets; published chains are never rehashed in place
+        auth_table_t *grown = auth_table_clone(table, (table->bucket_mask + 1) * 2);
+        if (!grown)
         {
-            slot = i;
-            break;
+            pthread_mutex_unlock(&g_auth_lock);
+            free(user);
+            LOG_ERROR("Failed to grow user table");
+            return -1;
         }
+        auth_table_insert(grown, user);
+        auth_publish(grown);
     }
-
-    if (slot == -1)
+    else
     {
-        pthread_mutex_unlock(&g_auth_lock);
-        LOG_ERROR("User database is full");
-        return -1;
+        auth_table_insert(table, user);
     }
 
-    // Create user
-    strncpy(g_users[slot].username, username, AUTH_MAX_USERNAME - 1);
-    g_users[slot].username[AUTH_MAX_USERNAME - 1] = '\0';
-
-    hash_password(password, g_users[slot].password_hash);
-
-    strncpy(g_users[slot].home_dir, home_dir, AUTH_MAX_HOME_DIR - 1);
-    g_users[slot].home_dir[AUTH_MAX_HOME_DIR - 1] = '\0';
-
-    g_users[slot].permissions = permissions;
-    g_users[slot].in_use = 1;
-
     pthread_mutex_unlock(&g_auth_lock);
 
     LOG_INFO("User '%s' added successfully", username);
@@ -370,52 +707,63 @@ int auth_add_user(const char *username,
 
 const auth_user_t *auth_get_user(const char *username)
 {
-    if (!g_initialized)
-        return NULL;
-
     if (!username)
         return NULL;
 
-    pthread_mutex_lock(&g_auth_lock);
-
-    // Check database first
-    auth_user_t *user = find_user(username);
+    int token = auth_read_lock();
+    auth_table_t *table = ATOMIC_LOAD(&g_table);
+    auth_user_t *user = NULL;
 
-    // If not found and it's anonymous with anonymous login enabled,
-    // return virtual anonymous user
-    if (!user && g_anonymous_enabled && strcmp(username, "anonymous") == 0)
+    if (table)
     {
-        pthread_mutex_unlock(&g_auth_lock);
-        return &g_virtual_anonymous;
+        // Check database first
+        user = auth_table_find(table, username);
+
+        // If not found and it's anonymous with anonymous login enabled,
+        // return virtual anonymous user
+        if (!user && ATOMIC_LOAD(&g_anonymous_enabled) && strcmp(username, "anonymous") == 0)
+            user = table->anonymous;
+
+        // Keeps the table alive after the read section until auth_user_release()
+        if (user)
+            ATOMIC_FETCH_ADD(&table->refcount, 1);
     }
 
-    pthread_mutex_unlock(&g_auth_lock);
+    auth_read_unlock(token);
     return user;
 }
 
-int auth_has_permission(const char *username, auth_permission_t permission)
+void auth_user_release(const auth_user_t *user)
 {
-    if (!g_initialized)
-        return 0;
+    if (user)
+        auth_table_put(user->table);
+}
 
+int auth_get_user_count(void)
+{
+    int token = auth_read_lock();
+    auth_table_t *table = ATOMIC_LOAD(&g_table);
+    int count = table ? ATOMIC_LOAD(&table->user_count) : 0;
+    auth_read_unlock(token);
+
+    return count;
+}
+
+int auth_has_permission(const char *username, auth_permission_t permission)
+{
     if (!username)
         return 0;
 
-    pthread_mutex_lock(&g_auth_lock);
-    auth_user_t *user = find_user(username);
+    int token = auth_read_lock();
+    auth_table_t *table = ATOMIC_LOAD(&g_table);
+    auth_user_t *user = table ? auth_table_find(table, username) : NULL;
 
     // Check for virtual anonymous user
-    if (!user && g_anonymous_enabled && strcmp(username, "anonymous") == 0)
-        user = &g_virtual_anonymous;
-
-    if (!user)
-    {
-        pthread_mutex_unlock(&g_auth_lock);
-        return 0;
-    }
+    if (table && !user && ATOMIC_LOAD(&g_anonymous_enabled) && strcmp(username, "anonymous") == 0)
+        user = table->anonymous;
 
-    int has_perm = (user->permissions & permission) == permission;
-    pthread_mutex_unlock(&g_auth_lock);
+    int has_perm = user && (user->permissions & permission) == permission;
+    auth_read_unlock(token);
 
     return has_perm;
 }
@@ -433,33 +781,44 @@ static void hash_password(const char *password, char *hash_output)
         return;
     }
 
-    // Simple hash for demonstration (Really simple, should be modified later)
-    unsigned int simple_hash = 0;
-    for (const char *p = password; *p; p++)
+    // Unsalted SHA-256 as lowercase hex, e.g. from `printf %s password | sha256sum`
+    digest_hex(DIGEST_SHA256, password, strlen(password), hash_output);
+}
+
+/**
+ * @brief Checks for a hash written by the original 32-bit string hash.
+ *
+ * Those are zero-padded to 64 hex digits, which a SHA-256 practically never is.
+ */
+static int is_legacy_hash(const char *hash)
+{
+    if (strlen(hash) != 64)
+        return 0;
+
+    for (int i = 0; i < 56; i++)
     {
-        simple_hash = simple_hash * 31 + (unsigned char)*p;
+        if (hash[i] != '0')
+            return 0;
     }
-    snprintf(hash_output, 65, "%064x", simple_hash);
+    return 1;
 }
 
 static int verify_password(const char *password, const char *hash)
 {
     char computed_hash[65];
-    hash_password(password, computed_hash);
-    return (strcmp(computed_hash, hash) == 0);
-}
 
-/// @brief  Finds a user by username in g_users
-/// @param username The username to search for.
-/// @return A pointer to the user structure if found, or NULL otherwise.
-static auth_user_t *find_user(const char *username)
-{
-    for (int i = 0; i < AUTH_MAX_USERS; i++)
+    // User databases written before SHA-256 keep working until they are updated
+    if (password && is_legacy_hash(hash))
     {
-        if (g_users[i].in_use && strcmp(g_users[i].username, username) == 0)
+        unsigned int simple_hash = 0;
+        for (const char *p = password; *p; p++)
         {
-            return &g_users[i];
+            simple_hash = simple_hash * 31 + (unsigned char)*p;
         }
+        snprintf(computed_hash, sizeof(computed_hash), "%064x", simple_hash);
+        return (strcmp(computed_hash, hash) == 0);
     }
-    return NULL;
-}
\ No newline at end of file
+
+    hash_password(password, computed_hash);
+    return (strcmp(computed_hash, hash) == 0);
+}
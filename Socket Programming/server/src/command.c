@@ -7,20 +7,34 @@
  */
 #include "command.h"
 #include "logger.h"
+#include "metrics.h"
 #include "utils.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Perfect hash index over the handler slots, 4 entries per slot keep collision-free seeds easy to find
+#define CMD_HASH_BITS 8
+#define CMD_HASH_SIZE (1 << CMD_HASH_BITS)
+
+// Multiplier without collisions among the standard verbs; registrations that collide search for another
+#define CMD_DEFAULT_SEED 0x80AD2251u
+
+// Multipliers tried before a registration is given up
+#define CMD_SEED_ATTEMPTS 100000
+
 /**
  * @brief Structure representing a registered command handler.
  */
 typedef struct
 {
     char command[PROTO_MAX_CMD_NAME];
+    uint32_t key;  // Packed name, see cmd_key()
+    int long_name; // 1 if the name has more than 4 characters and the key does not identify it alone
     cmd_handler_t handler;
-    cmd_handler_t prev_handler;
-    int in_use; //
+    unsigned flags; // CMD_NEED_* and CMD_CLEAR_* flags
+    int in_use;
 } cmd_handler_entry_t;
 
 /**
@@ -28,11 +42,134 @@ typedef struct
  */
 static cmd_handler_entry_t g_handlers[CMD_MAX_HANDLERS];
 
+/**
+ * @brief Hash index: slot + 1 of the handler whose key hashes there, 0 for none.
+ */
+static unsigned char g_index[CMD_HASH_SIZE];
+
+/**
+ * @brief Multiplier of the hash function that keeps g_index collision-free.
+ */
+static uint32_t g_seed = CMD_DEFAULT_SEED;
+
+/**
+ * @brief Callbacks behind the command flags, NULL to ignore the flags.
+ */
+static const cmd_context_ops_t *g_ops = NULL;
+
 /**
  * @brief Flag indicating whether the module has been initialized.
  */
 static int g_initialized = 0;
 
+/**
+ * @brief Packs an uppercase command name into its key.
+ *
+ * Names of up to 4 characters are stored byte by byte, so the key is the
+ * name. Longer ones (XSHA256) fold the rest in and are confirmed by name.
+ *
+ * @param name The command name
+ * @param long_name Receives 1 if the name is longer than 4 characters
+ * @return The key
+ */
+static uint32_t cmd_key(const char *name, int *long_name)
+{
+    uint32_t key = 0;
+    size_t i = 0;
+    for (; i < 4 && name[i]; i++)
+        key |= (uint32_t)(unsigned char)name[i] << (8 * i);
+
+    *long_name = name[i] != '\0';
+    for (; name[i]; i++)
+        key = ((key << 5) | (key >> 27)) ^ (unsigned char)name[i];
+    return key;
+}
+
+static unsigned cmd_hash(uint32_t key, uint32_t seed)
+{
+    return (unsigned)((key * seed) >> (32 - CMD_HASH_BITS));
+}
+
+/**
+ * @brief Builds the index for a multiplier.
+ *
+ * @return 0 on success, -1 if two registered commands hash to the same entry
+ */
+static int cmd_index_build(uint32_t seed)
+{
+    unsigned char index[CMD_HASH_SIZE];
+    memset(index, 0, sizeof(index));
+
+    for (int i = 0; i < CMD_MAX_HANDLERS; i++)
+    {
+        if (!g_handlers[i].in_use)
+            continue;
+        unsigned h = cmd_hash(g_handlers[i].key, seed);
+        if (index[h])
+            return -1;
+        index[h] = (unsigned char)(i + 1);
+    }
+
+    memcpy(g_index, index, sizeof(index));
+    g_seed = seed;
+    return 0;
+}
+
+/**
+ * @brief Finds a multiplier that hashes all registered commands without collisions.
+ *
+ * Candidates follow a fixed sequence, so a set of commands always gets the same layout.
+ *
+ * @return 0 on success, -1 if none was found
+ */
+static int cmd_index_rehash(void)
+{
+    uint32_t candidate = CMD_DEFAULT_SEED;
+    if (cmd_index_build(candidate) == 0)
+        return 0;
+
+    for (int attempt = 0; attempt < CMD_SEED_ATTEMPTS; attempt++)
+    {
+        candidate = candidate * 1664525u + 1013904223u;
+        if (cmd_index_build(candidate | 1u) == 0)
+        {
+            LOG_DEBUG("Command hash multiplier 0x%08x after %d attempts", (unsigned)(candidate | 1u), attempt + 1);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Finds the handler of an uppercase command name: one probe, no chains.
+ *
+ * @return The entry, or NULL if the command is not registered
+ */
+static cmd_handler_entry_t *cmd_lookup(const char *name)
+{
+    int long_name;
+    uint32_t key = cmd_key(name, &long_name);
+    unsigned char slot = g_index[cmd_hash(key, g_seed)];
+    if (slot == 0)
+        return NULL;
+
+    cmd_handler_entry_t *entry = &g_handlers[slot - 1];
+    if (entry->key != key || entry->long_name != long_name ||
+        (long_name && strcmp(entry->command, name) != 0))
+        return NULL;
+    return entry;
+}
+
+/**
+ * @brief Copies a command name in uppercase.
+ */
+static void cmd_upper_name(char *upper, const char *command)
+{
+    strncpy(upper, command, PROTO_MAX_CMD_NAME - 1);
+    upper[PROTO_MAX_CMD_NAME - 1] = '\0';
+    to_uppercase(upper);
+}
+
 int cmd_init(void)
 {
     if (g_initialized)
@@ -40,6 +177,8 @@ int cmd_init(void)
 
     // Clear handler table
     memset(g_handlers, 0, sizeof(g_handlers));
+    memset(g_index, 0, sizeof(g_index));
+    g_seed = CMD_DEFAULT_SEED;
 
     g_initialized = 1;
     return 0;
@@ -52,52 +191,85 @@ void cmd_cleanup(void)
 
     // Clear all handlers
     memset(g_handlers, 0, sizeof(g_handlers));
+    memset(g_index, 0, sizeof(g_index));
+    g_ops = NULL;
 
     g_initialized = 0;
 }
 
-int cmd_register_handler(const char *command, cmd_handler_t handler, cmd_handler_t prev_handler)
+void cmd_set_context_ops(const cmd_context_ops_t *ops)
+{
+    g_ops = ops;
+}
+
+int cmd_register_handler(const char *command, cmd_handler_t handler, unsigned flags)
 {
     if (!g_initialized)
         return -1;
 
-    if (!command || !handler)
+    if (!command || !command[0] || !handler)
         return -1;
 
     // Convert command to uppercase for comparison
     char cmd_upper[PROTO_MAX_CMD_NAME];
-    strncpy(cmd_upper, command, PROTO_MAX_CMD_NAME - 1);
-    cmd_upper[PROTO_MAX_CMD_NAME - 1] = '\0';
-    to_uppercase(cmd_upper);
+    cmd_upper_name(cmd_upper, command);
 
     // Check if command is already registered
-    for (int i = 0; i < CMD_MAX_HANDLERS; i++)
+    cmd_handler_entry_t *existing = cmd_lookup(cmd_upper);
+    if (existing)
     {
-        if (g_handlers[i].in_use && strcmp(g_handlers[i].command, cmd_upper) == 0)
-        {
-            // Update existing handler
-            g_handlers[i].handler = handler;
-            g_handlers[i].prev_handler = prev_handler;
-            return 0;
-        }
+        // Update existing handler
+        existing->handler = handler;
+        existing->flags = flags;
+        return 0;
     }
 
-    // Find empty slot
+    int long_name;
+    uint32_t key = cmd_key(cmd_upper, &long_name);
+    int slot = -1;
     for (int i = 0; i < CMD_MAX_HANDLERS; i++)
     {
         if (!g_handlers[i].in_use)
         {
-            strncpy(g_handlers[i].command, cmd_upper, PROTO_MAX_CMD_NAME - 1);
-            g_handlers[i].command[PROTO_MAX_CMD_NAME - 1] = '\0';
-            g_handlers[i].handler = handler;
-            g_handlers[i].prev_handler = prev_handler;
-            g_handlers[i].in_use = 1;
-            return 0;
+            if (slot < 0)
+                slot = i;
+        }
+        else if (g_handlers[i].key == key)
+        {
+            // Only long names can share a key, and no multiplier separates them
+            LOG_ERROR("Command %s has the same hash key as %s", cmd_upper, g_handlers[i].command);
+            return -1;
         }
     }
 
     // No space available
-    return -1;
+    if (slot < 0)
+        return -1;
+
+    cmd_handler_entry_t *entry = &g_handlers[slot];
+    strncpy(entry->command, cmd_upper, PROTO_MAX_CMD_NAME - 1);
+    entry->command[PROTO_MAX_CMD_NAME - 1] = '\0';
+    entry->key = key;
+    entry->long_name = long_name;
+    entry->handler = handler;
+    entry->flags = flags;
+    entry->in_use = 1;
+
+    // A free index entry keeps the current multiplier, a collision needs a new one
+    unsigned h = cmd_hash(key, g_seed);
+    if (g_index[h] == 0)
+    {
+        g_index[h] = (unsigned char)(slot + 1);
+        return 0;
+    }
+    if (cmd_index_rehash() != 0)
+    {
+        LOG_ERROR("No collision-free command hash with %s", cmd_upper);
+        memset(entry, 0, sizeof(*entry));
+        cmd_index_build(g_seed);
+        return -1;
+    }
+    return 0;
 }
 
 int cmd_unregister_handler(const char *command)
@@ -110,24 +282,16 @@ int cmd_unregister_handler(const char *command)
 
     // Convert command to uppercase for comparison
     char cmd_upper[PROTO_MAX_CMD_NAME];
-    strncpy(cmd_upper, command, PROTO_MAX_CMD_NAME - 1);
-    cmd_upper[PROTO_MAX_CMD_NAME - 1] = '\0';
-    to_uppercase(cmd_upper);
+    cmd_upper_name(cmd_upper, command);
 
-    // Find and remove handler
-    for (int i = 0; i < CMD_MAX_HANDLERS; i++)
-    {
-        if (g_handlers[i].in_use && strcmp(g_handlers[i].command, cmd_upper) == 0)
-        {
-            g_handlers[i].in_use = 0;
-            g_handlers[i].handler = NULL;
-            g_handlers[i].prev_handler = NULL;
-            memset(g_handlers[i].command, 0, PROTO_MAX_CMD_NAME);
-            return 0;
-        }
-    }
+    // Find and remove handler, the other commands keep their index entries
+    cmd_handler_entry_t *entry = cmd_lookup(cmd_upper);
+    if (!entry)
+        return -1;
 
-    return -1;
+    g_index[cmd_hash(entry->key, g_seed)] = 0;
+    memset(entry, 0, sizeof(*entry));
+    return 0;
 }
 
 int cmd_dispatch(cmd_handler_context_t context, const proto_command_t *cmd)
@@ -141,24 +305,29 @@ int cmd_dispatch(cmd_handler_context_t context, const proto_command_t *cmd)
     LOG_DEBUG("Dispatching command: %s", cmd->command);
 
     // Find matching handler
-    for (int i = 0; i < CMD_MAX_HANDLERS; i++)
+    cmd_handler_entry_t *entry = cmd_lookup(cmd->command);
+    if (!entry)
     {
-        if (g_handlers[i].in_use && strcmp(g_handlers[i].command, cmd->command) == 0)
-        {
-            // Call handler
-            if (g_handlers[i].prev_handler)
-            {
-                int res = g_handlers[i].prev_handler(context, cmd);
-                if (res != 0)
-                    return res;
-            }
-            return g_handlers[i].handler(context, cmd);
-        }
+        // No handler found
+        LOG_DEBUG("No handler found for command: %s", cmd->command);
+        metrics_observe_command(METRICS_UNKNOWN_COMMAND, 0);
+        return -1;
     }
 
-    // No handler found
-    LOG_DEBUG("No handler found for command: %s", cmd->command);
-    return -1;
+    // Apply the flags and call the handler, timing both stages
+    long long start = metrics_now_us();
+    unsigned flags = entry->flags;
+    unsigned missing = 0;
+    if (g_ops && flags)
+    {
+        if (flags & CMD_CLEAR_ALL)
+            g_ops->clear(context, flags & CMD_CLEAR_ALL);
+        if (flags & CMD_NEED_MASK)
+            missing = flags & CMD_NEED_MASK & ~g_ops->get_state(context);
+    }
+    int res = missing ? g_ops->refuse(context, missing) : entry->handler(context, cmd);
+    metrics_observe_command((int)(entry - g_handlers), metrics_now_us() - start);
+    return res;
 }
 
 int cmd_is_registered(const char *command)
@@ -171,20 +340,23 @@ int cmd_is_registered(const char *command)
 
     // Convert command to uppercase for comparison
     char cmd_upper[PROTO_MAX_CMD_NAME];
-    strncpy(cmd_upper, command, PROTO_MAX_CMD_NAME - 1);
-    cmd_upper[PROTO_MAX_CMD_NAME - 1] = '\0';
-    to_uppercase(cmd_upper);
+    cmd_upper_name(cmd_upper, command);
 
     LOG_DEBUG("Checking registration for command: %s", cmd_upper);
 
-    // Check if handler exists
-    for (int i = 0; i < CMD_MAX_HANDLERS; i++)
-    {
-        if (g_handlers[i].in_use && strcmp(g_handlers[i].command, cmd_upper) == 0)
-            return 1;
-    }
+    return cmd_lookup(cmd_upper) != NULL;
+}
 
-    return 0;
+unsigned cmd_get_handler_flags(const char *command)
+{
+    if (!g_initialized || !command)
+        return 0;
+
+    char cmd_upper[PROTO_MAX_CMD_NAME];
+    cmd_upper_name(cmd_upper, command);
+
+    cmd_handler_entry_t *entry = cmd_lookup(cmd_upper);
+    return entry ? entry->flags : 0;
 }
 
 int cmd_get_handler_count(void)
@@ -202,6 +374,14 @@ int cmd_get_handler_count(void)
     return count;
 }
 
+const char *cmd_get_handler_name(int slot)
+{
+    if (!g_initialized || slot < 0 || slot >= CMD_MAX_HANDLERS || !g_handlers[slot].in_use)
+        return NULL;
+
+    return g_handlers[slot].command;
+}
+
 const char *cmd_get_all_registered_commands(void)
 {
     static char command_list[CMD_MAX_HANDLERS * (PROTO_MAX_CMD_NAME + 4)]; // +4 for comma, space, and line breaks
@@ -234,10 +414,8 @@ const char *cmd_get_all_registered_commands(void)
     return command_list;
 }
 
-// Forward declarations for previous command handlers
-extern int cmd_prev_handle_clear_restart(cmd_handler_context_t context, const proto_command_t *cmd); // CLEAR RESTART
-extern int cmd_prev_handle_clear_rename(cmd_handler_context_t context, const proto_command_t *cmd);  // CLEAR RENAME
-extern int cmd_prev_handle_clear_all(cmd_handler_context_t context, const proto_command_t *cmd);     // CLEAR RESTART & RENAME
+// Session side of the command flags
+extern const cmd_context_ops_t cmd_session_ops;
 
 // Forward declarations for standard command handlers
 // RFC 959 4.1 FTP COMMANDS
@@ -255,6 +433,11 @@ extern int cmd_handle_smnt(cmd_handler_context_t context, const proto_command_t
 extern int cmd_handle_quit(cmd_handler_context_t context, const proto_command_t *cmd); // LOGOUT
 extern int cmd_handle_rein(cmd_handler_context_t context, const proto_command_t *cmd); // REINITIALIZE
 
+// Security Commands (RFC 4217)
+extern int cmd_handle_auth(cmd_handler_context_t context, const proto_command_t *cmd); // AUTHENTICATION/SECURITY MECHANISM
+extern int cmd_handle_pbsz(cmd_handler_context_t context, const proto_command_t *cmd); // PROTECTION BUFFER SIZE
+extern int cmd_handle_prot(cmd_handler_context_t context, const proto_command_t *cmd); // DATA CHANNEL PROTECTION LEVEL
+
 // Transfer Parameter Commands
 extern int cmd_handle_port(cmd_handler_context_t context, const proto_command_t *cmd); // DATA PORT
 extern int cmd_handle_pasv(cmd_handler_context_t context, const proto_command_t *cmd); // PASSIVE MODE
@@ -265,6 +448,7 @@ extern int cmd_handle_mode(cmd_handler_context_t context, const proto_command_t
 // FTP Service Commands
 extern int cmd_handle_allo(cmd_handler_context_t context, const proto_command_t *cmd); // ALLOCATE
 extern int cmd_handle_rest(cmd_handler_context_t context, const proto_command_t *cmd); // RESTART
+extern int cmd_handle_rang(cmd_handler_context_t context, const proto_command_t *cmd); // RANGE
 extern int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd); // STORE
 extern int cmd_handle_stou(cmd_handler_context_t context, const proto_command_t *cmd); // STORE UNIQUE
 extern int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd); // RETRIEVE
@@ -292,6 +476,13 @@ extern int cmd_handle_noop(cmd_handler_context_t context, const proto_command_t
 extern int cmd_handle_feat(cmd_handler_context_t context, const proto_command_t *cmd); // FEATURES
 extern int cmd_handle_size(cmd_handler_context_t context, const proto_command_t *cmd); // FILE SIZE
 extern int cmd_handle_mdtm(cmd_handler_context_t context, const proto_command_t *cmd); // MODIFICATION TIME
+extern int cmd_handle_opts(cmd_handler_context_t context, const proto_command_t *cmd); // OPTIONS
+extern int cmd_handle_mlsd(cmd_handler_context_t context, const proto_command_t *cmd); // MACHINE LIST DIRECTORY
+extern int cmd_handle_mlst(cmd_handler_context_t context, const proto_command_t *cmd); // MACHINE LIST OBJECT
+extern int cmd_handle_hash(cmd_handler_context_t context, const proto_command_t *cmd); // FILE HASH
+extern int cmd_handle_xcrc(cmd_handler_context_t context, const proto_command_t *cmd); // CRC-32 OF FILE
+extern int cmd_handle_xmd5(cmd_handler_context_t context, const proto_command_t *cmd); // MD5 OF FILE
+extern int cmd_handle_xsha256(cmd_handler_context_t context, const proto_command_t *cmd); // SHA-256 OF FILE
 
 int cmd_register_standard_handlers(void)
 {
@@ -300,50 +491,66 @@ int cmd_register_standard_handlers(void)
 
     int result = 0;
 
+    // Preconditions and state resets are checked once in cmd_dispatch(), not in every handler
+    cmd_set_context_ops(&cmd_session_ops);
+
     // Register all standard FTP commands
-    result |= cmd_register_handler("USER", cmd_handle_user, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("PASS", cmd_handle_pass, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("ACCT", cmd_handle_acct, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("CWD", cmd_handle_cwd, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("CDUP", cmd_handle_cdup, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("SMNT", cmd_handle_smnt, cmd_prev_handle_clear_all);
-
-    result |= cmd_register_handler("QUIT", cmd_handle_quit, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("REIN", cmd_handle_rein, cmd_prev_handle_clear_all);
-
-    result |= cmd_register_handler("PORT", cmd_handle_port, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("PASV", cmd_handle_pasv, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("TYPE", cmd_handle_type, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("STRU", cmd_handle_stru, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("MODE", cmd_handle_mode, cmd_prev_handle_clear_all);
-
-    // result |= cmd_register_handler("ALLO", cmd_handle_allo, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("REST", cmd_handle_rest, cmd_prev_handle_clear_rename);
-    result |= cmd_register_handler("STOR", cmd_handle_stor, cmd_prev_handle_clear_rename);
-    // result |= cmd_register_handler("STOU", cmd_handle_stou, cmd_prev_handle_clear_rename);
-    result |= cmd_register_handler("RETR", cmd_handle_retr, cmd_prev_handle_clear_rename);
-    result |= cmd_register_handler("APPE", cmd_handle_appe, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("LIST", cmd_handle_list, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("NLST", cmd_handle_nlst, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("RNFR", cmd_handle_rnfr, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("RNTO", cmd_handle_rnto, cmd_prev_handle_clear_restart);
-    result |= cmd_register_handler("DELE", cmd_handle_dele, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("RMD", cmd_handle_rmd, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("MKD", cmd_handle_mkd, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("PWD", cmd_handle_pwd, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("ABOR", cmd_handle_abor, cmd_prev_handle_clear_all);
-
-    result |= cmd_register_handler("SYST", cmd_handle_syst, cmd_prev_handle_clear_all);
-    // result |= cmd_register_handler("STAT", cmd_handle_stat, cmd_prev_handle_clear_all);
-    // result |= cmd_register_handler("HELP", cmd_handle_help, cmd_prev_handle_clear_all);
-
-    // result |= cmd_register_handler("SITE", cmd_handle_site, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("NOOP", cmd_handle_noop, NULL);
+    result |= cmd_register_handler("USER", cmd_handle_user, CMD_CLEAR_ALL);
+    result |= cmd_register_handler("PASS", cmd_handle_pass, CMD_CLEAR_ALL);
+    result |= cmd_register_handler("ACCT", cmd_handle_acct, CMD_CLEAR_ALL);
+    result |= cmd_register_handler("CWD", cmd_handle_cwd, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("CDUP", cmd_handle_cdup, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("SMNT", cmd_handle_smnt, CMD_CLEAR_ALL);
+
+    result |= cmd_register_handler("QUIT", cmd_handle_quit, CMD_CLEAR_ALL);
+    result |= cmd_register_handler("REIN", cmd_handle_rein, CMD_CLEAR_ALL);
+
+    result |= cmd_register_handler("AUTH", cmd_handle_auth, 0);
+    result |= cmd_register_handler("PBSZ", cmd_handle_pbsz, 0);
+    result |= cmd_register_handler("PROT", cmd_handle_prot, 0);
+
+    result |= cmd_register_handler("PORT", cmd_handle_port, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("PASV", cmd_handle_pasv, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("TYPE", cmd_handle_type, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("STRU", cmd_handle_stru, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("MODE", cmd_handle_mode, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+
+    result |= cmd_register_handler("ALLO", cmd_handle_allo, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("REST", cmd_handle_rest, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("RANG", cmd_handle_rang, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("STOR", cmd_handle_stor, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_RENAME);
+    // result |= cmd_register_handler("STOU", cmd_handle_stou, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("RETR", cmd_handle_retr, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("APPE", cmd_handle_appe, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("LIST", cmd_handle_list, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("NLST", cmd_handle_nlst, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("RNFR", cmd_handle_rnfr, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("RNTO", cmd_handle_rnto, CMD_NEED_AUTH | CMD_CLEAR_RESTART);
+    result |= cmd_register_handler("DELE", cmd_handle_dele, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("RMD", cmd_handle_rmd, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("MKD", cmd_handle_mkd, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("PWD", cmd_handle_pwd, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("ABOR", cmd_handle_abor, CMD_CLEAR_ALL);
+
+    result |= cmd_register_handler("SYST", cmd_handle_syst, CMD_CLEAR_ALL);
+    result |= cmd_register_handler("STAT", cmd_handle_stat, 0);
+    // result |= cmd_register_handler("HELP", cmd_handle_help, CMD_CLEAR_ALL);
+
+    result |= cmd_register_handler("SITE", cmd_handle_site, CMD_NEED_AUTH);
+    result |= cmd_register_handler("NOOP", cmd_handle_noop, 0);
 
     // Extension commands
-    result |= cmd_register_handler("FEAT", cmd_handle_feat, NULL);
-    result |= cmd_register_handler("SIZE", cmd_handle_size, cmd_prev_handle_clear_all);
-    result |= cmd_register_handler("MDTM", cmd_handle_mdtm, cmd_prev_handle_clear_all);
+    result |= cmd_register_handler("FEAT", cmd_handle_feat, 0);
+    result |= cmd_register_handler("SIZE", cmd_handle_size, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("MDTM", cmd_handle_mdtm, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("OPTS", cmd_handle_opts, 0);
+    result |= cmd_register_handler("MLSD", cmd_handle_mlsd, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_ALL);
+    result |= cmd_register_handler("MLST", cmd_handle_mlst, CMD_NEED_AUTH | CMD_CLEAR_ALL);
+    // Checksums cover the range set by a preceding REST or RANG
+    result |= cmd_register_handler("HASH", cmd_handle_hash, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("XCRC", cmd_handle_xcrc, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("XMD5", cmd_handle_xmd5, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
+    result |= cmd_register_handler("XSHA256", cmd_handle_xsha256, CMD_NEED_AUTH | CMD_CLEAR_RENAME);
 
     return (result == 0) ? 0 : -1;
 }
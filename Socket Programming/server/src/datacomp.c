@@ -0,0 +1,415 @@
+/**
+ * @file datacomp.c
+ * @brief Deflate compression of the data channel (MODE Z) implementation
+ * @version 0.1
+ * @date 2025-11-27
+ *
+ */
+#include "datacomp.h"
+#include "logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+int datacomp_is_incompressible(const void *data, size_t length)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    if (length > DATACOMP_SAMPLE_SIZE)
+        length = DATACOMP_SAMPLE_SIZE;
+
+    // Too short to judge, and cheap to compress anyway
+    if (!bytes || length < DATACOMP_MIN_SAMPLE_SIZE)
+        return 0;
+
+    unsigned int counts[256] = {0};
+    for (size_t i = 0; i < length; i++)
+    {
+        counts[bytes[i]]++;
+    }
+
+    // Sum of squared counts: n^2/256 + n for uniform bytes, several times more for text
+    unsigned long long squares = 0;
+    for (int i = 0; i < 256; i++)
+    {
+        squares += (unsigned long long)counts[i] * counts[i];
+    }
+
+    unsigned long long n = length;
+    return squares * 256 * 10 < n * n * 13 + n * 256 * 10;
+}
+
+#ifdef ENABLE_ZLIB
+
+struct datacomp_writer
+{
+    socket_t sock;
+    z_stream zs;
+    int level;              // Requested level
+    int current_level;      // Level in effect (0 while storing incompressible data)
+    int adaptive;
+    long long until_sample; // Input bytes left before the next sample
+    size_t used;            // Output bytes waiting in out
+    long long total_out;
+    unsigned char out[DATACOMP_BUFFER_SIZE];
+};
+
+struct datacomp_reader
+{
+    socket_t sock;
+    z_stream zs;
+    int finished;
+    long long total_in;
+    unsigned char in[DATACOMP_BUFFER_SIZE];
+};
+
+int datacomp_is_available(void)
+{
+    return 1;
+}
+
+/**
+ * @brief Sends the pending output of a writer.
+ */
+static int writer_send(datacomp_writer_t *writer)
+{
+    if (writer->used == 0)
+        return 0;
+
+    if (net_send_all(writer->sock, writer->out, writer->used) != 0)
+        return -1;
+
+    writer->total_out += (long long)writer->used;
+    writer->used = 0;
+    return 0;
+}
+
+/**
+ * @brief Runs deflate() until the input is consumed or, with Z_FINISH, the stream ends.
+ */
+static int writer_deflate(datacomp_writer_t *writer, int flush)
+{
+    for (;;)
+    {
+        writer->zs.next_out = writer->out + writer->used;
+        writer->zs.avail_out = (uInt)(sizeof(writer->out) - writer->used);
+
+        int rc = deflate(&writer->zs, flush);
+        writer->used = sizeof(writer->out) - writer->zs.avail_out;
+
+        if (rc == Z_STREAM_ERROR)
+        {
+            LOG_ERROR("Deflate stream error");
+            return -1;
+        }
+
+        if (writer->used == sizeof(writer->out))
+        {
+            if (writer_send(writer) != 0)
+                return -1;
+            continue;
+        }
+
+        // Output space is left, so deflate has taken all it could
+        if (flush == Z_FINISH ? rc == Z_STREAM_END : writer->zs.avail_in == 0)
+            return 0;
+    }
+}
+
+/**
+ * @brief Switches the level, e.g. to store a stretch of incompressible data.
+ */
+static int writer_set_level(datacomp_writer_t *writer, int level)
+{
+    for (;;)
+    {
+        writer->zs.next_out = writer->out + writer->used;
+        writer->zs.avail_out = (uInt)(sizeof(writer->out) - writer->used);
+
+        int rc = deflateParams(&writer->zs, level, Z_DEFAULT_STRATEGY);
+        writer->used = sizeof(writer->out) - writer->zs.avail_out;
+
+        if (rc == Z_OK)
+        {
+            writer->current_level = level;
+            return 0;
+        }
+
+        // Z_BUF_ERROR: the block in progress needs more output space
+        if (rc != Z_BUF_ERROR || writer->used == 0)
+            return 0; // Keep the current level
+        if (writer_send(writer) != 0)
+            return -1;
+    }
+}
+
+datacomp_writer_t *datacomp_writer_create(socket_t sock, int level, int adaptive)
+{
+    if (sock == INVALID_SOCKET_T || level < DATACOMP_MIN_LEVEL || level > DATACOMP_MAX_LEVEL)
+        return NULL;
+
+    datacomp_writer_t *writer = (datacomp_writer_t *)malloc(sizeof(datacomp_writer_t));
+    if (!writer)
+    {
+        LOG_ERROR("Failed to allocate deflate writer");
+        return NULL;
+    }
+
+    memset(&writer->zs, 0, sizeof(writer->zs));
+    if (deflateInit(&writer->zs, level) != Z_OK)
+    {
+        LOG_ERROR("Failed to initialize deflate stream");
+        free(writer);
+        return NULL;
+    }
+
+    writer->sock = sock;
+    writer->level = level;
+    writer->current_level = level;
+    writer->adaptive = adaptive && level > 0;
+    writer->until_sample = 0;
+    writer->used = 0;
+    writer->total_out = 0;
+    return writer;
+}
+
+int datacomp_writer_write(datacomp_writer_t *writer, const void *data, size_t length)
+{
+    if (!writer || (!data && length > 0))
+        return -1;
+
+    if (writer->adaptive)
+    {
+        // Writes too small to judge leave the sample to the next one
+        if (writer->until_sample <= 0 && length >= DATACOMP_MIN_SAMPLE_SIZE)
+        {
+            int level = datacomp_is_incompressible(data, length) ? 0 : writer->level;
+            if (level != writer->current_level)
+            {
+                LOG_DEBUG("Deflate level %d -> %d after sampling", writer->current_level, level);
+                if (writer_set_level(writer, level) != 0)
+                    return -1;
+            }
+            writer->until_sample = DATACOMP_RESAMPLE_INTERVAL;
+        }
+        writer->until_sample -= (long long)length;
+    }
+
+    // zlib counts in uInt, so feed large buffers in pieces
+    const unsigned char *bytes = (const unsigned char *)data;
+    while (length > 0)
+    {
+        size_t piece = length > DATACOMP_BUFFER_SIZE ? DATACOMP_BUFFER_SIZE : length;
+        writer->zs.next_in = (Bytef *)bytes;
+        writer->zs.avail_in = (uInt)piece;
+        if (writer_deflate(writer, Z_NO_FLUSH) != 0)
+            return -1;
+        bytes += piece;
+        length -= piece;
+    }
+
+    return 0;
+}
+
+int datacomp_writer_finish(datacomp_writer_t *writer)
+{
+    if (!writer)
+        return -1;
+
+    writer->zs.next_in = NULL;
+    writer->zs.avail_in = 0;
+    if (writer_deflate(writer, Z_FINISH) != 0)
+        return -1;
+
+    return writer_send(writer);
+}
+
+void datacomp_writer_get_totals(const datacomp_writer_t *writer, long long *bytes_in, long long *bytes_out)
+{
+    if (bytes_in)
+        *bytes_in = writer ? (long long)writer->zs.total_in : 0;
+    if (bytes_out)
+        *bytes_out = writer ? writer->total_out : 0;
+}
+
+void datacomp_writer_destroy(datacomp_writer_t *writer)
+{
+    if (!writer)
+        return;
+
+    deflateEnd(&writer->zs);
+    free(writer);
+}
+
+datacomp_reader_t *datacomp_reader_create(socket_t sock)
+{
+    if (sock == INVALID_SOCKET_T)
+        return NULL;
+
+    datacomp_reader_t *reader = (datacomp_reader_t *)malloc(sizeof(datacomp_reader_t));
+    if (!reader)
+    {
+        LOG_ERROR("Failed to allocate inflate reader");
+        return NULL;
+    }
+
+    memset(&reader->zs, 0, sizeof(reader->zs));
+    if (inflateInit(&reader->zs) != Z_OK)
+    {
+        LOG_ERROR("Failed to initialize inflate stream");
+        free(reader);
+        return NULL;
+    }
+
+    reader->sock = sock;
+    reader->finished = 0;
+    reader->total_in = 0;
+    return reader;
+}
+
+int datacomp_reader_receive(datacomp_reader_t *reader, void *buffer, size_t buffer_size)
+{
+    if (!reader || !buffer || buffer_size == 0)
+        return DATACOMP_STREAM_ERROR;
+
+    if (reader->finished)
+        return 0;
+
+    if (buffer_size > DATACOMP_BUFFER_SIZE)
+        buffer_size = DATACOMP_BUFFER_SIZE;
+
+    for (;;)
+    {
+        if (reader->zs.avail_in == 0)
+        {
+            int received = net_receive(reader->sock, reader->in, sizeof(reader->in));
+            if (received < 0)
+                return DATACOMP_NET_ERROR;
+            if (received == 0)
+            {
+                if (reader->total_in == 0)
+                {
+                    reader->finished = 1;
+                    return 0;
+                }
+                LOG_ERROR("Compressed stream truncated after %lld bytes", reader->total_in);
+                return DATACOMP_STREAM_ERROR;
+            }
+            reader->zs.next_in = reader->in;
+            reader->zs.avail_in = (uInt)received;
+            reader->total_in += received;
+        }
+
+        reader->zs.next_out = (Bytef *)buffer;
+        reader->zs.avail_out = (uInt)buffer_size;
+
+        int rc = inflate(&reader->zs, Z_NO_FLUSH);
+        int produced = (int)(buffer_size - reader->zs.avail_out);
+
+        if (rc == Z_STREAM_END)
+        {
+            reader->finished = 1;
+            return produced;
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR)
+        {
+            LOG_ERROR("Corrupt compressed stream: %s", reader->zs.msg ? reader->zs.msg : "unknown error");
+            return DATACOMP_STREAM_ERROR;
+        }
+        if (produced > 0)
+            return produced;
+    }
+}
+
+void datacomp_reader_get_totals(const datacomp_reader_t *reader, long long *bytes_in, long long *bytes_out)
+{
+    if (bytes_in)
+        *bytes_in = reader ? reader->total_in : 0;
+    if (bytes_out)
+        *bytes_out = reader ? (long long)reader->zs.total_out : 0;
+}
+
+void datacomp_reader_destroy(datacomp_reader_t *reader)
+{
+    if (!reader)
+        return;
+
+    inflateEnd(&reader->zs);
+    free(reader);
+}
+
+#else // !ENABLE_ZLIB
+
+int datacomp_is_available(void)
+{
+    return 0;
+}
+
+datacomp_writer_t *datacomp_writer_create(socket_t sock, int level, int adaptive)
+{
+    (void)sock;
+    (void)level;
+    (void)adaptive;
+    return NULL;
+}
+
+int datacomp_writer_write(datacomp_writer_t *writer, const void *data, size_t length)
+{
+    (void)writer;
+    (void)data;
+    (void)length;
+    return -1;
+}
+
+int datacomp_writer_finish(datacomp_writer_t *writer)
+{
+    (void)writer;
+    return -1;
+}
+
+void datacomp_writer_get_totals(const datacomp_writer_t *writer, long long *bytes_in, long long *bytes_out)
+{
+    (void)writer;
+    if (bytes_in)
+        *bytes_in = 0;
+    if (bytes_out)
+        *bytes_out = 0;
+}
+
+void datacomp_writer_destroy(datacomp_writer_t *writer)
+{
+    (void)writer;
+}
+
+datacomp_reader_t *datacomp_reader_create(socket_t sock)
+{
+    (void)sock;
+    return NULL;
+}
+
+int datacomp_reader_receive(datacomp_reader_t *reader, void *buffer, size_t buffer_size)
+{
+    (void)reader;
+    (void)buffer;
+    (void)buffer_size;
+    return DATACOMP_STREAM_ERROR;
+}
+
+void datacomp_reader_get_totals(const datacomp_reader_t *reader, long long *bytes_in, long long *bytes_out)
+{
+    (void)reader;
+    if (bytes_in)
+        *bytes_in = 0;
+    if (bytes_out)
+        *bytes_out = 0;
+}
+
+void datacomp_reader_destroy(datacomp_reader_t *reader)
+{
+    (void)reader;
+}
+
+#endif // ENABLE_ZLIB
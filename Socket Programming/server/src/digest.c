@@ -0,0 +1,535 @@
+/**
+ * @file digest.c
+ * @brief Checksum and message digest implementations
+ * @version 0.1
+ * @date 2025-12-10
+ *
+ */
+#include "digest.h"
+#include "atomics.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define DIGEST_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#if defined(HWCAP_CRC32)
+#define DIGEST_ARM 1
+#include <arm_acle.h>
+#endif
+#endif
+
+// Reflected polynomials
+#define CRC32_POLY 0xEDB88320u  // IEEE 802.3
+#define CRC32C_POLY 0x82F63B78u // Castagnoli
+
+typedef uint32_t (*crc_fn_t)(uint32_t crc, const unsigned char *data, size_t length);
+typedef void (*blocks_fn_t)(uint32_t *state, const unsigned char *data, size_t count);
+
+static const char *const g_algorithm_names[DIGEST_ALGORITHM_COUNT] = {
+    "SHA-256",
+    "MD5",
+    "CRC32",
+    "CRC32C",
+};
+
+// Slicing-by-8 tables, [0] is the classic byte table
+static uint32_t g_crc32_table[8][256];
+static uint32_t g_crc32c_table[8][256];
+
+// Implementations picked at first use
+static struct
+{
+    pthread_once_t once;
+    int use_hardware;
+    crc_fn_t crc32c_hw;
+    blocks_fn_t sha256_hw;
+    const char *crc32c_hw_name;
+    const char *sha256_hw_name;
+} g_digest = {.once = PTHREAD_ONCE_INIT, .use_hardware = 1};
+
+static const uint32_t g_md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const unsigned char g_md5_shift[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static const uint32_t g_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t rotl32(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+static uint32_t rotr32(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static uint32_t load_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t load_be32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+// CRC-32 and CRC-32C
+
+static void crc_build_table(uint32_t table[8][256], uint32_t poly)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+        table[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++)
+    {
+        for (int i = 0; i < 256; i++)
+            table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+    }
+}
+
+/**
+ * @brief Slicing-by-8: eight table lookups fold eight bytes at once.
+ */
+static uint32_t crc_slice8(const uint32_t table[8][256], uint32_t crc, const unsigned char *p, size_t length)
+{
+    while (length >= 8)
+    {
+        uint32_t one = crc ^ load_le32(p);
+        uint32_t two = load_le32(p + 4);
+        crc = table[7][one & 0xff] ^ table[6][(one >> 8) & 0xff] ^
+              table[5][(one >> 16) & 0xff] ^ table[4][one >> 24] ^
+              table[3][two & 0xff] ^ table[2][(two >> 8) & 0xff] ^
+              table[1][(two >> 16) & 0xff] ^ table[0][two >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--)
+        crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xff];
+    return crc;
+}
+
+static uint32_t crc32_generic(uint32_t crc, const unsigned char *data, size_t length)
+{
+    return crc_slice8((const uint32_t(*)[256])g_crc32_table, crc, data, length);
+}
+
+static uint32_t crc32c_generic(uint32_t crc, const unsigned char *data, size_t length)
+{
+    return crc_slice8((const uint32_t(*)[256])g_crc32c_table, crc, data, length);
+}
+
+#ifdef DIGEST_X86
+__attribute__((target("sse4.2"))) static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t length)
+{
+    uint64_t value = crc;
+    while (length >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        value = _mm_crc32_u64(value, word);
+        p += 8;
+        length -= 8;
+    }
+    crc = (uint32_t)value;
+    while (length--)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+#ifdef DIGEST_ARM
+__attribute__((target("+crc"))) static uint32_t crc32c_armv8(uint32_t crc, const unsigned char *p, size_t length)
+{
+    while (length >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = __crc32cd(crc, word);
+        p += 8;
+        length -= 8;
+    }
+    while (length--)
+        crc = __crc32cb(crc, *p++);
+    return crc;
+}
+#endif
+
+// MD5 (RFC 1321)
+
+static void md5_blocks(uint32_t *state, const unsigned char *data, size_t count)
+{
+    for (; count > 0; count--, data += 64)
+    {
+        uint32_t m[16];
+        for (int i = 0; i < 16; i++)
+            m[i] = load_le32(data + 4 * i);
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t f;
+            int g;
+            if (i < 16)
+            {
+                f = (b & c) | (~b & d);
+                g = i;
+            }
+            else if (i < 32)
+            {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) & 15;
+            }
+            else if (i < 48)
+            {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) & 15;
+            }
+            else
+            {
+                f = c ^ (b | ~d);
+                g = (7 * i) & 15;
+            }
+            uint32_t next = d;
+            d = c;
+            c = b;
+            b = b + rotl32(a + f + g_md5_k[i] + m[g], g_md5_shift[i]);
+            a = next;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    }
+}
+
+// SHA-256 (FIPS 180-4)
+
+static void sha256_blocks_generic(uint32_t *state, const unsigned char *data, size_t count)
+{
+    for (; count > 0; count--, data += 64)
+    {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = load_be32(data + 4 * i);
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) +
+                          g_sha256_k[i] + w[i];
+            uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef DIGEST_X86
+/**
+ * @brief SHA-256 with the SHA extensions: each sha256rnds2 does two rounds,
+ * sha256msg1/msg2 extend the message schedule four words at a time.
+ */
+__attribute__((target("sha,sse4.1"))) static void sha256_blocks_shani(uint32_t *state, const unsigned char *data,
+                                                                      size_t count)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+    // The instructions keep the state as ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1); // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B); // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);                                        // CDGH
+
+    for (; count > 0; count--, data += 64)
+    {
+        __m128i abef = state0;
+        __m128i cdgh = state1;
+        __m128i w[4];
+
+        for (int i = 0; i < 16; i++)
+        {
+            __m128i words;
+            if (i < 4)
+            {
+                words = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16 * i)), byte_swap);
+            }
+            else
+            {
+                words = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+                words = _mm_add_epi32(words, _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                words = _mm_sha256msg2_epu32(words, w[(i + 3) & 3]);
+            }
+            w[i & 3] = words;
+
+            __m128i rounds = _mm_add_epi32(words, _mm_loadu_si128((const __m128i *)&g_sha256_k[4 * i]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, rounds);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(rounds, 0x0E));
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);    // HGFE
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#endif
+
+// Dispatch
+
+static void digest_detect(void)
+{
+    crc_build_table(g_crc32_table, CRC32_POLY);
+    crc_build_table(g_crc32c_table, CRC32C_POLY);
+
+#ifdef DIGEST_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        if (ecx & bit_SSE4_2)
+        {
+            g_digest.crc32c_hw = crc32c_sse42;
+            g_digest.crc32c_hw_name = "SSE4.2";
+        }
+        int sse41 = (ecx & bit_SSE4_1) != 0;
+        if (sse41 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA))
+        {
+            g_digest.sha256_hw = sha256_blocks_shani;
+            g_digest.sha256_hw_name = "SHA-NI";
+        }
+    }
+#endif
+#ifdef DIGEST_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    {
+        g_digest.crc32c_hw = crc32c_armv8;
+        g_digest.crc32c_hw_name = "ARMv8";
+    }
+#endif
+}
+
+const char *digest_algorithm_name(digest_algorithm_t algorithm)
+{
+    if ((int)algorithm < 0 || (int)algorithm >= DIGEST_ALGORITHM_COUNT)
+        return "unknown";
+    return g_algorithm_names[algorithm];
+}
+
+int digest_parse_algorithm(const char *name, digest_algorithm_t *algorithm)
+{
+    if (!name || !algorithm)
+        return -1;
+
+    for (int i = 0; i < DIGEST_ALGORITHM_COUNT; i++)
+    {
+        const char *known = g_algorithm_names[i];
+        size_t j = 0;
+        while (known[j] && tolower((unsigned char)known[j]) == tolower((unsigned char)name[j]))
+            j++;
+        if (known[j] == '\0' && name[j] == '\0')
+        {
+            *algorithm = (digest_algorithm_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *digest_implementation(digest_algorithm_t algorithm)
+{
+    pthread_once(&g_digest.once, digest_detect);
+    if (!ATOMIC_LOAD_RELAXED(&g_digest.use_hardware))
+        return "generic";
+    if (algorithm == DIGEST_CRC32C && g_digest.crc32c_hw)
+        return g_digest.crc32c_hw_name;
+    if (algorithm == DIGEST_SHA256 && g_digest.sha256_hw)
+        return g_digest.sha256_hw_name;
+    return "generic";
+}
+
+void digest_use_hardware(int enabled)
+{
+    ATOMIC_STORE_RELAXED(&g_digest.use_hardware, enabled ? 1 : 0);
+}
+
+void digest_init(digest_ctx_t *ctx, digest_algorithm_t algorithm)
+{
+    static const uint32_t sha256_initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    static const uint32_t md5_initial[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+    pthread_once(&g_digest.once, digest_detect);
+    int hardware = ATOMIC_LOAD_RELAXED(&g_digest.use_hardware);
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->algorithm = algorithm;
+    switch (algorithm)
+    {
+    case DIGEST_MD5:
+        memcpy(ctx->state, md5_initial, sizeof(md5_initial));
+        ctx->blocks = md5_blocks;
+        break;
+    case DIGEST_CRC32:
+        ctx->state[0] = 0xFFFFFFFFu;
+        ctx->crc = crc32_generic;
+        break;
+    case DIGEST_CRC32C:
+        ctx->state[0] = 0xFFFFFFFFu;
+        ctx->crc = (hardware && g_digest.crc32c_hw) ? g_digest.crc32c_hw : crc32c_generic;
+        break;
+    case DIGEST_SHA256:
+    default:
+        ctx->algorithm = DIGEST_SHA256;
+        memcpy(ctx->state, sha256_initial, sizeof(sha256_initial));
+        ctx->blocks = (hardware && g_digest.sha256_hw) ? g_digest.sha256_hw : sha256_blocks_generic;
+        break;
+    }
+}
+
+/**
+ * @brief Feeds bytes to the block function without counting them.
+ */
+static void digest_absorb(digest_ctx_t *ctx, const unsigned char *p, size_t length)
+{
+    if (ctx->block_used > 0)
+    {
+        size_t take = sizeof(ctx->block) - ctx->block_used;
+        if (take > length)
+            take = length;
+        memcpy(ctx->block + ctx->block_used, p, take);
+        ctx->block_used += take;
+        p += take;
+        length -= take;
+        if (ctx->block_used < sizeof(ctx->block))
+            return;
+        ctx->blocks(ctx->state, ctx->block, 1);
+        ctx->block_used = 0;
+    }
+
+    if (length >= 64)
+    {
+        ctx->blocks(ctx->state, p, length / 64);
+        p += length & ~(size_t)63;
+        length &= 63;
+    }
+
+    memcpy(ctx->block, p, length);
+    ctx->block_used = length;
+}
+
+void digest_update(digest_ctx_t *ctx, const void *data, size_t length)
+{
+    if (!ctx || (!data && length > 0))
+        return;
+
+    ctx->length += length;
+    if (ctx->crc)
+    {
+        ctx->state[0] = ctx->crc(ctx->state[0], (const unsigned char *)data, length);
+        return;
+    }
+    digest_absorb(ctx, (const unsigned char *)data, length);
+}
+
+void digest_final_hex(digest_ctx_t *ctx, char *hex)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    if (ctx->crc)
+    {
+        snprintf(hex, DIGEST_HEX_SIZE, "%08x", (unsigned int)(ctx->state[0] ^ 0xFFFFFFFFu));
+        return;
+    }
+
+    // Padding: 0x80, zeros up to 56 mod 64, then the length in bits
+    unsigned char pad[72] = {0x80};
+    size_t pad_length = (ctx->block_used < 56 ? 56 : 120) - ctx->block_used;
+    uint64_t bits = ctx->length * 8;
+    int md5 = ctx->algorithm == DIGEST_MD5;
+    for (int i = 0; i < 8; i++)
+        pad[pad_length + i] = (unsigned char)(bits >> (md5 ? 8 * i : 56 - 8 * i));
+    digest_absorb(ctx, pad, pad_length + 8);
+
+    // MD5 words are little endian, SHA-256 words big endian
+    int words = md5 ? 4 : 8;
+    for (int i = 0; i < words; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            unsigned int byte = (ctx->state[i] >> (md5 ? 8 * j : 24 - 8 * j)) & 0xff;
+            hex[8 * i + 2 * j] = digits[byte >> 4];
+            hex[8 * i + 2 * j + 1] = digits[byte & 15];
+        }
+    }
+    hex[8 * words] = '\0';
+}
+
+void digest_hex(digest_algorithm_t algorithm, const void *data, size_t length, char *hex)
+{
+    digest_ctx_t ctx;
+    digest_init(&ctx, algorithm);
+    digest_update(&ctx, data, length);
+    digest_final_hex(&ctx, hex);
+}
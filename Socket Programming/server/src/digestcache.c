@@ -0,0 +1,238 @@
+/**
+ * @file digestcache.c
+ * @brief File checksum cache implementation
+ * @version 0.1
+ * @date 2025-12-10
+ *
+ */
+#include "digestcache.h"
+
+#include "logger.h"
+#include "session.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+    char path[SESSION_MAX_PATH];
+    uint64_t hash;
+    long long size;              // File size the checksum was computed from
+    time_t last_modified;        // File mtime the checksum was computed from
+    digest_algorithm_t algorithm;
+    long long offset;            // First byte covered
+    time_t last_used;            // For LRU replacement
+    int used;                    // 0 for a free slot
+    char hex[DIGEST_HEX_SIZE];
+} digestcache_entry_t;
+
+// Global cache state
+static struct
+{
+    digestcache_entry_t *entries;
+    int max_entries;
+    unsigned long generation; // Bumped by every invalidation
+    pthread_mutex_t mutex;
+} g_digestcache = {NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief FNV-1a hash of a path
+ */
+static uint64_t digestcache_hash(const char *path)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static digestcache_entry_t *digestcache_find(const char *path, uint64_t hash, digest_algorithm_t algorithm,
+                                             long long offset)
+{
+    for (int i = 0; i < g_digestcache.max_entries; i++)
+    {
+        digestcache_entry_t *entry = &g_digestcache.entries[i];
+        if (entry->used && entry->hash == hash && entry->algorithm == algorithm && entry->offset == offset &&
+            strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+int digestcache_init(int max_entries)
+{
+    if (max_entries <= 0)
+    {
+        max_entries = DIGESTCACHE_DEFAULT_ENTRIES;
+    }
+
+    digestcache_entry_t *entries = (digestcache_entry_t *)calloc((size_t)max_entries, sizeof(digestcache_entry_t));
+    if (!entries)
+    {
+        LOG_ERROR("Failed to allocate checksum cache");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_digestcache.mutex);
+    free(g_digestcache.entries);
+    g_digestcache.entries = entries;
+    g_digestcache.max_entries = max_entries;
+    pthread_mutex_unlock(&g_digestcache.mutex);
+
+    LOG_INFO("Checksum cache enabled: entries=%d, SHA-256 %s, CRC32C %s", max_entries,
+             digest_implementation(DIGEST_SHA256), digest_implementation(DIGEST_CRC32C));
+    return 0;
+}
+
+void digestcache_cleanup(void)
+{
+    pthread_mutex_lock(&g_digestcache.mutex);
+    free(g_digestcache.entries);
+    g_digestcache.entries = NULL;
+    g_digestcache.max_entries = 0;
+    pthread_mutex_unlock(&g_digestcache.mutex);
+}
+
+int digestcache_lookup(const char *path, const fs_stat_t *st, digest_algorithm_t algorithm,
+                       long long offset, char *hex)
+{
+    if (!path || !st || !hex)
+    {
+        return -1;
+    }
+
+    uint64_t hash = digestcache_hash(path);
+    int result = -1;
+
+    pthread_mutex_lock(&g_digestcache.mutex);
+
+    digestcache_entry_t *entry = g_digestcache.entries ? digestcache_find(path, hash, algorithm, offset) : NULL;
+    if (entry)
+    {
+        if (entry->size != st->size || entry->last_modified != st->last_modified)
+        {
+            entry->used = 0;
+        }
+        else
+        {
+            memcpy(hex, entry->hex, DIGEST_HEX_SIZE);
+            entry->last_used = time(NULL);
+            result = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&g_digestcache.mutex);
+
+    return result;
+}
+
+unsigned long digestcache_get_generation(void)
+{
+    pthread_mutex_lock(&g_digestcache.mutex);
+    unsigned long generation = g_digestcache.generation;
+    pthread_mutex_unlock(&g_digestcache.mutex);
+
+    return generation;
+}
+
+void digestcache_store(const char *path, const fs_stat_t *st, digest_algorithm_t algorithm,
+                       long long offset, unsigned long generation, const char *hex)
+{
+    if (!path || !st || !hex || strlen(path) >= SESSION_MAX_PATH || strlen(hex) >= DIGEST_HEX_SIZE)
+    {
+        return;
+    }
+
+    // A change later in the same second would leave size and mtime unchanged
+    time_t now = time(NULL);
+    if (st->last_modified >= now - 1)
+    {
+        return;
+    }
+
+    uint64_t hash = digestcache_hash(path);
+
+    pthread_mutex_lock(&g_digestcache.mutex);
+
+    if (!g_digestcache.entries || generation != g_digestcache.generation)
+    {
+        // Disabled, or something was invalidated while the checksum was computed
+        pthread_mutex_unlock(&g_digestcache.mutex);
+        return;
+    }
+
+    digestcache_entry_t *entry = digestcache_find(path, hash, algorithm, offset);
+    if (!entry)
+    {
+        // Take a free slot, otherwise replace the least recently used one
+        entry = &g_digestcache.entries[0];
+        for (int i = 0; i < g_digestcache.max_entries; i++)
+        {
+            digestcache_entry_t *candidate = &g_digestcache.entries[i];
+            if (!candidate->used)
+            {
+                entry = candidate;
+                break;
+            }
+            if (candidate->last_used < entry->last_used)
+            {
+                entry = candidate;
+            }
+        }
+    }
+
+    snprintf(entry->path, sizeof(entry->path), "%s", path);
+    entry->hash = hash;
+    entry->size = st->size;
+    entry->last_modified = st->last_modified;
+    entry->algorithm = algorithm;
+    entry->offset = offset;
+    entry->last_used = now;
+    entry->used = 1;
+    snprintf(entry->hex, sizeof(entry->hex), "%s", hex);
+
+    pthread_mutex_unlock(&g_digestcache.mutex);
+}
+
+void digestcache_invalidate(const char *path)
+{
+    if (!path)
+    {
+        return;
+    }
+
+    size_t length = strlen(path);
+    while (length > 1 && (path[length - 1] == '/' || path[length - 1] == '\\'))
+    {
+        length--;
+    }
+
+    pthread_mutex_lock(&g_digestcache.mutex);
+
+    if (g_digestcache.entries)
+    {
+        g_digestcache.generation++;
+
+        // The path itself, or anything below it when a directory was renamed
+        for (int i = 0; i < g_digestcache.max_entries; i++)
+        {
+            digestcache_entry_t *entry = &g_digestcache.entries[i];
+            if (entry->used && strncmp(entry->path, path, length) == 0 &&
+                (entry->path[length] == '\0' || entry->path[length] == '/' || entry->path[length] == '\\'))
+            {
+                entry->used = 0;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&g_digestcache.mutex);
+}
@@ -4,25 +4,66 @@
  */
 #include "filelock.h"
 
+#include "atomics.h"
 #include "logger.h"
+#include "metrics.h"
 #include "session.h"
 
 #include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct file_lock_entry
+/**
+ * @brief Number of independently locked shards (power of two)
+ */
+#define FILE_LOCK_SHARD_COUNT 64
+
+/**
+ * @brief Hash buckets per shard (power of two)
+ */
+#define FILE_LOCK_BUCKETS_PER_SHARD 64
+
+/**
+ * @brief Released entries kept on a shard's free list for reuse
+ */
+#define FILE_LOCK_POOL_PER_SHARD 16
+
+struct file_lock_entry
 {
     char path[SESSION_MAX_PATH];
-    unsigned int readers;
+    uint64_t hash;
+    unsigned int readers; // Atomic: handle releases decrement it without the shard mutex
     unsigned int writers;
+    unsigned int waiting_readers;
     unsigned int waiting_writers;
-    pthread_cond_t cond;
+    pthread_cond_t cond; // Initialized once, kept while the entry sits in the pool
     struct file_lock_entry *next;
-} file_lock_entry_t;
+};
 
-static pthread_mutex_t g_file_lock_mutex = PTHREAD_MUTEX_INITIALIZER;
-static file_lock_entry_t *g_file_lock_entries = NULL;
+typedef struct file_lock_entry file_lock_entry_t;
+
+/**
+ * @brief One slice of the lock table, guarded by its own mutex
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    file_lock_entry_t *buckets[FILE_LOCK_BUCKETS_PER_SHARD];
+    file_lock_entry_t *pool; // Free entries
+    int pool_count;
+} file_lock_shard_t;
+
+static file_lock_shard_t g_file_lock_shards[FILE_LOCK_SHARD_COUNT];
+static pthread_once_t g_file_lock_once = PTHREAD_ONCE_INIT;
+
+static void file_lock_init_shards(void)
+{
+    for (int i = 0; i < FILE_LOCK_SHARD_COUNT; i++)
+    {
+        pthread_mutex_init(&g_file_lock_shards[i].mutex, NULL);
+    }
+}
 
 static int file_lock_path_valid(const char *path)
 {
@@ -41,81 +82,128 @@ static int file_lock_path_valid(const char *path)
     return 1;
 }
 
-static file_lock_entry_t *file_lock_find(const char *path, file_lock_entry_t **out_prev)
+/**
+ * @brief FNV-1a hash of a path
+ */
+static uint64_t file_lock_hash(const char *path)
 {
-    file_lock_entry_t *prev = NULL;
-    file_lock_entry_t *curr = g_file_lock_entries;
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
 
-    while (curr)
+/**
+ * @brief Locks and returns the shard responsible for a hash
+ */
+static file_lock_shard_t *file_lock_shard_lock(uint64_t hash)
+{
+    pthread_once(&g_file_lock_once, file_lock_init_shards);
+
+    file_lock_shard_t *shard = &g_file_lock_shards[hash & (FILE_LOCK_SHARD_COUNT - 1)];
+    pthread_mutex_lock(&shard->mutex);
+    return shard;
+}
+
+static file_lock_entry_t **file_lock_bucket(file_lock_shard_t *shard, uint64_t hash)
+{
+    // Low bits pick the shard, so index buckets with the next ones
+    return &shard->buckets[(hash >> 6) & (FILE_LOCK_BUCKETS_PER_SHARD - 1)];
+}
+
+static file_lock_entry_t *file_lock_find(file_lock_shard_t *shard, const char *path, uint64_t hash)
+{
+    for (file_lock_entry_t *curr = *file_lock_bucket(shard, hash); curr; curr = curr->next)
     {
-        if (strcmp(curr->path, path) == 0)
+        if (curr->hash == hash && strcmp(curr->path, path) == 0)
         {
-            if (out_prev)
-            {
-                *out_prev = prev;
-            }
             return curr;
         }
-        prev = curr;
-        curr = curr->next;
-    }
-
-    if (out_prev)
-    {
-        *out_prev = NULL;
     }
 
     return NULL;
 }
 
-static file_lock_entry_t *file_lock_get_or_create(const char *path)
+static file_lock_entry_t *file_lock_get_or_create(file_lock_shard_t *shard, const char *path, uint64_t hash)
 {
-    file_lock_entry_t *entry = file_lock_find(path, NULL);
+    file_lock_entry_t *entry = file_lock_find(shard, path, hash);
     if (entry)
     {
         return entry;
     }
 
-    entry = (file_lock_entry_t *)calloc(1, sizeof(file_lock_entry_t));
-    if (!entry)
+    if (shard->pool)
     {
-        LOG_ERROR("Failed to allocate memory for file lock entry");
-        return NULL;
+        entry = shard->pool;
+        shard->pool = entry->next;
+        shard->pool_count--;
     }
-
-    strncpy(entry->path, path, sizeof(entry->path) - 1);
-    entry->path[sizeof(entry->path) - 1] = '\0';
-
-    if (pthread_cond_init(&entry->cond, NULL) != 0)
+    else
     {
-        LOG_ERROR("Failed to initialize condition variable for file lock");
-        free(entry);
-        return NULL;
+        entry = (file_lock_entry_t *)malloc(sizeof(file_lock_entry_t));
+        if (!entry)
+        {
+            LOG_ERROR("Failed to allocate memory for file lock entry");
+            return NULL;
+        }
+
+        if (pthread_cond_init(&entry->cond, NULL) != 0)
+        {
+            LOG_ERROR("Failed to initialize condition variable for file lock");
+            free(entry);
+            return NULL;
+        }
     }
 
-    entry->next = g_file_lock_entries;
-    g_file_lock_entries = entry;
+    strncpy(entry->path, path, sizeof(entry->path) - 1);
+    entry->path[sizeof(entry->path) - 1] = '\0';
+    entry->hash = hash;
+    ATOMIC_STORE_RELAXED(&entry->readers, 0);
+    entry->writers = 0;
+    entry->waiting_readers = 0;
+    entry->waiting_writers = 0;
+
+    file_lock_entry_t **bucket = file_lock_bucket(shard, hash);
+    entry->next = *bucket;
+    *bucket = entry;
     return entry;
 }
 
-static void file_lock_remove_entry(file_lock_entry_t *entry, file_lock_entry_t *prev)
+/**
+ * @brief Unlinks an entry once nobody holds or waits for it, recycling it into the pool
+ */
+static void file_lock_release_entry_if_unused(file_lock_shard_t *shard, file_lock_entry_t *entry)
 {
-    if (!entry)
+    if (ATOMIC_LOAD(&entry->readers) != 0 || entry->writers != 0 ||
+        entry->waiting_readers != 0 || entry->waiting_writers != 0)
     {
         return;
     }
 
-    if (prev)
+    file_lock_entry_t **link = file_lock_bucket(shard, entry->hash);
+    while (*link && *link != entry)
     {
-        prev->next = entry->next;
+        link = &(*link)->next;
     }
-    else
+    if (*link)
     {
-        g_file_lock_entries = entry->next;
+        *link = entry->next;
     }
 
-    pthread_cond_destroy(&entry->cond);
-    free(entry);
+    if (shard->pool_count < FILE_LOCK_POOL_PER_SHARD)
+    {
+        entry->next = shard->pool;
+        shard->pool = entry;
+        shard->pool_count++;
+    }
+    else
+    {
+        pthread_cond_destroy(&entry->cond);
+        free(entry);
+    }
 }
 
 int file_lock_acquire_shared(const char *path)
@@ -125,55 +213,73 @@ int file_lock_acquire_shared(const char *path)
         return -1;
     }
 
-    pthread_mutex_lock(&g_file_lock_mutex);
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
 
-    file_lock_entry_t *entry = file_lock_get_or_create(path);
+    file_lock_entry_t *entry = file_lock_get_or_create(shard, path, hash);
     if (!entry)
     {
-        pthread_mutex_unlock(&g_file_lock_mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
-    while (entry->writers > 0 || entry->waiting_writers > 0)
+    // Counted as waiting so a release does not recycle the entry under us
+    entry->waiting_readers++;
+
+    long long waited_us = 0;
+    if (entry->writers > 0 || entry->waiting_writers > 0)
     {
-        pthread_cond_wait(&entry->cond, &g_file_lock_mutex);
+        long long start = metrics_now_us();
+        while (entry->writers > 0 || entry->waiting_writers > 0)
+        {
+            pthread_cond_wait(&entry->cond, &shard->mutex);
+        }
+        waited_us = metrics_now_us() - start;
     }
 
-    entry->readers++;
+    entry->waiting_readers--;
+    ATOMIC_FETCH_ADD(&entry->readers, 1);
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
+    pthread_mutex_unlock(&shard->mutex);
+    metrics_observe_latency(METRICS_FILE_LOCK_WAIT, waited_us);
     return 0;
 }
 
-int file_lock_try_acquire_shared(const char *path)
+file_lock_t *file_lock_try_acquire_shared_handle(const char *path)
 {
     if (!file_lock_path_valid(path))
     {
-        return -1;
+        return NULL;
     }
 
-    pthread_mutex_lock(&g_file_lock_mutex);
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
 
-    file_lock_entry_t *entry = file_lock_get_or_create(path);
+    file_lock_entry_t *entry = file_lock_get_or_create(shard, path, hash);
     if (!entry)
     {
-        pthread_mutex_unlock(&g_file_lock_mutex);
-        return -1;
+        pthread_mutex_unlock(&shard->mutex);
+        return NULL;
     }
 
     // Check if lock is available (no writers and no waiting writers)
     if (entry->writers > 0 || entry->waiting_writers > 0)
     {
         // Lock is busy, return immediately
-        pthread_mutex_unlock(&g_file_lock_mutex);
-        return -1;
+        pthread_mutex_unlock(&shard->mutex);
+        return NULL;
     }
 
     // Lock is available, acquire it
-    entry->readers++;
+    ATOMIC_FETCH_ADD(&entry->readers, 1);
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
-    return 0;
+    pthread_mutex_unlock(&shard->mutex);
+    return entry;
+}
+
+int file_lock_try_acquire_shared(const char *path)
+{
+    return file_lock_try_acquire_shared_handle(path) ? 0 : -1;
 }
 
 int file_lock_acquire_exclusive(const char *path)
@@ -183,26 +289,34 @@ int file_lock_acquire_exclusive(const char *path)
         return -1;
     }
 
-    pthread_mutex_lock(&g_file_lock_mutex);
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
 
-    file_lock_entry_t *entry = file_lock_get_or_create(path);
+    file_lock_entry_t *entry = file_lock_get_or_create(shard, path, hash);
     if (!entry)
     {
-        pthread_mutex_unlock(&g_file_lock_mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
     entry->waiting_writers++;
 
-    while (entry->writers > 0 || entry->readers > 0)
+    long long waited_us = 0;
+    if (entry->writers > 0 || ATOMIC_LOAD(&entry->readers) > 0)
     {
-        pthread_cond_wait(&entry->cond, &g_file_lock_mutex);
+        long long start = metrics_now_us();
+        while (entry->writers > 0 || ATOMIC_LOAD(&entry->readers) > 0)
+        {
+            pthread_cond_wait(&entry->cond, &shard->mutex);
+        }
+        waited_us = metrics_now_us() - start;
     }
 
     entry->waiting_writers--;
     entry->writers = 1;
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
+    pthread_mutex_unlock(&shard->mutex);
+    metrics_observe_latency(METRICS_FILE_LOCK_WAIT, waited_us);
     return 0;
 }
 
@@ -213,76 +327,86 @@ int file_lock_try_acquire_exclusive(const char *path)
         return -1;
     }
 
-    pthread_mutex_lock(&g_file_lock_mutex);
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
 
-    file_lock_entry_t *entry = file_lock_get_or_create(path);
+    file_lock_entry_t *entry = file_lock_get_or_create(shard, path, hash);
     if (!entry)
     {
-        pthread_mutex_unlock(&g_file_lock_mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
     // Check if lock is available (no readers and no writers)
-    if (entry->writers > 0 || entry->readers > 0)
+    if (entry->writers > 0 || ATOMIC_LOAD(&entry->readers) > 0)
     {
         // Lock is busy, return immediately
-        pthread_mutex_unlock(&g_file_lock_mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return -1;
     }
 
     // Lock is available, acquire it
     entry->writers = 1;
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
+    pthread_mutex_unlock(&shard->mutex);
     return 0;
 }
 
-static void file_lock_release_common(const char *path, int exclusive)
+/**
+ * @brief Releases a lock on an entry found under the locked shard, then unlocks the shard
+ */
+static void file_lock_release_locked(file_lock_shard_t *shard, file_lock_entry_t *entry, int exclusive)
 {
-    if (!file_lock_path_valid(path))
-    {
-        return;
-    }
-
-    pthread_mutex_lock(&g_file_lock_mutex);
-
-    file_lock_entry_t *prev = NULL;
-    file_lock_entry_t *entry = file_lock_find(path, &prev);
-    if (!entry)
-    {
-        pthread_mutex_unlock(&g_file_lock_mutex);
-        LOG_WARN("Attempted to release non-existent file lock for '%s'", path);
-        return;
-    }
-
     if (exclusive)
     {
         if (entry->writers == 0)
         {
-            LOG_WARN("Release exclusive lock called without writer for '%s'", path);
+            LOG_WARN("Release exclusive lock called without writer for '%s'", entry->path);
         }
         entry->writers = 0;
     }
     else
     {
-        if (entry->readers == 0)
+        if (ATOMIC_LOAD(&entry->readers) == 0)
         {
-            LOG_WARN("Release shared lock called with no readers for '%s'", path);
+            LOG_WARN("Release shared lock called with no readers for '%s'", entry->path);
         }
         else
         {
-            entry->readers--;
+            ATOMIC_FETCH_SUB(&entry->readers, 1);
         }
     }
 
-    pthread_cond_broadcast(&entry->cond);
+    // Only wake waiters if someone is actually blocked on this path
+    if (entry->waiting_readers > 0 || entry->waiting_writers > 0)
+    {
+        pthread_cond_broadcast(&entry->cond);
+    }
+
+    file_lock_release_entry_if_unused(shard, entry);
 
-    if (entry->readers == 0 && entry->writers == 0 && entry->waiting_writers == 0)
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+static void file_lock_release_common(const char *path, int exclusive)
+{
+    if (!file_lock_path_valid(path))
     {
-        file_lock_remove_entry(entry, prev);
+        return;
     }
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
+
+    file_lock_entry_t *entry = file_lock_find(shard, path, hash);
+    if (!entry)
+    {
+        pthread_mutex_unlock(&shard->mutex);
+        LOG_WARN("Attempted to release non-existent file lock for '%s'", path);
+        return;
+    }
+
+    file_lock_release_locked(shard, entry, exclusive);
 }
 
 void file_lock_release_shared(const char *path)
@@ -290,6 +414,30 @@ void file_lock_release_shared(const char *path)
     file_lock_release_common(path, 0);
 }
 
+void file_lock_release_shared_handle(file_lock_t *lock)
+{
+    if (!lock)
+    {
+        return;
+    }
+
+    // Readers that are not the last change nothing a waiter looks at. Readers are only
+    // added under the shard mutex and the entry is only recycled at zero, so it stays
+    // valid while the count is above one and no lookup is needed.
+    unsigned int readers = ATOMIC_LOAD_RELAXED(&lock->readers);
+    while (readers > 1)
+    {
+        if (ATOMIC_CAS_WEAK(&lock->readers, &readers, readers - 1))
+        {
+            return;
+        }
+    }
+
+    // The last reader may have to wake a writer and recycle the entry
+    file_lock_shard_t *shard = file_lock_shard_lock(lock->hash);
+    file_lock_release_locked(shard, lock, 0);
+}
+
 void file_lock_release_exclusive(const char *path)
 {
     file_lock_release_common(path, 1);
@@ -302,18 +450,13 @@ int file_lock_is_exclusive_locked(const char *path)
         return -1;
     }
 
-    pthread_mutex_lock(&g_file_lock_mutex);
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
 
-    file_lock_entry_t *entry = file_lock_find(path, NULL);
-    if (!entry)
-    {
-        pthread_mutex_unlock(&g_file_lock_mutex);
-        return 0; // No lock entry
-    }
-
-    int result = (entry->writers > 0) ? 1 : 0;
+    file_lock_entry_t *entry = file_lock_find(shard, path, hash);
+    int result = (entry && entry->writers > 0) ? 1 : 0;
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
+    pthread_mutex_unlock(&shard->mutex);
     return result;
 }
 
@@ -324,17 +467,12 @@ int file_lock_get_shared_lock_count(const char *path)
         return -1;
     }
 
-    pthread_mutex_lock(&g_file_lock_mutex);
-
-    file_lock_entry_t *entry = file_lock_find(path, NULL);
-    if (!entry)
-    {
-        pthread_mutex_unlock(&g_file_lock_mutex);
-        return 0; // No lock entry
-    }
+    uint64_t hash = file_lock_hash(path);
+    file_lock_shard_t *shard = file_lock_shard_lock(hash);
 
-    int result = entry->readers;
+    file_lock_entry_t *entry = file_lock_find(shard, path, hash);
+    int result = entry ? (int)ATOMIC_LOAD(&entry->readers) : 0;
 
-    pthread_mutex_unlock(&g_file_lock_mutex);
+    pthread_mutex_unlock(&shard->mutex);
     return result;
 }
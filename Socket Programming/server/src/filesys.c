@@ -6,12 +6,17 @@
  * @date 2025-11-3
  *
  */
-#define _XOPEN_SOURCE 500
+#ifdef __linux__
+#define _GNU_SOURCE // fallocate(), sync_file_range()
+#endif
+#define _XOPEN_SOURCE 700
 #include "filesys.h"
+#include "fswalk.h"
 
 #include <limits.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -27,13 +32,14 @@
 #include <sys/types.h>
 #include <pwd.h>
 #include <grp.h>
+#include <pthread.h>
 #endif
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096
 #endif
 
-// Maximum recursion depth to prevent stack overflow and infinite loops
+// Maximum directory depth walked, guards against runaway trees
 #define MAX_RECURSION_DEPTH 256
 
 int fs_join_path(char *dest, long long dest_size, const char *dir, const char *name)
@@ -173,122 +179,108 @@ time_t fs_get_file_mtime(const char *path)
 }
 
 #ifdef _WIN32
-static long long dir_size_recursive_win32(const char *path, int depth)
+/**
+ * @brief Fills a stat snapshot from Windows attributes.
+ * @param attributes File attributes
+ * @param size_high High part of the size
+ * @param size_low Low part of the size
+ * @param mtime Last write time
+ * @param st Output metadata
+ */
+static void fs_fill_stat_win32(DWORD attributes, DWORD size_high, DWORD size_low, FILETIME mtime, fs_stat_t *st)
 {
-    if (depth > MAX_RECURSION_DEPTH)
-        return -1;
-
-    long long total = 0;
-    char search_path[PATH_MAX];
-
-    // Create search pattern: path\*
-    if (fs_join_path(search_path, PATH_MAX, path, "*") != 0)
-        return -1;
-
-    WIN32_FIND_DATAA find_data;
-    HANDLE hFind = FindFirstFileA(search_path, &find_data);
-
-    if (hFind == INVALID_HANDLE_VALUE)
-        return -1;
-
-    do
+    st->type = (attributes & FILE_ATTRIBUTE_DIRECTORY) ? FS_TYPE_DIR : FS_TYPE_FILE;
+    if (st->type == FS_TYPE_FILE)
     {
-        // Skip . and ..
-        if (strcmp(find_data.cFileName, ".") == 0 ||
-            strcmp(find_data.cFileName, "..") == 0)
-            continue;
-
-        char child_path[PATH_MAX];
-        if (fs_join_path(child_path, PATH_MAX, path, find_data.cFileName) != 0)
-        {
-            FindClose(hFind);
-            return -1;
-        }
-
-        // Skip reparse points (symbolic links, junctions, etc.) to avoid loops
-        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
-            continue;
-
-        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-        {
-            // Recurse into subdirectory
-            long long s = dir_size_recursive_win32(child_path, depth + 1);
-            if (s < 0)
-            {
-                FindClose(hFind);
-                return -1;
-            }
-            total += s;
-        }
-        else
-        {
-            // Regular file - add its size
-            LARGE_INTEGER file_size;
-            file_size.HighPart = find_data.nFileSizeHigh;
-            file_size.LowPart = find_data.nFileSizeLow;
-            total += file_size.QuadPart;
-        }
-    } while (FindNextFileA(hFind, &find_data));
+        LARGE_INTEGER size;
+        size.HighPart = size_high;
+        size.LowPart = size_low;
+        st->size = (long long)size.QuadPart;
+    }
+    else
+    {
+        st->size = 0;
+    }
 
-    FindClose(hFind);
-    return total;
+    // FILETIME is in 100-nanosecond intervals since January 1, 1601
+    ULARGE_INTEGER ull;
+    ull.LowPart = mtime.dwLowDateTime;
+    ull.HighPart = mtime.dwHighDateTime;
+    st->last_modified = (time_t)((ull.QuadPart / 10000000ULL) - 11644473600ULL);
+    st->file_id = 0; // Only known for open files, see fs_file_stat()
 }
 #else
-static long long dir_size_recursive(const char *path, int depth)
+/**
+ * @brief Fills a stat snapshot from a struct stat.
+ * @param native Result of stat()/fstat()
+ * @param st Output metadata
+ */
+static void fs_fill_stat(const struct stat *native, fs_stat_t *st)
+{
+    if (S_ISDIR(native->st_mode))
+        st->type = FS_TYPE_DIR;
+    else if (S_ISREG(native->st_mode))
+        st->type = FS_TYPE_FILE;
+    else
+        st->type = FS_TYPE_UNKNOWN;
+
+    st->size = S_ISREG(native->st_mode) ? (long long)native->st_size : 0;
+    st->last_modified = native->st_mtime;
+    st->file_id = (unsigned long long)native->st_ino;
+}
+#endif
+
+int fs_stat(const char *path, fs_stat_t *st)
 {
-    if (depth > MAX_RECURSION_DEPTH)
+    if (path == NULL || st == NULL)
+        return -1;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &fileInfo))
         return -1;
 
-    long long total = 0;
-    DIR *d = opendir(path);
-    if (!d)
+    fs_fill_stat_win32(fileInfo.dwFileAttributes, fileInfo.nFileSizeHigh, fileInfo.nFileSizeLow,
+                       fileInfo.ftLastWriteTime, st);
+    return 0;
+#else
+    struct stat native;
+    if (stat(path, &native) != 0)
         return -1;
 
-    struct dirent *entry;
-    while ((entry = readdir(d)) != NULL)
-    {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
+    fs_fill_stat(&native, st);
+    return 0;
+#endif
+}
 
-        char childpath[PATH_MAX];
-        if (fs_join_path(childpath, PATH_MAX, path, entry->d_name) != 0)
-        {
-            closedir(d);
-            return -1;
-        }
+// Per-worker running total, padded to its own cache line
+typedef struct
+{
+    long long total;
+    char padding[64 - sizeof(long long)];
+} dir_size_slot_t;
 
-        struct stat st;
-        // Use lstat to not follow symbolic links
-        if (lstat(childpath, &st) != 0)
-        {
-            closedir(d);
-            return -1;
-        }
+static int dir_size_visitor(const fswalk_entry_t *entry, void *arg)
+{
+    dir_size_slot_t *slots = (dir_size_slot_t *)arg;
+    if (entry->visit == FSWALK_VISIT_ENTRY && entry->type == FS_TYPE_FILE)
+        slots[entry->worker].total += entry->size;
+    return FSWALK_CONTINUE;
+}
 
-        // Skip symbolic links to avoid infinite loops
-        if (S_ISLNK(st.st_mode))
-            continue;
+static long long dir_size_walk(const char *path)
+{
+    dir_size_slot_t slots[FSWALK_MAX_THREADS];
+    memset(slots, 0, sizeof(slots));
 
-        if (S_ISDIR(st.st_mode))
-        {
-            long long s = dir_size_recursive(childpath, depth + 1);
-            if (s < 0)
-            {
-                closedir(d);
-                return -1;
-            }
-            total += s;
-        }
-        else if (S_ISREG(st.st_mode))
-        {
-            total += (long long)st.st_size;
-        }
-    }
+    fswalk_options_t options = {0, FSWALK_STAT, MAX_RECURSION_DEPTH, NULL};
+    if (fswalk_run(path, &options, dir_size_visitor, slots) != 0)
+        return -1;
 
-    closedir(d);
+    long long total = 0;
+    for (int i = 0; i < FSWALK_MAX_THREADS; i++)
+        total += slots[i].total;
     return total;
 }
-#endif
 
 long long fs_get_directory_size(const char *path)
 {
@@ -302,7 +294,7 @@ long long fs_get_directory_size(const char *path)
     if (!(attr & FILE_ATTRIBUTE_DIRECTORY))
         return -1;
 
-    return dir_size_recursive_win32(path, 0);
+    return dir_size_walk(path);
 #else
     struct stat st;
     // Use lstat to check if path itself is a symlink
@@ -312,288 +304,449 @@ long long fs_get_directory_size(const char *path)
     if (!S_ISDIR(st.st_mode))
         return -1;
 
-    return dir_size_recursive(path, 0);
+    return dir_size_walk(path);
 #endif
 }
 
-int fs_list_directory(const char *path, fs_file_info_t *file_list, int max_files)
-{
-    if (path == NULL || file_list == NULL || max_files <= 0)
-        return -1;
 #ifdef _WIN32
-    char search_path[PATH_MAX];
-    if (fs_join_path(search_path, PATH_MAX, path, "*") != 0)
-        return -1;
-
-    WIN32_FIND_DATAA find_data;
-    HANDLE hFind = FindFirstFileA(search_path, &find_data);
-
-    if (hFind == INVALID_HANDLE_VALUE)
-        return -1;
+/**
+ * @brief Fills file information from a FindFirstFile/FindNextFile record.
+ * @param dirpath Directory containing the entry
+ * @param find_data Directory record
+ * @param info Output file information
+ */
+static void fs_fill_info_win32(const char *dirpath, const WIN32_FIND_DATAA *find_data, fs_file_info_t *info)
+{
+    strncpy(info->name, find_data->cFileName, MAX_FILENAME_LEN - 1);
+    info->name[MAX_FILENAME_LEN - 1] = '\0';
+
+    // Determine file type
+    if (find_data->dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+        info->type = FS_TYPE_SYMLINK;
+    else if (find_data->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        info->type = FS_TYPE_DIR;
+    else
+        info->type = FS_TYPE_FILE;
 
-    int count = 0;
-    do
+    // Get file size (for regular files and symlinks)
+    if (info->type == FS_TYPE_FILE || info->type == FS_TYPE_SYMLINK)
     {
-        // Skip . and ..
-        if (strcmp(find_data.cFileName, ".") == 0 ||
-            strcmp(find_data.cFileName, "..") == 0)
-            continue;
-
-        if (count >= max_files)
-            break;
-
-        // Fill file_list[count]
-        strncpy(file_list[count].name, find_data.cFileName, MAX_FILENAME_LEN - 1);
-        file_list[count].name[MAX_FILENAME_LEN - 1] = '\0';
-
-        // Determine file type
-        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
-            file_list[count].type = FS_TYPE_SYMLINK;
-        else if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-            file_list[count].type = FS_TYPE_DIR;
-        else
-            file_list[count].type = FS_TYPE_FILE;
-
-        // Get file size (for regular files and symlinks)
-        if (file_list[count].type == FS_TYPE_FILE || file_list[count].type == FS_TYPE_SYMLINK)
-        {
-            LARGE_INTEGER file_size;
-            file_size.HighPart = find_data.nFileSizeHigh;
-            file_size.LowPart = find_data.nFileSizeLow;
-            file_list[count].size = file_size.QuadPart;
-        }
-        else
-        {
-            file_list[count].size = 0;
-        }
+        LARGE_INTEGER file_size;
+        file_size.HighPart = find_data->nFileSizeHigh;
+        file_size.LowPart = find_data->nFileSizeLow;
+        info->size = file_size.QuadPart;
+    }
+    else
+    {
+        info->size = 0;
+    }
 
-        // Get last modification time
-        FILETIME ft = find_data.ftLastWriteTime;
-        SYSTEMTIME st_utc, st_local;
-        FileTimeToSystemTime(&ft, &st_utc);
-        SystemTimeToTzSpecificLocalTime(NULL, &st_utc, &st_local);
-
-        struct tm tm_info = {
-            .tm_year = st_local.wYear - 1900,
-            .tm_mon = st_local.wMonth - 1,
-            .tm_mday = st_local.wDay,
-            .tm_hour = st_local.wHour,
-            .tm_min = st_local.wMinute,
-            .tm_sec = st_local.wSecond,
-            .tm_isdst = -1 // Let mktime determine DST
-        };
-        file_list[count].last_modified = mktime(&tm_info);
-
-        // Build full path for additional operations
-        char child_path[PATH_MAX];
-        fs_join_path(child_path, PATH_MAX, path, find_data.cFileName);
-
-        // Set mode (permissions) for Windows
-        file_list[count].mode = 0;
-        if (file_list[count].type == FS_TYPE_DIR)
+    // Get last modification time
+    FILETIME ft = find_data->ftLastWriteTime;
+    SYSTEMTIME st_utc, st_local;
+    FileTimeToSystemTime(&ft, &st_utc);
+    SystemTimeToTzSpecificLocalTime(NULL, &st_utc, &st_local);
+
+    struct tm tm_info = {
+        .tm_year = st_local.wYear - 1900,
+        .tm_mon = st_local.wMonth - 1,
+        .tm_mday = st_local.wDay,
+        .tm_hour = st_local.wHour,
+        .tm_min = st_local.wMinute,
+        .tm_sec = st_local.wSecond,
+        .tm_isdst = -1 // Let mktime determine DST
+    };
+    info->last_modified = mktime(&tm_info);
+
+    // Build full path for additional operations
+    char child_path[PATH_MAX];
+    fs_join_path(child_path, PATH_MAX, dirpath, find_data->cFileName);
+
+    // Set mode (permissions) for Windows
+    info->mode = 0;
+    if (info->type == FS_TYPE_DIR)
+    {
+        info->mode = S_IFDIR | S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+        // Directories are writable unless read-only
+        if (!(find_data->dwFileAttributes & FILE_ATTRIBUTE_READONLY))
         {
-            file_list[count].mode = S_IFDIR | S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
-            // Directories are writable unless read-only
-            if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_READONLY))
-            {
-                file_list[count].mode |= S_IWUSR;
-            }
+            info->mode |= S_IWUSR;
         }
-        else if (file_list[count].type == FS_TYPE_FILE)
-        {
-            file_list[count].mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
-
-            // Check if file is writable
-            if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_READONLY))
-            {
-                file_list[count].mode |= S_IWUSR;
-            }
+    }
+    else if (info->type == FS_TYPE_FILE)
+    {
+        info->mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
 
-            // Check if file is executable (by extension)
-            const char *ext = strrchr(find_data.cFileName, '.');
-            if (ext != NULL)
-            {
-                if (_stricmp(ext, ".exe") == 0 || _stricmp(ext, ".bat") == 0 ||
-                    _stricmp(ext, ".cmd") == 0 || _stricmp(ext, ".com") == 0)
-                {
-                    file_list[count].mode |= S_IXUSR | S_IXGRP | S_IXOTH;
-                }
-            }
-        }
-        else if (file_list[count].type == FS_TYPE_SYMLINK)
+        // Check if file is writable
+        if (!(find_data->dwFileAttributes & FILE_ATTRIBUTE_READONLY))
         {
-            file_list[count].mode = S_IFLNK | S_IRWXU | S_IRWXG | S_IRWXO;
+            info->mode |= S_IWUSR;
         }
 
-        // Get actual hard link count
-        file_list[count].nlink = 1; // Default
-        HANDLE hFile = CreateFileA(child_path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE,
-                                   NULL, OPEN_EXISTING,
-                                   FILE_FLAG_BACKUP_SEMANTICS, NULL);
-        if (hFile != INVALID_HANDLE_VALUE)
+        // Check if file is executable (by extension)
+        const char *ext = strrchr(find_data->cFileName, '.');
+        if (ext != NULL)
         {
-            BY_HANDLE_FILE_INFORMATION fileInfo;
-            if (GetFileInformationByHandle(hFile, &fileInfo))
+            if (_stricmp(ext, ".exe") == 0 || _stricmp(ext, ".bat") == 0 ||
+                _stricmp(ext, ".cmd") == 0 || _stricmp(ext, ".com") == 0)
             {
-                file_list[count].nlink = fileInfo.nNumberOfLinks;
+                info->mode |= S_IXUSR | S_IXGRP | S_IXOTH;
             }
-            CloseHandle(hFile);
         }
+    }
+    else if (info->type == FS_TYPE_SYMLINK)
+    {
+        info->mode = S_IFLNK | S_IRWXU | S_IRWXG | S_IRWXO;
+    }
 
-        // Use non-zero default values for uid/gid
-        file_list[count].uid = 1000; // Default user ID
-        file_list[count].gid = 1000; // Default group ID
-
-        // Symlinks
-        file_list[count].link_target[0] = '\0';
-        if (file_list[count].type == FS_TYPE_SYMLINK)
+    // Get actual hard link count
+    info->nlink = 1; // Default
+    HANDLE hFile = CreateFileA(child_path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                               NULL, OPEN_EXISTING,
+                               FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        BY_HANDLE_FILE_INFORMATION fileInfo;
+        if (GetFileInformationByHandle(hFile, &fileInfo))
         {
-            // Reading reparse points on Windows is complex and requires additional APIs
-            // For now, leave it empty - could be enhanced later
-            file_list[count].link_target[0] = '\0';
+            info->nlink = fileInfo.nNumberOfLinks;
         }
+        CloseHandle(hFile);
+    }
 
-        count++;
-    } while (FindNextFileA(hFind, &find_data));
+    // Use non-zero default values for uid/gid
+    info->uid = 1000; // Default user ID
+    info->gid = 1000; // Default group ID
 
-    FindClose(hFind);
-    return count;
+    // Symlinks
+    info->link_target[0] = '\0';
+    if (info->type == FS_TYPE_SYMLINK)
+    {
+        // Reading reparse points on Windows is complex and requires additional APIs
+        // For now, leave it empty - could be enhanced later
+        info->link_target[0] = '\0';
+    }
+}
 #else
-    DIR *d = opendir(path);
-    if (!d)
+/**
+ * @brief Fills file information for an entry relative to an open directory.
+ *
+ * Uses fstatat()/readlinkat() so the kernel does not resolve the full path
+ * again for every entry.
+ *
+ * @param dir_fd Descriptor of the containing directory
+ * @param name Entry name
+ * @param info Output file information
+ * @return 0 on success, -1 if the entry cannot be stat'ed
+ */
+static int fs_fill_info_at(int dir_fd, const char *name, fs_file_info_t *info)
+{
+    struct stat st;
+    // AT_SYMLINK_NOFOLLOW to get info about symlinks themselves
+    if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
         return -1;
 
-    struct dirent *entry;
-    int count = 0;
-    while ((entry = readdir(d)) != NULL && count < max_files)
-    {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
-
-        char childpath[PATH_MAX];
-        if (fs_join_path(childpath, PATH_MAX, path, entry->d_name) != 0)
-            continue; // skip overly long names
+    strncpy(info->name, name, MAX_FILENAME_LEN - 1);
+    info->name[MAX_FILENAME_LEN - 1] = '\0';
 
-        struct stat st;
-        // Use lstat to get info about symlinks themselves
-        if (lstat(childpath, &st) != 0)
-            continue; // skip entries we can't stat
-
-        // fill file_list[count]
-        strncpy(file_list[count].name, entry->d_name, MAX_FILENAME_LEN - 1);
-        file_list[count].name[MAX_FILENAME_LEN - 1] = '\0';
-
-        if (S_ISLNK(st.st_mode))
-            file_list[count].type = FS_TYPE_SYMLINK;
-        else if (S_ISDIR(st.st_mode))
-            file_list[count].type = FS_TYPE_DIR;
-        else if (S_ISREG(st.st_mode))
-            file_list[count].type = FS_TYPE_FILE;
-        else
-            file_list[count].type = FS_TYPE_UNKNOWN;
-
-        // For regular files and symlinks, record the size
-        // For symlinks, st_size represents the length of the target path
-        file_list[count].size = (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) ? (long long)st.st_size : 0;
-        file_list[count].last_modified = st.st_mtime; // Set last modified time
-        file_list[count].mode = st.st_mode;
-        file_list[count].nlink = st.st_nlink;
-        file_list[count].uid = st.st_uid;
-        file_list[count].gid = st.st_gid;
-
-        // For symbolic links, read the target path
-        if (S_ISLNK(st.st_mode))
-        {
-            ssize_t len = readlink(childpath, file_list[count].link_target, sizeof(file_list[count].link_target) - 1);
-            if (len != -1)
-            {
-                file_list[count].link_target[len] = '\0';
-            }
-            else
-            {
-                file_list[count].link_target[0] = '\0'; // Error or not a symlink
-            }
-        }
-        else
+    if (S_ISLNK(st.st_mode))
+        info->type = FS_TYPE_SYMLINK;
+    else if (S_ISDIR(st.st_mode))
+        info->type = FS_TYPE_DIR;
+    else if (S_ISREG(st.st_mode))
+        info->type = FS_TYPE_FILE;
+    else
+        info->type = FS_TYPE_UNKNOWN;
+
+    // For regular files and symlinks, record the size
+    // For symlinks, st_size represents the length of the target path
+    info->size = (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) ? (long long)st.st_size : 0;
+    info->last_modified = st.st_mtime; // Set last modified time
+    info->mode = st.st_mode;
+    info->nlink = st.st_nlink;
+    info->uid = st.st_uid;
+    info->gid = st.st_gid;
+
+    // For symbolic links, read the target path
+    info->link_target[0] = '\0';
+    if (S_ISLNK(st.st_mode))
+    {
+        ssize_t len = readlinkat(dir_fd, name, info->link_target, sizeof(info->link_target) - 1);
+        if (len != -1)
         {
-            file_list[count].link_target[0] = '\0'; // Not a symlink
+            info->link_target[len] = '\0';
         }
-
-        count++;
     }
 
-    closedir(d);
-    return count;
-#endif
+    return 0;
 }
+#endif
 
-const char *fs_extract_filename(const char *path)
+/**
+ * @brief Open directory stream state
+ */
+struct fs_dir
+{
+    int flags;
+#ifdef _WIN32
+    char path[PATH_MAX];
+    HANDLE find;
+    WIN32_FIND_DATAA find_data;
+    int has_pending; // find_data holds an entry not yet returned
+#else
+    DIR *d;
+#endif
+};
+
+fs_dir_t *fs_dir_open(const char *path, int flags)
 {
     if (path == NULL)
         return NULL;
 
-    // Find the last path separator
-    const char *filename = strrchr(path, '/');
+    fs_dir_t *dir = (fs_dir_t *)calloc(1, sizeof(fs_dir_t));
+    if (dir == NULL)
+        return NULL;
+    dir->flags = flags;
+
 #ifdef _WIN32
-    const char *backslash = strrchr(path, '\\');
-    if (!filename || (backslash && backslash > filename)) // use the rightmost separator
-        filename = backslash;
-#endif
+    char search_path[PATH_MAX];
+    if (fs_join_path(search_path, PATH_MAX, path, "*") != 0)
+    {
+        free(dir);
+        return NULL;
+    }
+    snprintf(dir->path, sizeof(dir->path), "%s", path);
 
-    if (filename)
-        return filename + 1;
-    else
+    dir->find = FindFirstFileA(search_path, &dir->find_data);
+    if (dir->find == INVALID_HANDLE_VALUE)
     {
-        // Check relative path or root
-#ifdef _WIN32
-        if (strlen(path) == 2 && path[1] == ':')
-            return ""; // e.g., "C:"
-        else
-            return path;
+        free(dir);
+        return NULL;
+    }
+    dir->has_pending = 1;
 #else
-        return path;
-#endif
+    dir->d = opendir(path);
+    if (dir->d == NULL)
+    {
+        free(dir);
+        return NULL;
     }
+#endif
+
+    return dir;
 }
 
-long long fs_read_file_all(const char *path, void *buffer, long long buffer_size)
+int fs_dir_next(fs_dir_t *dir, fs_file_info_t *info)
 {
-    if (path == NULL || buffer == NULL || buffer_size <= 0)
+    if (dir == NULL || info == NULL)
         return -1;
 #ifdef _WIN32
-    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
-                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-
-    if (hFile == INVALID_HANDLE_VALUE)
-        return -1;
-
-    LARGE_INTEGER file_size;
-    if (!GetFileSizeEx(hFile, &file_size))
+    for (;;)
     {
-        CloseHandle(hFile);
-        return -1;
-    }
+        if (!dir->has_pending)
+        {
+            if (!FindNextFileA(dir->find, &dir->find_data))
+                return GetLastError() == ERROR_NO_MORE_FILES ? 0 : -1;
+        }
+        dir->has_pending = 0;
 
-    long long to_read = file_size.QuadPart;
-    if (to_read > buffer_size)
-        to_read = buffer_size;
+        // Skip . and ..
+        if (strcmp(dir->find_data.cFileName, ".") == 0 ||
+            strcmp(dir->find_data.cFileName, "..") == 0)
+            continue;
 
-    long long total = 0;
-    while (total < to_read)
+        if (dir->flags & FS_DIR_NAMES_ONLY)
+        {
+            memset(info, 0, sizeof(*info));
+            strncpy(info->name, dir->find_data.cFileName, MAX_FILENAME_LEN - 1);
+            info->name[MAX_FILENAME_LEN - 1] = '\0';
+            if (dir->find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+                info->type = FS_TYPE_SYMLINK;
+            else if (dir->find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                info->type = FS_TYPE_DIR;
+            else
+                info->type = FS_TYPE_FILE;
+            return 1;
+        }
+
+        fs_fill_info_win32(dir->path, &dir->find_data, info);
+        return 1;
+    }
+#else
+    for (;;)
     {
-        DWORD bytes_to_read = (DWORD)((to_read - total) > MAXDWORD ? MAXDWORD : (to_read - total));
-        DWORD bytes_read = 0;
+        errno = 0;
+        struct dirent *entry = readdir(dir->d);
+        if (entry == NULL)
+            return errno == 0 ? 0 : -1;
 
-        if (!ReadFile(hFile, (char *)buffer + total, bytes_to_read, &bytes_read, NULL))
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        if (dir->flags & FS_DIR_NAMES_ONLY)
         {
-            CloseHandle(hFile);
-            return -1;
+            // No stat at all, type is left unknown
+            strncpy(info->name, entry->d_name, MAX_FILENAME_LEN - 1);
+            info->name[MAX_FILENAME_LEN - 1] = '\0';
+            info->type = FS_TYPE_UNKNOWN;
+            info->size = 0;
+            info->last_modified = 0;
+            info->mode = 0;
+            info->nlink = 0;
+            info->uid = 0;
+            info->gid = 0;
+            info->link_target[0] = '\0';
+            return 1;
         }
 
-        if (bytes_read == 0)
-            break;
+        if (fs_fill_info_at(dirfd(dir->d), entry->d_name, info) != 0)
+            continue; // skip entries we can't stat (e.g. removed meanwhile)
 
-        total += bytes_read;
+        return 1;
+    }
+#endif
+}
+
+int fs_dir_read_batch(fs_dir_t *dir, fs_file_info_t *infos, int max_entries)
+{
+    if (dir == NULL || infos == NULL || max_entries <= 0)
+        return -1;
+
+    int count = 0;
+    while (count < max_entries)
+    {
+        int rc = fs_dir_next(dir, &infos[count]);
+        if (rc < 0)
+            return count > 0 ? count : -1;
+        if (rc == 0)
+            break;
+        count++;
+    }
+
+    return count;
+}
+
+void fs_dir_close(fs_dir_t *dir)
+{
+    if (dir == NULL)
+        return;
+#ifdef _WIN32
+    FindClose(dir->find);
+#else
+    closedir(dir->d);
+#endif
+    free(dir);
+}
+
+int fs_get_entry_info(const char *dirpath, const char *name, fs_file_info_t *info)
+{
+    if (dirpath == NULL || name == NULL || info == NULL)
+        return -1;
+#ifdef _WIN32
+    char full_path[PATH_MAX];
+    if (fs_join_path(full_path, PATH_MAX, dirpath, name) != 0)
+        return -1;
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE hFind = FindFirstFileA(full_path, &find_data);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return -1;
+    FindClose(hFind);
+
+    fs_fill_info_win32(dirpath, &find_data, info);
+    return 0;
+#else
+    int dir_fd = open(dirpath, O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0)
+        return -1;
+
+    int rc = fs_fill_info_at(dir_fd, name, info);
+    close(dir_fd);
+    return rc;
+#endif
+}
+
+int fs_list_directory(const char *path, fs_file_info_t *file_list, int max_files)
+{
+    if (path == NULL || file_list == NULL || max_files <= 0)
+        return -1;
+
+    fs_dir_t *dir = fs_dir_open(path, 0);
+    if (dir == NULL)
+        return -1;
+
+    int count = fs_dir_read_batch(dir, file_list, max_files);
+    fs_dir_close(dir);
+    return count;
+}
+
+const char *fs_extract_filename(const char *path)
+{
+    if (path == NULL)
+        return NULL;
+
+    // Find the last path separator
+    const char *filename = strrchr(path, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(path, '\\');
+    if (!filename || (backslash && backslash > filename)) // use the rightmost separator
+        filename = backslash;
+#endif
+
+    if (filename)
+        return filename + 1;
+    else
+    {
+        // Check relative path or root
+#ifdef _WIN32
+        if (strlen(path) == 2 && path[1] == ':')
+            return ""; // e.g., "C:"
+        else
+            return path;
+#else
+        return path;
+#endif
+    }
+}
+
+long long fs_read_file_all(const char *path, void *buffer, long long buffer_size)
+{
+    if (path == NULL || buffer == NULL || buffer_size <= 0)
+        return -1;
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return -1;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(hFile, &file_size))
+    {
+        CloseHandle(hFile);
+        return -1;
+    }
+
+    long long to_read = file_size.QuadPart;
+    if (to_read > buffer_size)
+        to_read = buffer_size;
+
+    long long total = 0;
+    while (total < to_read)
+    {
+        DWORD bytes_to_read = (DWORD)((to_read - total) > MAXDWORD ? MAXDWORD : (to_read - total));
+        DWORD bytes_read = 0;
+
+        if (!ReadFile(hFile, (char *)buffer + total, bytes_to_read, &bytes_read, NULL))
+        {
+            CloseHandle(hFile);
+            return -1;
+        }
+
+        if (bytes_read == 0)
+            break;
+
+        total += bytes_read;
     }
 
     CloseHandle(hFile);
@@ -830,6 +983,286 @@ long long fs_write_file_chunk(const char *path, const void *buffer, long long of
 #endif
 }
 
+int fs_file_open(fs_file_t *file, const char *path, fs_open_mode_t mode)
+{
+    if (file == NULL)
+        return -1;
+#ifdef _WIN32
+    file->handle = NULL;
+    if (path == NULL)
+        return -1;
+
+    HANDLE hFile;
+    if (mode == FS_OPEN_READ)
+        hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    else
+        hFile = CreateFileA(path, GENERIC_WRITE, 0, NULL,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return -1;
+
+    file->handle = hFile;
+    return 0;
+#else
+    file->fd = -1;
+    if (path == NULL)
+        return -1;
+
+    int fd;
+    do
+    {
+        if (mode == FS_OPEN_READ)
+            fd = open(path, O_RDONLY);
+        else
+            fd = open(path, O_WRONLY | O_CREAT, 0644);
+    } while (fd < 0 && errno == EINTR);
+
+    if (fd < 0)
+        return -1;
+
+    file->fd = fd;
+    return 0;
+#endif
+}
+
+int fs_file_is_open(const fs_file_t *file)
+{
+    if (file == NULL)
+        return 0;
+#ifdef _WIN32
+    return file->handle != NULL;
+#else
+    return file->fd >= 0;
+#endif
+}
+
+long long fs_file_read(fs_file_t *file, void *buffer, long long length)
+{
+    if (!fs_file_is_open(file) || buffer == NULL || length < 0)
+        return -1;
+#ifdef _WIN32
+    long long total = 0;
+    while (total < length)
+    {
+        DWORD bytes_to_read = (DWORD)((length - total) > MAXDWORD ? MAXDWORD : (length - total));
+        DWORD bytes_read = 0;
+
+        if (!ReadFile((HANDLE)file->handle, (char *)buffer + total, bytes_to_read, &bytes_read, NULL))
+            return -1;
+
+        if (bytes_read == 0)
+            break;
+
+        total += bytes_read;
+    }
+
+    return total;
+#else
+    long long total = 0;
+    while (total < length)
+    {
+        ssize_t r = read(file->fd, (char *)buffer + total, (size_t)(length - total));
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (r == 0)
+            break;
+        total += r;
+    }
+
+    return total;
+#endif
+}
+
+long long fs_file_write(fs_file_t *file, const void *buffer, long long length)
+{
+    if (!fs_file_is_open(file) || buffer == NULL || length < 0)
+        return -1;
+#ifdef _WIN32
+    long long total = 0;
+    while (total < length)
+    {
+        DWORD bytes_to_write = (DWORD)((length - total) > MAXDWORD ? MAXDWORD : (length - total));
+        DWORD bytes_written = 0;
+
+        if (!WriteFile((HANDLE)file->handle, (const char *)buffer + total, bytes_to_write, &bytes_written, NULL))
+            return -1;
+
+        total += bytes_written;
+    }
+
+    return total;
+#else
+    long long total = 0;
+    while (total < length)
+    {
+        ssize_t w = write(file->fd, (const char *)buffer + total, (size_t)(length - total));
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        total += w;
+    }
+
+    return total;
+#endif
+}
+
+int fs_file_seek(fs_file_t *file, long long offset)
+{
+    if (!fs_file_is_open(file) || offset < 0)
+        return -1;
+#ifdef _WIN32
+    LARGE_INTEGER li_offset;
+    li_offset.QuadPart = offset;
+    return SetFilePointerEx((HANDLE)file->handle, li_offset, NULL, FILE_BEGIN) ? 0 : -1;
+#else
+    return lseek(file->fd, (off_t)offset, SEEK_SET) == (off_t)-1 ? -1 : 0;
+#endif
+}
+
+long long fs_file_size(fs_file_t *file)
+{
+    if (!fs_file_is_open(file))
+        return -1;
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx((HANDLE)file->handle, &size))
+        return -1;
+    return (long long)size.QuadPart;
+#else
+    struct stat st;
+    if (fstat(file->fd, &st) != 0)
+        return -1;
+    return (long long)st.st_size;
+#endif
+}
+
+int fs_file_stat(fs_file_t *file, fs_stat_t *st)
+{
+    if (!fs_file_is_open(file) || st == NULL)
+        return -1;
+#ifdef _WIN32
+    BY_HANDLE_FILE_INFORMATION fileInfo;
+    if (!GetFileInformationByHandle((HANDLE)file->handle, &fileInfo))
+        return -1;
+
+    fs_fill_stat_win32(fileInfo.dwFileAttributes, fileInfo.nFileSizeHigh, fileInfo.nFileSizeLow,
+                       fileInfo.ftLastWriteTime, st);
+    st->file_id = ((unsigned long long)fileInfo.nFileIndexHigh << 32) | fileInfo.nFileIndexLow;
+    return 0;
+#else
+    struct stat native;
+    if (fstat(file->fd, &native) != 0)
+        return -1;
+
+    fs_fill_stat(&native, st);
+    return 0;
+#endif
+}
+
+int fs_file_advise(fs_file_t *file, long long offset, long long length, fs_advice_t advice)
+{
+    if (!fs_file_is_open(file) || offset < 0 || length < 0)
+        return -1;
+#if defined(_WIN32) || !defined(POSIX_FADV_SEQUENTIAL)
+    // Files are opened with FILE_FLAG_SEQUENTIAL_SCAN on Windows
+    (void)advice;
+    return 0;
+#else
+    int native;
+    switch (advice)
+    {
+    case FS_ADVICE_SEQUENTIAL:
+        native = POSIX_FADV_SEQUENTIAL;
+        break;
+    case FS_ADVICE_WILLNEED:
+        native = POSIX_FADV_WILLNEED;
+        break;
+    case FS_ADVICE_DONTNEED:
+        native = POSIX_FADV_DONTNEED;
+        break;
+    default:
+        return -1;
+    }
+    // Returns the error number instead of setting errno
+    return posix_fadvise(file->fd, (off_t)offset, (off_t)length, native) == 0 ? 0 : -1;
+#endif
+}
+
+int fs_file_preallocate(fs_file_t *file, long long offset, long long length)
+{
+    if (!fs_file_is_open(file) || offset < 0 || length <= 0)
+        return -1;
+#ifdef _WIN32
+    // Reserves clusters without moving end of file. SetFileValidData is not
+    // used: it needs a privilege and would expose stale disk contents.
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = offset + length;
+    return SetFileInformationByHandle((HANDLE)file->handle, FileAllocationInfo, &info, sizeof(info)) ? 0 : -1;
+#elif defined(__linux__)
+    int result;
+    do
+    {
+        result = fallocate(file->fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)length);
+    } while (result != 0 && errno == EINTR);
+    return result == 0 ? 0 : -1;
+#else
+    // posix_fallocate() would grow the file, which readers and REST would see
+    return -1;
+#endif
+}
+
+int fs_file_flush_range(fs_file_t *file, long long offset, long long length, int wait)
+{
+    if (!fs_file_is_open(file) || offset < 0 || length < 0)
+        return -1;
+#if defined(__linux__)
+    unsigned int flags = SYNC_FILE_RANGE_WRITE;
+    if (wait)
+        flags |= SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WAIT_AFTER;
+    return sync_file_range(file->fd, (off_t)offset, (off_t)length, flags) == 0 ? 0 : -1;
+#else
+    // No range write-back elsewhere: waiting falls back to a full flush
+    (void)offset;
+    (void)length;
+    return wait ? fs_file_sync(file) : 0;
+#endif
+}
+
+int fs_file_sync(fs_file_t *file)
+{
+    if (!fs_file_is_open(file))
+        return -1;
+#ifdef _WIN32
+    return FlushFileBuffers((HANDLE)file->handle) ? 0 : -1;
+#else
+    return fsync(file->fd) == 0 ? 0 : -1;
+#endif
+}
+
+int fs_file_close(fs_file_t *file)
+{
+    if (!fs_file_is_open(file))
+        return 0;
+#ifdef _WIN32
+    int result = CloseHandle((HANDLE)file->handle) ? 0 : -1;
+    file->handle = NULL;
+    return result;
+#else
+    int result = close(file->fd) == 0 ? 0 : -1;
+    file->fd = -1;
+    return result;
+#endif
+}
+
 int fs_create_directory(const char *path)
 {
     if (path == NULL)
@@ -958,155 +1391,41 @@ int fs_delete_file(const char *path)
 #endif
 }
 
-#ifdef _WIN32
-static int remove_directory_recursive_win32(const char *path, int depth)
+/**
+ * @brief Removes every entry, directories once they are empty.
+ */
+static int remove_visitor(const fswalk_entry_t *entry, void *arg)
 {
-    if (depth > MAX_RECURSION_DEPTH)
-        return -1;
-
-    char search_path[PATH_MAX];
-    if (fs_join_path(search_path, PATH_MAX, path, "*") != 0)
-        return -1;
-
-    WIN32_FIND_DATAA find_data;
-    HANDLE hFind = FindFirstFileA(search_path, &find_data);
-
-    if (hFind == INVALID_HANDLE_VALUE)
-        return -1;
-
-    int ret = 0;
-    do
-    {
-        // Skip . and ..
-        if (strcmp(find_data.cFileName, ".") == 0 ||
-            strcmp(find_data.cFileName, "..") == 0)
-            continue;
-
-        char child_path[PATH_MAX];
-        if (fs_join_path(child_path, PATH_MAX, path, find_data.cFileName) != 0)
-        {
-            ret = -1;
-            break;
-        }
-
-        // Handle reparse points (symlinks, junctions) - delete them without following
-        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
-        {
-            if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-            {
-                // It's a directory junction/symlink - use RemoveDirectory
-                if (!RemoveDirectoryA(child_path))
-                {
-                    ret = -1;
-                    break;
-                }
-            }
-            else
-            {
-                // It's a file symlink - use DeleteFile
-                if (!DeleteFileA(child_path))
-                {
-                    ret = -1;
-                    break;
-                }
-            }
-        }
-        else if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-        {
-            // Regular directory - recurse
-            if (remove_directory_recursive_win32(child_path, depth + 1) != 0)
-            {
-                ret = -1;
-                break;
-            }
-            if (!RemoveDirectoryA(child_path))
-            {
-                ret = -1;
-                break;
-            }
-        }
-        else
-        {
-            // Regular file
-            if (!DeleteFileA(child_path))
-            {
-                ret = -1;
-                break;
-            }
-        }
-    } while (FindNextFileA(hFind, &find_data));
-
-    FindClose(hFind);
-    return ret;
-}
+    (void)arg;
+    if (entry->visit == FSWALK_VISIT_DIR_PRE)
+        return FSWALK_CONTINUE;
+#ifdef _WIN32
+    char child_path[PATH_MAX];
+    if (fs_join_path(child_path, PATH_MAX, entry->dir_path, entry->name) != 0)
+        return FSWALK_STOP;
+
+    if (entry->visit == FSWALK_VISIT_DIR_POST)
+        return RemoveDirectoryA(child_path) ? FSWALK_CONTINUE : FSWALK_STOP;
+
+    // Reparse points are removed without following them; directory
+    // junctions and symlinks need RemoveDirectory
+    if (DeleteFileA(child_path))
+        return FSWALK_CONTINUE;
+    if (entry->type == FS_TYPE_SYMLINK && RemoveDirectoryA(child_path))
+        return FSWALK_CONTINUE;
+    return FSWALK_STOP;
 #else
-static int remove_directory_recursive(const char *path, int depth)
-{
-    if (depth > MAX_RECURSION_DEPTH)
-        return -1;
-
-    DIR *d = opendir(path);
-    if (!d)
-        return -1;
-
-    struct dirent *entry;
-    int ret = 0;
-    while ((entry = readdir(d)) != NULL)
-    {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
-
-        char childpath[PATH_MAX];
-        if (fs_join_path(childpath, PATH_MAX, path, entry->d_name) != 0)
-        {
-            ret = -1;
-            break;
-        }
-
-        struct stat st;
-        // Use lstat to not follow symbolic links
-        if (lstat(childpath, &st) != 0)
-        {
-            ret = -1;
-            break;
-        }
-
-        if (S_ISLNK(st.st_mode))
-        {
-            // Remove symlink itself, don't follow it
-            if (unlink(childpath) != 0)
-            {
-                ret = -1;
-                break;
-            }
-        }
-        else if (S_ISDIR(st.st_mode))
-        {
-            if (remove_directory_recursive(childpath, depth + 1) != 0)
-            {
-                ret = -1;
-                break;
-            }
-            if (rmdir(childpath) != 0)
-            {
-                ret = -1;
-                break;
-            }
-        }
-        else
-        {
-            if (unlink(childpath) != 0)
-            {
-                ret = -1;
-                break;
-            }
-        }
-    }
+    // Symlinks are unlinked themselves, never followed
+    int flags = entry->visit == FSWALK_VISIT_DIR_POST ? AT_REMOVEDIR : 0;
+    return unlinkat(entry->dir_fd, entry->name, flags) == 0 ? FSWALK_CONTINUE : FSWALK_STOP;
+#endif
+}
 
-    closedir(d);
-    return ret;
+static int remove_directory_walk(const char *path)
+{
+    fswalk_options_t options = {0, 0, MAX_RECURSION_DEPTH, NULL};
+    return fswalk_run(path, &options, remove_visitor, NULL);
 }
-#endif
 
 int fs_delete_directory(const char *path, int force_delete)
 {
@@ -1122,7 +1441,7 @@ int fs_delete_directory(const char *path, int force_delete)
     }
 
     // Force delete recursively
-    if (remove_directory_recursive_win32(path, 0) != 0)
+    if (remove_directory_walk(path) != 0)
         return -1;
 
     if (!RemoveDirectoryA(path))
@@ -1138,7 +1457,7 @@ int fs_delete_directory(const char *path, int force_delete)
     }
 
     // force delete recursively
-    if (remove_directory_recursive(path, 0) != 0)
+    if (remove_directory_walk(path) != 0)
         return -1;
 
     if (rmdir(path) != 0)
@@ -1165,3 +1484,151 @@ int fs_rename(const char *old_path, const char *new_path)
     return -1;
 #endif
 }
+
+int fs_replace_file(const char *old_path, const char *new_path)
+{
+    if (old_path == NULL || new_path == NULL)
+        return -1;
+
+#ifdef _WIN32
+    if (MoveFileExA(old_path, new_path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        return 0;
+    return -1;
+#else
+    // rename() replaces the target atomically
+    if (rename(old_path, new_path) == 0)
+        return 0;
+    return -1;
+#endif
+}
+
+time_t fs_get_directory_mtime(const char *path)
+{
+    if (path == NULL)
+        return -1;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &fileInfo))
+        return -1;
+
+    if (!(fileInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return -1;
+
+    FILETIME ft = fileInfo.ftLastWriteTime;
+    ULARGE_INTEGER ull;
+    ull.LowPart = ft.dwLowDateTime;
+    ull.HighPart = ft.dwHighDateTime;
+
+    return (time_t)((ull.QuadPart / 10000000ULL) - 11644473600ULL);
+#else
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return -1;
+
+    if (!S_ISDIR(st.st_mode))
+        return -1;
+
+    return st.st_mtime;
+#endif
+}
+
+#ifndef _WIN32
+
+#define FS_NAME_CACHE_SLOTS 256 // Direct-mapped, indexed by id
+
+typedef struct
+{
+    unsigned int id;
+    int valid;
+    time_t fetched;
+    char name[64];
+} fs_name_cache_entry_t;
+
+static fs_name_cache_entry_t g_user_names[FS_NAME_CACHE_SLOTS];
+static fs_name_cache_entry_t g_group_names[FS_NAME_CACHE_SLOTS];
+static pthread_mutex_t g_name_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Copies a cached name if the slot holds a fresh entry for id.
+ * @return 1 on hit, 0 on miss
+ */
+static int fs_name_cache_get(fs_name_cache_entry_t *table, unsigned int id, time_t now,
+                             char *name, size_t name_size)
+{
+    int hit = 0;
+
+    pthread_mutex_lock(&g_name_cache_mutex);
+    fs_name_cache_entry_t *entry = &table[id % FS_NAME_CACHE_SLOTS];
+    if (entry->valid && entry->id == id && now - entry->fetched < FS_NAME_CACHE_TTL)
+    {
+        snprintf(name, name_size, "%s", entry->name);
+        hit = 1;
+    }
+    pthread_mutex_unlock(&g_name_cache_mutex);
+
+    return hit;
+}
+
+static void fs_name_cache_put(fs_name_cache_entry_t *table, unsigned int id, time_t now, const char *name)
+{
+    pthread_mutex_lock(&g_name_cache_mutex);
+    fs_name_cache_entry_t *entry = &table[id % FS_NAME_CACHE_SLOTS];
+    entry->id = id;
+    entry->valid = 1;
+    entry->fetched = now;
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    pthread_mutex_unlock(&g_name_cache_mutex);
+}
+
+#endif
+
+int fs_get_user_name(uid_t uid, char *name, size_t name_size)
+{
+    if (name == NULL || name_size == 0)
+        return -1;
+#ifdef _WIN32
+    (void)uid;
+    return -1;
+#else
+    time_t now = time(NULL);
+    if (fs_name_cache_get(g_user_names, (unsigned int)uid, now, name, name_size))
+        return 0;
+
+    // Reentrant lookup, the result lives in our buffer instead of static storage
+    char buffer[4096];
+    struct passwd pw;
+    struct passwd *result = NULL;
+    if (getpwuid_r(uid, &pw, buffer, sizeof(buffer), &result) == 0 && result)
+        snprintf(name, name_size, "%s", result->pw_name);
+    else
+        snprintf(name, name_size, "%u", (unsigned int)uid);
+
+    fs_name_cache_put(g_user_names, (unsigned int)uid, now, name);
+    return 0;
+#endif
+}
+
+int fs_get_group_name(gid_t gid, char *name, size_t name_size)
+{
+    if (name == NULL || name_size == 0)
+        return -1;
+#ifdef _WIN32
+    (void)gid;
+    return -1;
+#else
+    time_t now = time(NULL);
+    if (fs_name_cache_get(g_group_names, (unsigned int)gid, now, name, name_size))
+        return 0;
+
+    char buffer[4096];
+    struct group gr;
+    struct group *result = NULL;
+    if (getgrgid_r(gid, &gr, buffer, sizeof(buffer), &result) == 0 && result)
+        snprintf(name, name_size, "%s", result->gr_name);
+    else
+        snprintf(name, name_size, "%u", (unsigned int)gid);
+
+    fs_name_cache_put(g_group_names, (unsigned int)gid, now, name);
+    return 0;
+#endif
+}
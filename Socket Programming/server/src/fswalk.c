@@ -0,0 +1,593 @@
+/**
+ * @file fswalk.c
+ * @brief Parallel directory tree walker
+ * @version 0.1
+ * @date 2025-12-09
+ *
+ */
+#ifdef __linux__
+#define _GNU_SOURCE // d_type
+#endif
+#define _XOPEN_SOURCE 700
+#include "fswalk.h"
+#include "atomics.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// How long an idle worker sleeps before looking for work again
+#define FSWALK_IDLE_WAIT_MS 10
+
+/**
+ * @brief A directory. It lives until its own scan and every subdirectory
+ * below it are done, since children are opened and removed through its fd.
+ */
+typedef struct fswalk_node
+{
+    struct fswalk_node *parent; // NULL for the root
+    char *path;                 // Full path (allocated)
+    const char *name;           // Last component, points into path
+    int fd;                     // Open descriptor, -1 until scanned (always -1 on Windows)
+    int depth;                  // 0 for the root
+    int pending;                // 1 for the scan itself plus unfinished subdirectories
+} fswalk_node_t;
+
+/**
+ * @brief Bounded deque of a worker. The owner works at the tail, thieves
+ * take from the head.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    fswalk_node_t *items[FSWALK_QUEUE_CAPACITY];
+    int head;
+    int count;
+} fswalk_deque_t;
+
+typedef struct fswalk_state fswalk_state_t;
+
+typedef struct
+{
+    fswalk_state_t *state;
+    int index;
+    pthread_t thread;
+} fswalk_worker_t;
+
+struct fswalk_state
+{
+    fswalk_visitor_t visitor;
+    void *arg;
+    int flags;
+    int max_depth;
+    const volatile int *cancel;
+    int threads;
+
+    fswalk_deque_t deques[FSWALK_MAX_THREADS];
+    fswalk_worker_t workers[FSWALK_MAX_THREADS];
+    int helpers_launched; // Helpers were started (by worker 0, once)
+    int helpers_started;  // Helpers running: workers 1..helpers_started
+
+    int queued; // Directories in the deques (may briefly read high)
+    int idle;   // Workers about to wait on idle_cond
+    int done;   // The root and everything below it is finished
+    int failed; // Error, stop or cancellation
+
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+};
+
+static void walk_fail(fswalk_state_t *state)
+{
+    ATOMIC_STORE(&state->failed, 1);
+}
+
+static int walk_should_stop(fswalk_state_t *state)
+{
+    if (ATOMIC_LOAD_RELAXED(&state->failed))
+        return 1;
+    if (state->cancel && *state->cancel)
+    {
+        walk_fail(state);
+        return 1;
+    }
+    return 0;
+}
+
+static void wake_workers(fswalk_state_t *state, int all)
+{
+    pthread_mutex_lock(&state->idle_lock);
+    if (all)
+        pthread_cond_broadcast(&state->idle_cond);
+    else
+        pthread_cond_signal(&state->idle_cond);
+    pthread_mutex_unlock(&state->idle_lock);
+}
+
+static fswalk_node_t *node_create(fswalk_node_t *parent, const char *name)
+{
+    fswalk_node_t *node = calloc(1, sizeof(*node));
+    if (!node)
+        return NULL;
+
+    size_t size = (parent ? strlen(parent->path) + 1 : 0) + strlen(name) + 2;
+    node->path = malloc(size);
+    int joined = -1;
+    if (node->path && parent)
+    {
+        joined = fs_join_path(node->path, (long long)size, parent->path, name);
+    }
+    else if (node->path)
+    {
+        memcpy(node->path, name, strlen(name) + 1);
+        joined = 0;
+    }
+    if (joined != 0)
+    {
+        free(node->path);
+        free(node);
+        return NULL;
+    }
+
+    node->parent = parent;
+    node->name = parent ? node->path + strlen(node->path) - strlen(name) : node->path;
+    node->fd = -1;
+    node->depth = parent ? parent->depth + 1 : 0;
+    node->pending = 1;
+    if (parent)
+        ATOMIC_FETCH_ADD(&parent->pending, 1);
+    return node;
+}
+
+/**
+ * @brief Drops one reference of a node; the last one visits DIR_POST,
+ * frees the node and moves on to its parent.
+ */
+static void node_release(fswalk_state_t *state, fswalk_node_t *node, int worker)
+{
+    while (node && ATOMIC_FETCH_SUB(&node->pending, 1) == 1)
+    {
+        fswalk_node_t *parent = node->parent;
+
+        // Closed before DIR_POST, so the visitor may remove the directory
+#ifndef _WIN32
+        if (node->fd >= 0)
+            close(node->fd);
+#endif
+        if (parent && !ATOMIC_LOAD_RELAXED(&state->failed))
+        {
+            fswalk_entry_t entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.visit = FSWALK_VISIT_DIR_POST;
+            entry.dir_path = parent->path;
+            entry.dir_fd = parent->fd;
+            entry.name = node->name;
+            entry.type = FS_TYPE_DIR;
+            entry.depth = node->depth;
+            entry.worker = worker;
+            if (state->visitor(&entry, state->arg) == FSWALK_STOP)
+                walk_fail(state);
+        }
+
+        free(node->path);
+        free(node);
+
+        if (!parent)
+        {
+            ATOMIC_STORE(&state->done, 1);
+            wake_workers(state, 1);
+        }
+        node = parent;
+    }
+}
+
+static int deque_push(fswalk_deque_t *deque, fswalk_node_t *node)
+{
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == FSWALK_QUEUE_CAPACITY)
+    {
+        pthread_mutex_unlock(&deque->lock);
+        return -1;
+    }
+    deque->items[(deque->head + deque->count) % FSWALK_QUEUE_CAPACITY] = node;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+static fswalk_node_t *deque_take(fswalk_deque_t *deque, int from_head)
+{
+    fswalk_node_t *node = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0)
+    {
+        if (from_head)
+        {
+            node = deque->items[deque->head];
+            deque->head = (deque->head + 1) % FSWALK_QUEUE_CAPACITY;
+        }
+        else
+        {
+            node = deque->items[(deque->head + deque->count - 1) % FSWALK_QUEUE_CAPACITY];
+        }
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return node;
+}
+
+static void *walk_helper(void *arg);
+static void walk_node(fswalk_state_t *state, fswalk_node_t *node, int worker);
+
+/**
+ * @brief Starts the helper workers; failures just leave fewer workers.
+ */
+static void start_helpers(fswalk_state_t *state)
+{
+    state->helpers_launched = 1;
+    for (int i = 1; i < state->threads; i++)
+    {
+        state->workers[i].state = state;
+        state->workers[i].index = i;
+        if (pthread_create(&state->workers[i].thread, NULL, walk_helper, &state->workers[i]) != 0)
+            break;
+        state->helpers_started = i;
+    }
+}
+
+/**
+ * @brief Queues a subdirectory, or walks it right away if the deque is full.
+ */
+static void schedule_node(fswalk_state_t *state, fswalk_node_t *node, int worker)
+{
+    // Count before publishing, so a worker checking before it sleeps cannot miss it
+    ATOMIC_FETCH_ADD(&state->queued, 1);
+    if (deque_push(&state->deques[worker], node) != 0)
+    {
+        ATOMIC_FETCH_SUB(&state->queued, 1);
+        walk_node(state, node, worker);
+        return;
+    }
+
+    if (worker == 0 && !state->helpers_launched && state->threads > 1)
+        start_helpers(state);
+    else if (ATOMIC_LOAD(&state->idle) > 0)
+        wake_workers(state, 0);
+}
+
+/**
+ * @brief Handles one entry of a directory being scanned.
+ * @return 0 to go on, -1 to stop scanning.
+ */
+static int visit_entry(fswalk_state_t *state, fswalk_node_t *node, int worker, fswalk_entry_t *entry)
+{
+    if (entry->type != FS_TYPE_DIR)
+    {
+        if (state->visitor(entry, state->arg) == FSWALK_STOP)
+        {
+            walk_fail(state);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (state->max_depth > 0 && entry->depth > state->max_depth)
+    {
+        walk_fail(state);
+        return -1;
+    }
+
+    entry->visit = FSWALK_VISIT_DIR_PRE;
+    int action = state->visitor(entry, state->arg);
+    if (action == FSWALK_STOP)
+    {
+        walk_fail(state);
+        return -1;
+    }
+    if (action == FSWALK_SKIP)
+        return 0;
+
+    fswalk_node_t *child = node_create(node, entry->name);
+    if (!child)
+    {
+        walk_fail(state);
+        return -1;
+    }
+    schedule_node(state, child, worker);
+    return 0;
+}
+
+#ifdef _WIN32
+static void scan_directory(fswalk_state_t *state, fswalk_node_t *node, int worker)
+{
+    char search_path[MAX_PATH];
+    if (fs_join_path(search_path, MAX_PATH, node->path, "*") != 0)
+    {
+        walk_fail(state);
+        return;
+    }
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE hFind = FindFirstFileA(search_path, &find_data);
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        walk_fail(state);
+        return;
+    }
+
+    do
+    {
+        if (walk_should_stop(state))
+            break;
+
+        // Skip . and ..
+        if (strcmp(find_data.cFileName, ".") == 0 ||
+            strcmp(find_data.cFileName, "..") == 0)
+            continue;
+
+        fswalk_entry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.visit = FSWALK_VISIT_ENTRY;
+        entry.dir_path = node->path;
+        entry.dir_fd = -1;
+        entry.name = find_data.cFileName;
+        entry.depth = node->depth + 1;
+        entry.worker = worker;
+
+        // Reparse points (symbolic links, junctions) are never followed
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+            entry.type = FS_TYPE_SYMLINK;
+        else if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            entry.type = FS_TYPE_DIR;
+        else
+            entry.type = FS_TYPE_FILE;
+
+        // FindNextFile returns size and time for free
+        ULARGE_INTEGER ull;
+        ull.HighPart = find_data.nFileSizeHigh;
+        ull.LowPart = find_data.nFileSizeLow;
+        entry.size = entry.type == FS_TYPE_DIR ? 0 : (long long)ull.QuadPart;
+        ull.LowPart = find_data.ftLastWriteTime.dwLowDateTime;
+        ull.HighPart = find_data.ftLastWriteTime.dwHighDateTime;
+        entry.last_modified = (time_t)((ull.QuadPart / 10000000ULL) - 11644473600ULL);
+
+        if (visit_entry(state, node, worker, &entry) != 0)
+            break;
+    } while (FindNextFileA(hFind, &find_data));
+
+    FindClose(hFind);
+}
+#else
+static fs_file_type_t type_from_mode(mode_t mode)
+{
+    if (S_ISREG(mode))
+        return FS_TYPE_FILE;
+    if (S_ISDIR(mode))
+        return FS_TYPE_DIR;
+    if (S_ISLNK(mode))
+        return FS_TYPE_SYMLINK;
+    return FS_TYPE_UNKNOWN;
+}
+
+/**
+ * @brief Fills the type (and with FSWALK_STAT the size and time) of an entry.
+ * @return 0 on success, 1 if the entry vanished, -1 on error.
+ */
+static int describe_entry(fswalk_state_t *state, int dir_fd, const struct dirent *ent, fswalk_entry_t *entry)
+{
+    int known = 0;
+#ifdef DT_DIR
+    if (!(state->flags & FSWALK_STAT))
+    {
+        known = 1;
+        switch (ent->d_type)
+        {
+        case DT_REG:
+            entry->type = FS_TYPE_FILE;
+            break;
+        case DT_DIR:
+            entry->type = FS_TYPE_DIR;
+            break;
+        case DT_LNK:
+            entry->type = FS_TYPE_SYMLINK;
+            break;
+        case DT_UNKNOWN:
+            known = 0;
+            break;
+        default:
+            entry->type = FS_TYPE_UNKNOWN;
+            break;
+        }
+    }
+#endif
+    if (known)
+        return 0;
+
+    struct stat st;
+    if (fstatat(dir_fd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+        return errno == ENOENT ? 1 : -1;
+
+    entry->type = type_from_mode(st.st_mode);
+    entry->size = S_ISDIR(st.st_mode) ? 0 : (long long)st.st_size;
+    entry->last_modified = st.st_mtime;
+    return 0;
+}
+
+static void scan_directory(fswalk_state_t *state, fswalk_node_t *node, int worker)
+{
+    if (node->parent)
+        node->fd = openat(node->parent->fd, node->name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    else
+        node->fd = open(node->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (node->fd < 0)
+    {
+        walk_fail(state);
+        return;
+    }
+
+    // The stream owns its own descriptor; node->fd outlives it for the children
+    int stream_fd = dup(node->fd);
+    DIR *d = stream_fd >= 0 ? fdopendir(stream_fd) : NULL;
+    if (!d)
+    {
+        if (stream_fd >= 0)
+            close(stream_fd);
+        walk_fail(state);
+        return;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL)
+    {
+        if (walk_should_stop(state))
+            break;
+
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+
+        fswalk_entry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.visit = FSWALK_VISIT_ENTRY;
+        entry.dir_path = node->path;
+        entry.dir_fd = node->fd;
+        entry.name = ent->d_name;
+        entry.depth = node->depth + 1;
+        entry.worker = worker;
+
+        int described = describe_entry(state, node->fd, ent, &entry);
+        if (described == 1)
+            continue; // Removed while we were looking
+        if (described != 0)
+        {
+            walk_fail(state);
+            break;
+        }
+
+        if (visit_entry(state, node, worker, &entry) != 0)
+            break;
+    }
+
+    closedir(d);
+}
+#endif
+
+/**
+ * @brief Scans a directory (unless the walk already failed) and drops the
+ * reference the scan held.
+ */
+static void walk_node(fswalk_state_t *state, fswalk_node_t *node, int worker)
+{
+    if (!walk_should_stop(state))
+        scan_directory(state, node, worker);
+    node_release(state, node, worker);
+}
+
+static fswalk_node_t *find_work(fswalk_state_t *state, int worker)
+{
+    fswalk_node_t *node = deque_take(&state->deques[worker], 0);
+    for (int i = 1; !node && i < state->threads; i++)
+        node = deque_take(&state->deques[(worker + i) % state->threads], 1);
+    if (node)
+        ATOMIC_FETCH_SUB(&state->queued, 1);
+    return node;
+}
+
+static void walk_loop(fswalk_state_t *state, int worker)
+{
+    while (!ATOMIC_LOAD(&state->done))
+    {
+        fswalk_node_t *node = find_work(state, worker);
+        if (node)
+        {
+            walk_node(state, node, worker);
+            continue;
+        }
+
+        // Nothing to steal: sleep until a directory is queued or the walk ends
+        pthread_mutex_lock(&state->idle_lock);
+        ATOMIC_FETCH_ADD(&state->idle, 1);
+        if (ATOMIC_LOAD(&state->queued) <= 0 && !ATOMIC_LOAD(&state->done))
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += FSWALK_IDLE_WAIT_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&state->idle_cond, &state->idle_lock, &deadline);
+        }
+        ATOMIC_FETCH_SUB(&state->idle, 1);
+        pthread_mutex_unlock(&state->idle_lock);
+    }
+}
+
+static void *walk_helper(void *arg)
+{
+    fswalk_worker_t *worker = (fswalk_worker_t *)arg;
+    walk_loop(worker->state, worker->index);
+    return NULL;
+}
+
+int fswalk_run(const char *root, const fswalk_options_t *options, fswalk_visitor_t visitor, void *arg)
+{
+    if (!root || !visitor)
+        return -1;
+
+    fswalk_state_t *state = calloc(1, sizeof(*state));
+    if (!state)
+        return -1;
+
+    state->visitor = visitor;
+    state->arg = arg;
+    state->threads = FSWALK_DEFAULT_THREADS;
+    if (options)
+    {
+        state->flags = options->flags;
+        state->max_depth = options->max_depth;
+        state->cancel = options->cancel;
+        if (options->threads > 0)
+            state->threads = options->threads < FSWALK_MAX_THREADS ? options->threads : FSWALK_MAX_THREADS;
+    }
+
+    for (int i = 0; i < state->threads; i++)
+        pthread_mutex_init(&state->deques[i].lock, NULL);
+    pthread_mutex_init(&state->idle_lock, NULL);
+    pthread_cond_init(&state->idle_cond, NULL);
+
+    fswalk_node_t *node = node_create(NULL, root);
+    if (node)
+    {
+        // The caller is worker 0; helpers join once a subdirectory is queued
+        walk_node(state, node, 0);
+        walk_loop(state, 0);
+    }
+    else
+    {
+        walk_fail(state);
+    }
+
+    for (int i = 1; i <= state->helpers_started; i++)
+        pthread_join(state->workers[i].thread, NULL);
+
+    int result = ATOMIC_LOAD(&state->failed) ? -1 : 0;
+
+    for (int i = 0; i < state->threads; i++)
+        pthread_mutex_destroy(&state->deques[i].lock);
+    pthread_mutex_destroy(&state->idle_lock);
+    pthread_cond_destroy(&state->idle_cond);
+    free(state);
+    return result;
+}
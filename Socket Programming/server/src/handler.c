@@ -6,63 +6,83 @@
  */
 #include "command.h"
 #include "session.h"
+#include "datacomp.h"
+#include "digestcache.h"
 #include "protocol.h"
 #include "transfer.h"
 #include "filesys.h"
 #include "filelock.h"
+#include "hotcache.h"
+#include "listcache.h"
 #include "logger.h"
+#include "metrics.h"
+#include "mlsx.h"
+#include "server.h"
+#include "tlssock.h"
 #include "utils.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Previous Handlers for context changing
+// Command Flags, applied by cmd_dispatch() before the handlers below
 
-int cmd_prev_handle_clear_restart(cmd_handler_context_t context, const proto_command_t *cmd)
+static unsigned session_command_state(cmd_handler_context_t context)
 {
-    (void)cmd;
-
     session_t *session = (session_t *)context;
     if (!session)
     {
-        return -1;
+        return 0;
     }
 
-    session_clear_restart_offset(session);
-    return 0;
+    return (session->authenticated ? CMD_NEED_AUTH : 0) |
+           (session->data_mode != SESSION_DATA_MODE_NONE ? CMD_NEED_DATA : 0);
 }
 
-int cmd_prev_handle_clear_rename(cmd_handler_context_t context, const proto_command_t *cmd)
+static int session_command_refuse(cmd_handler_context_t context, unsigned missing)
 {
-    (void)cmd;
-
     session_t *session = (session_t *)context;
     if (!session)
     {
         return -1;
     }
 
-    session_clear_rename_state(session);
-    return 0;
+    if (missing & CMD_NEED_AUTH)
+    {
+        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
+                                     "Please login with USER and PASS");
+    }
+
+    return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
+                                 "Use PASV or PORT first");
 }
 
-// Clear both restart offset and rename state
-int cmd_prev_handle_clear_all(cmd_handler_context_t context, const proto_command_t *cmd)
+static void session_command_clear(cmd_handler_context_t context, unsigned flags)
 {
-    (void)cmd;
-
     session_t *session = (session_t *)context;
     if (!session)
     {
-        return -1;
+        return;
     }
 
-    session_clear_restart_offset(session);
-    session_clear_rename_state(session);
-    return 0;
+    if (flags & CMD_CLEAR_RESTART)
+    {
+        session_clear_restart_offset(session);
+    }
+    if (flags & CMD_CLEAR_RENAME)
+    {
+        session_clear_rename_state(session);
+    }
 }
 
+// Checked by cmd_dispatch() for the flags each command is registered with
+const cmd_context_ops_t cmd_session_ops = {
+    session_command_state,
+    session_command_refuse,
+    session_command_clear,
+};
+
 // Access Control Commands
 
 // Login Commands
@@ -79,6 +99,13 @@ int cmd_handle_user(cmd_handler_context_t context, const proto_command_t *cmd)
 
     const char *username = cmd->argument;
 
+    if (server_get_config()->tls_required && !session->control_protected)
+    {
+        LOG_WARN("Login without TLS rejected from %s:%u", session->client_ip, session->client_port);
+        return session_send_response(session, PROTO_RESP_POLICY_DENIED,
+                                     "TLS required, use AUTH TLS");
+    }
+
     // Check if user exists or if anonymous login is enabled
     int user_exists = auth_user_exists(username);
     int is_anonymous = (strcmp(username, "anonymous") == 0);
@@ -162,12 +189,6 @@ int cmd_handle_cwd(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -188,12 +209,6 @@ int cmd_handle_cdup(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -312,21 +327,18 @@ int cmd_handle_rein(cmd_handler_context_t context, const proto_command_t *cmd)
     // Close any existing data connections
     session_close_data_connection(session);
 
-    pthread_mutex_lock(&session->lock);
-
-    // Reset authentication state
-    session->authenticated = 0;
-    session->state = SESSION_STATE_CONNECTED;
-    memset(session->username, 0, sizeof(session->username));
-    session->permissions = AUTH_PERM_NONE;
+    // Reset authentication and directory state
+    session_reset_user(session);
+    session_clear_rename_state(session);
 
-    // Reset directory state
-    strcpy(session->current_dir, "/");
-    memset(session->user_home_dir, 0, sizeof(session->user_home_dir));
+    pthread_mutex_lock(&session->lock);
 
     // Reset transfer parameters to defaults
     session->transfer_type = PROTO_TYPE_BINARY;
     session->transfer_mode = PROTO_MODE_STREAM;
+    session->compression_level = server_get_config()->compression_level;
+    session->mlst_facts = MLSX_DEFAULT_FACTS;
+    session->hash_algorithm = DIGEST_SHA256;
     session->data_structure = PROTO_STRU_FILE;
 
     // Reset data connection mode
@@ -337,15 +349,13 @@ int cmd_handle_rein(cmd_handler_context_t context, const proto_command_t *cmd)
 
     // Clear command state
     session->restart_offset = 0;
-    session->rename_pending = 0;
-    memset(session->rename_from, 0, sizeof(session->rename_from));
+    session->restart_end = -1;
+    session->allocation_size = 0;
 
     // Clear transfer state
     session->transfer_should_abort = 0;
     session->transfer_in_progress = 0;
-    session->transfer_thread = 0;
     session->transfer_thread_state = TRANSFER_THREAD_IDLE;
-    session->transfer_params = NULL;
     session->transfer_result = TRANSFER_STATUS_OK;
 
     // Do not reset statistics on REIN
@@ -356,24 +366,158 @@ int cmd_handle_rein(cmd_handler_context_t context, const proto_command_t *cmd)
                                  "Service ready for new user");
 }
 
-// Transfer Parameter Commands
+// Security Commands (RFC 4217)
 
-int cmd_handle_port(cmd_handler_context_t context, const proto_command_t *cmd)
+int cmd_handle_auth(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
+    if (!cmd->has_argument)
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
+    }
+
+    if (!tlssock_is_available())
+    {
+        return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL,
+                                     "TLS not configured");
+    }
+
+    char mechanism[16];
+    strncpy(mechanism, cmd->argument, sizeof(mechanism) - 1);
+    mechanism[sizeof(mechanism) - 1] = '\0';
+    trim_whitespace(mechanism);
+    to_uppercase(mechanism);
+    if (strcmp(mechanism, "TLS") != 0 && strcmp(mechanism, "TLS-C") != 0 && strcmp(mechanism, "SSL") != 0)
+    {
+        return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
+                                     "Security mechanism not supported");
+    }
+
+    // The replies of a running transfer would interleave with the handshake
+    transfer_thread_state_t thread_state = session_get_transfer_thread_state(session);
+    if (session->control_protected || thread_state == TRANSFER_THREAD_STARTING ||
+        thread_state == TRANSFER_THREAD_RUNNING)
+    {
+        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
+                                     session->control_protected ? "Already using TLS" : "Transfer in progress");
+    }
+
+    if (session_send_response(session, PROTO_RESP_AUTH_OK, "AUTH TLS successful") != 0)
+    {
+        return -1;
+    }
+
+    // Commands pipelined behind AUTH arrived in plain text and must not pass as protected
+    net_line_buffer_free(&session->control_buffer);
+
+    // The handshake blocks; the thread owning the connection runs it before the next command
+    session->tls_pending = 1;
+    return 0;
+}
+
+int cmd_handle_pbsz(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
+    if (!session->control_protected)
+    {
+        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
+                                     "PBSZ requires AUTH TLS first");
+    }
+
+    char *end = NULL;
+    if (!cmd->has_argument || cmd->argument[0] < '0' || cmd->argument[0] > '9' ||
+        (strtoul(cmd->argument, &end, 10), *end != '\0'))
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
+    }
+
+    // TLS is a stream protection: there is no buffer to negotiate (RFC 4217 section 8)
+    pthread_mutex_lock(&session->lock);
+    session->pbsz_set = 1;
+    pthread_mutex_unlock(&session->lock);
+
+    return session_send_response(session, PROTO_RESP_OK, "PBSZ=0");
+}
+
+int cmd_handle_prot(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
+    if (!session->pbsz_set)
+    {
+        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
+                                     "PROT requires PBSZ first");
+    }
+
+    if (!cmd->has_argument || strlen(cmd->argument) != 1)
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
+    }
+
+    char level = (char)toupper((unsigned char)cmd->argument[0]);
+    if (level == 'S' || level == 'E')
+    {
+        return session_send_response(session, PROTO_RESP_PROT_NOT_SUPPORTED,
+                                     "Protection level not supported");
+    }
+    if (level != 'C' && level != 'P')
+    {
+        return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
+                                     "Unknown protection level");
+    }
+    if (level == 'C' && server_get_config()->tls_required)
+    {
+        return session_send_response(session, PROTO_RESP_POLICY_DENIED,
+                                     "Data connections must be protected");
+    }
+
+    pthread_mutex_lock(&session->lock);
+    session->data_protected = level == 'P';
+    pthread_mutex_unlock(&session->lock);
+
+    return session_send_response(session, PROTO_RESP_OK,
+                                 level == 'P' ? "Protection level set to Private" : "Protection level set to Clear");
+}
+
+/**
+ * @brief Refuses to set up a plain data connection when TLS is required
+ *
+ * @return 1 if the data connection may be set up, 0 if a 521 was sent instead
+ */
+static int data_protection_ok(session_t *session)
+{
+    if (!server_get_config()->tls_required || session->data_protected)
+    {
+        return 1;
     }
 
+    session_send_response(session, PROTO_RESP_DATA_PROT_REFUSED,
+                          "Data connections must be protected, use PROT P");
+    return 0;
+}
+
+// Transfer Parameter Commands
+
+int cmd_handle_port(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
                                      "Syntax error in parameters");
     }
 
+    if (!data_protection_ok(session))
+    {
+        return 0;
+    }
+
     proto_port_params_t port_params;
     if (proto_parse_port(cmd->argument, &port_params) != 0)
     {
@@ -407,18 +551,17 @@ int cmd_handle_pasv(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
                                      "PASV does not take parameters");
     }
 
+    if (!data_protection_ok(session))
+    {
+        return 0;
+    }
+
     // Get server IP (simplified - use control connection IP)
     char server_ip[64];
     uint16_t dummy_port;
@@ -430,8 +573,9 @@ int cmd_handle_pasv(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Failed to get server address");
     }
 
-    // Set passive mode (ports 20000-65535)
-    if (session_set_pasv(session, 20000, 65535, server_ip) != 0)
+    // Set passive mode on the configured port range
+    const server_config_t *config = server_get_config();
+    if (session_set_pasv(session, config->pasv_port_min, config->pasv_port_max, server_ip) != 0)
     {
         return session_send_response(session, PROTO_RESP_LOCAL_ERROR,
                                      "Failed to enter passive mode");
@@ -472,12 +616,6 @@ int cmd_handle_type(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -513,12 +651,6 @@ int cmd_handle_stru(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -558,12 +690,6 @@ int cmd_handle_mode(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -577,6 +703,13 @@ int cmd_handle_mode(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Invalid mode parameter");
     }
 
+    if (mode == PROTO_MODE_DEFLATE && datacomp_is_available())
+    {
+        session_set_mode(session, mode);
+        return session_send_response(session, PROTO_RESP_OK,
+                                     "Mode set to Deflate");
+    }
+
     if (mode != PROTO_MODE_STREAM)
     {
         return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
@@ -591,15 +724,26 @@ int cmd_handle_mode(cmd_handler_context_t context, const proto_command_t *cmd)
 
 // FTP Service Commands
 
-int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
+/**
+ * @brief Gets the length of a RANG range within a file.
+ *
+ * @param offset First byte of the range
+ * @param range_end Last byte of the range, -1 for none
+ * @param size File size
+ * @return The number of bytes, or -1 if there is no range or it runs to the end of the file
+ */
+static long long range_length(long long offset, long long range_end, long long size)
 {
-    session_t *session = (session_t *)context;
-
-    if (!session->authenticated)
+    if (range_end < 0 || range_end >= size - 1)
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        return -1;
     }
+    return range_end + 1 - offset;
+}
+
+int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
 
     if (!cmd->has_argument)
     {
@@ -607,13 +751,6 @@ int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Syntax error in parameters");
     }
 
-    // Check if data transfer mode is set (PASV or PORT must be called first)
-    if (session->data_mode == SESSION_DATA_MODE_NONE)
-    {
-        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
-                                     "Use PASV or PORT first");
-    }
-
     // Check path access permission (READ required for downloading)
     if (!session_check_path_access(session, cmd->argument, AUTH_PERM_READ))
     {
@@ -622,64 +759,90 @@ int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if file exists and is a regular file (not a directory)
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "File not found");
     }
 
-    // Get restart offset (for REST + RETR)
+    if (target.st.type == FS_TYPE_DIR)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Cannot download a directory");
+    }
+
+    // Opening a FIFO or device below could block the control connection
+    if (target.st.type != FS_TYPE_FILE)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Cannot read file");
+    }
+
+    // Get restart offset (for REST + RETR) and the last byte of a RANG range
     long long offset = session_get_restart_offset(session);
+    long long range_end = session_get_restart_end(session);
 
     // Error handling variables
     int response = -1;
-    int lock_acquired = 0;
+    file_lock_t *lock = NULL;
+    int file_opened = 0;
     int data_connection_opened = 0;
+    fs_file_t file;
 
     // Use do-while(0) for structured error handling
     do
     {
         // Try to acquire shared lock without blocking
         // If file is being written, fail immediately so client can retry
-        if (file_lock_try_acquire_shared(abs_path) != 0)
+        lock = file_lock_try_acquire_shared_handle(target.path);
+        if (!lock)
         {
             response = session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                              "File is busy, try again later");
             break;
         }
-        lock_acquired = 1;
 
-        // Revalidate file state while holding the lock
-        if (!fs_path_exists(abs_path))
+        // Revalidate file state while holding the lock on the file the transfer will read
+        if (fs_file_open(&file, target.path, FS_OPEN_READ) != 0)
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
-                                             "File not found");
+                                             session_path_refresh(&target) ? "Cannot read file" : "File not found");
             break;
         }
+        file_opened = 1;
 
-        if (fs_is_directory(abs_path))
+        if (fs_file_stat(&file, &target.st) != 0)
+        {
+            response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                             "Cannot read file");
+            break;
+        }
+
+        if (target.st.type == FS_TYPE_DIR)
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                              "Cannot download a directory");
             break;
         }
 
-        long long file_size = fs_get_file_size(abs_path);
-        if (file_size < 0)
+        if (target.st.type != FS_TYPE_FILE)
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                              "Cannot read file");
             break;
         }
 
+        long long file_size = target.st.size;
+
         if (offset > file_size)
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
@@ -687,11 +850,20 @@ int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
             break;
         }
 
+        // A range must start inside the file
+        if (range_end >= 0 && offset >= file_size)
+        {
+            response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                             "Invalid range");
+            break;
+        }
+        long long length = range_length(offset, range_end, file_size);
+
         // Inform client that transfer is starting (150 reply)
         char msg[PROTO_MAX_RESPONSE_LINE];
         snprintf(msg, sizeof(msg), "Opening %s mode data connection for %s (%lld bytes)",
                  (session->transfer_type == PROTO_TYPE_ASCII) ? "ASCII" : "BINARY",
-                 cmd->argument, file_size - offset);
+                 cmd->argument, length >= 0 ? length : file_size - offset);
         if (session_send_response(session, PROTO_RESP_FILE_STATUS_OK, msg) != 0)
         {
             response = -1;
@@ -713,10 +885,15 @@ int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
         transfer_params_t params;
         memset(&params, 0, sizeof(params));
         params.operation = TRANSFER_OP_SEND_FILE;
-        strncpy(params.filepath, abs_path, sizeof(params.filepath) - 1);
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
         params.offset = offset;
+        params.length = length;
         params.type = session->transfer_type;
-        params.lock_acquired = lock_acquired; // Transfer lock ownership to thread
+        params.lock_acquired = 1; // Transfer lock ownership to thread
+        params.shared_lock = lock;
+        params.stat = target.st;
+        params.file = file; // Transfer the open file to the thread
+        params.file_opened = file_opened;
 
         // Start async transfer thread
         if (session_start_transfer_thread(session, &params) != 0)
@@ -730,7 +907,8 @@ int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
         // Data connection will be closed by the transfer thread
         // File lock will be released by the transfer thread
         response = 0;
-        lock_acquired = 0;          // Don't release lock here, transfer thread will do it
+        lock = NULL;                // Don't release lock here, transfer thread will do it
+        file_opened = 0;            // Don't close the file here
         data_connection_opened = 0; // Don't close data connection here
     } while (0);
 
@@ -739,11 +917,13 @@ int cmd_handle_retr(cmd_handler_context_t context, const proto_command_t *cmd)
         session_close_data_connection(session);
     }
 
-    if (lock_acquired)
+    if (file_opened)
     {
-        file_lock_release_shared(abs_path);
+        fs_file_close(&file);
     }
 
+    file_lock_release_shared_handle(lock);
+
     return response;
 }
 
@@ -751,25 +931,12 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
                                      "Syntax error in parameters");
     }
 
-    // Check if data transfer mode is set (PASV or PORT must be called first)
-    if (session->data_mode == SESSION_DATA_MODE_NONE)
-    {
-        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
-                                     "Use PASV or PORT first");
-    }
-
     // Check path access permission (WRITE required for uploading)
     if (!session_check_path_access(session, cmd->argument, AUTH_PERM_WRITE))
     {
@@ -778,15 +945,16 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if path exists and is a directory (cannot overwrite directory)
-    if (fs_is_directory(abs_path))
+    if (target.exists && target.st.type == FS_TYPE_DIR)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot upload to a directory");
@@ -794,6 +962,16 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
 
     // Get restart offset (for REST + STOR)
     long long offset = session_get_restart_offset(session);
+    if (session_get_restart_end(session) >= 0)
+    {
+        session_clear_restart_offset(session);
+        return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
+                                     "RANG is not supported for uploads");
+    }
+    long long size_hint = session_take_allocation_size(session);
+
+    // A fresh upload can go to a temporary file that replaces the target at the end
+    int atomic = (offset == 0 && server_get_config()->atomic_uploads);
 
     int response = -1;
     int lock_acquired = 0;
@@ -804,7 +982,7 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
     {
         // Try to acquire exclusive lock without blocking
         // If file is being read/written, fail immediately so client can retry
-        if (file_lock_try_acquire_exclusive(abs_path) != 0)
+        if (file_lock_try_acquire_exclusive(target.path) != 0)
         {
             response = session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                              "File is busy, try again later");
@@ -815,40 +993,44 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
         // Revalidate file state while holding the lock
         if (offset > 0)
         {
-            if (!fs_path_exists(abs_path))
+            if (!session_path_refresh(&target))
             {
                 response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                                  "File does not exist for resume");
                 break;
             }
 
-            long long file_size = fs_get_file_size(abs_path);
-            if (file_size < 0)
+            if (target.st.type != FS_TYPE_FILE)
             {
                 response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                                  "Cannot read file");
                 break;
             }
 
-            if (offset > file_size)
+            if (offset > target.st.size)
             {
                 response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                                  "Invalid restart offset");
                 break;
             }
         }
-        else
+        else if (!atomic)
         {
             // Fresh upload should replace existing file to avoid stale data
-            if (fs_path_exists(abs_path) && fs_delete_file(abs_path) != 0)
+            if (session_path_refresh(&target) && fs_delete_file(target.path) != 0)
             {
-                LOG_WARN("User '%s' cannot overwrite file: %s", session->username, abs_path);
+                LOG_WARN("User '%s' cannot overwrite file: %s", session->username, target.path);
                 response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                                  "Cannot overwrite existing file");
                 break;
             }
         }
 
+        // The file is replaced or resumed; the transfer invalidates again when it completes
+        listcache_invalidate(target.path);
+        digestcache_invalidate(target.path);
+        hotcache_invalidate(target.path);
+
         // Inform client that transfer is starting (150 reply)
         char msg[PROTO_MAX_RESPONSE_LINE];
         snprintf(msg, sizeof(msg), "Opening %s mode data connection for %s",
@@ -875,10 +1057,12 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
         transfer_params_t params;
         memset(&params, 0, sizeof(params));
         params.operation = TRANSFER_OP_RECV_FILE;
-        strncpy(params.filepath, abs_path, sizeof(params.filepath) - 1);
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
         params.offset = offset;
         params.type = session->transfer_type;
         params.lock_acquired = lock_acquired; // Transfer lock ownership to thread
+        params.size_hint = size_hint;
+        params.atomic = atomic;
 
         // Start async transfer thread
         if (session_start_transfer_thread(session, &params) != 0)
@@ -903,7 +1087,7 @@ int cmd_handle_stor(cmd_handler_context_t context, const proto_command_t *cmd)
 
     if (lock_acquired)
     {
-        file_lock_release_exclusive(abs_path);
+        file_lock_release_exclusive(target.path);
     }
 
     return response;
@@ -913,25 +1097,12 @@ int cmd_handle_appe(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
                                      "Syntax error in parameters");
     }
 
-    // Check if data transfer mode is set (PASV or PORT must be called first)
-    if (session->data_mode == SESSION_DATA_MODE_NONE)
-    {
-        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
-                                     "Use PASV or PORT first");
-    }
-
     // Check path access permission (WRITE required for uploading)
     if (!session_check_path_access(session, cmd->argument, AUTH_PERM_WRITE))
     {
@@ -940,20 +1111,23 @@ int cmd_handle_appe(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if path exists and is a directory (cannot append to directory)
-    if (fs_is_directory(abs_path))
+    if (target.exists && target.st.type == FS_TYPE_DIR)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot append to a directory");
     }
 
+    long long size_hint = session_take_allocation_size(session);
+
     int response = -1;
     int lock_acquired = 0;
     int data_connection_opened = 0;
@@ -963,7 +1137,7 @@ int cmd_handle_appe(cmd_handler_context_t context, const proto_command_t *cmd)
     {
         // Try to acquire exclusive lock without blocking
         // If file is being read/written, fail immediately so client can retry
-        if (file_lock_try_acquire_exclusive(abs_path) != 0)
+        if (file_lock_try_acquire_exclusive(target.path) != 0)
         {
             response = session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                              "File is busy, try again later");
@@ -973,15 +1147,15 @@ int cmd_handle_appe(cmd_handler_context_t context, const proto_command_t *cmd)
 
         // Determine offset: if file exists, append to end; otherwise start from 0
         long long offset = 0;
-        if (fs_path_exists(abs_path))
+        if (session_path_refresh(&target))
         {
-            offset = fs_get_file_size(abs_path);
-            if (offset < 0)
+            if (target.st.type != FS_TYPE_FILE)
             {
                 response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                                  "Cannot read file");
                 break;
             }
+            offset = target.st.size;
         }
 
         // Inform client that transfer is starting (150 reply)
@@ -1007,10 +1181,11 @@ int cmd_handle_appe(cmd_handler_context_t context, const proto_command_t *cmd)
         transfer_params_t params;
         memset(&params, 0, sizeof(params));
         params.operation = TRANSFER_OP_RECV_FILE;
-        strncpy(params.filepath, abs_path, sizeof(params.filepath) - 1);
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
         params.offset = offset;
         params.type = session->transfer_type;
         params.lock_acquired = lock_acquired; // Transfer lock ownership to thread
+        params.size_hint = size_hint;
 
         // Start async transfer thread
         if (session_start_transfer_thread(session, &params) != 0)
@@ -1035,22 +1210,53 @@ int cmd_handle_appe(cmd_handler_context_t context, const proto_command_t *cmd)
 
     if (lock_acquired)
     {
-        file_lock_release_exclusive(abs_path);
+        file_lock_release_exclusive(target.path);
     }
 
     return response;
 }
 
-int cmd_handle_rest(cmd_handler_context_t context, const proto_command_t *cmd)
+int cmd_handle_allo(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
+    if (!cmd->has_argument)
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
+    }
+
+    // ALLO <size> [R <record size>]; records do not apply to file structure
+    char *endptr;
+    long long size = strtoll(cmd->argument, &endptr, 10);
+    while (*endptr == ' ')
+    {
+        endptr++;
+    }
+    if (endptr == cmd->argument || size < 0 ||
+        (*endptr != '\0' && !((endptr[0] == 'R' || endptr[0] == 'r') && endptr[1] == ' ')))
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Invalid allocation size");
+    }
+
+    // Taken by the next STOR or APPE to reserve the space up front
+    if (session_set_allocation_size(session, size) != 0)
+    {
+        return session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                     "Failed to record allocation size");
     }
 
+    char response[PROTO_MAX_RESPONSE_LINE];
+    snprintf(response, sizeof(response), "Allocation of %lld bytes noted", size);
+
+    return session_send_response(session, PROTO_RESP_OK, response);
+}
+
+int cmd_handle_rest(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1080,23 +1286,60 @@ int cmd_handle_rest(cmd_handler_context_t context, const proto_command_t *cmd)
     return session_send_response(session, PROTO_RESP_FILE_ACTION_PENDING, response);
 }
 
-int cmd_handle_list(cmd_handler_context_t context, const proto_command_t *cmd)
+int cmd_handle_rang(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
+    if (!cmd->has_argument)
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
     }
 
-    // Check if data transfer mode is set (PASV or PORT must be called first)
-    if (session->data_mode == SESSION_DATA_MODE_NONE)
+    // RANG <start> <end>, both inclusive (draft-bryan-ftp-range)
+    char *endptr;
+    long long start = strtoll(cmd->argument, &endptr, 10);
+    char *second = endptr;
+    long long end = (*second == ' ') ? strtoll(second + 1, &endptr, 10) : -1;
+
+    if (endptr == cmd->argument || *second != ' ' || endptr == second + 1 || *endptr != '\0' ||
+        start < 0 || end < 0)
     {
-        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
-                                     "Use PASV or PORT first");
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Invalid range");
     }
 
+    // "RANG 1 0" resets to the whole file
+    if (start == 1 && end == 0)
+    {
+        session_clear_restart_offset(session);
+        return session_send_response(session, PROTO_RESP_FILE_ACTION_PENDING,
+                                     "Restarting at 0. Ending at EOF.");
+    }
+
+    if (end < start)
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Invalid range");
+    }
+
+    // Taken by the next RETR or checksum, which clamp the end to the file size
+    if (session_set_restart_range(session, start, end) != 0)
+    {
+        return session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                     "Failed to set range");
+    }
+
+    char response[PROTO_MAX_RESPONSE_LINE];
+    snprintf(response, sizeof(response), "Restarting at %lld. Ending at %lld.", start, end);
+
+    return session_send_response(session, PROTO_RESP_FILE_ACTION_PENDING, response);
+}
+
+int cmd_handle_list(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
     // Get path argument, default to current directory
     const char *path = cmd->has_argument ? cmd->argument : ".";
 
@@ -1108,15 +1351,15 @@ int cmd_handle_list(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, path, abs_path, sizeof(abs_path)) != 0)
+    session_path_t target;
+    if (session_lookup_path(session, path, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if path exists
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Path not found");
@@ -1149,10 +1392,11 @@ int cmd_handle_list(cmd_handler_context_t context, const proto_command_t *cmd)
         transfer_params_t params;
         memset(&params, 0, sizeof(params));
         params.operation = TRANSFER_OP_SEND_LIST;
-        strncpy(params.filepath, abs_path, sizeof(params.filepath) - 1);
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
         params.offset = 0;
         params.type = session->transfer_type;
         params.lock_acquired = 0; // LIST doesn't need file locks
+        params.stat = target.st;  // Directory or single file, decided once here
 
         // Start async transfer thread
         if (session_start_transfer_thread(session, &params) != 0)
@@ -1180,19 +1424,89 @@ int cmd_handle_nlst(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
+    // Get path argument, default to current directory
+    const char *path = cmd->has_argument ? cmd->argument : ".";
+
+    // Check path access permission (READ required for listing)
+    if (!session_check_path_access(session, path, AUTH_PERM_READ))
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        LOG_WARN("User '%s' denied read access to: %s", session->username, path);
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Permission denied");
     }
 
-    // Check if data transfer mode is set (PASV or PORT must be called first)
-    if (session->data_mode == SESSION_DATA_MODE_NONE)
+    session_path_t target;
+    if (session_lookup_path(session, path, &target) != 0)
     {
-        return session_send_response(session, PROTO_RESP_BAD_COMMAND_SEQUENCE,
-                                     "Use PASV or PORT first");
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Invalid path");
+    }
+
+    // Check if path exists
+    if (!target.exists)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Path not found");
+    }
+
+    int response = -1;
+    int data_connection_opened = 0;
+
+    // Use do-while(0) for structured error handling
+    do
+    {
+        // Inform client that transfer is starting
+        if (session_send_response(session, PROTO_RESP_FILE_STATUS_OK,
+                                  "Opening data connection for name list") != 0)
+        {
+            response = -1;
+            break;
+        }
+
+        // Open data connection
+        if (session_open_data_connection(session, 10000) != 0)
+        {
+            response = session_send_response(session, PROTO_RESP_CANT_OPEN_DATA,
+                                             "Can't open data connection");
+            break;
+        }
+        data_connection_opened = 1;
+
+        // Prepare transfer parameters
+        transfer_params_t params;
+        memset(&params, 0, sizeof(params));
+        params.operation = TRANSFER_OP_SEND_NLST;
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
+        params.offset = 0;
+        params.type = session->transfer_type;
+        params.lock_acquired = 0; // NLST doesn't need file locks
+
+        // Start async transfer thread
+        if (session_start_transfer_thread(session, &params) != 0)
+        {
+            response = session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                             "Failed to start transfer");
+            break;
+        }
+
+        // Transfer started successfully, response will be sent by transfer thread
+        // Data connection will be closed by the transfer thread
+        response = 0;
+        data_connection_opened = 0; // Don't close data connection here
+    } while (0);
+
+    if (data_connection_opened)
+    {
+        session_close_data_connection(session);
     }
 
+    return response;
+}
+
+int cmd_handle_mlsd(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
     // Get path argument, default to current directory
     const char *path = cmd->has_argument ? cmd->argument : ".";
 
@@ -1204,20 +1518,26 @@ int cmd_handle_nlst(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, path, abs_path, sizeof(abs_path)) != 0)
+    session_path_t target;
+    if (session_lookup_path(session, path, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
-    // Check if path exists
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Path not found");
     }
 
+    // MLSD lists directories only, MLST describes a single object
+    if (target.st.type != FS_TYPE_DIR)
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Not a directory");
+    }
+
     int response = -1;
     int data_connection_opened = 0;
 
@@ -1226,7 +1546,7 @@ int cmd_handle_nlst(cmd_handler_context_t context, const proto_command_t *cmd)
     {
         // Inform client that transfer is starting
         if (session_send_response(session, PROTO_RESP_FILE_STATUS_OK,
-                                  "Opening data connection for name list") != 0)
+                                  "Opening data connection for MLSD") != 0)
         {
             response = -1;
             break;
@@ -1244,11 +1564,12 @@ int cmd_handle_nlst(cmd_handler_context_t context, const proto_command_t *cmd)
         // Prepare transfer parameters
         transfer_params_t params;
         memset(&params, 0, sizeof(params));
-        params.operation = TRANSFER_OP_SEND_NLST;
-        strncpy(params.filepath, abs_path, sizeof(params.filepath) - 1);
+        params.operation = TRANSFER_OP_SEND_MLSD;
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
         params.offset = 0;
         params.type = session->transfer_type;
-        params.lock_acquired = 0; // NLST doesn't need file locks
+        params.lock_acquired = 0; // MLSD doesn't need file locks
+        params.stat = target.st;
 
         // Start async transfer thread
         if (session_start_transfer_thread(session, &params) != 0)
@@ -1272,16 +1593,86 @@ int cmd_handle_nlst(cmd_handler_context_t context, const proto_command_t *cmd)
     return response;
 }
 
-int cmd_handle_pwd(cmd_handler_context_t context, const proto_command_t *cmd)
+int cmd_handle_mlst(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
+    // Get path argument, default to current directory
+    const char *path = cmd->has_argument ? cmd->argument : ".";
+
+    // Check path access permission (READ required for listing)
+    if (!session_check_path_access(session, path, AUTH_PERM_READ))
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        LOG_WARN("User '%s' denied read access to: %s", session->username, path);
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Permission denied");
     }
 
+    char virtual_path[SESSION_MAX_PATH];
+    session_path_t target;
+    if (session_get_virtual_path(session, path, virtual_path, sizeof(virtual_path)) != 0 ||
+        session_lookup_path(session, path, &target) != 0)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Invalid path");
+    }
+
+    if (!target.exists)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Path not found");
+    }
+
+    // Owner and mode come from the entry in its parent; the snapshot covers
+    // the object itself if that is not available (e.g. the server root)
+    fs_file_info_t info;
+    char entry_path[SESSION_MAX_PATH];
+    char parent[SESSION_MAX_PATH];
+    strncpy(entry_path, target.path, sizeof(entry_path) - 1);
+    entry_path[sizeof(entry_path) - 1] = '\0';
+    size_t length = strlen(entry_path);
+    while (length > 1 && (entry_path[length - 1] == '/' || entry_path[length - 1] == '\\'))
+    {
+        entry_path[--length] = '\0';
+    }
+    if (fs_get_parent_directory(entry_path, parent, sizeof(parent)) != 0 ||
+        fs_get_entry_info(parent, fs_extract_filename(entry_path), &info) != 0)
+    {
+        memset(&info, 0, sizeof(info));
+        info.type = target.st.type;
+        info.size = target.st.size;
+        info.last_modified = target.st.last_modified;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    unsigned int facts = session->mlst_facts;
+    auth_permission_t permissions = session->permissions;
+    pthread_mutex_unlock(&session->lock);
+
+    // The entry line starts with a single space, then the facts and the pathname
+    char line[PROTO_MAX_RESPONSE_LINE];
+    line[0] = ' ';
+    if (mlsx_format_entry(&info, facts, permissions, virtual_path, line + 1, sizeof(line) - 1) < 0)
+    {
+        return session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                     "Cannot describe path");
+    }
+
+    char header[PROTO_MAX_RESPONSE_LINE];
+    snprintf(header, sizeof(header), "Listing %s", path);
+    if (session_send_response_multiline(session, PROTO_RESP_FILE_ACTION_OK, header) != 0 ||
+        session_send_response_text(session, line) != 0)
+    {
+        return -1;
+    }
+
+    return session_send_response(session, PROTO_RESP_FILE_ACTION_OK, "End");
+}
+
+int cmd_handle_pwd(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
     if (cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1305,12 +1696,6 @@ int cmd_handle_mkd(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1345,6 +1730,7 @@ int cmd_handle_mkd(cmd_handler_context_t context, const proto_command_t *cmd)
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Failed to create directory");
     }
+    listcache_invalidate(abs_path);
 
     char response[PROTO_MAX_RESPONSE_LINE];
     snprintf(response, sizeof(response), "\"%s\" directory created", cmd->argument);
@@ -1356,12 +1742,6 @@ int cmd_handle_rmd(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1376,32 +1756,36 @@ int cmd_handle_rmd(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if path exists and is a directory
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Directory not found");
     }
 
-    if (!fs_is_directory(abs_path))
+    if (target.st.type != FS_TYPE_DIR)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Path is not a directory");
     }
 
     // Remove the directory
-    if (fs_delete_directory(abs_path, 0) != 0)
+    if (fs_delete_directory(target.path, 0) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Failed to remove directory");
     }
+    listcache_invalidate(target.path);
+    digestcache_invalidate(target.path);
+    hotcache_invalidate(target.path);
 
     return session_send_response(session, PROTO_RESP_FILE_ACTION_OK,
                                  "Directory removed");
@@ -1411,12 +1795,6 @@ int cmd_handle_rnfr(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1469,12 +1847,6 @@ int cmd_handle_rnto(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1518,12 +1890,13 @@ int cmd_handle_rnto(cmd_handler_context_t context, const proto_command_t *cmd)
     if (fs_get_parent_directory(to_path, dest_parent, sizeof(dest_parent)) == 0)
     {
         // Check if parent directory exists
-        if (!fs_path_exists(dest_parent))
+        fs_stat_t parent_st;
+        if (fs_stat(dest_parent, &parent_st) != 0)
         {
             return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                          "Destination directory does not exist");
         }
-        if (!fs_is_directory(dest_parent))
+        if (parent_st.type != FS_TYPE_DIR)
         {
             return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                          "Invalid destination path");
@@ -1569,6 +1942,12 @@ int cmd_handle_rnto(cmd_handler_context_t context, const proto_command_t *cmd)
                                              "Rename failed");
             break;
         }
+        listcache_invalidate(from_path);
+        listcache_invalidate(to_path);
+        digestcache_invalidate(from_path);
+        digestcache_invalidate(to_path);
+        hotcache_invalidate(from_path);
+        hotcache_invalidate(to_path);
 
         LOG_INFO("User '%s' renamed '%s' to '%s'", session->username, from_path, to_path);
         response = session_send_response(session, PROTO_RESP_FILE_ACTION_OK,
@@ -1591,12 +1970,6 @@ int cmd_handle_dele(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1611,22 +1984,23 @@ int cmd_handle_dele(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if path exists
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "File not found");
     }
 
     // Check if it's a directory (use RMD for directories)
-    if (fs_is_directory(abs_path))
+    if (target.st.type == FS_TYPE_DIR)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot delete directory with DELE (use RMD)");
@@ -1640,7 +2014,7 @@ int cmd_handle_dele(cmd_handler_context_t context, const proto_command_t *cmd)
     {
         // Try to acquire exclusive lock without blocking
         // If file is being read/written, fail immediately so client can retry
-        if (file_lock_try_acquire_exclusive(abs_path) != 0)
+        if (file_lock_try_acquire_exclusive(target.path) != 0)
         {
             response = session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                              "File is busy, try again later");
@@ -1649,14 +2023,14 @@ int cmd_handle_dele(cmd_handler_context_t context, const proto_command_t *cmd)
         lock_acquired = 1;
 
         // Revalidate file state while holding the lock
-        if (!fs_path_exists(abs_path))
+        if (!session_path_refresh(&target))
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                              "File no longer exists");
             break;
         }
 
-        if (fs_is_directory(abs_path))
+        if (target.st.type == FS_TYPE_DIR)
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                              "Cannot delete directory with DELE (use RMD)");
@@ -1664,21 +2038,24 @@ int cmd_handle_dele(cmd_handler_context_t context, const proto_command_t *cmd)
         }
 
         // Delete the file
-        if (fs_delete_file(abs_path) != 0)
+        if (fs_delete_file(target.path) != 0)
         {
             response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                              "Failed to delete file");
             break;
         }
+        listcache_invalidate(target.path);
+        digestcache_invalidate(target.path);
+        hotcache_invalidate(target.path);
 
-        LOG_INFO("User '%s' deleted file: %s", session->username, abs_path);
+        LOG_INFO("User '%s' deleted file: %s", session->username, target.path);
         response = session_send_response(session, PROTO_RESP_FILE_ACTION_OK,
                                          "File deleted");
     } while (0);
 
     if (lock_acquired)
     {
-        file_lock_release_exclusive(abs_path);
+        file_lock_release_exclusive(target.path);
     }
 
     return response;
@@ -1695,7 +2072,9 @@ int cmd_handle_abor(cmd_handler_context_t context, const proto_command_t *cmd)
     }
 
     transfer_thread_state_t thread_state = session_get_transfer_thread_state(session);
-    int transfer_thread_active = (thread_state == TRANSFER_THREAD_RUNNING);
+    // A transfer still queued for a worker counts as active, it is cancelled before it starts
+    int transfer_thread_active = (thread_state == TRANSFER_THREAD_STARTING ||
+                                  thread_state == TRANSFER_THREAD_RUNNING);
 
     if (!transfer_thread_active)
     {
@@ -1706,15 +2085,18 @@ int cmd_handle_abor(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "No transfer in progress");
     }
 
-    // Transfer is active - abort it
+    // Transfer is active - send 426 for the interrupted command first, so it
+    // always precedes the 226 the transfer thread sends once it sees the abort
+    int result = session_send_response(session, PROTO_RESP_CONN_CLOSED,
+                                       "Data connection closed; transfer aborted");
+
+    // Abort it
     session_set_transfer_should_abort(session);
 
     // Close data connection to unblock any blocking I/O
     session_close_data_connection(session);
 
-    // Send 426 response to indicate abnormal termination
-    return session_send_response(session, PROTO_RESP_CONN_CLOSED,
-                                 "Data connection closed; transfer aborted");
+    return result;
 }
 
 // Informational commands
@@ -1749,16 +2131,115 @@ int cmd_handle_noop(cmd_handler_context_t context, const proto_command_t *cmd)
                                  "OK");
 }
 
-int cmd_handle_size(cmd_handler_context_t context, const proto_command_t *cmd)
+int cmd_handle_stat(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
+    if (!session)
+    {
+        return -1;
+    }
 
-    if (!session->authenticated)
+    // STAT <pathname> would list over the control connection; only the status form is supported
+    if (cmd->has_argument)
     {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
+        return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
+                                     "STAT with a pathname is not implemented");
+    }
+
+    static const char *const modes[] = {"STREAM", "BLOCK", "COMPRESSED", "Z"};
+    metrics_snapshot_t *snapshot = (metrics_snapshot_t *)malloc(sizeof(metrics_snapshot_t));
+    if (!snapshot)
+    {
+        return session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                     "Local error in processing");
+    }
+    metrics_get_snapshot(snapshot);
+
+    threadpool_stats_t pool;
+    threadpool_get_stats(&pool);
+
+    char lines[6][PROTO_MAX_RESPONSE_LINE];
+    pthread_mutex_lock(&session->lock);
+    snprintf(lines[0], sizeof(lines[0]), " Connected from %s:%u", session->client_ip, session->client_port);
+    snprintf(lines[1], sizeof(lines[1]), " Logged in as %s",
+             session->authenticated ? session->username : "(not logged in)");
+    snprintf(lines[2], sizeof(lines[2]), " TYPE: %s, MODE: %s",
+             session->transfer_type == PROTO_TYPE_ASCII ? "ASCII" : "BINARY",
+             modes[session->transfer_mode]);
+    snprintf(lines[3], sizeof(lines[3]), " Session: %llu bytes downloaded, %llu bytes uploaded, %u commands",
+             session->bytes_downloaded, session->bytes_uploaded, session->commands_received);
+    snprintf(lines[4], sizeof(lines[4]), " %s",
+             session->transfer_in_progress ? "Data transfer in progress" : "No data transfer in progress");
+    pthread_mutex_unlock(&session->lock);
+    snprintf(lines[5], sizeof(lines[5]), " Server: %llu sessions, %d of %d transfer workers busy",
+             snapshot->sessions_opened - snapshot->sessions_closed, pool.busy_workers, pool.max_workers);
+    free(snapshot);
+
+    if (session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, "FTP server status:") != 0)
+        return -1;
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++)
+    {
+        if (session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, lines[i]) != 0)
+            return -1;
     }
 
+    return session_send_response(session, PROTO_RESP_SYSTEM_STATUS, "End of status");
+}
+
+int cmd_handle_site(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+    if (!session)
+    {
+        return -1;
+    }
+
+    char command[32] = "";
+    if (cmd->has_argument)
+    {
+        snprintf(command, sizeof(command), "%.*s", (int)sizeof(command) - 1, cmd->argument);
+        trim_whitespace(command);
+        to_uppercase(command);
+    }
+
+    if (strcmp(command, "HELP") == 0)
+    {
+        return session_send_response(session, PROTO_RESP_HELP_MESSAGE,
+                                     "SITE commands: METRICS, HELP");
+    }
+
+    if (strcmp(command, "METRICS") != 0)
+    {
+        return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
+                                     "Unknown SITE command");
+    }
+
+    char *text = metrics_render(METRICS_FORMAT_TEXT, NULL);
+    if (!text)
+    {
+        return session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                     "Local error in processing");
+    }
+
+    // One reply line per metrics line, indented so none can be taken for the final line
+    int result = session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, "Server metrics:");
+    char line[PROTO_MAX_RESPONSE_LINE];
+    for (char *item = strtok(text, "\n"); item && result == 0; item = strtok(NULL, "\n"))
+    {
+        snprintf(line, sizeof(line), " %s", item);
+        result = session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, line);
+    }
+    free(text);
+
+    if (result != 0)
+        return -1;
+    return session_send_response(session, PROTO_RESP_SYSTEM_STATUS, "End of metrics");
+}
+
+int cmd_handle_size(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1773,51 +2254,53 @@ int cmd_handle_size(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if file exists and is a regular file (not a directory)
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "File not found");
     }
 
-    if (fs_is_directory(abs_path))
+    if (target.st.type == FS_TYPE_DIR)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot get size of a directory");
     }
 
     // Check if file is locked and acquire shared lock
-    if (file_lock_is_exclusive_locked(abs_path))
+    if (file_lock_is_exclusive_locked(target.path))
     {
         return session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                      "File is busy, try again later");
     }
 
     // Acquire shared lock to ensure file is not being modified
-    if (file_lock_acquire_shared(abs_path) != 0)
+    if (file_lock_acquire_shared(target.path) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                      "File is busy, try again later");
     }
 
-    long long file_size = fs_get_file_size(abs_path);
-    file_lock_release_shared(abs_path);
+    // Revalidate under the lock, an upload may have finished since the lookup
+    session_path_refresh(&target);
+    file_lock_release_shared(target.path);
 
-    if (file_size < 0)
+    if (!target.exists || target.st.type != FS_TYPE_FILE)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot read file");
     }
 
     char response[PROTO_MAX_RESPONSE_LINE];
-    snprintf(response, sizeof(response), "%lld", file_size);
+    snprintf(response, sizeof(response), "%lld", target.st.size);
 
     return session_send_response(session, PROTO_RESP_FILE_STATUS, response);
 }
@@ -1826,12 +2309,6 @@ int cmd_handle_mdtm(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     session_t *session = (session_t *)context;
 
-    if (!session->authenticated)
-    {
-        return session_send_response(session, PROTO_RESP_NOT_LOGGED_IN,
-                                     "Please login with USER and PASS");
-    }
-
     if (!cmd->has_argument)
     {
         return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
@@ -1846,50 +2323,53 @@ int cmd_handle_mdtm(cmd_handler_context_t context, const proto_command_t *cmd)
                                      "Permission denied");
     }
 
-    char abs_path[SESSION_MAX_PATH];
-    if (session_resolve_path(session, cmd->argument, abs_path, sizeof(abs_path)) != 0)
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Invalid path");
     }
 
     // Check if file exists and is a regular file (not a directory)
-    if (!fs_path_exists(abs_path))
+    if (!target.exists)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "File not found");
     }
 
-    if (fs_is_directory(abs_path))
+    if (target.st.type == FS_TYPE_DIR)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot get modification time of a directory");
     }
 
     // Check if file is locked and acquire shared lock
-    if (file_lock_is_exclusive_locked(abs_path))
+    if (file_lock_is_exclusive_locked(target.path))
     {
         return session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                      "File is busy, try again later");
     }
 
     // Acquire shared lock to ensure file is not being modified
-    if (file_lock_acquire_shared(abs_path) != 0)
+    if (file_lock_acquire_shared(target.path) != 0)
     {
         return session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
                                      "File is busy, try again later");
     }
 
-    time_t mtime = fs_get_file_mtime(abs_path);
-    file_lock_release_shared(abs_path);
+    // Revalidate under the lock, an upload may have finished since the lookup
+    session_path_refresh(&target);
+    file_lock_release_shared(target.path);
 
-    if (mtime < 0)
+    if (!target.exists || target.st.type != FS_TYPE_FILE)
     {
         return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
                                      "Cannot read file");
     }
 
     // Format time as YYYYMMDDHHMMSS
+    time_t mtime = target.st.last_modified;
     struct tm *tm_info = gmtime(&mtime);
     if (!tm_info)
     {
@@ -1906,6 +2386,184 @@ int cmd_handle_mdtm(cmd_handler_context_t context, const proto_command_t *cmd)
     return session_send_response(session, PROTO_RESP_FILE_STATUS, response);
 }
 
+/**
+ * @brief Checksums a file for HASH, XCRC, XMD5 and XSHA256.
+ *
+ * The range starts at the REST offset and runs to the end of the file, or
+ * is the one set by RANG. A cached checksum is replied directly, otherwise the file is read on a
+ * transfer worker, which sends the reply.
+ *
+ * @param session The FTP session
+ * @param cmd The command, its argument is the file
+ * @param algorithm Checksum algorithm
+ * @param hash_reply 1 to reply in the HASH format, 0 in the X* format
+ * @return 0 on success, -1 on error
+ */
+static int start_checksum(session_t *session, const proto_command_t *cmd, digest_algorithm_t algorithm,
+                          int hash_reply)
+{
+    if (!cmd->has_argument)
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
+    }
+
+    // Check path access permission (READ required, the checksum reveals the contents)
+    if (!session_check_path_access(session, cmd->argument, AUTH_PERM_READ))
+    {
+        LOG_WARN("User '%s' denied read access to: %s", session->username, cmd->argument);
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Permission denied");
+    }
+
+    // Resolve and stat once, the checks below read the snapshot
+    session_path_t target;
+    if (session_lookup_path(session, cmd->argument, &target) != 0)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Invalid path");
+    }
+
+    if (!target.exists)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "File not found");
+    }
+
+    // Opening a FIFO or device below could block the control connection
+    if (target.st.type != FS_TYPE_FILE)
+    {
+        return session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                     "Not a regular file");
+    }
+
+    long long offset = session_get_restart_offset(session);
+    long long range_end = session_get_restart_end(session);
+    if (offset > target.st.size || (offset == target.st.size && offset > 0))
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Invalid range");
+    }
+
+    // A file checksummed before and unchanged since needs no reading; only ranges to the end are cached
+    char hex[DIGEST_HEX_SIZE];
+    if (range_length(offset, range_end, target.st.size) < 0 &&
+        digestcache_lookup(target.path, &target.st, algorithm, offset, hex) == 0)
+    {
+        session_clear_restart_offset(session);
+        LOG_DEBUG("Checksum cache hit: %s", target.path);
+        transfer_send_digest_reply(session, algorithm, hash_reply, offset, target.st.size, cmd->argument, hex);
+        return 0;
+    }
+
+    // Error handling variables
+    int response = -1;
+    file_lock_t *lock = NULL;
+    int file_opened = 0;
+    fs_file_t file;
+
+    // Use do-while(0) for structured error handling
+    do
+    {
+        // Fail immediately on a file being written, like RETR
+        lock = file_lock_try_acquire_shared_handle(target.path);
+        if (!lock)
+        {
+            response = session_send_response(session, PROTO_RESP_FILE_ACTION_ABORTED,
+                                             "File is busy, try again later");
+            break;
+        }
+
+        // Revalidate file state while holding the lock on the file the worker will read
+        if (fs_file_open(&file, target.path, FS_OPEN_READ) != 0)
+        {
+            response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                             session_path_refresh(&target) ? "Cannot read file" : "File not found");
+            break;
+        }
+        file_opened = 1;
+
+        if (fs_file_stat(&file, &target.st) != 0 || target.st.type != FS_TYPE_FILE)
+        {
+            response = session_send_response(session, PROTO_RESP_FILE_UNAVAILABLE,
+                                             "Cannot read file");
+            break;
+        }
+
+        if (offset > target.st.size || (offset == target.st.size && offset > 0))
+        {
+            response = session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                             "Invalid range");
+            break;
+        }
+
+        session_clear_restart_offset(session);
+
+        // Prepare transfer parameters
+        transfer_params_t params;
+        memset(&params, 0, sizeof(params));
+        params.operation = TRANSFER_OP_HASH;
+        strncpy(params.filepath, target.path, sizeof(params.filepath) - 1);
+        params.offset = offset;
+        params.length = range_length(offset, range_end, target.st.size);
+        params.lock_acquired = 1; // Transfer lock ownership to thread
+        params.shared_lock = lock;
+        params.stat = target.st;
+        params.file = file; // Transfer the open file to the thread
+        params.file_opened = file_opened;
+        params.algorithm = algorithm;
+        params.hash_reply = hash_reply;
+        strncpy(params.hash_name, cmd->argument, sizeof(params.hash_name) - 1);
+
+        if (session_start_transfer_thread(session, &params) != 0)
+        {
+            response = session_send_response(session, PROTO_RESP_LOCAL_ERROR,
+                                             "Failed to start checksum");
+            break;
+        }
+
+        // The worker sends the reply, closes the file and releases the lock
+        response = 0;
+        lock = NULL;
+        file_opened = 0;
+    } while (0);
+
+    if (file_opened)
+    {
+        fs_file_close(&file);
+    }
+
+    file_lock_release_shared_handle(lock);
+
+    return response;
+}
+
+int cmd_handle_hash(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+
+    pthread_mutex_lock(&session->lock);
+    digest_algorithm_t algorithm = session->hash_algorithm;
+    pthread_mutex_unlock(&session->lock);
+
+    return start_checksum(session, cmd, algorithm, 1);
+}
+
+int cmd_handle_xcrc(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    return start_checksum((session_t *)context, cmd, DIGEST_CRC32, 0);
+}
+
+int cmd_handle_xmd5(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    return start_checksum((session_t *)context, cmd, DIGEST_MD5, 0);
+}
+
+int cmd_handle_xsha256(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    return start_checksum((session_t *)context, cmd, DIGEST_SHA256, 0);
+}
+
 int cmd_handle_feat(cmd_handler_context_t context, const proto_command_t *cmd)
 {
     (void)cmd; // Unused parameter
@@ -1926,6 +2584,148 @@ int cmd_handle_feat(cmd_handler_context_t context, const proto_command_t *cmd)
         return -1;
     if (session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, " REST STREAM") != 0)
         return -1;
+    if (session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, " RANG STREAM") != 0)
+        return -1;
+    if (datacomp_is_available() &&
+        session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, " MODE Z") != 0)
+        return -1;
+    if (tlssock_is_available() &&
+        (session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, " AUTH TLS") != 0 ||
+         session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, " PBSZ") != 0 ||
+         session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, " PROT") != 0))
+        return -1;
+
+    // MLST with every supported fact, the selected ones marked with '*'
+    pthread_mutex_lock(&session->lock);
+    unsigned int facts = session->mlst_facts;
+    pthread_mutex_unlock(&session->lock);
+
+    char line[PROTO_MAX_RESPONSE_LINE] = " MLST ";
+    if (mlsx_format_fact_list(facts, 1, line + 6, sizeof(line) - 6) != 0 ||
+        session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, line) != 0)
+        return -1;
+
+    // HASH with every algorithm, the selected one marked with '*'
+    pthread_mutex_lock(&session->lock);
+    digest_algorithm_t selected = session->hash_algorithm;
+    pthread_mutex_unlock(&session->lock);
+
+    size_t used = (size_t)snprintf(line, sizeof(line), " HASH ");
+    for (int i = 0; i < DIGEST_ALGORITHM_COUNT; i++)
+    {
+        used += (size_t)snprintf(line + used, sizeof(line) - used, "%s%s%s", i > 0 ? ";" : "",
+                                 digest_algorithm_name((digest_algorithm_t)i), i == (int)selected ? "*" : "");
+    }
+    if (session_send_response_multiline(session, PROTO_RESP_SYSTEM_STATUS, line) != 0)
+        return -1;
 
     return session_send_response(session, PROTO_RESP_SYSTEM_STATUS, "End");
 }
+
+int cmd_handle_opts(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    session_t *session = (session_t *)context;
+    if (!session)
+    {
+        return -1;
+    }
+
+    if (!cmd->has_argument)
+    {
+        return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                     "Syntax error in parameters");
+    }
+
+    // OPTS MLST <fact>;<fact>;... selects the facts, unknown names are ignored
+    const char *argument = cmd->argument;
+    if (strlen(argument) >= 4 && (argument[4] == '\0' || argument[4] == ' '))
+    {
+        char name[5];
+        memcpy(name, argument, 4);
+        name[4] = '\0';
+        to_uppercase(name);
+        if (strcmp(name, "MLST") == 0)
+        {
+            const char *list = argument + 4;
+            while (*list == ' ')
+                list++;
+            unsigned int facts = mlsx_parse_fact_list(list);
+
+            pthread_mutex_lock(&session->lock);
+            session->mlst_facts = facts;
+            pthread_mutex_unlock(&session->lock);
+
+            char response[PROTO_MAX_RESPONSE_LINE] = "MLST OPTS ";
+            if (mlsx_format_fact_list(facts, 0, response + 10, sizeof(response) - 10) != 0)
+            {
+                return session_send_response(session, PROTO_RESP_LOCAL_ERROR, "Cannot list facts");
+            }
+            return session_send_response(session, PROTO_RESP_OK, response);
+        }
+    }
+
+    // OPTS HASH [<algorithm>] selects the algorithm of HASH or shows the current one
+    if (strlen(argument) >= 4 && (argument[4] == '\0' || argument[4] == ' '))
+    {
+        char name[5];
+        memcpy(name, argument, 4);
+        name[4] = '\0';
+        to_uppercase(name);
+        if (strcmp(name, "HASH") == 0)
+        {
+            char value[32];
+            snprintf(value, sizeof(value), "%s", argument + 4);
+            trim_whitespace(value);
+
+            digest_algorithm_t algorithm;
+            pthread_mutex_lock(&session->lock);
+            if (value[0] == '\0')
+            {
+                algorithm = session->hash_algorithm;
+            }
+            else if (digest_parse_algorithm(value, &algorithm) == 0)
+            {
+                session->hash_algorithm = algorithm;
+            }
+            else
+            {
+                pthread_mutex_unlock(&session->lock);
+                return session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL_PARAM,
+                                             "Unknown algorithm");
+            }
+            pthread_mutex_unlock(&session->lock);
+
+            return session_send_response(session, PROTO_RESP_OK, digest_algorithm_name(algorithm));
+        }
+    }
+
+    char option[64];
+    strncpy(option, cmd->argument, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+    to_uppercase(option);
+    trim_whitespace(option);
+
+    // OPTS MODE Z LEVEL <level>
+    int level = -1;
+    char trailing;
+    if (datacomp_is_available() && strncmp(option, "MODE Z", 6) == 0)
+    {
+        if (sscanf(option, "MODE Z LEVEL %d %c", &level, &trailing) != 1 ||
+            level < DATACOMP_MIN_LEVEL || level > DATACOMP_MAX_LEVEL)
+        {
+            return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                         "Invalid MODE Z options");
+        }
+
+        pthread_mutex_lock(&session->lock);
+        session->compression_level = level;
+        pthread_mutex_unlock(&session->lock);
+
+        char response[64];
+        snprintf(response, sizeof(response), "MODE Z LEVEL set to %d", level);
+        return session_send_response(session, PROTO_RESP_OK, response);
+    }
+
+    return session_send_response(session, PROTO_RESP_SYNTAX_ERROR_PARAM,
+                                 "Option not understood");
+}
@@ -0,0 +1,485 @@
+/**
+ * @file hotcache.c
+ * @brief Small file content cache implementation
+ * @version 0.1
+ * @date 2025-12-16
+ *
+ */
+#include "hotcache.h"
+
+#include "logger.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Hash buckets for path lookups
+#define HOTCACHE_BUCKETS 1024
+
+struct hotcache_file
+{
+    struct hotcache_file *bucket_next; // Next entry in the hash bucket
+    struct hotcache_file *clock_prev;  // Neighbours on the CLOCK ring
+    struct hotcache_file *clock_next;
+    uint64_t hash;
+    long long size;              // File size the copy was read with
+    time_t last_modified;        // File mtime the copy was read with
+    unsigned long long file_id;  // File inode the copy was read with
+    size_t refs;                 // One for the cache while linked, one per download
+    int referenced;              // CLOCK bit, set by every hit
+    int linked;                  // 1 while the entry is in the cache
+    char *path;                  // Key, stored after the contents
+    char data[];                 // File contents
+};
+
+// Global cache state
+static struct
+{
+    hotcache_file_t **buckets;
+    hotcache_file_t *hand; // Next CLOCK candidate, NULL when the cache is empty
+    size_t max_bytes;
+    size_t max_file_size;
+    size_t bytes;
+    size_t entries;
+    size_t pinned_bytes;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long generation; // Bumped by every invalidation
+    pthread_mutex_t mutex;
+} g_hotcache = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief FNV-1a hash of a path
+ */
+static uint64_t hotcache_hash(const char *path)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Drops a reference; called with the mutex held
+ *
+ * @return 1 if the entry has to be freed (after unlocking), 0 otherwise
+ */
+static int hotcache_unref(hotcache_file_t *entry)
+{
+    if (--entry->refs > 0)
+    {
+        return 0;
+    }
+    if (!entry->linked)
+    {
+        g_hotcache.pinned_bytes -= (size_t)entry->size;
+    }
+    return 1;
+}
+
+/**
+ * @brief Takes an entry out of the bucket and the ring; called with the mutex held
+ *
+ * @return 1 if the entry has to be freed (after unlocking), 0 if a download still holds it
+ */
+static int hotcache_unlink(hotcache_file_t *entry)
+{
+    hotcache_file_t **link = &g_hotcache.buckets[entry->hash & (HOTCACHE_BUCKETS - 1)];
+    while (*link != entry)
+    {
+        link = &(*link)->bucket_next;
+    }
+    *link = entry->bucket_next;
+
+    if (entry->clock_next == entry)
+    {
+        g_hotcache.hand = NULL;
+    }
+    else
+    {
+        entry->clock_prev->clock_next = entry->clock_next;
+        entry->clock_next->clock_prev = entry->clock_prev;
+        if (g_hotcache.hand == entry)
+        {
+            g_hotcache.hand = entry->clock_next;
+        }
+    }
+
+    entry->linked = 0;
+    g_hotcache.bytes -= (size_t)entry->size;
+    g_hotcache.entries--;
+    g_hotcache.pinned_bytes += (size_t)entry->size; // Until the last download lets go
+    return hotcache_unref(entry);
+}
+
+/**
+ * @brief Finds the entry of a path; called with the mutex held
+ */
+static hotcache_file_t *hotcache_find(const char *path, uint64_t hash)
+{
+    for (hotcache_file_t *entry = g_hotcache.buckets[hash & (HOTCACHE_BUCKETS - 1)]; entry;
+         entry = entry->bucket_next)
+    {
+        if (entry->hash == hash && strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Checks if an entry was read from the file as it is now
+ */
+static int hotcache_matches(const hotcache_file_t *entry, const fs_stat_t *st)
+{
+    return entry->size == st->size && entry->last_modified == st->last_modified && entry->file_id == st->file_id;
+}
+
+/**
+ * @brief Links a new entry, first replacing entries with CLOCK until it fits; called with the mutex held
+ *
+ * @param entry The new entry
+ * @param garbage Receives replaced entries nobody holds any more, chained through bucket_next, to free after unlocking
+ */
+static void hotcache_link(hotcache_file_t *entry, hotcache_file_t **garbage)
+{
+    while (g_hotcache.hand && g_hotcache.bytes + (size_t)entry->size > g_hotcache.max_bytes)
+    {
+        hotcache_file_t *candidate = g_hotcache.hand;
+        if (candidate->referenced)
+        {
+            // Recently hit: second chance
+            candidate->referenced = 0;
+            g_hotcache.hand = candidate->clock_next;
+            continue;
+        }
+
+        g_hotcache.evictions++;
+        if (hotcache_unlink(candidate))
+        {
+            candidate->bucket_next = *garbage;
+            *garbage = candidate;
+        }
+    }
+
+    hotcache_file_t **bucket = &g_hotcache.buckets[entry->hash & (HOTCACHE_BUCKETS - 1)];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+
+    // New entries go just behind the hand, so they are looked at last
+    if (g_hotcache.hand)
+    {
+        entry->clock_next = g_hotcache.hand;
+        entry->clock_prev = g_hotcache.hand->clock_prev;
+        entry->clock_prev->clock_next = entry;
+        g_hotcache.hand->clock_prev = entry;
+    }
+    else
+    {
+        entry->clock_next = entry->clock_prev = entry;
+        g_hotcache.hand = entry;
+    }
+
+    entry->linked = 1;
+    entry->refs++;
+    g_hotcache.bytes += (size_t)entry->size;
+    g_hotcache.entries++;
+}
+
+/**
+ * @brief Frees a chain of entries built by hotcache_link()
+ */
+static void hotcache_free_chain(hotcache_file_t *chain)
+{
+    while (chain)
+    {
+        hotcache_file_t *next = chain->bucket_next;
+        free(chain);
+        chain = next;
+    }
+}
+
+/**
+ * @brief Reads a whole file into a new, unlinked entry
+ *
+ * @return The entry holding one reference, or NULL if the file could not be read as it was stat'ed
+ */
+static hotcache_file_t *hotcache_read(const char *path, uint64_t hash, fs_file_t *file, const fs_stat_t *st)
+{
+    size_t path_length = strlen(path);
+    hotcache_file_t *entry =
+        (hotcache_file_t *)malloc(sizeof(hotcache_file_t) + (size_t)st->size + path_length + 1);
+    if (!entry)
+    {
+        return NULL;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->hash = hash;
+    entry->size = st->size;
+    entry->last_modified = st->last_modified;
+    entry->file_id = st->file_id;
+    entry->refs = 1;
+    entry->path = entry->data + st->size;
+    memcpy(entry->path, path, path_length + 1);
+
+    // A write while reading would move the mtime, so the second stat catches it
+    fs_stat_t after;
+    if (fs_file_seek(file, 0) != 0 || fs_file_read(file, entry->data, st->size) != st->size ||
+        fs_file_stat(file, &after) != 0 || after.size != st->size || after.last_modified != st->last_modified)
+    {
+        LOG_DEBUG("File changed or failed while caching: %s", path);
+        free(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+int hotcache_init(size_t max_bytes, size_t max_file_size)
+{
+    if (max_bytes == 0)
+    {
+        return 0;
+    }
+
+    if (max_file_size == 0)
+    {
+        max_file_size = HOTCACHE_DEFAULT_MAX_FILE;
+    }
+    if (max_file_size > max_bytes)
+    {
+        max_file_size = max_bytes;
+    }
+
+    hotcache_file_t **buckets = (hotcache_file_t **)calloc(HOTCACHE_BUCKETS, sizeof(hotcache_file_t *));
+    if (!buckets)
+    {
+        LOG_ERROR("Failed to allocate file cache");
+        return -1;
+    }
+
+    hotcache_cleanup();
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+    g_hotcache.buckets = buckets;
+    g_hotcache.max_bytes = max_bytes;
+    g_hotcache.max_file_size = max_file_size;
+    g_hotcache.hits = 0;
+    g_hotcache.misses = 0;
+    g_hotcache.evictions = 0;
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    LOG_INFO("File cache enabled: %zu bytes, files up to %zu bytes", max_bytes, max_file_size);
+    return 0;
+}
+
+void hotcache_cleanup(void)
+{
+    hotcache_file_t *garbage = NULL;
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+    while (g_hotcache.hand)
+    {
+        hotcache_file_t *entry = g_hotcache.hand;
+        if (hotcache_unlink(entry))
+        {
+            entry->bucket_next = garbage;
+            garbage = entry;
+        }
+    }
+    free(g_hotcache.buckets);
+    g_hotcache.buckets = NULL;
+    g_hotcache.max_bytes = 0;
+    g_hotcache.max_file_size = 0;
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    hotcache_free_chain(garbage);
+}
+
+int hotcache_is_enabled(void)
+{
+    pthread_mutex_lock(&g_hotcache.mutex);
+    int enabled = g_hotcache.buckets != NULL;
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    return enabled;
+}
+
+hotcache_file_t *hotcache_acquire(const char *path, fs_file_t *file)
+{
+    if (!path || !file)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+    size_t max_file_size = g_hotcache.max_file_size;
+    unsigned long generation = g_hotcache.generation;
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    fs_stat_t st;
+    if (max_file_size == 0 || fs_file_stat(file, &st) != 0 || st.type != FS_TYPE_FILE ||
+        (unsigned long long)st.size > max_file_size)
+    {
+        return NULL;
+    }
+
+    uint64_t hash = hotcache_hash(path);
+    hotcache_file_t *garbage = NULL;
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+
+    hotcache_file_t *entry = g_hotcache.buckets ? hotcache_find(path, hash) : NULL;
+    if (entry && hotcache_matches(entry, &st))
+    {
+        entry->refs++;
+        entry->referenced = 1;
+        g_hotcache.hits++;
+        pthread_mutex_unlock(&g_hotcache.mutex);
+        return entry;
+    }
+
+    // A stale copy is of no use to anyone from now on
+    if (entry && hotcache_unlink(entry))
+    {
+        garbage = entry;
+        garbage->bucket_next = NULL;
+    }
+    g_hotcache.misses++;
+
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    hotcache_free_chain(garbage);
+    garbage = NULL;
+
+    // A change later in the same second would leave size and mtime unchanged
+    if (st.last_modified >= time(NULL) - 1)
+    {
+        return NULL;
+    }
+
+    entry = hotcache_read(path, hash, file, &st);
+    if (!entry)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+
+    // Cached only if nothing was invalidated while reading and no other download cached it first;
+    // otherwise the copy serves this download alone
+    if (g_hotcache.buckets && generation == g_hotcache.generation && !hotcache_find(path, hash))
+    {
+        hotcache_link(entry, &garbage);
+    }
+    else
+    {
+        g_hotcache.pinned_bytes += (size_t)entry->size;
+    }
+
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    hotcache_free_chain(garbage);
+
+    return entry;
+}
+
+const char *hotcache_data(const hotcache_file_t *entry, size_t *length)
+{
+    if (!entry)
+    {
+        return NULL;
+    }
+
+    if (length)
+    {
+        *length = (size_t)entry->size;
+    }
+    return entry->data;
+}
+
+void hotcache_release(hotcache_file_t *entry)
+{
+    if (!entry)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+    int unused = hotcache_unref(entry);
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    if (unused)
+    {
+        free(entry);
+    }
+}
+
+void hotcache_invalidate(const char *path)
+{
+    if (!path)
+    {
+        return;
+    }
+
+    size_t length = strlen(path);
+    while (length > 1 && (path[length - 1] == '/' || path[length - 1] == '\\'))
+    {
+        length--;
+    }
+
+    hotcache_file_t *garbage = NULL;
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+
+    if (g_hotcache.buckets)
+    {
+        g_hotcache.generation++;
+
+        // The path itself, or anything below it when a directory was renamed
+        size_t count = g_hotcache.entries;
+        hotcache_file_t *entry = g_hotcache.hand;
+        for (size_t i = 0; i < count; i++)
+        {
+            hotcache_file_t *next = entry->clock_next;
+            if (strncmp(entry->path, path, length) == 0 &&
+                (entry->path[length] == '\0' || entry->path[length] == '/' || entry->path[length] == '\\') &&
+                hotcache_unlink(entry))
+            {
+                entry->bucket_next = garbage;
+                garbage = entry;
+            }
+            entry = next;
+        }
+    }
+
+    pthread_mutex_unlock(&g_hotcache.mutex);
+
+    hotcache_free_chain(garbage);
+}
+
+void hotcache_get_stats(hotcache_stats_t *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_hotcache.mutex);
+    stats->max_bytes = g_hotcache.max_bytes;
+    stats->bytes = g_hotcache.bytes;
+    stats->entries = g_hotcache.entries;
+    stats->pinned_bytes = g_hotcache.pinned_bytes;
+    stats->hits = g_hotcache.hits;
+    stats->misses = g_hotcache.misses;
+    stats->evictions = g_hotcache.evictions;
+    pthread_mutex_unlock(&g_hotcache.mutex);
+}
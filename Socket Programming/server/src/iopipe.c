@@ -0,0 +1,358 @@
+/**
+ * @file iopipe.c
+ * @brief Bounded buffer pipeline overlapping disk and network I/O implementation
+ * @version 0.1
+ * @date 2025-11-28
+ *
+ */
+#include "iopipe.h"
+#include "logger.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+struct iopipe
+{
+    iopipe_direction_t direction;
+    iopipe_stage_fn stage;
+    void *context;
+    int depth;
+    size_t buffer_size;
+    char *memory;   // depth buffers of buffer_size bytes
+    size_t *lengths;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    int threaded;   // 0 when the stage runs inline in the caller
+    int joined;
+
+    // Filled buffers form a ring: head is the oldest, count includes a
+    // buffer the consumer (caller or stage) is still working on
+    int head;
+    int count;
+    int holding;    // Caller holds a buffer: the head (read-ahead) or the next free one (write-behind)
+    int done;       // Stage ended (end of data, error, or no more input)
+    int failed;
+    int closing;    // Write-behind: no more buffers will be submitted
+    int stopping;   // Destroy requested
+
+    iopipe_stats_t stats;
+};
+
+static char *pipe_buffer(iopipe_t *pipe, int slot)
+{
+    return pipe->memory + (size_t)slot * pipe->buffer_size;
+}
+
+/**
+ * @brief Helper thread of a read-ahead pipeline: fills free buffers in order.
+ */
+static void *read_ahead_thread(void *arg)
+{
+    iopipe_t *pipe = (iopipe_t *)arg;
+
+    pthread_mutex_lock(&pipe->lock);
+    while (!pipe->stopping)
+    {
+        if (pipe->count == pipe->depth)
+        {
+            pipe->stats.stage_waits++;
+            while (pipe->count == pipe->depth && !pipe->stopping)
+                pthread_cond_wait(&pipe->cond, &pipe->lock);
+            continue;
+        }
+
+        int slot = (pipe->head + pipe->count) % pipe->depth;
+        pthread_mutex_unlock(&pipe->lock);
+
+        long long n = pipe->stage(pipe->context, pipe_buffer(pipe, slot), pipe->buffer_size);
+
+        pthread_mutex_lock(&pipe->lock);
+        if (n > 0)
+        {
+            pipe->lengths[slot] = (size_t)n;
+            pipe->count++;
+        }
+        else
+        {
+            pipe->done = 1;
+            pipe->failed = (n < 0);
+        }
+        pthread_cond_broadcast(&pipe->cond);
+        if (pipe->done)
+            break;
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Helper thread of a write-behind pipeline: consumes queued buffers in order.
+ */
+static void *write_behind_thread(void *arg)
+{
+    iopipe_t *pipe = (iopipe_t *)arg;
+
+    pthread_mutex_lock(&pipe->lock);
+    while (!pipe->stopping)
+    {
+        if (pipe->count == 0)
+        {
+            if (pipe->closing)
+                break;
+            pipe->stats.stage_waits++;
+            while (pipe->count == 0 && !pipe->closing && !pipe->stopping)
+                pthread_cond_wait(&pipe->cond, &pipe->lock);
+            continue;
+        }
+
+        int slot = pipe->head;
+        pthread_mutex_unlock(&pipe->lock);
+
+        long long rc = pipe->stage(pipe->context, pipe_buffer(pipe, slot), pipe->lengths[slot]);
+
+        pthread_mutex_lock(&pipe->lock);
+        pipe->head = (pipe->head + 1) % pipe->depth;
+        pipe->count--;
+        pthread_cond_broadcast(&pipe->cond);
+        if (rc < 0)
+        {
+            pipe->failed = 1;
+            break;
+        }
+    }
+    pipe->done = 1;
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    return NULL;
+}
+
+iopipe_t *iopipe_create(iopipe_direction_t direction, int depth, size_t buffer_size,
+                        iopipe_stage_fn stage, void *context)
+{
+    if (!stage || buffer_size == 0 || depth < IOPIPE_MIN_DEPTH || depth > IOPIPE_MAX_DEPTH ||
+        (direction != IOPIPE_READ_AHEAD && direction != IOPIPE_WRITE_BEHIND))
+        return NULL;
+
+    iopipe_t *pipe = (iopipe_t *)calloc(1, sizeof(iopipe_t));
+    if (!pipe)
+    {
+        LOG_ERROR("Failed to allocate I/O pipeline");
+        return NULL;
+    }
+
+    pipe->memory = (char *)malloc((size_t)depth * buffer_size);
+    pipe->lengths = (size_t *)calloc((size_t)depth, sizeof(size_t));
+    if (!pipe->memory || !pipe->lengths)
+    {
+        LOG_ERROR("Failed to allocate %d I/O pipeline buffers", depth);
+        free(pipe->memory);
+        free(pipe->lengths);
+        free(pipe);
+        return NULL;
+    }
+
+    pipe->direction = direction;
+    pipe->stage = stage;
+    pipe->context = context;
+    pipe->depth = depth;
+    pipe->buffer_size = buffer_size;
+    pthread_mutex_init(&pipe->lock, NULL);
+    pthread_cond_init(&pipe->cond, NULL);
+
+    if (depth > 1)
+    {
+        void *(*thread_func)(void *) = direction == IOPIPE_READ_AHEAD ? read_ahead_thread : write_behind_thread;
+        if (pthread_create(&pipe->thread, NULL, thread_func, pipe) == 0)
+        {
+            pipe->threaded = 1;
+        }
+        else
+        {
+            LOG_WARN("Failed to start I/O pipeline thread, running the stage inline");
+        }
+    }
+
+    if (!pipe->threaded)
+    {
+        pipe->depth = 1; // Only the caller's buffer is ever used
+    }
+    return pipe;
+}
+
+long long iopipe_next(iopipe_t *pipe, const char **data)
+{
+    if (!pipe || !data || pipe->direction != IOPIPE_READ_AHEAD)
+        return -1;
+
+    if (!pipe->threaded)
+    {
+        if (pipe->done)
+            return pipe->failed ? -1 : 0;
+
+        long long n = pipe->stage(pipe->context, pipe->memory, pipe->buffer_size);
+        if (n <= 0)
+        {
+            pipe->done = 1;
+            pipe->failed = (n < 0);
+            return n < 0 ? -1 : 0;
+        }
+        pipe->stats.buffers++;
+        *data = pipe->memory;
+        return n;
+    }
+
+    pthread_mutex_lock(&pipe->lock);
+    if (pipe->holding)
+    {
+        pipe->head = (pipe->head + 1) % pipe->depth;
+        pipe->count--;
+        pipe->holding = 0;
+        pthread_cond_broadcast(&pipe->cond);
+    }
+
+    if (pipe->count == 0 && !pipe->done)
+    {
+        pipe->stats.caller_waits++;
+        while (pipe->count == 0 && !pipe->done)
+            pthread_cond_wait(&pipe->cond, &pipe->lock);
+    }
+
+    long long result;
+    if (pipe->count > 0)
+    {
+        // Buffers filled before a failure are still delivered
+        pipe->holding = 1;
+        pipe->stats.buffers++;
+        *data = pipe_buffer(pipe, pipe->head);
+        result = (long long)pipe->lengths[pipe->head];
+    }
+    else
+    {
+        result = pipe->failed ? -1 : 0;
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return result;
+}
+
+char *iopipe_acquire(iopipe_t *pipe)
+{
+    if (!pipe || pipe->direction != IOPIPE_WRITE_BEHIND || pipe->closing)
+        return NULL;
+
+    if (!pipe->threaded)
+    {
+        if (pipe->failed)
+            return NULL;
+        pipe->holding = 1;
+        return pipe->memory;
+    }
+
+    pthread_mutex_lock(&pipe->lock);
+    if (pipe->count == pipe->depth && !pipe->failed)
+    {
+        pipe->stats.caller_waits++;
+        while (pipe->count == pipe->depth && !pipe->failed)
+            pthread_cond_wait(&pipe->cond, &pipe->lock);
+    }
+
+    char *buffer = NULL;
+    if (!pipe->failed)
+    {
+        pipe->holding = 1;
+        buffer = pipe_buffer(pipe, (pipe->head + pipe->count) % pipe->depth);
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return buffer;
+}
+
+int iopipe_submit(iopipe_t *pipe, size_t length)
+{
+    if (!pipe || pipe->direction != IOPIPE_WRITE_BEHIND || !pipe->holding || length > pipe->buffer_size)
+        return -1;
+
+    if (!pipe->threaded)
+    {
+        pipe->holding = 0;
+        pipe->stats.buffers++;
+        if (length > 0 && pipe->stage(pipe->context, pipe->memory, length) < 0)
+            pipe->failed = 1;
+        return pipe->failed ? -1 : 0;
+    }
+
+    pthread_mutex_lock(&pipe->lock);
+    pipe->holding = 0;
+    int result = -1;
+    if (!pipe->failed)
+    {
+        if (length > 0)
+        {
+            pipe->lengths[(pipe->head + pipe->count) % pipe->depth] = length;
+            pipe->count++;
+            pipe->stats.buffers++;
+            pthread_cond_broadcast(&pipe->cond);
+        }
+        result = 0;
+    }
+    pthread_mutex_unlock(&pipe->lock);
+
+    return result;
+}
+
+int iopipe_finish(iopipe_t *pipe)
+{
+    if (!pipe || pipe->direction != IOPIPE_WRITE_BEHIND)
+        return -1;
+
+    pthread_mutex_lock(&pipe->lock);
+    pipe->closing = 1;
+    pipe->holding = 0;
+    pthread_cond_broadcast(&pipe->cond);
+    pthread_mutex_unlock(&pipe->lock);
+
+    if (pipe->threaded && !pipe->joined)
+    {
+        pthread_join(pipe->thread, NULL);
+        pipe->joined = 1;
+    }
+
+    return pipe->failed ? -1 : 0;
+}
+
+void iopipe_get_stats(iopipe_t *pipe, iopipe_stats_t *stats)
+{
+    if (!pipe || !stats)
+        return;
+
+    pthread_mutex_lock(&pipe->lock);
+    *stats = pipe->stats;
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+void iopipe_destroy(iopipe_t *pipe)
+{
+    if (!pipe)
+        return;
+
+    if (pipe->threaded && !pipe->joined)
+    {
+        pthread_mutex_lock(&pipe->lock);
+        pipe->stopping = 1;
+        pthread_cond_broadcast(&pipe->cond);
+        pthread_mutex_unlock(&pipe->lock);
+
+        pthread_join(pipe->thread, NULL);
+        pipe->joined = 1;
+    }
+
+    pthread_cond_destroy(&pipe->cond);
+    pthread_mutex_destroy(&pipe->lock);
+    free(pipe->memory);
+    free(pipe->lengths);
+    free(pipe);
+}
@@ -0,0 +1,356 @@
+/**
+ * @file lineconv.c
+ * @brief Line ending conversion kernels with runtime dispatch
+ * @version 0.1
+ * @date 2025-11-25
+ *
+ * The vector kernels scan a block for the next CR (or LF), copy the whole
+ * block to the output and then continue right after that byte, so a block
+ * without line endings costs one load, compare and store. They only run
+ * while the output has room for a full block; the remainder goes through
+ * the scalar kernel, which also enforces the exact output size.
+ *
+ */
+#include "lineconv.h"
+#include "atomics.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINECONV_HAVE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__aarch64__) || defined(__ARM_NEON))
+#define LINECONV_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+typedef long long (*lineconv_fn_t)(const char *input, long long input_len, char *output, long long output_size);
+
+/**
+ * @brief Scalar CRLF to LF, lone CRs kept (also the tail of every vector kernel).
+ */
+static long long crlf_to_lf_scalar(const char *input, long long input_len, char *output, long long output_size)
+{
+    long long write_idx = 0;
+    for (long long i = 0; i < input_len; i++)
+    {
+        if (input[i] == '\r' && i + 1 < input_len && input[i + 1] == '\n')
+        {
+            i++; // Skip the CR, emit the LF
+        }
+        if (write_idx + 1 > output_size)
+            return -1; // Output buffer too small
+        output[write_idx++] = input[i];
+    }
+    return write_idx;
+}
+
+/**
+ * @brief Scalar LF to CRLF (also the tail of every vector kernel).
+ */
+static long long lf_to_crlf_scalar(const char *input, long long input_len, char *output, long long output_size)
+{
+    long long write_idx = 0;
+    for (long long i = 0; i < input_len; i++)
+    {
+        if (input[i] == '\n')
+        {
+            if (write_idx + 2 > output_size)
+                return -1; // Output buffer too small
+            output[write_idx++] = '\r';
+            output[write_idx++] = '\n';
+        }
+        else
+        {
+            if (write_idx + 1 > output_size)
+                return -1; // Output buffer too small
+            output[write_idx++] = input[i];
+        }
+    }
+    return write_idx;
+}
+
+/**
+ * @brief Stamps out the CRLF->LF and LF->CRLF kernels for one instruction set.
+ *
+ * MASK(p, c) returns a bit mask of the bytes equal to c in the block at p,
+ * FIRST(mask) the index of the first such byte, COPY(dst, src) copies one
+ * block (WIDTH bytes, unaligned).
+ */
+#define LINECONV_DEFINE_KERNELS(isa, WIDTH, ATTR, mask_t, MASK, FIRST, COPY)                                   \
+    static ATTR long long crlf_to_lf_##isa(const char *input, long long input_len, char *output,               \
+                                           long long output_size)                                               \
+    {                                                                                                           \
+        long long i = 0, o = 0;                                                                                 \
+        /* One extra input byte so a CR anywhere in the block can look at its successor */                      \
+        while (input_len - i > (WIDTH) && output_size - o >= (WIDTH))                                           \
+        {                                                                                                       \
+            mask_t mask = MASK(input + i, '\r');                                                                \
+            COPY(output + o, input + i);                                                                        \
+            if (mask == 0)                                                                                      \
+            {                                                                                                   \
+                i += (WIDTH);                                                                                   \
+                o += (WIDTH);                                                                                   \
+                continue;                                                                                       \
+            }                                                                                                   \
+            long long first = (long long)FIRST(mask);                                                           \
+            i += first;                                                                                         \
+            o += first;                                                                                         \
+            if (input[i + 1] == '\n')                                                                           \
+            {                                                                                                   \
+                output[o++] = '\n';                                                                             \
+                i += 2;                                                                                         \
+            }                                                                                                   \
+            else                                                                                                \
+            {                                                                                                   \
+                o++; /* Lone CR, already copied */                                                              \
+                i++;                                                                                            \
+            }                                                                                                   \
+        }                                                                                                       \
+        long long tail = crlf_to_lf_scalar(input + i, input_len - i, output + o, output_size - o);              \
+        return tail < 0 ? -1 : o + tail;                                                                        \
+    }                                                                                                           \
+                                                                                                                \
+    static ATTR long long lf_to_crlf_##isa(const char *input, long long input_len, char *output,               \
+                                           long long output_size)                                               \
+    {                                                                                                           \
+        long long i = 0, o = 0;                                                                                 \
+        while (input_len - i >= (WIDTH) && output_size - o > (WIDTH))                                           \
+        {                                                                                                       \
+            mask_t mask = MASK(input + i, '\n');                                                                \
+            COPY(output + o, input + i);                                                                        \
+            if (mask == 0)                                                                                      \
+            {                                                                                                   \
+                i += (WIDTH);                                                                                   \
+                o += (WIDTH);                                                                                   \
+                continue;                                                                                       \
+            }                                                                                                   \
+            long long first = (long long)FIRST(mask);                                                           \
+            i += first + 1;                                                                                     \
+            o += first;                                                                                         \
+            output[o++] = '\r';                                                                                 \
+            output[o++] = '\n';                                                                                 \
+        }                                                                                                       \
+        long long tail = lf_to_crlf_scalar(input + i, input_len - i, output + o, output_size - o);              \
+        return tail < 0 ? -1 : o + tail;                                                                        \
+    }
+
+#ifdef LINECONV_HAVE_X86
+#define SSE2_ATTR __attribute__((target("sse2")))
+#define AVX2_ATTR __attribute__((target("avx2")))
+
+static inline SSE2_ATTR unsigned int sse2_mask(const char *p, char c)
+{
+    __m128i block = _mm_loadu_si128((const __m128i *)p);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+}
+
+static inline SSE2_ATTR void sse2_copy(char *dst, const char *src)
+{
+    _mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+}
+
+static inline AVX2_ATTR unsigned int avx2_mask(const char *p, char c)
+{
+    __m256i block = _mm256_loadu_si256((const __m256i *)p);
+    return (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(c)));
+}
+
+static inline AVX2_ATTR void avx2_copy(char *dst, const char *src)
+{
+    _mm256_storeu_si256((__m256i *)dst, _mm256_loadu_si256((const __m256i *)src));
+}
+
+LINECONV_DEFINE_KERNELS(sse2, 16, SSE2_ATTR, unsigned int, sse2_mask, __builtin_ctz, sse2_copy)
+LINECONV_DEFINE_KERNELS(avx2, 32, AVX2_ATTR, unsigned int, avx2_mask, __builtin_ctz, avx2_copy)
+
+static int sse2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+static int avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#ifdef LINECONV_HAVE_NEON
+/**
+ * @brief NEON has no movemask; narrowing by 4 bits gives one nibble per byte.
+ */
+static inline uint64_t neon_mask(const char *p, char c)
+{
+    uint8x16_t block = vld1q_u8((const uint8_t *)p);
+    uint8x16_t eq = vceqq_u8(block, vdupq_n_u8((uint8_t)c));
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+
+static inline void neon_copy(char *dst, const char *src)
+{
+    vst1q_u8((uint8_t *)dst, vld1q_u8((const uint8_t *)src));
+}
+
+#define NEON_FIRST(mask) (__builtin_ctzll(mask) >> 2)
+
+LINECONV_DEFINE_KERNELS(neon, 16, , uint64_t, neon_mask, NEON_FIRST, neon_copy)
+
+static int neon_supported(void)
+{
+    return 1; // Compiled in only where NEON is part of the target
+}
+#endif
+
+static int scalar_supported(void)
+{
+    return 1;
+}
+
+typedef struct
+{
+    const char *name;
+    lineconv_fn_t crlf_to_lf;
+    lineconv_fn_t lf_to_crlf;
+    int (*supported)(void);
+} lineconv_kernel_t;
+
+// Ordered from slowest to fastest; the last supported one is the default
+static const lineconv_kernel_t g_kernels[] = {
+    {"scalar", crlf_to_lf_scalar, lf_to_crlf_scalar, scalar_supported},
+#ifdef LINECONV_HAVE_X86
+    {"sse2", crlf_to_lf_sse2, lf_to_crlf_sse2, sse2_supported},
+    {"avx2", crlf_to_lf_avx2, lf_to_crlf_avx2, avx2_supported},
+#endif
+#ifdef LINECONV_HAVE_NEON
+    {"neon", crlf_to_lf_neon, lf_to_crlf_neon, neon_supported},
+#endif
+};
+
+#define LINECONV_KERNEL_COUNT ((int)(sizeof(g_kernels) / sizeof(g_kernels[0])))
+
+static pthread_once_t g_detect_once = PTHREAD_ONCE_INIT;
+static int g_best_kernel = 0;
+static const lineconv_kernel_t *g_active = &g_kernels[0];
+
+static void lineconv_detect(void)
+{
+    for (int i = LINECONV_KERNEL_COUNT - 1; i > 0; i--)
+    {
+        if (g_kernels[i].supported())
+        {
+            g_best_kernel = i;
+            break;
+        }
+    }
+    ATOMIC_STORE_RELEASE(&g_active, &g_kernels[g_best_kernel]);
+}
+
+static const lineconv_kernel_t *lineconv_kernel(void)
+{
+    pthread_once(&g_detect_once, lineconv_detect);
+    return ATOMIC_LOAD_ACQUIRE(&g_active);
+}
+
+void lineconv_state_init(lineconv_state_t *state)
+{
+    if (state)
+        state->pending_cr = 0;
+}
+
+long long lineconv_crlf_to_lf(lineconv_state_t *state, const char *input, long long input_len,
+                              char *output, long long output_size)
+{
+    if (!state || !input || !output || input_len < 0 || output_size <= 0)
+        return -1;
+
+    long long written = 0;
+    if (state->pending_cr && input_len > 0)
+    {
+        // The CR held from the previous chunk
+        output[written++] = input[0] == '\n' ? '\n' : '\r';
+        if (input[0] == '\n')
+        {
+            input++;
+            input_len--;
+        }
+        state->pending_cr = 0;
+    }
+
+    // Hold a trailing CR until the next chunk decides it
+    if (input_len > 0 && input[input_len - 1] == '\r')
+    {
+        state->pending_cr = 1;
+        input_len--;
+    }
+
+    long long converted = lineconv_kernel()->crlf_to_lf(input, input_len, output + written, output_size - written);
+    return converted < 0 ? -1 : written + converted;
+}
+
+long long lineconv_crlf_to_lf_finish(lineconv_state_t *state, char *output, long long output_size)
+{
+    if (!state || !output)
+        return -1;
+    if (!state->pending_cr)
+        return 0;
+    if (output_size < 1)
+        return -1;
+
+    state->pending_cr = 0;
+    output[0] = '\r';
+    return 1;
+}
+
+long long lineconv_lf_to_crlf(const char *input, long long input_len, char *output, long long output_size)
+{
+    if (!input || !output || input_len < 0 || output_size <= 0)
+        return -1;
+
+    return lineconv_kernel()->lf_to_crlf(input, input_len, output, output_size);
+}
+
+int lineconv_get_kernel_count(void)
+{
+    return LINECONV_KERNEL_COUNT;
+}
+
+const char *lineconv_get_kernel_name(int index)
+{
+    if (index < 0 || index >= LINECONV_KERNEL_COUNT)
+        return NULL;
+    return g_kernels[index].name;
+}
+
+int lineconv_is_kernel_supported(int index)
+{
+    if (index < 0 || index >= LINECONV_KERNEL_COUNT)
+        return 0;
+    return g_kernels[index].supported();
+}
+
+int lineconv_get_active_kernel(void)
+{
+    return (int)(lineconv_kernel() - g_kernels);
+}
+
+int lineconv_select_kernel(int index)
+{
+    pthread_once(&g_detect_once, lineconv_detect);
+
+    if (index < 0)
+    {
+        ATOMIC_STORE_RELEASE(&g_active, &g_kernels[g_best_kernel]);
+        return 0;
+    }
+    if (!lineconv_is_kernel_supported(index))
+        return -1;
+
+    ATOMIC_STORE_RELEASE(&g_active, &g_kernels[index]);
+    return 0;
+}
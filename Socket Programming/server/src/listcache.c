@@ -0,0 +1,278 @@
+/**
+ * @file listcache.c
+ * @brief Per-directory LIST output cache implementation
+ * @version 0.1
+ * @date 2025-11-24
+ *
+ */
+#include "listcache.h"
+
+#include "filesys.h"
+#include "logger.h"
+#include "session.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    char path[SESSION_MAX_PATH];
+    uint64_t hash;
+    time_t dir_mtime; // Directory mtime the listing was built from
+    time_t stored;    // When the entry was filled
+    time_t last_used; // For LRU replacement
+    char *data;       // Formatted listing, NULL for a free slot
+    size_t length;
+} listcache_entry_t;
+
+// Global cache state
+static struct
+{
+    listcache_entry_t *entries;
+    int max_entries;
+    int ttl;                  // Seconds
+    unsigned long generation; // Bumped by every invalidation
+    pthread_mutex_t mutex;
+} g_listcache = {NULL, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief FNV-1a hash of a path
+ */
+static uint64_t listcache_hash(const char *path)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static listcache_entry_t *listcache_find(const char *path, uint64_t hash)
+{
+    for (int i = 0; i < g_listcache.max_entries; i++)
+    {
+        listcache_entry_t *entry = &g_listcache.entries[i];
+        if (entry->data && entry->hash == hash && strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void listcache_drop(listcache_entry_t *entry)
+{
+    free(entry->data);
+    entry->data = NULL;
+    entry->length = 0;
+}
+
+int listcache_init(int ttl_seconds, int max_entries)
+{
+    if (ttl_seconds <= 0)
+    {
+        return 0;
+    }
+
+    if (max_entries <= 0)
+    {
+        max_entries = LISTCACHE_DEFAULT_ENTRIES;
+    }
+
+    listcache_entry_t *entries = (listcache_entry_t *)calloc((size_t)max_entries, sizeof(listcache_entry_t));
+    if (!entries)
+    {
+        LOG_ERROR("Failed to allocate listing cache");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_listcache.mutex);
+    g_listcache.entries = entries;
+    g_listcache.max_entries = max_entries;
+    g_listcache.ttl = ttl_seconds;
+    pthread_mutex_unlock(&g_listcache.mutex);
+
+    LOG_INFO("Listing cache enabled: ttl=%ds, entries=%d", ttl_seconds, max_entries);
+    return 0;
+}
+
+void listcache_cleanup(void)
+{
+    pthread_mutex_lock(&g_listcache.mutex);
+    for (int i = 0; i < g_listcache.max_entries; i++)
+    {
+        listcache_drop(&g_listcache.entries[i]);
+    }
+    free(g_listcache.entries);
+    g_listcache.entries = NULL;
+    g_listcache.max_entries = 0;
+    g_listcache.ttl = 0;
+    pthread_mutex_unlock(&g_listcache.mutex);
+}
+
+int listcache_is_enabled(void)
+{
+    pthread_mutex_lock(&g_listcache.mutex);
+    int enabled = g_listcache.entries != NULL;
+    pthread_mutex_unlock(&g_listcache.mutex);
+
+    return enabled;
+}
+
+int listcache_lookup(const char *dirpath, time_t dir_mtime, char **data, size_t *length)
+{
+    if (!dirpath || !data || !length)
+    {
+        return -1;
+    }
+
+    uint64_t hash = listcache_hash(dirpath);
+    time_t now = time(NULL);
+    int result = -1;
+
+    pthread_mutex_lock(&g_listcache.mutex);
+
+    listcache_entry_t *entry = g_listcache.entries ? listcache_find(dirpath, hash) : NULL;
+    if (entry)
+    {
+        if (entry->dir_mtime != dir_mtime || now - entry->stored >= g_listcache.ttl)
+        {
+            listcache_drop(entry);
+        }
+        else
+        {
+            char *copy = (char *)malloc(entry->length);
+            if (copy)
+            {
+                memcpy(copy, entry->data, entry->length);
+                *data = copy;
+                *length = entry->length;
+                entry->last_used = now;
+                result = 0;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&g_listcache.mutex);
+
+    return result;
+}
+
+unsigned long listcache_get_generation(void)
+{
+    pthread_mutex_lock(&g_listcache.mutex);
+    unsigned long generation = g_listcache.generation;
+    pthread_mutex_unlock(&g_listcache.mutex);
+
+    return generation;
+}
+
+void listcache_store(const char *dirpath, time_t dir_mtime, unsigned long generation,
+                     const char *data, size_t length)
+{
+    if (!dirpath || !data || length == 0 || length > LISTCACHE_MAX_LISTING ||
+        strlen(dirpath) >= SESSION_MAX_PATH)
+    {
+        return;
+    }
+
+    // A change later in the same second would leave the mtime unchanged
+    time_t now = time(NULL);
+    if (dir_mtime >= now - 1)
+    {
+        return;
+    }
+
+    char *copy = (char *)malloc(length);
+    if (!copy)
+    {
+        return;
+    }
+    memcpy(copy, data, length);
+
+    uint64_t hash = listcache_hash(dirpath);
+
+    pthread_mutex_lock(&g_listcache.mutex);
+
+    if (!g_listcache.entries || generation != g_listcache.generation)
+    {
+        // Disabled, or something was invalidated while the listing was built
+        pthread_mutex_unlock(&g_listcache.mutex);
+        free(copy);
+        return;
+    }
+
+    listcache_entry_t *entry = listcache_find(dirpath, hash);
+    if (!entry)
+    {
+        // Take a free slot, otherwise replace the least recently used one
+        entry = &g_listcache.entries[0];
+        for (int i = 0; i < g_listcache.max_entries; i++)
+        {
+            listcache_entry_t *candidate = &g_listcache.entries[i];
+            if (!candidate->data)
+            {
+                entry = candidate;
+                break;
+            }
+            if (candidate->last_used < entry->last_used)
+            {
+                entry = candidate;
+            }
+        }
+    }
+
+    listcache_drop(entry);
+    snprintf(entry->path, sizeof(entry->path), "%s", dirpath);
+    entry->hash = hash;
+    entry->dir_mtime = dir_mtime;
+    entry->stored = now;
+    entry->last_used = now;
+    entry->data = copy;
+    entry->length = length;
+
+    pthread_mutex_unlock(&g_listcache.mutex);
+}
+
+void listcache_invalidate(const char *path)
+{
+    if (!path)
+    {
+        return;
+    }
+
+    char parent[SESSION_MAX_PATH];
+    int has_parent = fs_get_parent_directory(path, parent, sizeof(parent)) == 0;
+
+    uint64_t hash = listcache_hash(path);
+    uint64_t parent_hash = has_parent ? listcache_hash(parent) : 0;
+
+    pthread_mutex_lock(&g_listcache.mutex);
+
+    if (g_listcache.entries)
+    {
+        g_listcache.generation++;
+
+        listcache_entry_t *entry = listcache_find(path, hash);
+        if (entry)
+        {
+            listcache_drop(entry);
+        }
+
+        if (has_parent)
+        {
+            entry = listcache_find(parent, parent_hash);
+            if (entry)
+            {
+                listcache_drop(entry);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&g_listcache.mutex);
+}
@@ -10,20 +10,27 @@
 #include "logger.h"
 #include "filesys.h"
 #include "utils.h"
+#include "atomics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <io.h>
+#include <windows.h>
 #define isatty _isatty
 #define fileno _fileno
 #else
 #include <unistd.h>
 #endif
 
+#define LOG_ASYNC_FLUSH_INTERVAL_MS 50 // Writer drains the ring at least this often
+#define LOG_ASYNC_BATCH_SIZE 65536     // Bytes handed to the stream per write by the writer
+#define LOG_ASYNC_BLOCK_WAIT_MS 10     // Re-check interval for blocked producers
+
 // String map for LogLevel
 static const char *level_strings[] = {
     "DEBUG",
@@ -50,6 +57,378 @@ static struct
     pthread_mutex_t lock;
 } g_logger = {NULL, LOG_LEVEL_INFO, 0, PTHREAD_MUTEX_INITIALIZER};
 
+/**
+ * @brief Ring buffer slot (bounded MPMC queue cell, Vyukov style)
+ *
+ * sequence == position:     free, a producer may claim it
+ * sequence == position + 1: published, the writer may consume it
+ */
+typedef struct
+{
+    size_t sequence;
+    log_level_t level;
+    size_t length;
+    char text[LOG_ASYNC_LINE_MAX];
+} log_slot_t;
+
+// Asynchronous backend state
+static struct
+{
+    log_slot_t *slots;
+    size_t mask;                            // Slot count - 1
+    size_t enqueue_pos;                     // Next position claimed by producers (atomic)
+    size_t dequeue_pos;                     // Next position consumed by the writer (atomic)
+    log_overflow_policy_t policy;
+    int in_tty;                             // Output is a terminal (colored headers)
+    int active;                             // Producers may use the ring (atomic)
+    int in_flight;                          // Producers currently inside the ring (atomic)
+    int wake_pending;                       // Writer has been asked to run (atomic)
+    unsigned long long dropped;             // Messages lost to a full ring (atomic)
+    unsigned long long dropped_reported;    // Drops already mentioned in the log (writer only)
+    int flush_requests;                     // logger_flush() callers waiting (under mutex)
+    size_t synced_pos;                      // Everything before this is written and synced (under mutex)
+    int running;                            // Writer thread alive (under mutex)
+    int stop;                               // Writer should drain and exit (under mutex)
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;                    // Wakes the writer
+    pthread_cond_t progress;                // Writer freed slots or finished a sync
+} g_async = {.mutex = PTHREAD_MUTEX_INITIALIZER,
+             .wake = PTHREAD_COND_INITIALIZER,
+             .progress = PTHREAD_COND_INITIALIZER};
+
+/**
+ * @brief Computes an absolute CLOCK_REALTIME deadline for pthread_cond_timedwait
+ */
+static void logger_deadline(struct timespec *ts, int timeout_ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Pushes buffered stream data to stable storage (no-op for stdout/stderr)
+ */
+static void logger_sync_file(FILE *fp)
+{
+    if (!fp || fp == stdout || fp == stderr)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    _commit(_fileno(fp));
+#else
+    fsync(fileno(fp));
+#endif
+}
+
+/**
+ * @brief Asks the writer thread to run now
+ */
+static void logger_async_wake(void)
+{
+    if (ATOMIC_LOAD_RELAXED(&g_async.wake_pending))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_async.mutex);
+    ATOMIC_STORE_RELAXED(&g_async.wake_pending, 1);
+    pthread_cond_signal(&g_async.wake);
+    pthread_mutex_unlock(&g_async.mutex);
+}
+
+/**
+ * @brief Claims a free slot for a producer
+ *
+ * @param out_pos Receives the claimed position
+ * @return The slot, or NULL if the ring is full
+ */
+static log_slot_t *logger_async_claim(size_t *out_pos)
+{
+    size_t pos = ATOMIC_LOAD_RELAXED(&g_async.enqueue_pos);
+
+    for (;;)
+    {
+        log_slot_t *slot = &g_async.slots[pos & g_async.mask];
+        size_t seq = ATOMIC_LOAD_ACQUIRE(&slot->sequence);
+        long diff = (long)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (ATOMIC_CAS_WEAK_RELAXED(&g_async.enqueue_pos, &pos, pos + 1))
+            {
+                *out_pos = pos;
+                return slot;
+            }
+            // pos was reloaded by the failed CAS
+        }
+        else if (diff < 0)
+        {
+            // The writer has not consumed this slot from the previous lap yet
+            return NULL;
+        }
+        else
+        {
+            pos = ATOMIC_LOAD_RELAXED(&g_async.enqueue_pos);
+        }
+    }
+}
+
+/**
+ * @brief Formats one message into the ring
+ *
+ * @return 0 if the message was queued or dropped, -1 if async mode is off
+ */
+static int logger_async_log(log_level_t level, const char *timestamp, const char *ex_filename,
+                            int line, const char *funcname, const char *format, va_list args)
+{
+    ATOMIC_FETCH_ADD(&g_async.in_flight, 1);
+    if (!ATOMIC_LOAD(&g_async.active))
+    {
+        ATOMIC_FETCH_SUB(&g_async.in_flight, 1);
+        return -1;
+    }
+
+    size_t pos;
+    log_slot_t *slot;
+    while ((slot = logger_async_claim(&pos)) == NULL)
+    {
+        if (g_async.policy == LOG_OVERFLOW_DROP)
+        {
+            ATOMIC_FETCH_ADD_RELAXED(&g_async.dropped, 1);
+            ATOMIC_FETCH_SUB(&g_async.in_flight, 1);
+            return 0;
+        }
+
+        // LOG_OVERFLOW_BLOCK: wait for the writer to free slots
+        struct timespec deadline;
+        logger_deadline(&deadline, LOG_ASYNC_BLOCK_WAIT_MS);
+        pthread_mutex_lock(&g_async.mutex);
+        ATOMIC_STORE_RELAXED(&g_async.wake_pending, 1);
+        pthread_cond_signal(&g_async.wake);
+        pthread_cond_timedwait(&g_async.progress, &g_async.mutex, &deadline);
+        pthread_mutex_unlock(&g_async.mutex);
+    }
+
+    // Keep one byte for the newline
+    size_t cap = sizeof(slot->text) - 1;
+    int n;
+    if (g_async.in_tty)
+    {
+        n = snprintf(slot->text, cap, "%s[%s]%s[%s][%s:%d:%s] ",
+                     level_colors[level], level_strings[level], COLOR_RESET,
+                     timestamp, ex_filename, line, funcname);
+    }
+    else
+    {
+        n = snprintf(slot->text, cap, "[%s][%s][%s:%d:%s] ",
+                     level_strings[level], timestamp, ex_filename, line, funcname);
+    }
+    if (n < 0)
+        n = 0;
+    if ((size_t)n >= cap)
+        n = (int)cap - 1;
+
+    int m = vsnprintf(slot->text + n, cap - (size_t)n, format, args);
+    if (m < 0)
+        m = 0;
+    if ((size_t)m >= cap - (size_t)n)
+        m = (int)(cap - (size_t)n) - 1;
+
+    size_t length = (size_t)n + (size_t)m;
+    slot->text[length++] = '\n';
+    slot->length = length;
+    slot->level = level;
+
+    // Publish to the writer
+    ATOMIC_STORE_RELEASE(&slot->sequence, pos + 1);
+    ATOMIC_FETCH_SUB(&g_async.in_flight, 1);
+
+    // Errors are made durable promptly, and a half-full ring is drained early
+    size_t backlog = pos - ATOMIC_LOAD_RELAXED(&g_async.dequeue_pos);
+    if (level == LOG_LEVEL_ERROR || backlog >= (g_async.mask + 1) / 2)
+    {
+        logger_async_wake();
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes out all published slots (writer thread only)
+ *
+ * @param error_seen Set to 1 if an ERROR message was written
+ * @return Number of messages written
+ */
+static size_t logger_async_drain(int *error_seen)
+{
+    static char batch[LOG_ASYNC_BATCH_SIZE]; // Only the writer thread uses it
+    size_t used = 0;
+    size_t count = 0;
+
+    pthread_mutex_lock(&g_logger.lock);
+
+    for (;;)
+    {
+        size_t pos = ATOMIC_LOAD_RELAXED(&g_async.dequeue_pos);
+        log_slot_t *slot = &g_async.slots[pos & g_async.mask];
+        if (ATOMIC_LOAD_ACQUIRE(&slot->sequence) != pos + 1)
+        {
+            // Empty, or the next producer has not finished formatting yet
+            break;
+        }
+
+        if (used + slot->length > sizeof(batch))
+        {
+            if (g_logger.fp)
+                fwrite(batch, 1, used, g_logger.fp);
+            used = 0;
+        }
+        memcpy(batch + used, slot->text, slot->length);
+        used += slot->length;
+
+        if (slot->level == LOG_LEVEL_ERROR)
+        {
+            *error_seen = 1;
+        }
+
+        // Hand the slot back to producers for the next lap
+        ATOMIC_STORE_RELEASE(&slot->sequence, pos + g_async.mask + 1);
+        ATOMIC_STORE_RELEASE(&g_async.dequeue_pos, pos + 1);
+        count++;
+    }
+
+    if (used > 0 && g_logger.fp)
+    {
+        fwrite(batch, 1, used, g_logger.fp);
+    }
+
+    // Mention overflow once per batch rather than once per lost message
+    unsigned long long dropped = ATOMIC_LOAD_RELAXED(&g_async.dropped);
+    if (dropped != g_async.dropped_reported && g_logger.fp)
+    {
+        char timestamp[32];
+        get_timestamp(timestamp, sizeof(timestamp));
+        fprintf(g_logger.fp, "[%s][%s][%s:%d:%s] %llu log messages dropped (ring buffer full)\n",
+                level_strings[LOG_LEVEL_WARN], timestamp, fs_extract_filename(__FILE__), __LINE__, __func__,
+                dropped - g_async.dropped_reported);
+        g_async.dropped_reported = dropped;
+        count++;
+    }
+
+    pthread_mutex_unlock(&g_logger.lock);
+
+    return count;
+}
+
+static void *logger_async_writer(void *arg)
+{
+    (void)arg;
+
+    for (;;)
+    {
+        int error_seen = 0;
+        size_t written = logger_async_drain(&error_seen);
+
+        pthread_mutex_lock(&g_async.mutex);
+        int sync_wanted = error_seen || g_async.flush_requests > 0;
+        pthread_mutex_unlock(&g_async.mutex);
+
+        if (written > 0 || sync_wanted)
+        {
+            pthread_mutex_lock(&g_logger.lock);
+            if (g_logger.fp)
+            {
+                fflush(g_logger.fp);
+                if (sync_wanted)
+                {
+                    logger_sync_file(g_logger.fp);
+                }
+            }
+            pthread_mutex_unlock(&g_logger.lock);
+        }
+
+        pthread_mutex_lock(&g_async.mutex);
+
+        if (sync_wanted)
+        {
+            g_async.synced_pos = ATOMIC_LOAD_RELAXED(&g_async.dequeue_pos);
+        }
+        if (written > 0 || sync_wanted)
+        {
+            pthread_cond_broadcast(&g_async.progress);
+        }
+
+        if (g_async.stop &&
+            ATOMIC_LOAD(&g_async.enqueue_pos) == ATOMIC_LOAD_RELAXED(&g_async.dequeue_pos))
+        {
+            pthread_mutex_unlock(&g_async.mutex);
+            break;
+        }
+
+        if (!ATOMIC_LOAD_RELAXED(&g_async.wake_pending) && !g_async.stop)
+        {
+            struct timespec deadline;
+            logger_deadline(&deadline, LOG_ASYNC_FLUSH_INTERVAL_MS);
+            pthread_cond_timedwait(&g_async.wake, &g_async.mutex, &deadline);
+        }
+        ATOMIC_STORE_RELAXED(&g_async.wake_pending, 0);
+
+        pthread_mutex_unlock(&g_async.mutex);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Stops the writer after producers have left the ring and the ring is drained
+ */
+static void logger_async_stop(void)
+{
+    pthread_mutex_lock(&g_async.mutex);
+    if (!g_async.running)
+    {
+        pthread_mutex_unlock(&g_async.mutex);
+        return;
+    }
+    pthread_mutex_unlock(&g_async.mutex);
+
+    // New messages go through the synchronous path from here on
+    ATOMIC_STORE(&g_async.active, 0);
+    while (ATOMIC_LOAD(&g_async.in_flight) > 0)
+    {
+#ifdef _WIN32
+        Sleep(1);
+#else
+        usleep(1000);
+#endif
+    }
+
+    pthread_mutex_lock(&g_async.mutex);
+    g_async.stop = 1;
+    pthread_cond_signal(&g_async.wake);
+    pthread_mutex_unlock(&g_async.mutex);
+
+    pthread_join(g_async.writer, NULL);
+
+    pthread_mutex_lock(&g_async.mutex);
+    g_async.running = 0;
+    g_async.stop = 0;
+    pthread_cond_broadcast(&g_async.progress);
+    pthread_mutex_unlock(&g_async.mutex);
+
+    free(g_async.slots);
+    g_async.slots = NULL;
+}
+
 int logger_init(const char *log_file, log_level_t level)
 {
     if (g_logger.initialized)
@@ -101,6 +480,19 @@ void logger_log(log_level_t level, const char *filename,
     // Get filename
     const char *ex_filename = fs_extract_filename(filename);
 
+    // Asynchronous mode: format into the ring, the writer thread does the I/O
+    if (ATOMIC_LOAD_RELAXED(&g_async.active))
+    {
+        va_list async_args;
+        va_start(async_args, format);
+        int queued = logger_async_log(level, timestamp, ex_filename, line, funcname, format, async_args);
+        va_end(async_args);
+        if (queued == 0)
+        {
+            return;
+        }
+    }
+
     pthread_mutex_lock(&g_logger.lock);
 
     // Double-check
@@ -142,8 +534,123 @@ void logger_log(log_level_t level, const char *filename,
     pthread_mutex_unlock(&g_logger.lock);
 }
 
+int logger_enable_async(unsigned int capacity, log_overflow_policy_t policy)
+{
+    if (!g_logger.initialized)
+    {
+        fprintf(stderr, "Logger must be initialized before enabling async mode\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_async.mutex);
+    int running = g_async.running;
+    pthread_mutex_unlock(&g_async.mutex);
+    if (running)
+    {
+        return -1;
+    }
+
+    if (capacity == 0)
+    {
+        capacity = LOG_ASYNC_DEFAULT_CAPACITY;
+    }
+
+    // Round up to a power of two so positions map to slots with a mask
+    size_t slots = 2;
+    while (slots < capacity)
+    {
+        slots <<= 1;
+    }
+
+    g_async.slots = (log_slot_t *)malloc(slots * sizeof(log_slot_t));
+    if (!g_async.slots)
+    {
+        fprintf(stderr, "Failed to allocate async log buffer\n");
+        return -1;
+    }
+    for (size_t i = 0; i < slots; i++)
+    {
+        g_async.slots[i].sequence = i;
+    }
+
+    g_async.mask = slots - 1;
+    g_async.enqueue_pos = 0;
+    g_async.dequeue_pos = 0;
+    g_async.policy = policy;
+    g_async.in_tty = (g_logger.fp == stdout || g_logger.fp == stderr) && isatty(fileno(g_logger.fp));
+    g_async.in_flight = 0;
+    g_async.wake_pending = 0;
+    g_async.dropped = 0;
+    g_async.dropped_reported = 0;
+    g_async.flush_requests = 0;
+    g_async.synced_pos = 0;
+    g_async.stop = 0;
+
+    // Flush what the synchronous path buffered so ordering is kept
+    pthread_mutex_lock(&g_logger.lock);
+    if (g_logger.fp)
+    {
+        fflush(g_logger.fp);
+    }
+    pthread_mutex_unlock(&g_logger.lock);
+
+    if (pthread_create(&g_async.writer, NULL, logger_async_writer, NULL) != 0)
+    {
+        fprintf(stderr, "Failed to start log writer thread\n");
+        free(g_async.slots);
+        g_async.slots = NULL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_async.mutex);
+    g_async.running = 1;
+    pthread_mutex_unlock(&g_async.mutex);
+
+    ATOMIC_STORE(&g_async.active, 1);
+
+    return 0;
+}
+
+void logger_flush(void)
+{
+    pthread_mutex_lock(&g_async.mutex);
+    if (g_async.running && ATOMIC_LOAD(&g_async.active))
+    {
+        size_t target = ATOMIC_LOAD(&g_async.enqueue_pos);
+
+        g_async.flush_requests++;
+        ATOMIC_STORE_RELAXED(&g_async.wake_pending, 1);
+        pthread_cond_signal(&g_async.wake);
+        while (g_async.running && g_async.synced_pos < target)
+        {
+            pthread_cond_wait(&g_async.progress, &g_async.mutex);
+        }
+        g_async.flush_requests--;
+
+        pthread_mutex_unlock(&g_async.mutex);
+        return;
+    }
+    pthread_mutex_unlock(&g_async.mutex);
+
+    pthread_mutex_lock(&g_logger.lock);
+    if (g_logger.initialized && g_logger.fp)
+    {
+        fflush(g_logger.fp);
+        logger_sync_file(g_logger.fp);
+    }
+    pthread_mutex_unlock(&g_logger.lock);
+}
+
+unsigned long long logger_get_dropped_count(void)
+{
+    return ATOMIC_LOAD_RELAXED(&g_async.dropped);
+}
+
 void logger_close(void)
 {
+    // Drain and stop the writer before the stream goes away
+    logger_async_stop();
+
     pthread_mutex_lock(&g_logger.lock);
     if (g_logger.initialized && g_logger.fp &&
         g_logger.fp != stdout && g_logger.fp != stderr)
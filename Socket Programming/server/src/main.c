@@ -6,6 +6,8 @@
  */
 
 #include "server.h"
+#include "transfer.h"
+#include "ratelimit.h"
 #include "logger.h"
 #include "network.h"
 
@@ -20,8 +22,22 @@
 #define DEFAULT_BIND_ADDRESS "127.0.0.1" // Bind to localhost only for security
 #define DEFAULT_MAX_BACKLOG 10
 #define DEFAULT_COMMAND_TIMEOUT_MS 300000    // 5 minutes
+#define DEFAULT_DATA_TIMEOUT_MS 300000       // 5 minutes without data moving
 #define DEFAULT_MAX_CONNECTIONS 100          // Maximum concurrent connections
 #define DEFAULT_ADDRESS_FAMILY NET_AF_UNSPEC // Default to unspecified (auto-detect)
+#define DEFAULT_ENGINE SERVER_ENGINE_THREADED // One thread per client
+#define DEFAULT_EVENT_THREADS 0              // Auto (based on CPU count)
+#define DEFAULT_TRANSFER_WORKERS 0           // Auto (one per allowed connection)
+#define DEFAULT_LISTING_CACHE_TTL 0          // Listing cache disabled
+#define DEFAULT_PASV_PORT_MIN 20000
+#define DEFAULT_PASV_PORT_MAX 65535
+#define DEFAULT_PASV_PREBIND 0               // No pre-bound passive sockets
+#define DEFAULT_COMPRESSION_LEVEL 6          // zlib default, for MODE Z
+#define DEFAULT_PIPELINE_DEPTH 4             // Buffers in flight per file transfer
+#define DEFAULT_RATE_LIMIT 0                 // No bandwidth limit
+#define DEFAULT_METRICS_PORT 0               // No metrics endpoint
+#define DEFAULT_HOT_CACHE_BYTES 0            // No file cache
+#define DEFAULT_ACCEPTOR_THREADS 1           // Main thread accepts alone
 
 /**
  * @brief Signal handler for graceful shutdown
@@ -32,6 +48,34 @@ void signal_handler(int signum)
     server_stop();
 }
 
+/**
+ * @brief Parses a rate in bytes per second, or a size in bytes, with an optional K, M or G suffix (powers of 1024)
+ *
+ * @return 0 on success, -1 if the value is malformed or above RATELIMIT_MAX_RATE
+ */
+static int parse_rate(const char *text, unsigned long long *rate)
+{
+    char *end;
+    if (text[0] < '0' || text[0] > '9')
+        return -1;
+    unsigned long long value = strtoull(text, &end, 10);
+
+    unsigned long long scale = 1;
+    if (*end == 'K' || *end == 'k')
+        scale = 1024ULL;
+    else if (*end == 'M' || *end == 'm')
+        scale = 1024ULL * 1024;
+    else if (*end == 'G' || *end == 'g')
+        scale = 1024ULL * 1024 * 1024;
+    if (scale > 1)
+        end++;
+
+    if (*end != '\0' || value > RATELIMIT_MAX_RATE / scale)
+        return -1;
+    *rate = value * scale;
+    return 0;
+}
+
 /**
  * @brief Prints usage information
  */
@@ -44,7 +88,28 @@ void print_usage(const char *program_name)
     printf("  -b, -bind <address>    Address to bind to (default: %s)\n", DEFAULT_BIND_ADDRESS);
     printf("  -a, -addr <family>     Address family: ipv4, ipv6, unspec (default: unspec)\n");
     printf("  -l <log_level>  Log level: DEBUG, INFO, WARN, ERROR (default: INFO)\n");
+    printf("  -A <policy>     Asynchronous logging, when the buffer is full: drop, block (default: synchronous)\n");
     printf("  -c <max_conn>   Maximum concurrent connections (default: %d, -1 for unlimited)\n", DEFAULT_MAX_CONNECTIONS);
+    printf("  -e <engine>     Connection engine: threaded, event (default: threaded)\n");
+    printf("  -t <threads>    Event loop threads for the event engine (default: auto)\n");
+    printf("  -w <workers>    Maximum transfer worker threads (default: max connections)\n");
+    printf("  -C <seconds>    Cache LIST output per directory for up to <seconds> (default: off)\n");
+    printf("  -P <min>-<max>  Passive mode port range (default: %d-%d)\n", DEFAULT_PASV_PORT_MIN, DEFAULT_PASV_PORT_MAX);
+    printf("  -B <count>      Passive listening sockets to keep bound ahead of time (default: %d)\n", DEFAULT_PASV_PREBIND);
+    printf("  -z <level>      Default MODE Z compression level, 0-9 (default: %d)\n", DEFAULT_COMPRESSION_LEVEL);
+    printf("  -R <buffers>    Read-ahead/write-behind buffers per file transfer, 1-64 (default: %d, 1 disables)\n", DEFAULT_PIPELINE_DEPTH);
+    printf("  -S <policy>     Upload durability: none, close, periodic (default: close)\n");
+    printf("  -T              Upload fresh files to a temporary name, renamed into place on success\n");
+    printf("  -G <rate>       Bandwidth for all transfers together, bytes/s with K/M/G suffix (default: unlimited)\n");
+    printf("  -L <rate>       Bandwidth for the transfers of each session (default: unlimited)\n");
+    printf("  -H <size>       Keep small popular files in memory, up to <size> bytes with K/M/G suffix (default: off)\n");
+    printf("  -M <port>       Serve Prometheus metrics over HTTP on <port> (default: off)\n");
+    printf("  -N <threads>    Acceptor threads, each with its own SO_REUSEPORT socket where supported (default: %d, max %d)\n",
+           DEFAULT_ACCEPTOR_THREADS, SERVER_MAX_ACCEPTORS);
+    printf("  -K              Pin acceptor threads to CPUs\n");
+    printf("  -s <cert.pem>   Enable AUTH TLS with this certificate chain (requires an OpenSSL build)\n");
+    printf("  -k <key.pem>    Private key for -s (default: read from the certificate file)\n");
+    printf("  -F              Require TLS for logins and data connections\n");
     printf("  -h              Show this help message\n");
 }
 
@@ -58,14 +123,34 @@ int main(int argc, char *argv[])
         .port = DEFAULT_PORT,
         .max_backlog = DEFAULT_MAX_BACKLOG,
         .command_timeout_ms = DEFAULT_COMMAND_TIMEOUT_MS,
+        .data_timeout_ms = DEFAULT_DATA_TIMEOUT_MS,
         .max_connections = DEFAULT_MAX_CONNECTIONS,
-        .address_family = DEFAULT_ADDRESS_FAMILY};
+        .address_family = DEFAULT_ADDRESS_FAMILY,
+        .engine = DEFAULT_ENGINE,
+        .event_threads = DEFAULT_EVENT_THREADS,
+        .transfer_workers = DEFAULT_TRANSFER_WORKERS,
+        .listing_cache_ttl = DEFAULT_LISTING_CACHE_TTL,
+        .pasv_port_min = DEFAULT_PASV_PORT_MIN,
+        .pasv_port_max = DEFAULT_PASV_PORT_MAX,
+        .pasv_prebind = DEFAULT_PASV_PREBIND,
+        .compression_level = DEFAULT_COMPRESSION_LEVEL,
+        .pipeline_depth = DEFAULT_PIPELINE_DEPTH,
+        .upload_durability = TRANSFER_DURABILITY_CLOSE,
+        .atomic_uploads = 0,
+        .global_rate_limit = DEFAULT_RATE_LIMIT,
+        .session_rate_limit = DEFAULT_RATE_LIMIT,
+        .metrics_port = DEFAULT_METRICS_PORT,
+        .hot_cache_bytes = DEFAULT_HOT_CACHE_BYTES,
+        .acceptor_threads = DEFAULT_ACCEPTOR_THREADS,
+        .acceptor_pinning = 0};
     strncpy(config.root_dir, DEFAULT_ROOT_DIR, sizeof(config.root_dir) - 1);
     config.root_dir[sizeof(config.root_dir) - 1] = '\0';
     strncpy(config.bind_address, DEFAULT_BIND_ADDRESS, sizeof(config.bind_address) - 1);
     config.bind_address[sizeof(config.bind_address) - 1] = '\0';
 
     log_level_t log_level = LOG_LEVEL_INFO;
+    int async_log = 0;
+    log_overflow_policy_t log_overflow = LOG_OVERFLOW_DROP;
 
     for (int i = 1; i < argc; i++)
     {
@@ -111,10 +196,171 @@ int main(int argc, char *argv[])
             else if (strcmp(argv[i], "ERROR") == 0)
                 log_level = LOG_LEVEL_ERROR;
         }
+        else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc)
+        {
+            i++;
+            async_log = 1;
+            if (strcmp(argv[i], "drop") == 0)
+                log_overflow = LOG_OVERFLOW_DROP;
+            else if (strcmp(argv[i], "block") == 0)
+                log_overflow = LOG_OVERFLOW_BLOCK;
+            else
+            {
+                fprintf(stderr, "Invalid log overflow policy: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
         else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
         {
             config.max_connections = atoi(argv[++i]);
         }
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "threaded") == 0)
+                config.engine = SERVER_ENGINE_THREADED;
+            else if (strcmp(argv[i], "event") == 0)
+                config.engine = SERVER_ENGINE_EVENT;
+            else
+            {
+                fprintf(stderr, "Invalid engine: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            config.event_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            config.transfer_workers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc)
+        {
+            config.listing_cache_ttl = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc)
+        {
+            int port_min = 0;
+            int port_max = 0;
+            if (sscanf(argv[++i], "%d-%d", &port_min, &port_max) != 2 || port_min < 1 ||
+                port_max > 65535 || port_min > port_max)
+            {
+                fprintf(stderr, "Invalid passive port range: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            config.pasv_port_min = (uint16_t)port_min;
+            config.pasv_port_max = (uint16_t)port_max;
+        }
+        else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc)
+        {
+            config.pasv_prebind = atoi(argv[++i]);
+            if (config.pasv_prebind < 0)
+                config.pasv_prebind = 0;
+        }
+        else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc)
+        {
+            config.compression_level = atoi(argv[++i]);
+            if (config.compression_level < 0 || config.compression_level > 9)
+            {
+                fprintf(stderr, "Invalid compression level: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc)
+        {
+            config.pipeline_depth = atoi(argv[++i]);
+            if (config.pipeline_depth < 1 || config.pipeline_depth > 64)
+            {
+                fprintf(stderr, "Invalid pipeline depth: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "none") == 0)
+                config.upload_durability = TRANSFER_DURABILITY_NONE;
+            else if (strcmp(argv[i], "close") == 0)
+                config.upload_durability = TRANSFER_DURABILITY_CLOSE;
+            else if (strcmp(argv[i], "periodic") == 0)
+                config.upload_durability = TRANSFER_DURABILITY_PERIODIC;
+            else
+            {
+                fprintf(stderr, "Invalid durability policy: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-T") == 0)
+        {
+            config.atomic_uploads = 1;
+        }
+        else if ((strcmp(argv[i], "-G") == 0 || strcmp(argv[i], "-L") == 0) && i + 1 < argc)
+        {
+            unsigned long long *rate = argv[i][1] == 'G' ? &config.global_rate_limit : &config.session_rate_limit;
+            if (parse_rate(argv[++i], rate) != 0)
+            {
+                fprintf(stderr, "Invalid rate limit: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+        {
+            unsigned long long size;
+            if (parse_rate(argv[++i], &size) != 0 || size > SIZE_MAX)
+            {
+                fprintf(stderr, "Invalid file cache size: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            config.hot_cache_bytes = (size_t)size;
+        }
+        else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc)
+        {
+            int port = atoi(argv[++i]);
+            if (port < 1 || port > 65535)
+            {
+                fprintf(stderr, "Invalid metrics port: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+            config.metrics_port = (uint16_t)port;
+        }
+        else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc)
+        {
+            config.acceptor_threads = atoi(argv[++i]);
+            if (config.acceptor_threads < 1 || config.acceptor_threads > SERVER_MAX_ACCEPTORS)
+            {
+                fprintf(stderr, "Invalid acceptor thread count: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-K") == 0)
+        {
+            config.acceptor_pinning = 1;
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            strncpy(config.tls_cert_file, argv[++i], sizeof(config.tls_cert_file) - 1);
+            config.tls_cert_file[sizeof(config.tls_cert_file) - 1] = '\0';
+        }
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+        {
+            strncpy(config.tls_key_file, argv[++i], sizeof(config.tls_key_file) - 1);
+            config.tls_key_file[sizeof(config.tls_key_file) - 1] = '\0';
+        }
+        else if (strcmp(argv[i], "-F") == 0)
+        {
+            config.tls_required = 1;
+        }
         else if (strcmp(argv[i], "-h") == 0)
         {
             print_usage(argv[0]);
@@ -128,6 +374,13 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (config.tls_required && config.tls_cert_file[0] == '\0')
+    {
+        fprintf(stderr, "-F requires a certificate (-s)\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
     // Initialize logger
     if (logger_init(NULL, log_level) != 0)
     {
@@ -135,6 +388,11 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (async_log && logger_enable_async(LOG_ASYNC_DEFAULT_CAPACITY, log_overflow) != 0)
+    {
+        fprintf(stderr, "Failed to enable asynchronous logging, using synchronous logging\n");
+    }
+
     // Set up signal handlers for shutdown
 #ifdef _WIN32
     signal(SIGINT, signal_handler);
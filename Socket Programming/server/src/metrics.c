@@ -0,0 +1,661 @@
+/**
+ * @file metrics.c
+ * @brief Server-wide counters and latency histograms implementation
+ * @version 0.1
+ * @date 2025-11-30
+ *
+ */
+#define _POSIX_C_SOURCE 200112L
+#include "metrics.h"
+#include "atomics.h"
+#include "hotcache.h"
+#include "tlssock.h"
+#include "logger.h"
+#include "pasvport.h"
+#include "ratelimit.h"
+#include "session.h"
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define METRICS_HTTP_POLL_MS 500      // How often the HTTP thread checks for shutdown
+#define METRICS_HTTP_TIMEOUT_MS 2000  // Time a scraper gets to send its request
+#define METRICS_HTTP_MAX_REQUEST 2048
+
+// A thread's counters. All fields are unsigned long long, so shards are
+// merged as flat arrays; only the owning thread writes its shard.
+typedef struct metrics_shard
+{
+    metrics_snapshot_t counters;
+    struct metrics_shard *next;
+} metrics_shard_t;
+
+#define METRICS_COUNTER_COUNT (sizeof(metrics_snapshot_t) / sizeof(unsigned long long))
+
+// Global metrics state: shard list and retired totals are protected by mutex
+static struct
+{
+    pthread_mutex_t mutex;
+    pthread_once_t key_once;
+    pthread_key_t key;
+    int key_ok;
+    metrics_shard_t *shards;    // Shards of live threads
+    metrics_snapshot_t retired; // Totals of threads that exited
+} g_metrics = {.mutex = PTHREAD_MUTEX_INITIALIZER, .key_once = PTHREAD_ONCE_INIT};
+
+// HTTP endpoint state
+static struct
+{
+    socket_t sock;
+    pthread_t thread;
+    int running;
+    volatile int stopping;
+} g_http = {.sock = INVALID_SOCKET_T};
+
+static const char *const g_direction_names[METRICS_DIRECTION_COUNT] = {"download", "upload", "listing"};
+static const char *const g_result_names[METRICS_RESULT_COUNT] = {"ok", "aborted", "failed"};
+
+/**
+ * @brief Folds an exiting thread's shard into the retired totals
+ */
+static void metrics_shard_retire(void *arg)
+{
+    metrics_shard_t *shard = (metrics_shard_t *)arg;
+    unsigned long long *from = (unsigned long long *)&shard->counters;
+    unsigned long long *to = (unsigned long long *)&g_metrics.retired;
+
+    pthread_mutex_lock(&g_metrics.mutex);
+    metrics_shard_t **link = &g_metrics.shards;
+    while (*link && *link != shard)
+        link = &(*link)->next;
+    if (*link)
+        *link = shard->next;
+    for (size_t i = 0; i < METRICS_COUNTER_COUNT; i++)
+        to[i] += from[i];
+    pthread_mutex_unlock(&g_metrics.mutex);
+
+    free(shard);
+}
+
+static void metrics_create_key(void)
+{
+    g_metrics.key_ok = (pthread_key_create(&g_metrics.key, metrics_shard_retire) == 0);
+}
+
+/**
+ * @brief Gets the calling thread's shard, creating it on first use.
+ *
+ * @return The shard, or NULL if it could not be allocated (the sample is dropped).
+ */
+static metrics_shard_t *metrics_shard(void)
+{
+    pthread_once(&g_metrics.key_once, metrics_create_key);
+    if (!g_metrics.key_ok)
+        return NULL;
+
+    metrics_shard_t *shard = (metrics_shard_t *)pthread_getspecific(g_metrics.key);
+    if (shard)
+        return shard;
+
+    shard = (metrics_shard_t *)calloc(1, sizeof(metrics_shard_t));
+    if (!shard)
+        return NULL;
+    if (pthread_setspecific(g_metrics.key, shard) != 0)
+    {
+        free(shard);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_metrics.mutex);
+    shard->next = g_metrics.shards;
+    g_metrics.shards = shard;
+    pthread_mutex_unlock(&g_metrics.mutex);
+    return shard;
+}
+
+/**
+ * @brief Adds to a counter of the caller's own shard. A plain load and
+ * store suffice as no other thread writes it; readers load it atomically.
+ */
+static void shard_add(unsigned long long *counter, unsigned long long value)
+{
+    ATOMIC_STORE_RELAXED(counter, ATOMIC_LOAD_RELAXED(counter) + value);
+}
+
+static int histogram_bucket(long long elapsed_us)
+{
+    if (elapsed_us <= METRICS_MIN_BOUND_US)
+        return 0;
+
+    int bits = 64 - __builtin_clzll((unsigned long long)(elapsed_us - 1)); // Smallest power of two >= elapsed
+    int bucket = bits - 4;
+    return bucket < METRICS_HISTOGRAM_BUCKETS - 1 ? bucket : METRICS_HISTOGRAM_BUCKETS - 1;
+}
+
+static long long histogram_bound_us(int bucket)
+{
+    return METRICS_MIN_BOUND_US << bucket;
+}
+
+static void histogram_observe(metrics_histogram_t *histogram, long long elapsed_us)
+{
+    if (elapsed_us < 0)
+        elapsed_us = 0;
+    shard_add(&histogram->count, 1);
+    shard_add(&histogram->sum_us, (unsigned long long)elapsed_us);
+    shard_add(&histogram->buckets[histogram_bucket(elapsed_us)], 1);
+}
+
+long long metrics_now_us(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+           (long long)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+void metrics_observe_command(int slot, long long elapsed_us)
+{
+    metrics_shard_t *shard = metrics_shard();
+    if (!shard || slot < 0 || slot > METRICS_UNKNOWN_COMMAND)
+        return;
+
+    histogram_observe(&shard->counters.commands[slot], elapsed_us);
+}
+
+void metrics_observe_latency(metrics_latency_t latency, long long elapsed_us)
+{
+    metrics_shard_t *shard = metrics_shard();
+    if (!shard || (int)latency < 0 || latency >= METRICS_LATENCY_COUNT)
+        return;
+
+    histogram_observe(&shard->counters.latencies[latency], elapsed_us);
+}
+
+void metrics_record_transfer(metrics_direction_t direction, metrics_result_t result,
+                             long long bytes, long long elapsed_us)
+{
+    metrics_shard_t *shard = metrics_shard();
+    if (!shard || (int)direction < 0 || direction >= METRICS_DIRECTION_COUNT ||
+        (int)result < 0 || result >= METRICS_RESULT_COUNT)
+        return;
+
+    shard_add(&shard->counters.transfer_results[direction][result], 1);
+    if (result == METRICS_RESULT_OK)
+    {
+        shard_add(&shard->counters.transfer_bytes[direction], bytes > 0 ? (unsigned long long)bytes : 0);
+        histogram_observe(&shard->counters.transfers[direction], elapsed_us);
+    }
+}
+
+void metrics_record_session(int opened)
+{
+    metrics_shard_t *shard = metrics_shard();
+    if (!shard)
+        return;
+
+    shard_add(opened ? &shard->counters.sessions_opened : &shard->counters.sessions_closed, 1);
+}
+
+void metrics_get_snapshot(metrics_snapshot_t *snapshot)
+{
+    if (!snapshot)
+        return;
+
+    unsigned long long *to = (unsigned long long *)snapshot;
+
+    pthread_mutex_lock(&g_metrics.mutex);
+    *snapshot = g_metrics.retired;
+    for (metrics_shard_t *shard = g_metrics.shards; shard; shard = shard->next)
+    {
+        unsigned long long *from = (unsigned long long *)&shard->counters;
+        for (size_t i = 0; i < METRICS_COUNTER_COUNT; i++)
+            to[i] += ATOMIC_LOAD_RELAXED(&from[i]);
+    }
+    pthread_mutex_unlock(&g_metrics.mutex);
+}
+
+long long metrics_histogram_quantile(const metrics_histogram_t *histogram, double quantile)
+{
+    if (!histogram || histogram->count == 0)
+        return 0;
+
+    // Buckets are summed separately from count; a sample in flight may be in one and not yet the other
+    unsigned long long total = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++)
+        total += histogram->buckets[i];
+
+    unsigned long long rank = (unsigned long long)(quantile * (double)total + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    unsigned long long seen = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+            return histogram_bound_us(i);
+    }
+    return -1;
+}
+
+// Growable output buffer of metrics_render()
+typedef struct
+{
+    char *data;
+    size_t used;
+    size_t capacity;
+    int failed;
+} text_t;
+
+static void text_printf(text_t *text, const char *format, ...)
+{
+    if (text->failed)
+        return;
+
+    for (;;)
+    {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(text->data + text->used, text->capacity - text->used, format, args);
+        va_end(args);
+        if (n < 0)
+        {
+            text->failed = 1;
+            return;
+        }
+        if ((size_t)n < text->capacity - text->used)
+        {
+            text->used += (size_t)n;
+            return;
+        }
+
+        size_t capacity = text->capacity * 2 + (size_t)n;
+        char *data = (char *)realloc(text->data, capacity);
+        if (!data)
+        {
+            text->failed = 1;
+            return;
+        }
+        text->data = data;
+        text->capacity = capacity;
+    }
+}
+
+static void text_histogram_line(text_t *text, const char *name, const metrics_histogram_t *histogram)
+{
+    long long p50 = metrics_histogram_quantile(histogram, 0.5);
+    long long p99 = metrics_histogram_quantile(histogram, 0.99);
+    text_printf(text, "%s: %llu samples, avg %llu us", name, histogram->count,
+                histogram->count ? histogram->sum_us / histogram->count : 0);
+    if (p50 < 0)
+        text_printf(text, ", p50 > %lld us", METRICS_MAX_BOUND_US);
+    else
+        text_printf(text, ", p50 <= %lld us", p50);
+    if (p99 < 0)
+        text_printf(text, ", p99 > %lld us\n", METRICS_MAX_BOUND_US);
+    else
+        text_printf(text, ", p99 <= %lld us\n", p99);
+}
+
+static void render_text(text_t *text, const metrics_snapshot_t *snapshot, const threadpool_stats_t *pool,
+                        const pasv_port_stats_t *pasv, const ratelimit_stats_t *rate,
+                        const session_memory_stats_t *memory, const hotcache_stats_t *files,
+                        const tlssock_stats_t *tls)
+{
+    static const char *const titles[METRICS_DIRECTION_COUNT] = {"Downloads", "Uploads", "Listings"};
+
+    text_printf(text, "Sessions: %llu active, %llu opened\n",
+                snapshot->sessions_opened - snapshot->sessions_closed, snapshot->sessions_opened);
+    text_printf(text, "Session memory: %zu bytes per idle session, %zu pooled, %zu transfers, %zu bytes shared\n",
+                memory->idle_bytes, memory->sessions_pooled, memory->transfers_in_use, memory->shared_bytes);
+    text_printf(text, "Transfer workers: %d busy, %d alive, %d max, %d queued, %llu jobs done\n",
+                pool->busy_workers, pool->workers, pool->max_workers, pool->queue_depth, pool->jobs_completed);
+
+    for (int d = 0; d < METRICS_DIRECTION_COUNT; d++)
+    {
+        const unsigned long long *results = snapshot->transfer_results[d];
+        if (d == METRICS_LISTING)
+        {
+            text_printf(text, "%s: %llu ok, %llu aborted, %llu failed\n", titles[d], results[METRICS_RESULT_OK],
+                        results[METRICS_RESULT_ABORTED], results[METRICS_RESULT_FAILED]);
+            continue;
+        }
+
+        double seconds = (double)snapshot->transfers[d].sum_us / 1e6;
+        double throughput = seconds > 0 ? (double)snapshot->transfer_bytes[d] / seconds / (1024.0 * 1024.0) : 0;
+        text_printf(text, "%s: %llu ok, %llu aborted, %llu failed, %llu bytes, %.2f MB/s average\n",
+                    titles[d], results[METRICS_RESULT_OK], results[METRICS_RESULT_ABORTED],
+                    results[METRICS_RESULT_FAILED], snapshot->transfer_bytes[d], throughput);
+    }
+
+    text_histogram_line(text, "Data connection setup", &snapshot->latencies[METRICS_DATA_CONNECT]);
+    text_histogram_line(text, "File lock wait", &snapshot->latencies[METRICS_FILE_LOCK_WAIT]);
+    text_printf(text, "Passive ports: %llu leases, %llu pre-bound, %llu bind failures\n",
+                pasv->leases, pasv->prebound_hits, pasv->bind_failures);
+    text_printf(text, "Bandwidth: %llu bytes paced, %llu pauses, %.2f s paused\n",
+                rate->charged, rate->delays, (double)rate->delay_us / 1e6);
+    if (files->max_bytes > 0)
+    {
+        unsigned long long lookups = files->hits + files->misses;
+        text_printf(text, "File cache: %zu files, %zu of %zu bytes, %zu pinned, %llu hits, %llu misses (%.1f%% hit rate), "
+                    "%llu evictions\n",
+                    files->entries, files->bytes, files->max_bytes, files->pinned_bytes, files->hits, files->misses,
+                    lookups ? 100.0 * (double)files->hits / (double)lookups : 0.0, files->evictions);
+    }
+    if (tlssock_is_available())
+    {
+        text_printf(text, "TLS: %llu handshakes, %llu resumed, %llu failed, %llu kernel TLS, %d secured\n",
+                    tls->handshakes, tls->resumed, tls->failures, tls->ktls_send, tls->secured);
+    }
+
+    for (int i = 0; i <= METRICS_UNKNOWN_COMMAND; i++)
+    {
+        const char *command = i == METRICS_UNKNOWN_COMMAND ? "unknown" : cmd_get_handler_name(i);
+        if (!command || snapshot->commands[i].count == 0)
+            continue;
+
+        char name[PROTO_MAX_CMD_NAME + 16];
+        snprintf(name, sizeof(name), "Command %s", command);
+        text_histogram_line(text, name, &snapshot->commands[i]);
+    }
+}
+
+static void prometheus_header(text_t *text, const char *name, const char *type, const char *help)
+{
+    text_printf(text, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * @brief Writes the series of one histogram. labels is empty or a list like `a="b",`
+ */
+static void prometheus_histogram(text_t *text, const char *name, const char *labels,
+                                 const metrics_histogram_t *histogram)
+{
+    unsigned long long cumulative = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        cumulative += histogram->buckets[i];
+        text_printf(text, "%s_bucket{%sle=\"%g\"} %llu\n", name, labels,
+                    (double)histogram_bound_us(i) / 1e6, cumulative);
+    }
+    cumulative += histogram->buckets[METRICS_HISTOGRAM_BUCKETS - 1];
+    text_printf(text, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, labels, cumulative);
+
+    // Without labels the braces are dropped, as the format requires
+    size_t labels_len = strlen(labels);
+    if (labels_len > 0)
+    {
+        text_printf(text, "%s_sum{%.*s} %.6f\n", name, (int)labels_len - 1, labels, (double)histogram->sum_us / 1e6);
+        text_printf(text, "%s_count{%.*s} %llu\n", name, (int)labels_len - 1, labels, cumulative);
+    }
+    else
+    {
+        text_printf(text, "%s_sum %.6f\n", name, (double)histogram->sum_us / 1e6);
+        text_printf(text, "%s_count %llu\n", name, cumulative);
+    }
+}
+
+static void render_prometheus(text_t *text, const metrics_snapshot_t *snapshot, const threadpool_stats_t *pool,
+                              const pasv_port_stats_t *pasv, const ratelimit_stats_t *rate,
+                              const session_memory_stats_t *memory, const hotcache_stats_t *files,
+                              const tlssock_stats_t *tls)
+{
+    char labels[64];
+
+    prometheus_header(text, "ftp_sessions_active", "gauge", "Control sessions currently open.");
+    text_printf(text, "ftp_sessions_active %llu\n", snapshot->sessions_opened - snapshot->sessions_closed);
+    prometheus_header(text, "ftp_sessions_opened_total", "counter", "Control sessions opened.");
+    text_printf(text, "ftp_sessions_opened_total %llu\n", snapshot->sessions_opened);
+    prometheus_header(text, "ftp_session_idle_bytes", "gauge", "Heap memory held by one idle session.");
+    text_printf(text, "ftp_session_idle_bytes %zu\n", memory->idle_bytes);
+    prometheus_header(text, "ftp_session_pool_objects", "gauge", "Session objects in the pool.");
+    text_printf(text, "ftp_session_pool_objects{state=\"in_use\"} %zu\n", memory->sessions_in_use);
+    text_printf(text, "ftp_session_pool_objects{state=\"allocated\"} %zu\n", memory->sessions_pooled);
+    prometheus_header(text, "ftp_session_shared_bytes", "gauge", "Directory and user names shared by sessions.");
+    text_printf(text, "ftp_session_shared_bytes %zu\n", memory->shared_bytes);
+
+    prometheus_header(text, "ftp_transfer_workers", "gauge", "Transfer worker threads.");
+    text_printf(text, "ftp_transfer_workers{state=\"busy\"} %d\n", pool->busy_workers);
+    text_printf(text, "ftp_transfer_workers{state=\"alive\"} %d\n", pool->workers);
+    text_printf(text, "ftp_transfer_workers{state=\"max\"} %d\n", pool->max_workers);
+    prometheus_header(text, "ftp_transfer_queue_depth", "gauge", "Transfers waiting for a worker.");
+    text_printf(text, "ftp_transfer_queue_depth %d\n", pool->queue_depth);
+
+    prometheus_header(text, "ftp_transfers_total", "counter", "Finished data transfers.");
+    for (int d = 0; d < METRICS_DIRECTION_COUNT; d++)
+    {
+        for (int r = 0; r < METRICS_RESULT_COUNT; r++)
+            text_printf(text, "ftp_transfers_total{direction=\"%s\",result=\"%s\"} %llu\n",
+                        g_direction_names[d], g_result_names[r], snapshot->transfer_results[d][r]);
+    }
+    prometheus_header(text, "ftp_transfer_bytes_total", "counter", "Bytes of successful data transfers.");
+    for (int d = 0; d < METRICS_LISTING; d++)
+        text_printf(text, "ftp_transfer_bytes_total{direction=\"%s\"} %llu\n",
+                    g_direction_names[d], snapshot->transfer_bytes[d]);
+    prometheus_header(text, "ftp_transfer_duration_seconds", "histogram", "Duration of successful data transfers.");
+    for (int d = 0; d < METRICS_DIRECTION_COUNT; d++)
+    {
+        snprintf(labels, sizeof(labels), "direction=\"%s\",", g_direction_names[d]);
+        prometheus_histogram(text, "ftp_transfer_duration_seconds", labels, &snapshot->transfers[d]);
+    }
+
+    prometheus_header(text, "ftp_data_connect_seconds", "histogram", "Time to open a data connection.");
+    prometheus_histogram(text, "ftp_data_connect_seconds", "", &snapshot->latencies[METRICS_DATA_CONNECT]);
+    prometheus_header(text, "ftp_file_lock_wait_seconds", "histogram", "Time spent waiting for file locks.");
+    prometheus_histogram(text, "ftp_file_lock_wait_seconds", "", &snapshot->latencies[METRICS_FILE_LOCK_WAIT]);
+
+    prometheus_header(text, "ftp_command_duration_seconds", "histogram", "Time to handle a command.");
+    for (int i = 0; i <= METRICS_UNKNOWN_COMMAND; i++)
+    {
+        const char *command = i == METRICS_UNKNOWN_COMMAND ? "unknown" : cmd_get_handler_name(i);
+        if (!command)
+            continue;
+        snprintf(labels, sizeof(labels), "command=\"%s\",", command);
+        prometheus_histogram(text, "ftp_command_duration_seconds", labels, &snapshot->commands[i]);
+    }
+
+    prometheus_header(text, "ftp_pasv_leases_total", "counter", "Passive ports leased.");
+    text_printf(text, "ftp_pasv_leases_total %llu\n", pasv->leases);
+    prometheus_header(text, "ftp_pasv_bind_failures_total", "counter", "Passive ports that failed to bind.");
+    text_printf(text, "ftp_pasv_bind_failures_total %llu\n", pasv->bind_failures);
+
+    prometheus_header(text, "ftp_ratelimit_bytes_total", "counter", "Bytes charged to the bandwidth scheduler.");
+    text_printf(text, "ftp_ratelimit_bytes_total %llu\n", rate->charged);
+    prometheus_header(text, "ftp_ratelimit_pauses_total", "counter", "Transfer pauses for bandwidth limits.");
+    text_printf(text, "ftp_ratelimit_pauses_total %llu\n", rate->delays);
+    prometheus_header(text, "ftp_ratelimit_pause_seconds_total", "counter", "Time transfers paused for bandwidth limits.");
+    text_printf(text, "ftp_ratelimit_pause_seconds_total %.6f\n", (double)rate->delay_us / 1e6);
+
+    prometheus_header(text, "ftp_file_cache_lookups_total", "counter", "Downloads of files small enough for the file cache.");
+    text_printf(text, "ftp_file_cache_lookups_total{result=\"hit\"} %llu\n", files->hits);
+    text_printf(text, "ftp_file_cache_lookups_total{result=\"miss\"} %llu\n", files->misses);
+    prometheus_header(text, "ftp_file_cache_evictions_total", "counter", "Files replaced in the file cache to make room.");
+    text_printf(text, "ftp_file_cache_evictions_total %llu\n", files->evictions);
+    prometheus_header(text, "ftp_file_cache_bytes", "gauge", "Memory held by the file cache.");
+    text_printf(text, "ftp_file_cache_bytes{state=\"cached\"} %zu\n", files->bytes);
+    text_printf(text, "ftp_file_cache_bytes{state=\"pinned\"} %zu\n", files->pinned_bytes);
+    text_printf(text, "ftp_file_cache_bytes{state=\"max\"} %zu\n", files->max_bytes);
+    prometheus_header(text, "ftp_file_cache_files", "gauge", "Files in the file cache.");
+    text_printf(text, "ftp_file_cache_files %zu\n", files->entries);
+
+    prometheus_header(text, "ftp_tls_handshakes_total", "counter", "TLS handshakes on control and data connections.");
+    text_printf(text, "ftp_tls_handshakes_total{result=\"full\"} %llu\n", tls->handshakes - tls->resumed);
+    text_printf(text, "ftp_tls_handshakes_total{result=\"resumed\"} %llu\n", tls->resumed);
+    text_printf(text, "ftp_tls_handshakes_total{result=\"failed\"} %llu\n", tls->failures);
+    prometheus_header(text, "ftp_tls_ktls_handshakes_total", "counter", "TLS handshakes that enabled kernel TLS for sending.");
+    text_printf(text, "ftp_tls_ktls_handshakes_total %llu\n", tls->ktls_send);
+    prometheus_header(text, "ftp_tls_secured_sockets", "gauge", "Sockets currently secured with TLS.");
+    text_printf(text, "ftp_tls_secured_sockets %d\n", tls->secured);
+}
+
+char *metrics_render(metrics_format_t format, size_t *length)
+{
+    metrics_snapshot_t *snapshot = (metrics_snapshot_t *)malloc(sizeof(metrics_snapshot_t));
+    text_t text = {(char *)malloc(4096), 0, 4096, 0};
+    if (!snapshot || !text.data)
+    {
+        free(snapshot);
+        free(text.data);
+        return NULL;
+    }
+
+    threadpool_stats_t pool;
+    pasv_port_stats_t pasv;
+    ratelimit_stats_t rate;
+    session_memory_stats_t memory;
+    hotcache_stats_t files;
+    tlssock_stats_t tls;
+    memset(&pool, 0, sizeof(pool));
+    memset(&pasv, 0, sizeof(pasv));
+    metrics_get_snapshot(snapshot);
+    threadpool_get_stats(&pool);
+    pasv_port_get_stats(&pasv);
+    ratelimit_get_stats(&rate);
+    session_get_memory_stats(&memory);
+    hotcache_get_stats(&files);
+    tlssock_get_stats(&tls);
+
+    if (format == METRICS_FORMAT_PROMETHEUS)
+        render_prometheus(&text, snapshot, &pool, &pasv, &rate, &memory, &files, &tls);
+    else
+        render_text(&text, snapshot, &pool, &pasv, &rate, &memory, &files, &tls);
+    free(snapshot);
+
+    if (text.failed)
+    {
+        free(text.data);
+        return NULL;
+    }
+    if (length)
+        *length = text.used;
+    return text.data;
+}
+
+/**
+ * @brief Answers one HTTP request on an accepted connection and closes it
+ */
+static void metrics_http_serve(socket_t client)
+{
+    char request[METRICS_HTTP_MAX_REQUEST];
+    size_t used = 0;
+
+    // Only the request line matters, but the headers are read so closing does not reset the connection
+    net_set_recv_timeout(client, METRICS_HTTP_TIMEOUT_MS);
+    while (used < sizeof(request) - 1)
+    {
+        int n = net_receive(client, request + used, sizeof(request) - 1 - used);
+        if (n <= 0)
+            break;
+        used += (size_t)n;
+        request[used] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+            break;
+    }
+    request[used] = '\0';
+
+    const char *status = "404 Not Found";
+    char *body = NULL;
+    size_t body_len = 0;
+    if (strncmp(request, "GET ", 4) != 0 && strncmp(request, "HEAD ", 5) != 0)
+    {
+        status = "405 Method Not Allowed";
+    }
+    else
+    {
+        const char *path = strchr(request, ' ') + 1;
+        if (strncmp(path, "/metrics", 8) == 0 && (path[8] == ' ' || path[8] == '?'))
+        {
+            body = metrics_render(METRICS_FORMAT_PROMETHEUS, &body_len);
+            status = body ? "200 OK" : "500 Internal Server Error";
+        }
+    }
+
+    char header[256];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 %s\r\n"
+                              "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n\r\n",
+                              status, body_len);
+    net_set_send_timeout(client, METRICS_HTTP_TIMEOUT_MS);
+    if (net_send_all(client, header, (size_t)header_len) == 0 && body && strncmp(request, "GET ", 4) == 0)
+        net_send_all(client, body, body_len);
+
+    free(body);
+    net_shutdown_send(client);
+    net_close_socket(client);
+}
+
+static void *metrics_http_thread(void *arg)
+{
+    (void)arg;
+
+    while (!g_http.stopping)
+    {
+        if (net_wait_readable(g_http.sock, METRICS_HTTP_POLL_MS) <= 0)
+            continue;
+
+        socket_t client = net_accept(g_http.sock, NULL, 0, NULL);
+        if (client != INVALID_SOCKET_T)
+            metrics_http_serve(client);
+    }
+
+    return NULL;
+}
+
+int metrics_http_start(net_addr_family_t family, const char *bind_address, uint16_t port)
+{
+    if (g_http.running || port == 0)
+        return -1;
+
+    g_http.sock = net_create_listening_socket(family, bind_address, port, 16);
+    if (g_http.sock == INVALID_SOCKET_T)
+    {
+        LOG_ERROR("Failed to listen for metrics scrapes on port %u", port);
+        return -1;
+    }
+
+    g_http.stopping = 0;
+    if (pthread_create(&g_http.thread, NULL, metrics_http_thread, NULL) != 0)
+    {
+        LOG_ERROR("Failed to start the metrics endpoint thread");
+        net_close_socket(g_http.sock);
+        g_http.sock = INVALID_SOCKET_T;
+        return -1;
+    }
+
+    g_http.running = 1;
+    LOG_INFO("Serving Prometheus metrics on port %u (GET /metrics)", port);
+    return 0;
+}
+
+void metrics_http_stop(void)
+{
+    if (!g_http.running)
+        return;
+
+    g_http.stopping = 1;
+    pthread_join(g_http.thread, NULL);
+    net_close_socket(g_http.sock);
+    g_http.sock = INVALID_SOCKET_T;
+    g_http.running = 0;
+}
@@ -0,0 +1,336 @@
+/**
+ * @file mlsx.c
+ * @brief Machine-readable listings (RFC 3659 MLST and MLSD)
+ * @version 0.1
+ * @date 2025-12-08
+ */
+#define _POSIX_C_SOURCE 200112L // gmtime_r()
+#include "mlsx.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+// Fact names in output order, indexed by bit position
+static const char *const g_fact_names[] = {
+    "type",
+    "size",
+    "modify",
+    "perm",
+    "UNIX.mode",
+    "UNIX.owner",
+    "UNIX.group",
+    "UNIX.ownername",
+    "UNIX.groupname",
+};
+
+#define MLSX_FACT_COUNT ((int)(sizeof(g_fact_names) / sizeof(g_fact_names[0])))
+
+// Output cursor; once full, further appends are dropped and the entry fails
+typedef struct
+{
+    char *buffer;
+    size_t size;
+    size_t used;
+    int overflow;
+} mlsx_writer_t;
+
+static void put_bytes(mlsx_writer_t *w, const char *data, size_t length)
+{
+    if (w->overflow || w->used + length >= w->size)
+    {
+        w->overflow = 1;
+        return;
+    }
+    memcpy(w->buffer + w->used, data, length);
+    w->used += length;
+}
+
+static void put_string(mlsx_writer_t *w, const char *text)
+{
+    put_bytes(w, text, strlen(text));
+}
+
+static void put_char(mlsx_writer_t *w, char c)
+{
+    put_bytes(w, &c, 1);
+}
+
+static void put_unsigned(mlsx_writer_t *w, unsigned long long value, unsigned int base)
+{
+    char digits[24];
+    size_t n = sizeof(digits);
+    do
+    {
+        digits[--n] = (char)('0' + value % base);
+        value /= base;
+    } while (value > 0);
+    put_bytes(w, digits + n, sizeof(digits) - n);
+}
+
+// Writes a value of exactly width digits, zero padded
+static void put_padded(mlsx_writer_t *w, int value, int width)
+{
+    char digits[4];
+    for (int i = width - 1; i >= 0; i--)
+    {
+        digits[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    put_bytes(w, digits, (size_t)width);
+}
+
+// Starts a fact: "name="
+static void put_fact(mlsx_writer_t *w, mlsx_fact_t fact)
+{
+    for (int i = 0; i < MLSX_FACT_COUNT; i++)
+    {
+        if ((unsigned int)fact == (1u << i))
+        {
+            put_string(w, g_fact_names[i]);
+            break;
+        }
+    }
+    put_char(w, '=');
+}
+
+/**
+ * @brief Writes the operations of RFC 3659 section 7.5.5 the user may perform.
+ */
+static void put_perm(mlsx_writer_t *w, fs_file_type_t type, auth_permission_t permissions)
+{
+    int admin = (permissions & AUTH_PERM_ADMIN) != 0;
+    int read = admin || (permissions & AUTH_PERM_READ);
+    int write = admin || (permissions & AUTH_PERM_WRITE);
+    int rename = admin || (permissions & AUTH_PERM_RENAME);
+
+    if (type == FS_TYPE_DIR)
+    {
+        if (write)
+            put_char(w, 'c');
+        if (admin || (permissions & AUTH_PERM_RMDIR))
+            put_char(w, 'd');
+        if (read)
+            put_char(w, 'e');
+        if (rename)
+            put_char(w, 'f');
+        if (read)
+            put_char(w, 'l');
+        if (admin || (permissions & AUTH_PERM_MKDIR))
+            put_char(w, 'm');
+        if (admin || (permissions & AUTH_PERM_DELETE))
+            put_char(w, 'p');
+    }
+    else
+    {
+        if (write)
+            put_char(w, 'a');
+        if (admin || (permissions & AUTH_PERM_DELETE))
+            put_char(w, 'd');
+        if (rename)
+            put_char(w, 'f');
+        if (read)
+            put_char(w, 'r');
+        if (write)
+            put_char(w, 'w');
+    }
+}
+
+static const char *type_value(const fs_file_info_t *info)
+{
+    switch (info->type)
+    {
+    case FS_TYPE_FILE:
+        return "file";
+    case FS_TYPE_DIR:
+        return "dir";
+    case FS_TYPE_SYMLINK:
+        return "OS.unix=symlink";
+    default:
+        return "OS.unix=special";
+    }
+}
+
+int mlsx_format_fact_list(unsigned int facts, int mark_selected, char *buffer, size_t buffer_size)
+{
+    if (!buffer || buffer_size == 0)
+    {
+        return -1;
+    }
+
+    mlsx_writer_t w = {buffer, buffer_size, 0, 0};
+    for (int i = 0; i < MLSX_FACT_COUNT; i++)
+    {
+        int selected = (facts & (1u << i)) != 0;
+        if (!selected && !mark_selected)
+        {
+            continue;
+        }
+        put_string(&w, g_fact_names[i]);
+        if (selected && mark_selected)
+        {
+            put_char(&w, '*');
+        }
+        put_char(&w, ';');
+    }
+
+    buffer[w.overflow ? 0 : w.used] = '\0';
+    return w.overflow ? -1 : 0;
+}
+
+/**
+ * @brief Compares a fact name of the given length, ignoring case.
+ */
+static int fact_name_equals(const char *name, size_t length, const char *fact)
+{
+    if (strlen(fact) != length)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        if (tolower((unsigned char)name[i]) != tolower((unsigned char)fact[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+unsigned int mlsx_parse_fact_list(const char *list)
+{
+    unsigned int facts = 0;
+    if (!list)
+    {
+        return 0;
+    }
+
+    while (*list)
+    {
+        const char *end = strchr(list, ';');
+        size_t length = end ? (size_t)(end - list) : strlen(list);
+
+        for (int i = 0; i < MLSX_FACT_COUNT; i++)
+        {
+            if (fact_name_equals(list, length, g_fact_names[i]))
+            {
+                facts |= 1u << i;
+                break;
+            }
+        }
+
+        if (!end)
+        {
+            break;
+        }
+        list = end + 1;
+    }
+
+    return facts;
+}
+
+int mlsx_format_entry(const fs_file_info_t *info, unsigned int facts, auth_permission_t permissions,
+                      const char *name, char *buffer, size_t buffer_size)
+{
+    if (!info || !name || !buffer || buffer_size == 0)
+    {
+        return -1;
+    }
+
+    mlsx_writer_t w = {buffer, buffer_size, 0, 0};
+
+    if (facts & MLSX_FACT_TYPE)
+    {
+        put_fact(&w, MLSX_FACT_TYPE);
+        put_string(&w, type_value(info));
+        put_char(&w, ';');
+    }
+
+    if ((facts & MLSX_FACT_SIZE) && info->type != FS_TYPE_DIR)
+    {
+        put_fact(&w, MLSX_FACT_SIZE);
+        put_unsigned(&w, info->size > 0 ? (unsigned long long)info->size : 0, 10);
+        put_char(&w, ';');
+    }
+
+    if (facts & MLSX_FACT_MODIFY)
+    {
+        struct tm tm_info;
+#ifdef _WIN32
+        int valid = (gmtime_s(&tm_info, &info->last_modified) == 0);
+#else
+        int valid = (gmtime_r(&info->last_modified, &tm_info) != NULL);
+#endif
+        if (valid)
+        {
+            put_fact(&w, MLSX_FACT_MODIFY);
+            put_padded(&w, tm_info.tm_year + 1900, 4);
+            put_padded(&w, tm_info.tm_mon + 1, 2);
+            put_padded(&w, tm_info.tm_mday, 2);
+            put_padded(&w, tm_info.tm_hour, 2);
+            put_padded(&w, tm_info.tm_min, 2);
+            put_padded(&w, tm_info.tm_sec, 2);
+            put_char(&w, ';');
+        }
+    }
+
+    if (facts & MLSX_FACT_PERM)
+    {
+        put_fact(&w, MLSX_FACT_PERM);
+        put_perm(&w, info->type, permissions);
+        put_char(&w, ';');
+    }
+
+    if (facts & MLSX_FACT_UNIX_MODE)
+    {
+        put_fact(&w, MLSX_FACT_UNIX_MODE);
+        put_char(&w, '0');
+        put_unsigned(&w, (unsigned long long)(info->mode & 07777), 8);
+        put_char(&w, ';');
+    }
+
+    if (facts & MLSX_FACT_UNIX_OWNER)
+    {
+        put_fact(&w, MLSX_FACT_UNIX_OWNER);
+        put_unsigned(&w, (unsigned long long)info->uid, 10);
+        put_char(&w, ';');
+    }
+
+    if (facts & MLSX_FACT_UNIX_GROUP)
+    {
+        put_fact(&w, MLSX_FACT_UNIX_GROUP);
+        put_unsigned(&w, (unsigned long long)info->gid, 10);
+        put_char(&w, ';');
+    }
+
+    // Names are the only facts that cost a lookup, and only when asked for
+    char lookup[64];
+    if ((facts & MLSX_FACT_UNIX_OWNERNAME) && fs_get_user_name(info->uid, lookup, sizeof(lookup)) == 0)
+    {
+        put_fact(&w, MLSX_FACT_UNIX_OWNERNAME);
+        put_string(&w, lookup);
+        put_char(&w, ';');
+    }
+
+    if ((facts & MLSX_FACT_UNIX_GROUPNAME) && fs_get_group_name(info->gid, lookup, sizeof(lookup)) == 0)
+    {
+        put_fact(&w, MLSX_FACT_UNIX_GROUPNAME);
+        put_string(&w, lookup);
+        put_char(&w, ';');
+    }
+
+    put_char(&w, ' ');
+    put_string(&w, name);
+
+    if (w.overflow)
+    {
+        buffer[0] = '\0';
+        return -1;
+    }
+    buffer[w.used] = '\0';
+    return (int)w.used;
+}
@@ -5,9 +5,18 @@
  * @version 0.1
  * @date 2025-10-19
  */
+#if defined(__APPLE__)
+#define _DARWIN_C_SOURCE // sendfile() is hidden under strict POSIX
+#elif !defined(__FreeBSD__) && !defined(__DragonFly__)
+#define _DEFAULT_SOURCE // SO_REUSEPORT is outside strict POSIX
 #define _POSIX_C_SOURCE 200112L
+#endif
 #include "network.h"
 
+#ifdef ENABLE_OPENSSL
+#include "tlssock.h"
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -15,6 +24,7 @@
 
 #ifdef _WIN32
 #include <ws2tcpip.h>
+#include <mswsock.h>
 #else
 #include <unistd.h>
 #include <fcntl.h>
@@ -26,6 +36,20 @@
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <errno.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__DragonFly__)
+#include <sys/uio.h>
+#define NET_HAVE_BSD_SENDFILE
+#endif
+#endif
+
+// Socket option that spreads incoming connections across sockets bound to the same port.
+// Elsewhere SO_REUSEPORT only lets sockets share the port, so it is not used.
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#define NET_REUSEPORT_OPTION SO_REUSEPORT
+#elif defined(__FreeBSD__) && defined(SO_REUSEPORT_LB)
+#define NET_REUSEPORT_OPTION SO_REUSEPORT_LB
 #endif
 
 /**
@@ -58,7 +82,13 @@ void net_cleanup(void)
     g_initialized = 0;
 }
 
-socket_t net_create_listening_socket(net_addr_family_t family, const char *bind_address, uint16_t port, int backlog)
+/**
+ * @brief Creates a listening socket, see net_create_listening_socket()
+ *
+ * @param reuse_port 1 to join the load-balancing group of the port
+ */
+static socket_t create_listening_socket(net_addr_family_t family, const char *bind_address, uint16_t port,
+                                        int backlog, int reuse_port)
 {
     struct addrinfo hints, *res, *p;
     socket_t listening_socket = INVALID_SOCKET_T;
@@ -108,6 +138,18 @@ socket_t net_create_listening_socket(net_addr_family_t family, const char *bind_
             continue;
         }
 
+#ifdef NET_REUSEPORT_OPTION
+        if (reuse_port &&
+            setsockopt(listening_socket, SOL_SOCKET, NET_REUSEPORT_OPTION, (const char *)&opt, sizeof(opt)) < 0)
+        {
+            net_close_socket(listening_socket);
+            listening_socket = INVALID_SOCKET_T;
+            continue;
+        }
+#else
+        (void)reuse_port;
+#endif
+
         // For IPv6, ensure it's not an IPv4-mapped address (IPv6 only)
         if (p->ai_family == AF_INET6)
         {
@@ -146,6 +188,39 @@ socket_t net_create_listening_socket(net_addr_family_t family, const char *bind_
     return listening_socket;
 }
 
+socket_t net_create_listening_socket(net_addr_family_t family, const char *bind_address, uint16_t port, int backlog)
+{
+    return create_listening_socket(family, bind_address, port, backlog, 0);
+}
+
+int net_reuseport_supported(void)
+{
+#ifdef NET_REUSEPORT_OPTION
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int net_listener_shutdown_supported(void)
+{
+#if defined(__linux__)
+    return 1;
+#else
+    return 0; // shutdown() of a listening socket fails with ENOTCONN or WSAENOTCONN
+#endif
+}
+
+socket_t net_create_listening_socket_reuseport(net_addr_family_t family, const char *bind_address, uint16_t port,
+                                               int backlog)
+{
+    if (!net_reuseport_supported())
+    {
+        return INVALID_SOCKET_T;
+    }
+    return create_listening_socket(family, bind_address, port, backlog, 1);
+}
+
 socket_t net_create_listening_socket_range(net_addr_family_t family, const char *bind_address, uint16_t port_min,
                                            uint16_t port_max, int backlog, uint16_t *assigned_port)
 {
@@ -313,6 +388,11 @@ int net_get_socket_info(socket_t sock, char *ip_buffer, size_t buffer_size, uint
 
 int net_receive(socket_t connected_socket, void *buffer, size_t buffer_size)
 {
+#ifdef ENABLE_OPENSSL
+    int received;
+    if (tlssock_receive(connected_socket, buffer, buffer_size, &received))
+        return received;
+#endif
 #ifdef _WIN32
     return recv(connected_socket, (char *)buffer, (int)buffer_size, 0);
 #else
@@ -384,8 +464,157 @@ int net_receive_line(socket_t sock, char *buffer, size_t buffer_size, int timeou
     return -1;
 }
 
+void net_line_buffer_init(net_line_buffer_t *line_buffer)
+{
+    if (!line_buffer)
+        return;
+    line_buffer->data = NULL;
+    line_buffer->start = 0;
+    line_buffer->end = 0;
+}
+
+void net_line_buffer_free(net_line_buffer_t *line_buffer)
+{
+    if (!line_buffer)
+        return;
+    free(line_buffer->data);
+    line_buffer->data = NULL;
+    line_buffer->start = 0;
+    line_buffer->end = 0;
+}
+
+int net_line_buffer_fill(socket_t connected_socket, net_line_buffer_t *line_buffer)
+{
+    if (!line_buffer)
+        return -1;
+
+    // Compact so the pending partial line starts at the beginning
+    if (line_buffer->start > 0)
+    {
+        size_t pending = line_buffer->end - line_buffer->start;
+        memmove(line_buffer->data, line_buffer->data + line_buffer->start, pending);
+        line_buffer->start = 0;
+        line_buffer->end = pending;
+    }
+
+    size_t space = NET_LINE_BUFFER_SIZE - line_buffer->end;
+    if (space == 0)
+        return -1;
+
+    if (!line_buffer->data)
+    {
+        line_buffer->data = (char *)malloc(NET_LINE_BUFFER_SIZE);
+        if (!line_buffer->data)
+            return -1;
+    }
+
+    int result = net_receive(connected_socket, line_buffer->data + line_buffer->end, space);
+    if (result > 0)
+        line_buffer->end += (size_t)result;
+    else if (line_buffer->end == 0)
+        net_line_buffer_free(line_buffer);
+
+    return result;
+}
+
+int net_line_buffer_next(net_line_buffer_t *line_buffer, char *buffer, size_t buffer_size)
+{
+    if (!line_buffer || !buffer || buffer_size < 3) // Need at least space for "X\r\n"
+        return -1;
+
+    if (!line_buffer->data)
+        return 0;
+
+    const char *begin = line_buffer->data + line_buffer->start;
+    size_t pending = line_buffer->end - line_buffer->start;
+
+    // Search for CRLF
+    const char *lf = begin;
+    while ((lf = memchr(lf, '\n', pending - (size_t)(lf - begin))) != NULL)
+    {
+        if (lf > begin && lf[-1] == '\r')
+            break;
+        lf++;
+        if ((size_t)(lf - begin) >= pending)
+        {
+            lf = NULL;
+            break;
+        }
+    }
+
+    if (!lf)
+    {
+        // Line too long
+        if (pending >= buffer_size - 1)
+            return -1;
+        return 0;
+    }
+
+    size_t length = (size_t)(lf - begin) + 1;
+    if (length > buffer_size - 1)
+        return -1; // Line too long
+
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    line_buffer->start += length;
+
+    // Drained: give the storage back until more input arrives
+    if (line_buffer->start == line_buffer->end)
+        net_line_buffer_free(line_buffer);
+
+    return (int)length;
+}
+
+int net_receive_line_buffered(socket_t connected_socket, net_line_buffer_t *line_buffer,
+                              char *buffer, size_t buffer_size, int timeout_ms, int *has_urgent)
+{
+    int result;
+
+    while (1)
+    {
+        // Return a buffered line without touching the socket
+        result = net_line_buffer_next(line_buffer, buffer, buffer_size);
+        if (result != 0)
+            return result;
+
+        if (has_urgent && net_has_urgent_data(connected_socket) > 0)
+            *has_urgent = 1;
+
+        // Wait for data with timeout
+        if (timeout_ms >= 0)
+        {
+            result = net_wait_readable(connected_socket, timeout_ms);
+            if (result <= 0)
+            {
+                return result; // Timeout or error
+            }
+        }
+
+        result = net_line_buffer_fill(connected_socket, line_buffer);
+        if (result <= 0)
+        {
+            return result; // Connection closed or error
+        }
+    }
+}
+
+size_t net_receive_pending(socket_t connected_socket)
+{
+#ifdef ENABLE_OPENSSL
+    return tlssock_pending(connected_socket);
+#else
+    (void)connected_socket;
+    return 0;
+#endif
+}
+
 int net_send(socket_t connected_socket, const void *data, size_t length)
 {
+#ifdef ENABLE_OPENSSL
+    int sent;
+    if (tlssock_send(connected_socket, data, length, &sent))
+        return sent;
+#endif
 #ifdef _WIN32
     return send(connected_socket, (const char *)data, (int)length, 0);
 #else
@@ -412,8 +641,144 @@ int net_send_all(socket_t connected_socket, const void *data, size_t length)
     return 0; // Success
 }
 
+void net_send_buffer_init(net_send_buffer_t *send_buffer, socket_t sock)
+{
+    if (!send_buffer)
+        return;
+    send_buffer->sock = sock;
+    send_buffer->used = 0;
+    send_buffer->sends = 0;
+}
+
+int net_send_buffer_flush(net_send_buffer_t *send_buffer)
+{
+    if (!send_buffer)
+        return -1;
+    if (send_buffer->used == 0)
+        return 0;
+
+    send_buffer->sends++;
+    int rc = net_send_all(send_buffer->sock, send_buffer->data, send_buffer->used);
+    send_buffer->used = 0;
+    return rc;
+}
+
+int net_send_buffer_append(net_send_buffer_t *send_buffer, const void *data, size_t length)
+{
+    if (!send_buffer || (!data && length > 0))
+        return -1;
+
+    if (length > sizeof(send_buffer->data) - send_buffer->used)
+    {
+        if (net_send_buffer_flush(send_buffer) != 0)
+            return -1;
+
+        if (length > sizeof(send_buffer->data))
+        {
+            send_buffer->sends++;
+            return net_send_all(send_buffer->sock, data, length);
+        }
+    }
+
+    memcpy(send_buffer->data + send_buffer->used, data, length);
+    send_buffer->used += length;
+    return 0;
+}
+
+long long net_send_file(socket_t sock, fs_file_t *file, long long offset, long long length)
+{
+    if (!fs_file_is_open(file) || offset < 0 || length < 0)
+        return -1;
+
+#ifdef ENABLE_OPENSSL
+    long long encrypted;
+    if (tlssock_send_file(sock, file, offset, length, &encrypted))
+        return encrypted;
+#endif
+
+    long long total = 0;
+#ifdef _WIN32
+    LARGE_INTEGER li_offset;
+    li_offset.QuadPart = offset;
+    if (!SetFilePointerEx((HANDLE)file->handle, li_offset, NULL, FILE_BEGIN))
+        return -1;
+
+    while (total < length)
+    {
+        // TransmitFile() accepts at most 2^31 - 2 bytes per call
+        long long remaining = length - total;
+        DWORD chunk = (DWORD)(remaining > 0x7FFFFFFELL ? 0x7FFFFFFELL : remaining);
+        if (!TransmitFile(sock, (HANDLE)file->handle, chunk, 0, NULL, NULL, 0))
+        {
+            int err = WSAGetLastError();
+            if (total == 0 && (err == WSAEOPNOTSUPP || err == WSAEINVAL))
+                return NET_SENDFILE_UNSUPPORTED;
+            return -1;
+        }
+        total += chunk;
+    }
+    return total;
+#elif defined(__linux__)
+    off_t file_offset = (off_t)offset;
+    while (total < length)
+    {
+        // Linux transfers at most 0x7ffff000 bytes per call
+        long long remaining = length - total;
+        size_t count = (size_t)(remaining > 0x7FFFF000LL ? 0x7FFFF000LL : remaining);
+        ssize_t sent = sendfile(sock, file->fd, &file_offset, count);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (total == 0 && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+                return NET_SENDFILE_UNSUPPORTED;
+            return -1;
+        }
+        if (sent == 0)
+            break; // End of file
+        total += sent;
+    }
+    return total;
+#elif defined(NET_HAVE_BSD_SENDFILE)
+    while (total < length)
+    {
+        long long remaining = length - total;
+        off_t sent = 0;
+#if defined(__APPLE__)
+        sent = (off_t)remaining;
+        int result = sendfile(file->fd, sock, (off_t)(offset + total), &sent, NULL, 0);
+#else
+        int result = sendfile(file->fd, sock, (off_t)(offset + total), (size_t)remaining, NULL, &sent, 0);
+#endif
+        total += sent; // Partial progress is reported on EINTR/EAGAIN too
+        if (result != 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                if (sent == 0 && errno == EAGAIN)
+                    net_wait_writable(sock, -1);
+                continue;
+            }
+            if (total == 0 && (errno == EINVAL || errno == ENOTSOCK || errno == EOPNOTSUPP))
+                return NET_SENDFILE_UNSUPPORTED;
+            return -1;
+        }
+        if (sent == 0)
+            break; // End of file
+    }
+    return total;
+#else
+    (void)sock;
+    (void)total;
+    return NET_SENDFILE_UNSUPPORTED;
+#endif
+}
+
 void net_close_socket(socket_t sock)
 {
+#ifdef ENABLE_OPENSSL
+    tlssock_detach(sock);
+#endif
 #ifdef _WIN32
     closesocket(sock);
 #else
@@ -423,6 +788,9 @@ void net_close_socket(socket_t sock)
 
 int net_shutdown_send(socket_t sock)
 {
+#ifdef ENABLE_OPENSSL
+    tlssock_close_notify(sock);
+#endif
 #ifdef _WIN32
     if (shutdown(sock, SD_SEND) < 0)
     {
@@ -455,6 +823,9 @@ int net_shutdown_recv(socket_t sock)
 
 int net_shutdown_both(socket_t sock)
 {
+#ifdef ENABLE_OPENSSL
+    tlssock_close_notify(sock);
+#endif
 #ifdef _WIN32
     if (shutdown(sock, SD_BOTH) < 0)
     {
@@ -565,6 +936,12 @@ int net_set_keepalive(socket_t sock, int enable)
 
 int net_wait_readable(socket_t sock, int timeout_ms)
 {
+#ifdef ENABLE_OPENSSL
+    // Input TLS has already taken off the socket is invisible to select()
+    if (tlssock_pending(sock) > 0)
+        return 1;
+#endif
+
     fd_set read_fds;
     struct timeval tv;
     struct timeval *tv_ptr = NULL;
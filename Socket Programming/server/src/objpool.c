@@ -0,0 +1,136 @@
+/**
+ * @file objpool.c
+ * @brief Fixed-size object pool implementation
+ * @version 0.1
+ * @date 2025-12-12
+ *
+ */
+#include "objpool.h"
+
+#include "logger.h"
+
+#include <stdlib.h>
+
+// Objects and the slab header are kept at malloc's alignment
+#define OBJPOOL_ALIGNMENT 16
+
+/**
+ * @brief Size of an object in its slab: large enough for the free-list link, rounded to the alignment
+ */
+static size_t objpool_stride(const objpool_t *pool)
+{
+    size_t size = pool->object_size < sizeof(void *) ? sizeof(void *) : pool->object_size;
+    return (size + OBJPOOL_ALIGNMENT - 1) & ~(size_t)(OBJPOOL_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Allocates a slab and puts its objects on the free list; called with the mutex held
+ */
+static int objpool_grow(objpool_t *pool)
+{
+    size_t stride = objpool_stride(pool);
+    size_t per_slab = pool->per_slab > 0 ? pool->per_slab : 1;
+
+    char *slab = (char *)malloc(OBJPOOL_ALIGNMENT + stride * per_slab);
+    if (!slab)
+    {
+        LOG_ERROR("Failed to allocate a slab of %zu objects of %zu bytes", per_slab, stride);
+        return -1;
+    }
+
+    *(void **)slab = pool->slabs;
+    pool->slabs = slab;
+
+    // Pushed in reverse so objects are handed out in address order
+    for (size_t i = per_slab; i > 0; i--)
+    {
+        void *object = slab + OBJPOOL_ALIGNMENT + (i - 1) * stride;
+        *(void **)object = pool->free_list;
+        pool->free_list = object;
+    }
+    pool->allocated += per_slab;
+    return 0;
+}
+
+void *objpool_alloc(objpool_t *pool)
+{
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+
+    if (!pool->free_list && objpool_grow(pool) != 0)
+    {
+        pthread_mutex_unlock(&pool->mutex);
+        return NULL;
+    }
+
+    void *object = pool->free_list;
+    pool->free_list = *(void **)object;
+    pool->in_use++;
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    return object;
+}
+
+void objpool_free(objpool_t *pool, void *object)
+{
+    if (!pool || !object)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void objpool_get_stats(objpool_t *pool, objpool_stats_t *stats)
+{
+    if (!pool || !stats)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    stats->object_size = objpool_stride(pool);
+    stats->allocated = pool->allocated;
+    stats->in_use = pool->in_use;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void objpool_destroy(objpool_t *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+
+    if (pool->in_use > 0)
+    {
+        // Freeing the slabs would pull the objects out from under their users
+        LOG_WARN("Object pool destroyed with %zu objects in use, slabs kept", pool->in_use);
+        pthread_mutex_unlock(&pool->mutex);
+        return;
+    }
+
+    void *slab = pool->slabs;
+    while (slab)
+    {
+        void *next = *(void **)slab;
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool->allocated = 0;
+
+    pthread_mutex_unlock(&pool->mutex);
+}
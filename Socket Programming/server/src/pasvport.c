@@ -0,0 +1,348 @@
+/**
+ * @file pasvport.c
+ * @brief Server-wide passive mode port allocator implementation
+ * @version 0.1
+ * @date 2025-11-26
+ *
+ */
+#include "pasvport.h"
+#include "logger.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PASV_PORT_PREBIND_BACKLOG 5
+
+typedef struct
+{
+    socket_t sock;
+    uint16_t port;
+} pasv_prebound_t;
+
+// Global allocator state, protected by mutex
+static struct
+{
+    pthread_mutex_t mutex;
+    int enabled;
+    uint16_t port_min;
+    uint16_t port_max;
+    uint16_t *queue;              // Ring of free ports, range_size slots
+    int range_size;
+    int head;                     // Oldest free port
+    int count;                    // Free ports in the ring
+    uint64_t leased[65536 / 64];  // Bit set while a port is leased
+    char bind_address[64];        // Address of the pre-bound sockets
+    pasv_prebound_t *prebound;    // Stack of ready listening sockets
+    int prebound_target;          // Sockets to keep bound
+    int prebound_count;           // Sockets currently bound
+    int prebound_refilling;       // Binds in progress outside the mutex
+    unsigned long long leases;
+    unsigned long long prebound_hits;
+    unsigned long long bind_failures;
+} g_pasv = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+static int pasv_is_leased(uint16_t port)
+{
+    return (g_pasv.leased[port >> 6] >> (port & 63)) & 1;
+}
+
+static void pasv_set_leased(uint16_t port, int leased)
+{
+    if (leased)
+        g_pasv.leased[port >> 6] |= (uint64_t)1 << (port & 63);
+    else
+        g_pasv.leased[port >> 6] &= ~((uint64_t)1 << (port & 63));
+}
+
+/**
+ * @brief Takes the oldest free port and marks it leased. Caller holds the mutex.
+ *
+ * @return 0 on success, -1 if no port is free.
+ */
+static int pasv_pop_locked(uint16_t *port)
+{
+    if (g_pasv.count == 0)
+        return -1;
+
+    *port = g_pasv.queue[g_pasv.head];
+    g_pasv.head = (g_pasv.head + 1) % g_pasv.range_size;
+    g_pasv.count--;
+    pasv_set_leased(*port, 1);
+    return 0;
+}
+
+/**
+ * @brief Puts a leased port at the back of the free queue. Caller holds the mutex.
+ */
+static void pasv_push_locked(uint16_t port)
+{
+    pasv_set_leased(port, 0);
+    g_pasv.queue[(g_pasv.head + g_pasv.count) % g_pasv.range_size] = port;
+    g_pasv.count++;
+}
+
+/**
+ * @brief Leases ports until one binds. Must be called without the mutex.
+ */
+static socket_t pasv_bind_leased(const char *bind_address, int backlog, uint16_t *port)
+{
+    for (int attempt = 0; attempt < PASV_PORT_MAX_ATTEMPTS; attempt++)
+    {
+        uint16_t candidate;
+        pthread_mutex_lock(&g_pasv.mutex);
+        int rc = g_pasv.enabled ? pasv_pop_locked(&candidate) : -1;
+        pthread_mutex_unlock(&g_pasv.mutex);
+        if (rc != 0)
+            return INVALID_SOCKET_T;
+
+        socket_t sock = net_create_listening_socket(NET_AF_UNSPEC, bind_address, candidate, backlog);
+        if (sock != INVALID_SOCKET_T)
+        {
+            *port = candidate;
+            return sock;
+        }
+
+        // Taken by something outside this server: retry it later
+        pthread_mutex_lock(&g_pasv.mutex);
+        g_pasv.bind_failures++;
+        if (g_pasv.enabled)
+            pasv_push_locked(candidate);
+        pthread_mutex_unlock(&g_pasv.mutex);
+    }
+
+    return INVALID_SOCKET_T;
+}
+
+/**
+ * @brief Binds pre-bound sockets until the target is reached. Must be called without the mutex.
+ */
+static void pasv_refill_prebound(void)
+{
+    for (;;)
+    {
+        pthread_mutex_lock(&g_pasv.mutex);
+        if (!g_pasv.enabled || g_pasv.prebound_count + g_pasv.prebound_refilling >= g_pasv.prebound_target)
+        {
+            pthread_mutex_unlock(&g_pasv.mutex);
+            return;
+        }
+        g_pasv.prebound_refilling++;
+        pthread_mutex_unlock(&g_pasv.mutex);
+
+        uint16_t port = 0;
+        socket_t sock = pasv_bind_leased(g_pasv.bind_address[0] ? g_pasv.bind_address : NULL,
+                                         PASV_PORT_PREBIND_BACKLOG, &port);
+        if (sock != INVALID_SOCKET_T && net_set_nonblocking(sock, 1) != 0)
+        {
+            LOG_WARN("Failed to set pre-bound passive socket to non-blocking mode");
+        }
+
+        pthread_mutex_lock(&g_pasv.mutex);
+        g_pasv.prebound_refilling--;
+        int stored = 0;
+        if (sock != INVALID_SOCKET_T && g_pasv.enabled && g_pasv.prebound_count < g_pasv.prebound_target)
+        {
+            g_pasv.prebound[g_pasv.prebound_count].sock = sock;
+            g_pasv.prebound[g_pasv.prebound_count].port = port;
+            g_pasv.prebound_count++;
+            stored = 1;
+        }
+        pthread_mutex_unlock(&g_pasv.mutex);
+
+        if (sock == INVALID_SOCKET_T)
+            return; // Range exhausted, try again on the next release
+
+        if (!stored)
+        {
+            net_close_socket(sock);
+            pasv_port_release(port);
+            return;
+        }
+    }
+}
+
+int pasv_port_init(uint16_t port_min, uint16_t port_max, const char *bind_address, int prebind_count)
+{
+    if (port_min == 0 || port_min > port_max || prebind_count < 0)
+    {
+        LOG_ERROR("Invalid passive port range: %u-%u", port_min, port_max);
+        return -1;
+    }
+
+    int range_size = (int)port_max - (int)port_min + 1;
+    uint16_t *queue = (uint16_t *)malloc((size_t)range_size * sizeof(uint16_t));
+    pasv_prebound_t *prebound = NULL;
+    if (prebind_count > 0)
+    {
+        prebound = (pasv_prebound_t *)calloc((size_t)prebind_count, sizeof(pasv_prebound_t));
+    }
+    if (!queue || (prebind_count > 0 && !prebound))
+    {
+        free(queue);
+        free(prebound);
+        LOG_ERROR("Failed to allocate passive port allocator");
+        return -1;
+    }
+
+    // Shuffle, so several servers sharing a range do not collide in the same order
+    for (int i = 0; i < range_size; i++)
+    {
+        queue[i] = (uint16_t)(port_min + i);
+    }
+    unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)(uintptr_t)queue;
+    for (int i = range_size - 1; i > 0; i--)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int j = (int)((seed >> 8) % (unsigned int)(i + 1));
+        uint16_t tmp = queue[i];
+        queue[i] = queue[j];
+        queue[j] = tmp;
+    }
+
+    pthread_mutex_lock(&g_pasv.mutex);
+    if (g_pasv.enabled)
+    {
+        pthread_mutex_unlock(&g_pasv.mutex);
+        free(queue);
+        free(prebound);
+        LOG_ERROR("Passive port allocator already initialized");
+        return -1;
+    }
+    g_pasv.port_min = port_min;
+    g_pasv.port_max = port_max;
+    g_pasv.queue = queue;
+    g_pasv.range_size = range_size;
+    g_pasv.head = 0;
+    g_pasv.count = range_size;
+    memset(g_pasv.leased, 0, sizeof(g_pasv.leased));
+    snprintf(g_pasv.bind_address, sizeof(g_pasv.bind_address), "%s", bind_address ? bind_address : "");
+    g_pasv.prebound = prebound;
+    g_pasv.prebound_target = prebind_count;
+    g_pasv.prebound_count = 0;
+    g_pasv.prebound_refilling = 0;
+    g_pasv.leases = 0;
+    g_pasv.prebound_hits = 0;
+    g_pasv.bind_failures = 0;
+    g_pasv.enabled = 1;
+    pthread_mutex_unlock(&g_pasv.mutex);
+
+    pasv_refill_prebound();
+
+    LOG_INFO("Passive port allocator: ports %u-%u, %d pre-bound sockets", port_min, port_max, prebind_count);
+    return 0;
+}
+
+void pasv_port_cleanup(void)
+{
+    pthread_mutex_lock(&g_pasv.mutex);
+    if (!g_pasv.enabled)
+    {
+        pthread_mutex_unlock(&g_pasv.mutex);
+        return;
+    }
+
+    g_pasv.enabled = 0;
+    for (int i = 0; i < g_pasv.prebound_count; i++)
+    {
+        net_close_socket(g_pasv.prebound[i].sock);
+    }
+    free(g_pasv.prebound);
+    g_pasv.prebound = NULL;
+    g_pasv.prebound_count = 0;
+    g_pasv.prebound_target = 0;
+    free(g_pasv.queue);
+    g_pasv.queue = NULL;
+    g_pasv.count = 0;
+    g_pasv.range_size = 0;
+    pthread_mutex_unlock(&g_pasv.mutex);
+}
+
+int pasv_port_is_enabled(void)
+{
+    pthread_mutex_lock(&g_pasv.mutex);
+    int enabled = g_pasv.enabled;
+    pthread_mutex_unlock(&g_pasv.mutex);
+
+    return enabled;
+}
+
+socket_t pasv_port_acquire(const char *bind_address, int backlog, uint16_t *port)
+{
+    if (!port)
+        return INVALID_SOCKET_T;
+
+    const char *address = bind_address ? bind_address : "";
+    socket_t sock = INVALID_SOCKET_T;
+
+    pthread_mutex_lock(&g_pasv.mutex);
+    if (!g_pasv.enabled)
+    {
+        pthread_mutex_unlock(&g_pasv.mutex);
+        return INVALID_SOCKET_T;
+    }
+    if (g_pasv.prebound_count > 0 && strcmp(address, g_pasv.bind_address) == 0)
+    {
+        g_pasv.prebound_count--;
+        sock = g_pasv.prebound[g_pasv.prebound_count].sock;
+        *port = g_pasv.prebound[g_pasv.prebound_count].port;
+        g_pasv.prebound_hits++;
+        g_pasv.leases++;
+    }
+    pthread_mutex_unlock(&g_pasv.mutex);
+
+    if (sock != INVALID_SOCKET_T)
+    {
+        // Whoever connected before the port was announced is not our client
+        socket_t stray;
+        while ((stray = net_accept(sock, NULL, 0, NULL)) != INVALID_SOCKET_T)
+        {
+            LOG_WARN("Dropped connection that reached passive port %u before PASV", *port);
+            net_close_socket(stray);
+        }
+        return sock;
+    }
+
+    sock = pasv_bind_leased(bind_address, backlog, port);
+    if (sock != INVALID_SOCKET_T)
+    {
+        pthread_mutex_lock(&g_pasv.mutex);
+        g_pasv.leases++;
+        pthread_mutex_unlock(&g_pasv.mutex);
+    }
+    return sock;
+}
+
+void pasv_port_release(uint16_t port)
+{
+    pthread_mutex_lock(&g_pasv.mutex);
+    if (!g_pasv.enabled || port < g_pasv.port_min || port > g_pasv.port_max || !pasv_is_leased(port))
+    {
+        pthread_mutex_unlock(&g_pasv.mutex);
+        return;
+    }
+    pasv_push_locked(port);
+    int refill = g_pasv.prebound_count + g_pasv.prebound_refilling < g_pasv.prebound_target;
+    pthread_mutex_unlock(&g_pasv.mutex);
+
+    if (refill)
+        pasv_refill_prebound();
+}
+
+void pasv_port_get_stats(pasv_port_stats_t *stats)
+{
+    if (!stats)
+        return;
+
+    pthread_mutex_lock(&g_pasv.mutex);
+    stats->range_size = g_pasv.range_size;
+    stats->free_ports = g_pasv.count;
+    stats->leased_ports = g_pasv.range_size - g_pasv.count;
+    stats->prebound_sockets = g_pasv.prebound_count;
+    stats->leases = g_pasv.leases;
+    stats->prebound_hits = g_pasv.prebound_hits;
+    stats->bind_failures = g_pasv.bind_failures;
+    pthread_mutex_unlock(&g_pasv.mutex);
+}
@@ -266,6 +266,11 @@ int proto_parse_mode(const char *argument, proto_transfer_mode_t *mode)
         *mode = PROTO_MODE_COMPRESSED;
         return 0;
     }
+    else if (strcmp(arg_upper, "Z") == 0)
+    {
+        *mode = PROTO_MODE_DEFLATE;
+        return 0;
+    }
 
     return -1;
 }
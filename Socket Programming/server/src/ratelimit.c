@@ -0,0 +1,380 @@
+/**
+ * @file ratelimit.c
+ * @brief Hierarchical token-bucket bandwidth scheduler implementation
+ * @version 0.1
+ * @date 2025-11-29
+ *
+ */
+#define _POSIX_C_SOURCE 200112L
+#include "ratelimit.h"
+#include "atomics.h"
+#include "logger.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define RATELIMIT_US_PER_SECOND 1000000LL
+
+/**
+ * @brief A token bucket. The balance is kept in byte-microseconds so
+ * refills stay exact however often the bucket is charged.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;
+    unsigned long long rate; // Bytes per second, 0 if unlimited
+    long long balance;       // Tokens in bytes * 1e6, negative while in debt
+    long long burst;         // Most tokens the bucket can hold, same unit
+    long long last_us;       // Time of the last refill
+} bucket_t;
+
+// Bucket shared by all sessions of one user
+typedef struct user_bucket
+{
+    bucket_t bucket;
+    int refs;
+    struct user_bucket *next;
+    char username[];
+} user_bucket_t;
+
+struct ratelimit_session
+{
+    bucket_t bucket;     // The session's own bucket; its lock also guards user
+    user_bucket_t *user; // Shared bucket of the logged-in user, NULL if none
+};
+
+// Global scheduler state; users is protected by mutex
+static struct
+{
+    pthread_mutex_t mutex;
+    bucket_t global;
+    unsigned long long session_rate;
+    user_bucket_t *users;
+    int user_count;
+    unsigned long long charged;
+    unsigned long long delays;
+    unsigned long long delay_us;
+} g_rl = {.mutex = PTHREAD_MUTEX_INITIALIZER, .global = {.lock = PTHREAD_MUTEX_INITIALIZER}};
+
+/**
+ * @brief Gets a monotonic timestamp in microseconds
+ */
+static long long ratelimit_now_us(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / frequency.QuadPart) * RATELIMIT_US_PER_SECOND +
+           (long long)(counter.QuadPart % frequency.QuadPart) * RATELIMIT_US_PER_SECOND / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * RATELIMIT_US_PER_SECOND + ts.tv_nsec / 1000;
+#endif
+}
+
+/**
+ * @brief Sets the rate of a bucket. Caller holds the bucket lock.
+ */
+static void bucket_set_rate_locked(bucket_t *bucket, unsigned long long rate, long long now)
+{
+    unsigned long long burst = rate / RATELIMIT_BURST_DIVISOR;
+    if (burst < RATELIMIT_MIN_BURST)
+        burst = RATELIMIT_MIN_BURST;
+
+    // A bucket that was unlimited starts full, a limited one keeps its debt
+    if (bucket->rate == 0 || bucket->last_us == 0)
+        bucket->balance = (long long)burst * RATELIMIT_US_PER_SECOND;
+    bucket->rate = rate;
+    bucket->burst = (long long)burst * RATELIMIT_US_PER_SECOND;
+    if (bucket->balance > bucket->burst)
+        bucket->balance = bucket->burst;
+    bucket->last_us = now;
+}
+
+static void bucket_init(bucket_t *bucket, unsigned long long rate)
+{
+    pthread_mutex_init(&bucket->lock, NULL);
+    bucket->rate = 0;
+    bucket->balance = 0;
+    bucket->last_us = 0;
+    bucket_set_rate_locked(bucket, rate, ratelimit_now_us());
+}
+
+/**
+ * @brief Refills a bucket and takes bytes from it. Caller holds the bucket lock.
+ *
+ * @return Microseconds until the bucket is out of debt, 0 if it is not in debt.
+ */
+static long long bucket_charge_locked(bucket_t *bucket, size_t bytes, long long now)
+{
+    if (bucket->rate == 0)
+        return 0;
+
+    // Compared by division first, so long idle periods cannot overflow
+    long long elapsed = now - bucket->last_us;
+    long long missing = bucket->burst - bucket->balance;
+    if (elapsed > 0)
+    {
+        if ((unsigned long long)elapsed >= (unsigned long long)missing / bucket->rate + 1)
+            bucket->balance = bucket->burst;
+        else
+            bucket->balance += elapsed * (long long)bucket->rate;
+        bucket->last_us = now;
+    }
+
+    bucket->balance -= (long long)bytes * RATELIMIT_US_PER_SECOND;
+    if (bucket->balance >= 0)
+        return 0;
+    return (-bucket->balance + (long long)bucket->rate - 1) / (long long)bucket->rate;
+}
+
+/**
+ * @brief Drops a reference to a user bucket, freeing it with the last one.
+ */
+static void user_bucket_put(user_bucket_t *user)
+{
+    if (!user)
+        return;
+
+    pthread_mutex_lock(&g_rl.mutex);
+    if (--user->refs > 0)
+    {
+        pthread_mutex_unlock(&g_rl.mutex);
+        return;
+    }
+
+    user_bucket_t **link = &g_rl.users;
+    while (*link && *link != user)
+        link = &(*link)->next;
+    if (*link)
+        *link = user->next;
+    g_rl.user_count--;
+    pthread_mutex_unlock(&g_rl.mutex);
+
+    pthread_mutex_destroy(&user->bucket.lock);
+    free(user);
+}
+
+/**
+ * @brief Finds or creates the bucket of a user and takes a reference.
+ */
+static user_bucket_t *user_bucket_get(const char *username, unsigned long long rate)
+{
+    pthread_mutex_lock(&g_rl.mutex);
+
+    user_bucket_t *user = g_rl.users;
+    while (user && strcmp(user->username, username) != 0)
+        user = user->next;
+
+    if (user)
+    {
+        user->refs++;
+        pthread_mutex_lock(&user->bucket.lock);
+        if (user->bucket.rate != rate)
+            bucket_set_rate_locked(&user->bucket, rate, ratelimit_now_us());
+        pthread_mutex_unlock(&user->bucket.lock);
+    }
+    else
+    {
+        size_t username_len = strlen(username);
+        user = (user_bucket_t *)malloc(sizeof(user_bucket_t) + username_len + 1);
+        if (user)
+        {
+            bucket_init(&user->bucket, rate);
+            user->refs = 1;
+            memcpy(user->username, username, username_len + 1);
+            user->next = g_rl.users;
+            g_rl.users = user;
+            g_rl.user_count++;
+        }
+    }
+
+    pthread_mutex_unlock(&g_rl.mutex);
+    return user;
+}
+
+int ratelimit_init(unsigned long long global_rate, unsigned long long session_rate)
+{
+    if (global_rate > RATELIMIT_MAX_RATE || session_rate > RATELIMIT_MAX_RATE)
+        return -1;
+
+    pthread_mutex_lock(&g_rl.global.lock);
+    bucket_set_rate_locked(&g_rl.global, global_rate, ratelimit_now_us());
+    pthread_mutex_unlock(&g_rl.global.lock);
+
+    pthread_mutex_lock(&g_rl.mutex);
+    g_rl.session_rate = session_rate;
+    pthread_mutex_unlock(&g_rl.mutex);
+
+    ATOMIC_STORE_RELAXED(&g_rl.charged, 0);
+    ATOMIC_STORE_RELAXED(&g_rl.delays, 0);
+    ATOMIC_STORE_RELAXED(&g_rl.delay_us, 0);
+
+    return 0;
+}
+
+void ratelimit_cleanup(void)
+{
+    ratelimit_init(0, 0);
+
+    pthread_mutex_lock(&g_rl.mutex);
+    if (g_rl.users)
+        LOG_WARN("Bandwidth scheduler cleaned up with %d user buckets in use", g_rl.user_count);
+    pthread_mutex_unlock(&g_rl.mutex);
+}
+
+ratelimit_session_t *ratelimit_session_create(void)
+{
+    ratelimit_session_t *limiter = (ratelimit_session_t *)calloc(1, sizeof(ratelimit_session_t));
+    if (!limiter)
+    {
+        LOG_ERROR("Failed to allocate session rate limiter");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_rl.mutex);
+    unsigned long long rate = g_rl.session_rate;
+    pthread_mutex_unlock(&g_rl.mutex);
+
+    bucket_init(&limiter->bucket, rate);
+    return limiter;
+}
+
+int ratelimit_session_set_user(ratelimit_session_t *limiter, const char *username,
+                               unsigned long long user_rate)
+{
+    if (!limiter || user_rate > RATELIMIT_MAX_RATE)
+        return -1;
+
+    user_bucket_t *user = NULL;
+    if (username)
+    {
+        user = user_bucket_get(username, user_rate);
+        if (!user)
+            LOG_ERROR("Failed to allocate rate limiter of user '%s'", username);
+    }
+
+    pthread_mutex_lock(&limiter->bucket.lock);
+    user_bucket_t *previous = limiter->user;
+    limiter->user = user;
+    pthread_mutex_unlock(&limiter->bucket.lock);
+
+    user_bucket_put(previous);
+    return (username && !user) ? -1 : 0;
+}
+
+void ratelimit_session_destroy(ratelimit_session_t *limiter)
+{
+    if (!limiter)
+        return;
+
+    user_bucket_put(limiter->user);
+    pthread_mutex_destroy(&limiter->bucket.lock);
+    free(limiter);
+}
+
+size_t ratelimit_session_size(void)
+{
+    return sizeof(ratelimit_session_t);
+}
+
+/**
+ * @brief Lowers a minimum rate by a bucket's rate if the bucket is limited.
+ */
+static unsigned long long min_rate(unsigned long long current, unsigned long long rate)
+{
+    if (rate == 0)
+        return current;
+    return (current == 0 || rate < current) ? rate : current;
+}
+
+size_t ratelimit_chunk_size(ratelimit_session_t *limiter, size_t max_bytes)
+{
+    if (!limiter)
+        return max_bytes;
+
+    // Lock order: session, user, global
+    pthread_mutex_lock(&limiter->bucket.lock);
+    unsigned long long rate = limiter->bucket.rate;
+    if (limiter->user)
+    {
+        pthread_mutex_lock(&limiter->user->bucket.lock);
+        rate = min_rate(rate, limiter->user->bucket.rate);
+        pthread_mutex_unlock(&limiter->user->bucket.lock);
+    }
+    pthread_mutex_lock(&g_rl.global.lock);
+    rate = min_rate(rate, g_rl.global.rate);
+    pthread_mutex_unlock(&g_rl.global.lock);
+    pthread_mutex_unlock(&limiter->bucket.lock);
+
+    if (rate == 0)
+        return max_bytes;
+
+    unsigned long long chunk = rate / RATELIMIT_CHUNKS_PER_SECOND;
+    if (chunk < RATELIMIT_MIN_CHUNK)
+        chunk = RATELIMIT_MIN_CHUNK;
+    return chunk < max_bytes ? (size_t)chunk : max_bytes;
+}
+
+long long ratelimit_charge(ratelimit_session_t *limiter, size_t bytes)
+{
+    if (!limiter || bytes == 0)
+        return 0;
+
+    long long now = ratelimit_now_us();
+
+    // Every level is charged, so each one accounts for all the bytes that passed it
+    pthread_mutex_lock(&limiter->bucket.lock);
+    long long wait_us = bucket_charge_locked(&limiter->bucket, bytes, now);
+    if (limiter->user)
+    {
+        pthread_mutex_lock(&limiter->user->bucket.lock);
+        long long user_wait = bucket_charge_locked(&limiter->user->bucket, bytes, now);
+        pthread_mutex_unlock(&limiter->user->bucket.lock);
+        if (user_wait > wait_us)
+            wait_us = user_wait;
+    }
+    pthread_mutex_lock(&g_rl.global.lock);
+    long long global_wait = bucket_charge_locked(&g_rl.global, bytes, now);
+    pthread_mutex_unlock(&g_rl.global.lock);
+    pthread_mutex_unlock(&limiter->bucket.lock);
+    if (global_wait > wait_us)
+        wait_us = global_wait;
+
+    ATOMIC_FETCH_ADD_RELAXED(&g_rl.charged, (unsigned long long)bytes);
+    if (wait_us > 0)
+    {
+        ATOMIC_FETCH_ADD_RELAXED(&g_rl.delays, 1);
+        ATOMIC_FETCH_ADD_RELAXED(&g_rl.delay_us, (unsigned long long)wait_us);
+    }
+    return wait_us;
+}
+
+void ratelimit_get_stats(ratelimit_stats_t *stats)
+{
+    if (!stats)
+        return;
+
+    pthread_mutex_lock(&g_rl.global.lock);
+    stats->global_rate = g_rl.global.rate;
+    pthread_mutex_unlock(&g_rl.global.lock);
+
+    pthread_mutex_lock(&g_rl.mutex);
+    stats->session_rate = g_rl.session_rate;
+    stats->user_buckets = g_rl.user_count;
+    pthread_mutex_unlock(&g_rl.mutex);
+
+    stats->charged = ATOMIC_LOAD_RELAXED(&g_rl.charged);
+    stats->delays = ATOMIC_LOAD_RELAXED(&g_rl.delays);
+    stats->delay_us = ATOMIC_LOAD_RELAXED(&g_rl.delay_us);
+}
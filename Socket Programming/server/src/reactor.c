@@ -0,0 +1,470 @@
+/**
+ * @file reactor.c
+ * @brief Readiness-based event loop implementation (epoll / kqueue)
+ * @version 0.1
+ * @date 2025-11-20
+ *
+ */
+#ifdef __linux__
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "reactor.h"
+#include "logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#if defined(__linux__)
+#define REACTOR_USE_EPOLL
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || \
+    defined(__DragonFly__)
+#define REACTOR_USE_KQUEUE
+#endif
+
+#if defined(REACTOR_USE_EPOLL) || defined(REACTOR_USE_KQUEUE)
+
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef REACTOR_USE_EPOLL
+#include <sys/epoll.h>
+#else
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+#define REACTOR_MAX_THREADS 64
+#define REACTOR_MIN_DEFAULT_THREADS 4
+#define REACTOR_MAX_EVENTS 8 // Small batches keep slow callbacks from starving other sockets
+
+/**
+ * @brief Registration record for a watched socket
+ */
+typedef struct reactor_entry
+{
+    socket_t sock;
+    void *user_data;
+    struct reactor_entry *prev;
+    struct reactor_entry *next;
+} reactor_entry_t;
+
+/**
+ * @brief Global reactor state
+ */
+static struct
+{
+    int poll_fd;     // epoll or kqueue descriptor
+    int wake_fds[2]; // Pipe used to wake loop threads on shutdown
+    volatile int running;
+    pthread_t threads[REACTOR_MAX_THREADS];
+    int thread_count;
+    reactor_read_cb_t on_readable;
+    reactor_close_cb_t on_close;
+    reactor_tick_cb_t on_tick;
+    int tick_ms;
+    reactor_entry_t *entries; // All registered sockets
+    pthread_mutex_t lock;     // Protects entries
+} g_reactor = {
+    .poll_fd = -1,
+    .wake_fds = {-1, -1},
+    .running = 0,
+    .thread_count = 0,
+    .entries = NULL,
+    .lock = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief Gets a monotonic timestamp in milliseconds
+ */
+static long long reactor_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Arms (or re-arms) a socket for a single readiness notification
+ *
+ * @param entry Registration record
+ * @param first 1 when the socket is being added, 0 when re-arming
+ * @return 0 on success, -1 on error
+ */
+static int reactor_arm(reactor_entry_t *entry, int first)
+{
+#ifdef REACTOR_USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.ptr = entry;
+    return epoll_ctl(g_reactor.poll_fd, first ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, entry->sock, &ev);
+#else
+    struct kevent ev;
+    EV_SET(&ev, entry->sock, EVFILT_READ, (first ? EV_ADD : EV_ENABLE) | EV_DISPATCH, 0, 0, entry);
+    return kevent(g_reactor.poll_fd, &ev, 1, NULL, 0, NULL);
+#endif
+}
+
+/**
+ * @brief Removes a socket from the poll set
+ */
+static void reactor_disarm(reactor_entry_t *entry)
+{
+#ifdef REACTOR_USE_EPOLL
+    struct epoll_event ev; // Non-NULL for kernels before 2.6.9
+    epoll_ctl(g_reactor.poll_fd, EPOLL_CTL_DEL, entry->sock, &ev);
+#else
+    struct kevent ev;
+    EV_SET(&ev, entry->sock, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    kevent(g_reactor.poll_fd, &ev, 1, NULL, 0, NULL);
+#endif
+}
+
+/**
+ * @brief Unlinks an entry from the registration list (caller holds the lock)
+ */
+static void reactor_unlink_entry(reactor_entry_t *entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        g_reactor.entries = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+/**
+ * @brief Unregisters an entry and hands its user data to the close callback
+ */
+static void reactor_release_entry(reactor_entry_t *entry)
+{
+    void *user_data = entry->user_data;
+
+    reactor_disarm(entry);
+
+    pthread_mutex_lock(&g_reactor.lock);
+    reactor_unlink_entry(entry);
+    pthread_mutex_unlock(&g_reactor.lock);
+
+    free(entry);
+    g_reactor.on_close(user_data);
+}
+
+/**
+ * @brief Waits for readiness events
+ *
+ * @return Number of entries stored in out (wake-ups are reported as NULL), -1 on error
+ */
+static int reactor_wait(reactor_entry_t **out, int max_events, int timeout_ms)
+{
+#ifdef REACTOR_USE_EPOLL
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    int n = epoll_wait(g_reactor.poll_fd, events, max_events, timeout_ms);
+    for (int i = 0; i < n; i++)
+        out[i] = (reactor_entry_t *)events[i].data.ptr;
+    return n;
+#else
+    struct kevent events[REACTOR_MAX_EVENTS];
+    struct timespec ts;
+    struct timespec *tsp = NULL;
+    if (timeout_ms >= 0)
+    {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    int n = kevent(g_reactor.poll_fd, NULL, 0, events, max_events, tsp);
+    for (int i = 0; i < n; i++)
+        out[i] = (reactor_entry_t *)events[i].udata;
+    return n;
+#endif
+}
+
+/**
+ * @brief Event loop thread
+ *
+ * @param arg Loop index cast to a pointer; loop 0 also drives the tick callback
+ * @return NULL
+ */
+static void *reactor_loop(void *arg)
+{
+    int index = (int)(intptr_t)arg;
+    int drives_tick = (index == 0 && g_reactor.on_tick && g_reactor.tick_ms > 0);
+    long long next_tick = reactor_now_ms() + g_reactor.tick_ms;
+    reactor_entry_t *ready[REACTOR_MAX_EVENTS];
+
+    LOG_DEBUG("Reactor loop %d started", index);
+
+    while (g_reactor.running)
+    {
+        int timeout_ms = -1;
+        if (drives_tick)
+        {
+            long long remaining = next_tick - reactor_now_ms();
+            timeout_ms = remaining > 0 ? (int)remaining : 0;
+        }
+
+        int n = reactor_wait(ready, REACTOR_MAX_EVENTS, timeout_ms);
+        if (n < 0 && errno != EINTR)
+        {
+            LOG_ERROR("Reactor wait failed: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n && g_reactor.running; i++)
+        {
+            reactor_entry_t *entry = ready[i];
+            if (!entry)
+                continue; // Wake-up pipe, loop condition handles shutdown
+
+            if (g_reactor.on_readable(entry->user_data) == 0)
+            {
+                if (reactor_arm(entry, 0) == 0)
+                    continue;
+                LOG_WARN("Failed to re-arm socket %d: %s", (int)entry->sock, strerror(errno));
+            }
+            reactor_release_entry(entry);
+        }
+
+        if (drives_tick && g_reactor.running && reactor_now_ms() >= next_tick)
+        {
+            g_reactor.on_tick();
+            next_tick = reactor_now_ms() + g_reactor.tick_ms;
+        }
+    }
+
+    LOG_DEBUG("Reactor loop %d stopped", index);
+    return NULL;
+}
+
+int reactor_is_supported(void)
+{
+    return 1;
+}
+
+const char *reactor_get_backend_name(void)
+{
+#ifdef REACTOR_USE_EPOLL
+    return "epoll";
+#else
+    return "kqueue";
+#endif
+}
+
+int reactor_init(int num_threads, reactor_read_cb_t on_readable, reactor_close_cb_t on_close,
+                 reactor_tick_cb_t on_tick, int tick_ms)
+{
+    if (!on_readable || !on_close)
+        return -1;
+
+    if (g_reactor.running)
+    {
+        LOG_WARN("Reactor already running");
+        return -1;
+    }
+
+    if (num_threads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > REACTOR_MIN_DEFAULT_THREADS ? (int)cpus : REACTOR_MIN_DEFAULT_THREADS;
+    }
+    if (num_threads > REACTOR_MAX_THREADS)
+        num_threads = REACTOR_MAX_THREADS;
+
+#ifdef REACTOR_USE_EPOLL
+    g_reactor.poll_fd = epoll_create(REACTOR_MAX_EVENTS); // Size hint is ignored by modern kernels
+#else
+    g_reactor.poll_fd = kqueue();
+#endif
+    if (g_reactor.poll_fd < 0)
+    {
+        LOG_ERROR("Failed to create %s instance: %s", reactor_get_backend_name(), strerror(errno));
+        return -1;
+    }
+
+    if (pipe(g_reactor.wake_fds) != 0)
+    {
+        LOG_ERROR("Failed to create reactor wake pipe: %s", strerror(errno));
+        close(g_reactor.poll_fd);
+        g_reactor.poll_fd = -1;
+        return -1;
+    }
+
+    // The wake pipe stays level-triggered so a single write wakes every loop
+#ifdef REACTOR_USE_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    int rc = epoll_ctl(g_reactor.poll_fd, EPOLL_CTL_ADD, g_reactor.wake_fds[0], &ev);
+#else
+    struct kevent ev;
+    EV_SET(&ev, g_reactor.wake_fds[0], EVFILT_READ, EV_ADD, 0, 0, NULL);
+    int rc = kevent(g_reactor.poll_fd, &ev, 1, NULL, 0, NULL);
+#endif
+    if (rc != 0)
+    {
+        LOG_ERROR("Failed to register reactor wake pipe: %s", strerror(errno));
+        close(g_reactor.wake_fds[0]);
+        close(g_reactor.wake_fds[1]);
+        close(g_reactor.poll_fd);
+        g_reactor.wake_fds[0] = g_reactor.wake_fds[1] = -1;
+        g_reactor.poll_fd = -1;
+        return -1;
+    }
+
+    g_reactor.on_readable = on_readable;
+    g_reactor.on_close = on_close;
+    g_reactor.on_tick = on_tick;
+    g_reactor.tick_ms = tick_ms;
+    g_reactor.running = 1;
+    g_reactor.thread_count = 0;
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        if (pthread_create(&g_reactor.threads[i], NULL, reactor_loop, (void *)(intptr_t)i) != 0)
+        {
+            LOG_ERROR("Failed to create reactor loop thread %d", i);
+            break;
+        }
+        g_reactor.thread_count++;
+    }
+
+    if (g_reactor.thread_count == 0)
+    {
+        reactor_shutdown();
+        return -1;
+    }
+
+    LOG_INFO("Reactor started: backend=%s, loops=%d", reactor_get_backend_name(), g_reactor.thread_count);
+    return 0;
+}
+
+int reactor_add(socket_t sock, void *user_data)
+{
+    if (!g_reactor.running || sock == INVALID_SOCKET_T)
+        return -1;
+
+    reactor_entry_t *entry = (reactor_entry_t *)malloc(sizeof(reactor_entry_t));
+    if (!entry)
+    {
+        LOG_ERROR("Failed to allocate reactor entry");
+        return -1;
+    }
+
+    entry->sock = sock;
+    entry->user_data = user_data;
+    entry->prev = NULL;
+
+    pthread_mutex_lock(&g_reactor.lock);
+    entry->next = g_reactor.entries;
+    if (g_reactor.entries)
+        g_reactor.entries->prev = entry;
+    g_reactor.entries = entry;
+    pthread_mutex_unlock(&g_reactor.lock);
+
+    if (reactor_arm(entry, 1) != 0)
+    {
+        LOG_ERROR("Failed to register socket %d with reactor: %s", (int)sock, strerror(errno));
+        pthread_mutex_lock(&g_reactor.lock);
+        reactor_unlink_entry(entry);
+        pthread_mutex_unlock(&g_reactor.lock);
+        free(entry);
+        return -1;
+    }
+
+    return 0;
+}
+
+void reactor_shutdown(void)
+{
+    if (g_reactor.poll_fd < 0)
+        return;
+
+    g_reactor.running = 0;
+
+    // Wake every loop thread blocked in the poll call
+    if (g_reactor.wake_fds[1] >= 0)
+    {
+        char byte = 1;
+        ssize_t written = write(g_reactor.wake_fds[1], &byte, 1);
+        (void)written;
+    }
+
+    for (int i = 0; i < g_reactor.thread_count; i++)
+    {
+        pthread_join(g_reactor.threads[i], NULL);
+    }
+    g_reactor.thread_count = 0;
+
+    // Drop registration records; sockets and user data belong to the caller
+    pthread_mutex_lock(&g_reactor.lock);
+    reactor_entry_t *entry = g_reactor.entries;
+    while (entry)
+    {
+        reactor_entry_t *next = entry->next;
+        free(entry);
+        entry = next;
+    }
+    g_reactor.entries = NULL;
+    pthread_mutex_unlock(&g_reactor.lock);
+
+    close(g_reactor.wake_fds[0]);
+    close(g_reactor.wake_fds[1]);
+    close(g_reactor.poll_fd);
+    g_reactor.wake_fds[0] = g_reactor.wake_fds[1] = -1;
+    g_reactor.poll_fd = -1;
+
+    LOG_INFO("Reactor stopped");
+}
+
+int reactor_get_thread_count(void)
+{
+    return g_reactor.running ? g_reactor.thread_count : 0;
+}
+
+#else // No event backend on this platform
+
+int reactor_is_supported(void)
+{
+    return 0;
+}
+
+const char *reactor_get_backend_name(void)
+{
+    return "none";
+}
+
+int reactor_init(int num_threads, reactor_read_cb_t on_readable, reactor_close_cb_t on_close,
+                 reactor_tick_cb_t on_tick, int tick_ms)
+{
+    (void)num_threads;
+    (void)on_readable;
+    (void)on_close;
+    (void)on_tick;
+    (void)tick_ms;
+    LOG_ERROR("Event engine is not supported on this platform");
+    return -1;
+}
+
+int reactor_add(socket_t sock, void *user_data)
+{
+    (void)sock;
+    (void)user_data;
+    return -1;
+}
+
+void reactor_shutdown(void)
+{
+}
+
+int reactor_get_thread_count(void)
+{
+    return 0;
+}
+
+#endif
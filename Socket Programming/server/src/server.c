@@ -5,14 +5,31 @@
  * @date 2025-11-03
  */
 
+#if defined(__linux__)
+#define _GNU_SOURCE // pthread_setaffinity_np()
+#endif
 #include "server.h"
 #include "network.h"
 #include "logger.h"
+#include "atomics.h"
 #include "session.h"
 #include "command.h"
 #include "protocol.h"
 #include "filesys.h"
 #include "auth.h"
+#include "reactor.h"
+#include "threadpool.h"
+#include "listcache.h"
+#include "metrics.h"
+#include "pasvport.h"
+#include "ratelimit.h"
+#include "datacomp.h"
+#include "digestcache.h"
+#include "hotcache.h"
+#include "tlssock.h"
+#include "transfer.h"
+#include "timerwheel.h"
+#include "utils.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,35 +42,90 @@
 #else
 #include <unistd.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#define COMMAND_BUFFER_SIZE 1024      // Longest accepted command line (including CRLF)
+#define DEFAULT_TRANSFER_WORKERS 256  // Transfer worker limit when connections are unlimited
+#define ACCEPTOR_POLL_MS 500          // How often acceptor threads check for shutdown
 
 // Server state
 static volatile int g_server_running = 0;
 static socket_t g_listening_socket = INVALID_SOCKET_T;
 static server_config_t g_config;
 
-// Connection tracking
-static volatile int g_current_connections = 0;
-static pthread_mutex_t g_connection_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Connection tracking, updated atomically by any acceptor and session thread
+static int g_current_connections = 0;
 
 /**
- * @brief Client session thread function
+ * @brief Acceptor thread state
  *
- * Handles all communication with a single FTP client.
+ * With SO_REUSEPORT every acceptor has its own socket and the kernel spreads
+ * connections across them; otherwise all acceptors share g_listening_socket.
+ */
+typedef struct
+{
+    socket_t sock;
+    pthread_t thread;
+    int index;
+    int started; // 1 once the thread runs
+} acceptor_t;
+
+static acceptor_t g_acceptors[SERVER_MAX_ACCEPTORS];
+static int g_acceptor_count = 0; // 0 when the main thread accepts alone
+
+/**
+ * @brief Control connection state for the event engine
  *
- * @param arg Pointer to session_t structure
- * @return NULL
+ * Partially received command lines stay in the session's control buffer
+ * between readiness notifications. Clients are kept in a list so remaining
+ * sessions can be released on shutdown. Sessions secured with AUTH TLS move
+ * to a client thread, as TLS reads cannot be resumed by a later event.
  */
-static void *client_thread(void *arg)
+typedef struct event_client
 {
-    session_t *session = (session_t *)arg;
-    if (!session)
+    session_t *session;
+    struct event_client *prev;
+    struct event_client *next;
+} event_client_t;
+
+static int g_event_engine_active = 0;
+static event_client_t *g_event_clients = NULL;
+static pthread_mutex_t g_event_clients_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Counts a new connection unless max_connections is reached
+ *
+ * @return 0 if the connection was counted, -1 if the server is full
+ */
+static int server_connection_reserve(void)
+{
+    int current = ATOMIC_LOAD_RELAXED(&g_current_connections);
+    do
     {
-        LOG_ERROR("Client thread received NULL session");
-        return NULL;
-    }
+        if (g_config.max_connections > 0 && current >= g_config.max_connections)
+            return -1;
+    } while (!ATOMIC_CAS_WEAK_RELAXED(&g_current_connections, &current, current + 1));
+    return 0;
+}
 
-    LOG_INFO("Client thread started for %s:%u", session->client_ip, session->client_port);
+/**
+ * @brief Uncounts a connection counted by server_connection_reserve()
+ */
+static void server_connection_release(void)
+{
+    ATOMIC_FETCH_SUB(&g_current_connections, 1);
+}
 
+/**
+ * @brief Sends the welcome banner on a new control connection
+ *
+ * @param session Pointer to session structure
+ * @return 0 on success, -1 on error
+ */
+static int session_greet(session_t *session)
+{
     // Configure socket to receive urgent data inline
     if (net_set_oob_inline(session->control_socket, 1) != 0)
     {
@@ -64,35 +136,228 @@ static void *client_thread(void *arg)
     if (session_send_response(session, PROTO_RESP_SERVICE_READY, "FTP Server Ready") != 0)
     {
         LOG_ERROR("Failed to send welcome message");
-        session_destroy(session);
+        return -1;
+    }
 
-        // Decrement connection count
-        pthread_mutex_lock(&g_connection_mutex);
-        g_current_connections--;
-        pthread_mutex_unlock(&g_connection_mutex);
+    return 0;
+}
 
-        return NULL;
+/**
+ * @brief Parses and dispatches one command line received from a client
+ *
+ * Shared by both engines so commands behave identically.
+ *
+ * @param session Pointer to session structure
+ * @param line Received line (including CRLF)
+ * @param has_urgent Non-zero if urgent data preceded the line
+ */
+static void process_command_line(session_t *session, const char *line, int has_urgent)
+{
+    proto_command_t cmd;
+
+    // Update last activity time
+    session_update_activity(session);
+
+    // Parse the command
+    if (proto_parse_command(line, &cmd) != 0)
+    {
+        LOG_WARN("Failed to parse command: %s", line);
+        session_send_response(session, PROTO_RESP_SYNTAX_ERROR, "Syntax error, command unrecognized");
+        return;
     }
 
-    char command_buffer[1024];
-    proto_command_t cmd;
+    // Increment command counter
+    session->commands_received++;
+
+    // Special logging for urgent commands
+    if (has_urgent > 0)
+    {
+        LOG_INFO("Client %s:%u: [URGENT] %s %s",
+                 session->client_ip, session->client_port,
+                 cmd.command, cmd.has_argument ? cmd.argument : "");
+    }
+    else
+    {
+        LOG_INFO("Client %s:%u: %s %s",
+                 session->client_ip, session->client_port,
+                 cmd.command, cmd.has_argument ? cmd.argument : "");
+    }
+
+    // Dispatch command to handler
+    // ABOR will be dispatched through the normal command handler mechanism
+    if (cmd_dispatch((cmd_handler_context_t)session, &cmd) != 0)
+    {
+        // Command not recognized or handler failed
+        if (!cmd_is_registered(cmd.command))
+        {
+            LOG_WARN("Unknown command: %s", cmd.command);
+            session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL, "Command not implemented");
+        }
+        else
+        {
+            LOG_WARN("Command handler failed: %s", cmd.command);
+            // Handler sends appropriate error response
+        }
+    }
+    LOG_DEBUG("Finished processing command: %s", cmd.command);
+}
+
+/**
+ * @brief Runs the command loop of a session on its own thread until it ends, then releases it
+ *
+ * @param session Pointer to session structure
+ */
+static void client_session_run(session_t *session)
+{
+    char command_buffer[COMMAND_BUFFER_SIZE];
 
     // Main command loop
     while (!session->should_quit && g_server_running)
     {
+        // AUTH TLS was accepted; the handshake blocks, so it runs here rather than in the handler
+        if (session->tls_pending && session_secure_control(session) != 0)
+        {
+            break;
+        }
+
         LOG_DEBUG("Waiting for command from client %s:%u",
                   session->client_ip, session->client_port);
-        int has_urgent = net_has_urgent_data(session->control_socket);
+        // Receive command from client (served from the control buffer when pipelined)
+        // The idle timer shuts the connection down, so no receive timeout is needed
+        int has_urgent = 0;
+        int bytes_received = session_receive_line(session,
+                                                  command_buffer,
+                                                  sizeof(command_buffer),
+                                                  -1,
+                                                  &has_urgent);
+
+        if (bytes_received <= 0)
+        {
+            if (bytes_received == 0)
+            {
+                LOG_INFO("Client %s:%u disconnected",
+                         session->client_ip, session->client_port);
+            }
+            else
+            {
+                LOG_WARN("Error receiving command from client %s:%u",
+                         session->client_ip, session->client_port);
+            }
+            break;
+        }
+
         if (has_urgent > 0)
         {
             LOG_INFO("Urgent data detected - priority command expected (likely ABOR)");
         }
-        // Receive command from client
-        int bytes_received = net_receive_line(session->control_socket,
-                                              command_buffer,
-                                              sizeof(command_buffer),
-                                              g_config.command_timeout_ms);
 
+        process_command_line(session, command_buffer, has_urgent);
+    }
+
+    LOG_INFO("Client session ended for %s:%u", session->client_ip, session->client_port);
+
+    // Clean up session
+    session_destroy(session);
+
+    // Decrement connection count
+    server_connection_release();
+}
+
+/**
+ * @brief Client session thread function
+ *
+ * Handles all communication with a single FTP client.
+ *
+ * @param arg Pointer to session_t structure
+ * @return NULL
+ */
+static void *client_thread(void *arg)
+{
+    session_t *session = (session_t *)arg;
+    if (!session)
+    {
+        LOG_ERROR("Client thread received NULL session");
+        return NULL;
+    }
+
+    LOG_INFO("Client thread started for %s:%u", session->client_ip, session->client_port);
+
+    if (session_greet(session) != 0)
+    {
+        session_destroy(session);
+
+        // Decrement connection count
+        server_connection_release();
+
+        return NULL;
+    }
+
+    client_session_run(session);
+    return NULL;
+}
+
+/**
+ * @brief Thread function for a session the event engine handed over after AUTH TLS
+ *
+ * @param arg Pointer to session_t structure
+ * @return NULL
+ */
+static void *secured_client_thread(void *arg)
+{
+    session_t *session = (session_t *)arg;
+
+    LOG_INFO("Client thread took over TLS session of %s:%u", session->client_ip, session->client_port);
+
+    client_session_run(session);
+    return NULL;
+}
+
+/**
+ * @brief Starts a detached thread for a session
+ *
+ * @param session Pointer to session structure, owned by the thread on success
+ * @param start_routine Thread function
+ * @return 0 on success, -1 on error
+ */
+static int client_thread_start(session_t *session, void *(*start_routine)(void *))
+{
+    pthread_t thread_id;
+    if (pthread_create(&thread_id, NULL, start_routine, session) != 0)
+    {
+        LOG_ERROR("Failed to create thread for client %s:%u", session->client_ip, session->client_port);
+        return -1;
+    }
+
+    // Detach thread so it cleans up automatically when done
+    pthread_detach(thread_id);
+
+    LOG_DEBUG("Created thread for client %s:%u", session->client_ip, session->client_port);
+    return 0;
+}
+
+/**
+ * @brief Reactor read callback: consumes available bytes and runs complete commands
+ *
+ * @param user_data Pointer to event_client_t
+ * @return 0 to keep the connection, -1 to close it
+ */
+static int event_client_readable(void *user_data)
+{
+    event_client_t *client = (event_client_t *)user_data;
+    session_t *session = client->session;
+
+    int has_urgent = net_has_urgent_data(session->control_socket);
+    if (has_urgent > 0)
+    {
+        LOG_INFO("Urgent data detected - priority command expected (likely ABOR)");
+    }
+
+    // Socket is readable, so a single receive does not block. TLS may decrypt more than fits
+    // the buffer, and readiness events do not report what it holds, so that is drained too.
+    char command_buffer[COMMAND_BUFFER_SIZE];
+    do
+    {
+        int bytes_received = net_line_buffer_fill(session->control_socket, &session->control_buffer);
         if (bytes_received <= 0)
         {
             if (bytes_received == 0)
@@ -105,69 +370,384 @@ static void *client_thread(void *arg)
                 LOG_WARN("Error receiving command from client %s:%u",
                          session->client_ip, session->client_port);
             }
-            break;
+            return -1;
         }
 
-        // Update last activity time
-        session_update_activity(session);
-
-        // Parse the command
-        if (proto_parse_command(command_buffer, &cmd) != 0)
+        // Run every complete line; a trailing partial line stays buffered for the next event
+        while (!session->should_quit && !session->tls_pending && g_server_running)
         {
-            LOG_WARN("Failed to parse command: %s", command_buffer);
-            session_send_response(session, PROTO_RESP_SYNTAX_ERROR, "Syntax error, command unrecognized");
-            continue;
+            int line_length = net_line_buffer_next(&session->control_buffer, command_buffer, sizeof(command_buffer));
+            if (line_length == 0)
+                break;
+            if (line_length < 0)
+            {
+                // Line too long (same as net_receive_line)
+                LOG_WARN("Error receiving command from client %s:%u",
+                         session->client_ip, session->client_port);
+                return -1;
+            }
+
+            process_command_line(session, command_buffer, has_urgent);
+            has_urgent = 0;
         }
+    } while (!session->should_quit && !session->tls_pending && g_server_running &&
+             net_receive_pending(session->control_socket) > 0);
+
+    // TLS handshakes and reads block, so after AUTH TLS the session leaves the loops (see event_client_closed)
+    if (session->should_quit || session->tls_pending || !g_server_running)
+        return -1;
 
-        // Increment command counter
-        session->commands_received++;
+    return 0;
+}
 
-        // Special logging for urgent commands
-        if (has_urgent > 0)
+/**
+ * @brief Unlinks an event client from the active list
+ */
+static void event_client_unlink(event_client_t *client)
+{
+    pthread_mutex_lock(&g_event_clients_mutex);
+    if (client->prev)
+        client->prev->next = client->next;
+    else
+        g_event_clients = client->next;
+    if (client->next)
+        client->next->prev = client->prev;
+    client->prev = client->next = NULL;
+    pthread_mutex_unlock(&g_event_clients_mutex);
+}
+
+/**
+ * @brief Releases an event client and its session
+ */
+static void event_client_free(event_client_t *client)
+{
+    LOG_INFO("Client session ended for %s:%u", client->session->client_ip, client->session->client_port);
+
+    session_destroy(client->session);
+    free(client);
+
+    // Decrement connection count
+    server_connection_release();
+}
+
+/**
+ * @brief Reactor close callback
+ *
+ * @param user_data Pointer to event_client_t
+ */
+static void event_client_closed(void *user_data)
+{
+    event_client_t *client = (event_client_t *)user_data;
+    event_client_unlink(client);
+
+    // A session that accepted AUTH TLS continues on a thread of its own, which runs the handshake
+    session_t *session = client->session;
+    if (session->tls_pending && !session->should_quit && g_server_running)
+    {
+        free(client);
+        if (client_thread_start(session, secured_client_thread) != 0)
         {
-            LOG_INFO("Client %s:%u: [URGENT] %s %s",
-                     session->client_ip, session->client_port,
-                     cmd.command, cmd.has_argument ? cmd.argument : "");
+            LOG_INFO("Client session ended for %s:%u", session->client_ip, session->client_port);
+            session_destroy(session);
+            server_connection_release();
         }
-        else
+        return;
+    }
+
+    event_client_free(client);
+}
+
+/**
+ * @brief Hands a new session to the event loops
+ *
+ * @param session Newly created session
+ * @return 0 on success, -1 on error (session is left to the caller)
+ */
+static int event_client_start(session_t *session)
+{
+    if (session_greet(session) != 0)
+        return -1;
+
+    event_client_t *client = (event_client_t *)calloc(1, sizeof(event_client_t));
+    if (!client)
+    {
+        LOG_ERROR("Failed to allocate event client for %s:%u", session->client_ip, session->client_port);
+        return -1;
+    }
+    client->session = session;
+
+    pthread_mutex_lock(&g_event_clients_mutex);
+    client->next = g_event_clients;
+    if (g_event_clients)
+        g_event_clients->prev = client;
+    g_event_clients = client;
+    pthread_mutex_unlock(&g_event_clients_mutex);
+
+    // From here on a loop thread may process and close the client at any time
+    if (reactor_add(session->control_socket, client) != 0)
+    {
+        event_client_unlink(client);
+        free(client);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Takes over an accepted control connection
+ *
+ * Counts it against max_connections, creates its session and hands it to
+ * the event loops or a client thread. Called by every acceptor.
+ *
+ * @param client_socket The accepted connection
+ * @param client_ip Client address
+ * @param client_port Client port
+ */
+static void server_handle_connection(socket_t client_socket, const char *client_ip, uint16_t client_port)
+{
+    LOG_INFO("Accepted connection from %s:%u", client_ip, client_port);
+
+    // Replies are small writes; Nagle would hold each back until the previous one is acknowledged
+    net_set_tcp_nodelay(client_socket, 1);
+
+    // If server is busy (connection limit exceeded), send busy response and close connection
+    if (server_connection_reserve() != 0)
+    {
+        LOG_WARN("Server busy, rejecting connection from %s:%u (max connections: %d)",
+                 client_ip, client_port, g_config.max_connections);
+
+        // Send busy response (421 Service not available)
+        // Session has not been established yet,
+        // use raw proto_format_response() to generate message.
+        char busy_response[PROTO_MAX_RESPONSE_LINE];
+        proto_format_response(busy_response, sizeof(busy_response), PROTO_RESP_SERVICE_NOT_AVAIL, "Service not available, too many connections");
+        net_send_all(client_socket, busy_response, strlen(busy_response));
+
+        // Close connection
+        net_close_socket(client_socket);
+        return;
+    }
+
+    // Create session for this client
+    session_t *session = session_create(client_socket, client_ip,
+                                        client_port, g_config.root_dir,
+                                        g_config.bind_address);
+    if (!session)
+    {
+        LOG_ERROR("Failed to create session for client %s:%u", client_ip, client_port);
+        net_close_socket(client_socket);
+
+        // Decrement connection count on session creation failure
+        server_connection_release();
+        return;
+    }
+    session->compression_level = g_config.compression_level;
+
+    // The timer wheel runs from server_init() to server_cleanup()
+    session_set_timeouts(session, g_config.command_timeout_ms, g_config.data_timeout_ms);
+
+    // Event engine: register with the event loops instead of spawning a thread
+    if (g_event_engine_active)
+    {
+        if (event_client_start(session) != 0)
         {
-            LOG_INFO("Client %s:%u: %s %s",
-                     session->client_ip, session->client_port,
-                     cmd.command, cmd.has_argument ? cmd.argument : "");
+            LOG_ERROR("Failed to start event client for %s:%u", client_ip, client_port);
+            session_destroy(session);
+
+            // Decrement connection count on session creation failure
+            server_connection_release();
         }
+        return;
+    }
+
+    // Create thread to handle this client
+    if (client_thread_start(session, client_thread) != 0)
+    {
+        session_destroy(session);
 
-        // Dispatch command to handler
-        // ABOR will be dispatched through the normal command handler mechanism
-        if (cmd_dispatch((cmd_handler_context_t)session, &cmd) != 0)
+        // Decrement connection count on session creation failure
+        server_connection_release();
+    }
+}
+
+/**
+ * @brief Accepts connections until the server stops
+ *
+ * @param listening_socket Socket to accept on
+ * @param polling 0 to block in accept() (the socket is closed to stop), 1 for a
+ *        non-blocking socket, possibly shared with other acceptors, that is
+ *        polled so the loop notices shutdown by itself
+ */
+static void server_accept_loop(socket_t listening_socket, int polling)
+{
+    while (g_server_running)
+    {
+        if (polling)
         {
-            // Command not recognized or handler failed
-            if (!cmd_is_registered(cmd.command))
+            int ready = net_wait_readable(listening_socket, ACCEPTOR_POLL_MS);
+            if (ready < 0 && g_server_running)
             {
-                LOG_WARN("Unknown command: %s", cmd.command);
-                session_send_response(session, PROTO_RESP_COMMAND_NOT_IMPL, "Command not implemented");
+                LOG_ERROR("Failed to wait for client connections");
+                sleep_ms(ACCEPTOR_POLL_MS);
             }
-            else
+            if (ready <= 0)
+                continue;
+        }
+
+        char client_ip[64];
+        uint16_t client_port;
+
+        // Accept incoming connection
+        socket_t client_socket = net_accept(listening_socket,
+                                            client_ip, sizeof(client_ip),
+                                            &client_port);
+
+        if (client_socket == INVALID_SOCKET_T)
+        {
+            // Another acceptor of a shared socket may have taken the connection
+            if (g_server_running && !(polling && net_is_would_block(net_get_last_error())))
             {
-                LOG_WARN("Command handler failed: %s", cmd.command);
-                // Handler sends appropriate error response
+                LOG_ERROR("Failed to accept client connection");
             }
+            continue;
         }
-        LOG_DEBUG("Finished processing command: %s", cmd.command);
+
+        // BSD and Windows pass the listening socket's non-blocking mode on to accepted sockets
+        if (polling)
+            net_set_nonblocking(client_socket, 0);
+
+        server_handle_connection(client_socket, client_ip, client_port);
     }
+}
 
-    LOG_INFO("Client session ended for %s:%u", session->client_ip, session->client_port);
+/**
+ * @brief Pins the calling acceptor thread to a CPU
+ *
+ * @param index Acceptor index, CPUs are assigned round-robin
+ * @return 0 on success, -1 if pinning failed or is not supported
+ */
+static int acceptor_pin_cpu(int index)
+{
+#if defined(__linux__)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 0)
+        return -1;
 
-    // Clean up session
-    session_destroy(session);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((int)(index % cpus), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    DWORD cpus = info.dwNumberOfProcessors;
+    if (cpus == 0)
+        return -1;
+    if (cpus > sizeof(DWORD_PTR) * 8)
+        cpus = sizeof(DWORD_PTR) * 8;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (index % cpus)) != 0 ? 0 : -1;
+#else
+    (void)index;
+    return -1;
+#endif
+}
 
-    // Decrement connection count
-    pthread_mutex_lock(&g_connection_mutex);
-    g_current_connections--;
-    pthread_mutex_unlock(&g_connection_mutex);
+/**
+ * @brief Acceptor thread entry point
+ *
+ * @param arg Pointer to acceptor_t
+ * @return NULL
+ */
+static void *acceptor_thread(void *arg)
+{
+    acceptor_t *acceptor = (acceptor_t *)arg;
+
+    if (g_config.acceptor_pinning && acceptor_pin_cpu(acceptor->index) != 0)
+    {
+        LOG_WARN("Could not pin acceptor %d to a CPU", acceptor->index);
+    }
 
+    server_accept_loop(acceptor->sock, 1);
     return NULL;
 }
 
+/**
+ * @brief Sets up the acceptor sockets after g_listening_socket was created
+ *
+ * Each acceptor gets its own socket in the SO_REUSEPORT group of
+ * g_listening_socket; if the group cannot be formed, all share it.
+ */
+static void server_acceptors_open(void)
+{
+    int count = g_config.acceptor_threads;
+    if (count <= 1)
+    {
+        g_acceptor_count = 0;
+        return;
+    }
+    if (count > SERVER_MAX_ACCEPTORS)
+        count = SERVER_MAX_ACCEPTORS;
+
+    int own_sockets = net_reuseport_supported();
+    g_acceptors[0].sock = g_listening_socket;
+    for (int i = 1; i < count && own_sockets; i++)
+    {
+        g_acceptors[i].sock = net_create_listening_socket_reuseport(g_config.address_family, g_config.bind_address,
+                                                                    g_config.port, g_config.max_backlog);
+        if (g_acceptors[i].sock == INVALID_SOCKET_T)
+        {
+            LOG_WARN("Failed to create listening socket for acceptor %d, acceptors share one socket", i);
+            for (int j = 1; j < i; j++)
+                net_close_socket(g_acceptors[j].sock);
+            own_sockets = 0;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        g_acceptors[i].index = i;
+        if (!own_sockets)
+            g_acceptors[i].sock = g_listening_socket;
+        net_set_nonblocking(g_acceptors[i].sock, 1);
+    }
+    g_acceptor_count = count;
+
+    LOG_INFO("Acceptors: %d threads, %s%s", count, own_sockets ? "one SO_REUSEPORT socket each" : "sharing one socket",
+             g_config.acceptor_pinning ? ", pinned to CPUs" : "");
+}
+
+/**
+ * @brief Closes the acceptor sockets other than g_listening_socket
+ */
+static void server_acceptors_close(void)
+{
+    for (int i = 0; i < g_acceptor_count; i++)
+    {
+        if (g_acceptors[i].sock != g_listening_socket && g_acceptors[i].sock != INVALID_SOCKET_T)
+            net_close_socket(g_acceptors[i].sock);
+        g_acceptors[i].sock = INVALID_SOCKET_T;
+    }
+    g_acceptor_count = 0;
+}
+
+/**
+ * @brief Gets the transfer worker limit for the current configuration
+ *
+ * Each session runs at most one transfer at a time, so by default the pool
+ * is allowed one worker per permitted connection.
+ *
+ * @return Maximum number of transfer workers
+ */
+static int server_transfer_worker_limit(void)
+{
+    if (g_config.transfer_workers > 0)
+        return g_config.transfer_workers;
+    if (g_config.max_connections > 0)
+        return g_config.max_connections;
+    return DEFAULT_TRANSFER_WORKERS;
+}
+
 int server_init(const server_config_t *config)
 {
     if (!config)
@@ -185,8 +765,41 @@ int server_init(const server_config_t *config)
     LOG_INFO("Root directory: %s", g_config.root_dir);
     LOG_INFO("Max backlog: %d", g_config.max_backlog);
     LOG_INFO("Command timeout: %d ms", g_config.command_timeout_ms);
+    LOG_INFO("Data stall timeout: %d ms", g_config.data_timeout_ms);
     LOG_INFO("Max connections: %d", g_config.max_connections);
     LOG_INFO("Address family: %d", g_config.address_family);
+    LOG_INFO("Engine: %s", g_config.engine == SERVER_ENGINE_EVENT ? "event" : "threaded");
+    LOG_INFO("Transfer workers: %d", server_transfer_worker_limit());
+    LOG_INFO("Listing cache TTL: %d s", g_config.listing_cache_ttl);
+    LOG_INFO("File cache: %zu bytes", g_config.hot_cache_bytes);
+    LOG_INFO("Passive ports: %u-%u (%d pre-bound)", g_config.pasv_port_min, g_config.pasv_port_max,
+             g_config.pasv_prebind);
+    LOG_INFO("MODE Z: %s (level %d)", datacomp_is_available() ? "available" : "not built", g_config.compression_level);
+    LOG_INFO("TLS: %s", g_config.tls_cert_file[0] == '\0' ? "off"
+                        : g_config.tls_required      ? "required"
+                                                     : "optional");
+    LOG_INFO("Transfer pipeline: %d buffers", g_config.pipeline_depth);
+    LOG_INFO("Upload durability: %s%s",
+             g_config.upload_durability == TRANSFER_DURABILITY_NONE       ? "none"
+             : g_config.upload_durability == TRANSFER_DURABILITY_PERIODIC ? "periodic"
+                                                                          : "close",
+             g_config.atomic_uploads ? ", atomic replace" : "");
+
+    if (transfer_set_pipeline_depth(g_config.pipeline_depth) != 0)
+    {
+        LOG_WARN("Using the default transfer pipeline depth");
+    }
+    transfer_set_durability((transfer_durability_t)g_config.upload_durability);
+
+    if (g_config.global_rate_limit > 0 || g_config.session_rate_limit > 0)
+    {
+        LOG_INFO("Bandwidth limits: %llu bytes/s global, %llu bytes/s per session (0 is unlimited)",
+                 g_config.global_rate_limit, g_config.session_rate_limit);
+    }
+    if (ratelimit_init(g_config.global_rate_limit, g_config.session_rate_limit) != 0)
+    {
+        LOG_WARN("Invalid bandwidth limits, transfers run unlimited");
+    }
 
     // Verify root directory exists
     if (!fs_is_directory(g_config.root_dir))
@@ -245,136 +858,188 @@ int server_init(const server_config_t *config)
     LOG_INFO("Registered %d command handlers", cmd_get_handler_count());
     LOG_DEBUG("All registered commands:\n%s", cmd_get_all_registered_commands());
 
-    // Create listening socket
-    g_listening_socket = net_create_listening_socket(g_config.address_family,
-                                                     g_config.bind_address,
-                                                     g_config.port,
-                                                     g_config.max_backlog);
+    // A configured certificate that cannot be used is fatal, clients expecting TLS must not fall back to plain text
+    if (g_config.tls_cert_file[0] != '\0' && tlssock_init(g_config.tls_cert_file, g_config.tls_key_file) != 0)
+    {
+        LOG_ERROR("Failed to enable TLS");
+        cmd_cleanup();
+        auth_cleanup();
+        net_cleanup();
+        return -1;
+    }
+
+    // Create listening socket, the first of the SO_REUSEPORT group when there are several acceptors
+    if (g_config.acceptor_threads > 1 && net_reuseport_supported())
+    {
+        g_listening_socket = net_create_listening_socket_reuseport(g_config.address_family,
+                                                                   g_config.bind_address,
+                                                                   g_config.port,
+                                                                   g_config.max_backlog);
+    }
+    else
+    {
+        g_listening_socket = net_create_listening_socket(g_config.address_family,
+                                                         g_config.bind_address,
+                                                         g_config.port,
+                                                         g_config.max_backlog);
+    }
     if (g_listening_socket == INVALID_SOCKET_T)
     {
         LOG_ERROR("Failed to create listening socket on port %u", g_config.port);
+        tlssock_cleanup();
         cmd_cleanup();
         auth_cleanup();
         net_cleanup();
         return -1;
     }
 
-    LOG_INFO("Server initialized successfully");
-    g_server_running = 1;
+    // Optional LIST cache, failure only costs performance
+    if (listcache_init(g_config.listing_cache_ttl, LISTCACHE_DEFAULT_ENTRIES) != 0)
+    {
+        LOG_WARN("Listing cache disabled");
+    }
 
-    return 0;
-}
+    session_memory_stats_t memory;
+    session_get_memory_stats(&memory);
+    LOG_INFO("Session footprint: %zu bytes per idle session", memory.idle_bytes);
 
-int server_run(void)
-{
-    if (!g_server_running)
+    // Checksum cache for HASH and the X* commands, also optional
+    if (digestcache_init(DIGESTCACHE_DEFAULT_ENTRIES) != 0)
     {
-        LOG_ERROR("Server not initialized");
-        return -1;
+        LOG_WARN("Checksum cache disabled");
     }
 
-    LOG_INFO("Server listening on port %u", g_config.port);
-    LOG_INFO("Waiting for connections...");
+    // Memory cache for small downloads, also optional
+    if (hotcache_init(g_config.hot_cache_bytes, HOTCACHE_DEFAULT_MAX_FILE) != 0)
+    {
+        LOG_WARN("File cache disabled");
+    }
 
-    // Main accept loop
-    while (g_server_running)
+    // Without the allocator PASV falls back to probing the range with bind()
+    if (pasv_port_init(g_config.pasv_port_min, g_config.pasv_port_max, g_config.bind_address,
+                       g_config.pasv_prebind) != 0)
     {
-        char client_ip[64];
-        uint16_t client_port;
+        LOG_WARN("Passive port allocator disabled");
+    }
 
-        // Accept incoming connection
-        socket_t client_socket = net_accept(g_listening_socket,
-                                            client_ip, sizeof(client_ip),
-                                            &client_port);
+    // Idle, accept and stall deadlines of every connection
+    if (timerwheel_init(TIMERWHEEL_DEFAULT_TICK_MS) != 0)
+    {
+        LOG_ERROR("Failed to start timer wheel");
+        pasv_port_cleanup();
+        net_close_socket(g_listening_socket);
+        g_listening_socket = INVALID_SOCKET_T;
+        tlssock_cleanup();
+        cmd_cleanup();
+        auth_cleanup();
+        net_cleanup();
+        return -1;
+    }
 
-        if (client_socket == INVALID_SOCKET_T)
+    // Start transfer workers
+    if (threadpool_init(server_transfer_worker_limit()) != 0)
+    {
+        LOG_ERROR("Failed to start transfer worker pool");
+        timerwheel_shutdown();
+        pasv_port_cleanup();
+        net_close_socket(g_listening_socket);
+        g_listening_socket = INVALID_SOCKET_T;
+        tlssock_cleanup();
+        cmd_cleanup();
+        auth_cleanup();
+        net_cleanup();
+        return -1;
+    }
+
+    // Start event loops for the event engine
+    if (g_config.engine == SERVER_ENGINE_EVENT)
+    {
+        if (!reactor_is_supported())
         {
-            if (g_server_running)
-            {
-                LOG_ERROR("Failed to accept client connection");
-            }
-            continue;
+            LOG_WARN("Event engine is not supported on this platform, falling back to threaded engine");
+            g_config.engine = SERVER_ENGINE_THREADED;
         }
-
-        LOG_INFO("Accepted connection from %s:%u", client_ip, client_port);
-
-        // Check if server is busy (connection limit exceeded)
-        int is_busy = 0;
-        if (g_config.max_connections > 0)
+        else if (reactor_init(g_config.event_threads, event_client_readable, event_client_closed, NULL, 0) != 0)
         {
-            pthread_mutex_lock(&g_connection_mutex);
-            if (g_current_connections >= g_config.max_connections)
-            {
-                is_busy = 1;
-            }
-            else
-            {
-                g_current_connections++;
-            }
-            pthread_mutex_unlock(&g_connection_mutex);
+            LOG_ERROR("Failed to start event engine");
+            threadpool_shutdown();
+            timerwheel_shutdown();
+            pasv_port_cleanup();
+            net_close_socket(g_listening_socket);
+            g_listening_socket = INVALID_SOCKET_T;
+            tlssock_cleanup();
+            cmd_cleanup();
+            auth_cleanup();
+            net_cleanup();
+            return -1;
         }
         else
         {
-            // No limit, just increment connection count
-            pthread_mutex_lock(&g_connection_mutex);
-            g_current_connections++;
-            pthread_mutex_unlock(&g_connection_mutex);
+            g_event_engine_active = 1;
         }
+    }
 
-        // If server is busy, send busy response and close connection
-        if (is_busy)
-        {
-            LOG_WARN("Server busy, rejecting connection from %s:%u (max connections: %d)",
-                     client_ip, client_port, g_config.max_connections);
-
-            // Send busy response (421 Service not available)
-            // Session has not been established yet,
-            // use raw proto_format_response() to generate message.
-            char busy_response[PROTO_MAX_RESPONSE_LINE];
-            proto_format_response(busy_response, sizeof(busy_response), PROTO_RESP_SERVICE_NOT_AVAIL, "Service not available, too many connections");
-            net_send_all(client_socket, busy_response, strlen(busy_response));
-
-            // Close connection
-            net_close_socket(client_socket);
-            continue;
-        }
+    server_acceptors_open();
 
-        // Create session for this client
-        session_t *session = session_create(client_socket, client_ip,
-                                            client_port, g_config.root_dir,
-                                            g_config.bind_address);
-        if (!session)
-        {
-            LOG_ERROR("Failed to create session for client %s:%u", client_ip, client_port);
-            net_close_socket(client_socket);
+    // Optional metrics endpoint, STAT and SITE METRICS work without it
+    if (g_config.metrics_port > 0 &&
+        metrics_http_start(g_config.address_family, g_config.bind_address, g_config.metrics_port) != 0)
+    {
+        LOG_WARN("Metrics endpoint disabled");
+    }
 
-            // Decrement connection count on session creation failure
-            pthread_mutex_lock(&g_connection_mutex);
-            g_current_connections--;
-            pthread_mutex_unlock(&g_connection_mutex);
+    LOG_INFO("Server initialized successfully");
+    g_server_running = 1;
 
-            continue;
-        }
+    return 0;
+}
 
-        // Create thread to handle this client
-        pthread_t thread_id;
-        if (pthread_create(&thread_id, NULL, client_thread, session) != 0)
-        {
-            LOG_ERROR("Failed to create thread for client %s:%u", client_ip, client_port);
-            session_destroy(session);
+int server_run(void)
+{
+    if (!g_server_running)
+    {
+        LOG_ERROR("Server not initialized");
+        return -1;
+    }
 
-            // Decrement connection count on session creation failure
-            pthread_mutex_lock(&g_connection_mutex);
-            g_current_connections--;
-            pthread_mutex_unlock(&g_connection_mutex);
+    LOG_INFO("Server listening on port %u", g_config.port);
+    LOG_INFO("Waiting for connections...");
 
-            continue;
+    if (g_acceptor_count == 0)
+    {
+        // Main accept loop
+        server_accept_loop(g_listening_socket, 0);
+        LOG_INFO("Server stopped accepting connections");
+        return 0;
+    }
+
+    // Acceptor threads; they poll their sockets and exit once g_server_running is cleared
+    for (int i = 0; i < g_acceptor_count; i++)
+    {
+        g_acceptors[i].started = pthread_create(&g_acceptors[i].thread, NULL, acceptor_thread, &g_acceptors[i]) == 0;
+        if (!g_acceptors[i].started)
+        {
+            LOG_ERROR("Failed to create acceptor thread %d", i);
+
+            // Leave the SO_REUSEPORT group so the kernel stops handing this socket connections
+            if (g_acceptors[i].sock != g_listening_socket)
+            {
+                net_close_socket(g_acceptors[i].sock);
+                g_acceptors[i].sock = INVALID_SOCKET_T;
+            }
         }
+    }
 
-        // Detach thread so it cleans up automatically when done
-        pthread_detach(thread_id);
+    // The first acceptor serves g_listening_socket; the main thread stands in for it
+    if (!g_acceptors[0].started)
+    {
+        server_accept_loop(g_listening_socket, 1);
+    }
 
-        LOG_DEBUG("Created thread for client %s:%u", client_ip, client_port);
+    for (int i = 0; i < g_acceptor_count; i++)
+    {
+        if (g_acceptors[i].started)
+            pthread_join(g_acceptors[i].thread, NULL);
     }
 
     LOG_INFO("Server stopped accepting connections");
@@ -387,8 +1052,8 @@ void server_stop(void)
     LOG_INFO("Stopping server...");
     g_server_running = 0;
 
-    // Close listening socket to unblock accept()
-    if (g_listening_socket != INVALID_SOCKET_T)
+    // Close listening socket to unblock accept(); acceptor threads notice the flag instead
+    if (g_acceptor_count == 0 && g_listening_socket != INVALID_SOCKET_T)
     {
         net_close_socket(g_listening_socket);
         g_listening_socket = INVALID_SOCKET_T;
@@ -399,6 +1064,39 @@ void server_cleanup(void)
 {
     LOG_INFO("Cleaning up server resources...");
 
+    metrics_http_stop();
+
+    // Stop event loops, then release sessions they still owned
+    if (g_event_engine_active)
+    {
+        reactor_shutdown();
+        g_event_engine_active = 0;
+
+        pthread_mutex_lock(&g_event_clients_mutex);
+        event_client_t *client = g_event_clients;
+        g_event_clients = NULL;
+        pthread_mutex_unlock(&g_event_clients_mutex);
+
+        while (client)
+        {
+            event_client_t *next = client->next;
+            event_client_free(client);
+            client = next;
+        }
+    }
+
+    // Sessions destroyed above have already waited for their transfer jobs
+    threadpool_shutdown();
+    timerwheel_shutdown();
+    listcache_cleanup();
+    digestcache_cleanup();
+    hotcache_cleanup();
+    tlssock_cleanup();
+    session_pool_cleanup();
+    pasv_port_cleanup();
+    ratelimit_cleanup();
+
+    server_acceptors_close();
     if (g_listening_socket != INVALID_SOCKET_T)
     {
         net_close_socket(g_listening_socket);
@@ -412,13 +1110,16 @@ void server_cleanup(void)
     g_server_running = 0;
 
     // Reset connection count
-    pthread_mutex_lock(&g_connection_mutex);
-    g_current_connections = 0;
-    pthread_mutex_unlock(&g_connection_mutex);
+    ATOMIC_STORE_RELAXED(&g_current_connections, 0);
 
     LOG_INFO("Server cleanup completed");
 }
 
+const server_config_t *server_get_config(void)
+{
+    return &g_config;
+}
+
 int server_is_running(void)
 {
     return g_server_running;
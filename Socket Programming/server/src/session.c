@@ -10,16 +10,74 @@
 #include "filesys.h"
 #include "utils.h"
 #include "transfer.h"
+#include "pasvport.h"
+#include "datacomp.h"
+#include "metrics.h"
+#include "mlsx.h"
+#include "objpool.h"
+#include "strintern.h"
+#include "timerwheel.h"
+#include "tlssock.h"
+#include "atomics.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 #include <errno.h>
 
+// Objects per slab of the session and transfer parameter pools
+#define SESSION_POOL_SLAB 64
+#define SESSION_TRANSFER_POOL_SLAB 16
+
+static objpool_t g_session_pool = OBJPOOL_INITIALIZER(sizeof(session_t), SESSION_POOL_SLAB);
+static objpool_t g_transfer_pool = OBJPOOL_INITIALIZER(sizeof(transfer_params_t), SESSION_TRANSFER_POOL_SLAB);
+
 // Forward declaration of helper functions
+static void session_close_listen_socket(session_t *session);
+static int session_idle_expired(void *arg);
+static int session_accept_expired(void *arg);
+static int session_stall_check(void *arg);
 static int normalize_and_validate_path(const char *base, const char *path,
                                        char *result, size_t result_size);
 
+/**
+ * @brief Points a shared string field at a new value, releasing the old one.
+ *
+ * @param field The field
+ * @param value The new value
+ * @return 0 on success, -1 if memory ran out (the field keeps its value)
+ */
+static int session_replace_string(const char **field, const char *value)
+{
+    const char *shared = strintern_acquire(value);
+    if (!shared)
+    {
+        return -1;
+    }
+
+    strintern_release(*field);
+    *field = shared;
+    return 0;
+}
+
+/**
+ * @brief Frees what a session allocated and returns it to the pool.
+ *
+ * @param session Pointer to session
+ */
+static void session_free(session_t *session)
+{
+    strintern_release(session->bind_address);
+    strintern_release(session->username);
+    strintern_release(session->root_dir);
+    strintern_release(session->current_dir);
+    strintern_release(session->user_home_dir);
+    free(session->rename_from);
+    objpool_free(&g_transfer_pool, session->transfer_params);
+    net_line_buffer_free(&session->control_buffer);
+    objpool_free(&g_session_pool, session);
+}
+
 session_t *session_create(socket_t control_socket,
                           const char *client_ip,
                           uint16_t client_port,
@@ -32,7 +90,7 @@ session_t *session_create(socket_t control_socket,
         return NULL;
     }
 
-    session_t *session = (session_t *)malloc(sizeof(session_t));
+    session_t *session = (session_t *)objpool_alloc(&g_session_pool);
     if (!session)
     {
         LOG_ERROR("Failed to allocate memory for session");
@@ -47,56 +105,67 @@ session_t *session_create(socket_t control_socket,
     strncpy(session->client_ip, client_ip, sizeof(session->client_ip) - 1);
     session->client_ip[sizeof(session->client_ip) - 1] = '\0';
     session->client_port = client_port;
-    if (bind_address)
-    {
-        strncpy(session->bind_address, bind_address, sizeof(session->bind_address) - 1);
-        session->bind_address[sizeof(session->bind_address) - 1] = '\0';
-    }
-    else
-    {
-        strcpy(session->bind_address, "127.0.0.1"); // Default fallback
-    }
+    session->bind_address = strintern_acquire(bind_address ? bind_address : "127.0.0.1"); // Default fallback
+
+    net_line_buffer_init(&session->control_buffer);
+    session->control_protected = 0;
+    session->tls_pending = 0;
+    session->pbsz_set = 0;
+    session->data_protected = 0;
 
     // Set initial state
     session->state = SESSION_STATE_CONNECTED;
     session->authenticated = 0;
     session->permissions = AUTH_PERM_NONE;
 
+    session->username = strintern_acquire("");
+
     // Set directory information
-    strncpy(session->root_dir, root_dir, sizeof(session->root_dir) - 1);
-    session->root_dir[sizeof(session->root_dir) - 1] = '\0';
+    session->root_dir = strintern_acquire(root_dir);
+    session->current_dir = strintern_acquire("/");    // Start at root
+    session->user_home_dir = strintern_acquire(""); // No home dir yet
+    if (!session->bind_address || !session->root_dir || !session->current_dir)
+    {
+        LOG_ERROR("Failed to allocate session strings");
+        session_free(session);
+        return NULL;
+    }
+
     if (!fs_is_directory(session->root_dir))
     {
         LOG_ERROR("Root directory does not exist or is not a directory: %s", root_dir);
-        free(session);
+        session_free(session);
         return NULL;
     }
 
-    strcpy(session->current_dir, "/");                                 // Start at root
-    memset(session->user_home_dir, 0, sizeof(session->user_home_dir)); // No home dir yet
-
     // Set default transfer parameters
     session->transfer_type = PROTO_TYPE_BINARY; // Change as HOMEWORK REQUIRES
     session->transfer_mode = PROTO_MODE_STREAM;
+    session->compression_level = DATACOMP_DEFAULT_LEVEL;
+    session->mlst_facts = MLSX_DEFAULT_FACTS;
+    session->hash_algorithm = DIGEST_SHA256;
     session->data_structure = PROTO_STRU_FILE;
 
     // Initialize data connection state
     session->data_mode = SESSION_DATA_MODE_NONE;
     session->data_socket = INVALID_SOCKET_T;
     session->data_listen_socket = INVALID_SOCKET_T;
+    session->passive_port_leased = 0;
 
     // Initialize command state
     session->restart_offset = 0;
+    session->restart_end = -1;
+    session->allocation_size = 0;
     session->rename_pending = 0;
 
     // Initialize transfer state
     session->transfer_should_abort = 0;
     session->transfer_in_progress = 0;
+    session->limiter = ratelimit_session_create(); // Transfers run unpaced without it
 
-    // Initialize async transfer thread state
-    session->transfer_thread = 0;
+    // Initialize async transfer state
+    session->transfer_job_active = 0;
     session->transfer_thread_state = TRANSFER_THREAD_IDLE;
-    session->transfer_params = NULL;
     session->transfer_result = TRANSFER_STATUS_OK;
 
     // Initialize timestamps
@@ -111,9 +180,16 @@ session_t *session_create(socket_t control_socket,
     session->files_downloaded = 0;
     session->commands_received = 0;
 
+    // Deadlines stay off until session_set_timeouts()
+    timerwheel_timer_init(&session->idle_timer, session_idle_expired, session);
+    timerwheel_timer_init(&session->accept_timer, session_accept_expired, session);
+    timerwheel_timer_init(&session->stall_timer, session_stall_check, session);
+
     // Initialize mutex
     pthread_mutex_init(&session->lock, NULL);
+    pthread_cond_init(&session->transfer_job_done, NULL);
 
+    metrics_record_session(1);
     LOG_INFO("Session created for client %s:%u", client_ip, client_port);
 
     return session;
@@ -129,25 +205,29 @@ void session_destroy(session_t *session)
     LOG_INFO("Destroying session for client %s:%u",
              session->client_ip, session->client_port);
 
+    // No deadline may fire on the sockets closed below
+    timerwheel_cancel(&session->idle_timer);
+    timerwheel_cancel(&session->accept_timer);
+
     // Set quit flag so transfer thread won't send responses
     session->should_quit = 1;
 
     // Close data connections, this will cause transfer thread to exit with Connection error
     session_close_data_connection(session);
 
-    // Wait for transfer thread to complete before freeing session
-    // This prevents use-after-free when transfer thread accesses session
-    if (session->transfer_thread != 0)
+    // Wait for the transfer job to finish before freeing session
+    // This prevents use-after-free when the transfer worker accesses session
+    pthread_mutex_lock(&session->lock);
+    if (session->transfer_job_active)
     {
-        transfer_thread_state_t state = session_get_transfer_thread_state(session);
-        if (state != TRANSFER_THREAD_IDLE)
+        LOG_DEBUG("Waiting for transfer job to complete before destroying session...");
+        while (session->transfer_job_active)
         {
-            LOG_DEBUG("Waiting for transfer thread to complete before destroying session...");
+            pthread_cond_wait(&session->transfer_job_done, &session->lock);
         }
-        pthread_join(session->transfer_thread, NULL);
-        session->transfer_thread = 0;
-        LOG_DEBUG("Transfer thread joined successfully.");
+        LOG_DEBUG("Transfer job completed.");
     }
+    pthread_mutex_unlock(&session->lock);
 
     // Close control socket
     if (session->control_socket != INVALID_SOCKET_T)
@@ -156,11 +236,43 @@ void session_destroy(session_t *session)
         session->control_socket = INVALID_SOCKET_T;
     }
 
+    ratelimit_session_destroy(session->limiter);
+    metrics_record_session(0);
+
     // Destroy mutex
+    pthread_cond_destroy(&session->transfer_job_done);
     pthread_mutex_destroy(&session->lock);
 
     // Free memory
-    free(session);
+    session_free(session);
+}
+
+void session_get_memory_stats(session_memory_stats_t *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    objpool_stats_t sessions;
+    objpool_stats_t transfers;
+    strintern_stats_t strings;
+    objpool_get_stats(&g_session_pool, &sessions);
+    objpool_get_stats(&g_transfer_pool, &transfers);
+    strintern_get_stats(&strings);
+
+    // The line buffer and the rename and transfer state are only allocated while in use
+    stats->idle_bytes = sessions.object_size + ratelimit_session_size();
+    stats->sessions_in_use = sessions.in_use;
+    stats->sessions_pooled = sessions.allocated;
+    stats->transfers_in_use = transfers.in_use;
+    stats->shared_bytes = strings.bytes;
+}
+
+void session_pool_cleanup(void)
+{
+    objpool_destroy(&g_session_pool);
+    objpool_destroy(&g_transfer_pool);
 }
 
 int session_set_user(session_t *session, const char *username)
@@ -172,8 +284,12 @@ int session_set_user(session_t *session, const char *username)
 
     pthread_mutex_lock(&session->lock);
 
-    strncpy(session->username, username, sizeof(session->username) - 1);
-    session->username[sizeof(session->username) - 1] = '\0';
+    if (session_replace_string(&session->username, username) != 0)
+    {
+        pthread_mutex_unlock(&session->lock);
+        LOG_ERROR("Failed to store username for session %s:%u", session->client_ip, session->client_port);
+        return -1;
+    }
     session->state = SESSION_STATE_WAIT_PASSWORD;
 
     pthread_mutex_unlock(&session->lock);
@@ -213,9 +329,16 @@ int session_authenticate(session_t *session, const char *password)
     }
 
     // Set user permissions and home directory
+    if (session_replace_string(&session->user_home_dir, user->home_dir) != 0)
+    {
+        pthread_mutex_unlock(&session->lock);
+        auth_user_release(user);
+        LOG_ERROR("Failed to store home directory for '%s'", session->username);
+        return -1;
+    }
     session->permissions = user->permissions;
-    strncpy(session->user_home_dir, user->home_dir, sizeof(session->user_home_dir) - 1);
-    session->user_home_dir[sizeof(session->user_home_dir) - 1] = '\0';
+    ratelimit_session_set_user(session->limiter, user->username, user->rate_limit);
+    auth_user_release(user);
 
     // Mark as authenticated
     session->authenticated = 1;
@@ -241,9 +364,10 @@ int session_authenticate(session_t *session, const char *password)
             if (fs_is_directory(absolute_home))
             {
                 // Set current directory to home directory (with leading /)
-                strncpy(session->current_dir, session->user_home_dir, sizeof(session->current_dir) - 1);
-                session->current_dir[sizeof(session->current_dir) - 1] = '\0';
-                LOG_DEBUG("Changed to home directory: %s", session->current_dir);
+                if (session_replace_string(&session->current_dir, session->user_home_dir) == 0)
+                {
+                    LOG_DEBUG("Changed to home directory: %s", session->current_dir);
+                }
             }
             else
             {
@@ -260,6 +384,31 @@ int session_authenticate(session_t *session, const char *password)
     return 0;
 }
 
+void session_reset_user(session_t *session)
+{
+    if (!session)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&session->lock);
+
+    session->authenticated = 0;
+    session->state = SESSION_STATE_CONNECTED;
+    session->permissions = AUTH_PERM_NONE;
+    ratelimit_session_set_user(session->limiter, NULL, 0);
+
+    // "" needs no allocation and "/" is shared with every other session at the root
+    session_replace_string(&session->username, "");
+    session_replace_string(&session->user_home_dir, "");
+    if (session_replace_string(&session->current_dir, "/") != 0)
+    {
+        LOG_WARN("Session %s:%u stays in %s", session->client_ip, session->client_port, session->current_dir);
+    }
+
+    pthread_mutex_unlock(&session->lock);
+}
+
 int session_has_permission(session_t *session, auth_permission_t permission)
 {
     if (!session)
@@ -397,8 +546,12 @@ int session_change_directory(session_t *session, const char *path)
     }
 
     // Update current directory
-    strncpy(session->current_dir, new_path, sizeof(session->current_dir) - 1);
-    session->current_dir[sizeof(session->current_dir) - 1] = '\0';
+    if (session_replace_string(&session->current_dir, new_path) != 0)
+    {
+        pthread_mutex_unlock(&session->lock);
+        LOG_ERROR("Failed to store current directory: %s", new_path);
+        return -1;
+    }
 
     pthread_mutex_unlock(&session->lock);
 
@@ -461,6 +614,63 @@ int session_resolve_path(session_t *session,
     return 0;
 }
 
+int session_get_virtual_path(session_t *session, const char *relative_path,
+                             char *virtual_path, size_t buffer_size)
+{
+    if (!session || !relative_path || !virtual_path || buffer_size == 0)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    int rc = normalize_and_validate_path(session->current_dir, relative_path, virtual_path, buffer_size);
+    pthread_mutex_unlock(&session->lock);
+
+    return rc;
+}
+
+int session_lookup_path(session_t *session, const char *relative_path, session_path_t *resolved)
+{
+    if (!resolved)
+    {
+        return -1;
+    }
+
+    if (session_resolve_path(session, relative_path, resolved->path, sizeof(resolved->path)) != 0)
+    {
+        return -1;
+    }
+
+    session_path_refresh(resolved);
+    return 0;
+}
+
+int session_path_refresh(session_path_t *resolved)
+{
+    resolved->exists = (fs_stat(resolved->path, &resolved->st) == 0);
+    return resolved->exists;
+}
+
+/**
+ * @brief Closes the passive listening socket and returns its port to the allocator.
+ *
+ * Caller must hold session->lock.
+ */
+static void session_close_listen_socket(session_t *session)
+{
+    if (session->data_listen_socket != INVALID_SOCKET_T)
+    {
+        net_close_socket(session->data_listen_socket);
+        session->data_listen_socket = INVALID_SOCKET_T;
+    }
+
+    if (session->passive_port_leased)
+    {
+        session->passive_port_leased = 0;
+        pasv_port_release(session->passive_port);
+    }
+}
+
 int session_set_port(session_t *session, const char *ip, uint16_t port)
 {
     if (!session || !ip)
@@ -477,11 +687,7 @@ int session_set_port(session_t *session, const char *ip, uint16_t port)
         session->data_socket = INVALID_SOCKET_T;
     }
 
-    if (session->data_listen_socket != INVALID_SOCKET_T)
-    {
-        net_close_socket(session->data_listen_socket);
-        session->data_listen_socket = INVALID_SOCKET_T;
-    }
+    session_close_listen_socket(session);
 
     // Store active mode parameters
     strncpy(session->active_ip, ip, sizeof(session->active_ip) - 1);
@@ -515,16 +721,20 @@ int session_set_pasv(session_t *session,
         session->data_socket = INVALID_SOCKET_T;
     }
 
-    if (session->data_listen_socket != INVALID_SOCKET_T)
-    {
-        net_close_socket(session->data_listen_socket);
-        session->data_listen_socket = INVALID_SOCKET_T;
-    }
+    session_close_listen_socket(session);
 
     // Create listening socket on dynamic port
     uint16_t assigned_port = 0;
-    session->data_listen_socket = net_create_listening_socket_range(
-        NET_AF_UNSPEC, session->bind_address, port_min, port_max, 5, &assigned_port); // Larger backlog
+    if (pasv_port_is_enabled())
+    {
+        session->data_listen_socket = pasv_port_acquire(session->bind_address, 5, &assigned_port);
+        session->passive_port_leased = session->data_listen_socket != INVALID_SOCKET_T;
+    }
+    else
+    {
+        session->data_listen_socket = net_create_listening_socket_range(
+            NET_AF_UNSPEC, session->bind_address, port_min, port_max, 5, &assigned_port); // Larger backlog
+    }
 
     if (session->data_listen_socket == INVALID_SOCKET_T)
     {
@@ -551,7 +761,10 @@ int session_set_pasv(session_t *session,
     return 0;
 }
 
-int session_open_data_connection(session_t *session, int timeout_ms)
+/**
+ * @brief Opens the data connection, see session_open_data_connection()
+ */
+static int open_data_connection(session_t *session, int timeout_ms)
 {
     if (!session)
     {
@@ -597,6 +810,14 @@ int session_open_data_connection(session_t *session, int timeout_ms)
         socket_t listen_sock = session->data_listen_socket;
         uint16_t port = session->passive_port;
 
+        // Where the timer wheel can end the wait by shutting the listener down, the wait needs no timeout
+        int deadline = 0;
+        if (timeout_ms >= 0 && net_listener_shutdown_supported())
+        {
+            session->accept_expired = 0;
+            deadline = timerwheel_schedule(&session->accept_timer, timeout_ms) == 0;
+        }
+
         // CRITICAL: Release lock before blocking on select()
         // This allows other threads (e.g., session cleanup) to proceed
         // If the socket is closed while we're in select(), select() will return with error
@@ -607,7 +828,24 @@ int session_open_data_connection(session_t *session, int timeout_ms)
         if (timeout_ms >= 0)
         {
             LOG_DEBUG("Waiting for passive mode connection on port %u (timeout=%dms)", port, timeout_ms);
-            ready = net_wait_readable(listen_sock, timeout_ms);
+            ready = net_wait_readable(listen_sock, deadline ? -1 : timeout_ms);
+
+            if (deadline)
+            {
+                timerwheel_cancel(&session->accept_timer);
+
+                // The shut down listener is of no further use, a retry needs a new PASV
+                pthread_mutex_lock(&session->lock);
+                if (session->accept_expired)
+                {
+                    ready = 0;
+                    if (session->data_listen_socket == listen_sock)
+                    {
+                        session_close_listen_socket(session);
+                    }
+                }
+                pthread_mutex_unlock(&session->lock);
+            }
 
             if (ready < 0)
             {
@@ -721,8 +959,7 @@ int session_open_data_connection(session_t *session, int timeout_ms)
         }
 
         // Close listening socket after accepting
-        net_close_socket(session->data_listen_socket);
-        session->data_listen_socket = INVALID_SOCKET_T;
+        session_close_listen_socket(session);
 
         LOG_DEBUG("Data connection accepted in passive mode on port %u", port);
     }
@@ -733,11 +970,33 @@ int session_open_data_connection(session_t *session, int timeout_ms)
         return -1;
     }
 
+    socket_t data_socket = session->data_socket;
+    int data_protected = session->data_protected;
     pthread_mutex_unlock(&session->lock);
 
+    // PROT P: the client resumes the control connection's TLS session, so this is a short handshake.
+    // The lock is not held, so ABOR can still close the connection meanwhile.
+    if (data_protected && tlssock_accept(data_socket, TLSSOCK_HANDSHAKE_TIMEOUT_MS) != 0)
+    {
+        LOG_ERROR("TLS handshake on the data connection of %s:%u failed", session->client_ip, session->client_port);
+        session_close_data_connection(session);
+        return -1;
+    }
+
     return 0;
 }
 
+int session_open_data_connection(session_t *session, int timeout_ms)
+{
+    long long start = metrics_now_us();
+    int result = open_data_connection(session, timeout_ms);
+    if (result == 0)
+    {
+        metrics_observe_latency(METRICS_DATA_CONNECT, metrics_now_us() - start);
+    }
+    return result;
+}
+
 void session_close_data_connection(session_t *session)
 {
     if (!session)
@@ -763,8 +1022,7 @@ void session_close_data_connection(session_t *session)
     {
         // Close listening socket
         // Shutdown is not necessary here since we are not connected
-        net_close_socket(session->data_listen_socket);
-        session->data_listen_socket = INVALID_SOCKET_T;
+        session_close_listen_socket(session);
         LOG_DEBUG("Data listening socket closed");
     }
 
@@ -824,6 +1082,7 @@ int session_set_restart_offset(session_t *session, long long offset)
 
     pthread_mutex_lock(&session->lock);
     session->restart_offset = offset;
+    session->restart_end = -1;
     pthread_mutex_unlock(&session->lock);
 
     LOG_DEBUG("Restart offset set to %lld", offset);
@@ -831,6 +1090,37 @@ int session_set_restart_offset(session_t *session, long long offset)
     return 0;
 }
 
+int session_set_restart_range(session_t *session, long long start, long long end)
+{
+    if (!session || start < 0 || end < start)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    session->restart_offset = start;
+    session->restart_end = end;
+    pthread_mutex_unlock(&session->lock);
+
+    LOG_DEBUG("Restart range set to %lld-%lld", start, end);
+
+    return 0;
+}
+
+long long session_get_restart_end(session_t *session)
+{
+    if (!session)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    long long end = session->restart_end;
+    pthread_mutex_unlock(&session->lock);
+
+    return end;
+}
+
 long long session_get_restart_offset(session_t *session)
 {
     if (!session)
@@ -854,7 +1144,37 @@ void session_clear_restart_offset(session_t *session)
 
     pthread_mutex_lock(&session->lock);
     session->restart_offset = 0;
+    session->restart_end = -1;
+    pthread_mutex_unlock(&session->lock);
+}
+
+int session_set_allocation_size(session_t *session, long long size)
+{
+    if (!session || size < 0)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    session->allocation_size = size;
     pthread_mutex_unlock(&session->lock);
+
+    return 0;
+}
+
+long long session_take_allocation_size(session_t *session)
+{
+    if (!session)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    long long size = session->allocation_size;
+    session->allocation_size = 0;
+    pthread_mutex_unlock(&session->lock);
+
+    return size;
 }
 
 int session_set_rename_from(session_t *session, const char *path)
@@ -864,10 +1184,19 @@ int session_set_rename_from(session_t *session, const char *path)
         return -1;
     }
 
+    size_t length = strlen(path);
+    char *rename_from = (char *)malloc(length + 1);
+    if (!rename_from)
+    {
+        LOG_ERROR("Failed to allocate rename state");
+        return -1;
+    }
+    memcpy(rename_from, path, length + 1);
+
     pthread_mutex_lock(&session->lock);
 
-    strncpy(session->rename_from, path, sizeof(session->rename_from) - 1);
-    session->rename_from[sizeof(session->rename_from) - 1] = '\0';
+    free(session->rename_from);
+    session->rename_from = rename_from;
     session->rename_pending = 1;
 
     pthread_mutex_unlock(&session->lock);
@@ -911,7 +1240,8 @@ void session_clear_rename_state(session_t *session)
 
     pthread_mutex_lock(&session->lock);
     session->rename_pending = 0;
-    memset(session->rename_from, 0, sizeof(session->rename_from));
+    free(session->rename_from);
+    session->rename_from = NULL;
     pthread_mutex_unlock(&session->lock);
 }
 
@@ -1018,6 +1348,192 @@ int session_is_timed_out(session_t *session, int timeout_seconds)
     return timed_out;
 }
 
+/*
+ * Timer wheel callbacks. They run with the wheel locked, so instead of
+ * waiting for a session lock held across a blocking send they return 1 to
+ * look again on the next tick.
+ */
+
+/**
+ * @brief Idle timer: shuts the control connection down once the session has been idle too long
+ *
+ * The shutdown wakes the session's reader, which closes the session
+ * through the normal disconnect path.
+ *
+ * @param arg Pointer to session
+ * @return Milliseconds until the next check, 0 once the connection was shut down
+ */
+static int session_idle_expired(void *arg)
+{
+    session_t *session = (session_t *)arg;
+    if (pthread_mutex_trylock(&session->lock) != 0)
+    {
+        return 1;
+    }
+
+    // Same rule as session_is_timed_out(), seconds rounded up
+    int timeout_seconds = (session->idle_timeout_ms + 999) / 1000;
+    time_t idle = time(NULL) - session->last_activity;
+    int wait_ms = 0;
+    if (session->transfer_in_progress)
+    {
+        wait_ms = session->idle_timeout_ms; // The control connection is quiet during transfers
+    }
+    else if (idle <= timeout_seconds)
+    {
+        wait_ms = (int)(timeout_seconds + 1 - idle) * 1000;
+    }
+    pthread_mutex_unlock(&session->lock);
+
+    if (wait_ms > 0)
+    {
+        return wait_ms;
+    }
+
+    LOG_INFO("Client %s:%u timed out", session->client_ip, session->client_port);
+    net_shutdown_both(session->control_socket);
+    return 0;
+}
+
+/**
+ * @brief Accept timer: ends the wait for a passive mode connection by shutting the listener down
+ *
+ * @param arg Pointer to session
+ * @return 1 to retry on the next tick, 0 when done
+ */
+static int session_accept_expired(void *arg)
+{
+    session_t *session = (session_t *)arg;
+    if (pthread_mutex_trylock(&session->lock) != 0)
+    {
+        return 1;
+    }
+
+    session->accept_expired = 1;
+    if (session->data_listen_socket != INVALID_SOCKET_T)
+    {
+        net_shutdown_both(session->data_listen_socket);
+    }
+    pthread_mutex_unlock(&session->lock);
+    return 0;
+}
+
+/**
+ * @brief Stall timer: closes a data connection that has moved nothing since the last check
+ *
+ * The transfer's blocked send or receive then fails, and the transfer ends
+ * with 426 like any other broken data connection.
+ *
+ * @param arg Pointer to session
+ * @return Milliseconds until the next check, 0 once the connection was shut down
+ */
+static int session_stall_check(void *arg)
+{
+    session_t *session = (session_t *)arg;
+    if (pthread_mutex_trylock(&session->lock) != 0)
+    {
+        return 1;
+    }
+
+    unsigned long long progress = ATOMIC_LOAD_RELAXED(&session->transfer_progress);
+    if (progress != session->stall_progress)
+    {
+        session->stall_progress = progress;
+        pthread_mutex_unlock(&session->lock);
+        return session->data_timeout_ms;
+    }
+
+    session->transfer_stalled = 1;
+    if (session->data_socket != INVALID_SOCKET_T)
+    {
+        net_shutdown_both(session->data_socket);
+    }
+    pthread_mutex_unlock(&session->lock);
+
+    LOG_WARN("Data connection of %s:%u moved nothing for %d ms, closing it",
+             session->client_ip, session->client_port, session->data_timeout_ms);
+    return 0;
+}
+
+int session_set_timeouts(session_t *session, int idle_timeout_ms, int data_timeout_ms)
+{
+    if (!session)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    session->idle_timeout_ms = idle_timeout_ms;
+    session->data_timeout_ms = data_timeout_ms;
+    pthread_mutex_unlock(&session->lock);
+
+    if (!timerwheel_is_running())
+    {
+        return -1;
+    }
+
+    if (idle_timeout_ms <= 0)
+    {
+        timerwheel_cancel(&session->idle_timer);
+        return 0;
+    }
+
+    return timerwheel_schedule(&session->idle_timer, idle_timeout_ms);
+}
+
+void session_add_transfer_progress(session_t *session, size_t bytes)
+{
+    ATOMIC_FETCH_ADD_RELAXED(&session->transfer_progress, (unsigned long long)bytes);
+}
+
+int session_is_transfer_stalled(session_t *session)
+{
+    if (!session)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    int stalled = session->transfer_stalled;
+    pthread_mutex_unlock(&session->lock);
+
+    return stalled;
+}
+
+int session_receive_line(session_t *session, char *buffer, size_t buffer_size, int timeout_ms, int *has_urgent)
+{
+    if (!session || !buffer)
+    {
+        return -1;
+    }
+
+    return net_receive_line_buffered(session->control_socket, &session->control_buffer,
+                                     buffer, buffer_size, timeout_ms, has_urgent);
+}
+
+int session_secure_control(session_t *session)
+{
+    if (!session)
+    {
+        return -1;
+    }
+
+    session->tls_pending = 0;
+    if (tlssock_accept(session->control_socket, TLSSOCK_HANDSHAKE_TIMEOUT_MS) != 0)
+    {
+        LOG_WARN("TLS handshake with %s:%u failed", session->client_ip, session->client_port);
+        session->should_quit = 1;
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+    session->control_protected = 1;
+    pthread_mutex_unlock(&session->lock);
+
+    LOG_INFO("Control connection of %s:%u secured with TLS", session->client_ip, session->client_port);
+    return 0;
+}
+
 int session_send_response(session_t *session, int code, const char *message)
 {
     if (!session || !message)
@@ -1082,6 +1598,38 @@ int session_send_response_multiline(session_t *session, int code, const char *me
     return 0;
 }
 
+int session_send_response_text(session_t *session, const char *line)
+{
+    if (!session || !line)
+    {
+        return -1;
+    }
+
+    char buffer[PROTO_MAX_RESPONSE_LINE];
+    int written = snprintf(buffer, sizeof(buffer), "%s\r\n", line);
+    if (written < 0 || (size_t)written >= sizeof(buffer))
+    {
+        LOG_ERROR("Response line too long");
+        return -1;
+    }
+
+    pthread_mutex_lock(&session->lock);
+
+    int result = net_send_all(session->control_socket, buffer, (size_t)written);
+
+    pthread_mutex_unlock(&session->lock);
+
+    if (result < 0)
+    {
+        LOG_ERROR("Failed to send response line to client");
+        return -1;
+    }
+
+    LOG_DEBUG("Sent (text): %s", line);
+
+    return 0;
+}
+
 // Transfer thread management functions
 
 void session_set_transfer_thread_state(session_t *session, transfer_thread_state_t state)
@@ -1110,6 +1658,53 @@ transfer_thread_state_t session_get_transfer_thread_state(session_t *session)
     return state;
 }
 
+/**
+ * @brief Runs one transfer for a session and marks the job finished.
+ *
+ * The session may be freed as soon as transfer_job_active is cleared, so it
+ * must not be touched after the lock is released.
+ *
+ * @param arg Pointer to session
+ */
+static void session_transfer_job(void *arg)
+{
+    session_t *session = (session_t *)arg;
+
+    // A checksum has no data connection that could stall
+    if (session->data_timeout_ms > 0 && session->transfer_params->operation != TRANSFER_OP_HASH)
+    {
+        pthread_mutex_lock(&session->lock);
+        session->transfer_stalled = 0;
+        session->stall_progress = 0;
+        ATOMIC_STORE_RELAXED(&session->transfer_progress, 0ULL);
+        pthread_mutex_unlock(&session->lock);
+        timerwheel_schedule(&session->stall_timer, session->data_timeout_ms);
+    }
+
+    transfer_thread_func(session);
+
+    timerwheel_cancel(&session->stall_timer);
+
+    pthread_mutex_lock(&session->lock);
+    objpool_free(&g_transfer_pool, session->transfer_params);
+    session->transfer_params = NULL;
+    session->transfer_job_active = 0;
+    pthread_cond_broadcast(&session->transfer_job_done);
+    pthread_mutex_unlock(&session->lock);
+}
+
+/**
+ * @brief Thread entry used when the worker pool is not running.
+ *
+ * @param arg Pointer to session
+ * @return NULL
+ */
+static void *session_transfer_thread(void *arg)
+{
+    session_transfer_job(arg);
+    return NULL;
+}
+
 int session_start_transfer_thread(session_t *session, const void *params)
 {
     if (!session || !params)
@@ -1117,43 +1712,68 @@ int session_start_transfer_thread(session_t *session, const void *params)
         return -1;
     }
 
+    // Held only while the job is active, idle sessions keep no transfer state
+    transfer_params_t *job_params = (transfer_params_t *)objpool_alloc(&g_transfer_pool);
+    if (!job_params)
+    {
+        return -1;
+    }
+    memcpy(job_params, params, sizeof(transfer_params_t));
+
     pthread_mutex_lock(&session->lock);
 
     // Check if a transfer is already in progress
     if (session->transfer_thread_state != TRANSFER_THREAD_IDLE)
     {
         pthread_mutex_unlock(&session->lock);
+        objpool_free(&g_transfer_pool, job_params);
         return -1;
     }
 
-    // Copy transfer parameters
-    session->transfer_params = malloc(sizeof(transfer_params_t));
-    if (!session->transfer_params)
+    // An idle state with the job still active means the previous job has sent
+    // its final reply and is returning; wait for it to release the job node
+    while (session->transfer_job_active)
     {
-        pthread_mutex_unlock(&session->lock);
-        return -1;
+        pthread_cond_wait(&session->transfer_job_done, &session->lock);
     }
-    memcpy(session->transfer_params, params, sizeof(transfer_params_t));
 
-    // Set state to starting
+    session->transfer_params = job_params;
+
+    // An ABOR that raced with the end of the previous transfer must not cancel this one
+    session->transfer_should_abort = 0;
+
+    // Set state to starting, the job stays STARTING while it waits in the pool queue
     session->transfer_thread_state = TRANSFER_THREAD_STARTING;
+    session->transfer_job_active = 1;
+    session->transfer_job.fn = session_transfer_job;
+    session->transfer_job.arg = session;
+
+    pthread_mutex_unlock(&session->lock);
+
+    int rc = threadpool_submit(&session->transfer_job);
+    if (rc != 0 && !threadpool_is_running())
+    {
+        // No pool (e.g. library use without server_init), run on a dedicated thread
+        pthread_t thread;
+        rc = pthread_create(&thread, NULL, session_transfer_thread, session);
+        if (rc == 0)
+        {
+            pthread_detach(thread);
+        }
+    }
 
-    // Create transfer thread
-    int rc = pthread_create(&session->transfer_thread, NULL, transfer_thread_func, session);
     if (rc != 0)
     {
-        free(session->transfer_params);
+        pthread_mutex_lock(&session->lock);
+        objpool_free(&g_transfer_pool, session->transfer_params);
         session->transfer_params = NULL;
         session->transfer_thread_state = TRANSFER_THREAD_IDLE;
+        session->transfer_job_active = 0;
+        pthread_cond_broadcast(&session->transfer_job_done);
         pthread_mutex_unlock(&session->lock);
         return -1;
     }
 
-    // Don't detach now - we need to join in session_destroy to prevent use-after-free
-    // pthread_detach(session->transfer_thread);
-
-    pthread_mutex_unlock(&session->lock);
-
     return 0;
 }
 
@@ -0,0 +1,202 @@
+/**
+ * @file strintern.c
+ * @brief Shared string table implementation
+ * @version 0.1
+ * @date 2025-12-12
+ *
+ */
+#include "strintern.h"
+
+#include "logger.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Buckets allocated on first use; the table doubles when it holds more strings than buckets
+#define STRINTERN_INITIAL_BUCKETS 64
+
+typedef struct strintern_entry
+{
+    struct strintern_entry *next; // Next entry in the bucket
+    uint64_t hash;
+    size_t refcount;
+    size_t length;
+    char text[]; // NUL-terminated, handed out to owners
+} strintern_entry_t;
+
+static const char g_empty[1] = "";
+
+// Global table state
+static struct
+{
+    strintern_entry_t **buckets;
+    size_t bucket_mask; // Bucket count - 1 (power of two)
+    size_t strings;
+    size_t references;
+    size_t bytes;
+    pthread_mutex_t mutex;
+} g_strintern = {NULL, 0, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief FNV-1a hash of a string
+ */
+static uint64_t strintern_hash(const char *text, size_t length)
+{
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Doubles the bucket array, or allocates it; called with the mutex held
+ */
+static int strintern_grow(void)
+{
+    size_t count = g_strintern.buckets ? (g_strintern.bucket_mask + 1) * 2 : STRINTERN_INITIAL_BUCKETS;
+    strintern_entry_t **buckets = (strintern_entry_t **)calloc(count, sizeof(strintern_entry_t *));
+    if (!buckets)
+    {
+        return -1;
+    }
+
+    if (g_strintern.buckets)
+    {
+        for (size_t i = 0; i <= g_strintern.bucket_mask; i++)
+        {
+            strintern_entry_t *entry = g_strintern.buckets[i];
+            while (entry)
+            {
+                strintern_entry_t *next = entry->next;
+                size_t bucket = (size_t)entry->hash & (count - 1);
+                entry->next = buckets[bucket];
+                buckets[bucket] = entry;
+                entry = next;
+            }
+        }
+        free(g_strintern.buckets);
+    }
+
+    g_strintern.buckets = buckets;
+    g_strintern.bucket_mask = count - 1;
+    return 0;
+}
+
+const char *strintern_acquire(const char *text)
+{
+    if (!text)
+    {
+        return NULL;
+    }
+
+    if (text[0] == '\0')
+    {
+        return g_empty;
+    }
+
+    size_t length = strlen(text);
+    uint64_t hash = strintern_hash(text, length);
+
+    pthread_mutex_lock(&g_strintern.mutex);
+
+    if (g_strintern.buckets)
+    {
+        for (strintern_entry_t *entry = g_strintern.buckets[(size_t)hash & g_strintern.bucket_mask]; entry;
+             entry = entry->next)
+        {
+            if (entry->hash == hash && entry->length == length && memcmp(entry->text, text, length) == 0)
+            {
+                entry->refcount++;
+                g_strintern.references++;
+                pthread_mutex_unlock(&g_strintern.mutex);
+                return entry->text;
+            }
+        }
+    }
+
+    // Growing is only an optimization once the table exists
+    if ((!g_strintern.buckets || g_strintern.strings > g_strintern.bucket_mask) && strintern_grow() != 0 &&
+        !g_strintern.buckets)
+    {
+        pthread_mutex_unlock(&g_strintern.mutex);
+        LOG_ERROR("Failed to allocate the shared string table");
+        return NULL;
+    }
+
+    size_t size = sizeof(strintern_entry_t) + length + 1;
+    strintern_entry_t *entry = (strintern_entry_t *)malloc(size);
+    if (!entry)
+    {
+        pthread_mutex_unlock(&g_strintern.mutex);
+        LOG_ERROR("Failed to allocate a shared string of %zu bytes", length);
+        return NULL;
+    }
+    entry->hash = hash;
+    entry->refcount = 1;
+    entry->length = length;
+    memcpy(entry->text, text, length + 1);
+
+    size_t bucket = (size_t)hash & g_strintern.bucket_mask;
+    entry->next = g_strintern.buckets[bucket];
+    g_strintern.buckets[bucket] = entry;
+    g_strintern.strings++;
+    g_strintern.references++;
+    g_strintern.bytes += size;
+
+    pthread_mutex_unlock(&g_strintern.mutex);
+
+    return entry->text;
+}
+
+void strintern_release(const char *text)
+{
+    if (!text || text == g_empty)
+    {
+        return;
+    }
+
+    strintern_entry_t *entry = (strintern_entry_t *)(void *)(text - offsetof(strintern_entry_t, text));
+
+    pthread_mutex_lock(&g_strintern.mutex);
+
+    g_strintern.references--;
+    if (--entry->refcount > 0)
+    {
+        pthread_mutex_unlock(&g_strintern.mutex);
+        return;
+    }
+
+    // Last owner, unlink it
+    strintern_entry_t **link = &g_strintern.buckets[(size_t)entry->hash & g_strintern.bucket_mask];
+    while (*link != entry)
+    {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    g_strintern.strings--;
+    g_strintern.bytes -= sizeof(strintern_entry_t) + entry->length + 1;
+
+    pthread_mutex_unlock(&g_strintern.mutex);
+
+    free(entry);
+}
+
+void strintern_get_stats(strintern_stats_t *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_strintern.mutex);
+    stats->strings = g_strintern.strings;
+    stats->references = g_strintern.references;
+    stats->bytes = g_strintern.bytes;
+    pthread_mutex_unlock(&g_strintern.mutex);
+}
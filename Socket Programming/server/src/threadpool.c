@@ -0,0 +1,254 @@
+/**
+ * @file threadpool.c
+ * @brief Bounded worker thread pool implementation
+ * @version 0.1
+ * @date 2025-11-22
+ *
+ */
+#include "threadpool.h"
+#include "logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/**
+ * @brief Global pool state, protected by mutex
+ */
+static struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;               // Signalled when a job is queued or the pool stops
+    pthread_t *threads;                // Worker handles, max_workers entries
+    int max_workers;                   // Upper bound on workers
+    int workers;                       // Workers spawned so far (they only exit on shutdown)
+    int idle_workers;                  // Workers parked on cond
+    int busy_workers;                  // Workers running a job
+    int queue_depth;                   // Jobs in the queue
+    threadpool_job_t *head;            // Next job to run
+    threadpool_job_t *tail;            // Last queued job
+    unsigned long long jobs_completed; // Jobs finished since init
+    int running;                       // Accepting jobs
+} g_pool = {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+
+/**
+ * @brief Worker loop: runs queued jobs until the pool stops and the queue is empty.
+ */
+static void *threadpool_worker(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&g_pool.mutex);
+
+    for (;;)
+    {
+        while (!g_pool.head && g_pool.running)
+        {
+            g_pool.idle_workers++;
+            pthread_cond_wait(&g_pool.cond, &g_pool.mutex);
+            g_pool.idle_workers--;
+        }
+
+        threadpool_job_t *job = g_pool.head;
+        if (!job)
+        {
+            // Stopped and drained
+            break;
+        }
+
+        g_pool.head = job->next;
+        if (!g_pool.head)
+        {
+            g_pool.tail = NULL;
+        }
+        g_pool.queue_depth--;
+        g_pool.busy_workers++;
+
+        // The node belongs to the submitter again once it is dequeued
+        threadpool_job_fn_t fn = job->fn;
+        void *job_arg = job->arg;
+        job->next = NULL;
+
+        pthread_mutex_unlock(&g_pool.mutex);
+        fn(job_arg);
+        pthread_mutex_lock(&g_pool.mutex);
+
+        g_pool.busy_workers--;
+        g_pool.jobs_completed++;
+    }
+
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    return NULL;
+}
+
+int threadpool_init(int max_workers)
+{
+    if (max_workers <= 0)
+    {
+        LOG_ERROR("Invalid worker pool size: %d", max_workers);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_pool.mutex);
+
+    if (g_pool.running || g_pool.threads)
+    {
+        pthread_mutex_unlock(&g_pool.mutex);
+        LOG_ERROR("Worker pool already initialized");
+        return -1;
+    }
+
+    g_pool.threads = (pthread_t *)calloc((size_t)max_workers, sizeof(pthread_t));
+    if (!g_pool.threads)
+    {
+        pthread_mutex_unlock(&g_pool.mutex);
+        LOG_ERROR("Failed to allocate worker pool");
+        return -1;
+    }
+
+    g_pool.max_workers = max_workers;
+    g_pool.workers = 0;
+    g_pool.idle_workers = 0;
+    g_pool.busy_workers = 0;
+    g_pool.queue_depth = 0;
+    g_pool.head = NULL;
+    g_pool.tail = NULL;
+    g_pool.jobs_completed = 0;
+    g_pool.running = 1;
+
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    LOG_INFO("Transfer worker pool started: max_workers=%d", max_workers);
+
+    return 0;
+}
+
+int threadpool_submit(threadpool_job_t *job)
+{
+    if (!job || !job->fn)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_pool.mutex);
+
+    if (!g_pool.running)
+    {
+        pthread_mutex_unlock(&g_pool.mutex);
+        return -1;
+    }
+
+    // Every parked worker will take one queued job; spawn only if this one would be left over
+    if (g_pool.queue_depth + 1 > g_pool.idle_workers && g_pool.workers < g_pool.max_workers)
+    {
+        int rc = pthread_create(&g_pool.threads[g_pool.workers], NULL, threadpool_worker, NULL);
+        if (rc == 0)
+        {
+            g_pool.workers++;
+            LOG_DEBUG("Worker pool grew to %d threads", g_pool.workers);
+        }
+        else if (g_pool.workers == 0)
+        {
+            // Nobody would ever run the job
+            pthread_mutex_unlock(&g_pool.mutex);
+            LOG_ERROR("Failed to start worker thread: %s", strerror(rc));
+            return -1;
+        }
+        else
+        {
+            LOG_WARN("Failed to start worker thread, job queued: %s", strerror(rc));
+        }
+    }
+
+    job->next = NULL;
+    if (g_pool.tail)
+    {
+        g_pool.tail->next = job;
+    }
+    else
+    {
+        g_pool.head = job;
+    }
+    g_pool.tail = job;
+    g_pool.queue_depth++;
+
+    pthread_cond_signal(&g_pool.cond);
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    return 0;
+}
+
+int threadpool_is_running(void)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+    int running = g_pool.running;
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    return running;
+}
+
+void threadpool_get_stats(threadpool_stats_t *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_pool.mutex);
+    stats->max_workers = g_pool.max_workers;
+    stats->workers = g_pool.workers;
+    stats->busy_workers = g_pool.busy_workers;
+    stats->queue_depth = g_pool.queue_depth;
+    stats->jobs_completed = g_pool.jobs_completed;
+    pthread_mutex_unlock(&g_pool.mutex);
+}
+
+int threadpool_get_queue_depth(void)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+    int depth = g_pool.queue_depth;
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    return depth;
+}
+
+int threadpool_get_busy_count(void)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+    int busy = g_pool.busy_workers;
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    return busy;
+}
+
+void threadpool_shutdown(void)
+{
+    pthread_mutex_lock(&g_pool.mutex);
+
+    if (!g_pool.threads)
+    {
+        pthread_mutex_unlock(&g_pool.mutex);
+        return;
+    }
+
+    g_pool.running = 0;
+    pthread_cond_broadcast(&g_pool.cond);
+
+    int workers = g_pool.workers;
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    // Workers finish whatever is still queued before exiting
+    for (int i = 0; i < workers; i++)
+    {
+        pthread_join(g_pool.threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&g_pool.mutex);
+    LOG_INFO("Transfer worker pool stopped: %llu jobs completed", g_pool.jobs_completed);
+    free(g_pool.threads);
+    g_pool.threads = NULL;
+    g_pool.workers = 0;
+    g_pool.max_workers = 0;
+    pthread_mutex_unlock(&g_pool.mutex);
+}
@@ -0,0 +1,321 @@
+/**
+ * @file timerwheel.c
+ * @brief Hashed timer wheel implementation
+ * @version 0.1
+ * @date 2025-12-14
+ *
+ */
+#define _POSIX_C_SOURCE 200112L
+#include "timerwheel.h"
+#include "logger.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Slots in the wheel (power of two); deadlines beyond one turn wait in their slot for later turns
+#define TIMERWHEEL_SLOTS 512
+#define TIMERWHEEL_SLOT_MASK (TIMERWHEEL_SLOTS - 1)
+
+/**
+ * @brief Global wheel state, protected by mutex
+ */
+static struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                           // Signalled to stop the wheel thread
+    pthread_t thread;
+    timerwheel_timer_t *slots[TIMERWHEEL_SLOTS];   // Armed timers by expiry tick
+    int tick_ms;
+    long long start_ms;                            // Monotonic time of tick 0
+    unsigned long long current_tick;               // Next tick to process
+    size_t armed;                                  // Timers in the slots
+    unsigned long long expired;                    // Callbacks run since init
+    int running;
+} g_wheel = {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+
+/**
+ * @brief Gets a monotonic timestamp in milliseconds
+ */
+static long long timerwheel_now_ms(void)
+{
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * @brief Puts a timer into the slot of its expiry tick; called with the mutex held
+ */
+static void timerwheel_link(timerwheel_timer_t *timer, int delay_ms)
+{
+    if (delay_ms < 0)
+    {
+        delay_ms = 0;
+    }
+
+    // Rounded up, so the timer never fires before its delay has passed
+    long long elapsed = timerwheel_now_ms() - g_wheel.start_ms + delay_ms;
+    unsigned long long expires = (unsigned long long)((elapsed + g_wheel.tick_ms - 1) / g_wheel.tick_ms);
+    if (expires < g_wheel.current_tick)
+    {
+        expires = g_wheel.current_tick;
+    }
+
+    timerwheel_timer_t **slot = &g_wheel.slots[expires & TIMERWHEEL_SLOT_MASK];
+    timer->expires = expires;
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (*slot)
+    {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+    timer->armed = 1;
+    g_wheel.armed++;
+}
+
+/**
+ * @brief Takes an armed timer out of its slot; called with the mutex held
+ */
+static void timerwheel_unlink(timerwheel_timer_t *timer)
+{
+    if (timer->prev)
+    {
+        timer->prev->next = timer->next;
+    }
+    else
+    {
+        g_wheel.slots[timer->expires & TIMERWHEEL_SLOT_MASK] = timer->next;
+    }
+    if (timer->next)
+    {
+        timer->next->prev = timer->prev;
+    }
+    timer->prev = timer->next = NULL;
+    timer->armed = 0;
+    g_wheel.armed--;
+}
+
+/**
+ * @brief Runs the timers of one slot that are due at tick; called with the mutex held
+ */
+static void timerwheel_expire_slot(unsigned long long tick)
+{
+    timerwheel_timer_t *timer = g_wheel.slots[tick & TIMERWHEEL_SLOT_MASK];
+    while (timer)
+    {
+        // A re-armed timer goes to the head of its slot, never after next
+        timerwheel_timer_t *next = timer->next;
+        if (timer->expires <= tick)
+        {
+            timerwheel_unlink(timer);
+            g_wheel.expired++;
+
+            int again_ms = timer->callback(timer->user_data);
+            if (again_ms > 0)
+            {
+                timerwheel_link(timer, again_ms);
+            }
+        }
+        timer = next;
+    }
+}
+
+/**
+ * @brief Wheel thread: processes every tick that has passed, then sleeps until the next one.
+ */
+static void *timerwheel_thread(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&g_wheel.mutex);
+
+    while (g_wheel.running)
+    {
+        long long now = timerwheel_now_ms();
+        unsigned long long due = (unsigned long long)((now - g_wheel.start_ms) / g_wheel.tick_ms);
+
+        // After a long stall one turn visits every slot, and everything overdue fires once
+        if (due >= g_wheel.current_tick + TIMERWHEEL_SLOTS)
+        {
+            g_wheel.current_tick = due - TIMERWHEEL_SLOTS + 1;
+        }
+        while (g_wheel.current_tick <= due)
+        {
+            timerwheel_expire_slot(g_wheel.current_tick);
+            g_wheel.current_tick++;
+        }
+
+        long long wait_ms = g_wheel.start_ms + (long long)g_wheel.current_tick * g_wheel.tick_ms - timerwheel_now_ms();
+        if (wait_ms <= 0)
+        {
+            continue;
+        }
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)(wait_ms / 1000);
+        deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&g_wheel.cond, &g_wheel.mutex, &deadline);
+    }
+
+    pthread_mutex_unlock(&g_wheel.mutex);
+
+    return NULL;
+}
+
+void timerwheel_timer_init(timerwheel_timer_t *timer, timerwheel_cb_t callback, void *user_data)
+{
+    if (!timer)
+    {
+        return;
+    }
+
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->user_data = user_data;
+}
+
+int timerwheel_init(int tick_ms)
+{
+    pthread_mutex_lock(&g_wheel.mutex);
+
+    if (g_wheel.running)
+    {
+        pthread_mutex_unlock(&g_wheel.mutex);
+        LOG_ERROR("Timer wheel already initialized");
+        return -1;
+    }
+
+    memset(g_wheel.slots, 0, sizeof(g_wheel.slots));
+    g_wheel.tick_ms = tick_ms > 0 ? tick_ms : TIMERWHEEL_DEFAULT_TICK_MS;
+    g_wheel.start_ms = timerwheel_now_ms();
+    g_wheel.current_tick = 1;
+    g_wheel.armed = 0;
+    g_wheel.expired = 0;
+    g_wheel.running = 1;
+
+    int rc = pthread_create(&g_wheel.thread, NULL, timerwheel_thread, NULL);
+    if (rc != 0)
+    {
+        g_wheel.running = 0;
+        pthread_mutex_unlock(&g_wheel.mutex);
+        LOG_ERROR("Failed to start timer wheel thread: %s", strerror(rc));
+        return -1;
+    }
+
+    pthread_mutex_unlock(&g_wheel.mutex);
+
+    LOG_INFO("Timer wheel started: %d ms tick, %d slots", g_wheel.tick_ms, TIMERWHEEL_SLOTS);
+
+    return 0;
+}
+
+int timerwheel_schedule(timerwheel_timer_t *timer, int delay_ms)
+{
+    if (!timer || !timer->callback)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_wheel.mutex);
+
+    if (!g_wheel.running)
+    {
+        pthread_mutex_unlock(&g_wheel.mutex);
+        return -1;
+    }
+
+    if (timer->armed)
+    {
+        timerwheel_unlink(timer);
+    }
+    timerwheel_link(timer, delay_ms);
+
+    pthread_mutex_unlock(&g_wheel.mutex);
+
+    return 0;
+}
+
+void timerwheel_cancel(timerwheel_timer_t *timer)
+{
+    if (!timer)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_wheel.mutex);
+    if (timer->armed)
+    {
+        timerwheel_unlink(timer);
+    }
+    pthread_mutex_unlock(&g_wheel.mutex);
+}
+
+int timerwheel_is_running(void)
+{
+    pthread_mutex_lock(&g_wheel.mutex);
+    int running = g_wheel.running;
+    pthread_mutex_unlock(&g_wheel.mutex);
+
+    return running;
+}
+
+void timerwheel_get_stats(timerwheel_stats_t *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&g_wheel.mutex);
+    stats->tick_ms = g_wheel.tick_ms;
+    stats->armed = g_wheel.armed;
+    stats->expired = g_wheel.expired;
+    pthread_mutex_unlock(&g_wheel.mutex);
+}
+
+void timerwheel_shutdown(void)
+{
+    pthread_mutex_lock(&g_wheel.mutex);
+
+    if (!g_wheel.running)
+    {
+        pthread_mutex_unlock(&g_wheel.mutex);
+        return;
+    }
+
+    g_wheel.running = 0;
+    pthread_cond_signal(&g_wheel.cond);
+    pthread_mutex_unlock(&g_wheel.mutex);
+
+    pthread_join(g_wheel.thread, NULL);
+
+    // Owners may still cancel their timers later, which must find them disarmed
+    pthread_mutex_lock(&g_wheel.mutex);
+    for (int i = 0; i < TIMERWHEEL_SLOTS; i++)
+    {
+        while (g_wheel.slots[i])
+        {
+            timerwheel_unlink(g_wheel.slots[i]);
+        }
+    }
+    pthread_mutex_unlock(&g_wheel.mutex);
+
+    LOG_INFO("Timer wheel stopped");
+}
@@ -0,0 +1,570 @@
+/**
+ * @file tlssock.c
+ * @brief TLS on connected sockets implementation
+ * @version 0.1
+ * @date 2025-12-18
+ *
+ */
+#include "tlssock.h"
+
+#include "atomics.h"
+#include "logger.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ENABLE_OPENSSL
+#include <errno.h>
+#include <limits.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+// Hash buckets of the secured sockets
+#define TLSSOCK_BUCKETS 256
+
+// Distinguishes this server's sessions in the session cache
+#define TLSSOCK_SESSION_CONTEXT "ftpserver"
+
+// SSL_sendfile() and kTLS arrived with OpenSSL 3.0
+#if defined(__linux__) && OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS) && \
+    defined(SSL_OP_ENABLE_KTLS)
+#define TLSSOCK_HAVE_KTLS
+#endif
+
+typedef struct tlssock_entry
+{
+    struct tlssock_entry *next; // Next entry in the hash bucket
+    socket_t sock;
+    SSL *ssl;
+    pthread_mutex_t lock; // Serializes SSL calls: the session thread reads while transfers reply
+    int refs;             // One for the table, one per operation in progress
+    int ktls_send;        // 1 if the kernel encrypts what is sent
+    int closed;           // 1 once close_notify was sent (or could not be)
+} tlssock_entry_t;
+
+// Global TLS state
+static struct
+{
+    SSL_CTX *ctx;
+    tlssock_entry_t *buckets[TLSSOCK_BUCKETS];
+    int secured; // Entries in the table, read without the mutex to skip lookups for plain sockets
+    unsigned long long handshakes;
+    unsigned long long resumed;
+    unsigned long long failures;
+    unsigned long long ktls_send;
+    pthread_mutex_t mutex;
+} g_tls = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * @brief Logs and clears the OpenSSL error queue
+ */
+static void tlssock_log_errors(const char *what)
+{
+    unsigned long error = ERR_get_error();
+    if (error == 0)
+    {
+        LOG_WARN("%s failed", what);
+        return;
+    }
+
+    char text[256];
+    ERR_error_string_n(error, text, sizeof(text));
+    LOG_WARN("%s failed: %s", what, text);
+    ERR_clear_error();
+}
+
+/**
+ * @brief Reports a TLS level failure through net_get_last_error()
+ */
+static void tlssock_set_error(int ssl_error)
+{
+    // A failed system call has set the error already
+    if (ssl_error == SSL_ERROR_SYSCALL)
+        return;
+#ifdef _WIN32
+    WSASetLastError(WSAECONNABORTED);
+#else
+    errno = EPROTO;
+#endif
+}
+
+static size_t tlssock_bucket(socket_t sock)
+{
+    return (size_t)sock % TLSSOCK_BUCKETS;
+}
+
+/**
+ * @brief Finds the entry of a socket and takes a reference
+ *
+ * @return The entry, or NULL for plain sockets
+ */
+static tlssock_entry_t *tlssock_find(socket_t sock)
+{
+    if (ATOMIC_LOAD_RELAXED(&g_tls.secured) == 0)
+        return NULL;
+
+    pthread_mutex_lock(&g_tls.mutex);
+    tlssock_entry_t *entry = g_tls.buckets[tlssock_bucket(sock)];
+    while (entry && entry->sock != sock)
+        entry = entry->next;
+    if (entry)
+        entry->refs++;
+    pthread_mutex_unlock(&g_tls.mutex);
+    return entry;
+}
+
+/**
+ * @brief Drops a reference, freeing the entry with the last one
+ */
+static void tlssock_put(tlssock_entry_t *entry)
+{
+    pthread_mutex_lock(&g_tls.mutex);
+    int unused = --entry->refs == 0;
+    pthread_mutex_unlock(&g_tls.mutex);
+
+    if (unused)
+    {
+        SSL_free(entry->ssl);
+        pthread_mutex_destroy(&entry->lock);
+        free(entry);
+    }
+}
+
+/**
+ * @brief Sends close_notify without blocking; called with the entry locked
+ */
+static void tlssock_shutdown_locked(tlssock_entry_t *entry)
+{
+    if (entry->closed)
+        return;
+    entry->closed = 1;
+
+    // The connection is being torn down, so a peer that reads nothing must not hold it up
+    net_set_nonblocking(entry->sock, 1);
+    ERR_clear_error();
+    SSL_shutdown(entry->ssl);
+    ERR_clear_error();
+}
+
+int tlssock_init(const char *cert_file, const char *key_file)
+{
+    if (!cert_file || !cert_file[0])
+        return -1;
+    if (!key_file || !key_file[0])
+        key_file = cert_file;
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx)
+    {
+        tlssock_log_errors("Creating the TLS context");
+        return -1;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    // Clients often close data connections without close_notify; treated as the end of the data
+    SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+#ifdef TLSSOCK_HAVE_KTLS
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+
+    // Records without application data return to tlssock_read(), which waits outside the lock
+    SSL_CTX_clear_mode(ctx, SSL_MODE_AUTO_RETRY);
+
+    // Data connections resume the session of the control connection (IDs for TLS 1.2, tickets for 1.3)
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_set_session_id_context(ctx, (const unsigned char *)TLSSOCK_SESSION_CONTEXT,
+                                   sizeof(TLSSOCK_SESSION_CONTEXT) - 1);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, cert_file) != 1)
+    {
+        LOG_ERROR("Failed to load TLS certificate: %s", cert_file);
+        tlssock_log_errors("Loading the certificate");
+        SSL_CTX_free(ctx);
+        return -1;
+    }
+    if (SSL_CTX_use_PrivateKey_file(ctx, key_file, SSL_FILETYPE_PEM) != 1 || SSL_CTX_check_private_key(ctx) != 1)
+    {
+        LOG_ERROR("Failed to load TLS private key: %s", key_file);
+        tlssock_log_errors("Loading the private key");
+        SSL_CTX_free(ctx);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_tls.mutex);
+    SSL_CTX *old = g_tls.ctx;
+    g_tls.ctx = ctx;
+    g_tls.handshakes = 0;
+    g_tls.resumed = 0;
+    g_tls.failures = 0;
+    g_tls.ktls_send = 0;
+    pthread_mutex_unlock(&g_tls.mutex);
+    SSL_CTX_free(old);
+
+    LOG_INFO("TLS enabled with %s (%s)", cert_file, OpenSSL_version(OPENSSL_VERSION));
+    return 0;
+}
+
+void tlssock_cleanup(void)
+{
+    pthread_mutex_lock(&g_tls.mutex);
+    SSL_CTX *ctx = g_tls.ctx;
+    g_tls.ctx = NULL;
+    pthread_mutex_unlock(&g_tls.mutex);
+
+    // Secured sockets hold their own reference to the context
+    SSL_CTX_free(ctx);
+}
+
+int tlssock_is_available(void)
+{
+    pthread_mutex_lock(&g_tls.mutex);
+    int available = g_tls.ctx != NULL;
+    pthread_mutex_unlock(&g_tls.mutex);
+    return available;
+}
+
+int tlssock_accept(socket_t sock, int timeout_ms)
+{
+    pthread_mutex_lock(&g_tls.mutex);
+    SSL *ssl = g_tls.ctx ? SSL_new(g_tls.ctx) : NULL;
+    pthread_mutex_unlock(&g_tls.mutex);
+
+    tlssock_entry_t *entry = (tlssock_entry_t *)calloc(1, sizeof(tlssock_entry_t));
+    if (!ssl || !entry || SSL_set_fd(ssl, (int)sock) != 1)
+    {
+        LOG_ERROR("Failed to set up TLS for a connection");
+        SSL_free(ssl);
+        free(entry);
+        return -1;
+    }
+
+    // Plain blocking I/O with a deadline, so a silent peer cannot hold the thread
+    if (timeout_ms > 0)
+    {
+        net_set_recv_timeout(sock, timeout_ms);
+        net_set_send_timeout(sock, timeout_ms);
+    }
+    ERR_clear_error();
+    int accepted = SSL_accept(ssl);
+    if (timeout_ms > 0)
+    {
+        net_set_recv_timeout(sock, 0);
+        net_set_send_timeout(sock, 0);
+    }
+
+    if (accepted != 1)
+    {
+        tlssock_log_errors("TLS handshake");
+        pthread_mutex_lock(&g_tls.mutex);
+        g_tls.failures++;
+        pthread_mutex_unlock(&g_tls.mutex);
+        SSL_free(ssl);
+        free(entry);
+        return -1;
+    }
+
+    entry->sock = sock;
+    entry->ssl = ssl;
+    entry->refs = 1;
+    pthread_mutex_init(&entry->lock, NULL);
+#ifdef TLSSOCK_HAVE_KTLS
+    entry->ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl)) ? 1 : 0;
+#endif
+    int resumed = SSL_session_reused(ssl);
+
+    pthread_mutex_lock(&g_tls.mutex);
+    size_t bucket = tlssock_bucket(sock);
+    entry->next = g_tls.buckets[bucket];
+    g_tls.buckets[bucket] = entry;
+    ATOMIC_FETCH_ADD(&g_tls.secured, 1);
+    g_tls.handshakes++;
+    g_tls.resumed += resumed ? 1 : 0;
+    g_tls.ktls_send += (unsigned long long)entry->ktls_send;
+    pthread_mutex_unlock(&g_tls.mutex);
+
+    LOG_DEBUG("TLS handshake done: %s, %s%s%s", SSL_get_version(ssl), SSL_get_cipher_name(ssl),
+              resumed ? ", resumed" : "", entry->ktls_send ? ", kernel TLS" : "");
+    return 0;
+}
+
+int tlssock_is_secured(socket_t sock)
+{
+    tlssock_entry_t *entry = tlssock_find(sock);
+    if (!entry)
+        return 0;
+    tlssock_put(entry);
+    return 1;
+}
+
+void tlssock_get_stats(tlssock_stats_t *stats)
+{
+    if (!stats)
+        return;
+
+    pthread_mutex_lock(&g_tls.mutex);
+    stats->handshakes = g_tls.handshakes;
+    stats->resumed = g_tls.resumed;
+    stats->failures = g_tls.failures;
+    stats->ktls_send = g_tls.ktls_send;
+    stats->secured = g_tls.secured;
+    pthread_mutex_unlock(&g_tls.mutex);
+}
+
+/**
+ * @brief Reads decrypted data, waiting for input without holding the entry lock
+ */
+static int tlssock_read(tlssock_entry_t *entry, void *buffer, size_t buffer_size)
+{
+    int length = buffer_size > INT_MAX ? INT_MAX : (int)buffer_size;
+
+    while (1)
+    {
+        // An idle client must not block the replies transfer threads send meanwhile
+        pthread_mutex_lock(&entry->lock);
+        int pending = SSL_pending(entry->ssl);
+        pthread_mutex_unlock(&entry->lock);
+        if (pending == 0 && net_wait_readable(entry->sock, -1) < 0)
+            return -1;
+
+        pthread_mutex_lock(&entry->lock);
+        ERR_clear_error();
+        int received = SSL_read(entry->ssl, buffer, length);
+        int error = received > 0 ? SSL_ERROR_NONE : SSL_get_error(entry->ssl, received);
+        pthread_mutex_unlock(&entry->lock);
+
+        if (received > 0)
+            return received;
+        if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+            continue; // A record without application data, e.g. a new session ticket
+        if (error == SSL_ERROR_ZERO_RETURN)
+            return 0;
+
+        tlssock_set_error(error);
+        ERR_clear_error();
+        return -1;
+    }
+}
+
+int tlssock_receive(socket_t sock, void *buffer, size_t buffer_size, int *result)
+{
+    tlssock_entry_t *entry = tlssock_find(sock);
+    if (!entry)
+        return 0;
+
+    *result = tlssock_read(entry, buffer, buffer_size);
+    tlssock_put(entry);
+    return 1;
+}
+
+int tlssock_send(socket_t sock, const void *data, size_t length, int *result)
+{
+    tlssock_entry_t *entry = tlssock_find(sock);
+    if (!entry)
+        return 0;
+
+    // Without partial writes SSL_write() returns only once everything is sent
+    int chunk = length > INT_MAX ? INT_MAX : (int)length;
+    pthread_mutex_lock(&entry->lock);
+    ERR_clear_error();
+    int sent = chunk > 0 ? SSL_write(entry->ssl, data, chunk) : 0;
+    int error = sent > 0 || chunk == 0 ? SSL_ERROR_NONE : SSL_get_error(entry->ssl, sent);
+    pthread_mutex_unlock(&entry->lock);
+
+    if (error != SSL_ERROR_NONE)
+    {
+        tlssock_set_error(error);
+        ERR_clear_error();
+        sent = -1;
+    }
+
+    *result = sent;
+    tlssock_put(entry);
+    return 1;
+}
+
+int tlssock_send_file(socket_t sock, fs_file_t *file, long long offset, long long length, long long *result)
+{
+    tlssock_entry_t *entry = tlssock_find(sock);
+    if (!entry)
+        return 0;
+
+    *result = NET_SENDFILE_UNSUPPORTED;
+#ifdef TLSSOCK_HAVE_KTLS
+    if (entry->ktls_send)
+    {
+        long long total = 0;
+        while (total < length)
+        {
+            long long remaining = length - total;
+            size_t count = (size_t)(remaining > 0x7FFFF000LL ? 0x7FFFF000LL : remaining);
+
+            pthread_mutex_lock(&entry->lock);
+            ERR_clear_error();
+            ossl_ssize_t sent = SSL_sendfile(entry->ssl, file->fd, (off_t)(offset + total), count, 0);
+            pthread_mutex_unlock(&entry->lock);
+
+            if (sent < 0)
+            {
+                ERR_clear_error();
+                total = total == 0 && (errno == EINVAL || errno == EOPNOTSUPP) ? NET_SENDFILE_UNSUPPORTED : -1;
+                break;
+            }
+            if (sent == 0)
+                break; // End of file
+            total += sent;
+        }
+        *result = total;
+    }
+#else
+    (void)file;
+    (void)offset;
+    (void)length;
+#endif
+
+    tlssock_put(entry);
+    return 1;
+}
+
+size_t tlssock_pending(socket_t sock)
+{
+    tlssock_entry_t *entry = tlssock_find(sock);
+    if (!entry)
+        return 0;
+
+    pthread_mutex_lock(&entry->lock);
+    int pending = SSL_pending(entry->ssl);
+    pthread_mutex_unlock(&entry->lock);
+
+    tlssock_put(entry);
+    return pending > 0 ? (size_t)pending : 0;
+}
+
+void tlssock_close_notify(socket_t sock)
+{
+    tlssock_entry_t *entry = tlssock_find(sock);
+    if (!entry)
+        return;
+
+    // A thread inside SSL_write() is about to fail anyway; its connection ends without close_notify
+    if (pthread_mutex_trylock(&entry->lock) == 0)
+    {
+        tlssock_shutdown_locked(entry);
+        pthread_mutex_unlock(&entry->lock);
+    }
+    tlssock_put(entry);
+}
+
+void tlssock_detach(socket_t sock)
+{
+    if (ATOMIC_LOAD_RELAXED(&g_tls.secured) == 0)
+        return;
+
+    pthread_mutex_lock(&g_tls.mutex);
+    tlssock_entry_t **link = &g_tls.buckets[tlssock_bucket(sock)];
+    while (*link && (*link)->sock != sock)
+        link = &(*link)->next;
+    tlssock_entry_t *entry = *link;
+    if (entry)
+    {
+        *link = entry->next;
+        ATOMIC_FETCH_SUB(&g_tls.secured, 1);
+    }
+    pthread_mutex_unlock(&g_tls.mutex);
+
+    if (!entry)
+        return;
+
+    if (pthread_mutex_trylock(&entry->lock) == 0)
+    {
+        tlssock_shutdown_locked(entry);
+        pthread_mutex_unlock(&entry->lock);
+    }
+    tlssock_put(entry); // The table's reference
+}
+
+#else // !ENABLE_OPENSSL
+
+int tlssock_init(const char *cert_file, const char *key_file)
+{
+    (void)key_file;
+    LOG_ERROR("TLS requested (%s) but the server was built without OpenSSL", cert_file ? cert_file : "");
+    return -1;
+}
+
+void tlssock_cleanup(void)
+{
+}
+
+int tlssock_is_available(void)
+{
+    return 0;
+}
+
+int tlssock_accept(socket_t sock, int timeout_ms)
+{
+    (void)sock;
+    (void)timeout_ms;
+    return -1;
+}
+
+int tlssock_is_secured(socket_t sock)
+{
+    (void)sock;
+    return 0;
+}
+
+void tlssock_get_stats(tlssock_stats_t *stats)
+{
+    if (stats)
+        memset(stats, 0, sizeof(*stats));
+}
+
+int tlssock_receive(socket_t sock, void *buffer, size_t buffer_size, int *result)
+{
+    (void)sock;
+    (void)buffer;
+    (void)buffer_size;
+    (void)result;
+    return 0;
+}
+
+int tlssock_send(socket_t sock, const void *data, size_t length, int *result)
+{
+    (void)sock;
+    (void)data;
+    (void)length;
+    (void)result;
+    return 0;
+}
+
+int tlssock_send_file(socket_t sock, fs_file_t *file, long long offset, long long length, long long *result)
+{
+    (void)sock;
+    (void)file;
+    (void)offset;
+    (void)length;
+    (void)result;
+    return 0;
+}
+
+size_t tlssock_pending(socket_t sock)
+{
+    (void)sock;
+    return 0;
+}
+
+void tlssock_close_notify(socket_t sock)
+{
+    (void)sock;
+}
+
+void tlssock_detach(socket_t sock)
+{
+    (void)sock;
+}
+
+#endif // ENABLE_OPENSSL
@@ -8,10 +8,20 @@
 #include "transfer.h"
 
 #include "session.h"
+#include "atomics.h"
+#include "datacomp.h"
+#include "digestcache.h"
 #include "filesys.h"
 #include "filelock.h"
+#include "hotcache.h"
+#include "iopipe.h"
+#include "lineconv.h"
+#include "listcache.h"
 #include "network.h"
 #include "logger.h"
+#include "metrics.h"
+#include "mlsx.h"
+#include "ratelimit.h"
 #include "utils.h"
 
 #include <stdlib.h>
@@ -22,63 +32,459 @@
 
 #ifndef _WIN32
 #include <sys/stat.h>
-#include <pwd.h>
-#include <grp.h>
 #endif
 
+// Line format of send_listing()
+typedef enum
+{
+    LISTING_LS,  // ls -l style (LIST)
+    LISTING_MLSD // RFC 3659 facts (MLSD)
+} listing_style_t;
+
 // Forward declarations
 static int format_list_line(const fs_file_info_t *info,
                             char *buffer,
                             size_t buffer_size);
 static transfer_status_t send_listing(session_t *session,
                                       const char *dirpath,
-                                      const char *filter_name);
+                                      const char *filter_name,
+                                      listing_style_t style);
+static transfer_status_t listing_send_failed(session_t *session, const char *what, const char *dirpath);
 
-transfer_status_t transfer_send_file(session_t *session, const char *filepath, long long offset)
+// Buffers in flight per file transfer and upload durability, set once at startup
+static int g_pipeline_depth = IOPIPE_DEFAULT_DEPTH;
+static transfer_durability_t g_durability = TRANSFER_DURABILITY_CLOSE;
+
+// Read-ahead stage of a download
+typedef struct
 {
-    if (!session || !filepath)
+    fs_file_t *file;
+    const char *filepath;
+    long long offset;    // Offset of the next read
+    long long remaining; // Bytes left to read
+} file_reader_t;
+
+// Write-behind stage of an upload
+typedef struct
+{
+    fs_file_t *file;
+    long long offset;       // Offset of the next write
+    long long window_start; // Start of the data not yet written back (periodic durability)
+    long long prev_window;  // Start of the window whose write-back is in progress
+} file_writer_t;
+
+int transfer_set_pipeline_depth(int depth)
+{
+    if (depth < IOPIPE_MIN_DEPTH || depth > IOPIPE_MAX_DEPTH)
     {
-        LOG_ERROR("Invalid parameters for transfer_send_file");
-        return TRANSFER_STATUS_INTERNAL_ERROR;
+        LOG_ERROR("Invalid transfer pipeline depth: %d", depth);
+        return -1;
     }
+    g_pipeline_depth = depth;
+    return 0;
+}
 
-    // Verify data socket is valid
-    if (session->data_socket == INVALID_SOCKET_T)
+void transfer_set_durability(transfer_durability_t durability)
+{
+    g_durability = durability;
+}
+
+/**
+ * @brief Pipeline stage reading the next piece of a download.
+ */
+static long long read_file_stage(void *context, char *buffer, size_t length)
+{
+    file_reader_t *reader = (file_reader_t *)context;
+    if (reader->remaining <= 0)
     {
-        LOG_ERROR("Data socket is not open for SEND transfer (data_mode=%d, client=%s:%u)",
-                  session->data_mode, session->client_ip, session->client_port);
-        return TRANSFER_STATUS_CONN_ERROR;
+        return 0;
     }
 
-    long long file_size = fs_get_file_size(filepath);
-    if (file_size < 0)
+    size_t to_read = (reader->remaining > (long long)length) ? length : (size_t)reader->remaining;
+    long long bytes_read = fs_file_read(reader->file, buffer, to_read);
+
+    if (bytes_read < 0)
     {
-        LOG_ERROR("Cannot get file size: %s", filepath);
-        return TRANSFER_STATUS_IO_ERROR;
+        LOG_ERROR("Failed to read file at offset %lld", reader->offset);
+        return -1;
+    }
+
+    if (bytes_read == 0)
+    {
+        LOG_ERROR("Unexpected EOF while reading %s", reader->filepath);
+        return -1;
+    }
+
+    reader->offset += bytes_read;
+    reader->remaining -= bytes_read;
+    return bytes_read;
+}
+
+/**
+ * @brief Pipeline stage writing the next piece of an upload.
+ */
+static long long write_file_stage(void *context, char *buffer, size_t length)
+{
+    file_writer_t *writer = (file_writer_t *)context;
+
+    if (fs_file_write(writer->file, buffer, (long long)length) != (long long)length)
+    {
+        LOG_ERROR("Failed to write to file at offset %lld", writer->offset);
+        return -1;
+    }
+
+    writer->offset += (long long)length;
+
+    // Start writing back the last window and wait for the one before, so
+    // dirty data stays bounded and the final flush is short
+    if (g_durability == TRANSFER_DURABILITY_PERIODIC &&
+        writer->offset - writer->window_start >= TRANSFER_SYNC_INTERVAL)
+    {
+        fs_file_flush_range(writer->file, writer->window_start, writer->offset - writer->window_start, 0);
+        if (writer->prev_window < writer->window_start &&
+            fs_file_flush_range(writer->file, writer->prev_window, writer->window_start - writer->prev_window, 1) != 0)
+        {
+            LOG_ERROR("Failed to write back file data at offset %lld", writer->prev_window);
+            return -1;
+        }
+        writer->prev_window = writer->window_start;
+        writer->window_start = writer->offset;
     }
+    return 0;
+}
+
+/**
+ * @brief Starts reading a byte range of an open file ahead of the sender.
+ * @param reader Stage state, must outlive the pipeline
+ * @param file Open file handle, positioned at offset
+ * @param filepath File path (for logging)
+ * @param offset Starting byte offset
+ * @param length Number of bytes to read
+ * @return The pipeline, or NULL on error
+ */
+static iopipe_t *start_read_ahead(file_reader_t *reader, fs_file_t *file, const char *filepath,
+                                  long long offset, long long length)
+{
+    reader->file = file;
+    reader->filepath = filepath;
+    reader->offset = offset;
+    reader->remaining = length;
+
+    // Lets the kernel read further ahead than its default window
+    fs_file_advise(file, offset, length, FS_ADVICE_SEQUENTIAL);
+
+    iopipe_t *pipeline = iopipe_create(IOPIPE_READ_AHEAD, g_pipeline_depth, TRANSFER_BUFFER_SIZE, read_file_stage, reader);
+    if (!pipeline)
+    {
+        LOG_ERROR("Failed to set up read-ahead for %s", filepath);
+    }
+    return pipeline;
+}
+
+/**
+ * @brief Starts writing an upload behind the receiver.
+ * @param writer Stage state, must outlive the pipeline
+ * @param file Open file handle, positioned at offset
+ * @param filepath File path (for logging)
+ * @param offset Starting byte offset
+ * @param buffer_size Size of each buffer
+ * @return The pipeline, or NULL on error
+ */
+static iopipe_t *start_write_behind(file_writer_t *writer, fs_file_t *file, const char *filepath,
+                                    long long offset, size_t buffer_size)
+{
+    writer->file = file;
+    writer->offset = offset;
+    writer->window_start = offset;
+    writer->prev_window = offset;
+
+    iopipe_t *pipeline = iopipe_create(IOPIPE_WRITE_BEHIND, g_pipeline_depth, buffer_size, write_file_stage, writer);
+    if (!pipeline)
+    {
+        LOG_ERROR("Failed to set up write-behind for %s", filepath);
+    }
+    return pipeline;
+}
 
-    if (offset > file_size)
+/**
+ * @brief Opens the file of an upload at its starting offset and reserves the announced size.
+ * @param file Output: open file handle
+ * @param filepath Path to write
+ * @param offset Starting byte offset
+ * @param size_hint Expected upload size, 0 if unknown
+ * @return 0 on success, -1 if the file could not be opened or positioned
+ */
+static int open_upload(fs_file_t *file, const char *filepath, long long offset, long long size_hint)
+{
+    if (fs_file_open(file, filepath, FS_OPEN_WRITE) != 0)
     {
-        LOG_ERROR("Offset %lld exceeds file size %lld", offset, file_size);
+        LOG_ERROR("Cannot open file for writing: %s", filepath);
+        return -1;
+    }
+
+    if (fs_file_seek(file, offset) != 0)
+    {
+        LOG_ERROR("Failed to seek to offset %lld: %s", offset, filepath);
+        fs_file_close(file);
+        return -1;
+    }
+
+    // Only a hint: without it the upload still works, just less contiguously
+    if (size_hint > 0 && fs_file_preallocate(file, offset, size_hint) != 0)
+    {
+        LOG_DEBUG("Could not preallocate %lld bytes for %s", size_hint, filepath);
+    }
+    return 0;
+}
+
+/**
+ * @brief Flushes a completed upload as the durability policy asks and closes the file.
+ * @param file Open file handle
+ * @param filepath Uploaded path (for logging)
+ * @param status Transfer status so far
+ * @return The final transfer status
+ */
+static transfer_status_t close_upload(fs_file_t *file, const char *filepath, transfer_status_t status)
+{
+    // Flush once at the end rather than after every chunk
+    if (status == TRANSFER_STATUS_OK && g_durability != TRANSFER_DURABILITY_NONE && fs_file_sync(file) != 0)
+    {
+        LOG_ERROR("Failed to flush file to disk: %s", filepath);
+        status = TRANSFER_STATUS_IO_ERROR;
+    }
+    fs_file_close(file);
+    return status;
+}
+
+/**
+ * @brief Stops a transfer pipeline and logs where the transfer waited.
+ * @param pipeline The pipeline
+ * @param what Name of the transfer for log messages
+ * @param filepath Transferred path
+ */
+static void stop_pipeline(iopipe_t *pipeline, const char *what, const char *filepath)
+{
+    iopipe_stats_t stats;
+    iopipe_get_stats(pipeline, &stats);
+    LOG_DEBUG("%s pipeline: %llu buffers, %llu waits for disk, %llu waits for network: %s",
+              what, stats.buffers, stats.caller_waits, stats.stage_waits, filepath);
+    iopipe_destroy(pipeline);
+}
+
+/**
+ * @brief Creates the deflate writer of a transfer when the session is in MODE Z.
+ * @param session The FTP session
+ * @param adaptive 1 to store data that looks already compressed (file contents)
+ * @param deflater Output: the writer, NULL in stream mode
+ * @return 0 on success, -1 if the writer could not be created
+ */
+static int open_deflater(session_t *session, int adaptive, datacomp_writer_t **deflater)
+{
+    *deflater = NULL;
+    if (session->transfer_mode != PROTO_MODE_DEFLATE)
+    {
+        return 0;
+    }
+
+    *deflater = datacomp_writer_create(session->data_socket, session->compression_level, adaptive);
+    if (!*deflater)
+    {
+        LOG_ERROR("Failed to set up MODE Z compression");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Creates the inflate reader of an upload when the session is in MODE Z.
+ * @param session The FTP session
+ * @param inflater Output: the reader, NULL in stream mode
+ * @return 0 on success, -1 if the reader could not be created
+ */
+static int open_inflater(session_t *session, datacomp_reader_t **inflater)
+{
+    *inflater = NULL;
+    if (session->transfer_mode != PROTO_MODE_DEFLATE)
+    {
+        return 0;
+    }
+
+    *inflater = datacomp_reader_create(session->data_socket);
+    if (!*inflater)
+    {
+        LOG_ERROR("Failed to set up MODE Z decompression");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sends data on the data connection, through the deflate stream in MODE Z.
+ * @param session The FTP session
+ * @param deflater Deflate writer, or NULL in stream mode
+ * @param data Data to send
+ * @param length Data length
+ * @return 0 on success, -1 if sending failed
+ */
+static int send_data(session_t *session, datacomp_writer_t *deflater, const void *data, size_t length)
+{
+    int result = deflater ? datacomp_writer_write(deflater, data, length)
+                          : net_send_all(session->data_socket, data, length);
+    if (result == 0)
+    {
+        session_add_transfer_progress(session, length);
+    }
+    return result;
+}
+
+/**
+ * @brief Charges transferred bytes to the session's bandwidth buckets and
+ * sleeps for as long as the scheduler asks, waking up for ABOR.
+ * @param session The FTP session
+ * @param bytes Bytes just sent or received
+ * @return 0 to go on, -1 if the transfer was aborted while paused
+ */
+static int pace_transfer(session_t *session, size_t bytes)
+{
+    long long wait_us = ratelimit_charge(session->limiter, bytes);
+    while (wait_us > 0)
+    {
+        if (session_should_abort_transfer(session))
+        {
+            return -1;
+        }
+        long long step_ms = (wait_us + 999) / 1000;
+        if (step_ms > RATELIMIT_MAX_SLEEP_MS)
+        {
+            step_ms = RATELIMIT_MAX_SLEEP_MS;
+        }
+        sleep_ms((unsigned int)step_ms);
+        wait_us -= step_ms * 1000;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sends file data in slices paced by the bandwidth scheduler.
+ * @param session The FTP session
+ * @param deflater Deflate writer, or NULL in stream mode
+ * @param data Data to send
+ * @param length Data length
+ * @return 0 on success, -1 if sending failed or the transfer was aborted while paused
+ */
+static int send_paced(session_t *session, datacomp_writer_t *deflater, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t chunk = ratelimit_chunk_size(session->limiter, length);
+        if (send_data(session, deflater, data, chunk) != 0 || pace_transfer(session, chunk) != 0)
+        {
+            return -1;
+        }
+        data += chunk;
+        length -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * @brief Receives data from the data connection, through the inflate stream in MODE Z.
+ * @param session The FTP session
+ * @param inflater Inflate reader, or NULL in stream mode
+ * @param buffer Receive buffer
+ * @param buffer_size Buffer size
+ * @return Bytes received, 0 at the end of the upload, DATACOMP_NET_ERROR if
+ *         receiving failed or the connection was closed for stalling, or
+ *         DATACOMP_STREAM_ERROR for corrupt compressed data
+ */
+static int receive_data(session_t *session, datacomp_reader_t *inflater, void *buffer, size_t buffer_size)
+{
+    int received = inflater ? datacomp_reader_receive(inflater, buffer, buffer_size)
+                            : net_receive(session->data_socket, buffer, buffer_size);
+    if (received > 0)
+    {
+        session_add_transfer_progress(session, (size_t)received);
+        return received;
+    }
+    if (received < 0 && !inflater)
+    {
+        return DATACOMP_NET_ERROR;
+    }
+
+    // The stall timer's shutdown looks like the end of the upload, which must not be stored as complete
+    if (received == 0 && session_is_transfer_stalled(session))
+    {
+        return DATACOMP_NET_ERROR;
+    }
+    return received;
+}
+
+/**
+ * @brief Ends the deflate stream of a transfer that succeeded so far and frees the writer.
+ * @param session The FTP session
+ * @param deflater Deflate writer, or NULL in stream mode
+ * @param status Transfer status so far
+ * @param what Name of the transfer for log messages
+ * @param path Transferred path
+ * @param bytes_sent Output: compressed bytes sent (unchanged in stream mode)
+ * @return The final transfer status
+ */
+static transfer_status_t close_deflater(session_t *session, datacomp_writer_t *deflater, transfer_status_t status,
+                                        const char *what, const char *path, long long *bytes_sent)
+{
+    if (!deflater)
+    {
+        return status;
+    }
+
+    if (status == TRANSFER_STATUS_OK && datacomp_writer_finish(deflater) != 0)
+    {
+        status = listing_send_failed(session, what, path);
+    }
+
+    long long bytes_in = 0;
+    datacomp_writer_get_totals(deflater, &bytes_in, bytes_sent);
+    LOG_DEBUG("%s compressed %lld bytes to %lld: %s", what, bytes_in, *bytes_sent, path);
+    datacomp_writer_destroy(deflater);
+    return status;
+}
+
+/**
+ * @brief Sends a byte range of an open file by copying through user-space buffers.
+ *
+ * The file is read ahead on the pipeline thread while the data is sent.
+ *
+ * @param session The FTP session
+ * @param deflater Deflate writer in MODE Z, NULL otherwise
+ * @param file Open file handle
+ * @param filepath File path (for logging)
+ * @param offset Starting byte offset
+ * @param length Number of bytes to send
+ * @param total_sent Output: bytes sent
+ * @return transfer_status_t value indicating success or the failure reason
+ */
+static transfer_status_t send_file_buffered(session_t *session, datacomp_writer_t *deflater, fs_file_t *file,
+                                            const char *filepath, long long offset, long long length,
+                                            long long *total_sent)
+{
+    *total_sent = 0;
+
+    if (fs_file_seek(file, offset) != 0)
+    {
+        LOG_ERROR("Failed to seek to offset %lld: %s", offset, filepath);
         return TRANSFER_STATUS_IO_ERROR;
     }
 
-    char *buffer = malloc(TRANSFER_BUFFER_SIZE);
-    if (!buffer)
+    file_reader_t reader;
+    iopipe_t *pipeline = start_read_ahead(&reader, file, filepath, offset, length);
+    if (!pipeline)
     {
-        LOG_ERROR("Failed to allocate transfer buffer");
         return TRANSFER_STATUS_INTERNAL_ERROR;
     }
 
-    long long remaining = file_size - offset;
-    long long current_offset = offset;
-    long long total_sent = 0;
     transfer_status_t status = TRANSFER_STATUS_OK;
 
-    LOG_INFO("Starting file transfer: %s (size: %lld, offset: %lld)",
-             filepath, file_size, offset);
-
-    while (remaining > 0)
+    while (1)
     {
         // Check if transfer has been aborted before attempting I/O
         if (session_should_abort_transfer(session))
@@ -88,26 +494,21 @@ transfer_status_t transfer_send_file(session_t *session, const char *filepath, l
             break;
         }
 
-        size_t to_read = (remaining > TRANSFER_BUFFER_SIZE) ? TRANSFER_BUFFER_SIZE : (size_t)remaining;
-
-        long long bytes_read = fs_read_file_chunk(filepath, buffer,
-                                                  current_offset, to_read);
+        const char *buffer;
+        long long bytes_read = iopipe_next(pipeline, &buffer);
 
         if (bytes_read < 0)
         {
-            LOG_ERROR("Failed to read file chunk at offset %lld", current_offset);
-            status = TRANSFER_STATUS_IO_ERROR;
+            status = TRANSFER_STATUS_IO_ERROR; // Logged by the read stage
             break;
         }
 
         if (bytes_read == 0)
         {
-            LOG_ERROR("Unexpected EOF while reading %s", filepath);
-            status = TRANSFER_STATUS_IO_ERROR;
             break;
         }
 
-        if (net_send_all(session->data_socket, buffer, (size_t)bytes_read) != 0)
+        if (send_paced(session, deflater, buffer, (size_t)bytes_read) != 0)
         {
             // Check if this error is due to abort
             if (session_should_abort_transfer(session))
@@ -124,12 +525,259 @@ transfer_status_t transfer_send_file(session_t *session, const char *filepath, l
             break;
         }
 
-        current_offset += bytes_read;
-        remaining -= bytes_read;
-        total_sent += bytes_read;
+        *total_sent += bytes_read;
+    }
+
+    stop_pipeline(pipeline, "File transfer", filepath);
+    return status;
+}
+
+/**
+ * @brief Sends a byte range of an open file from the file cache.
+ *
+ * @param session The FTP session
+ * @param deflater Deflate writer in MODE Z, NULL otherwise
+ * @param file Open file handle
+ * @param filepath File path (cache key and for logging)
+ * @param offset Starting byte offset
+ * @param length Number of bytes to send, -1 to the end of the file
+ * @param total_sent Output: bytes sent
+ * @param status Output: transfer result when the file was cached
+ * @return 0 if the file was sent from the cache (see status), -1 if it is not
+ *         cached and nothing was sent, so the caller should read the file.
+ */
+static int send_file_cached(session_t *session, datacomp_writer_t *deflater, fs_file_t *file,
+                            const char *filepath, long long offset, long long length,
+                            long long *total_sent, transfer_status_t *status)
+{
+    hotcache_file_t *entry = hotcache_acquire(filepath, file);
+    if (!entry)
+    {
+        return -1;
+    }
+
+    size_t size = 0;
+    const char *data = hotcache_data(entry, &size);
+    *total_sent = 0;
+    *status = TRANSFER_STATUS_OK;
+
+    // The entry was validated against the open file, which may have changed since it was stat'ed
+    if ((unsigned long long)offset > size || (length >= 0 && (unsigned long long)(offset + length) > size))
+    {
+        LOG_ERROR("Range at offset %lld exceeds file size %zu", offset, size);
+        *status = TRANSFER_STATUS_IO_ERROR;
+    }
+    else if (send_paced(session, deflater, data + offset,
+                        length >= 0 ? (size_t)length : size - (size_t)offset) != 0)
+    {
+        if (session_should_abort_transfer(session))
+        {
+            LOG_INFO("File transfer aborted by ABOR command (connection closed): %s", filepath);
+            *status = TRANSFER_STATUS_ABORTED;
+        }
+        else
+        {
+            int err = net_get_last_error();
+            LOG_ERROR("Failed to send data to client: %s (code=%d)", net_get_error_string(err), err);
+            *status = TRANSFER_STATUS_CONN_ERROR;
+        }
+    }
+    else
+    {
+        *total_sent = length >= 0 ? length : (long long)(size - (size_t)offset);
+        LOG_DEBUG("File sent from cache: %s", filepath);
+    }
+
+    hotcache_release(entry);
+    return 0;
+}
+
+/**
+ * @brief Sends a byte range of an open file with the kernel's zero-copy primitive.
+ *
+ * Data is sent in TRANSFER_ZERO_COPY_SLICE pieces so aborts are noticed
+ * between slices, or in smaller ones paced by the bandwidth scheduler when
+ * a rate limit applies. The kernel is asked to read each next slice while the
+ * current one is sent, as sendfile() itself reads synchronously.
+ *
+ * @param session The FTP session
+ * @param file Open file handle
+ * @param filepath File path (for logging)
+ * @param offset Starting byte offset
+ * @param length Number of bytes to send
+ * @param total_sent Output: bytes sent
+ * @param status Output: transfer result when the range was handled
+ * @return 0 if the range was handled (see status), -1 if zero-copy is unavailable
+ *         and nothing was sent, so the caller should fall back to copying.
+ */
+static int send_file_zero_copy(session_t *session, fs_file_t *file, const char *filepath,
+                               long long offset, long long length,
+                               long long *total_sent, transfer_status_t *status)
+{
+    long long remaining = length;
+    long long current_offset = offset;
+
+    *total_sent = 0;
+    *status = TRANSFER_STATUS_OK;
+
+    fs_file_advise(file, offset, length, FS_ADVICE_SEQUENTIAL);
+
+    while (remaining > 0)
+    {
+        // Check if transfer has been aborted before attempting I/O
+        if (session_should_abort_transfer(session))
+        {
+            LOG_INFO("File transfer aborted: %s", filepath);
+            *status = TRANSFER_STATUS_ABORTED;
+            break;
+        }
+
+        long long slice = (long long)ratelimit_chunk_size(session->limiter, TRANSFER_ZERO_COPY_SLICE);
+        if (slice > remaining)
+        {
+            slice = remaining;
+        }
+
+        if (remaining > slice)
+        {
+            long long next = remaining - slice;
+            fs_file_advise(file, current_offset + slice, next > slice ? slice : next, FS_ADVICE_WILLNEED);
+        }
+
+        long long sent = net_send_file(session->data_socket, file, current_offset, slice);
+
+        if (sent == NET_SENDFILE_UNSUPPORTED)
+        {
+            if (*total_sent == 0)
+            {
+                LOG_DEBUG("Zero-copy send unavailable for %s, using buffered copy", filepath);
+                return -1;
+            }
+            sent = -1;
+        }
+
+        if (sent < 0)
+        {
+            // Check if this error is due to abort
+            if (session_should_abort_transfer(session))
+            {
+                LOG_INFO("File transfer aborted by ABOR command (connection closed): %s", filepath);
+                *status = TRANSFER_STATUS_ABORTED;
+            }
+            else
+            {
+                int err = net_get_last_error();
+                LOG_ERROR("Failed to send file to client: %s (code=%d)", net_get_error_string(err), err);
+                *status = TRANSFER_STATUS_CONN_ERROR;
+            }
+            break;
+        }
+
+        current_offset += sent;
+        remaining -= sent;
+        *total_sent += sent;
+        session_add_transfer_progress(session, (size_t)sent);
+        pace_transfer(session, (size_t)sent); // An abort is noticed before the next slice
+
+        if (sent < slice)
+        {
+            LOG_ERROR("Unexpected EOF while reading %s", filepath);
+            *status = TRANSFER_STATUS_IO_ERROR;
+            break;
+        }
     }
 
-    free(buffer);
+    return 0;
+}
+
+/**
+ * @brief Opens a file for a download and gets its size.
+ *
+ * @param file Receives the open file
+ * @param filepath File to open
+ * @param file_size Receives the size of the opened file
+ * @return 0 on success, -1 on error (file closed)
+ */
+static int open_download(fs_file_t *file, const char *filepath, long long *file_size)
+{
+    if (fs_file_open(file, filepath, FS_OPEN_READ) != 0)
+    {
+        LOG_ERROR("Cannot open file: %s", filepath);
+        return -1;
+    }
+
+    *file_size = fs_file_size(file);
+    if (*file_size < 0)
+    {
+        LOG_ERROR("Cannot get file size: %s", filepath);
+        fs_file_close(file);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sends an open file in binary mode.
+ *
+ * @param session The FTP session
+ * @param file Open file, left open for the caller to close
+ * @param filepath File path (for logging)
+ * @param file_size Size of the open file
+ * @param offset Starting byte offset
+ * @param length Number of bytes to send (RANG), -1 to the end of the file
+ * @return transfer_status_t value indicating success or the failure reason
+ */
+static transfer_status_t send_open_file(session_t *session, fs_file_t *file, const char *filepath,
+                                        long long file_size, long long offset, long long length)
+{
+    // Verify data socket is valid
+    if (session->data_socket == INVALID_SOCKET_T)
+    {
+        LOG_ERROR("Data socket is not open for SEND transfer (data_mode=%d, client=%s:%u)",
+                  session->data_mode, session->client_ip, session->client_port);
+        return TRANSFER_STATUS_CONN_ERROR;
+    }
+
+    if (offset > file_size || (length >= 0 && offset + length > file_size))
+    {
+        LOG_ERROR("Range at offset %lld exceeds file size %lld", offset, file_size);
+        return TRANSFER_STATUS_IO_ERROR;
+    }
+
+    long long remaining = length >= 0 ? length : file_size - offset;
+    long long total_sent = 0;
+    transfer_status_t status = TRANSFER_STATUS_OK;
+    int handled = 0;
+
+    datacomp_writer_t *deflater = NULL;
+    if (open_deflater(session, 1, &deflater) != 0)
+    {
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    LOG_INFO("Starting file transfer: %s (size: %lld, offset: %lld, length: %lld)",
+             filepath, file_size, offset, remaining);
+
+    // Small popular files are sent from memory without touching the file
+    if (hotcache_is_enabled())
+    {
+        handled = (send_file_cached(session, deflater, file, filepath, offset, length, &total_sent, &status) == 0);
+    }
+
+    // TLS sockets take this path only with kernel TLS, otherwise the zero-copy send reports
+    // it as unsupported and the buffered path encrypts. MODE Z has to see the data to compress it.
+    if (!handled && !deflater)
+    {
+        handled = (send_file_zero_copy(session, file, filepath, offset, remaining, &total_sent, &status) == 0);
+    }
+
+    if (!handled)
+    {
+        status = send_file_buffered(session, deflater, file, filepath, offset, remaining, &total_sent);
+    }
+
+    status = close_deflater(session, deflater, status, "File transfer", filepath, &total_sent);
 
     if (status == TRANSFER_STATUS_OK)
     {
@@ -149,7 +797,28 @@ transfer_status_t transfer_send_file(session_t *session, const char *filepath, l
     return status;
 }
 
-transfer_status_t transfer_receive_file(session_t *session, const char *filepath, long long offset)
+transfer_status_t transfer_send_file(session_t *session, const char *filepath, long long offset)
+{
+    if (!session || !filepath)
+    {
+        LOG_ERROR("Invalid parameters for transfer_send_file");
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    fs_file_t file;
+    long long file_size;
+    if (open_download(&file, filepath, &file_size) != 0)
+    {
+        return TRANSFER_STATUS_IO_ERROR;
+    }
+
+    transfer_status_t status = send_open_file(session, &file, filepath, file_size, offset, -1);
+    fs_file_close(&file);
+    return status;
+}
+
+transfer_status_t transfer_receive_file(session_t *session, const char *filepath, long long offset,
+                                        long long size_hint)
 {
     if (!session || !filepath)
     {
@@ -165,10 +834,19 @@ transfer_status_t transfer_receive_file(session_t *session, const char *filepath
         return TRANSFER_STATUS_CONN_ERROR;
     }
 
-    char *buffer = malloc(TRANSFER_BUFFER_SIZE);
-    if (!buffer)
+    fs_file_t file;
+    if (open_upload(&file, filepath, offset, size_hint) != 0)
     {
-        LOG_ERROR("Failed to allocate transfer buffer");
+        return TRANSFER_STATUS_IO_ERROR;
+    }
+
+    file_writer_t writer;
+    iopipe_t *pipeline = start_write_behind(&writer, &file, filepath, offset, TRANSFER_BUFFER_SIZE);
+    datacomp_reader_t *inflater = NULL;
+    if (!pipeline || open_inflater(session, &inflater) != 0)
+    {
+        iopipe_destroy(pipeline);
+        fs_file_close(&file);
         return TRANSFER_STATUS_INTERNAL_ERROR;
     }
 
@@ -187,8 +865,15 @@ transfer_status_t transfer_receive_file(session_t *session, const char *filepath
             break;
         }
 
-        int bytes_received = net_receive(session->data_socket, buffer,
-                                         TRANSFER_BUFFER_SIZE);
+        char *buffer = iopipe_acquire(pipeline);
+        if (!buffer)
+        {
+            status = TRANSFER_STATUS_IO_ERROR; // Logged by the write stage
+            break;
+        }
+
+        int bytes_received = receive_data(session, inflater, buffer,
+                                          ratelimit_chunk_size(session->limiter, TRANSFER_BUFFER_SIZE));
 
         if (bytes_received < 0)
         {
@@ -198,6 +883,10 @@ transfer_status_t transfer_receive_file(session_t *session, const char *filepath
                 LOG_INFO("File reception aborted by ABOR command (connection closed): %s", filepath);
                 status = TRANSFER_STATUS_ABORTED;
             }
+            else if (bytes_received == DATACOMP_STREAM_ERROR)
+            {
+                status = TRANSFER_STATUS_CONN_ERROR;
+            }
             else
             {
                 int err = net_get_last_error();
@@ -219,22 +908,30 @@ transfer_status_t transfer_receive_file(session_t *session, const char *filepath
             break;
         }
 
-        long long bytes_written = fs_write_file_chunk(filepath, buffer,
-                                                      offset + total_received,
-                                                      bytes_received);
-
-        if (bytes_written != bytes_received)
+        if (iopipe_submit(pipeline, (size_t)bytes_received) != 0)
         {
-            LOG_ERROR("Failed to write to file at offset %lld",
-                      offset + total_received);
             status = TRANSFER_STATUS_IO_ERROR;
             break;
         }
 
         total_received += bytes_received;
+        pace_transfer(session, (size_t)bytes_received); // An abort is noticed at the top of the loop
     }
 
-    free(buffer);
+    // Data received before an abort or error is still written, as without the pipeline
+    if (iopipe_finish(pipeline) != 0 && status == TRANSFER_STATUS_OK)
+    {
+        status = TRANSFER_STATUS_IO_ERROR;
+    }
+    stop_pipeline(pipeline, "File reception", filepath);
+    if (inflater)
+    {
+        // Statistics count network bytes
+        datacomp_reader_get_totals(inflater, &total_received, NULL);
+        datacomp_reader_destroy(inflater);
+    }
+
+    status = close_upload(&file, filepath, status);
 
     if (status == TRANSFER_STATUS_OK)
     {
@@ -254,14 +951,20 @@ transfer_status_t transfer_receive_file(session_t *session, const char *filepath
     return status;
 }
 
-transfer_status_t transfer_send_file_ascii(session_t *session, const char *filepath, long long offset)
+/**
+ * @brief Sends an open file in ASCII mode, converting LF to CRLF.
+ *
+ * @param session The FTP session
+ * @param file Open file, left open for the caller to close
+ * @param filepath File path (for logging)
+ * @param file_size Size of the open file
+ * @param offset Starting byte offset
+ * @param length Number of file bytes to send (RANG), -1 to the end of the file
+ * @return transfer_status_t value indicating success or the failure reason
+ */
+static transfer_status_t send_open_file_ascii(session_t *session, fs_file_t *file, const char *filepath,
+                                              long long file_size, long long offset, long long length)
 {
-    if (!session || !filepath)
-    {
-        LOG_ERROR("Invalid parameters for transfer_send_file_ascii");
-        return TRANSFER_STATUS_INTERNAL_ERROR;
-    }
-
     // Verify data socket is valid
     if (session->data_socket == INVALID_SOCKET_T)
     {
@@ -269,38 +972,38 @@ transfer_status_t transfer_send_file_ascii(session_t *session, const char *filep
         return TRANSFER_STATUS_CONN_ERROR;
     }
 
-    long long file_size = fs_get_file_size(filepath);
-    if (file_size < 0)
+    if (offset > file_size || (length >= 0 && offset + length > file_size))
     {
-        LOG_ERROR("Cannot get file size: %s", filepath);
+        LOG_ERROR("Range at offset %lld exceeds file size %lld", offset, file_size);
         return TRANSFER_STATUS_IO_ERROR;
     }
 
-    if (offset > file_size)
+    if (fs_file_seek(file, offset) != 0)
     {
-        LOG_ERROR("Offset %lld exceeds file size %lld", offset, file_size);
+        LOG_ERROR("Failed to seek to offset %lld: %s", offset, filepath);
         return TRANSFER_STATUS_IO_ERROR;
     }
 
-    char *read_buffer = malloc(TRANSFER_BUFFER_SIZE);
+    file_reader_t reader;
+    long long remaining = length >= 0 ? length : file_size - offset;
+    iopipe_t *pipeline = start_read_ahead(&reader, file, filepath, offset, remaining);
     char *write_buffer = malloc(TRANSFER_BUFFER_SIZE * 2); // Max 2x for CRLF conversion
-    if (!read_buffer || !write_buffer)
+    datacomp_writer_t *deflater = NULL;
+    if (!pipeline || !write_buffer || open_deflater(session, 1, &deflater) != 0)
     {
         LOG_ERROR("Failed to allocate transfer buffers");
-        free(read_buffer);
+        iopipe_destroy(pipeline);
         free(write_buffer);
         return TRANSFER_STATUS_INTERNAL_ERROR;
     }
 
-    long long remaining = file_size - offset;
-    long long current_offset = offset;
     long long total_sent = 0;
     transfer_status_t status = TRANSFER_STATUS_OK;
 
-    LOG_INFO("Starting ASCII file transfer: %s (size: %lld, offset: %lld)",
-             filepath, file_size, offset);
+    LOG_INFO("Starting ASCII file transfer: %s (size: %lld, offset: %lld, length: %lld)",
+             filepath, file_size, offset, remaining);
 
-    while (remaining > 0)
+    while (1)
     {
         // Check if transfer has been aborted before attempting I/O
         if (session_should_abort_transfer(session))
@@ -310,26 +1013,21 @@ transfer_status_t transfer_send_file_ascii(session_t *session, const char *filep
             break;
         }
 
-        size_t to_read = (remaining > TRANSFER_BUFFER_SIZE) ? TRANSFER_BUFFER_SIZE : (size_t)remaining;
-
-        long long bytes_read = fs_read_file_chunk(filepath, read_buffer,
-                                                  current_offset, to_read);
+        const char *read_buffer;
+        long long bytes_read = iopipe_next(pipeline, &read_buffer);
 
         if (bytes_read < 0)
         {
-            LOG_ERROR("Failed to read file chunk at offset %lld", current_offset);
-            status = TRANSFER_STATUS_IO_ERROR;
+            status = TRANSFER_STATUS_IO_ERROR; // Logged by the read stage
             break;
         }
 
         if (bytes_read == 0)
         {
-            LOG_ERROR("Unexpected EOF while reading %s in ASCII mode", filepath);
-            status = TRANSFER_STATUS_IO_ERROR;
             break;
         }
 
-        long long converted_bytes = lf_to_crlf(read_buffer, bytes_read, write_buffer, TRANSFER_BUFFER_SIZE * 2);
+        long long converted_bytes = lineconv_lf_to_crlf(read_buffer, bytes_read, write_buffer, TRANSFER_BUFFER_SIZE * 2);
         if (converted_bytes < 0)
         {
             LOG_ERROR("Failed to convert LF to CRLF for sending");
@@ -337,7 +1035,7 @@ transfer_status_t transfer_send_file_ascii(session_t *session, const char *filep
             break;
         }
 
-        if (net_send_all(session->data_socket, write_buffer, (size_t)converted_bytes) != 0)
+        if (send_paced(session, deflater, write_buffer, (size_t)converted_bytes) != 0)
         {
             // Check if this error is due to abort
             if (session_should_abort_transfer(session))
@@ -354,13 +1052,12 @@ transfer_status_t transfer_send_file_ascii(session_t *session, const char *filep
             break;
         }
 
-        current_offset += bytes_read;
-        remaining -= bytes_read;
         total_sent += converted_bytes; // total_sent counts bytes sent over network
     }
 
-    free(read_buffer);
+    stop_pipeline(pipeline, "ASCII file transfer", filepath);
     free(write_buffer);
+    status = close_deflater(session, deflater, status, "ASCII file transfer", filepath, &total_sent);
 
     if (status == TRANSFER_STATUS_OK)
     {
@@ -372,15 +1069,36 @@ transfer_status_t transfer_send_file_ascii(session_t *session, const char *filep
         session->files_downloaded++;
         pthread_mutex_unlock(&session->lock);
     }
-    else
+    else
+    {
+        LOG_ERROR("ASCII file transfer failed after %lld bytes", total_sent);
+    }
+
+    return status;
+}
+
+transfer_status_t transfer_send_file_ascii(session_t *session, const char *filepath, long long offset)
+{
+    if (!session || !filepath)
+    {
+        LOG_ERROR("Invalid parameters for transfer_send_file_ascii");
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    fs_file_t file;
+    long long file_size;
+    if (open_download(&file, filepath, &file_size) != 0)
     {
-        LOG_ERROR("ASCII file transfer failed after %lld bytes", total_sent);
+        return TRANSFER_STATUS_IO_ERROR;
     }
 
+    transfer_status_t status = send_open_file_ascii(session, &file, filepath, file_size, offset, -1);
+    fs_file_close(&file);
     return status;
 }
 
-transfer_status_t transfer_receive_file_ascii(session_t *session, const char *filepath, long long offset)
+transfer_status_t transfer_receive_file_ascii(session_t *session, const char *filepath, long long offset,
+                                              long long size_hint)
 {
     if (!session || !filepath)
     {
@@ -395,19 +1113,31 @@ transfer_status_t transfer_receive_file_ascii(session_t *session, const char *fi
         return TRANSFER_STATUS_CONN_ERROR;
     }
 
+    fs_file_t file;
+    if (open_upload(&file, filepath, offset, size_hint) != 0)
+    {
+        return TRANSFER_STATUS_IO_ERROR;
+    }
+
+    // Pipeline buffers hold converted data, plus a CR held from the previous chunk
     char *read_buffer = malloc(TRANSFER_BUFFER_SIZE);
-    char *write_buffer = malloc(TRANSFER_BUFFER_SIZE); // Output buffer for converted data
-    if (!read_buffer || !write_buffer)
+    file_writer_t writer;
+    iopipe_t *pipeline = start_write_behind(&writer, &file, filepath, offset, TRANSFER_BUFFER_SIZE + 1);
+    datacomp_reader_t *inflater = NULL;
+    if (!read_buffer || !pipeline || open_inflater(session, &inflater) != 0)
     {
         LOG_ERROR("Failed to allocate transfer buffers");
         free(read_buffer);
-        free(write_buffer);
+        iopipe_destroy(pipeline);
+        fs_file_close(&file);
         return TRANSFER_STATUS_INTERNAL_ERROR;
     }
 
     long long total_received = 0;
     long long total_written = 0;
     transfer_status_t status = TRANSFER_STATUS_OK;
+    lineconv_state_t conv_state; // CRLF may be split across receives
+    lineconv_state_init(&conv_state);
 
     LOG_INFO("Starting ASCII file reception: %s (offset: %lld)", filepath, offset);
 
@@ -421,8 +1151,8 @@ transfer_status_t transfer_receive_file_ascii(session_t *session, const char *fi
             break;
         }
 
-        int bytes_received = net_receive(session->data_socket, read_buffer,
-                                         TRANSFER_BUFFER_SIZE);
+        int bytes_received = receive_data(session, inflater, read_buffer,
+                                          ratelimit_chunk_size(session->limiter, TRANSFER_BUFFER_SIZE));
 
         if (bytes_received < 0)
         {
@@ -432,6 +1162,10 @@ transfer_status_t transfer_receive_file_ascii(session_t *session, const char *fi
                 LOG_INFO("ASCII file reception aborted by ABOR command (connection closed): %s", filepath);
                 status = TRANSFER_STATUS_ABORTED;
             }
+            else if (bytes_received == DATACOMP_STREAM_ERROR)
+            {
+                status = TRANSFER_STATUS_CONN_ERROR;
+            }
             else
             {
                 int err = net_get_last_error();
@@ -455,16 +1189,23 @@ transfer_status_t transfer_receive_file_ascii(session_t *session, const char *fi
 
         total_received += bytes_received;
 
+        char *write_buffer = iopipe_acquire(pipeline);
+        if (!write_buffer)
+        {
+            status = TRANSFER_STATUS_IO_ERROR; // Logged by the write stage
+            break;
+        }
+
         long long bytes_to_write;
-        const char *data_to_write;
 
 #ifdef _WIN32
         // On Windows, No conversion needed for received ASCII.
+        memcpy(write_buffer, read_buffer, (size_t)bytes_received);
         bytes_to_write = bytes_received;
-        data_to_write = read_buffer;
 #else
         // On Unix, convert CRLF to LF.
-        long long converted_bytes = crlf_to_lf(read_buffer, bytes_received, write_buffer, TRANSFER_BUFFER_SIZE);
+        long long converted_bytes = lineconv_crlf_to_lf(&conv_state, read_buffer, bytes_received,
+                                                        write_buffer, TRANSFER_BUFFER_SIZE + 1);
         if (converted_bytes < 0)
         {
             LOG_ERROR("Failed to convert CRLF to LF for receiving");
@@ -472,26 +1213,50 @@ transfer_status_t transfer_receive_file_ascii(session_t *session, const char *fi
             break;
         }
         bytes_to_write = converted_bytes;
-        data_to_write = write_buffer;
 #endif
 
-        long long bytes_written = fs_write_file_chunk(filepath, data_to_write,
-                                                      offset + total_written,
-                                                      bytes_to_write);
-
-        if (bytes_written != bytes_to_write)
+        if (iopipe_submit(pipeline, (size_t)bytes_to_write) != 0)
         {
-            LOG_ERROR("Failed to write to file at offset %lld in ASCII mode",
-                      offset + total_written);
             status = TRANSFER_STATUS_IO_ERROR;
             break;
         }
 
-        total_written += bytes_written;
+        total_written += bytes_to_write;
+        pace_transfer(session, (size_t)bytes_received); // An abort is noticed at the top of the loop
+    }
+
+    // A CR at the very end of the upload was a lone CR
+    if (status == TRANSFER_STATUS_OK)
+    {
+        char *write_buffer = iopipe_acquire(pipeline);
+        if (!write_buffer)
+        {
+            status = TRANSFER_STATUS_IO_ERROR;
+        }
+        else if (lineconv_crlf_to_lf_finish(&conv_state, write_buffer, 1) == 1)
+        {
+            if (iopipe_submit(pipeline, 1) != 0)
+                status = TRANSFER_STATUS_IO_ERROR;
+            else
+                total_written++;
+        }
     }
 
+    // Data received before an abort or error is still written, as without the pipeline
+    if (iopipe_finish(pipeline) != 0 && status == TRANSFER_STATUS_OK)
+    {
+        status = TRANSFER_STATUS_IO_ERROR;
+    }
+    stop_pipeline(pipeline, "ASCII file reception", filepath);
     free(read_buffer);
-    free(write_buffer);
+    if (inflater)
+    {
+        // Statistics count network bytes
+        datacomp_reader_get_totals(inflater, &total_received, NULL);
+        datacomp_reader_destroy(inflater);
+    }
+
+    status = close_upload(&file, filepath, status);
 
     if (status == TRANSFER_STATUS_OK)
     {
@@ -563,28 +1328,26 @@ static int format_list_line(const fs_file_info_t *info,
     char user_name[32] = "ftp";
     char group_name[32] = "ftp";
 
-#ifndef _WIN32
-    struct passwd *pw = getpwuid(info->uid);
-    if (pw)
-        snprintf(user_name, sizeof(user_name), "%s", pw->pw_name);
-    else
-        snprintf(user_name, sizeof(user_name), "%u", info->uid);
-
-    struct group *gr = getgrgid(info->gid);
-    if (gr)
-        snprintf(group_name, sizeof(group_name), "%s", gr->gr_name);
-    else
-        snprintf(group_name, sizeof(group_name), "%u", info->gid);
-#endif
+    // Cached lookups; on Windows these fail and the "ftp" defaults stay
+    fs_get_user_name(info->uid, user_name, sizeof(user_name));
+    fs_get_group_name(info->gid, group_name, sizeof(group_name));
 
-    struct tm *tm_info = localtime(&info->last_modified);
-    if (!tm_info)
+    // localtime() shares a static buffer between transfer threads
+    struct tm tm_info;
+#ifdef _WIN32
+    if (localtime_s(&tm_info, &info->last_modified) != 0)
+    {
+        return -1;
+    }
+#else
+    if (!localtime_r(&info->last_modified, &tm_info))
     {
         return -1;
     }
+#endif
 
     char date_str[32];
-    strftime(date_str, sizeof(date_str), "%b %d %H:%M", tm_info);
+    strftime(date_str, sizeof(date_str), "%b %d %H:%M", &tm_info);
 
     int written;
     if (info->type == FS_TYPE_SYMLINK && info->link_target[0] != '\0')
@@ -608,183 +1371,681 @@ static int format_list_line(const fs_file_info_t *info,
     return (written >= 0 && written < (int)buffer_size) ? 0 : -1;
 }
 
+/**
+ * @brief Appends a formatted line to the listing being collected for the cache.
+ * @param listing Growable buffer (may be reallocated).
+ * @param used Bytes used in the buffer.
+ * @param capacity Buffer capacity.
+ * @param line Line to append.
+ * @param length Line length.
+ * @return 0 on success, -1 if the listing is too large or memory ran out (collection stops).
+ */
+static int append_listing(char **listing, size_t *used, size_t *capacity, const char *line, size_t length)
+{
+    if (*used + length > LISTCACHE_MAX_LISTING)
+    {
+        return -1;
+    }
+
+    if (*used + length > *capacity)
+    {
+        size_t new_capacity = *capacity ? *capacity * 2 : 16384;
+        while (new_capacity < *used + length)
+        {
+            new_capacity *= 2;
+        }
+        char *grown = (char *)realloc(*listing, new_capacity);
+        if (!grown)
+        {
+            return -1;
+        }
+        *listing = grown;
+        *capacity = new_capacity;
+    }
+
+    memcpy(*listing + *used, line, length);
+    *used += length;
+    return 0;
+}
+
+/**
+ * @brief Sends a listing served from the listing cache.
+ * @param session Pointer to the session structure.
+ * @param deflater Deflate writer in MODE Z, NULL otherwise.
+ * @param dirpath Directory path (for logging).
+ * @param data Cached listing.
+ * @param length Listing length.
+ * @return Transfer status code.
+ */
+static transfer_status_t send_cached_listing(session_t *session, datacomp_writer_t *deflater, const char *dirpath,
+                                             const char *data, size_t length)
+{
+    if (send_data(session, deflater, data, length) != 0)
+    {
+        if (session_should_abort_transfer(session))
+        {
+            LOG_INFO("Directory listing aborted by ABOR command (connection closed): %s", dirpath);
+            return TRANSFER_STATUS_ABORTED;
+        }
+
+        int err = net_get_last_error();
+        LOG_ERROR("Failed to send listing: %s (code=%d)", net_get_error_string(err), err);
+        return TRANSFER_STATUS_CONN_ERROR;
+    }
+
+    LOG_INFO("Sent cached directory listing: %zu bytes", length);
+    return TRANSFER_STATUS_OK;
+}
+
+/**
+ * @brief Maps a failed listing send to a transfer status.
+ * @param session Pointer to the session structure.
+ * @param what Name of the listing for log messages ("Directory listing", "Name list transfer").
+ * @param dirpath Path of the listed directory.
+ * @return TRANSFER_STATUS_ABORTED if ABOR closed the connection, TRANSFER_STATUS_CONN_ERROR otherwise.
+ */
+static transfer_status_t listing_send_failed(session_t *session, const char *what, const char *dirpath)
+{
+    if (session_should_abort_transfer(session))
+    {
+        LOG_INFO("%s aborted by ABOR command (connection closed): %s", what, dirpath);
+        return TRANSFER_STATUS_ABORTED;
+    }
+
+    int err = net_get_last_error();
+    LOG_ERROR("%s failed to send: %s (code=%d)", what, net_get_error_string(err), err);
+    return TRANSFER_STATUS_CONN_ERROR;
+}
+
 /**
  * @brief Send a directory listing to the client.
  * @param session Pointer to the session structure.
  * @param dirpath Path to the directory to list.
  * @param filter_name Optional filter for a specific file name.
+ * @param style Line format.
  * @return Transfer status code.
  */
 static transfer_status_t send_listing(session_t *session,
                                       const char *dirpath,
-                                      const char *filter_name)
+                                      const char *filter_name,
+                                      listing_style_t style)
 {
-    fs_file_info_t file_list[1024];
-    int count = fs_list_directory(dirpath, file_list, 1024);
+    // Full LIST listings go through the listing cache when it is enabled.
+    // MLSD lines depend on the session's fact selection, so they are not cached.
+    int use_cache = (filter_name == NULL) && style == LISTING_LS && listcache_is_enabled();
+    unsigned int facts = 0;
+    auth_permission_t permissions = AUTH_PERM_NONE;
+    if (style == LISTING_MLSD)
+    {
+        pthread_mutex_lock(&session->lock);
+        facts = session->mlst_facts;
+        permissions = session->permissions;
+        pthread_mutex_unlock(&session->lock);
+    }
+    time_t dir_mtime = -1;
+    unsigned long cache_generation = 0;
+    long long compressed_bytes = 0;
 
-    if (count < 0)
+    datacomp_writer_t *deflater = NULL;
+    if (open_deflater(session, 0, &deflater) != 0)
     {
-        LOG_ERROR("Failed to list directory: %s", dirpath);
-        return TRANSFER_STATUS_IO_ERROR;
+        return TRANSFER_STATUS_INTERNAL_ERROR;
     }
 
+    if (use_cache)
+    {
+        cache_generation = listcache_get_generation();
+        dir_mtime = fs_get_directory_mtime(dirpath);
+
+        char *cached = NULL;
+        size_t cached_length = 0;
+        if (dir_mtime >= 0 && listcache_lookup(dirpath, dir_mtime, &cached, &cached_length) == 0)
+        {
+            transfer_status_t status = send_cached_listing(session, deflater, dirpath, cached, cached_length);
+            free(cached);
+            return close_deflater(session, deflater, status, "Directory listing", dirpath, &compressed_bytes);
+        }
+    }
+
+    // Entries are formatted and sent as they are read, so memory use does not grow with the directory
+    fs_file_info_t entry;
+    fs_dir_t *dir = NULL;
+
+    if (filter_name)
+    {
+        // A single entry needs no directory scan
+        if (fs_get_entry_info(dirpath, filter_name, &entry) != 0)
+        {
+            LOG_DEBUG("Entry '%s' not found in %s", filter_name, dirpath);
+            datacomp_writer_destroy(deflater);
+            return TRANSFER_STATUS_IO_ERROR;
+        }
+    }
+    else
+    {
+        dir = fs_dir_open(dirpath, 0);
+        if (!dir)
+        {
+            LOG_ERROR("Failed to list directory: %s", dirpath);
+            datacomp_writer_destroy(deflater);
+            return TRANSFER_STATUS_IO_ERROR;
+        }
+    }
+
+    // Lines are gathered and sent in NET_SEND_BUFFER_SIZE batches (the deflate stream buffers by itself)
+    net_send_buffer_t *out = (net_send_buffer_t *)malloc(sizeof(net_send_buffer_t));
+    if (!out)
+    {
+        LOG_ERROR("Failed to allocate listing output buffer");
+        fs_dir_close(dir);
+        datacomp_writer_destroy(deflater);
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+    net_send_buffer_init(out, session->data_socket);
+
     int entries_sent = 0;
     char line_buffer[1024];
+    char *listing = NULL;
+    size_t listing_used = 0;
+    size_t listing_capacity = 0;
+    transfer_status_t status = TRANSFER_STATUS_OK;
+
+    for (;;)
+    {
+        // Check if transfer has been aborted
+        if (session_should_abort_transfer(session))
+        {
+            LOG_INFO("Directory listing aborted: %s", dirpath);
+            status = TRANSFER_STATUS_ABORTED;
+            break;
+        }
+
+        if (dir)
+        {
+            int rc = fs_dir_next(dir, &entry);
+            if (rc == 0)
+            {
+                break;
+            }
+            if (rc < 0)
+            {
+                LOG_ERROR("Failed to read directory: %s", dirpath);
+                status = TRANSFER_STATUS_IO_ERROR;
+                break;
+            }
+        }
+
+        int formatted;
+        if (style == LISTING_MLSD)
+        {
+            // The facts leave room for the name and CRLF in the line buffer
+            int length = mlsx_format_entry(&entry, facts, permissions, entry.name, line_buffer, sizeof(line_buffer) - 2);
+            formatted = (length >= 0) ? 0 : -1;
+            if (length >= 0)
+            {
+                memcpy(line_buffer + length, "\r\n", 3);
+            }
+        }
+        else
+        {
+            formatted = format_list_line(&entry, line_buffer, sizeof(line_buffer));
+        }
+
+        if (formatted != 0)
+        {
+            LOG_ERROR("Failed to format listing line for %s", entry.name);
+            status = TRANSFER_STATUS_INTERNAL_ERROR;
+            break;
+        }
+
+        size_t line_length = strlen(line_buffer);
+        int send_rc = deflater ? datacomp_writer_write(deflater, line_buffer, line_length)
+                               : net_send_buffer_append(out, line_buffer, line_length);
+        if (send_rc != 0)
+        {
+            status = listing_send_failed(session, "Directory listing", dirpath);
+            break;
+        }
+
+        if (use_cache && append_listing(&listing, &listing_used, &listing_capacity, line_buffer, line_length) != 0)
+        {
+            // Too large to cache, keep sending without collecting
+            use_cache = 0;
+        }
+
+        entries_sent++;
+
+        // A filtered listing has exactly one entry
+        if (!dir)
+        {
+            break;
+        }
+    }
+
+    fs_dir_close(dir);
+
+    if (status == TRANSFER_STATUS_OK && net_send_buffer_flush(out) != 0)
+    {
+        status = listing_send_failed(session, "Directory listing", dirpath);
+    }
+    unsigned long sends = out->sends;
+    free(out);
+    status = close_deflater(session, deflater, status, "Directory listing", dirpath, &compressed_bytes);
+
+    if (status == TRANSFER_STATUS_OK && use_cache && listing_used > 0)
+    {
+        listcache_store(dirpath, dir_mtime, cache_generation, listing, listing_used);
+    }
+    free(listing);
+
+    if (status != TRANSFER_STATUS_OK)
+    {
+        return status;
+    }
+
+    LOG_INFO("Sent directory listing: %d entries in %lu sends", entries_sent, sends);
+    return TRANSFER_STATUS_OK;
+}
+
+/**
+ * @brief Sends the listing of a directory, or the line of a single file.
+ *
+ * @param session The FTP session
+ * @param path Absolute filesystem path to list
+ * @param st Metadata of path, decides between the two
+ * @return transfer_status_t indicating success or failure reason
+ */
+static transfer_status_t send_list_path(session_t *session, const char *path, const fs_stat_t *st)
+{
+    // Verify data socket is valid
+    if (session->data_socket == INVALID_SOCKET_T)
+    {
+        LOG_ERROR("Data socket is not open for transfer");
+        return TRANSFER_STATUS_CONN_ERROR;
+    }
+
+    if (st->type == FS_TYPE_DIR)
+    {
+        return send_listing(session, path, NULL, LISTING_LS);
+    }
+
+    // It's a file, extract parent directory and ls that file only
+    char filename[SESSION_MAX_PATH];
+    const char *name_part = fs_extract_filename(path);
+    if (!name_part || name_part[0] == '\0')
+    {
+        LOG_ERROR("Failed to extract filename for LIST: %s", path);
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    strncpy(filename, name_part, sizeof(filename) - 1);
+    filename[sizeof(filename) - 1] = '\0';
+
+    char parent_dir[SESSION_MAX_PATH];
+    if (fs_get_parent_directory(path, parent_dir, sizeof(parent_dir)) != 0)
+    {
+        LOG_ERROR("Failed to determine parent directory for LIST: %s", path);
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    return send_listing(session, parent_dir, filename, LISTING_LS);
+}
+
+transfer_status_t transfer_send_list(session_t *session, const char *path)
+{
+    if (!session || !path)
+    {
+        LOG_ERROR("Invalid parameters for transfer_send_list");
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    fs_stat_t st;
+    if (fs_stat(path, &st) != 0)
+    {
+        LOG_ERROR("LIST path does not exist: %s", path);
+        return TRANSFER_STATUS_IO_ERROR;
+    }
+
+    return send_list_path(session, path, &st);
+}
+
+transfer_status_t transfer_send_mlsd(session_t *session, const char *dirpath)
+{
+    if (!session || !dirpath)
+    {
+        LOG_ERROR("Invalid parameters for transfer_send_mlsd");
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    // Verify data socket is valid
+    if (session->data_socket == INVALID_SOCKET_T)
+    {
+        LOG_ERROR("Data socket is not open for transfer");
+        return TRANSFER_STATUS_CONN_ERROR;
+    }
+
+    return send_listing(session, dirpath, NULL, LISTING_MLSD);
+}
+
+transfer_status_t transfer_send_nlst(session_t *session, const char *dirpath)
+{
+    if (!session || !dirpath)
+    {
+        LOG_ERROR("Invalid parameters for transfer_send_nlst");
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+
+    // Names only: NLST does not need a stat of every entry
+    fs_dir_t *dir = fs_dir_open(dirpath, FS_DIR_NAMES_ONLY);
+    if (!dir)
+    {
+        LOG_ERROR("Failed to list directory: %s", dirpath);
+        return TRANSFER_STATUS_IO_ERROR;
+    }
+
+    datacomp_writer_t *deflater = NULL;
+    net_send_buffer_t *out = (net_send_buffer_t *)malloc(sizeof(net_send_buffer_t));
+    if (!out || open_deflater(session, 0, &deflater) != 0)
+    {
+        LOG_ERROR("Failed to allocate name list output buffer");
+        free(out);
+        fs_dir_close(dir);
+        return TRANSFER_STATUS_INTERNAL_ERROR;
+    }
+    net_send_buffer_init(out, session->data_socket);
 
-    for (int i = 0; i < count; i++)
+    fs_file_info_t entry;
+    char line_buffer[512];
+    int count = 0;
+    transfer_status_t status = TRANSFER_STATUS_OK;
+
+    for (;;)
     {
-        // Check if transfer has been aborted
+        // Check if transfer should be aborted
         if (session_should_abort_transfer(session))
         {
-            LOG_INFO("Directory listing aborted: %s", dirpath);
-            return TRANSFER_STATUS_ABORTED;
-        }
-
-        // If filtering by name, skip non-matching entries
-        if (filter_name && strcmp(file_list[i].name, filter_name) != 0)
-        {
-            continue;
+            LOG_INFO("Name list transfer aborted: %s", dirpath);
+            status = TRANSFER_STATUS_ABORTED;
+            break;
         }
 
-        if (format_list_line(&file_list[i], line_buffer, sizeof(line_buffer)) != 0)
+        int rc = fs_dir_next(dir, &entry);
+        if (rc == 0)
         {
-            LOG_ERROR("Failed to format listing line for %s", file_list[i].name);
-            return TRANSFER_STATUS_INTERNAL_ERROR;
+            break;
         }
-
-        if (net_send_all(session->data_socket, line_buffer, strlen(line_buffer)) != 0)
+        if (rc < 0)
         {
-            if (session_should_abort_transfer(session))
-            {
-                LOG_INFO("Directory listing aborted by ABOR command (connection closed): %s", dirpath);
-                return TRANSFER_STATUS_ABORTED;
-            }
-            else
-            {
-                int err = net_get_last_error();
-                LOG_ERROR("Failed to send listing line: %s (code=%d)", net_get_error_string(err), err);
-                return TRANSFER_STATUS_CONN_ERROR;
-            }
+            LOG_ERROR("Failed to read directory: %s", dirpath);
+            status = TRANSFER_STATUS_IO_ERROR;
+            break;
         }
 
-        entries_sent++;
+        // NLST format: just filename with CRLF
+        snprintf(line_buffer, sizeof(line_buffer), "%s\r\n", entry.name);
 
-        // If filtering for a specific name, we can stop after sending it
-        if (filter_name)
+        size_t line_length = strlen(line_buffer);
+        int send_rc = deflater ? datacomp_writer_write(deflater, line_buffer, line_length)
+                               : net_send_buffer_append(out, line_buffer, line_length);
+        if (send_rc != 0)
         {
+            status = listing_send_failed(session, "Name list transfer", dirpath);
             break;
         }
+
+        count++;
     }
 
-    if (filter_name && entries_sent == 0)
+    fs_dir_close(dir);
+
+    if (status == TRANSFER_STATUS_OK && net_send_buffer_flush(out) != 0)
     {
-        LOG_DEBUG("Entry '%s' not found in %s", filter_name, dirpath);
-        return TRANSFER_STATUS_IO_ERROR;
+        status = listing_send_failed(session, "Name list transfer", dirpath);
+    }
+    unsigned long sends = out->sends;
+    free(out);
+    long long compressed_bytes = 0;
+    status = close_deflater(session, deflater, status, "Name list transfer", dirpath, &compressed_bytes);
+
+    if (status != TRANSFER_STATUS_OK)
+    {
+        return status;
     }
 
-    LOG_INFO("Sent directory listing: %d entries", entries_sent);
+    LOG_INFO("Sent name list: %d entries in %lu sends", count, sends);
     return TRANSFER_STATUS_OK;
 }
 
-transfer_status_t transfer_send_list(session_t *session, const char *path)
+/**
+ * @brief Builds a unique temporary path next to an upload target.
+ * @param filepath Upload target
+ * @param temp_path Output buffer
+ * @param temp_size Output buffer size
+ * @return 0 on success, -1 if the path does not fit or no free name was found
+ */
+static int make_upload_temp_path(const char *filepath, char *temp_path, size_t temp_size)
 {
-    if (!session || !path)
+    static unsigned int counter = 0;
+
+    char dir[1024];
+    if (fs_get_parent_directory(filepath, dir, sizeof(dir)) != 0)
     {
-        LOG_ERROR("Invalid parameters for transfer_send_list");
-        return TRANSFER_STATUS_INTERNAL_ERROR;
+        return -1;
     }
 
-    // Verify data socket is valid
-    if (session->data_socket == INVALID_SOCKET_T)
+    // Same directory, so the final rename does not cross filesystems
+    for (int attempt = 0; attempt < 16; attempt++)
     {
-        LOG_ERROR("Data socket is not open for transfer");
-        return TRANSFER_STATUS_CONN_ERROR;
+        char name[MAX_FILENAME_LEN];
+        unsigned int id = ATOMIC_FETCH_ADD_RELAXED(&counter, 1);
+        int n = snprintf(name, sizeof(name), ".%s.upload-%u", fs_extract_filename(filepath), id);
+        if (n < 0 || (size_t)n >= sizeof(name) || fs_join_path(temp_path, (long long)temp_size, dir, name) != 0)
+        {
+            return -1;
+        }
+        if (!fs_path_exists(temp_path))
+        {
+            return 0;
+        }
     }
+    return -1;
+}
+
+/**
+ * @brief Runs an upload, through a temporary file when it must appear atomically.
+ *
+ * The temporary file replaces the target only after the upload completed
+ * (and was flushed, per the durability policy); on failure or ABOR it is
+ * removed and the target is left as it was.
+ *
+ * @param session The FTP session
+ * @param params Transfer parameters
+ * @return transfer_status_t value indicating success or the failure reason
+ */
+static transfer_status_t receive_upload(session_t *session, const transfer_params_t *params)
+{
+    char temp_path[sizeof(params->filepath)];
+    const char *target = params->filepath;
 
-    if (fs_is_directory(path))
+    if (params->atomic)
     {
-        return send_listing(session, path, NULL);
+        if (make_upload_temp_path(params->filepath, temp_path, sizeof(temp_path)) != 0)
+        {
+            LOG_ERROR("Cannot create a temporary upload path for %s", params->filepath);
+            return TRANSFER_STATUS_IO_ERROR;
+        }
+        target = temp_path;
     }
 
-    if (!fs_path_exists(path))
+    transfer_status_t result;
+    if (params->type == PROTO_TYPE_ASCII)
     {
-        LOG_ERROR("LIST path does not exist: %s", path);
-        return TRANSFER_STATUS_IO_ERROR;
+        result = transfer_receive_file_ascii(session, target, params->offset, params->size_hint);
     }
-
-    // It's a file, extract parent directory and ls that file only
-    char filename[SESSION_MAX_PATH];
-    const char *name_part = fs_extract_filename(path);
-    if (!name_part || name_part[0] == '\0')
+    else
     {
-        LOG_ERROR("Failed to extract filename for LIST: %s", path);
-        return TRANSFER_STATUS_INTERNAL_ERROR;
+        result = transfer_receive_file(session, target, params->offset, params->size_hint);
     }
 
-    strncpy(filename, name_part, sizeof(filename) - 1);
-    filename[sizeof(filename) - 1] = '\0';
-
-    char parent_dir[SESSION_MAX_PATH];
-    if (fs_get_parent_directory(path, parent_dir, sizeof(parent_dir)) != 0)
+    if (params->atomic)
     {
-        LOG_ERROR("Failed to determine parent directory for LIST: %s", path);
-        return TRANSFER_STATUS_INTERNAL_ERROR;
+        if (result == TRANSFER_STATUS_OK && fs_replace_file(temp_path, params->filepath) != 0)
+        {
+            LOG_ERROR("Failed to move upload into place: %s", params->filepath);
+            result = TRANSFER_STATUS_IO_ERROR;
+        }
+        if (result != TRANSFER_STATUS_OK && fs_path_exists(temp_path))
+        {
+            fs_delete_file(temp_path);
+        }
     }
 
-    return send_listing(session, parent_dir, filename);
+    return result;
 }
 
-transfer_status_t transfer_send_nlst(session_t *session, const char *dirpath)
+/**
+ * @brief Checksums an open file from params->offset to its end, or params->length bytes.
+ *
+ * The file is read through the read-ahead pipeline like a download, and the
+ * result is stored in the checksum cache.
+ *
+ * @param session The FTP session
+ * @param params Transfer parameters, with the file opened by the handler
+ * @param hex Output: the checksum (DIGEST_HEX_SIZE bytes)
+ * @return transfer_status_t value indicating success or the failure reason
+ */
+static transfer_status_t compute_digest(session_t *session, transfer_params_t *params, char *hex)
 {
-    if (!session || !dirpath)
+    if (!params->file_opened)
     {
-        LOG_ERROR("Invalid parameters for transfer_send_nlst");
         return TRANSFER_STATUS_INTERNAL_ERROR;
     }
 
-    fs_file_info_t file_list[1024];
-    int count = fs_list_directory(dirpath, file_list, 1024);
+    unsigned long generation = digestcache_get_generation();
+    long long length = params->length >= 0 ? params->length : params->stat.size - params->offset;
 
-    if (count < 0)
+    if (fs_file_seek(&params->file, params->offset) != 0)
     {
-        LOG_ERROR("Failed to list directory: %s", dirpath);
+        LOG_ERROR("Failed to seek to offset %lld: %s", params->offset, params->filepath);
         return TRANSFER_STATUS_IO_ERROR;
     }
 
-    char line_buffer[512];
+    digest_ctx_t ctx;
+    digest_init(&ctx, params->algorithm);
+    transfer_status_t status = TRANSFER_STATUS_OK;
 
-    for (int i = 0; i < count; i++)
+    if (length > 0)
     {
-        // Check if transfer should be aborted
-        if (session_should_abort_transfer(session))
+        file_reader_t reader;
+        iopipe_t *pipeline = start_read_ahead(&reader, &params->file, params->filepath, params->offset, length);
+        if (!pipeline)
         {
-            LOG_INFO("Name list transfer aborted: %s", dirpath);
-            return TRANSFER_STATUS_ABORTED;
+            return TRANSFER_STATUS_INTERNAL_ERROR;
         }
 
-        // NLST format: just filename with CRLF
-        snprintf(line_buffer, sizeof(line_buffer), "%s\r\n", file_list[i].name);
-
-        if (net_send_all(session->data_socket, line_buffer, strlen(line_buffer)) != 0)
+        while (1)
         {
+            // ABOR cancels a long checksum like a transfer
             if (session_should_abort_transfer(session))
             {
-                LOG_INFO("Name list transfer aborted by ABOR command (connection closed): %s", dirpath);
-                return TRANSFER_STATUS_ABORTED;
+                LOG_INFO("Checksum aborted: %s", params->filepath);
+                status = TRANSFER_STATUS_ABORTED;
+                break;
             }
-            else
+
+            const char *buffer;
+            long long bytes_read = iopipe_next(pipeline, &buffer);
+
+            if (bytes_read < 0)
             {
-                int err = net_get_last_error();
-                LOG_ERROR("Failed to send name list line: %s (code=%d)", net_get_error_string(err), err);
-                return TRANSFER_STATUS_CONN_ERROR;
+                status = TRANSFER_STATUS_IO_ERROR; // Logged by the read stage
+                break;
+            }
+
+            if (bytes_read == 0)
+            {
+                break;
             }
+
+            digest_update(&ctx, buffer, (size_t)bytes_read);
         }
+
+        stop_pipeline(pipeline, "Checksum", params->filepath);
+    }
+
+    if (status != TRANSFER_STATUS_OK)
+    {
+        return status;
     }
 
-    LOG_INFO("Sent name list: %d entries", count);
+    digest_final_hex(&ctx, hex);
+    if (params->length < 0)
+    {
+        // The cache keys checksums by their offset, which implies ranges to the end of the file
+        digestcache_store(params->filepath, &params->stat, params->algorithm, params->offset, generation, hex);
+    }
     return TRANSFER_STATUS_OK;
 }
 
+void transfer_send_digest_reply(session_t *session, digest_algorithm_t algorithm, int hash_reply,
+                                long long offset, long long size, const char *name, const char *hex)
+{
+    if (!hash_reply)
+    {
+        session_send_response(session, PROTO_RESP_FILE_ACTION_OK, hex);
+        return;
+    }
+
+    // The range is inclusive; an empty one is written as the start offset twice
+    long long end = size > offset ? size - 1 : offset;
+    char message[PROTO_MAX_RESPONSE_LINE];
+    snprintf(message, sizeof(message), "%s %lld-%lld %s %s", digest_algorithm_name(algorithm), offset, end, hex,
+             name);
+    session_send_response(session, PROTO_RESP_FILE_STATUS, message);
+}
+
+/**
+ * @brief Records a finished transfer in the server metrics
+ *
+ * @param operation The transfer operation
+ * @param status Its result
+ * @param bytes Bytes it moved
+ * @param elapsed_us Its duration
+ */
+static void record_transfer_metrics(transfer_operation_t operation, transfer_status_t status,
+                                    long long bytes, long long elapsed_us)
+{
+    metrics_direction_t direction;
+    switch (operation)
+    {
+    case TRANSFER_OP_SEND_FILE:
+        direction = METRICS_DOWNLOAD;
+        break;
+    case TRANSFER_OP_RECV_FILE:
+        direction = METRICS_UPLOAD;
+        break;
+    case TRANSFER_OP_SEND_LIST:
+    case TRANSFER_OP_SEND_NLST:
+    case TRANSFER_OP_SEND_MLSD:
+        direction = METRICS_LISTING;
+        break;
+    default:
+        return;
+    }
+
+    metrics_result_t result = METRICS_RESULT_FAILED;
+    if (status == TRANSFER_STATUS_OK)
+    {
+        result = METRICS_RESULT_OK;
+    }
+    else if (status == TRANSFER_STATUS_ABORTED)
+    {
+        result = METRICS_RESULT_ABORTED;
+    }
+
+    metrics_record_transfer(direction, result, bytes, elapsed_us);
+}
+
 /**
  * @brief Transfer thread function for async file transfers
  *
@@ -809,69 +2070,169 @@ void *transfer_thread_func(void *arg)
     session_set_transfer_in_progress(session);
 
     transfer_status_t result;
-    transfer_params_t *params = (transfer_params_t *)session->transfer_params;
+    transfer_params_t *params = session->transfer_params;
+    char digest[DIGEST_HEX_SIZE];
 
     LOG_INFO("Session from %s, transfer thread started: operation=%d, path=%s, offset=%lld",
              session->client_ip, params->operation, params->filepath, params->offset);
 
-    // Execute transfer based on operation type
-    switch (params->operation)
+    long long start_us = metrics_now_us();
+    unsigned long long downloaded = session->bytes_downloaded;
+    unsigned long long uploaded = session->bytes_uploaded;
+
+    // ABOR may have arrived while the job was still waiting for a worker
+    if (session_should_abort_transfer(session))
     {
-    case TRANSFER_OP_SEND_FILE:
-        // Download (RETR)
-        if (params->type == PROTO_TYPE_ASCII)
+        LOG_INFO("Session from %s, transfer aborted before it started", session->client_ip);
+        result = TRANSFER_STATUS_ABORTED;
+    }
+    else
+    {
+        // Execute transfer based on operation type
+        switch (params->operation)
         {
-            result = transfer_send_file_ascii(session, params->filepath, params->offset);
+        case TRANSFER_OP_SEND_FILE:
+            // Download (RETR)
+            // The handler opened the file under the lock, its size is in the snapshot
+            if (!params->file_opened)
+            {
+                result = (params->type == PROTO_TYPE_ASCII)
+                             ? transfer_send_file_ascii(session, params->filepath, params->offset)
+                             : transfer_send_file(session, params->filepath, params->offset);
+            }
+            else if (params->type == PROTO_TYPE_ASCII)
+            {
+                result = send_open_file_ascii(session, &params->file, params->filepath,
+                                              params->stat.size, params->offset, params->length);
+            }
+            else
+            {
+                result = send_open_file(session, &params->file, params->filepath,
+                                        params->stat.size, params->offset, params->length);
+            }
+            break;
+
+        case TRANSFER_OP_RECV_FILE:
+            // Upload (STOR / APPE)
+            result = receive_upload(session, params);
+            break;
+
+        case TRANSFER_OP_SEND_LIST:
+            // Directory listing (LIST)
+            result = send_list_path(session, params->filepath, &params->stat);
+            break;
+
+        case TRANSFER_OP_SEND_NLST:
+            // Name listing (NLST)
+            result = transfer_send_nlst(session, params->filepath);
+            break;
+
+        case TRANSFER_OP_SEND_MLSD:
+            // Machine-readable listing (MLSD)
+            result = transfer_send_mlsd(session, params->filepath);
+            break;
+
+        case TRANSFER_OP_HASH:
+            // Checksum (HASH, XCRC, XMD5, XSHA256)
+            result = compute_digest(session, params, digest);
+            break;
+
+        default:
+            LOG_ERROR("Unknown transfer operation: %d", params->operation);
+            result = TRANSFER_STATUS_INTERNAL_ERROR;
+            break;
         }
-        else
+    }
+
+    record_transfer_metrics(params->operation, result,
+                            (long long)(session->bytes_downloaded - downloaded + session->bytes_uploaded - uploaded),
+                            metrics_now_us() - start_us);
+
+    // Close data connection; a checksum has none and leaves PASV/PORT to the next transfer
+    if (params->operation != TRANSFER_OP_HASH)
+    {
+        session_close_data_connection(session);
+    }
+
+    // The file handed over by the handler is closed even if the transfer never started
+    if (params->file_opened)
+    {
+        fs_file_close(&params->file);
+        params->file_opened = 0;
+    }
+
+    // Release file lock if it was acquired. Done before the completion reply so
+    // a client acting on the reply (e.g. DELE right after ABOR) finds the file unlocked.
+    if (params->lock_acquired)
+    {
+        // Determine lock type based on operation
+        if (params->operation == TRANSFER_OP_RECV_FILE)
         {
-            result = transfer_send_file(session, params->filepath, params->offset);
+            file_lock_release_exclusive(params->filepath);
         }
-        break;
-
-    case TRANSFER_OP_RECV_FILE:
-        // Upload (STOR / APPE)
-        if (params->type == PROTO_TYPE_ASCII)
+        else if (params->shared_lock)
         {
-            result = transfer_receive_file_ascii(session, params->filepath, params->offset);
+            file_lock_release_shared_handle(params->shared_lock);
+            params->shared_lock = NULL;
         }
-        else
+        else if (params->operation == TRANSFER_OP_SEND_FILE || params->operation == TRANSFER_OP_HASH)
         {
-            result = transfer_receive_file(session, params->filepath, params->offset);
+            file_lock_release_shared(params->filepath);
         }
-        break;
+        // LIST/NLST operations don't acquire locks
+        params->lock_acquired = 0;
+        LOG_DEBUG("Released file lock for %s", params->filepath);
+    }
 
-    case TRANSFER_OP_SEND_LIST:
-        // Directory listing (LIST)
-        result = transfer_send_list(session, params->filepath);
-        break;
+    // An upload changed the file size (and maybe created it); drop stale listings
+    if (params->operation == TRANSFER_OP_RECV_FILE)
+    {
+        listcache_invalidate(params->filepath);
+        digestcache_invalidate(params->filepath);
+        hotcache_invalidate(params->filepath);
+    }
 
-    case TRANSFER_OP_SEND_NLST:
-        // Name listing (NLST)
-        result = transfer_send_nlst(session, params->filepath);
-        break;
+    // Store result
+    session->transfer_result = result;
 
-    default:
-        LOG_ERROR("Unknown transfer operation: %d", params->operation);
-        result = TRANSFER_STATUS_INTERNAL_ERROR;
-        break;
+    // Clear transfer flags
+    session_clear_transfer_in_progress(session);
+
+    // Set final thread state
+    if (result == TRANSFER_STATUS_ABORTED)
+    {
+        session_set_transfer_thread_state(session, TRANSFER_THREAD_ABORTED);
+        // The 426 was already sent by ABOR, the flag is not needed any more
+        session_clear_transfer_should_abort(session);
+    }
+    else
+    {
+        session_set_transfer_thread_state(session, TRANSFER_THREAD_COMPLETING);
     }
 
-    // Close data connection
-    session_close_data_connection(session);
+    // Go idle before the completion reply, so a client that issues the next
+    // transfer command as soon as it reads the reply is not refused
+    session_set_transfer_thread_state(session, TRANSFER_THREAD_IDLE);
 
     // Send completion response based on result
     switch (result)
     {
     case TRANSFER_STATUS_OK:
-        session_send_response(session, PROTO_RESP_CLOSING_DATA, "Transfer complete");
+        if (params->operation == TRANSFER_OP_HASH)
+        {
+            long long end = params->length >= 0 ? params->offset + params->length : params->stat.size;
+            transfer_send_digest_reply(session, params->algorithm, params->hash_reply, params->offset,
+                                       end, params->hash_name, digest);
+        }
+        else
+        {
+            session_send_response(session, PROTO_RESP_CLOSING_DATA, "Transfer complete");
+        }
         break;
 
     case TRANSFER_STATUS_ABORTED:
         // Send the 226 response for ABOR command sequence
         session_send_response(session, PROTO_RESP_CLOSING_DATA, "ABOR command successful");
-        // Clear abort flag after sending response
-        session_clear_transfer_should_abort(session);
         break;
 
     case TRANSFER_STATUS_CONN_ERROR:
@@ -893,49 +2254,6 @@ void *transfer_thread_func(void *arg)
         break;
     }
 
-    // Store result
-    session->transfer_result = result;
-
-    // Clear transfer flags
-    session_clear_transfer_in_progress(session);
-
-    // Release file lock if it was acquired
-    if (params->lock_acquired)
-    {
-        // Determine lock type based on operation
-        if (params->operation == TRANSFER_OP_RECV_FILE)
-        {
-            file_lock_release_exclusive(params->filepath);
-        }
-        else if (params->operation == TRANSFER_OP_SEND_FILE)
-        {
-            file_lock_release_shared(params->filepath);
-        }
-        // LIST/NLST operations don't acquire locks
-        params->lock_acquired = 0;
-        LOG_DEBUG("Released file lock for %s", params->filepath);
-    }
-
-    // Free transfer parameters
-    if (session->transfer_params)
-    {
-        free(session->transfer_params);
-        session->transfer_params = NULL;
-    }
-
-    // Set final thread state
-    if (result == TRANSFER_STATUS_ABORTED)
-    {
-        session_set_transfer_thread_state(session, TRANSFER_THREAD_ABORTED);
-    }
-    else
-    {
-        session_set_transfer_thread_state(session, TRANSFER_THREAD_COMPLETING);
-    }
-
-    // Reset to idle after a short delay to allow any pending operations to complete
-    session_set_transfer_thread_state(session, TRANSFER_THREAD_IDLE);
-
     LOG_DEBUG("Session from %s, transfer thread exiting", session->client_ip);
 
     return NULL;
@@ -7,6 +7,7 @@
 
 #define _POSIX_C_SOURCE 200809L
 #include "utils.h"
+#include "lineconv.h"
 
 #include <ctype.h>
 #include <stdio.h>
@@ -22,8 +23,13 @@
 void get_timestamp(char *buffer, size_t size)
 {
     time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm_info);
+    struct tm tm_info;
+#ifdef _WIN32
+    localtime_s(&tm_info, &now);
+#else
+    localtime_r(&now, &tm_info);
+#endif
+    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &tm_info);
 }
 
 void trim_whitespace(char *str)
@@ -61,63 +67,21 @@ void to_uppercase(char *str)
 
 long long crlf_to_lf(const char *input_buffer, long long input_len, char *output_buffer, long long output_size)
 {
-    if (!input_buffer || !output_buffer || input_len < 0 || output_size <= 0)
+    lineconv_state_t state;
+    lineconv_state_init(&state);
+
+    long long written = lineconv_crlf_to_lf(&state, input_buffer, input_len, output_buffer, output_size);
+    if (written < 0)
         return -1;
 
-    long long write_idx = 0;
-    for (long long i = 0; i < input_len; i++)
-    {
-        if (input_buffer[i] == '\r')
-        {
-            // Check for CRLF sequence
-            if (i + 1 < input_len && input_buffer[i + 1] == '\n')
-            {
-                if (write_idx + 1 > output_size)
-                    return -1; // Output buffer too small
-                output_buffer[write_idx++] = '\n';
-                i++; // Skip next character (LF)
-            }
-            else
-            {
-                // Lone CR, treat as regular character
-                if (write_idx + 1 > output_size)
-                    return -1; // Output buffer too small
-                output_buffer[write_idx++] = input_buffer[i];
-            }
-        }
-        else
-        {
-            if (write_idx + 1 > output_size)
-                return -1; // Output buffer too small
-            output_buffer[write_idx++] = input_buffer[i];
-        }
-    }
-    return write_idx;
+    // A trailing CR is a lone CR here, there is no next chunk
+    long long tail = lineconv_crlf_to_lf_finish(&state, output_buffer + written, output_size - written);
+    return tail < 0 ? -1 : written + tail;
 }
 
 long long lf_to_crlf(const char *input_buffer, long long input_len, char *output_buffer, long long output_size)
 {
-    if (!input_buffer || !output_buffer || input_len < 0 || output_size <= 0)
-        return -1;
-
-    long long write_idx = 0;
-    for (long long i = 0; i < input_len; i++)
-    {
-        if (input_buffer[i] == '\n')
-        {
-            if (write_idx + 2 > output_size)
-                return -1; // Output buffer too small
-            output_buffer[write_idx++] = '\r';
-            output_buffer[write_idx++] = '\n';
-        }
-        else
-        {
-            if (write_idx + 1 > output_size)
-                return -1; // Output buffer too small
-            output_buffer[write_idx++] = input_buffer[i];
-        }
-    }
-    return write_idx;
+    return lineconv_lf_to_crlf(input_buffer, input_len, output_buffer, output_size);
 }
 
 int string_to_hex(const char *input, char *output_buffer, size_t buffer_size)
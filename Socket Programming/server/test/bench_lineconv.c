@@ -0,0 +1,99 @@
+/**
+ * Line ending conversion benchmark.
+ *
+ * Reports the throughput of every supported kernel for LF->CRLF and
+ * CRLF->LF on text with ~80 byte lines, the shape of a typical log export.
+ *
+ * Usage: bench_lineconv [megabytes] (default 256)
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lineconv.h"
+
+#define CHUNK_SIZE 65536 // Same as TRANSFER_BUFFER_SIZE
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Fills buf with lines of 60-100 characters ending in eol.
+ */
+static void fill_text(char *buf, size_t len, const char *eol)
+{
+    size_t eol_len = strlen(eol);
+    size_t i = 0;
+    srand(42);
+    while (i < len)
+    {
+        size_t line = 60 + (size_t)(rand() % 41);
+        for (size_t j = 0; j < line && i < len; j++)
+            buf[i++] = (char)(' ' + rand() % 90);
+        for (size_t j = 0; j < eol_len && i < len; j++)
+            buf[i++] = eol[j];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long long megabytes = argc > 1 ? atoll(argv[1]) : 256;
+    if (megabytes <= 0)
+    {
+        fprintf(stderr, "Invalid size\n");
+        return 1;
+    }
+    long long total = megabytes * 1024 * 1024;
+
+    char *lf_text = malloc(CHUNK_SIZE);
+    char *crlf_text = malloc(CHUNK_SIZE);
+    char *out = malloc(CHUNK_SIZE * 2);
+    if (!lf_text || !crlf_text || !out)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    fill_text(lf_text, CHUNK_SIZE, "\n");
+    fill_text(crlf_text, CHUNK_SIZE, "\r\n");
+
+    printf("Converting %lld MB in %d byte chunks\n", megabytes, CHUNK_SIZE);
+    printf("%-8s %14s %14s\n", "kernel", "LF->CRLF GB/s", "CRLF->LF GB/s");
+
+    long long checksum = 0;
+    for (int k = 0; k < lineconv_get_kernel_count(); k++)
+    {
+        if (lineconv_select_kernel(k) != 0)
+        {
+            printf("%-8s %14s %14s\n", lineconv_get_kernel_name(k), "unsupported", "unsupported");
+            continue;
+        }
+
+        double start = now_seconds();
+        for (long long done = 0; done < total; done += CHUNK_SIZE)
+            checksum += lineconv_lf_to_crlf(lf_text, CHUNK_SIZE, out, CHUNK_SIZE * 2);
+        double lf_seconds = now_seconds() - start;
+
+        lineconv_state_t state;
+        lineconv_state_init(&state);
+        start = now_seconds();
+        for (long long done = 0; done < total; done += CHUNK_SIZE)
+            checksum += lineconv_crlf_to_lf(&state, crlf_text, CHUNK_SIZE, out, CHUNK_SIZE + 1);
+        double crlf_seconds = now_seconds() - start;
+
+        printf("%-8s %14.2f %14.2f\n", lineconv_get_kernel_name(k),
+               (double)total / lf_seconds / 1e9, (double)total / crlf_seconds / 1e9);
+    }
+    lineconv_select_kernel(-1);
+    printf("Default kernel: %s (checksum %lld)\n", lineconv_get_kernel_name(lineconv_get_active_kernel()), checksum);
+
+    free(lf_text);
+    free(crlf_text);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * Directory listing benchmark.
+ *
+ * Lists a directory of many entries over a loopback connection and reports
+ * the number of send calls and the time taken, for per-line sends versus
+ * the coalescing send buffer used by LIST/NLST.
+ *
+ * Usage: bench_listing [entries] (default 100000)
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "filesys.h"
+#include "logger.h"
+#include "network.h"
+#include "session.h"
+#include "transfer.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+typedef struct
+{
+    uint16_t port;
+    unsigned long long bytes;
+    unsigned long long lines;
+} reader_args_t;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Connects to the benchmark listener and drains it until EOF.
+ */
+static void *reader_thread(void *arg)
+{
+    reader_args_t *args = (reader_args_t *)arg;
+    socket_t sock = net_connect("127.0.0.1", args->port);
+    if (sock == INVALID_SOCKET_T)
+        return NULL;
+
+    char buffer[65536];
+    int received;
+    while ((received = net_receive(sock, buffer, sizeof(buffer))) > 0)
+    {
+        args->bytes += (unsigned long long)received;
+        for (int i = 0; i < received; i++)
+        {
+            if (buffer[i] == '\n')
+                args->lines++;
+        }
+    }
+    net_close_socket(sock);
+    return NULL;
+}
+
+/**
+ * Opens a loopback connection: returns the server side, starts the reader on the client side.
+ */
+static socket_t open_connection(pthread_t *thread, reader_args_t *args)
+{
+    socket_t listener = net_create_listening_socket(NET_AF_IPV4, "127.0.0.1", 0, 1);
+    if (listener == INVALID_SOCKET_T)
+        return INVALID_SOCKET_T;
+
+    memset(args, 0, sizeof(*args));
+    if (net_get_socket_info(listener, NULL, 0, &args->port) != 0 ||
+        pthread_create(thread, NULL, reader_thread, args) != 0)
+    {
+        net_close_socket(listener);
+        return INVALID_SOCKET_T;
+    }
+
+    socket_t sock = net_accept(listener, NULL, 0, NULL);
+    net_close_socket(listener);
+    if (sock == INVALID_SOCKET_T)
+        pthread_join(*thread, NULL);
+    return sock;
+}
+
+int main(int argc, char **argv)
+{
+    int entries = argc > 1 ? atoi(argv[1]) : 100000;
+    if (entries <= 0)
+    {
+        fprintf(stderr, "Invalid entry count\n");
+        return 1;
+    }
+
+    logger_init(0, LOG_LEVEL_ERROR);
+    if (net_init() != 0)
+    {
+        fprintf(stderr, "net_init failed\n");
+        return 1;
+    }
+
+    const char *dir = "/tmp/ftp_bench_listing";
+    char path[PATH_MAX];
+    fs_delete_directory(dir, 1);
+    if (fs_create_directory(dir) != 0)
+    {
+        fprintf(stderr, "Failed to create %s\n", dir);
+        return 1;
+    }
+
+    printf("Creating %d entries in %s...\n", entries, dir);
+    for (int i = 0; i < entries; i++)
+    {
+        snprintf(path, sizeof(path), "%s/entry%07d.dat", dir, i);
+        if (fs_write_file_all(path, "x", 1) != 1)
+        {
+            fprintf(stderr, "Failed to create %s\n", path);
+            fs_delete_directory(dir, 1);
+            return 1;
+        }
+    }
+
+    int failed = 0;
+    pthread_t thread;
+    reader_args_t args;
+    const char *line = "-rw-r--r--   1 ftp      ftp             1 Jan 01 00:00 entry0000000.dat\r\n";
+    size_t line_length = strlen(line);
+
+    // Per-line sends, as LIST did before
+    socket_t sock = open_connection(&thread, &args);
+    if (sock == INVALID_SOCKET_T)
+    {
+        fprintf(stderr, "Failed to open loopback connection\n");
+        fs_delete_directory(dir, 1);
+        return 1;
+    }
+    double start = now_seconds();
+    for (int i = 0; i < entries; i++)
+        net_send_all(sock, line, line_length);
+    net_close_socket(sock);
+    pthread_join(thread, NULL);
+    printf("Per-line sends:    %8d sends  %8.3f s\n", entries, now_seconds() - start);
+
+    // Coalesced sends
+    static net_send_buffer_t out;
+    sock = open_connection(&thread, &args);
+    start = now_seconds();
+    net_send_buffer_init(&out, sock);
+    for (int i = 0; i < entries; i++)
+        net_send_buffer_append(&out, line, line_length);
+    net_send_buffer_flush(&out);
+    net_close_socket(sock);
+    pthread_join(thread, NULL);
+    printf("Coalesced sends:   %8lu sends  %8.3f s\n", out.sends, now_seconds() - start);
+    if (args.lines != (unsigned long long)entries ||
+        out.sends > args.bytes / NET_SEND_BUFFER_SIZE + 1)
+    {
+        fprintf(stderr, "Coalesced output mismatch: %llu lines, %lu sends\n", args.lines, out.sends);
+        failed = 1;
+    }
+
+    // End to end: LIST and NLST of the directory
+    pthread_t control_thread;
+    reader_args_t control_args;
+    socket_t control = open_connection(&control_thread, &control_args);
+    session_t *session = control == INVALID_SOCKET_T ? NULL : session_create(control, "127.0.0.1", 0, "/", NULL);
+    if (!session)
+    {
+        fprintf(stderr, "session_create failed\n");
+        fs_delete_directory(dir, 1);
+        return 1;
+    }
+    for (int pass = 0; pass < 2; pass++)
+    {
+        session->data_socket = open_connection(&thread, &args);
+        start = now_seconds();
+        transfer_status_t status = pass == 0 ? transfer_send_list(session, dir) : transfer_send_nlst(session, dir);
+        double elapsed = now_seconds() - start;
+        net_close_socket(session->data_socket);
+        session->data_socket = INVALID_SOCKET_T;
+        pthread_join(thread, NULL);
+
+        printf("%s of %d entries: %8.3f s, %llu bytes\n", pass == 0 ? "LIST" : "NLST", entries, elapsed, args.bytes);
+        if (status != TRANSFER_STATUS_OK || args.lines != (unsigned long long)entries)
+        {
+            fprintf(stderr, "%s returned %d with %llu lines\n", pass == 0 ? "LIST" : "NLST", status, args.lines);
+            failed = 1;
+        }
+    }
+    session_destroy(session); // Closes the control connection
+    pthread_join(control_thread, NULL);
+
+    fs_delete_directory(dir, 1);
+    net_cleanup();
+    logger_close();
+
+    return failed;
+}
@@ -0,0 +1,776 @@
+/**
+ * FTP load generator.
+ *
+ * Runs N concurrent clients against a live server, each picking operations
+ * from a weighted mix until the duration or operation budget is spent, and
+ * reports ops/s, latency percentiles and bytes/s per operation. The JSON
+ * and CSV outputs are meant to be stored and compared between builds.
+ *
+ * Operations:
+ *   login  connect, USER, PASS, QUIT on a fresh control connection
+ *   list   PASV + LIST of the fixture directory
+ *   small  PASV + RETR of one of the small fixture files
+ *   stor   PASV + STOR of a large file (one target file per client)
+ *   retr   PASV + RETR of the large fixture file
+ *   pasv   PASV and connecting to the announced port, without a transfer
+ *
+ * The fixtures are uploaded to a scratch directory before the run and
+ * removed afterwards. Data connections go to the control host, whatever
+ * address the 227 reply announces.
+ *
+ * Usage: ftpbench [options], see print_usage()
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "logger.h"
+#include "network.h"
+#include "protocol.h"
+
+#define BENCH_BUFFER_SIZE 65536
+#define BENCH_TIMEOUT_MS 30000
+#define BENCH_MAX_LINE 1024
+
+typedef enum
+{
+    OP_LOGIN,
+    OP_LIST,
+    OP_SMALL,
+    OP_STOR,
+    OP_RETR,
+    OP_PASV,
+    OP_COUNT
+} bench_op_t;
+
+static const char *const g_op_names[OP_COUNT] = {"login", "list", "small", "stor", "retr", "pasv"};
+
+// Named mixes accepted by -m besides explicit weights
+static const struct
+{
+    const char *name;
+    const char *weights;
+} g_presets[] = {
+    {"login", "login=1"},
+    {"list", "list=1"},
+    {"small", "small=1"},
+    {"large", "stor=1,retr=1"},
+    {"pasv", "pasv=1"},
+    {"mixed", "login=1,list=2,small=8,stor=1,retr=1,pasv=2"},
+};
+
+typedef enum
+{
+    OUTPUT_TEXT,
+    OUTPUT_JSON,
+    OUTPUT_CSV
+} bench_output_t;
+
+typedef struct
+{
+    char host[256];
+    uint16_t port;
+    char user[64];
+    char pass[64];
+    char dir[128];
+    char mix[256];
+    int clients;
+    double duration;
+    long long ops_per_client; // 0 to run for the duration
+    long long small_size;
+    int small_files;
+    long long large_size;
+    bench_output_t output;
+    int weights[OP_COUNT];
+} bench_config_t;
+
+// Latency samples and byte counts of one operation
+typedef struct
+{
+    long long *samples_us;
+    size_t count;
+    size_t capacity;
+    long long errors;
+    long long bytes;
+} bench_series_t;
+
+typedef struct
+{
+    socket_t sock;
+    net_line_buffer_t lines;
+} bench_conn_t;
+
+typedef struct
+{
+    int id;
+    pthread_t thread;
+    unsigned long long rng;
+    char *buffer;
+    bench_series_t series[OP_COUNT];
+} bench_client_t;
+
+static bench_config_t g_config;
+static double g_deadline;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static unsigned long long next_random(unsigned long long *state)
+{
+    // xorshift64*, per client so the threads do not contend on rand()
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static int series_add(bench_series_t *series, long long elapsed_us)
+{
+    if (series->count == series->capacity)
+    {
+        size_t capacity = series->capacity ? series->capacity * 2 : 1024;
+        long long *samples = realloc(series->samples_us, capacity * sizeof(long long));
+        if (!samples)
+            return -1;
+        series->samples_us = samples;
+        series->capacity = capacity;
+    }
+    series->samples_us[series->count++] = elapsed_us;
+    return 0;
+}
+
+static void conn_close(bench_conn_t *conn)
+{
+    if (conn->sock != INVALID_SOCKET_T)
+        net_close_socket(conn->sock);
+    conn->sock = INVALID_SOCKET_T;
+    net_line_buffer_free(&conn->lines);
+}
+
+/**
+ * Reads a complete (possibly multi-line) reply.
+ *
+ * @return The reply code, or -1 if the connection failed.
+ */
+static int conn_reply(bench_conn_t *conn, char *text, size_t text_size)
+{
+    char line[BENCH_MAX_LINE];
+    int code = -1;
+
+    for (;;)
+    {
+        int n = net_receive_line_buffered(conn->sock, &conn->lines, line, sizeof(line), BENCH_TIMEOUT_MS, NULL);
+        if (n <= 0 || n < 4)
+            return -1;
+
+        int line_code = atoi(line);
+        if (code < 0)
+        {
+            code = line_code;
+            if (text)
+                snprintf(text, text_size, "%s", line);
+        }
+        if (line_code == code && line[3] == ' ')
+            return code;
+    }
+}
+
+/**
+ * Sends a command and reads its reply.
+ *
+ * @return The reply code, or -1 if the connection failed.
+ */
+static int conn_command(bench_conn_t *conn, char *text, size_t text_size, const char *format, ...)
+{
+    char line[BENCH_MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line) - 2, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= sizeof(line) - 2)
+        return -1;
+    memcpy(line + n, "\r\n", 2);
+
+    if (net_send_all(conn->sock, line, (size_t)n + 2) != 0)
+        return -1;
+    return conn_reply(conn, text, text_size);
+}
+
+/**
+ * Connects and reads the greeting, then logs in unless login is 0.
+ */
+static int conn_open(bench_conn_t *conn, int login)
+{
+    net_line_buffer_init(&conn->lines);
+    conn->sock = net_connect(g_config.host, g_config.port);
+    if (conn->sock == INVALID_SOCKET_T)
+        return -1;
+    net_set_recv_timeout(conn->sock, BENCH_TIMEOUT_MS);
+    net_set_tcp_nodelay(conn->sock, 1);
+
+    if (conn_reply(conn, NULL, 0) != 220)
+    {
+        conn_close(conn);
+        return -1;
+    }
+    if (!login)
+        return 0;
+
+    int code = conn_command(conn, NULL, 0, "USER %s", g_config.user);
+    if (code == 331)
+        code = conn_command(conn, NULL, 0, "PASS %s", g_config.pass);
+    if (code != 230 || conn_command(conn, NULL, 0, "TYPE I") != 200)
+    {
+        conn_close(conn);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Sends PASV and connects to the announced port.
+ *
+ * @return The data socket, or INVALID_SOCKET_T on error.
+ */
+static socket_t conn_passive(bench_conn_t *conn)
+{
+    char reply[BENCH_MAX_LINE];
+    if (conn_command(conn, reply, sizeof(reply), "PASV") != 227)
+        return INVALID_SOCKET_T;
+
+    char *begin = strchr(reply, '(');
+    char *end = begin ? strchr(begin, ')') : NULL;
+    if (!end)
+        return INVALID_SOCKET_T;
+    *end = '\0';
+
+    proto_port_params_t params;
+    char ip[64];
+    uint16_t port;
+    if (proto_parse_port(begin + 1, &params) != 0 || proto_port_to_address(&params, ip, sizeof(ip), &port) != 0)
+        return INVALID_SOCKET_T;
+
+    socket_t data = net_connect(g_config.host, port);
+    if (data != INVALID_SOCKET_T)
+        net_set_recv_timeout(data, BENCH_TIMEOUT_MS);
+    return data;
+}
+
+/**
+ * Runs a download-style command (LIST, RETR) and drains the data connection.
+ *
+ * @return Bytes received, or -1 on error.
+ */
+static long long conn_download(bench_conn_t *conn, char *buffer, const char *command, const char *path)
+{
+    socket_t data = conn_passive(conn);
+    if (data == INVALID_SOCKET_T)
+        return -1;
+
+    int code = conn_command(conn, NULL, 0, "%s %s", command, path);
+    if (code != 150 && code != 125)
+    {
+        net_close_socket(data);
+        return -1;
+    }
+
+    long long total = 0;
+    int n;
+    while ((n = net_receive(data, buffer, BENCH_BUFFER_SIZE)) > 0)
+        total += n;
+    net_close_socket(data);
+
+    if (n < 0 || conn_reply(conn, NULL, 0) != 226)
+        return -1;
+    return total;
+}
+
+/**
+ * Uploads size bytes of the buffer pattern to path.
+ *
+ * @return Bytes sent, or -1 on error.
+ */
+static long long conn_upload(bench_conn_t *conn, const char *buffer, const char *path, long long size)
+{
+    socket_t data = conn_passive(conn);
+    if (data == INVALID_SOCKET_T)
+        return -1;
+
+    int code = conn_command(conn, NULL, 0, "STOR %s", path);
+    if (code != 150 && code != 125)
+    {
+        net_close_socket(data);
+        return -1;
+    }
+
+    int failed = 0;
+    for (long long sent = 0; sent < size && !failed;)
+    {
+        size_t chunk = (size_t)(size - sent < BENCH_BUFFER_SIZE ? size - sent : BENCH_BUFFER_SIZE);
+        failed = net_send_all(data, buffer, chunk) != 0;
+        sent += (long long)chunk;
+    }
+    net_shutdown_send(data);
+    net_close_socket(data);
+
+    if (failed || conn_reply(conn, NULL, 0) != 226)
+        return -1;
+    return size;
+}
+
+/**
+ * Runs one operation on the client's control connection.
+ *
+ * @return Bytes moved (0 for control-only operations), or -1 on error.
+ */
+static long long run_op(bench_client_t *client, bench_conn_t *conn, bench_op_t op)
+{
+    char path[256];
+
+    switch (op)
+    {
+    case OP_LOGIN:
+    {
+        bench_conn_t fresh;
+        if (conn_open(&fresh, 1) != 0)
+            return -1;
+        int code = conn_command(&fresh, NULL, 0, "QUIT");
+        conn_close(&fresh);
+        return code == 221 ? 0 : -1;
+    }
+    case OP_LIST:
+        return conn_download(conn, client->buffer, "LIST", g_config.dir);
+    case OP_SMALL:
+        snprintf(path, sizeof(path), "%s/small-%d.bin", g_config.dir,
+                 (int)(next_random(&client->rng) % (unsigned long long)g_config.small_files));
+        return conn_download(conn, client->buffer, "RETR", path);
+    case OP_STOR:
+        snprintf(path, sizeof(path), "%s/stor-%d.bin", g_config.dir, client->id);
+        return conn_upload(conn, client->buffer, path, g_config.large_size);
+    case OP_RETR:
+        snprintf(path, sizeof(path), "%s/large.bin", g_config.dir);
+        return conn_download(conn, client->buffer, "RETR", path);
+    case OP_PASV:
+    {
+        socket_t data = conn_passive(conn);
+        if (data == INVALID_SOCKET_T)
+            return -1;
+        net_close_socket(data);
+        return 0;
+    }
+    default:
+        return -1;
+    }
+}
+
+static bench_op_t pick_op(bench_client_t *client)
+{
+    int total = 0;
+    for (int i = 0; i < OP_COUNT; i++)
+        total += g_config.weights[i];
+
+    int pick = (int)(next_random(&client->rng) % (unsigned long long)total);
+    for (int i = 0; i < OP_COUNT; i++)
+    {
+        pick -= g_config.weights[i];
+        if (pick < 0)
+            return (bench_op_t)i;
+    }
+    return OP_LOGIN;
+}
+
+static void *client_thread(void *arg)
+{
+    bench_client_t *client = (bench_client_t *)arg;
+    bench_conn_t conn;
+    conn.sock = INVALID_SOCKET_T;
+
+    for (long long done = 0; g_config.ops_per_client == 0 || done < g_config.ops_per_client; done++)
+    {
+        if (now_seconds() >= g_deadline)
+            break;
+
+        bench_op_t op = pick_op(client);
+        long long start = now_us();
+
+        // A failed operation may leave the control connection out of step, so it is reopened
+        long long bytes = -1;
+        if (conn.sock != INVALID_SOCKET_T || op == OP_LOGIN || conn_open(&conn, 1) == 0)
+            bytes = run_op(client, &conn, op);
+
+        bench_series_t *series = &client->series[op];
+        if (bytes < 0)
+        {
+            series->errors++;
+            conn_close(&conn);
+            continue;
+        }
+        series_add(series, now_us() - start);
+        series->bytes += bytes;
+    }
+
+    if (conn.sock != INVALID_SOCKET_T)
+        conn_command(&conn, NULL, 0, "QUIT");
+    conn_close(&conn);
+    return NULL;
+}
+
+/**
+ * Uploads the fixture files (or removes them when remove is 1).
+ */
+static int fixtures(int remove, char *buffer)
+{
+    bench_conn_t conn;
+    char path[256];
+    if (conn_open(&conn, 1) != 0)
+    {
+        fprintf(stderr, "Cannot log in to %s:%u as %s\n", g_config.host, g_config.port, g_config.user);
+        return -1;
+    }
+
+    int failed = 0;
+    if (remove)
+    {
+        for (int i = 0; i < g_config.small_files; i++)
+        {
+            snprintf(path, sizeof(path), "%s/small-%d.bin", g_config.dir, i);
+            conn_command(&conn, NULL, 0, "DELE %s", path);
+        }
+        for (int i = 0; i < g_config.clients; i++)
+        {
+            snprintf(path, sizeof(path), "%s/stor-%d.bin", g_config.dir, i);
+            conn_command(&conn, NULL, 0, "DELE %s", path);
+        }
+        conn_command(&conn, NULL, 0, "DELE %s/large.bin", g_config.dir);
+        conn_command(&conn, NULL, 0, "RMD %s", g_config.dir);
+    }
+    else
+    {
+        conn_command(&conn, NULL, 0, "MKD %s", g_config.dir); // May already exist
+        for (int i = 0; i < g_config.small_files && !failed; i++)
+        {
+            snprintf(path, sizeof(path), "%s/small-%d.bin", g_config.dir, i);
+            failed = conn_upload(&conn, buffer, path, g_config.small_size) < 0;
+        }
+        if (!failed && g_config.weights[OP_RETR] > 0)
+        {
+            snprintf(path, sizeof(path), "%s/large.bin", g_config.dir);
+            failed = conn_upload(&conn, buffer, path, g_config.large_size) < 0;
+        }
+        if (failed)
+            fprintf(stderr, "Cannot upload fixtures to %s\n", g_config.dir);
+    }
+
+    conn_command(&conn, NULL, 0, "QUIT");
+    conn_close(&conn);
+    return failed ? -1 : 0;
+}
+
+static int parse_mix(const char *mix, int *weights)
+{
+    for (size_t i = 0; i < sizeof(g_presets) / sizeof(g_presets[0]); i++)
+    {
+        if (strcmp(mix, g_presets[i].name) == 0)
+            mix = g_presets[i].weights;
+    }
+
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", mix);
+    memset(weights, 0, OP_COUNT * sizeof(int));
+
+    int total = 0;
+    for (char *item = strtok(copy, ","); item; item = strtok(NULL, ","))
+    {
+        char *equals = strchr(item, '=');
+        int weight = equals ? atoi(equals + 1) : 1;
+        if (equals)
+            *equals = '\0';
+
+        int op = -1;
+        for (int i = 0; i < OP_COUNT; i++)
+        {
+            if (strcmp(item, g_op_names[i]) == 0)
+                op = i;
+        }
+        if (op < 0 || weight < 0)
+            return -1;
+        weights[op] = weight;
+        total += weight;
+    }
+    return total > 0 ? 0 : -1;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentile(const bench_series_t *series, double q)
+{
+    if (series->count == 0)
+        return 0;
+    size_t rank = (size_t)(q * (double)series->count + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    if (rank > series->count)
+        rank = series->count;
+    return series->samples_us[rank - 1];
+}
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("Options:\n");
+    printf("  -H <host>       Server host (default: 127.0.0.1)\n");
+    printf("  -p <port>       Server port (default: 2121)\n");
+    printf("  -u <user>       Username (default: anonymous)\n");
+    printf("  -w <password>   Password (default: ftpbench@)\n");
+    printf("  -c <clients>    Concurrent clients (default: 8)\n");
+    printf("  -d <seconds>    Run duration (default: 10)\n");
+    printf("  -n <ops>        Stop each client after <ops> operations (default: run for the duration)\n");
+    printf("  -m <mix>        login, list, small, large, pasv, mixed, or weights such as\n");
+    printf("                  \"list=2,small=8\" over login, list, small, stor, retr, pasv (default: mixed)\n");
+    printf("  -s <bytes>      Size of the small files (default: 4096)\n");
+    printf("  -f <count>      Number of small files (default: 16)\n");
+    printf("  -l <bytes>      Size of the large STOR/RETR file (default: 8388608)\n");
+    printf("  -D <dir>        Scratch directory on the server (default: ftpbench)\n");
+    printf("  -o <format>     Output: text, json, csv (default: text)\n");
+    printf("  -h              Show this help message\n");
+}
+
+static int parse_args(int argc, char **argv)
+{
+    g_config = (bench_config_t){.port = 2121,
+                                .clients = 8,
+                                .duration = 10,
+                                .small_size = 4096,
+                                .small_files = 16,
+                                .large_size = 8 * 1024 * 1024,
+                                .output = OUTPUT_TEXT};
+    strcpy(g_config.host, "127.0.0.1");
+    strcpy(g_config.user, "anonymous");
+    strcpy(g_config.pass, "ftpbench@");
+    strcpy(g_config.dir, "ftpbench");
+    strcpy(g_config.mix, "mixed");
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "-h") == 0)
+        {
+            print_usage(argv[0]);
+            exit(0);
+        }
+        if (!value || argv[i][0] != '-' || strlen(argv[i]) != 2)
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return -1;
+        }
+        i++;
+
+        switch (argv[i - 1][1])
+        {
+        case 'H': snprintf(g_config.host, sizeof(g_config.host), "%s", value); break;
+        case 'p': g_config.port = (uint16_t)atoi(value); break;
+        case 'u': snprintf(g_config.user, sizeof(g_config.user), "%s", value); break;
+        case 'w': snprintf(g_config.pass, sizeof(g_config.pass), "%s", value); break;
+        case 'c': g_config.clients = atoi(value); break;
+        case 'd': g_config.duration = atof(value); break;
+        case 'n': g_config.ops_per_client = atoll(value); break;
+        case 'm': snprintf(g_config.mix, sizeof(g_config.mix), "%s", value); break;
+        case 's': g_config.small_size = atoll(value); break;
+        case 'f': g_config.small_files = atoi(value); break;
+        case 'l': g_config.large_size = atoll(value); break;
+        case 'D': snprintf(g_config.dir, sizeof(g_config.dir), "%s", value); break;
+        case 'o':
+            if (strcmp(value, "json") == 0)
+                g_config.output = OUTPUT_JSON;
+            else if (strcmp(value, "csv") == 0)
+                g_config.output = OUTPUT_CSV;
+            else if (strcmp(value, "text") == 0)
+                g_config.output = OUTPUT_TEXT;
+            else
+                return -1;
+            break;
+        default:
+            fprintf(stderr, "Unknown option: %s\n", argv[i - 1]);
+            return -1;
+        }
+    }
+
+    if (g_config.port == 0 || g_config.clients <= 0 || g_config.duration <= 0 || g_config.ops_per_client < 0 ||
+        g_config.small_size < 0 || g_config.small_files <= 0 || g_config.large_size < 0 ||
+        parse_mix(g_config.mix, g_config.weights) != 0)
+        return -1;
+    return 0;
+}
+
+static void print_report(bench_series_t *totals, double elapsed)
+{
+    long long ops = 0, errors = 0, bytes = 0;
+    for (int i = 0; i < OP_COUNT; i++)
+    {
+        ops += (long long)totals[i].count;
+        errors += totals[i].errors;
+        bytes += totals[i].bytes;
+    }
+
+    if (g_config.output == OUTPUT_JSON)
+    {
+        printf("{\"host\":\"%s\",\"port\":%u,\"clients\":%d,\"mix\":\"%s\",\"elapsed_s\":%.3f,\"ops\":{",
+               g_config.host, g_config.port, g_config.clients, g_config.mix, elapsed);
+        int first = 1;
+        for (int i = 0; i < OP_COUNT; i++)
+        {
+            const bench_series_t *s = &totals[i];
+            if (g_config.weights[i] == 0)
+                continue;
+            printf("%s\"%s\":{\"count\":%zu,\"errors\":%lld,\"ops_per_s\":%.1f,\"p50_us\":%lld,"
+                   "\"p99_us\":%lld,\"p999_us\":%lld,\"max_us\":%lld,\"bytes\":%lld,\"bytes_per_s\":%.0f}",
+                   first ? "" : ",", g_op_names[i], s->count, s->errors, (double)s->count / elapsed,
+                   percentile(s, 0.5), percentile(s, 0.99), percentile(s, 0.999), percentile(s, 1.0),
+                   s->bytes, (double)s->bytes / elapsed);
+            first = 0;
+        }
+        printf("},\"total\":{\"count\":%lld,\"errors\":%lld,\"ops_per_s\":%.1f,\"bytes\":%lld,\"bytes_per_s\":%.0f}}\n",
+               ops, errors, (double)ops / elapsed, bytes, (double)bytes / elapsed);
+        return;
+    }
+
+    if (g_config.output == OUTPUT_CSV)
+        printf("op,count,errors,ops_per_s,p50_us,p99_us,p999_us,max_us,bytes,bytes_per_s\n");
+    else
+    {
+        printf("%d clients, mix %s, %.2f s\n", g_config.clients, g_config.mix, elapsed);
+        printf("%-6s %9s %7s %10s %9s %9s %9s %9s %12s\n", "op", "count", "errors", "ops/s",
+               "p50 us", "p99 us", "p999 us", "max us", "MB/s");
+    }
+
+    for (int i = 0; i < OP_COUNT; i++)
+    {
+        const bench_series_t *s = &totals[i];
+        if (g_config.weights[i] == 0)
+            continue;
+        if (g_config.output == OUTPUT_CSV)
+            printf("%s,%zu,%lld,%.1f,%lld,%lld,%lld,%lld,%lld,%.0f\n", g_op_names[i], s->count, s->errors,
+                   (double)s->count / elapsed, percentile(s, 0.5), percentile(s, 0.99), percentile(s, 0.999),
+                   percentile(s, 1.0), s->bytes, (double)s->bytes / elapsed);
+        else
+            printf("%-6s %9zu %7lld %10.1f %9lld %9lld %9lld %9lld %12.2f\n", g_op_names[i], s->count, s->errors,
+                   (double)s->count / elapsed, percentile(s, 0.5), percentile(s, 0.99), percentile(s, 0.999),
+                   percentile(s, 1.0), (double)s->bytes / elapsed / (1024.0 * 1024.0));
+    }
+
+    if (g_config.output == OUTPUT_CSV)
+        printf("total,%lld,%lld,%.1f,,,,,%lld,%.0f\n", ops, errors, (double)ops / elapsed, bytes,
+               (double)bytes / elapsed);
+    else
+        printf("%-6s %9lld %7lld %10.1f %9s %9s %9s %9s %12.2f\n", "total", ops, errors, (double)ops / elapsed,
+               "", "", "", "", (double)bytes / elapsed / (1024.0 * 1024.0));
+}
+
+int main(int argc, char **argv)
+{
+    if (parse_args(argc, argv) != 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    logger_init(0, LOG_LEVEL_ERROR);
+    if (net_init() != 0)
+    {
+        fprintf(stderr, "net_init failed\n");
+        return 1;
+    }
+
+    bench_client_t *clients = calloc((size_t)g_config.clients, sizeof(bench_client_t));
+    char *pattern = malloc(BENCH_BUFFER_SIZE);
+    if (!clients || !pattern)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < BENCH_BUFFER_SIZE; i++)
+        pattern[i] = (char)('a' + i % 26);
+
+    if (fixtures(0, pattern) != 0)
+    {
+        fixtures(1, pattern);
+        return 1;
+    }
+
+    double start = now_seconds();
+    g_deadline = start + g_config.duration;
+    int started = 0;
+    for (int i = 0; i < g_config.clients; i++)
+    {
+        clients[i].id = i;
+        clients[i].rng = 0x9E3779B97F4A7C15ULL * (unsigned long long)(i + 1);
+        clients[i].buffer = malloc(BENCH_BUFFER_SIZE);
+        if (!clients[i].buffer)
+            break;
+        memcpy(clients[i].buffer, pattern, BENCH_BUFFER_SIZE);
+        if (pthread_create(&clients[i].thread, NULL, client_thread, &clients[i]) != 0)
+            break;
+        started++;
+    }
+    for (int i = 0; i < started; i++)
+        pthread_join(clients[i].thread, NULL);
+    double elapsed = now_seconds() - start;
+
+    // Merge the clients' samples per operation
+    bench_series_t totals[OP_COUNT];
+    memset(totals, 0, sizeof(totals));
+    for (int i = 0; i < started; i++)
+    {
+        for (int op = 0; op < OP_COUNT; op++)
+        {
+            bench_series_t *s = &clients[i].series[op];
+            for (size_t k = 0; k < s->count; k++)
+                series_add(&totals[op], s->samples_us[k]);
+            totals[op].errors += s->errors;
+            totals[op].bytes += s->bytes;
+            free(s->samples_us);
+        }
+    }
+    for (int i = 0; i < g_config.clients; i++)
+        free(clients[i].buffer);
+    for (int op = 0; op < OP_COUNT; op++)
+        qsort(totals[op].samples_us, totals[op].count, sizeof(long long), compare_samples);
+
+    fixtures(1, pattern);
+    print_report(totals, elapsed);
+
+    // Fail when a selected operation never succeeded, so the run can gate a build
+    int failed = started < g_config.clients;
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        if (g_config.weights[op] > 0 && totals[op].count == 0 && totals[op].errors > 0)
+            failed = 1;
+        free(totals[op].samples_us);
+    }
+
+    free(pattern);
+    free(clients);
+    net_cleanup();
+    logger_close();
+    return failed ? 1 : 0;
+}
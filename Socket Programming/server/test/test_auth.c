@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "auth.h"
+#include "logger.h"
+
+#define USER_COUNT 20000
+#define READER_THREADS 4
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+static const char *g_db_path = "/tmp/ftp_auth_test_users.db";
+static char g_alice_hash[65];
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void test_basic_users()
+{
+    printf("\n--- Test 1: Add and Authenticate ---\n");
+
+    if (auth_add_user("alice", "secret", "/alice", AUTH_PERM_READ | AUTH_PERM_WRITE) != 0 ||
+        auth_add_user("alice", "other", "/alice", AUTH_PERM_READ) == 0)
+    {
+        test_fail("Add user", "duplicate handling wrong");
+        return;
+    }
+    if (!auth_authenticate("alice", "secret") || auth_authenticate("alice", "wrong") ||
+        auth_authenticate("nobody", "secret"))
+    {
+        test_fail("Authenticate", "credential check wrong");
+        return;
+    }
+    if (!auth_has_permission("alice", AUTH_PERM_WRITE) || auth_has_permission("alice", AUTH_PERM_ADMIN))
+    {
+        test_fail("Permissions", "permission check wrong");
+        return;
+    }
+
+    const auth_user_t *anonymous = auth_get_user("anonymous");
+    if (!anonymous || strcmp(anonymous->home_dir, "/pub") != 0)
+        test_fail("Anonymous", "virtual anonymous user missing");
+    auth_user_release(anonymous);
+
+    const auth_user_t *alice = auth_get_user("alice");
+    if (!alice)
+    {
+        test_fail("Get user", "alice not found");
+        return;
+    }
+    snprintf(g_alice_hash, sizeof(g_alice_hash), "%s", alice->password_hash);
+    auth_user_release(alice);
+    test_pass("Add and authenticate");
+}
+
+static int write_database(int count)
+{
+    FILE *fp = fopen(g_db_path, "w");
+    if (!fp)
+        return -1;
+    fprintf(fp, "# test database\n");
+    fprintf(fp, "alice:%s:/alice:3\n", g_alice_hash);
+    for (int i = 0; i < count; i++)
+        fprintf(fp, "user%d:%s:/users/user%d:1\n", i, g_alice_hash, i);
+    fprintf(fp, "user0:%s:/duplicate:255\n", g_alice_hash);
+    fclose(fp);
+    return 0;
+}
+
+static void test_large_database()
+{
+    printf("\n--- Test 2: Load Large Database ---\n");
+
+    if (write_database(USER_COUNT) != 0 || auth_load_users(g_db_path) != 0)
+    {
+        test_fail("Large database", "load failed");
+        return;
+    }
+    if (auth_get_user_count() != USER_COUNT + 1)
+    {
+        test_fail("Large database", "unexpected user count");
+        return;
+    }
+    if (!auth_authenticate("user12345", "secret") || !auth_user_exists("user19999") ||
+        auth_user_exists("user20000"))
+    {
+        test_fail("Large database", "lookup failed");
+        return;
+    }
+    const auth_user_t *user = auth_get_user("user0");
+    if (!user || strcmp(user->home_dir, "/users/user0") != 0)
+        test_fail("Large database", "duplicate entry replaced the first one");
+    else
+        test_pass("Large database");
+    auth_user_release(user);
+}
+
+static int g_stop = 0;
+
+static void *reader_thread(void *arg)
+{
+    long errors = 0;
+    unsigned int seed = (unsigned int)(size_t)arg;
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE))
+    {
+        char name[32];
+        seed = seed * 1103515245u + 12345u;
+        int id = (int)((seed >> 8) % USER_COUNT);
+        snprintf(name, sizeof(name), "user%d", id);
+
+        if (!auth_authenticate(name, "secret"))
+            errors++;
+
+        const auth_user_t *user = auth_get_user(name);
+        if (!user || strcmp(user->username, name) != 0)
+            errors++;
+        auth_user_release(user);
+    }
+    return (void *)errors;
+}
+
+static void test_reload_under_load()
+{
+    printf("\n--- Test 3: Reload While Logging In ---\n");
+
+    // Held across reloads: must stay readable until released
+    const auth_user_t *pinned = auth_get_user("user42");
+
+    pthread_t threads[READER_THREADS];
+    for (int i = 0; i < READER_THREADS; i++)
+        pthread_create(&threads[i], NULL, reader_thread, (void *)(size_t)(i + 1));
+
+    int reload_failures = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        if (auth_load_users(g_db_path) != 0)
+            reload_failures++;
+    }
+
+    __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+    long errors = 0;
+    for (int i = 0; i < READER_THREADS; i++)
+    {
+        void *result;
+        pthread_join(threads[i], &result);
+        errors += (long)result;
+    }
+
+    int pinned_ok = pinned && strcmp(pinned->username, "user42") == 0 && strcmp(pinned->home_dir, "/users/user42") == 0;
+    auth_user_release(pinned);
+
+    if (reload_failures || errors || !pinned_ok)
+        test_fail("Reload under load", "lookups failed during reload");
+    else
+        test_pass("Reload under load");
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Authentication Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+    auth_init();
+
+    test_basic_users();
+    test_large_database();
+    test_reload_under_load();
+
+    auth_cleanup();
+    remove(g_db_path);
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
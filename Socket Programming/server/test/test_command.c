@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "command.h"
+#include "logger.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+// What the handlers and context callbacks saw
+static const char *g_handled = NULL;
+static unsigned g_state = 0;
+static unsigned g_refused = 0;
+static unsigned g_cleared = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static int handle_a(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    (void)context;
+    (void)cmd;
+    g_handled = "A";
+    return 0;
+}
+
+static int handle_b(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    (void)context;
+    (void)cmd;
+    g_handled = "B";
+    return 0;
+}
+
+static int handle_echo(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    (void)context;
+    g_handled = cmd->command;
+    return 0;
+}
+
+static unsigned mock_state(cmd_handler_context_t context)
+{
+    (void)context;
+    return g_state;
+}
+
+static int mock_refuse(cmd_handler_context_t context, unsigned missing)
+{
+    (void)context;
+    g_refused = missing;
+    return 0;
+}
+
+static void mock_clear(cmd_handler_context_t context, unsigned flags)
+{
+    (void)context;
+    g_cleared |= flags;
+}
+
+static const cmd_context_ops_t g_mock_ops = {mock_state, mock_refuse, mock_clear};
+
+/**
+ * @brief Dispatches a command name and returns the handler that ran, or NULL
+ */
+static const char *dispatch(const char *name)
+{
+    proto_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    snprintf(cmd.command, sizeof(cmd.command), "%.*s", (int)sizeof(cmd.command) - 1, name);
+    g_handled = NULL;
+    g_refused = 0;
+    g_cleared = 0;
+    cmd_dispatch(NULL, &cmd);
+    return g_handled;
+}
+
+static void test_lookup()
+{
+    printf("\n--- Test 1: Lookup ---\n");
+
+    cmd_init();
+    cmd_register_handler("user", handle_a, 0);
+    cmd_register_handler("XSHA256", handle_b, 0);
+    cmd_register_handler("XSHA1", handle_echo, 0);
+
+    if (!cmd_is_registered("USER") || !cmd_is_registered("User") || cmd_get_handler_count() != 3)
+        test_fail("Case", "registered name not found in another case");
+    else
+        test_pass("Case");
+
+    // Keys pack 4 characters: longer names must be confirmed, prefixes must not match
+    const char *a = dispatch("USER");
+    const char *b = dispatch("XSHA256");
+    const char *c = dispatch("XSHA1");
+    if (!a || strcmp(a, "A") != 0 || !b || strcmp(b, "B") != 0 || !c || strcmp(c, "XSHA1") != 0)
+        test_fail("Dispatch", "wrong handler called");
+    else
+        test_pass("Dispatch");
+
+    if (dispatch("USE") || dispatch("USERS") || dispatch("XSHA") || dispatch("XSHA25") ||
+        cmd_is_registered("XSHA512"))
+        test_fail("Unknown", "unregistered name matched");
+    else
+        test_pass("Unknown");
+
+    // Registering again replaces the handler and its flags
+    cmd_register_handler("USER", handle_b, CMD_CLEAR_ALL);
+    a = dispatch("USER");
+    if (!a || strcmp(a, "B") != 0 || cmd_get_handler_count() != 3 || cmd_get_handler_flags("user") != CMD_CLEAR_ALL)
+        test_fail("Replace", "re-registration not applied");
+    else
+        test_pass("Replace");
+
+    cmd_cleanup();
+}
+
+static void test_flags()
+{
+    printf("\n--- Test 2: Flags ---\n");
+
+    cmd_init();
+    cmd_register_handler("RETR", handle_a, CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_RENAME);
+    cmd_register_handler("RNTO", handle_a, CMD_NEED_AUTH | CMD_CLEAR_RESTART);
+    cmd_register_handler("NOOP", handle_b, 0);
+
+    // Without callbacks the flags are ignored
+    if (!dispatch("RETR"))
+        test_fail("No callbacks", "command refused without context callbacks");
+    else
+        test_pass("No callbacks");
+
+    cmd_set_context_ops(&g_mock_ops);
+
+    g_state = 0;
+    const char *handled = dispatch("RETR");
+    if (handled || g_refused != (CMD_NEED_AUTH | CMD_NEED_DATA) || g_cleared != CMD_CLEAR_RENAME)
+        test_fail("Not logged in", "handler ran without its preconditions");
+    else
+        test_pass("Not logged in");
+
+    g_state = CMD_NEED_AUTH;
+    handled = dispatch("RETR");
+    if (handled || g_refused != CMD_NEED_DATA)
+        test_fail("No data connection", "handler ran before PORT/PASV");
+    else
+        test_pass("No data connection");
+
+    g_state = CMD_NEED_AUTH | CMD_NEED_DATA;
+    handled = dispatch("RETR");
+    if (!handled || g_refused != 0 || g_cleared != CMD_CLEAR_RENAME)
+        test_fail("Preconditions met", "handler not called");
+    else
+        test_pass("Preconditions met");
+
+    handled = dispatch("RNTO");
+    if (!handled || g_cleared != CMD_CLEAR_RESTART)
+        test_fail("Clear restart", "wrong state cleared");
+    else
+        test_pass("Clear restart");
+
+    handled = dispatch("NOOP");
+    if (!handled || g_cleared != 0 || g_refused != 0)
+        test_fail("No flags", "command without flags touched state");
+    else
+        test_pass("No flags");
+
+    cmd_cleanup();
+}
+
+static void test_full_table()
+{
+    printf("\n--- Test 3: Full Table ---\n");
+
+    cmd_init();
+    if (cmd_register_standard_handlers() != 0)
+        test_fail("Standard", "standard handlers did not register");
+    else
+        test_pass("Standard");
+
+    unsigned retr = cmd_get_handler_flags("RETR");
+    unsigned rnto = cmd_get_handler_flags("RNTO");
+    if (retr != (CMD_NEED_AUTH | CMD_NEED_DATA | CMD_CLEAR_RENAME) || rnto != (CMD_NEED_AUTH | CMD_CLEAR_RESTART) ||
+        cmd_get_handler_flags("USER") & CMD_NEED_AUTH || cmd_get_handler_flags("FEAT") != 0)
+        test_fail("Standard flags", "unexpected preconditions");
+    else
+        test_pass("Standard flags");
+    cmd_set_context_ops(NULL);
+
+    // Filling every slot forces new multipliers; all names must stay reachable in one probe
+    int standard = cmd_get_handler_count();
+    char names[CMD_MAX_HANDLERS][16];
+    int added = 0;
+    for (int i = 0; standard + added < CMD_MAX_HANDLERS; i++)
+    {
+        snprintf(names[added], sizeof(names[added]), "Z%03d", i);
+        if (cmd_register_handler(names[added], handle_echo, 0) != 0)
+            break;
+        added++;
+    }
+    if (standard + added != CMD_MAX_HANDLERS || cmd_register_handler("ZFULL", handle_echo, 0) == 0)
+        test_fail("Capacity", "table did not fill up to its limit");
+    else
+        test_pass("Capacity");
+
+    int reachable = 1;
+    for (int i = 0; i < added; i++)
+    {
+        const char *handled = dispatch(names[i]);
+        if (!handled || strcmp(handled, names[i]) != 0)
+            reachable = 0;
+    }
+    if (!reachable || !cmd_is_registered("XSHA256") || !cmd_is_registered("CWD") || !cmd_is_registered("MLSD"))
+        test_fail("Reachable", "commands lost after rehashing");
+    else
+        test_pass("Reachable");
+
+    // Freed slots can be taken again, the others keep working
+    if (cmd_unregister_handler("Z000") != 0 || cmd_is_registered("Z000") || !cmd_is_registered("Z001") ||
+        cmd_register_handler("ZNEW", handle_echo, 0) != 0 || !dispatch("ZNEW") || cmd_unregister_handler("Z000") == 0)
+        test_fail("Unregister", "slot not reused");
+    else
+        test_pass("Unregister");
+
+    cmd_cleanup();
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Command Dispatch Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+
+    test_lookup();
+    test_flags();
+    test_full_table();
+
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
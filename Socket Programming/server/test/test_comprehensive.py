@@ -8,10 +8,12 @@ import ftplib
 import threading
 import time
 import os
+import io
 import tempfile
 import random
 import string
 import socket
+import zlib
 from pathlib import Path
 
 # Server configuration
@@ -636,6 +638,124 @@ def test_error_handling():
     except Exception as e:
         results.add_result("Error handling", False, str(e))
 
+# ============================================================================
+# Test 11: MODE Z (Deflate)
+# ============================================================================
+
+def test_mode_z():
+    """Test deflate compressed transfers"""
+    print("\n--- Test 11: MODE Z ---")
+    try:
+        ftp = ftplib.FTP()
+        ftp.connect(FTP_HOST, FTP_PORT, timeout=10)
+        ftp.login(FTP_USER, FTP_PASS)
+        ftp.sendcmd('TYPE I')
+
+        if 'MODE Z' not in ftp.sendcmd('FEAT'):
+            # Built without zlib: the mode must be refused
+            try:
+                ftp.sendcmd('MODE Z')
+                results.add_result("MODE Z refused without zlib", False, "Should have failed")
+            except ftplib.error_perm:
+                results.add_result("MODE Z refused without zlib", True)
+            ftp.quit()
+            return
+
+        text = ''.join(f"line {i}: {random_string(20)} the quick brown fox\n" for i in range(20000)).encode()
+        noise = os.urandom(256 * 1024)
+        test_filename = f"test_modez_{random_string()}.txt"
+        random_filename = f"test_modez_{random_string()}.bin"
+
+        # Upload in MODE Z, then check the stored file in stream mode
+        ftp.sendcmd('MODE Z')
+        ftp.sendcmd('OPTS MODE Z LEVEL 9')
+        for name, data in ((test_filename, text), (random_filename, noise)):
+            conn = ftp.transfercmd(f'STOR {name}')
+            conn.sendall(zlib.compress(data, 6))
+            conn.close()
+            ftp.voidresp()
+
+        ftp.sendcmd('MODE S')
+        stored = bytearray()
+        ftp.retrbinary(f'RETR {test_filename}', stored.extend)
+        results.add_result("MODE Z upload", bytes(stored) == text,
+                           "" if bytes(stored) == text else "Stored data differs")
+
+        # Download in MODE Z: compressible text shrinks, random data is stored
+        ftp.sendcmd('MODE Z')
+        for name, data, label in ((test_filename, text, "text"), (random_filename, noise, "random")):
+            conn = ftp.transfercmd(f'RETR {name}')
+            wire = bytearray()
+            while True:
+                chunk = conn.recv(65536)
+                if not chunk:
+                    break
+                wire.extend(chunk)
+            conn.close()
+            ftp.voidresp()
+            ok = zlib.decompress(bytes(wire)) == data
+            if label == "text":
+                ok = ok and len(wire) < len(data) // 2
+            else:
+                ok = ok and len(wire) < len(data) + len(data) // 100
+            results.add_result(f"MODE Z download ({label})", ok,
+                               "" if ok else f"{len(wire)} bytes on the wire for {len(data)}")
+
+        conn = ftp.transfercmd('NLST')
+        wire = bytearray()
+        while True:
+            chunk = conn.recv(65536)
+            if not chunk:
+                break
+            wire.extend(chunk)
+        conn.close()
+        ftp.voidresp()
+        names = zlib.decompress(bytes(wire)).decode().split('\r\n')
+        results.add_result("MODE Z name list", test_filename in names)
+
+        ftp.sendcmd('MODE S')
+        ftp.delete(test_filename)
+        ftp.delete(random_filename)
+        ftp.quit()
+    except Exception as e:
+        results.add_result("MODE Z", False, str(e))
+
+# ============================================================================
+# Test 12: ALLO + STOR (preallocated upload)
+# ============================================================================
+
+def test_allo():
+    """Test ALLO size hints for uploads"""
+    print("\n--- Test 12: ALLO ---")
+    try:
+        ftp = ftplib.FTP()
+        ftp.connect(FTP_HOST, FTP_PORT, timeout=10)
+        ftp.login(FTP_USER, FTP_PASS)
+        ftp.sendcmd('TYPE I')
+
+        # Announce more than is sent: the stored file must not keep the reserve
+        test_data = generate_test_data(100 * 1024)
+        test_filename = f"test_allo_{random_string()}.bin"
+        resp = ftp.sendcmd(f'ALLO {len(test_data) * 4}')
+        ftp.storbinary(f'STOR {test_filename}', io.BytesIO(test_data))
+        size = ftp.size(test_filename)
+        ok = resp.startswith('200') and size == len(test_data)
+        results.add_result("ALLO + STOR", ok, "" if ok else f"Reply {resp}, size {size}")
+
+        ftp.sendcmd('ALLO 1024 R 128')
+        results.add_result("ALLO with record size", True)
+
+        try:
+            ftp.sendcmd('ALLO lots')
+            results.add_result("ALLO rejects bad size", False, "Should have failed")
+        except ftplib.error_perm:
+            results.add_result("ALLO rejects bad size", True)
+
+        ftp.delete(test_filename)
+        ftp.quit()
+    except Exception as e:
+        results.add_result("ALLO", False, str(e))
+
 # ============================================================================
 # Main Test Runner
 # ============================================================================
@@ -671,6 +791,8 @@ def main():
     test_file_locking()
     test_transfer_types()
     test_error_handling()
+    test_mode_z()
+    test_allo()
     
     # Print summary
     results.summary()
@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "datacomp.h"
+#include "network.h"
+#include "logger.h"
+
+#define TEXT_SIZE (3 * 1024 * 1024)
+#define RANDOM_SIZE (2 * 1024 * 1024)
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void fill_text(char *buf, size_t len)
+{
+    static const char *words[] = {"transfer ", "server ", "client ", "directory ", "file ", "mode ", "\n"};
+    size_t i = 0;
+    unsigned int seed = 7;
+    while (i < len)
+    {
+        seed = seed * 1103515245u + 12345u;
+        const char *word = words[(seed >> 16) % 7];
+        for (size_t j = 0; word[j] && i < len; j++)
+            buf[i++] = word[j];
+    }
+}
+
+static void fill_random(char *buf, size_t len, unsigned int seed)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = (char)(seed >> 16);
+    }
+}
+
+static void test_heuristic()
+{
+    printf("\n--- Test 1: Incompressible Data Detection ---\n");
+
+    char *text = malloc(DATACOMP_SAMPLE_SIZE);
+    char *noise = malloc(DATACOMP_SAMPLE_SIZE);
+    fill_text(text, DATACOMP_SAMPLE_SIZE);
+    fill_random(noise, DATACOMP_SAMPLE_SIZE, 3);
+
+    if (datacomp_is_incompressible(text, DATACOMP_SAMPLE_SIZE))
+        test_fail("Heuristic", "text taken as incompressible");
+    else if (!datacomp_is_incompressible(noise, DATACOMP_SAMPLE_SIZE))
+        test_fail("Heuristic", "random data taken as compressible");
+    else if (datacomp_is_incompressible(noise, 100))
+        test_fail("Heuristic", "short sample judged");
+    else
+        test_pass("Heuristic");
+
+    free(text);
+    free(noise);
+}
+
+typedef struct
+{
+    socket_t sock;
+    const char *data;
+    size_t length;
+    int level;
+    int adaptive;
+    int result;
+    long long bytes_out;
+} writer_args_t;
+
+static void *writer_thread(void *arg)
+{
+    writer_args_t *args = (writer_args_t *)arg;
+    args->result = -1;
+
+    datacomp_writer_t *writer = datacomp_writer_create(args->sock, args->level, args->adaptive);
+    if (writer)
+    {
+        // Uneven pieces, like file reads and listing lines
+        size_t pos = 0;
+        size_t piece = 1;
+        int rc = 0;
+        while (pos < args->length && rc == 0)
+        {
+            size_t n = piece > args->length - pos ? args->length - pos : piece;
+            rc = datacomp_writer_write(writer, args->data + pos, n);
+            pos += n;
+            piece = piece * 3 % 100003 + 1;
+        }
+        if (rc == 0 && datacomp_writer_finish(writer) == 0)
+            args->result = 0;
+        datacomp_writer_get_totals(writer, NULL, &args->bytes_out);
+        datacomp_writer_destroy(writer);
+    }
+
+    net_shutdown_send(args->sock);
+    return NULL;
+}
+
+/**
+ * Streams data through a writer and a reader over a socket pair.
+ * @return 0 if the data arrived intact, -1 otherwise.
+ */
+static int round_trip(const char *data, size_t length, int level, int adaptive, long long *bytes_out)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        return -1;
+
+    writer_args_t args = {fds[0], data, length, level, adaptive, -1, 0};
+    pthread_t thread;
+    pthread_create(&thread, NULL, writer_thread, &args);
+
+    char *received = malloc(length + 1);
+    char buffer[8192];
+    size_t total = 0;
+    int ok = 1;
+    datacomp_reader_t *reader = datacomp_reader_create(fds[1]);
+    for (;;)
+    {
+        int n = reader ? datacomp_reader_receive(reader, buffer, sizeof(buffer)) : -1;
+        if (n < 0 || total + (size_t)n > length)
+        {
+            ok = 0;
+            break;
+        }
+        if (n == 0)
+            break;
+        memcpy(received + total, buffer, (size_t)n);
+        total += (size_t)n;
+    }
+    datacomp_reader_destroy(reader);
+    if (!ok)
+        shutdown(fds[1], SHUT_RDWR); // Unblock the writer
+
+    pthread_join(thread, NULL);
+    net_close_socket(fds[0]);
+    net_close_socket(fds[1]);
+
+    ok = ok && args.result == 0 && total == length && memcmp(received, data, length) == 0;
+    free(received);
+    *bytes_out = args.bytes_out;
+    return ok ? 0 : -1;
+}
+
+static void test_round_trip()
+{
+    printf("\n--- Test 2: Compressed Round Trip ---\n");
+
+    // Text, then random data, then text again
+    size_t length = TEXT_SIZE + RANDOM_SIZE + TEXT_SIZE;
+    char *data = malloc(length);
+    fill_text(data, TEXT_SIZE);
+    fill_random(data + TEXT_SIZE, RANDOM_SIZE, 5);
+    fill_text(data + TEXT_SIZE + RANDOM_SIZE, TEXT_SIZE);
+
+    long long text_out = 0;
+    if (round_trip(data, TEXT_SIZE, DATACOMP_DEFAULT_LEVEL, 0, &text_out) != 0)
+        test_fail("Text round trip", "data corrupted");
+    else if (text_out * 4 > TEXT_SIZE)
+        test_fail("Text round trip", "text barely compressed");
+    else
+        test_pass("Text round trip");
+
+    // Stretches are noticed within a resample interval plus one write
+    long long mixed_out = 0;
+    if (round_trip(data, length, 9, 1, &mixed_out) != 0)
+        test_fail("Mixed adaptive round trip", "data corrupted");
+    else if (mixed_out > RANDOM_SIZE + RANDOM_SIZE / 50 + text_out * 2 + DATACOMP_RESAMPLE_INTERVAL / 4)
+        test_fail("Mixed adaptive round trip", "output larger than expected");
+    else
+        test_pass("Mixed adaptive round trip");
+
+    // Stored blocks add only a few bytes per 64KB
+    long long random_out = 0;
+    if (round_trip(data + TEXT_SIZE, RANDOM_SIZE, DATACOMP_DEFAULT_LEVEL, 1, &random_out) != 0)
+        test_fail("Random data stored", "data corrupted");
+    else if (random_out > RANDOM_SIZE + RANDOM_SIZE / 1000)
+        test_fail("Random data stored", "random data was not stored");
+    else
+        test_pass("Random data stored");
+
+    long long empty_out = 0;
+    if (round_trip(data, 0, DATACOMP_DEFAULT_LEVEL, 1, &empty_out) != 0 || empty_out == 0)
+        test_fail("Empty stream", "empty transfer failed");
+    else
+        test_pass("Empty stream");
+
+    free(data);
+}
+
+static void test_bad_streams()
+{
+    printf("\n--- Test 3: Corrupt and Truncated Streams ---\n");
+
+    int fds[2];
+    char buffer[1024];
+
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    net_send_all(fds[0], "this is not a zlib stream", 25);
+    net_shutdown_send(fds[0]);
+    datacomp_reader_t *reader = datacomp_reader_create(fds[1]);
+    int rc = datacomp_reader_receive(reader, buffer, sizeof(buffer));
+    datacomp_reader_destroy(reader);
+    net_close_socket(fds[0]);
+    net_close_socket(fds[1]);
+    if (rc != DATACOMP_STREAM_ERROR)
+        test_fail("Corrupt stream", "garbage accepted");
+    else
+        test_pass("Corrupt stream");
+
+    // A stream cut short must not look like a complete upload
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    net_send_all(fds[0], "\x78\x9c", 2); // zlib header, no data
+    net_shutdown_send(fds[0]);
+    reader = datacomp_reader_create(fds[1]);
+    do
+    {
+        rc = datacomp_reader_receive(reader, buffer, sizeof(buffer));
+    } while (rc > 0);
+    datacomp_reader_destroy(reader);
+    net_close_socket(fds[0]);
+    net_close_socket(fds[1]);
+    if (rc != DATACOMP_STREAM_ERROR)
+        test_fail("Truncated stream", "short stream accepted");
+    else
+        test_pass("Truncated stream");
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Data Compression Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+    net_init();
+
+    test_heuristic();
+
+    if (!datacomp_is_available())
+    {
+        printf("\n--- Built without zlib, MODE Z tests skipped ---\n");
+        if (datacomp_writer_create(0, DATACOMP_DEFAULT_LEVEL, 1) != NULL)
+            test_fail("Unavailable", "writer created without zlib");
+        else
+            test_pass("Unavailable");
+    }
+    else
+    {
+        test_round_trip();
+        test_bad_streams();
+    }
+
+    net_cleanup();
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "digest.h"
+#include "digestcache.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void check_digest(const char *test_name, digest_algorithm_t algorithm, const char *data,
+                         const char *expected)
+{
+    char hex[DIGEST_HEX_SIZE];
+    digest_hex(algorithm, data, strlen(data), hex);
+    if (strcmp(hex, expected) != 0)
+        test_fail(test_name, hex);
+    else
+        test_pass(test_name);
+}
+
+static void test_vectors()
+{
+    printf("\n--- Test 1: Known Vectors (%s SHA-256, %s CRC32C) ---\n",
+           digest_implementation(DIGEST_SHA256), digest_implementation(DIGEST_CRC32C));
+
+    check_digest("SHA-256 empty", DIGEST_SHA256, "",
+                 "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    check_digest("SHA-256 abc", DIGEST_SHA256, "abc",
+                 "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    check_digest("SHA-256 two blocks", DIGEST_SHA256, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                 "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    check_digest("MD5 empty", DIGEST_MD5, "", "d41d8cd98f00b204e9800998ecf8427e");
+    check_digest("MD5 abc", DIGEST_MD5, "abc", "900150983cd24fb0d6963f7d28e17f72");
+    check_digest("CRC32 check value", DIGEST_CRC32, "123456789", "cbf43926");
+    check_digest("CRC32C check value", DIGEST_CRC32C, "123456789", "e3069283");
+}
+
+static void test_hardware_agrees()
+{
+    printf("\n--- Test 2: Chunked Updates and Portable Code ---\n");
+
+    size_t length = 100000;
+    unsigned char *data = (unsigned char *)malloc(length);
+    if (!data)
+    {
+        test_fail("Allocate data", "out of memory");
+        return;
+    }
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (unsigned char)(seed >> 16);
+    }
+
+    for (int alg = 0; alg < DIGEST_ALGORITHM_COUNT; alg++)
+    {
+        digest_algorithm_t algorithm = (digest_algorithm_t)alg;
+        char whole[DIGEST_HEX_SIZE];
+        char chunked[DIGEST_HEX_SIZE];
+        char portable[DIGEST_HEX_SIZE];
+
+        digest_use_hardware(1);
+        digest_hex(algorithm, data, length, whole);
+
+        // Odd chunk sizes cross block boundaries and the CRC alignment prologue
+        digest_ctx_t ctx;
+        digest_init(&ctx, algorithm);
+        size_t used = 0;
+        size_t chunk = 1;
+        while (used < length)
+        {
+            size_t n = (length - used < chunk) ? length - used : chunk;
+            digest_update(&ctx, data + used, n);
+            used += n;
+            chunk = chunk * 3 + 1;
+        }
+        digest_final_hex(&ctx, chunked);
+
+        digest_use_hardware(0);
+        digest_hex(algorithm, data, length, portable);
+        digest_use_hardware(1);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s chunked and portable", digest_algorithm_name(algorithm));
+        if (strcmp(whole, chunked) != 0)
+            test_fail(name, "chunked digest differs");
+        else if (strcmp(whole, portable) != 0)
+            test_fail(name, "portable digest differs");
+        else
+            test_pass(name);
+    }
+
+    free(data);
+}
+
+static void test_names()
+{
+    printf("\n--- Test 3: Algorithm Names ---\n");
+
+    digest_algorithm_t algorithm;
+    if (digest_parse_algorithm("sha-256", &algorithm) != 0 || algorithm != DIGEST_SHA256 ||
+        digest_parse_algorithm("CRC32C", &algorithm) != 0 || algorithm != DIGEST_CRC32C ||
+        digest_parse_algorithm("md5", &algorithm) != 0 || algorithm != DIGEST_MD5)
+        test_fail("Parse names", "known name rejected");
+    else
+        test_pass("Parse names");
+
+    if (digest_parse_algorithm("SHA-1", &algorithm) == 0 || digest_parse_algorithm("", &algorithm) == 0)
+        test_fail("Parse unknown", "unknown name accepted");
+    else
+        test_pass("Parse unknown");
+
+    if (strcmp(digest_algorithm_name(DIGEST_CRC32), "CRC32") != 0 ||
+        strcmp(digest_algorithm_name(DIGEST_SHA256), "SHA-256") != 0)
+        test_fail("Names", "unexpected name");
+    else
+        test_pass("Names");
+}
+
+static void test_cache()
+{
+    printf("\n--- Test 4: Checksum Cache ---\n");
+
+    if (digestcache_init(4) != 0)
+    {
+        test_fail("Init cache", "init failed");
+        return;
+    }
+
+    fs_stat_t st;
+    memset(&st, 0, sizeof(st));
+    st.type = FS_TYPE_FILE;
+    st.size = 100;
+    st.last_modified = 1700000000;
+
+    char hex[DIGEST_HEX_SIZE];
+    unsigned long generation = digestcache_get_generation();
+    digestcache_store("/srv/a.bin", &st, DIGEST_SHA256, 0, generation, "aaaa");
+
+    if (digestcache_lookup("/srv/a.bin", &st, DIGEST_SHA256, 0, hex) != 0 || strcmp(hex, "aaaa") != 0)
+        test_fail("Hit", "stored checksum not found");
+    else
+        test_pass("Hit");
+
+    if (digestcache_lookup("/srv/a.bin", &st, DIGEST_MD5, 0, hex) == 0 ||
+        digestcache_lookup("/srv/a.bin", &st, DIGEST_SHA256, 10, hex) == 0)
+        test_fail("Key", "other algorithm or offset hit");
+    else
+        test_pass("Key");
+
+    fs_stat_t changed = st;
+    changed.size = 101;
+    if (digestcache_lookup("/srv/a.bin", &changed, DIGEST_SHA256, 0, hex) == 0 ||
+        digestcache_lookup("/srv/a.bin", &st, DIGEST_SHA256, 0, hex) == 0)
+        test_fail("Changed file", "stale checksum returned");
+    else
+        test_pass("Changed file");
+
+    // Invalidating a directory drops the files below it, and a racing store is refused
+    generation = digestcache_get_generation();
+    digestcache_store("/srv/dir/b.bin", &st, DIGEST_CRC32, 0, generation, "bbbb");
+    digestcache_store("/srv/dirx.bin", &st, DIGEST_CRC32, 0, generation, "cccc");
+    unsigned long before = digestcache_get_generation();
+    digestcache_invalidate("/srv/dir/");
+    digestcache_store("/srv/dir/c.bin", &st, DIGEST_CRC32, 0, before, "dddd");
+    if (digestcache_lookup("/srv/dir/b.bin", &st, DIGEST_CRC32, 0, hex) == 0 ||
+        digestcache_lookup("/srv/dir/c.bin", &st, DIGEST_CRC32, 0, hex) == 0 ||
+        digestcache_lookup("/srv/dirx.bin", &st, DIGEST_CRC32, 0, hex) != 0)
+        test_fail("Invalidate", "unexpected entries");
+    else
+        test_pass("Invalidate");
+
+    fs_stat_t recent = st;
+    recent.last_modified = time(NULL);
+    digestcache_store("/srv/new.bin", &recent, DIGEST_CRC32, 0, digestcache_get_generation(), "eeee");
+    if (digestcache_lookup("/srv/new.bin", &recent, DIGEST_CRC32, 0, hex) == 0)
+        test_fail("Recent file", "checksum of a file modified just now was cached");
+    else
+        test_pass("Recent file");
+
+    digestcache_cleanup();
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Digest Test Suite\n");
+    printf("============================================================\n");
+
+    test_vectors();
+    test_hardware_agrees();
+    test_names();
+    test_cache();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
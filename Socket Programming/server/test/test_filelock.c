@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#define usleep(us) Sleep((us) / 1000)
+#else
+#include <unistd.h>
+#endif
+
+#include "filelock.h"
+#include "logger.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void test_shared_exclusive()
+{
+    printf("\n--- Test 1: Shared / Exclusive Semantics ---\n");
+    const char *path = "/tmp/ftp_lock_test/file.bin";
+
+    if (file_lock_acquire_shared(path) != 0 || file_lock_try_acquire_shared(path) != 0)
+    {
+        test_fail("Shared locks", "failed to take two shared locks");
+        return;
+    }
+    if (file_lock_get_shared_lock_count(path) != 2)
+    {
+        test_fail("Shared locks", "expected 2 readers");
+        return;
+    }
+    if (file_lock_try_acquire_exclusive(path) == 0)
+    {
+        test_fail("Shared locks", "exclusive lock granted while readers hold the file");
+        return;
+    }
+    file_lock_release_shared(path);
+    file_lock_release_shared(path);
+    test_pass("Shared locks");
+
+    if (file_lock_try_acquire_exclusive(path) != 0 || file_lock_is_exclusive_locked(path) != 1)
+    {
+        test_fail("Exclusive lock", "failed to take exclusive lock on idle file");
+        return;
+    }
+    if (file_lock_try_acquire_shared(path) == 0 || file_lock_try_acquire_exclusive(path) == 0)
+    {
+        test_fail("Exclusive lock", "second lock granted while writer holds the file");
+        return;
+    }
+    file_lock_release_exclusive(path);
+    if (file_lock_is_exclusive_locked(path) != 0 || file_lock_get_shared_lock_count(path) != 0)
+    {
+        test_fail("Exclusive lock", "lock still reported after release");
+        return;
+    }
+    test_pass("Exclusive lock");
+}
+
+static void *blocked_reader(void *arg)
+{
+    const char *path = (const char *)arg;
+    file_lock_acquire_shared(path);
+    file_lock_release_shared(path);
+    return NULL;
+}
+
+static void test_blocked_reader_wakes()
+{
+    printf("\n--- Test 2: Blocked Reader Wakes After Writer ---\n");
+    const char *path = "/tmp/ftp_lock_test/blocked.bin";
+
+    file_lock_acquire_exclusive(path);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, blocked_reader, (void *)path) != 0)
+    {
+        test_fail("Blocked reader", "pthread_create failed");
+        file_lock_release_exclusive(path);
+        return;
+    }
+
+    usleep(50000);
+    // The waiting reader keeps the entry alive across this release
+    file_lock_release_exclusive(path);
+    pthread_join(thread, NULL);
+
+    if (file_lock_get_shared_lock_count(path) != 0 || file_lock_is_exclusive_locked(path) != 0)
+    {
+        test_fail("Blocked reader", "lock state not clean after reader finished");
+        return;
+    }
+    test_pass("Blocked reader");
+}
+
+static void test_many_paths()
+{
+    printf("\n--- Test 3: Many Distinct Paths ---\n");
+    char path[64];
+    const int count = 2000;
+
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(path, sizeof(path), "/tmp/ftp_lock_test/f%d", i);
+        if (file_lock_try_acquire_exclusive(path) != 0)
+        {
+            test_fail("Many paths", "distinct path reported busy");
+            return;
+        }
+    }
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(path, sizeof(path), "/tmp/ftp_lock_test/f%d", i);
+        if (file_lock_is_exclusive_locked(path) != 1)
+        {
+            test_fail("Many paths", "held lock not found");
+            return;
+        }
+        file_lock_release_exclusive(path);
+    }
+    snprintf(path, sizeof(path), "/tmp/ftp_lock_test/f%d", count / 2);
+    if (file_lock_is_exclusive_locked(path) != 0)
+    {
+        test_fail("Many paths", "lock still reported after release");
+        return;
+    }
+    test_pass("Many paths");
+}
+
+#define HANDLE_READERS 8
+#define HANDLE_ROUNDS 2000
+
+static void *handle_reader(void *arg)
+{
+    const char *path = (const char *)arg;
+    for (int i = 0; i < HANDLE_ROUNDS; i++)
+    {
+        file_lock_t *lock = file_lock_try_acquire_shared_handle(path);
+        if (!lock)
+            return (void *)1;
+        file_lock_release_shared_handle(lock);
+    }
+    return NULL;
+}
+
+static void *blocked_writer(void *arg)
+{
+    const char *path = (const char *)arg;
+    file_lock_acquire_exclusive(path);
+    file_lock_release_exclusive(path);
+    return NULL;
+}
+
+static void test_shared_handles()
+{
+    printf("\n--- Test 4: Shared Lock Handles ---\n");
+    const char *path = "/tmp/ftp_lock_test/segments.bin";
+
+    // Held by one reader throughout, so the others release without the shard mutex
+    file_lock_t *held = file_lock_try_acquire_shared_handle(path);
+    if (!held)
+    {
+        test_fail("Concurrent readers", "handle not granted on idle file");
+        return;
+    }
+
+    pthread_t threads[HANDLE_READERS];
+    for (int i = 0; i < HANDLE_READERS; i++)
+        pthread_create(&threads[i], NULL, handle_reader, (void *)path);
+    int refused = 0;
+    for (int i = 0; i < HANDLE_READERS; i++)
+    {
+        void *result;
+        pthread_join(threads[i], &result);
+        refused |= (result != NULL);
+    }
+    if (refused || file_lock_get_shared_lock_count(path) != 1)
+        test_fail("Concurrent readers", "reader count wrong after concurrent handle releases");
+    else
+        test_pass("Concurrent readers");
+
+    // A writer waits for the last handle; the path-based and handle releases mix
+    file_lock_acquire_shared(path);
+    pthread_t writer;
+    pthread_create(&writer, NULL, blocked_writer, (void *)path);
+    usleep(50000);
+    int blocked = file_lock_is_exclusive_locked(path) == 0 && file_lock_try_acquire_shared_handle(path) == NULL;
+    file_lock_release_shared_handle(held);
+    usleep(20000);
+    blocked = blocked && file_lock_is_exclusive_locked(path) == 0;
+    file_lock_release_shared(path);
+    pthread_join(writer, NULL);
+
+    if (!blocked || file_lock_get_shared_lock_count(path) != 0 || file_lock_is_exclusive_locked(path) != 0)
+        test_fail("Writer waits", "writer not held off until every reader released");
+    else
+        test_pass("Writer waits");
+
+    file_lock_release_shared_handle(NULL);
+    if (file_lock_try_acquire_exclusive(path) != 0)
+        test_fail("Entry recycled", "idle file still reported busy");
+    else
+        test_pass("Entry recycled");
+    file_lock_release_exclusive(path);
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("File Lock Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+
+    test_shared_exclusive();
+    test_blocked_reader_wakes();
+    test_many_paths();
+    test_shared_handles();
+
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
@@ -58,6 +58,51 @@ static void test_get_file_size()
     test_pass("Get file size");
 }
 
+static void test_stat_snapshot()
+{
+    printf("\n--- Test: Stat Snapshot ---\n");
+
+    char path[PATH_MAX];
+    snprintf(path, PATH_MAX, "%s/file1.txt", g_test_dir);
+
+    /* one call reports what fs_path_exists/fs_is_directory/fs_get_file_size would */
+    fs_stat_t st;
+    if (fs_stat(path, &st) != 0 || st.type != FS_TYPE_FILE || st.size != 11 ||
+        st.last_modified != fs_get_file_mtime(path))
+        test_fail("Stat snapshot", "file metadata mismatch");
+    if (fs_stat(g_test_dir, &st) != 0 || st.type != FS_TYPE_DIR || st.size != 0)
+        test_fail("Stat snapshot", "directory metadata mismatch");
+
+    char missing[PATH_MAX];
+    snprintf(missing, PATH_MAX, "%s/missing.txt", g_test_dir);
+    if (fs_stat(missing, &st) == 0 || fs_stat(NULL, &st) == 0)
+        test_fail("Stat snapshot", "missing path reported as existing");
+
+    /* an open file keeps describing itself after the path is replaced */
+    char other[PATH_MAX];
+    snprintf(other, PATH_MAX, "%s/stat_other.txt", g_test_dir);
+    fs_write_file_all(other, "abc", 3);
+    fs_file_t file;
+    if (fs_file_open(&file, path, FS_OPEN_READ) != 0)
+        test_fail("Stat snapshot", "open failed");
+#ifndef _WIN32
+    if (fs_replace_file(other, path) != 0 || fs_stat(path, &st) != 0 || st.size != 3)
+        test_fail("Stat snapshot", "replacing the path failed");
+    if (fs_file_stat(&file, &st) != 0 || st.type != FS_TYPE_FILE || st.size != 11)
+        test_fail("Stat snapshot", "open file metadata mismatch");
+    fs_file_close(&file);
+    fs_write_file_all(path, "Hello World", 11);
+#else
+    if (fs_file_stat(&file, &st) != 0 || st.type != FS_TYPE_FILE || st.size != 11)
+        test_fail("Stat snapshot", "open file metadata mismatch");
+    fs_file_close(&file);
+    fs_delete_file(other);
+#endif
+    if (fs_file_stat(&file, &st) == 0)
+        test_fail("Stat snapshot", "closed handle stat'ed");
+    test_pass("Stat snapshot");
+}
+
 static void test_read_file()
 {
     printf("\n--- Test 3: Read File ---\n");
@@ -133,6 +178,70 @@ static void test_list_directory()
     test_pass("List directory");
 }
 
+static void test_directory_stream()
+{
+    printf("\n--- Test: Directory Stream ---\n");
+
+    // More entries than the old fixed-size listing buffer held
+    const int count = 1500;
+    char dir[PATH_MAX];
+    char path[PATH_MAX];
+    snprintf(dir, PATH_MAX, "%s/many", g_test_dir);
+    if (fs_create_directory(dir) != 0)
+    {
+        test_fail("Directory stream", "failed to create directory");
+        return;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(path, PATH_MAX, "%s/entry%04d", dir, i);
+        if (fs_write_file_all(path, "x", 1) != 1)
+        {
+            test_fail("Directory stream", "failed to create entries");
+            fs_delete_directory(dir, 1);
+            return;
+        }
+    }
+
+    fs_file_info_t info;
+    int seen = 0, bad = 0;
+    fs_dir_t *stream = fs_dir_open(dir, 0);
+    if (!stream)
+        test_fail("Directory stream", "fs_dir_open failed");
+    int rc;
+    while (stream && (rc = fs_dir_next(stream, &info)) == 1)
+    {
+        seen++;
+        if (info.type != FS_TYPE_FILE || info.size != 1 || strncmp(info.name, "entry", 5) != 0)
+            bad++;
+    }
+    fs_dir_close(stream);
+    if (seen != count || bad != 0)
+        test_fail("Directory stream", "full entries mismatch");
+    else
+        test_pass("Directory stream");
+
+    seen = 0;
+    stream = fs_dir_open(dir, FS_DIR_NAMES_ONLY);
+    fs_file_info_t batch[64];
+    int got;
+    while (stream && (got = fs_dir_read_batch(stream, batch, 64)) > 0)
+        seen += got;
+    fs_dir_close(stream);
+    if (seen != count)
+        test_fail("Directory stream - names only batches", "entry count mismatch");
+    else
+        test_pass("Directory stream - names only batches");
+
+    if (fs_get_entry_info(dir, "entry0042", &info) != 0 || info.type != FS_TYPE_FILE ||
+        fs_get_entry_info(dir, "missing", &info) == 0)
+        test_fail("Entry info", "lookup mismatch");
+    else
+        test_pass("Entry info");
+
+    fs_delete_directory(dir, 1);
+}
+
 static void test_get_directory_size()
 {
     printf("\n--- Test 6: Get Directory Size ---\n");
@@ -303,6 +412,106 @@ static void test_get_parent_directory()
     test_pass("Get parent directory");
 }
 
+static void test_file_handle_streaming()
+{
+    printf("\n--- Test: Streaming File Handle ---\n");
+
+    char path[PATH_MAX];
+    snprintf(path, PATH_MAX, "%s/stream.bin", g_test_dir);
+
+    fs_file_t file;
+    if (fs_file_open(&file, path, FS_OPEN_READ) == 0 || fs_file_is_open(&file))
+        test_fail("Streaming file handle", "opening a missing file for reading should fail");
+
+    /* sequential writes through one handle */
+    if (fs_file_open(&file, path, FS_OPEN_WRITE) != 0)
+        test_fail("Streaming file handle", "open for writing failed");
+    if (fs_file_write(&file, "0123", 4) != 4 || fs_file_write(&file, "4567", 4) != 4)
+        test_fail("Streaming file handle", "sequential write failed");
+    if (fs_file_size(&file) != 8)
+        test_fail("Streaming file handle", "size mismatch after write");
+    if (fs_file_sync(&file) != 0 || fs_file_close(&file) != 0 || fs_file_is_open(&file))
+        test_fail("Streaming file handle", "sync/close failed");
+
+    /* reopening for write keeps content, seek overwrites in place */
+    if (fs_file_open(&file, path, FS_OPEN_WRITE) != 0 || fs_file_seek(&file, 6) != 0 ||
+        fs_file_write(&file, "XYZ", 3) != 3)
+        test_fail("Streaming file handle", "write at offset failed");
+    fs_file_close(&file);
+
+    /* sequential reads continue from the current position */
+    char buf[16];
+    if (fs_file_open(&file, path, FS_OPEN_READ) != 0 || fs_file_seek(&file, 2) != 0)
+        test_fail("Streaming file handle", "open/seek for reading failed");
+    if (fs_file_read(&file, buf, 4) != 4 || memcmp(buf, "2345", 4) != 0)
+        test_fail("Streaming file handle", "first read mismatch");
+    if (fs_file_read(&file, buf, sizeof(buf)) != 3 || memcmp(buf, "XYZ", 3) != 0)
+        test_fail("Streaming file handle", "second read mismatch");
+    if (fs_file_read(&file, buf, sizeof(buf)) != 0)
+        test_fail("Streaming file handle", "read at EOF should return 0");
+    fs_file_close(&file);
+
+    /* double close is harmless */
+    if (fs_file_close(&file) != 0)
+        test_fail("Streaming file handle", "closing a closed handle failed");
+
+    fs_delete_file(path);
+    test_pass("Streaming file handle");
+}
+
+static void test_upload_helpers()
+{
+    printf("\n--- Test: Preallocation, Write-Back and Replace ---\n");
+
+    char path[PATH_MAX];
+    char temp[PATH_MAX];
+    snprintf(path, PATH_MAX, "%s/upload.bin", g_test_dir);
+    snprintf(temp, PATH_MAX, "%s/.upload.bin.part", g_test_dir);
+
+    fs_file_t file;
+    if (fs_write_file_all(path, "old", 3) != 3 || fs_file_open(&file, temp, FS_OPEN_WRITE) != 0)
+    {
+        test_fail("Upload helpers", "setup failed");
+        return;
+    }
+
+    /* preallocation is only a hint, but must never change the visible size */
+    fs_file_preallocate(&file, 0, 1024 * 1024);
+    fs_file_advise(&file, 0, 0, FS_ADVICE_SEQUENTIAL);
+    if (fs_file_size(&file) != 0)
+    {
+        test_fail("Upload helpers", "preallocation changed the file size");
+        fs_file_close(&file);
+        return;
+    }
+
+    if (fs_file_write(&file, "new content", 11) != 11 || fs_file_flush_range(&file, 0, 11, 0) != 0 ||
+        fs_file_flush_range(&file, 0, 11, 1) != 0 || fs_file_sync(&file) != 0)
+    {
+        test_fail("Upload helpers", "write-back failed");
+        fs_file_close(&file);
+        return;
+    }
+    fs_file_close(&file);
+
+    char buf[16] = {0};
+    if (fs_replace_file(temp, path) != 0 || fs_path_exists(temp) ||
+        fs_get_file_size(path) != 11 || fs_read_file_all(path, buf, sizeof(buf)) != 11 || memcmp(buf, "new content", 11) != 0)
+    {
+        test_fail("Upload helpers", "replace did not swap the content");
+        return;
+    }
+
+    if (fs_replace_file(temp, path) == 0)
+    {
+        test_fail("Upload helpers", "replacing with a missing file succeeded");
+        return;
+    }
+
+    fs_delete_file(path);
+    test_pass("Upload helpers");
+}
+
 int main()
 {
     printf("============================================================\n");
@@ -330,9 +539,13 @@ int main()
     // Run all tests
     test_write_file();
     test_get_file_size();
+    test_stat_snapshot();
     test_read_file();
     test_write_file_chunk();
+    test_file_handle_streaming();
+    test_upload_helpers();
     test_list_directory();
+    test_directory_stream();
     test_get_directory_size();
     test_delete_file();
     test_create_and_delete_directory();
@@ -0,0 +1,418 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "filesys.h"
+#include "fswalk.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define TREE_DIRS 30      // Directories under the root
+#define TREE_SUBDIRS 10   // Directories under each of those
+#define TREE_FILES 3      // Files in every leaf directory
+#define WIDE_DIRS 300     // More than a deque holds, forces inline walking
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+static char g_test_dir[PATH_MAX];
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+typedef struct
+{
+    long long files;
+    long long dirs;
+    long long posts;
+    long long links;
+    long long bytes;
+    long long bad_worker;
+} walk_counts_t;
+
+typedef struct
+{
+    walk_counts_t slots[FSWALK_MAX_THREADS];
+    int threads;
+    const char *skip_name; // Directories with this name are skipped
+    int stop_after;        // Stop (or cancel) after this many entries of worker 0, 0 for never
+    volatile int *cancel;  // Set instead of returning FSWALK_STOP when not NULL
+} walk_context_t;
+
+static int count_visitor(const fswalk_entry_t *entry, void *arg)
+{
+    walk_context_t *context = (walk_context_t *)arg;
+    if (entry->worker < 0 || entry->worker >= context->threads)
+    {
+        context->slots[0].bad_worker++;
+        return FSWALK_STOP;
+    }
+
+    walk_counts_t *counts = &context->slots[entry->worker];
+    switch (entry->visit)
+    {
+    case FSWALK_VISIT_DIR_PRE:
+        if (context->skip_name && strcmp(entry->name, context->skip_name) == 0)
+            return FSWALK_SKIP;
+        counts->dirs++;
+        break;
+    case FSWALK_VISIT_DIR_POST:
+        counts->posts++;
+        break;
+    default:
+        if (entry->type == FS_TYPE_SYMLINK)
+        {
+            counts->links++;
+        }
+        else
+        {
+            counts->files++;
+            counts->bytes += entry->size;
+        }
+        break;
+    }
+
+    if (context->stop_after > 0 && entry->worker == 0 && --context->stop_after == 0)
+    {
+        if (!context->cancel)
+            return FSWALK_STOP;
+        *context->cancel = 1;
+    }
+    return FSWALK_CONTINUE;
+}
+
+static walk_counts_t total_counts(const walk_context_t *context)
+{
+    walk_counts_t total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < FSWALK_MAX_THREADS; i++)
+    {
+        total.files += context->slots[i].files;
+        total.dirs += context->slots[i].dirs;
+        total.posts += context->slots[i].posts;
+        total.links += context->slots[i].links;
+        total.bytes += context->slots[i].bytes;
+        total.bad_worker += context->slots[i].bad_worker;
+    }
+    return total;
+}
+
+static void make_dir(const char *path)
+{
+    if (fs_create_directory(path) != 0)
+    {
+        fprintf(stderr, "Setup failed: cannot create %s\n", path);
+        exit(1);
+    }
+}
+
+static void make_file(const char *path, long long size)
+{
+    char data[16] = "0123456789abcdef";
+    if (fs_write_file_all(path, data, size) != size)
+    {
+        fprintf(stderr, "Setup failed: cannot write %s\n", path);
+        exit(1);
+    }
+}
+
+/**
+ * @brief Exits the fixture setup when a formatted path did not fit its buffer.
+ */
+static void check_path_length(int length, size_t size)
+{
+    if (length < 0 || (size_t)length >= size)
+    {
+        fprintf(stderr, "Setup failed: test directory path too long\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Builds root/dN/sM/fK, with file K holding K + 1 bytes.
+ * @return Total size of the files.
+ */
+static long long build_tree(const char *root)
+{
+    char path[PATH_MAX];
+    long long bytes = 0;
+    make_dir(root);
+    for (int d = 0; d < TREE_DIRS; d++)
+    {
+        check_path_length(snprintf(path, sizeof(path), "%s/d%d", root, d), sizeof(path));
+        make_dir(path);
+        for (int s = 0; s < TREE_SUBDIRS; s++)
+        {
+            check_path_length(snprintf(path, sizeof(path), "%s/d%d/s%d", root, d, s), sizeof(path));
+            make_dir(path);
+            for (int f = 0; f < TREE_FILES; f++)
+            {
+                check_path_length(snprintf(path, sizeof(path), "%s/d%d/s%d/f%d", root, d, s, f), sizeof(path));
+                make_file(path, f + 1);
+                bytes += f + 1;
+            }
+        }
+    }
+
+#ifndef _WIN32
+    // A loop back to the root, followed it would never end
+    check_path_length(snprintf(path, sizeof(path), "%s/d0/loop", root), sizeof(path));
+    if (symlink(root, path) != 0)
+    {
+        fprintf(stderr, "Setup failed: cannot link %s\n", path);
+        exit(1);
+    }
+#endif
+    return bytes;
+}
+
+static void test_parallel_walk(const char *root, long long bytes)
+{
+    printf("\n--- Test 1: Parallel Walk ---\n");
+
+    walk_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.threads = 8;
+    fswalk_options_t options = {context.threads, FSWALK_STAT, 0, NULL};
+    int result = fswalk_run(root, &options, count_visitor, &context);
+    walk_counts_t total = total_counts(&context);
+
+    long long dirs = TREE_DIRS + TREE_DIRS * TREE_SUBDIRS;
+    if (result != 0 || total.bad_worker != 0)
+        test_fail("Walk succeeds", "fswalk_run failed");
+    else
+        test_pass("Walk succeeds");
+
+    if (total.dirs != dirs || total.posts != dirs || total.files != TREE_DIRS * TREE_SUBDIRS * TREE_FILES)
+        test_fail("Every entry once", "unexpected entry counts");
+    else
+        test_pass("Every entry once");
+
+    if (total.bytes != bytes)
+        test_fail("Sizes with FSWALK_STAT", "unexpected total size");
+    else
+        test_pass("Sizes with FSWALK_STAT");
+
+#ifndef _WIN32
+    if (total.links != 1)
+        test_fail("Symlinks not followed", "symlink not reported once");
+    else
+        test_pass("Symlinks not followed");
+#endif
+
+    // Without FSWALK_STAT the types still come through, the sizes do not
+    memset(&context, 0, sizeof(context));
+    context.threads = 3;
+    options.threads = context.threads;
+    options.flags = 0;
+    result = fswalk_run(root, &options, count_visitor, &context);
+    total = total_counts(&context);
+    if (result != 0 || total.dirs != dirs || total.files != TREE_DIRS * TREE_SUBDIRS * TREE_FILES)
+        test_fail("Types without stat", "unexpected entry counts");
+    else
+        test_pass("Types without stat");
+}
+
+static void test_inline_walk(const char *base)
+{
+    printf("\n--- Test 2: Full Deque ---\n");
+
+    char root[PATH_MAX - 32]; // Leaves room for the wN/f names below it
+    char path[PATH_MAX];
+    if (snprintf(root, sizeof(root), "%s/wide", base) >= (int)sizeof(root))
+    {
+        test_fail("Single worker, full deque", "test directory path too long");
+        return;
+    }
+    make_dir(root);
+    for (int i = 0; i < WIDE_DIRS; i++)
+    {
+        snprintf(path, sizeof(path), "%s/w%d", root, i);
+        make_dir(path);
+        snprintf(path, sizeof(path), "%s/w%d/f", root, i);
+        make_file(path, 1);
+    }
+
+    // One worker, so the directories past the deque capacity are walked inline
+    walk_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.threads = 1;
+    fswalk_options_t options = {1, 0, 0, NULL};
+    int result = fswalk_run(root, &options, count_visitor, &context);
+    walk_counts_t total = total_counts(&context);
+    if (result != 0 || total.dirs != WIDE_DIRS || total.posts != WIDE_DIRS || total.files != WIDE_DIRS)
+        test_fail("Single worker, full deque", "unexpected entry counts");
+    else
+        test_pass("Single worker, full deque");
+
+    if (fs_delete_directory(root, 1) != 0 || fs_path_exists(root))
+        test_fail("Delete wide tree", "directory left behind");
+    else
+        test_pass("Delete wide tree");
+}
+
+static void test_control(const char *root)
+{
+    printf("\n--- Test 3: Skip, Stop and Cancel ---\n");
+
+    walk_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.threads = 4;
+    context.skip_name = "s0";
+    fswalk_options_t options = {context.threads, 0, 0, NULL};
+    int result = fswalk_run(root, &options, count_visitor, &context);
+    walk_counts_t total = total_counts(&context);
+    long long dirs = TREE_DIRS + TREE_DIRS * (TREE_SUBDIRS - 1);
+    if (result != 0 || total.dirs != dirs || total.posts != dirs ||
+        total.files != TREE_DIRS * (TREE_SUBDIRS - 1) * TREE_FILES)
+        test_fail("Skip subtree", "skipped directories were walked");
+    else
+        test_pass("Skip subtree");
+
+    memset(&context, 0, sizeof(context));
+    context.threads = 4;
+    context.stop_after = 5;
+    result = fswalk_run(root, &options, count_visitor, &context);
+    if (result != -1)
+        test_fail("Visitor stop", "walk did not fail");
+    else
+        test_pass("Visitor stop");
+
+    volatile int cancel = 0;
+    memset(&context, 0, sizeof(context));
+    context.threads = 4;
+    context.stop_after = 5;
+    context.cancel = &cancel;
+    options.cancel = &cancel;
+    result = fswalk_run(root, &options, count_visitor, &context);
+    total = total_counts(&context);
+    if (result != -1 || total.files + total.dirs >= TREE_DIRS + TREE_DIRS * TREE_SUBDIRS * (TREE_FILES + 1))
+        test_fail("Cancellation", "walk was not cut short");
+    else
+        test_pass("Cancellation");
+
+    // Cancelled before it starts
+    memset(&context, 0, sizeof(context));
+    context.threads = 4;
+    result = fswalk_run(root, &options, count_visitor, &context);
+    total = total_counts(&context);
+    if (result != -1 || total.files + total.dirs != 0)
+        test_fail("Cancelled up front", "entries visited");
+    else
+        test_pass("Cancelled up front");
+
+    memset(&context, 0, sizeof(context));
+    context.threads = 4;
+    options.cancel = NULL;
+    options.max_depth = 1;
+    if (fswalk_run(root, &options, count_visitor, &context) != -1)
+        test_fail("Depth limit", "deeper directories accepted");
+    else
+        test_pass("Depth limit");
+
+    options.max_depth = 2;
+    memset(&context, 0, sizeof(context));
+    context.threads = 4;
+    if (fswalk_run(root, &options, count_visitor, &context) != 0)
+        test_fail("Depth within limit", "walk failed");
+    else
+        test_pass("Depth within limit");
+
+    char missing[PATH_MAX];
+    if (snprintf(missing, sizeof(missing), "%s/missing", root) >= (int)sizeof(missing))
+        test_fail("Invalid root", "test directory path too long");
+    else if (fswalk_run(missing, NULL, count_visitor, &context) != -1 || fswalk_run(root, NULL, NULL, NULL) != -1)
+        test_fail("Invalid root", "walk succeeded");
+    else
+        test_pass("Invalid root");
+}
+
+static void test_filesys_users(const char *root, long long bytes)
+{
+    printf("\n--- Test 4: Directory Size and Recursive Delete ---\n");
+
+    if (fs_get_directory_size(root) != bytes)
+        test_fail("Directory size", "unexpected size");
+    else
+        test_pass("Directory size");
+
+    // Removing a directory before its contents would fail, so this checks the post order
+    if (fs_delete_directory(root, 1) != 0 || fs_path_exists(root))
+        test_fail("Recursive delete", "tree left behind");
+    else
+        test_pass("Recursive delete");
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Tree Walker Test Suite\n");
+    printf("============================================================\n");
+
+#ifdef _WIN32
+    char template[] = "fswalk_test_XXXXXX";
+    if (_mktemp(template) == NULL || (!CreateDirectoryA(template, NULL) && GetLastError() != ERROR_ALREADY_EXISTS))
+    {
+        fprintf(stderr, "Setup failed\n");
+        return 1;
+    }
+    char *dir = template;
+#else
+    char template[] = "/tmp/fswalk_test_XXXXXX";
+    char *dir = mkdtemp(template);
+    if (!dir)
+    {
+        fprintf(stderr, "Setup failed: mkdtemp\n");
+        return 1;
+    }
+#endif
+    strncpy(g_test_dir, dir, PATH_MAX - 1);
+    g_test_dir[PATH_MAX - 1] = '\0';
+
+    char root[PATH_MAX];
+    if (snprintf(root, sizeof(root), "%s/tree", g_test_dir) >= (int)sizeof(root))
+    {
+        fprintf(stderr, "Setup failed: test directory path too long\n");
+        fs_delete_directory(g_test_dir, 1);
+        return 1;
+    }
+    long long bytes = build_tree(root);
+
+    test_parallel_walk(root, bytes);
+    test_inline_walk(g_test_dir);
+    test_control(root);
+    test_filesys_users(root, bytes);
+
+    fs_delete_directory(g_test_dir, 1);
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
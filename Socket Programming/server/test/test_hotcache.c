@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "filesys.h"
+#include "hotcache.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static char g_dir[] = "/tmp/test_hotcache_XXXXXX";
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+/**
+ * @brief Writes a file filled with one byte and dates it an hour back, so it may be cached
+ */
+static void write_file(const char *path, char fill, size_t size)
+{
+    char *data = (char *)malloc(size + 1);
+    memset(data, fill, size);
+    fs_write_file_all(path, data, (long long)size);
+    free(data);
+
+    struct utimbuf times;
+    times.actime = times.modtime = time(NULL) - 3600;
+    utime(path, &times);
+}
+
+/**
+ * @brief Opens a file and acquires its cached copy
+ */
+static hotcache_file_t *acquire(const char *path)
+{
+    fs_file_t file;
+    if (fs_file_open(&file, path, FS_OPEN_READ) != 0)
+        return NULL;
+    hotcache_file_t *entry = hotcache_acquire(path, &file);
+    fs_file_close(&file);
+    return entry;
+}
+
+static int holds(const hotcache_file_t *entry, char fill, size_t size)
+{
+    size_t length = 0;
+    const char *data = hotcache_data(entry, &length);
+    if (!data || length != size)
+        return 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] != fill)
+            return 0;
+    }
+    return 1;
+}
+
+static void test_hit_and_miss()
+{
+    printf("\n--- Test 1: Hits and Misses ---\n");
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/a.bin", g_dir);
+    write_file(path, 'a', 1000);
+
+    hotcache_file_t *first = acquire(path);
+    hotcache_file_t *second = acquire(path);
+    hotcache_stats_t stats;
+    hotcache_get_stats(&stats);
+    if (!first || first != second || !holds(second, 'a', 1000) || stats.hits != 1 || stats.misses != 1)
+        test_fail("Hit", "second download did not hit the cached copy");
+    else
+        test_pass("Hit");
+    hotcache_release(first);
+    hotcache_release(second);
+
+    // Just written files may still change within the same mtime second
+    snprintf(path, sizeof(path), "%s/fresh.bin", g_dir);
+    char data[100] = {0};
+    fs_write_file_all(path, data, sizeof(data));
+    hotcache_file_t *fresh = acquire(path);
+    if (fresh)
+        test_fail("Recently modified", "fresh file was cached");
+    else
+        test_pass("Recently modified");
+
+    snprintf(path, sizeof(path), "%s/large.bin", g_dir);
+    write_file(path, 'l', 8192);
+    hotcache_file_t *large = acquire(path);
+    if (large)
+        test_fail("Too large", "file above the size limit was cached");
+    else
+        test_pass("Too large");
+    hotcache_release(large);
+}
+
+static void test_validation()
+{
+    printf("\n--- Test 2: Validation ---\n");
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/v.bin", g_dir);
+    write_file(path, 'v', 500);
+    hotcache_release(acquire(path));
+
+    // Rewritten behind the cache's back to another size
+    write_file(path, 'w', 600);
+    hotcache_file_t *entry = acquire(path);
+    if (!entry || !holds(entry, 'w', 600))
+        test_fail("Size", "stale copy served after a rewrite");
+    else
+        test_pass("Size");
+    hotcache_release(entry);
+
+    // Same size, only the date moved
+    write_file(path, 'y', 600);
+    struct utimbuf times;
+    times.actime = times.modtime = time(NULL) - 7200;
+    utime(path, &times);
+    entry = acquire(path);
+    if (!entry || !holds(entry, 'y', 600))
+        test_fail("Mtime", "stale copy served after a rewrite");
+    else
+        test_pass("Mtime");
+    hotcache_release(entry);
+
+    // Replaced by another file of the same size and date: only the inode differs
+    char other[256];
+    snprintf(other, sizeof(other), "%s/v.new", g_dir);
+    write_file(other, 'x', 600);
+    times.actime = times.modtime = time(NULL) - 3600;
+    utime(path, &times);
+    utime(other, &times);
+    hotcache_release(acquire(path));
+    rename(other, path);
+    entry = acquire(path);
+    if (!entry || !holds(entry, 'x', 600))
+        test_fail("Inode", "stale copy served after the file was replaced");
+    else
+        test_pass("Inode");
+    hotcache_release(entry);
+}
+
+static void test_invalidation()
+{
+    printf("\n--- Test 3: Invalidation ---\n");
+
+    char dir[256], inner[256], outer[256];
+    snprintf(dir, sizeof(dir), "%s/sub", g_dir);
+    snprintf(inner, sizeof(inner), "%s/sub/in.bin", g_dir);
+    snprintf(outer, sizeof(outer), "%s/subway.bin", g_dir);
+    fs_create_directory(dir);
+    write_file(inner, 'i', 100);
+    write_file(outer, 'o', 100);
+    hotcache_release(acquire(inner));
+    hotcache_release(acquire(outer));
+
+    hotcache_stats_t before, after;
+    hotcache_get_stats(&before);
+    hotcache_invalidate(dir);
+    hotcache_get_stats(&after);
+    if (after.entries != before.entries - 1 || after.bytes != before.bytes - 100)
+        test_fail("Directory", "entries below the directory were not dropped alone");
+    else
+        test_pass("Directory");
+
+    hotcache_invalidate(outer);
+    hotcache_file_t *entry = acquire(outer);
+    hotcache_get_stats(&after);
+    if (!entry || after.misses != before.misses + 1)
+        test_fail("File", "invalidated file was served from the cache");
+    else
+        test_pass("File");
+    hotcache_release(entry);
+}
+
+static void test_eviction()
+{
+    printf("\n--- Test 4: Eviction ---\n");
+
+    hotcache_cleanup();
+    hotcache_init(10000, 4096);
+
+    // Ten 3000 byte files fit three at a time; hot.bin is downloaded all along
+    char hot[256];
+    snprintf(hot, sizeof(hot), "%s/hot.bin", g_dir);
+    write_file(hot, 'h', 3000);
+    hotcache_release(acquire(hot));
+
+    hotcache_file_t *pinned = NULL;
+    for (int i = 0; i < 10; i++)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/e%d.bin", g_dir, i);
+        write_file(path, (char)('0' + i), 3000);
+        hotcache_file_t *entry = acquire(path);
+        if (i == 0)
+            pinned = entry;
+        else
+            hotcache_release(entry);
+        hotcache_release(acquire(hot));
+    }
+
+    hotcache_stats_t stats;
+    hotcache_get_stats(&stats);
+    if (stats.bytes > stats.max_bytes || stats.entries != 3 || stats.evictions < 8)
+        test_fail("Bound", "cache grew beyond its size limit");
+    else
+        test_pass("Bound");
+
+    hotcache_file_t *entry = acquire(hot);
+    hotcache_get_stats(&stats);
+    if (!entry || stats.hits < 11)
+        test_fail("Second chance", "frequently downloaded file was evicted");
+    else
+        test_pass("Second chance");
+    hotcache_release(entry);
+
+    // The first file was evicted while a download still held it
+    if (!pinned || !holds(pinned, '0', 3000) || stats.pinned_bytes != 3000)
+        test_fail("Pinned", "evicted entry was freed during a download");
+    else
+        test_pass("Pinned");
+    hotcache_release(pinned);
+    hotcache_get_stats(&stats);
+    if (stats.pinned_bytes != 0)
+        test_fail("Release", "evicted entry not freed on release");
+    else
+        test_pass("Release");
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("File Cache Test Suite\n");
+    printf("============================================================\n");
+
+    if (!mkdtemp(g_dir) || hotcache_init(64 * 1024, 4096) != 0 || !hotcache_is_enabled())
+    {
+        fprintf(stderr, "Failed to set up the file cache\n");
+        return 1;
+    }
+
+    test_hit_and_miss();
+    test_validation();
+    test_invalidation();
+    test_eviction();
+
+    hotcache_cleanup();
+    if (hotcache_is_enabled())
+        test_fail("Cleanup", "cache still enabled");
+    else
+        test_pass("Cleanup");
+    fs_delete_directory(g_dir, 1);
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
@@ -0,0 +1,318 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "iopipe.h"
+#include "logger.h"
+
+#define BUFFER_SIZE 4096
+#define STREAM_SIZE (BUFFER_SIZE * 100 + 123)
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void pause_briefly(void)
+{
+    struct timespec ts = {0, 200000}; // 0.2ms, long enough to let the other side run ahead
+    nanosleep(&ts, NULL);
+}
+
+static unsigned char stream_byte(long long pos)
+{
+    return (unsigned char)(pos * 7 + pos / 251);
+}
+
+// Produces STREAM_SIZE bytes in uneven pieces, optionally failing after some calls
+typedef struct
+{
+    long long pos;
+    int calls;
+    int fail_at;  // Call number that fails, 0 for never
+    int slow;
+} source_t;
+
+static long long source_stage(void *context, char *buffer, size_t length)
+{
+    source_t *source = (source_t *)context;
+    source->calls++;
+    if (source->fail_at && source->calls == source->fail_at)
+        return -1;
+    if (source->slow)
+        pause_briefly();
+
+    long long left = STREAM_SIZE - source->pos;
+    if (left <= 0)
+        return 0;
+
+    size_t n = (size_t)(source->calls * 997 % BUFFER_SIZE) + 1;
+    if (n > length)
+        n = length;
+    if ((long long)n > left)
+        n = (size_t)left;
+    for (size_t i = 0; i < n; i++)
+        buffer[i] = (char)stream_byte(source->pos + (long long)i);
+    source->pos += (long long)n;
+    return (long long)n;
+}
+
+// Collects what the stage consumes, optionally failing after some calls
+typedef struct
+{
+    unsigned char *data;
+    long long used;
+    int calls;
+    int fail_at;
+    int slow;
+} sink_t;
+
+static long long sink_stage(void *context, char *buffer, size_t length)
+{
+    sink_t *sink = (sink_t *)context;
+    sink->calls++;
+    if (sink->fail_at && sink->calls == sink->fail_at)
+        return -1;
+    if (sink->slow)
+        pause_briefly();
+
+    memcpy(sink->data + sink->used, buffer, length);
+    sink->used += (long long)length;
+    return 0;
+}
+
+/**
+ * Drains a read-ahead pipeline and checks the stream.
+ * @return Bytes read and verified, or -1 on corruption.
+ */
+static long long drain(iopipe_t *pipe, long long *last_result, int slow)
+{
+    long long pos = 0;
+    for (;;)
+    {
+        const char *data;
+        long long n = iopipe_next(pipe, &data);
+        *last_result = n;
+        if (n <= 0)
+            return pos;
+        for (long long i = 0; i < n; i++)
+        {
+            if ((unsigned char)data[i] != stream_byte(pos + i))
+                return -1;
+        }
+        pos += n;
+        if (slow)
+            pause_briefly();
+    }
+}
+
+static void test_read_ahead()
+{
+    printf("\n--- Test 1: Read-Ahead Order ---\n");
+
+    int depths[] = {1, 2, IOPIPE_DEFAULT_DEPTH, IOPIPE_MAX_DEPTH};
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++)
+    {
+        for (int slow = 0; slow < 3; slow++)
+        {
+            source_t source = {0, 0, 0, slow == 1};
+            iopipe_t *pipe = iopipe_create(IOPIPE_READ_AHEAD, depths[d], BUFFER_SIZE, source_stage, &source);
+            long long last = -2;
+            long long total = pipe ? drain(pipe, &last, slow == 2) : -1;
+
+            char name[64];
+            snprintf(name, sizeof(name), "Read-ahead depth %d, %s", depths[d],
+                     slow == 1 ? "slow disk" : slow == 2 ? "slow network" : "no delay");
+            if (total != STREAM_SIZE || last != 0)
+                test_fail(name, "stream corrupted or incomplete");
+            else
+                test_pass(name);
+            iopipe_destroy(pipe);
+        }
+    }
+
+    source_t source = {0, 0, 0, 0};
+    if (iopipe_create(IOPIPE_READ_AHEAD, 0, BUFFER_SIZE, source_stage, &source) != NULL ||
+        iopipe_create(IOPIPE_READ_AHEAD, IOPIPE_MAX_DEPTH + 1, BUFFER_SIZE, source_stage, &source) != NULL)
+        test_fail("Invalid depth", "pipeline created");
+    else
+        test_pass("Invalid depth");
+}
+
+static void test_read_ahead_failure()
+{
+    printf("\n--- Test 2: Read-Ahead Failure and Early Stop ---\n");
+
+    for (int depth = 1; depth <= IOPIPE_DEFAULT_DEPTH; depth += IOPIPE_DEFAULT_DEPTH - 1)
+    {
+        // Data read before the failure still arrives first
+        source_t source = {0, 0, 6, 0};
+        iopipe_t *pipe = iopipe_create(IOPIPE_READ_AHEAD, depth, BUFFER_SIZE, source_stage, &source);
+        long long last = 0;
+        long long total = pipe ? drain(pipe, &last, 0) : -1;
+        long long again = -2;
+        const char *data;
+        if (pipe)
+            again = iopipe_next(pipe, &data);
+
+        // Five successful pieces: 998, 1995, 2992, 3989, 890 bytes
+        if (total != 998 + 1995 + 2992 + 3989 + 890 || last != -1 || again != -1 || source.calls != 6)
+            test_fail(depth == 1 ? "Failure inline" : "Failure threaded", "error not delivered after the data");
+        else
+            test_pass(depth == 1 ? "Failure inline" : "Failure threaded");
+        iopipe_destroy(pipe);
+    }
+
+    // Like ABOR: stop consuming midway, destroy must not wait for the whole file
+    source_t source = {0, 0, 0, 1};
+    iopipe_t *pipe = iopipe_create(IOPIPE_READ_AHEAD, IOPIPE_DEFAULT_DEPTH, BUFFER_SIZE, source_stage, &source);
+    const char *data;
+    int ok = pipe && iopipe_next(pipe, &data) > 0 && iopipe_next(pipe, &data) > 0;
+    iopipe_destroy(pipe);
+    if (!ok || source.calls > 2 + IOPIPE_DEFAULT_DEPTH + 1)
+        test_fail("Early stop", "stage kept reading after destroy");
+    else
+        test_pass("Early stop");
+}
+
+/**
+ * Pushes the stream through a write-behind pipeline.
+ * @return 0 if every submit succeeded, -1 otherwise.
+ */
+static int fill(iopipe_t *pipe, int slow)
+{
+    long long pos = 0;
+    int piece = 1;
+    while (pos < STREAM_SIZE)
+    {
+        char *buffer = iopipe_acquire(pipe);
+        if (!buffer)
+            return -1;
+
+        size_t n = (size_t)(piece * 1237 % BUFFER_SIZE) + 1;
+        if ((long long)n > STREAM_SIZE - pos)
+            n = (size_t)(STREAM_SIZE - pos);
+        for (size_t i = 0; i < n; i++)
+            buffer[i] = (char)stream_byte(pos + (long long)i);
+        if (iopipe_submit(pipe, n) != 0)
+            return -1;
+        pos += (long long)n;
+        piece++;
+        if (slow)
+            pause_briefly();
+    }
+    return 0;
+}
+
+static int check_sink(const sink_t *sink)
+{
+    if (sink->used != STREAM_SIZE)
+        return -1;
+    for (long long i = 0; i < STREAM_SIZE; i++)
+    {
+        if (sink->data[i] != stream_byte(i))
+            return -1;
+    }
+    return 0;
+}
+
+static void test_write_behind()
+{
+    printf("\n--- Test 3: Write-Behind Order ---\n");
+
+    int depths[] = {1, 2, IOPIPE_DEFAULT_DEPTH, IOPIPE_MAX_DEPTH};
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++)
+    {
+        for (int slow = 0; slow < 3; slow++)
+        {
+            sink_t sink = {malloc(STREAM_SIZE), 0, 0, 0, slow == 1};
+            iopipe_t *pipe = iopipe_create(IOPIPE_WRITE_BEHIND, depths[d], BUFFER_SIZE, sink_stage, &sink);
+            int rc = pipe ? fill(pipe, slow == 2) : -1;
+            int finished = pipe ? iopipe_finish(pipe) : -1;
+
+            char name[64];
+            snprintf(name, sizeof(name), "Write-behind depth %d, %s", depths[d],
+                     slow == 1 ? "slow disk" : slow == 2 ? "slow network" : "no delay");
+            if (rc != 0 || finished != 0 || check_sink(&sink) != 0)
+                test_fail(name, "stream corrupted or incomplete");
+            else
+                test_pass(name);
+            iopipe_destroy(pipe);
+            free(sink.data);
+        }
+    }
+}
+
+static void test_write_behind_failure()
+{
+    printf("\n--- Test 4: Write-Behind Failure ---\n");
+
+    for (int depth = 1; depth <= IOPIPE_DEFAULT_DEPTH; depth += IOPIPE_DEFAULT_DEPTH - 1)
+    {
+        sink_t sink = {malloc(STREAM_SIZE), 0, 0, 3, 0};
+        iopipe_t *pipe = iopipe_create(IOPIPE_WRITE_BEHIND, depth, BUFFER_SIZE, sink_stage, &sink);
+        int rc = pipe ? fill(pipe, 0) : 0;
+        int finished = pipe ? iopipe_finish(pipe) : 0;
+
+        if (rc != -1 || finished != -1 || sink.calls != 3)
+            test_fail(depth == 1 ? "Failure inline" : "Failure threaded", "write error not reported");
+        else
+            test_pass(depth == 1 ? "Failure inline" : "Failure threaded");
+        iopipe_destroy(pipe);
+        free(sink.data);
+    }
+
+    // An acquired buffer that is never submitted is not written
+    sink_t sink = {malloc(STREAM_SIZE), 0, 0, 0, 0};
+    iopipe_t *pipe = iopipe_create(IOPIPE_WRITE_BEHIND, IOPIPE_DEFAULT_DEPTH, BUFFER_SIZE, sink_stage, &sink);
+    char *buffer = pipe ? iopipe_acquire(pipe) : NULL;
+    if (buffer)
+        memset(buffer, 'x', BUFFER_SIZE);
+    int finished = pipe ? iopipe_finish(pipe) : -1;
+    if (!buffer || finished != 0 || sink.calls != 0 || iopipe_acquire(pipe) != NULL)
+        test_fail("Unsubmitted buffer", "buffer written or pipeline usable after finish");
+    else
+        test_pass("Unsubmitted buffer");
+    iopipe_destroy(pipe);
+    free(sink.data);
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("I/O Pipeline Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+
+    test_read_ahead();
+    test_read_ahead_failure();
+    test_write_behind();
+    test_write_behind_failure();
+
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
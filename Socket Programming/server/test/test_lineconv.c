@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lineconv.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+/**
+ * Reference CRLF->LF over a whole buffer, lone CRs kept.
+ */
+static long long reference_crlf_to_lf(const char *in, long long len, char *out)
+{
+    long long o = 0;
+    for (long long i = 0; i < len; i++)
+    {
+        if (in[i] == '\r' && i + 1 < len && in[i + 1] == '\n')
+            i++;
+        out[o++] = in[i];
+    }
+    return o;
+}
+
+static long long reference_lf_to_crlf(const char *in, long long len, char *out)
+{
+    long long o = 0;
+    for (long long i = 0; i < len; i++)
+    {
+        if (in[i] == '\n')
+            out[o++] = '\r';
+        out[o++] = in[i];
+    }
+    return o;
+}
+
+/**
+ * Text with many CR, LF and CRLF, including runs like "\r\r\n".
+ */
+static void fill_random(char *buf, long long len, unsigned int seed)
+{
+    srand(seed);
+    for (long long i = 0; i < len; i++)
+    {
+        int r = rand() % 16;
+        buf[i] = r == 0 ? '\r' : r == 1 ? '\n' : (char)('a' + r);
+    }
+}
+
+static void test_lf_to_crlf(int kernel)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "LF to CRLF (%s)", lineconv_get_kernel_name(kernel));
+
+    const long long len = 100000;
+    char *in = malloc(len);
+    char *expected = malloc(len * 2);
+    char *out = malloc(len * 2);
+    fill_random(in, len, 1);
+
+    long long expected_len = reference_lf_to_crlf(in, len, expected);
+    long long got = lineconv_lf_to_crlf(in, len, out, len * 2);
+    if (got != expected_len || memcmp(out, expected, expected_len) != 0)
+        test_fail(name, "output mismatch");
+    else if (lineconv_lf_to_crlf(in, len, out, expected_len - 1) != -1)
+        test_fail(name, "output buffer one byte short was accepted");
+    else if (lineconv_lf_to_crlf(in, len, out, expected_len) != expected_len)
+        test_fail(name, "exact size output buffer rejected");
+    else
+        test_pass(name);
+
+    free(in);
+    free(expected);
+    free(out);
+}
+
+static void test_crlf_to_lf_chunked(int kernel)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "CRLF to LF in chunks (%s)", lineconv_get_kernel_name(kernel));
+
+    const long long len = 100000;
+    char *in = malloc(len);
+    char *expected = malloc(len);
+    char *out = malloc(len + 1);
+    fill_random(in, len, 2);
+    // Force CRLF pairs split at chunk boundaries below
+    for (long long i = 63; i + 1 < len; i += 97)
+    {
+        in[i] = '\r';
+        in[i + 1] = '\n';
+    }
+    in[len - 1] = '\r'; // Lone CR at the very end
+
+    long long expected_len = reference_crlf_to_lf(in, len, expected);
+
+    lineconv_state_t state;
+    lineconv_state_init(&state);
+    long long total = 0;
+    int failed = 0;
+    for (long long pos = 0; pos < len && !failed;)
+    {
+        long long chunk = 1 + rand() % 200;
+        if (chunk > len - pos)
+            chunk = len - pos;
+        long long got = lineconv_crlf_to_lf(&state, in + pos, chunk, out + total, len + 1 - total);
+        if (got < 0)
+            failed = 1;
+        else
+            total += got;
+        pos += chunk;
+    }
+    long long tail = lineconv_crlf_to_lf_finish(&state, out + total, len + 1 - total);
+    if (!failed && tail >= 0)
+        total += tail;
+
+    if (failed || tail != 1 || total != expected_len || memcmp(out, expected, expected_len) != 0)
+        test_fail(name, "output mismatch");
+    else
+        test_pass(name);
+
+    free(in);
+    free(expected);
+    free(out);
+}
+
+static void test_split_crlf(void)
+{
+    printf("\n--- Test: CRLF Split Across Chunks ---\n");
+
+    lineconv_state_t state;
+    lineconv_state_init(&state);
+    char out[16];
+    long long a = lineconv_crlf_to_lf(&state, "ab\r", 3, out, sizeof(out));
+    long long b = lineconv_crlf_to_lf(&state, "\ncd\r", 4, out + a, sizeof(out) - a);
+    long long c = lineconv_crlf_to_lf(&state, "x", 1, out + a + b, sizeof(out) - a - b);
+    long long d = lineconv_crlf_to_lf_finish(&state, out + a + b + c, sizeof(out) - a - b - c);
+    if (a != 2 || b != 3 || c != 2 || d != 0 || memcmp(out, "ab\ncd\rx", 7) != 0)
+        test_fail("Split CRLF", "held CR not resolved by the next chunk");
+    else
+        test_pass("Split CRLF");
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Line Conversion Test Suite\n");
+    printf("============================================================\n");
+
+    test_split_crlf();
+
+    for (int k = 0; k < lineconv_get_kernel_count(); k++)
+    {
+        if (!lineconv_is_kernel_supported(k))
+        {
+            printf("\n--- Kernel %s: not supported by this CPU, skipped ---\n", lineconv_get_kernel_name(k));
+            continue;
+        }
+        printf("\n--- Kernel %s ---\n", lineconv_get_kernel_name(k));
+        lineconv_select_kernel(k);
+        test_lf_to_crlf(k);
+        test_crlf_to_lf_chunked(k);
+    }
+    lineconv_select_kernel(-1);
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
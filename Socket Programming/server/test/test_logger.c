@@ -1,8 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "logger.h"
 
+#define ASYNC_TEST_THREADS 4
+#define ASYNC_TEST_MESSAGES 5000 // Per thread
+
 static int g_test_passed = 0;
 static int g_test_failed = 0;
 
@@ -69,6 +74,123 @@ static void test_reset_logger_level()
     test_pass("Logger level change");
 }
 
+static void *async_producer(void *arg)
+{
+    int id = *(int *)arg;
+    for (int i = 0; i < ASYNC_TEST_MESSAGES; i++)
+    {
+        LOG_INFO("async producer %d message %d", id, i);
+    }
+    return NULL;
+}
+
+static int run_async_producers(void)
+{
+    pthread_t threads[ASYNC_TEST_THREADS];
+    int ids[ASYNC_TEST_THREADS];
+    for (int i = 0; i < ASYNC_TEST_THREADS; i++)
+    {
+        ids[i] = i;
+        if (pthread_create(&threads[i], NULL, async_producer, &ids[i]) != 0)
+        {
+            return -1;
+        }
+    }
+    for (int i = 0; i < ASYNC_TEST_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    return 0;
+}
+
+static long count_lines_containing(const char *path, const char *needle)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        return -1;
+    }
+
+    char line[2048];
+    long count = 0;
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strstr(line, needle))
+        {
+            count++;
+        }
+    }
+    fclose(fp);
+    return count;
+}
+
+static void test_async_block()
+{
+    printf("\n--- Test 4: Async Logger (block on overflow) ---\n");
+    const char *path = "test_async_block.log";
+    remove(path);
+
+    logger_init(path, LOG_LEVEL_DEBUG);
+    // Small ring so producers really hit the full condition
+    if (logger_enable_async(64, LOG_OVERFLOW_BLOCK) != 0 || run_async_producers() != 0)
+    {
+        logger_close();
+        test_fail("Async block", "failed to start async logging");
+        return;
+    }
+    LOG_ERROR("async error marker");
+    logger_flush();
+
+    long before_close = count_lines_containing(path, "async error marker");
+    unsigned long long dropped = logger_get_dropped_count();
+    logger_close();
+
+    long lines = count_lines_containing(path, "async producer");
+    if (before_close != 1)
+    {
+        test_fail("Async block", "logger_flush() returned before the ERROR line was written");
+    }
+    else if (dropped != 0 || lines != (long)ASYNC_TEST_THREADS * ASYNC_TEST_MESSAGES)
+    {
+        test_fail("Async block", "messages were lost");
+    }
+    else
+    {
+        test_pass("Async block");
+    }
+    remove(path);
+}
+
+static void test_async_drop()
+{
+    printf("\n--- Test 5: Async Logger (drop on overflow) ---\n");
+    const char *path = "test_async_drop.log";
+    remove(path);
+
+    logger_init(path, LOG_LEVEL_DEBUG);
+    if (logger_enable_async(16, LOG_OVERFLOW_DROP) != 0 || run_async_producers() != 0)
+    {
+        logger_close();
+        test_fail("Async drop", "failed to start async logging");
+        return;
+    }
+    unsigned long long dropped = logger_get_dropped_count();
+    logger_close();
+
+    // Every message is either written or counted as dropped
+    long lines = count_lines_containing(path, "async producer");
+    if (lines < 0 || (unsigned long long)lines + dropped != (unsigned long long)ASYNC_TEST_THREADS * ASYNC_TEST_MESSAGES)
+    {
+        test_fail("Async drop", "written + dropped does not match messages logged");
+    }
+    else
+    {
+        printf("   written=%ld dropped=%llu\n", lines, dropped);
+        test_pass("Async drop");
+    }
+    remove(path);
+}
+
 int main()
 {
     printf("============================================================\n");
@@ -78,6 +200,8 @@ int main()
     test_tty_log();
     test_file_log();
     test_reset_logger_level();
+    test_async_block();
+    test_async_drop();
     
     printf("\n============================================================\n");
     printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
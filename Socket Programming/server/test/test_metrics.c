@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+#include "command.h"
+#include "filelock.h"
+#include "logger.h"
+
+#define THREADS 8
+#define SESSIONS_PER_THREAD 1000
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static metrics_snapshot_t g_before;
+static metrics_snapshot_t g_after;
+
+static int handle_test(cmd_handler_context_t context, const proto_command_t *cmd)
+{
+    (void)context;
+    (void)cmd;
+    return 0;
+}
+
+static void test_histogram()
+{
+    printf("\n--- Test 1: Histogram Buckets ---\n");
+
+    metrics_get_snapshot(&g_before);
+    metrics_observe_latency(METRICS_DATA_CONNECT, 0);
+    metrics_observe_latency(METRICS_DATA_CONNECT, 16);
+    metrics_observe_latency(METRICS_DATA_CONNECT, 17);
+    metrics_observe_latency(METRICS_DATA_CONNECT, 32);
+    metrics_observe_latency(METRICS_DATA_CONNECT, 1000);
+    metrics_observe_latency(METRICS_DATA_CONNECT, METRICS_MAX_BOUND_US);
+    metrics_observe_latency(METRICS_DATA_CONNECT, METRICS_MAX_BOUND_US + 1);
+    metrics_get_snapshot(&g_after);
+
+    const metrics_histogram_t *b = &g_before.latencies[METRICS_DATA_CONNECT];
+    const metrics_histogram_t *a = &g_after.latencies[METRICS_DATA_CONNECT];
+    int last = METRICS_HISTOGRAM_BUCKETS - 1;
+    if (a->count - b->count != 7 || a->buckets[0] - b->buckets[0] != 2 || a->buckets[1] - b->buckets[1] != 2 ||
+        a->buckets[6] - b->buckets[6] != 1 || a->buckets[last - 1] - b->buckets[last - 1] != 1 ||
+        a->buckets[last] - b->buckets[last] != 1)
+        test_fail("Bucket placement", "sample in the wrong bucket");
+    else
+        test_pass("Bucket placement");
+
+    if (a->sum_us - b->sum_us != 16 + 17 + 32 + 1000 + 2 * (unsigned long long)METRICS_MAX_BOUND_US + 1)
+        test_fail("Histogram sum", "unexpected sum");
+    else
+        test_pass("Histogram sum");
+
+    // Quantiles report the bound of the bucket they fall in
+    metrics_histogram_t histogram;
+    memset(&histogram, 0, sizeof(histogram));
+    histogram.count = 100;
+    histogram.buckets[0] = 50;
+    histogram.buckets[3] = 49;
+    histogram.buckets[last] = 1;
+    if (metrics_histogram_quantile(&histogram, 0.5) != 16 || metrics_histogram_quantile(&histogram, 0.99) != 128 ||
+        metrics_histogram_quantile(&histogram, 1.0) != -1)
+        test_fail("Quantiles", "unexpected bound");
+    else
+        test_pass("Quantiles");
+
+    memset(&histogram, 0, sizeof(histogram));
+    if (metrics_histogram_quantile(&histogram, 0.5) != 0 || metrics_histogram_quantile(NULL, 0.5) != 0)
+        test_fail("Empty quantile", "empty histogram has a quantile");
+    else
+        test_pass("Empty quantile");
+}
+
+static void *record_sessions(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < SESSIONS_PER_THREAD; i++)
+        metrics_record_session(1);
+    return NULL;
+}
+
+static void test_thread_shards()
+{
+    printf("\n--- Test 2: Thread Shards ---\n");
+
+    metrics_get_snapshot(&g_before);
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, record_sessions, NULL);
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+    metrics_get_snapshot(&g_after);
+
+    // The threads have exited, so their counts must have survived in the retired totals
+    if (g_after.sessions_opened - g_before.sessions_opened != THREADS * SESSIONS_PER_THREAD)
+        test_fail("Exited threads counted", "counts lost when threads exited");
+    else
+        test_pass("Exited threads counted");
+
+    metrics_record_session(0);
+    metrics_get_snapshot(&g_before);
+    if (g_before.sessions_closed - g_after.sessions_closed != 1)
+        test_fail("Live thread counted", "own shard not merged");
+    else
+        test_pass("Live thread counted");
+}
+
+static void test_transfers_and_commands()
+{
+    printf("\n--- Test 3: Transfers and Commands ---\n");
+
+    metrics_get_snapshot(&g_before);
+    metrics_record_transfer(METRICS_DOWNLOAD, METRICS_RESULT_OK, 1000, 2000);
+    metrics_record_transfer(METRICS_DOWNLOAD, METRICS_RESULT_ABORTED, 500, 100);
+    metrics_record_transfer(METRICS_UPLOAD, METRICS_RESULT_FAILED, 500, 100);
+    metrics_get_snapshot(&g_after);
+
+    if (g_after.transfer_results[METRICS_DOWNLOAD][METRICS_RESULT_OK] - g_before.transfer_results[METRICS_DOWNLOAD][METRICS_RESULT_OK] != 1 ||
+        g_after.transfer_results[METRICS_DOWNLOAD][METRICS_RESULT_ABORTED] - g_before.transfer_results[METRICS_DOWNLOAD][METRICS_RESULT_ABORTED] != 1 ||
+        g_after.transfer_results[METRICS_UPLOAD][METRICS_RESULT_FAILED] - g_before.transfer_results[METRICS_UPLOAD][METRICS_RESULT_FAILED] != 1)
+        test_fail("Transfer results", "unexpected outcome counts");
+    else
+        test_pass("Transfer results");
+
+    if (g_after.transfer_bytes[METRICS_DOWNLOAD] - g_before.transfer_bytes[METRICS_DOWNLOAD] != 1000 ||
+        g_after.transfer_bytes[METRICS_UPLOAD] != g_before.transfer_bytes[METRICS_UPLOAD] ||
+        g_after.transfers[METRICS_DOWNLOAD].count - g_before.transfers[METRICS_DOWNLOAD].count != 1)
+        test_fail("Successful bytes only", "bytes of a failed transfer counted");
+    else
+        test_pass("Successful bytes only");
+
+    // Uncontended lock acquisitions count as waits of 0
+    metrics_get_snapshot(&g_before);
+    file_lock_acquire_shared("/metrics/test");
+    file_lock_acquire_shared("/metrics/test");
+    file_lock_release_shared("/metrics/test");
+    file_lock_release_shared("/metrics/test");
+    file_lock_acquire_exclusive("/metrics/test");
+    file_lock_release_exclusive("/metrics/test");
+    metrics_get_snapshot(&g_after);
+    const metrics_histogram_t *wait_before = &g_before.latencies[METRICS_FILE_LOCK_WAIT];
+    const metrics_histogram_t *wait_after = &g_after.latencies[METRICS_FILE_LOCK_WAIT];
+    if (wait_after->count - wait_before->count != 3 || wait_after->buckets[0] - wait_before->buckets[0] != 3)
+        test_fail("Lock wait", "acquisitions not recorded");
+    else
+        test_pass("Lock wait");
+
+    // Dispatch times every command, unknown ones in their own slot
+    proto_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    strcpy(cmd.command, "TEST");
+    proto_command_t unknown = cmd;
+    strcpy(unknown.command, "XYZZ");
+
+    cmd_init();
+    cmd_register_handler("TEST", handle_test, 0);
+    metrics_get_snapshot(&g_before);
+    cmd_dispatch(NULL, &cmd);
+    cmd_dispatch(NULL, &cmd);
+    cmd_dispatch(NULL, &unknown);
+    metrics_get_snapshot(&g_after);
+
+    int slot = -1;
+    for (int i = 0; i < CMD_MAX_HANDLERS; i++)
+    {
+        const char *name = cmd_get_handler_name(i);
+        if (name && strcmp(name, "TEST") == 0)
+            slot = i;
+    }
+    if (slot < 0 || g_after.commands[slot].count - g_before.commands[slot].count != 2 ||
+        g_after.commands[METRICS_UNKNOWN_COMMAND].count - g_before.commands[METRICS_UNKNOWN_COMMAND].count != 1)
+        test_fail("Command latency", "dispatch not timed");
+    else
+        test_pass("Command latency");
+}
+
+static void test_render()
+{
+    printf("\n--- Test 4: Rendering ---\n");
+
+    size_t length = 0;
+    char *text = metrics_render(METRICS_FORMAT_PROMETHEUS, &length);
+    if (!text || strlen(text) != length ||
+        !strstr(text, "# TYPE ftp_sessions_opened_total counter\n") ||
+        !strstr(text, "ftp_transfers_total{direction=\"download\",result=\"ok\"}") ||
+        !strstr(text, "ftp_data_connect_seconds_bucket{le=\"+Inf\"} ") ||
+        !strstr(text, "ftp_data_connect_seconds_count ") ||
+        !strstr(text, "ftp_command_duration_seconds_count{command=\"TEST\"} 2\n") ||
+        !strstr(text, "ftp_transfer_duration_seconds_sum{direction=\"upload\"} "))
+        test_fail("Prometheus format", "expected series missing");
+    else
+        test_pass("Prometheus format");
+    free(text);
+
+    text = metrics_render(METRICS_FORMAT_TEXT, NULL);
+    if (!text || strncmp(text, "Sessions: ", 10) != 0 || !strstr(text, "Command TEST: 2 samples"))
+        test_fail("Text format", "expected lines missing");
+    else
+        test_pass("Text format");
+    free(text);
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Metrics Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+
+    test_histogram();
+    test_thread_shards();
+    test_transfers_and_commands();
+    test_render();
+
+    cmd_cleanup();
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
@@ -0,0 +1,151 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mlsx.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static fs_file_info_t make_info(fs_file_type_t type, long long size)
+{
+    fs_file_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.type = type;
+    info.size = size;
+    info.last_modified = 1700000000; // 2023-11-14 22:13:20 UTC
+    info.mode = 0644;
+    info.uid = 1000;
+    info.gid = 100;
+    return info;
+}
+
+static void test_fact_lists()
+{
+    printf("\n--- Test 1: Fact Lists ---\n");
+
+    unsigned int facts = mlsx_parse_fact_list("Type;SIZE;unix.owner;bogus;;");
+    if (facts != (MLSX_FACT_TYPE | MLSX_FACT_SIZE | MLSX_FACT_UNIX_OWNER))
+        test_fail("Parse facts", "unexpected mask");
+    else
+        test_pass("Parse facts");
+
+    if (mlsx_parse_fact_list("") != 0 || mlsx_parse_fact_list(NULL) != 0 ||
+        mlsx_parse_fact_list("modify") != MLSX_FACT_MODIFY)
+        test_fail("Parse edge cases", "unexpected mask");
+    else
+        test_pass("Parse edge cases");
+
+    char buffer[MLSX_MAX_FACTS_LEN];
+    if (mlsx_format_fact_list(facts, 0, buffer, sizeof(buffer)) != 0 ||
+        strcmp(buffer, "type;size;UNIX.owner;") != 0)
+        test_fail("Selected facts", buffer);
+    else
+        test_pass("Selected facts");
+
+    if (mlsx_format_fact_list(MLSX_FACT_TYPE | MLSX_FACT_PERM, 1, buffer, sizeof(buffer)) != 0 ||
+        strcmp(buffer, "type*;size;modify;perm*;UNIX.mode;UNIX.owner;UNIX.group;"
+                       "UNIX.ownername;UNIX.groupname;") != 0)
+        test_fail("Marked facts", buffer);
+    else
+        test_pass("Marked facts");
+
+    if (mlsx_format_fact_list(MLSX_DEFAULT_FACTS, 1, buffer, 8) != -1 || buffer[0] != '\0')
+        test_fail("Short fact list buffer", "overflow not reported");
+    else
+        test_pass("Short fact list buffer");
+}
+
+static void test_entries()
+{
+    printf("\n--- Test 2: Entries ---\n");
+
+    char buffer[MLSX_MAX_FACTS_LEN + 64];
+    fs_file_info_t file = make_info(FS_TYPE_FILE, 1234);
+    int length = mlsx_format_entry(&file, MLSX_DEFAULT_FACTS, AUTH_PERM_READ | AUTH_PERM_WRITE,
+                                   "a b.txt", buffer, sizeof(buffer));
+    const char *expected = "type=file;size=1234;modify=20231114221320;perm=arw;UNIX.mode=0644; a b.txt";
+    if (length != (int)strlen(expected) || strcmp(buffer, expected) != 0)
+        test_fail("File entry", buffer);
+    else
+        test_pass("File entry");
+
+    // Directories carry no size, and ADMIN grants every operation
+    fs_file_info_t dir = make_info(FS_TYPE_DIR, 4096);
+    dir.mode = 0755;
+    length = mlsx_format_entry(&dir, MLSX_DEFAULT_FACTS | MLSX_FACT_UNIX_OWNER | MLSX_FACT_UNIX_GROUP,
+                               AUTH_PERM_ADMIN, "sub", buffer, sizeof(buffer));
+    expected = "type=dir;modify=20231114221320;perm=cdeflmp;UNIX.mode=0755;UNIX.owner=1000;UNIX.group=100; sub";
+    if (length < 0 || strcmp(buffer, expected) != 0)
+        test_fail("Directory entry", buffer);
+    else
+        test_pass("Directory entry");
+
+    // Read-only users may list a directory but not change it
+    length = mlsx_format_entry(&dir, MLSX_FACT_PERM, AUTH_PERM_READ, "sub", buffer, sizeof(buffer));
+    if (length < 0 || strcmp(buffer, "perm=el; sub") != 0)
+        test_fail("Read-only perm", buffer);
+    else
+        test_pass("Read-only perm");
+
+    fs_file_info_t link = make_info(FS_TYPE_SYMLINK, 10);
+    length = mlsx_format_entry(&link, MLSX_FACT_TYPE, AUTH_PERM_NONE, "ln", buffer, sizeof(buffer));
+    if (length < 0 || strcmp(buffer, "type=OS.unix=symlink; ln") != 0)
+        test_fail("Symlink entry", buffer);
+    else
+        test_pass("Symlink entry");
+
+    length = mlsx_format_entry(&file, 0, AUTH_PERM_NONE, "bare", buffer, sizeof(buffer));
+    if (length != 5 || strcmp(buffer, " bare") != 0)
+        test_fail("No facts", buffer);
+    else
+        test_pass("No facts");
+
+    // An entry that does not fit is rejected as a whole
+    length = mlsx_format_entry(&file, MLSX_DEFAULT_FACTS, AUTH_PERM_READ, "a b.txt", buffer, 20);
+    if (length != -1 || buffer[0] != '\0')
+        test_fail("Short entry buffer", "overflow not reported");
+    else
+        test_pass("Short entry buffer");
+
+    if (mlsx_format_entry(NULL, MLSX_DEFAULT_FACTS, AUTH_PERM_READ, "x", buffer, sizeof(buffer)) != -1 ||
+        mlsx_format_entry(&file, MLSX_DEFAULT_FACTS, AUTH_PERM_READ, NULL, buffer, sizeof(buffer)) != -1)
+        test_fail("Invalid arguments", "accepted");
+    else
+        test_pass("Invalid arguments");
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("MLSx Formatter Test Suite\n");
+    printf("============================================================\n");
+
+    test_fact_lists();
+    test_entries();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
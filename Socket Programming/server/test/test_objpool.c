@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "network.h"
+#include "objpool.h"
+#include "strintern.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void test_object_pool()
+{
+    printf("\n--- Test 1: Object Pool ---\n");
+
+    objpool_t pool = OBJPOOL_INITIALIZER(100, 4);
+    void *objects[6];
+    int aligned = 1;
+    for (int i = 0; i < 6; i++)
+    {
+        objects[i] = objpool_alloc(&pool);
+        if (!objects[i] || ((uintptr_t)objects[i] & 15) != 0)
+            aligned = 0;
+        else
+            memset(objects[i], i, 100);
+    }
+    if (!aligned)
+        test_fail("Allocate", "object missing or misaligned");
+    else
+        test_pass("Allocate");
+
+    objpool_stats_t stats;
+    objpool_get_stats(&pool, &stats);
+    if (stats.object_size != 112 || stats.allocated != 8 || stats.in_use != 6)
+        test_fail("Stats", "unexpected slab accounting");
+    else
+        test_pass("Stats");
+
+    // A freed object is handed out again before the pool grows
+    void *freed = objects[2];
+    objpool_free(&pool, freed);
+    objects[2] = objpool_alloc(&pool);
+    objpool_get_stats(&pool, &stats);
+    if (objects[2] != freed || stats.allocated != 8)
+        test_fail("Reuse", "freed object not recycled");
+    else
+        test_pass("Reuse");
+
+    for (int i = 0; i < 6; i++)
+        objpool_free(&pool, objects[i]);
+    objpool_destroy(&pool);
+    objpool_get_stats(&pool, &stats);
+    if (stats.allocated != 0 || stats.in_use != 0)
+        test_fail("Destroy", "slabs left");
+    else
+        test_pass("Destroy");
+}
+
+static void test_shared_strings()
+{
+    printf("\n--- Test 2: Shared Strings ---\n");
+
+    strintern_stats_t before;
+    strintern_get_stats(&before);
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "/home/%s", "alice");
+    const char *a = strintern_acquire("/home/alice");
+    const char *b = strintern_acquire(buffer);
+    const char *c = strintern_acquire("/home/bob");
+    if (!a || a != b || a == c || strcmp(c, "/home/bob") != 0)
+        test_fail("Share", "equal strings not shared");
+    else
+        test_pass("Share");
+
+    const char *empty = strintern_acquire("");
+    if (!empty || empty[0] != '\0' || strintern_acquire(NULL) != NULL)
+        test_fail("Empty", "unexpected result");
+    else
+        test_pass("Empty");
+
+    strintern_stats_t stats;
+    strintern_get_stats(&stats);
+    if (stats.strings != before.strings + 2 || stats.references != before.references + 3)
+        test_fail("Count", "unexpected string count");
+    else
+        test_pass("Count");
+
+    // The copy lives until its last owner lets go
+    strintern_release(a);
+    if (strcmp(b, "/home/alice") != 0)
+        test_fail("Release", "string freed while still owned");
+    else
+        test_pass("Release");
+    strintern_release(b);
+    strintern_release(c);
+    strintern_release(empty);
+
+    // Many strings make the table grow
+    const char *many[500];
+    int ok = 1;
+    for (int i = 0; i < 500; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "/dir%d", i);
+        many[i] = strintern_acquire(buffer);
+        if (!many[i])
+            ok = 0;
+    }
+    for (int i = 0; ok && i < 500; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "/dir%d", i);
+        const char *again = strintern_acquire(buffer);
+        if (again != many[i])
+            ok = 0;
+        strintern_release(again);
+    }
+    for (int i = 0; i < 500; i++)
+        strintern_release(many[i]);
+
+    strintern_get_stats(&stats);
+    if (!ok || stats.strings != before.strings || stats.references != before.references ||
+        stats.bytes != before.bytes)
+        test_fail("Grow and drain", "lookups failed or strings left");
+    else
+        test_pass("Grow and drain");
+}
+
+static void test_line_buffer()
+{
+    printf("\n--- Test 3: Line Buffer Storage ---\n");
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        test_fail("Socket pair", "socketpair failed");
+        return;
+    }
+
+    net_line_buffer_t lines;
+    net_line_buffer_init(&lines);
+    char line[64];
+
+    if (write(fds[1], "NOOP\r\nSY", 8) != 8 || net_line_buffer_fill(fds[0], &lines) != 8 || !lines.data)
+        test_fail("Fill", "no data");
+    else
+        test_pass("Fill");
+
+    // Storage is kept while a partial line is pending and dropped once drained
+    int first = net_line_buffer_next(&lines, line, sizeof(line));
+    int partial = net_line_buffer_next(&lines, line, sizeof(line));
+    int kept = lines.data != NULL;
+    if (write(fds[1], "ST\r\n", 4) != 4 || net_line_buffer_fill(fds[0], &lines) != 4)
+        kept = 0;
+    int second = net_line_buffer_next(&lines, line, sizeof(line));
+    if (first != 6 || partial != 0 || !kept || second != 6 || strcmp(line, "SYST\r\n") != 0 || lines.data)
+        test_fail("Drain", "storage not released after the last line");
+    else
+        test_pass("Drain");
+
+    if (net_line_buffer_next(&lines, line, sizeof(line)) != 0)
+        test_fail("Empty", "line from an empty buffer");
+    else
+        test_pass("Empty");
+
+    net_line_buffer_free(&lines);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Object Pool Test Suite\n");
+    printf("============================================================\n");
+
+    test_object_pool();
+    test_shared_strings();
+    test_line_buffer();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
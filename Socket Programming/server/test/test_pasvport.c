@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pasvport.h"
+#include "network.h"
+#include "logger.h"
+
+// Below the usual ephemeral range, so client sockets do not take them
+#define RANGE_MIN 31000
+#define RANGE_MAX 31007
+#define RANGE_SIZE (RANGE_MAX - RANGE_MIN + 1)
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void test_unique_leases()
+{
+    printf("\n--- Test 1: Unique Leases and Reuse ---\n");
+
+    if (pasv_port_init(RANGE_MIN, RANGE_MAX, "127.0.0.1", 2) != 0)
+    {
+        test_fail("Unique leases", "init failed");
+        return;
+    }
+
+    pasv_port_stats_t stats;
+    pasv_port_get_stats(&stats);
+    if (stats.range_size != RANGE_SIZE || stats.prebound_sockets != 2 || stats.leased_ports != 2)
+    {
+        test_fail("Unique leases", "pre-bound sockets not created");
+        pasv_port_cleanup();
+        return;
+    }
+
+    socket_t socks[RANGE_SIZE];
+    uint16_t ports[RANGE_SIZE];
+    int seen[RANGE_SIZE] = {0};
+    int failed = 0;
+    for (int i = 0; i < RANGE_SIZE; i++)
+    {
+        socks[i] = pasv_port_acquire("127.0.0.1", 5, &ports[i]);
+        if (socks[i] == INVALID_SOCKET_T || ports[i] < RANGE_MIN || ports[i] > RANGE_MAX ||
+            seen[ports[i] - RANGE_MIN]++)
+            failed = 1;
+    }
+
+    uint16_t extra_port;
+    socket_t extra = pasv_port_acquire("127.0.0.1", 5, &extra_port);
+    pasv_port_get_stats(&stats);
+    if (failed || extra != INVALID_SOCKET_T || stats.free_ports != 0 || stats.prebound_hits != 2)
+        test_fail("Unique leases", "range not leased exactly once");
+    else
+        test_pass("Unique leases");
+
+    // A released port is bound again right away to refill the pool
+    net_close_socket(socks[0]);
+    pasv_port_release(ports[0]);
+    pasv_port_get_stats(&stats);
+    uint16_t reused_port = 0;
+    socket_t reused = pasv_port_acquire("127.0.0.1", 5, &reused_port);
+    if (stats.prebound_sockets != 1 || stats.free_ports != 0 || reused == INVALID_SOCKET_T ||
+        reused_port != ports[0])
+        test_fail("Release", "released port not reused through the pool");
+    else
+        test_pass("Release");
+    socks[0] = reused;
+
+    for (int i = 0; i < RANGE_SIZE; i++)
+    {
+        net_close_socket(socks[i]);
+        pasv_port_release(ports[i]);
+    }
+    pasv_port_cleanup();
+}
+
+static void test_stray_connection()
+{
+    printf("\n--- Test 2: Stray Connection on Pre-bound Socket ---\n");
+
+    if (pasv_port_init(RANGE_MAX + 10, RANGE_MAX + 10, "127.0.0.1", 1) != 0)
+    {
+        test_fail("Stray connection", "init failed");
+        return;
+    }
+
+    socket_t stray = net_connect("127.0.0.1", RANGE_MAX + 10);
+    uint16_t port = 0;
+    socket_t sock = pasv_port_acquire("127.0.0.1", 5, &port);
+    socket_t pending = sock != INVALID_SOCKET_T ? net_accept(sock, NULL, 0, NULL) : INVALID_SOCKET_T;
+
+    if (stray == INVALID_SOCKET_T || sock == INVALID_SOCKET_T || port != RANGE_MAX + 10)
+        test_fail("Stray connection", "pre-bound socket not handed out");
+    else if (pending != INVALID_SOCKET_T)
+        test_fail("Stray connection", "connection made before the lease was accepted");
+    else
+        test_pass("Stray connection");
+
+    if (pending != INVALID_SOCKET_T)
+        net_close_socket(pending);
+    if (stray != INVALID_SOCKET_T)
+        net_close_socket(stray);
+    if (sock != INVALID_SOCKET_T)
+    {
+        net_close_socket(sock);
+        pasv_port_release(port);
+    }
+    pasv_port_cleanup();
+}
+
+static void test_port_in_use()
+{
+    printf("\n--- Test 3: Port Taken by Another Socket ---\n");
+
+    uint16_t busy_port = RANGE_MAX + 20;
+    socket_t busy = net_create_listening_socket(NET_AF_UNSPEC, "127.0.0.1", busy_port, 5);
+    if (busy == INVALID_SOCKET_T || pasv_port_init(busy_port, busy_port + 1, NULL, 0) != 0)
+    {
+        test_fail("Port in use", "setup failed");
+        if (busy != INVALID_SOCKET_T)
+            net_close_socket(busy);
+        return;
+    }
+
+    uint16_t port = 0;
+    uint16_t second_port = 0;
+    socket_t sock = pasv_port_acquire("127.0.0.1", 5, &port);
+    socket_t second = pasv_port_acquire("127.0.0.1", 5, &second_port);
+    pasv_port_stats_t stats;
+    pasv_port_get_stats(&stats);
+
+    if (sock == INVALID_SOCKET_T || port != busy_port + 1 || second != INVALID_SOCKET_T ||
+        stats.bind_failures == 0 || stats.free_ports != 1)
+        test_fail("Port in use", "busy port not skipped");
+    else
+        test_pass("Port in use");
+
+    if (second != INVALID_SOCKET_T)
+        net_close_socket(second);
+    if (sock != INVALID_SOCKET_T)
+        net_close_socket(sock);
+    net_close_socket(busy);
+    pasv_port_cleanup();
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Passive Port Allocator Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+    net_init();
+
+    test_unique_leases();
+    test_stray_connection();
+    test_port_in_use();
+
+    net_cleanup();
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
@@ -0,0 +1,249 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ratelimit.h"
+#include "logger.h"
+
+#define MB (1024ULL * 1024)
+#define SLACK_US 50000 // Time the test itself may take between charges
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static long long burst_of(unsigned long long rate)
+{
+    unsigned long long burst = rate / RATELIMIT_BURST_DIVISOR;
+    return (long long)(burst < RATELIMIT_MIN_BURST ? RATELIMIT_MIN_BURST : burst);
+}
+
+// Charges of a few extra bytes may add microseconds
+static int about(long long wait_us, long long expected_us)
+{
+    return wait_us <= expected_us + 1000 && wait_us >= expected_us - SLACK_US;
+}
+
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void test_unlimited()
+{
+    printf("\n--- Test 1: Unlimited ---\n");
+
+    ratelimit_init(0, 0);
+    ratelimit_session_t *limiter = ratelimit_session_create();
+    long long wait = 0;
+    for (int i = 0; i < 1000; i++)
+        wait += limiter ? ratelimit_charge(limiter, 1024 * 1024) : 1;
+
+    if (!limiter || wait != 0 || ratelimit_chunk_size(limiter, 65536) != 65536 ||
+        ratelimit_charge(NULL, 100) != 0 || ratelimit_chunk_size(NULL, 4096) != 4096)
+        test_fail("Unlimited", "unlimited transfer was paced");
+    else
+        test_pass("Unlimited");
+    ratelimit_session_destroy(limiter);
+
+    if (ratelimit_init(RATELIMIT_MAX_RATE + 1, 0) != -1 || ratelimit_init(0, RATELIMIT_MAX_RATE + 1) != -1)
+        test_fail("Invalid rate", "rate above the maximum accepted");
+    else
+        test_pass("Invalid rate");
+}
+
+static void test_session_bucket()
+{
+    printf("\n--- Test 2: Session Bucket ---\n");
+
+    ratelimit_init(0, MB);
+    ratelimit_session_t *limiter = ratelimit_session_create();
+    ratelimit_session_t *other = ratelimit_session_create();
+
+    // The burst goes through, then half a second of debt
+    long long first = ratelimit_charge(limiter, (size_t)burst_of(MB));
+    long long second = ratelimit_charge(limiter, MB / 2);
+    if (first != 0 || !about(second, 500000))
+        test_fail("Burst then debt", "unexpected pause");
+    else
+        test_pass("Burst then debt");
+
+    if (ratelimit_charge(other, 1) != 0)
+        test_fail("Sessions independent", "one session paced by another");
+    else
+        test_pass("Sessions independent");
+
+    if (ratelimit_chunk_size(limiter, 65536) != MB / RATELIMIT_CHUNKS_PER_SECOND ||
+        ratelimit_chunk_size(limiter, 1000) != 1000)
+        test_fail("Chunk size", "chunk does not follow the rate");
+    else
+        test_pass("Chunk size");
+
+    ratelimit_session_destroy(limiter);
+    ratelimit_session_destroy(other);
+
+    // Slow sessions still move reasonable chunks
+    ratelimit_init(0, 100);
+    limiter = ratelimit_session_create();
+    if (ratelimit_chunk_size(limiter, 65536) != RATELIMIT_MIN_CHUNK)
+        test_fail("Minimum chunk", "chunk below the minimum");
+    else
+        test_pass("Minimum chunk");
+    ratelimit_session_destroy(limiter);
+}
+
+static void test_user_bucket()
+{
+    printf("\n--- Test 3: Shared User Bucket ---\n");
+
+    ratelimit_init(0, 0);
+    ratelimit_session_t *alice1 = ratelimit_session_create();
+    ratelimit_session_t *alice2 = ratelimit_session_create();
+    ratelimit_session_t *bob = ratelimit_session_create();
+    ratelimit_session_set_user(alice1, "alice", MB);
+    ratelimit_session_set_user(alice2, "alice", MB);
+    ratelimit_session_set_user(bob, "bob", MB);
+
+    // The second session of a user inherits the debt of the first
+    long long first = ratelimit_charge(alice1, (size_t)(burst_of(MB) + MB));
+    long long second = ratelimit_charge(alice2, 1);
+    long long other = ratelimit_charge(bob, 1);
+    if (!about(first, 1000000) || !about(second, 1000000) || other != 0)
+        test_fail("Shared debt", "user bucket not shared, or shared across users");
+    else
+        test_pass("Shared debt");
+
+    ratelimit_stats_t stats;
+    ratelimit_get_stats(&stats);
+    if (stats.user_buckets != 2 || stats.delays != 2)
+        test_fail("User statistics", "unexpected bucket or delay count");
+    else
+        test_pass("User statistics");
+
+    // The latest login sets the rate; logging out leaves the session bucket only
+    ratelimit_session_set_user(alice2, "alice", 0);
+    if (ratelimit_charge(alice1, MB) != 0)
+        test_fail("Rate follows login", "old user rate still applied");
+    else
+        test_pass("Rate follows login");
+
+    ratelimit_session_set_user(bob, NULL, 0);
+    ratelimit_session_destroy(alice1);
+    ratelimit_session_destroy(alice2);
+    ratelimit_get_stats(&stats);
+    if (stats.user_buckets != 0)
+        test_fail("User buckets freed", "bucket left after the last session");
+    else
+        test_pass("User buckets freed");
+    ratelimit_session_destroy(bob);
+}
+
+static void test_hierarchy()
+{
+    printf("\n--- Test 4: Global and Session Levels ---\n");
+
+    // Every session draws from the global bucket
+    ratelimit_init(MB, 0);
+    ratelimit_session_t *first = ratelimit_session_create();
+    ratelimit_session_t *second = ratelimit_session_create();
+    long long a = ratelimit_charge(first, (size_t)(burst_of(MB) + MB / 2));
+    long long b = ratelimit_charge(second, MB / 2);
+    if (!about(a, 500000) || !about(b, 1000000))
+        test_fail("Global shared", "global bucket not shared");
+    else
+        test_pass("Global shared");
+    ratelimit_session_destroy(first);
+    ratelimit_session_destroy(second);
+
+    // The strictest level decides the pause and the chunk size
+    ratelimit_init(10 * MB, MB);
+    first = ratelimit_session_create();
+    ratelimit_session_set_user(first, "carol", 4 * MB);
+    long long wait = ratelimit_charge(first, (size_t)(burst_of(MB) + MB));
+    if (!about(wait, 1000000) || ratelimit_chunk_size(first, 1 << 20) != MB / RATELIMIT_CHUNKS_PER_SECOND)
+        test_fail("Strictest level", "pause not set by the session rate");
+    else
+        test_pass("Strictest level");
+    ratelimit_session_destroy(first);
+}
+
+static void test_pacing()
+{
+    printf("\n--- Test 5: Paced Throughput ---\n");
+
+    // Sleeping as told keeps a transfer at the configured rate
+    unsigned long long rate = 2 * MB;
+    ratelimit_init(0, rate);
+    ratelimit_session_t *limiter = ratelimit_session_create();
+
+    long long total = burst_of(rate) + (long long)MB;
+    long long start = now_us();
+    for (long long sent = 0; sent < total;)
+    {
+        size_t chunk = ratelimit_chunk_size(limiter, 65536);
+        long long wait = ratelimit_charge(limiter, chunk);
+        sent += (long long)chunk;
+        if (wait > 0)
+        {
+            struct timespec ts = {wait / 1000000, (wait % 1000000) * 1000};
+            nanosleep(&ts, NULL);
+        }
+    }
+    long long elapsed = now_us() - start;
+
+    // One megabyte past the burst at 2MB/s takes half a second
+    if (elapsed < 450000 || elapsed > 800000)
+    {
+        char message[64];
+        snprintf(message, sizeof(message), "took %lld us", elapsed);
+        test_fail("Paced throughput", message);
+    }
+    else
+        test_pass("Paced throughput");
+    ratelimit_session_destroy(limiter);
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Bandwidth Scheduler Test Suite\n");
+    printf("============================================================\n");
+
+    logger_init(0, LOG_LEVEL_ERROR);
+
+    test_unlimited();
+    test_session_bucket();
+    test_user_bucket();
+    test_hierarchy();
+    test_pacing();
+
+    ratelimit_cleanup();
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
@@ -11,6 +11,8 @@ import os
 import tempfile
 import sys
 import io
+import hashlib
+import threading
 
 # --- Configuration ---
 FTP_HOST = 'localhost'
@@ -268,6 +270,142 @@ def test_resume_upload():
         if local_temp_file and os.path.exists(local_temp_file):
             os.unlink(local_temp_file)
 
+def retr_after(ftp, remote_filename, commands):
+    """RETR a file with commands sent after PASV, which resets REST and RANG"""
+    host, port = ftp.makepasv()
+    for cmd in commands:
+        ftp.sendcmd(cmd)
+    conn = socket.create_connection((host, port), timeout=30)
+    chunks = []
+    try:
+        ftp.sendcmd(f'RETR {remote_filename}')
+        while True:
+            data = conn.recv(65536)
+            if not data:
+                break
+            chunks.append(data)
+    finally:
+        conn.close()
+    ftp.voidresp()
+    return b''.join(chunks)
+
+
+def download_range(remote_filename, start, end):
+    """Download bytes start..end (inclusive) of a file over its own connection"""
+    ftp = ftplib.FTP()
+    ftp.connect(FTP_HOST, FTP_PORT, timeout=30)
+    ftp.login(FTP_USER, FTP_PASS)
+    try:
+        ftp.voidcmd('TYPE I')
+        return retr_after(ftp, remote_filename, [f'RANG {start} {end}'])
+    finally:
+        ftp.quit()
+
+
+def test_segmented_download():
+    """Test RANG + RETR (Segmented Parallel Download)"""
+    test_name = "Segmented Download (RANG + RETR)"
+    print("\n" + "="*60)
+    print(f"TEST 3: {test_name}")
+    print("="*60)
+
+    local_temp_file = None
+    remote_filename = 'segmented_download_test.bin'
+    segments = 4
+
+    try:
+        local_temp_file, original_size = create_large_file(3)
+        with open(local_temp_file, 'rb') as f:
+            original = f.read()
+
+        ftp = ftplib.FTP()
+        ftp.connect(FTP_HOST, FTP_PORT, timeout=30)
+        ftp.login(FTP_USER, FTP_PASS)
+        with open(local_temp_file, 'rb') as f:
+            ftp.storbinary(f'STOR {remote_filename}', f)
+
+        # Uneven segments, the last one asking past the end of the file
+        step = original_size // segments + 1
+        ranges = [(i * step, (i + 1) * step - 1) for i in range(segments)]
+        parts = [None] * segments
+        errors = []
+
+        def fetch(index):
+            try:
+                parts[index] = download_range(remote_filename, *ranges[index])
+            except Exception as e:
+                errors.append(str(e))
+
+        threads = [threading.Thread(target=fetch, args=(i,)) for i in range(segments)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        if errors:
+            results.add_result(test_name, False, errors[0])
+        elif b''.join(parts) != original:
+            results.add_result(test_name, False, "Reassembled segments differ from the original")
+        else:
+            results.add_result(test_name, True, f"{segments} segments reassembled: {original_size} bytes")
+
+        # A single byte, then ranges reset by REST and by "RANG 1 0"
+        single = download_range(remote_filename, 1000, 1000)
+
+        ftp.voidcmd('TYPE I')
+        rest_data = retr_after(ftp, remote_filename, ['RANG 10 19', 'REST 100'])
+        full_data = retr_after(ftp, remote_filename, ['RANG 10 19', 'RANG 1 0'])
+        if single != original[1000:1001] or rest_data != original[100:] or full_data != original:
+            results.add_result("RANG reset by REST and RANG 1 0", False, "Wrong bytes after reset")
+        else:
+            results.add_result("RANG reset by REST and RANG 1 0", True)
+
+        # HASH covers the range
+        ftp.sendcmd('RANG 0 999')
+        hash_reply = ftp.sendcmd(f'HASH {remote_filename}')
+        expected = hashlib.sha256(original[:1000]).hexdigest()
+        if f'0-999 {expected}' not in hash_reply.lower():
+            results.add_result("HASH over a RANG range", False, hash_reply)
+        else:
+            results.add_result("HASH over a RANG range", True)
+
+        # Ranges that cannot be served, and uploads, are refused
+        refused = []
+        for cmd in ('RANG 20 10', 'RANG 1', 'RANG a b'):
+            try:
+                ftp.sendcmd(cmd)
+            except ftplib.error_perm as e:
+                refused.append(str(e)[:3])
+        try:
+            retr_after(ftp, remote_filename, [f'RANG {original_size} {original_size + 10}'])
+        except ftplib.error_perm as e:
+            refused.append(str(e)[:3])
+        ftp.makepasv()
+        ftp.sendcmd('RANG 0 9')
+        try:
+            ftp.sendcmd('STOR rang_upload_test.bin')
+        except ftplib.error_perm as e:
+            refused.append(str(e)[:3])
+        if refused != ['501', '501', '501', '550', '504']:
+            results.add_result("RANG invalid ranges refused", False, f"Replies: {refused}")
+        else:
+            results.add_result("RANG invalid ranges refused", True)
+
+    except Exception as e:
+        results.add_result(test_name, False, str(e))
+        import traceback
+        traceback.print_exc()
+
+    finally:
+        try:
+            if 'ftp' in locals():
+                ftp.delete(remote_filename)
+                ftp.quit()
+        except:
+            pass
+        if local_temp_file and os.path.exists(local_temp_file):
+            os.unlink(local_temp_file)
+
 def main():
     print("============================================================")
     print("FTP REST Command (Breakpoint Resume) Test Suite")
@@ -293,6 +431,9 @@ def main():
     
     test_resume_upload()
     time.sleep(1)
+
+    test_segmented_download()
+    time.sleep(1)
     
     return results.summary()
 
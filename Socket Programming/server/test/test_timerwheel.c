@@ -0,0 +1,261 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "atomics.h"
+#include "network.h"
+#include "session.h"
+#include "timerwheel.h"
+#include "utils.h"
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static long long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+typedef struct
+{
+    int fired;        // Callback runs
+    long long at_ms;  // Time of the last run
+    int repeat;       // Runs that ask to be re-armed
+    int again_ms;     // Delay returned while repeating
+} probe_t;
+
+static int probe_fire(void *arg)
+{
+    probe_t *probe = (probe_t *)arg;
+    ATOMIC_STORE(&probe->at_ms, now_ms());
+    ATOMIC_FETCH_ADD(&probe->fired, 1);
+    if (probe->repeat > 0)
+    {
+        probe->repeat--;
+        return probe->again_ms;
+    }
+    return 0;
+}
+
+static int wait_fired(probe_t *probe, int count, int limit_ms)
+{
+    long long end = now_ms() + limit_ms;
+    while (ATOMIC_LOAD(&probe->fired) < count && now_ms() < end)
+    {
+        sleep_ms(2);
+    }
+    return ATOMIC_LOAD(&probe->fired) >= count;
+}
+
+static void test_expiry()
+{
+    printf("\n--- Test 1: Expiry ---\n");
+
+    probe_t probe = {0};
+    timerwheel_timer_t timer;
+    timerwheel_timer_init(&timer, probe_fire, &probe);
+
+    // Tick of 5 ms, so one turn of the wheel spans a bit over 2.5 s
+    long long start = now_ms();
+    if (timerwheel_schedule(&timer, 100) != 0 || !wait_fired(&probe, 1, 2000))
+        test_fail("Fire", "timer did not fire");
+    else if (probe.at_ms - start < 100)
+        test_fail("Fire", "timer fired early");
+    else
+        test_pass("Fire");
+
+    sleep_ms(50);
+    if (probe.fired != 1 || timer.armed)
+        test_fail("Once", "timer fired again");
+    else
+        test_pass("Once");
+
+    // A deadline beyond one turn waits out the rounds in its slot
+    probe_t late = {0};
+    timerwheel_timer_t long_timer;
+    timerwheel_timer_init(&long_timer, probe_fire, &late);
+    start = now_ms();
+    if (timerwheel_schedule(&long_timer, 3000) != 0 || !wait_fired(&late, 1, 5000))
+        test_fail("Beyond one turn", "timer did not fire");
+    else if (late.at_ms - start < 3000)
+        test_fail("Beyond one turn", "timer fired a turn early");
+    else
+        test_pass("Beyond one turn");
+}
+
+static void test_rearm_and_cancel()
+{
+    printf("\n--- Test 2: Re-arm and Cancel ---\n");
+
+    probe_t probe = {.repeat = 2, .again_ms = 20};
+    timerwheel_timer_t timer;
+    timerwheel_timer_init(&timer, probe_fire, &probe);
+    if (timerwheel_schedule(&timer, 20) != 0 || !wait_fired(&probe, 3, 2000))
+        test_fail("Re-arm", "callback did not re-arm the timer");
+    else
+        test_pass("Re-arm");
+
+    probe_t cancelled = {0};
+    timerwheel_timer_init(&timer, probe_fire, &cancelled);
+    timerwheel_schedule(&timer, 50);
+    timerwheel_cancel(&timer);
+    timerwheel_cancel(&timer); // Disarmed already, nothing to do
+    sleep_ms(150);
+    if (cancelled.fired != 0 || timer.armed)
+        test_fail("Cancel", "cancelled timer fired");
+    else
+        test_pass("Cancel");
+
+    // Scheduling an armed timer moves its deadline
+    probe_t moved = {0};
+    timerwheel_timer_init(&timer, probe_fire, &moved);
+    long long start = now_ms();
+    timerwheel_schedule(&timer, 30);
+    timerwheel_schedule(&timer, 300);
+    if (!wait_fired(&moved, 1, 2000) || moved.at_ms - start < 300 || moved.fired != 1)
+        test_fail("Move", "timer kept its old deadline");
+    else
+        test_pass("Move");
+
+    timerwheel_stats_t stats;
+    timerwheel_get_stats(&stats);
+    if (stats.armed != 0 || stats.tick_ms != 5)
+        test_fail("Stats", "unexpected armed count or tick");
+    else
+        test_pass("Stats");
+}
+
+static void test_many_timers()
+{
+    printf("\n--- Test 3: Many Timers ---\n");
+
+    enum { COUNT = 2000 };
+    probe_t *probes = (probe_t *)calloc(COUNT, sizeof(probe_t));
+    timerwheel_timer_t *timers = (timerwheel_timer_t *)calloc(COUNT, sizeof(timerwheel_timer_t));
+    if (!probes || !timers)
+    {
+        test_fail("Many timers", "allocation failed");
+        free(probes);
+        free(timers);
+        return;
+    }
+
+    // Every other timer is cancelled before it is due
+    for (int i = 0; i < COUNT; i++)
+    {
+        timerwheel_timer_init(&timers[i], probe_fire, &probes[i]);
+        timerwheel_schedule(&timers[i], 10 + (i % 200));
+    }
+    for (int i = 0; i < COUNT; i += 2)
+    {
+        timerwheel_cancel(&timers[i]);
+    }
+    sleep_ms(400);
+    for (int i = 0; i < COUNT; i++)
+    {
+        timerwheel_cancel(&timers[i]);
+    }
+
+    int wrong = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        if (probes[i].fired != (i % 2))
+            wrong++;
+    }
+    if (wrong != 0)
+        test_fail("Many timers", "some timers fired wrongly or not at all");
+    else
+        test_pass("Many timers");
+
+    free(probes);
+    free(timers);
+}
+
+static void test_session_idle()
+{
+    printf("\n--- Test 4: Session Idle Timeout ---\n");
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        test_fail("Idle timeout", "socketpair failed");
+        return;
+    }
+
+    session_t *session = session_create(fds[0], "127.0.0.1", 2121, "/tmp", "127.0.0.1");
+    if (!session || session_set_timeouts(session, 1000, 1000) != 0)
+    {
+        test_fail("Idle timeout", "no session or timer");
+        session_destroy(session);
+        close(fds[1]);
+        return;
+    }
+
+    // The wheel shuts the quiet connection down; the peer sees the end of the stream
+    long long start = now_ms();
+    char byte;
+    net_set_recv_timeout(fds[1], 5000);
+    ssize_t received = recv(fds[1], &byte, 1, 0);
+    long long waited = now_ms() - start;
+    if (received != 0 || waited < 1000 || waited > 4000)
+        test_fail("Idle timeout", "connection not closed in time");
+    else
+        test_pass("Idle timeout");
+
+    session_destroy(session);
+    close(fds[1]);
+}
+
+int main()
+{
+    printf("============================================================\n");
+    printf("Timer Wheel Test Suite\n");
+    printf("============================================================\n");
+
+    if (timerwheel_init(5) != 0)
+    {
+        fprintf(stderr, "Failed to start the timer wheel\n");
+        return 1;
+    }
+
+    test_expiry();
+    test_rearm_and_cancel();
+    test_many_timers();
+    test_session_idle();
+
+    timerwheel_shutdown();
+    if (timerwheel_is_running())
+        test_fail("Shutdown", "wheel still running");
+    else
+        test_pass("Shutdown");
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}
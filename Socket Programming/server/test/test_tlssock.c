@@ -0,0 +1,360 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "filesys.h"
+#include "logger.h"
+#include "network.h"
+#include "tlssock.h"
+
+#ifdef ENABLE_OPENSSL
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
+static int g_test_passed = 0;
+static int g_test_failed = 0;
+
+static void test_pass(const char *test_name)
+{
+    printf("✅ PASS: %s\n", test_name);
+    g_test_passed++;
+}
+
+static void test_fail(const char *test_name, const char *message)
+{
+    fprintf(stderr, "❌ FAIL: %s - %s\n", test_name, message);
+    g_test_failed++;
+}
+
+static void test_plain_sockets()
+{
+    printf("\n--- Test 1: Plain Sockets ---\n");
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    char buffer[16] = {0};
+    if (tlssock_is_secured(fds[0]) || net_send(fds[0], "plain", 5) != 5 ||
+        net_receive(fds[1], buffer, sizeof(buffer)) != 5 || strcmp(buffer, "plain") != 0 ||
+        net_receive_pending(fds[1]) != 0)
+        test_fail("Plain", "unsecured socket did not pass data untouched");
+    else
+        test_pass("Plain");
+    net_close_socket(fds[0]);
+    net_close_socket(fds[1]);
+}
+
+#ifdef ENABLE_OPENSSL
+
+static char g_cert_path[] = "/tmp/test_tlssock_XXXXXX";
+
+/**
+ * @brief Writes a self-signed certificate and its key into one PEM file
+ */
+static int write_certificate(void)
+{
+    int fd = mkstemp(g_cert_path);
+    if (fd < 0)
+        return -1;
+    close(fd);
+
+    EVP_PKEY *key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    X509 *cert = X509_new();
+    if (!key || !cert)
+        return -1;
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    FILE *file = fopen(g_cert_path, "w");
+    int rc = file && PEM_write_X509(file, cert) == 1 &&
+                     PEM_write_PrivateKey(file, key, NULL, NULL, 0, NULL, NULL) == 1
+                 ? 0
+                 : -1;
+    if (file)
+        fclose(file);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return rc;
+}
+
+typedef struct
+{
+    int sock;
+    int result;
+} accept_args_t;
+
+static void *accept_thread(void *arg)
+{
+    accept_args_t *args = (accept_args_t *)arg;
+    args->result = tlssock_accept(args->sock, 5000);
+    return NULL;
+}
+
+/**
+ * @brief Connects a client over a socket pair; fds[0] ends up secured by tlssock_accept()
+ *
+ * @return The client, or NULL if the handshake failed
+ */
+static SSL *connect_pair(SSL_CTX *client_ctx, SSL_SESSION *session, int fds[2])
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        return NULL;
+
+    accept_args_t args = {fds[0], -1};
+    pthread_t thread;
+    pthread_create(&thread, NULL, accept_thread, &args);
+
+    SSL *client = SSL_new(client_ctx);
+    SSL_set_fd(client, fds[1]);
+    if (session)
+        SSL_set_session(client, session);
+    int connected = SSL_connect(client);
+    pthread_join(thread, NULL);
+
+    if (connected != 1 || args.result != 0)
+    {
+        SSL_free(client);
+        close(fds[1]);
+        net_close_socket(fds[0]);
+        return NULL;
+    }
+    return client;
+}
+
+static void test_round_trip(SSL_CTX *client_ctx, SSL_SESSION **session)
+{
+    printf("\n--- Test 2: Handshake and Data ---\n");
+
+    int fds[2];
+    SSL *client = connect_pair(client_ctx, NULL, fds);
+    if (!client || !tlssock_is_secured(fds[0]))
+    {
+        test_fail("Handshake", "handshake failed");
+        return;
+    }
+    test_pass("Handshake");
+
+    char buffer[64] = {0};
+    SSL_write(client, "USER anonymous\r\n", 16);
+    if (net_receive(fds[0], buffer, sizeof(buffer)) != 16 || strcmp(buffer, "USER anonymous\r\n") != 0)
+        test_fail("Receive", "decrypted data differs");
+    else
+        test_pass("Receive");
+
+    memset(buffer, 0, sizeof(buffer));
+    if (net_send(fds[0], "331 OK\r\n", 8) != 8 || SSL_read(client, buffer, sizeof(buffer)) != 8 ||
+        strcmp(buffer, "331 OK\r\n") != 0)
+        test_fail("Send", "client did not read the reply");
+    else
+        test_pass("Send");
+
+    // Data decrypted with the record but not yet returned is invisible to select()
+    SSL_write(client, "PWD\r\nSYST\r\n", 11);
+    memset(buffer, 0, sizeof(buffer));
+    int first = net_receive(fds[0], buffer, 5);
+    if (first != 5 || net_receive_pending(fds[0]) != 6 || net_wait_readable(fds[0], 0) != 1 ||
+        net_receive(fds[0], buffer + 5, sizeof(buffer) - 5) != 6 || strcmp(buffer, "PWD\r\nSYST\r\n") != 0)
+        test_fail("Pending", "buffered plaintext not reported");
+    else
+        test_pass("Pending");
+
+    *session = SSL_get1_session(client);
+
+    // Closing sends close_notify, so the client can tell the end from a truncation
+    net_close_socket(fds[0]);
+    int read = SSL_read(client, buffer, sizeof(buffer));
+    if (read > 0 || SSL_get_error(client, read) != SSL_ERROR_ZERO_RETURN || tlssock_is_secured(fds[0]))
+        test_fail("Close notify", "connection ended without close_notify");
+    else
+        test_pass("Close notify");
+
+    // Answering close_notify keeps the session resumable on the client side
+    SSL_shutdown(client);
+    SSL_free(client);
+    close(fds[1]);
+}
+
+static void test_resumption(SSL_CTX *client_ctx, SSL_SESSION *session)
+{
+    printf("\n--- Test 3: Session Resumption ---\n");
+
+    tlssock_stats_t before, after;
+    tlssock_get_stats(&before);
+
+    int fds[2];
+    SSL *client = connect_pair(client_ctx, session, fds);
+    tlssock_get_stats(&after);
+    if (!client || !SSL_session_reused(client) || after.resumed != before.resumed + 1 ||
+        after.handshakes != before.handshakes + 1)
+        test_fail("Resume", "data connection did not resume the session");
+    else
+        test_pass("Resume");
+
+    if (client)
+    {
+        SSL_free(client);
+        close(fds[1]);
+        net_close_socket(fds[0]);
+    }
+}
+
+static void test_send_file(SSL_CTX *client_ctx)
+{
+    printf("\n--- Test 4: File Send ---\n");
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s.bin", g_cert_path);
+    char data[4096];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (char)(i * 7);
+    fs_write_file_all(path, data, sizeof(data));
+
+    int fds[2];
+    SSL *client = connect_pair(client_ctx, NULL, fds);
+    fs_file_t file;
+    if (!client || fs_file_open(&file, path, FS_OPEN_READ) != 0)
+    {
+        test_fail("Send file", "setup failed");
+        fs_delete_file(path);
+        return;
+    }
+
+    // Without kernel TLS the caller must fall back to a buffered copy that net_send() encrypts
+    long long sent = net_send_file(fds[0], &file, 0, sizeof(data));
+    char received[4096];
+    int ok = 0;
+    if (sent == NET_SENDFILE_UNSUPPORTED)
+    {
+        ok = 1;
+    }
+    else if (sent == (long long)sizeof(data))
+    {
+        int total = 0;
+        while (total < (int)sizeof(received))
+        {
+            int n = SSL_read(client, received + total, (int)sizeof(received) - total);
+            if (n <= 0)
+                break;
+            total += n;
+        }
+        ok = total == (int)sizeof(received) && memcmp(received, data, sizeof(data)) == 0;
+    }
+    if (!ok)
+        test_fail("Send file", "plaintext leaked or data corrupted");
+    else
+        test_pass(sent == NET_SENDFILE_UNSUPPORTED ? "Send file (no kernel TLS, falls back)" : "Send file (kernel TLS)");
+
+    fs_file_close(&file);
+    fs_delete_file(path);
+    SSL_free(client);
+    close(fds[1]);
+    net_close_socket(fds[0]);
+}
+
+static void test_failed_handshake()
+{
+    printf("\n--- Test 5: Failed Handshake ---\n");
+
+    tlssock_stats_t before, after;
+    tlssock_get_stats(&before);
+
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    net_send(fds[1], "USER anonymous\r\n", 16);
+    close(fds[1]);
+
+    int result = tlssock_accept(fds[0], 1000);
+    tlssock_get_stats(&after);
+    if (result == 0 || tlssock_is_secured(fds[0]) || after.failures != before.failures + 1)
+        test_fail("Plain text client", "handshake accepted garbage");
+    else
+        test_pass("Plain text client");
+    net_close_socket(fds[0]);
+
+    if (after.secured != 0)
+        test_fail("Secured count", "closed sockets still counted");
+    else
+        test_pass("Secured count");
+}
+
+static void test_tls()
+{
+    if (write_certificate() != 0 || tlssock_init(g_cert_path, NULL) != 0 || !tlssock_is_available())
+    {
+        test_fail("Init", "TLS could not be enabled");
+        return;
+    }
+    test_pass("Init");
+
+    SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, NULL);
+    SSL_SESSION *session = NULL;
+
+    test_round_trip(client_ctx, &session);
+    test_resumption(client_ctx, session);
+    test_send_file(client_ctx);
+    test_failed_handshake();
+
+    SSL_SESSION_free(session);
+    SSL_CTX_free(client_ctx);
+    tlssock_cleanup();
+    if (tlssock_is_available())
+        test_fail("Cleanup", "TLS still enabled");
+    else
+        test_pass("Cleanup");
+    fs_delete_file(g_cert_path);
+}
+
+#endif // ENABLE_OPENSSL
+
+int main()
+{
+    printf("============================================================\n");
+    printf("TLS Socket Test Suite\n");
+    printf("============================================================\n");
+
+    // Alerts to peers that already hung up must fail, not kill the test (the server ignores SIGPIPE as well)
+    signal(SIGPIPE, SIG_IGN);
+    logger_init(0, LOG_LEVEL_ERROR);
+    net_init();
+
+    test_plain_sockets();
+
+#ifdef ENABLE_OPENSSL
+    test_tls();
+#else
+    printf("\n--- Built without OpenSSL, TLS tests skipped ---\n");
+    if (tlssock_init("/nonexistent.pem", NULL) == 0 || tlssock_is_available())
+        test_fail("Unavailable", "TLS enabled without OpenSSL");
+    else
+        test_pass("Unavailable");
+#endif
+
+    net_cleanup();
+    logger_close();
+
+    printf("\n============================================================\n");
+    printf("Test Results: %d/%d passed\n", g_test_passed, g_test_passed + g_test_failed);
+    printf("============================================================\n");
+
+    if (g_test_failed > 0) {
+        printf("\n❌ Some tests failed\n");
+        return 1;
+    } else {
+        printf("\n✅ All tests passed\n");
+        return 0;
+    }
+}